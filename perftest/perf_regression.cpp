@@ -0,0 +1,174 @@
+/** \file perf_regression.cpp
+ * \brief Measures end-to-end performance of a flow or heat conduction case and compares it with a
+ *   baseline
+ *
+ * Command-line or PETSc options file parameters:
+ * * -perftest_case_name [string] Name of the case; used to name the output and baseline files
+ * * -perftest_threads_sequence [integer array] The numbers of threads to run the case with
+ *     (default 1)
+ * * -perftest_num_repeat [integer] Number of times to repeat each run; the fastest is recorded
+ *     (default 1)
+ * * -perftest_output_file [string] JSON file to write results to (default <case name>.json)
+ * * -perftest_baseline_dir [string] Directory containing baselines in sub-directories named after
+ *     the host, as <dir>/<hostname>/<case name>.json. If not given, no comparison is done.
+ * * -perftest_update_baseline If given, the results are written to the baseline file of this host
+ *     instead of being compared with it.
+ * * -perftest_time_tolerance [real] Allowed relative increase in wall time (default 0.3)
+ * * -perftest_iter_tolerance [real] Allowed relative increase in time steps, linear iterations
+ *     and residual evaluations (default 0.1)
+ * * -perftest_memory_tolerance [real] Allowed relative increase in peak memory (default 0.2)
+ * * -perftest_vortex_params [string] Isentropic vortex parameter file; needed for unsteady cases,
+ *     which start from the isentropic vortex initial condition
+ * * -perftest_heat If given, the steady heat conduction benchmark (see \ref runHeatPerfCase) is
+ *     run on the mesh given by --mesh_file instead of a flow case, and no control file is needed
+ *
+ * Returns a non-zero value if any metric has regressed beyond its tolerance. If no baseline exists
+ * for this host, the results are only written out.
+ *
+ * \author Aditya Kashi
+ */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <petscsys.h>
+
+#include "utilities/aoptionparser.hpp"
+#include "utilities/aerrorhandling.hpp"
+#include "utilities/casesolvers.hpp"
+#include "utilities/isentropicvortex.hpp"
+#include "mesh/ameshutils.hpp"
+#include "perf_regression_tests.hpp"
+
+using namespace fvens;
+using namespace perftest;
+namespace po = boost::program_options;
+
+#define ARR_LEN 10
+#define PATH_LEN 200
+
+static std::string getHostName()
+{
+	char name[PATH_LEN];
+	if(gethostname(name, PATH_LEN) != 0)
+		return "unknown-host";
+	name[PATH_LEN-1] = '\0';
+	return std::string(name);
+}
+
+static bool fileExists(const std::string fname)
+{
+	std::ifstream f(fname);
+	return f.good();
+}
+
+int main(int argc, char *argv[])
+{
+	StatusCode ierr = 0;
+	const char help[] = "Performance regression test for FVENS.\n\
+		Arguments needed: FVENS control file and PETSc options file with -options_file.\n";
+
+	ierr = PetscInitialize(&argc,&argv,NULL,help); CHKERRQ(ierr);
+	int mpirank;
+	MPI_Comm_rank(PETSC_COMM_WORLD, &mpirank);
+
+	po::options_description desc
+		(std::string("FVENS performance regression test")
+		 + "\n The first argument must be the control file to use. Further options");
+
+	const po::variables_map cmdvars = parse_cmd_options(argc, argv, desc);
+	if(cmdvars.count("help")) {
+		std::cout << desc << std::endl;
+		std::exit(0);
+	}
+
+	const std::string casename = parsePetscCmd_string("-perftest_case_name", PATH_LEN);
+
+	std::vector<int> threadseq = parseOptionalPetscCmd_intArray("-perftest_threads_sequence",
+	                                                            ARR_LEN);
+	if(threadseq.size() == 0)
+		threadseq.push_back(1);
+
+	const int nrepeat = parsePetscCmd_isDefined("-perftest_num_repeat") ?
+		parsePetscCmd_int("-perftest_num_repeat") : 1;
+
+	const std::string outfile = parsePetscCmd_isDefined("-perftest_output_file") ?
+		parsePetscCmd_string("-perftest_output_file", PATH_LEN) : casename + ".json";
+
+	const PerfTolerances tols {
+		parseOptionalPetscCmd_real("-perftest_time_tolerance", 0.3),
+		parseOptionalPetscCmd_real("-perftest_iter_tolerance", 0.1),
+		parseOptionalPetscCmd_real("-perftest_memory_tolerance", 0.2)
+	};
+
+	std::vector<PerfRecord> records;
+
+	if(parsePetscCmd_isDefined("-perftest_heat"))
+	{
+		fvens_throw(!cmdvars.count("mesh_file"), "The heat conduction case needs --mesh_file!");
+		UMesh2dh<a_real> m;
+		m.readMesh(cmdvars["mesh_file"].as<std::string>());
+		ierr = preprocessMesh(m); CHKERRQ(ierr);
+
+		records = runHeatPerfCase(m, threadseq, nrepeat);
+	}
+	else
+	{
+		const FlowParserOptions opts = parse_flow_controlfile(argc, argv, cmdvars);
+		const UMesh2dh<a_real> m = constructMesh(opts, "");
+
+		Vec u0;
+		ierr = initializeSystemVector(opts, m, &u0); CHKERRQ(ierr);
+		if(opts.sim_type == "UNSTEADY") {
+			const std::string vortexfile = parsePetscCmd_string("-perftest_vortex_params", PATH_LEN);
+			const IsentropicVortexProblem isen
+				(readIsenVortexConfig(vortexfile, opts.gamma, opts.Minf, opts.alpha));
+			std::vector<a_real> uexact(m.gnelem()*NVARS);
+			a_real *uarr;
+			ierr = VecGetArray(u0, &uarr); CHKERRQ(ierr);
+			isen.getInitialConditionAndExactSolution(m, opts.final_time, uarr, &uexact[0]);
+			ierr = VecRestoreArray(u0, &uarr); CHKERRQ(ierr);
+		}
+
+		records = runPerfCase(opts, m, u0, threadseq, nrepeat);
+		ierr = VecDestroy(&u0); CHKERRQ(ierr);
+	}
+
+	int nregress = 0;
+
+	if(mpirank == 0)
+	{
+		writePerfJSON(outfile, casename, records);
+		std::cout << "\nPerformance data written to " << outfile << '\n';
+
+		if(parsePetscCmd_isDefined("-perftest_baseline_dir"))
+		{
+			const std::string basedir = parsePetscCmd_string("-perftest_baseline_dir", PATH_LEN);
+			const std::string hostdir = basedir + "/" + getHostName();
+			const std::string basefile = hostdir + "/" + casename + ".json";
+
+			if(parsePetscCmd_isDefined("-perftest_update_baseline")) {
+				const mode_t mode = S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH;
+				mkdir(basedir.c_str(), mode);
+				mkdir(hostdir.c_str(), mode);
+				writePerfJSON(basefile, casename, records);
+				std::cout << "Baseline written to " << basefile << '\n';
+			}
+			else if(!fileExists(basefile)) {
+				std::cout << "No baseline " << basefile << " for this host; "
+				          << "run with -perftest_update_baseline to record one.\n";
+			}
+			else {
+				std::cout << "Comparing with baseline " << basefile << ":\n";
+				const std::vector<PerfRecord> baseline = readPerfJSON(basefile);
+				nregress = comparePerfRecords(records, baseline, tols);
+				std::cout << "Number of regressions = " << nregress << '\n';
+			}
+		}
+	}
+
+	ierr = PetscFinalize(); CHKERRQ(ierr);
+	return nregress > 0 ? 1 : 0;
+}
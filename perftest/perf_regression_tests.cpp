@@ -0,0 +1,395 @@
+/** \file perf_regression_tests.cpp
+ * \brief End-to-end performance measurement of flow cases and comparison against stored baselines
+ * \author Aditya Kashi
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <limits>
+#include <cmath>
+#include <sys/resource.h>
+#include <petscksp.h>
+#include <petsctime.h>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "utilities/aerrorhandling.hpp"
+#include "spatial/diffusion.hpp"
+#include "linalg/alinalg.hpp"
+#include "perf_regression_tests.hpp"
+
+namespace perftest {
+
+namespace pt = boost::property_tree;
+
+/// Resets the peak resident set size of this process to its current resident set size
+/** Only possible on Linux, by writing 5 to /proc/self/clear_refs.
+ * \return True if the peak was reset
+ */
+static bool resetPeakMemory()
+{
+	std::ofstream clearrefs("/proc/self/clear_refs");
+	if(!clearrefs)
+		return false;
+	clearrefs << "5";
+	clearrefs.close();
+	return !clearrefs.fail();
+}
+
+/// Peak resident set size of this process in kB since the last \ref resetPeakMemory
+/** Read as VmHWM from /proc/self/status. Where that is not available, the peak over the lifetime
+ * of the process is returned.
+ */
+static long getPeakMemory()
+{
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	while(std::getline(status, line))
+	{
+		if(line.compare(0, 6, "VmHWM:") == 0) {
+			std::istringstream iss(line.substr(6));
+			long peak = 0;
+			if(iss >> peak)
+				return peak;
+		}
+	}
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+
+/** The startup solve of a steady case is repeated along with the main solve so that the total time
+ * is representative of a production run.
+ */
+static PerfRecord runPerfOnce(const FlowCase& flowcase,
+                              const Spatial<a_real,NVARS> *const prob, const Vec u0)
+{
+	PerfRecord rec;
+	rec.nelem = prob->mesh()->gnelem();
+	rec.num_threads = 1;
+#ifdef _OPENMP
+	rec.num_threads = omp_get_max_threads();
+#endif
+
+	// so that the peak memory is that of this run, and not of any earlier run in this process
+	const bool memreset = resetPeakMemory();
+	if(!memreset)
+		std::cout << " runPerfOnce: Could not reset the peak memory; it is process-wide.\n";
+
+	Vec u;
+	int ierr = VecDuplicate(u0, &u); petsc_throw(ierr, "Vec duplicate");
+	ierr = VecCopy(u0, u); petsc_throw(ierr, "Vec copy");
+
+	PetscLogDouble starttime, endtime;
+	PetscTime(&starttime);
+
+	TimingData td;
+	try {
+		ierr = flowcase.execute_starter(prob, u); fvens_throw(ierr, "Startup solve failed!");
+		td = flowcase.execute_main(prob, u);
+	}
+	catch(Tolerance_error& e) {
+		std::cout << e.what() << std::endl;
+		td.converged = false;
+	}
+
+	PetscTime(&endtime);
+
+	rec.peak_memory = getPeakMemory();
+	ierr = VecDestroy(&u); petsc_throw(ierr, "Vec destroy");
+
+	rec.converged = td.converged;
+	rec.total_walltime = endtime-starttime;
+	if(td.converged) {
+		rec.ode_walltime = td.ode_walltime;
+		rec.lin_walltime = td.lin_walltime;
+		rec.ode_cputime = td.ode_cputime;
+		rec.num_timesteps = td.num_timesteps;
+		rec.total_lin_iters = td.total_lin_iters;
+		rec.num_res_evals = td.num_res_evals;
+	}
+	else {
+		rec.ode_walltime = rec.lin_walltime = rec.ode_cputime = 0;
+		rec.num_timesteps = rec.total_lin_iters = rec.num_res_evals = 0;
+	}
+	return rec;
+}
+
+/// Runs a case with each number of threads, keeping the fastest of the repetitions
+/** The spatial discretization is constructed anew for each number of threads, since its face loop
+ * schedule is partitioned for the number of threads available when it is constructed.
+ */
+template <typename Case>
+static std::vector<PerfRecord> runPerfSequence(const FlowParserOptions& opts,
+                                               const UMesh2dh<a_real>& m, const Vec u0,
+                                               const std::vector<int>& threadseq, const int nrepeat)
+{
+	const Case flowcase(opts);
+	std::vector<PerfRecord> records;
+
+	for(const int nthreads : threadseq)
+	{
+#ifdef _OPENMP
+		omp_set_num_threads(nthreads);
+#else
+		if(nthreads != 1)
+			std::cout << " runPerfCase: Not built with OpenMP; running on 1 thread.\n";
+#endif
+		const FlowFV_base<a_real> *const prob = createFlowSpatial(opts, m);
+
+		PerfRecord best;
+		for(int irpt = 0; irpt < nrepeat; irpt++)
+		{
+			const PerfRecord rec = runPerfOnce(flowcase, prob, u0);
+			if(irpt == 0 || !rec.converged || rec.total_walltime < best.total_walltime)
+				best = rec;
+			if(!rec.converged)
+				break;
+		}
+
+		const int faceloopthreads = prob->faceLoopSchedule().lastTeamSize();
+		std::cout << " runPerfCase: " << best.num_threads << " threads; face loops ran on "
+		          << faceloopthreads << " threads over " << prob->faceLoopSchedule().numParts()
+		          << " parts.\n";
+		delete prob;
+		fvens_throw(faceloopthreads != best.num_threads,
+		            "Face loops did not run on the requested number of threads!");
+
+		records.push_back(best);
+	}
+
+	return records;
+}
+
+std::vector<PerfRecord> runPerfCase(const FlowParserOptions& opts, const UMesh2dh<a_real>& m,
+                                    const Vec u0,
+                                    const std::vector<int>& threadseq, const int nrepeat)
+{
+	if(opts.sim_type == "UNSTEADY")
+		return runPerfSequence<UnsteadyFlowCase>(opts, m, u0, threadseq, nrepeat);
+	else
+		return runPerfSequence<SteadyFlowCase>(opts, m, u0, threadseq, nrepeat);
+}
+
+/// Solves the heat conduction benchmark once from a zero initial state
+static PerfRecord runHeatPerfOnce(const UMesh2dh<a_real>& m)
+{
+	const a_real diffcoeff = 1.0, bvalue = 0.0;
+	const SteadySolverConfig conf {false, "", 1.0, 20.0, 0, 40, 1e-6, 50000, 0, 0};
+
+	PerfRecord rec;
+	rec.nelem = m.gnelem();
+	rec.num_threads = 1;
+#ifdef _OPENMP
+	rec.num_threads = omp_get_max_threads();
+#endif
+
+	const bool memreset = resetPeakMemory();
+	if(!memreset)
+		std::cout << " runHeatPerfOnce: Could not reset the peak memory; it is process-wide.\n";
+
+	PetscLogDouble starttime, endtime;
+	PetscTime(&starttime);
+
+	const DiffusionMA<1> prob(&m, diffcoeff, bvalue,
+		[diffcoeff](const a_real *const r, const a_real t, const a_real *const u,
+		            a_real *const sourceterm) {
+			sourceterm[0] = diffcoeff*8.0*PI*PI*std::sin(2*PI*r[0])*std::sin(2*PI*r[1]);
+		},
+		"LEASTSQUARES");
+
+	Mat M;
+	int ierr = setupSystemMatrix<1>(&m, &M); petsc_throw(ierr, "Could not set up matrix");
+	Vec u;
+	ierr = MatCreateVecs(M, &u, NULL); petsc_throw(ierr, "Could not create vector");
+	prob.initializeUnknowns(u);
+
+	KSP ksp;
+	ierr = KSPCreate(PETSC_COMM_WORLD, &ksp); petsc_throw(ierr, "Could not create KSP");
+	ierr = KSPSetOperators(ksp, M, M); petsc_throw(ierr, "Could not set KSP operators");
+	ierr = KSPSetFromOptions(ksp); petsc_throw(ierr, "Could not set KSP options");
+
+	TimingData td;
+	{
+		SteadyBackwardEulerSolver<1> time(&prob, conf, ksp);
+		try {
+			ierr = time.solve(u); petsc_throw(ierr, "Heat conduction solve failed!");
+			td = time.getTimingData();
+		}
+		catch(Tolerance_error& e) {
+			std::cout << e.what() << std::endl;
+			td = time.getTimingData();
+			td.converged = false;
+		}
+	}
+
+	PetscTime(&endtime);
+	rec.peak_memory = getPeakMemory();
+
+	ierr = KSPDestroy(&ksp); petsc_throw(ierr, "KSP destroy");
+	ierr = VecDestroy(&u); petsc_throw(ierr, "Vec destroy");
+	ierr = MatDestroy(&M); petsc_throw(ierr, "Mat destroy");
+
+	rec.converged = td.converged;
+	rec.total_walltime = endtime-starttime;
+	if(td.converged) {
+		rec.ode_walltime = td.ode_walltime;
+		rec.lin_walltime = td.lin_walltime;
+		rec.ode_cputime = td.ode_cputime;
+		rec.num_timesteps = td.num_timesteps;
+		rec.total_lin_iters = td.total_lin_iters;
+		rec.num_res_evals = td.num_res_evals;
+	}
+	else {
+		rec.ode_walltime = rec.lin_walltime = rec.ode_cputime = 0;
+		rec.num_timesteps = rec.total_lin_iters = rec.num_res_evals = 0;
+	}
+	return rec;
+}
+
+std::vector<PerfRecord> runHeatPerfCase(const UMesh2dh<a_real>& m,
+                                        const std::vector<int>& threadseq, const int nrepeat)
+{
+	std::vector<PerfRecord> records;
+
+	for(const int nthreads : threadseq)
+	{
+#ifdef _OPENMP
+		omp_set_num_threads(nthreads);
+#else
+		if(nthreads != 1)
+			std::cout << " runHeatPerfCase: Not built with OpenMP; running on 1 thread.\n";
+#endif
+		PerfRecord best;
+		for(int irpt = 0; irpt < nrepeat; irpt++)
+		{
+			const PerfRecord rec = runHeatPerfOnce(m);
+			if(irpt == 0 || !rec.converged || rec.total_walltime < best.total_walltime)
+				best = rec;
+			if(!rec.converged)
+				break;
+		}
+		records.push_back(best);
+	}
+
+	return records;
+}
+
+void writePerfJSON(const std::string fname, const std::string casename,
+                   const std::vector<PerfRecord>& records)
+{
+	pt::ptree tree;
+	tree.put("case", casename);
+
+	pt::ptree runs;
+	for(const PerfRecord& r : records)
+	{
+		pt::ptree run;
+		run.put("threads", r.num_threads);
+		run.put("cells", r.nelem);
+		run.put("total_wall_time", r.total_walltime);
+		run.put("ode_wall_time", r.ode_walltime);
+		run.put("linear_wall_time", r.lin_walltime);
+		run.put("ode_cpu_time", r.ode_cputime);
+		run.put("time_steps", r.num_timesteps);
+		run.put("linear_iterations", r.total_lin_iters);
+		run.put("residual_evaluations", r.num_res_evals);
+		run.put("peak_memory_kB", r.peak_memory);
+		run.put("converged", r.converged);
+		runs.push_back(std::make_pair("", run));
+	}
+	tree.add_child("runs", runs);
+
+	pt::write_json(fname, tree);
+}
+
+std::vector<PerfRecord> readPerfJSON(const std::string fname)
+{
+	pt::ptree tree;
+	pt::read_json(fname, tree);
+
+	std::vector<PerfRecord> records;
+	for(const auto& it : tree.get_child("runs"))
+	{
+		const pt::ptree& run = it.second;
+		PerfRecord r;
+		r.num_threads = run.get<int>("threads");
+		r.nelem = run.get<a_int>("cells");
+		r.total_walltime = run.get<double>("total_wall_time");
+		r.ode_walltime = run.get<double>("ode_wall_time");
+		r.lin_walltime = run.get<double>("linear_wall_time");
+		r.ode_cputime = run.get<double>("ode_cpu_time");
+		r.num_timesteps = run.get<int>("time_steps");
+		r.total_lin_iters = run.get<int>("linear_iterations");
+		r.num_res_evals = run.get<int>("residual_evaluations");
+		r.peak_memory = run.get<long>("peak_memory_kB");
+		r.converged = run.get<bool>("converged");
+		records.push_back(r);
+	}
+	return records;
+}
+
+/// Checks one metric against its baseline value and prints a line if it has regressed
+static bool checkMetric(const std::string name, const int nthreads, const double value,
+                        const double baseval, const double tol)
+{
+	const bool regressed = value > baseval*(1.0+tol);
+	std::cout << (regressed ? "! " : "  ") << std::setw(22) << name
+	          << std::setw(5) << nthreads << " threads: " << std::setw(12) << value
+	          << "  baseline " << std::setw(12) << baseval;
+	if(baseval > 0)
+		std::cout << "  (" << std::showpos << std::setprecision(3)
+		          << 100.0*(value-baseval)/baseval << std::noshowpos << std::setprecision(6) << "%)";
+	std::cout << '\n';
+	return regressed;
+}
+
+int comparePerfRecords(const std::vector<PerfRecord>& records,
+                       const std::vector<PerfRecord>& baseline, const PerfTolerances& tols)
+{
+	int nregress = 0;
+
+	for(const PerfRecord& r : records)
+	{
+		const PerfRecord *b = nullptr;
+		for(const PerfRecord& br : baseline)
+			if(br.num_threads == r.num_threads)
+				b = &br;
+
+		if(!b) {
+			std::cout << "  No baseline for " << r.num_threads << " threads; skipping.\n";
+			continue;
+		}
+
+		if(b->nelem != r.nelem)
+			std::cout << "  Warning: the baseline was recorded on a different mesh!\n";
+
+		if(b->converged && !r.converged) {
+			std::cout << "! Case with " << r.num_threads << " threads no longer converges.\n";
+			nregress++;
+			continue;
+		}
+
+		nregress += checkMetric("total wall time", r.num_threads, r.total_walltime,
+		                        b->total_walltime, tols.walltime);
+		nregress += checkMetric("time steps", r.num_threads, r.num_timesteps,
+		                        b->num_timesteps, tols.iterations);
+		nregress += checkMetric("linear iterations", r.num_threads, r.total_lin_iters,
+		                        b->total_lin_iters, tols.iterations);
+		nregress += checkMetric("residual evaluations", r.num_threads, r.num_res_evals,
+		                        b->num_res_evals, tols.iterations);
+		nregress += checkMetric("peak memory (kB)", r.num_threads, r.peak_memory,
+		                        b->peak_memory, tols.memory);
+	}
+
+	return nregress;
+}
+
+}
@@ -0,0 +1,87 @@
+/** \file perf_regression_tests.hpp
+ * \brief End-to-end performance measurement of flow cases and comparison against stored baselines
+ * \author Aditya Kashi
+ */
+
+#ifndef FVENS_PERF_REGRESSION_TESTS_H
+#define FVENS_PERF_REGRESSION_TESTS_H
+
+#include <vector>
+#include <string>
+
+#include "utilities/casesolvers.hpp"
+
+namespace perftest {
+
+using namespace fvens;
+
+/// Performance data of one solve of a case with a certain number of threads
+struct PerfRecord {
+	int num_threads;             ///< Number of OpenMP threads used
+	a_int nelem;                 ///< Number of cells in the mesh
+	double total_walltime;       ///< Wall time of startup and main solves together
+	double ode_walltime;         ///< Wall time of the main solve
+	double lin_walltime;         ///< Wall time of linear solves in the main solve
+	double ode_cputime;          ///< CPU time of the main solve
+	int num_timesteps;           ///< Pseudo-time steps, or physical time steps, in the main solve
+	int total_lin_iters;         ///< Linear solver iterations in the main solve
+	int num_res_evals;           ///< Residual evaluations in the main solve
+	/// Peak resident set size during this run, in kB, including memory allocated before the run
+	///  such as the mesh. Where the peak cannot be reset (outside Linux), it is the peak of the
+	///  process so far.
+	long peak_memory;
+	bool converged;              ///< Whether the main solve converged
+};
+
+/// Relative tolerances by which a metric may exceed its baseline before it is flagged
+struct PerfTolerances {
+	double walltime;             ///< For wall times
+	double iterations;           ///< For time steps, linear iterations and residual evaluations
+	double memory;               ///< For peak memory usage
+};
+
+/// Solve a steady or unsteady case with each requested number of threads and record performance
+///  data
+/** Each solve is repeated and the fastest repetition is recorded, to reduce timing noise.
+ * \param opts Parsed control file options
+ * \param m Mesh to solve on
+ * \param u0 Initial condition that every solve starts from
+ * \param threadseq Numbers of threads to use
+ * \param nrepeat Number of repetitions of each solve
+ */
+std::vector<PerfRecord> runPerfCase(const FlowParserOptions& opts, const UMesh2dh<a_real>& m,
+                                    const Vec u0,
+                                    const std::vector<int>& threadseq, const int nrepeat);
+
+/// Solve the steady heat conduction benchmark with each requested number of threads and record
+///  performance data
+/** The problem is -k Laplacian(u) = f on the mesh with u = 0 on the boundary, where f is such that
+ * the exact solution is sin(2 pi x) sin(2 pi y) on the unit square, as in the heat conduction
+ * convergence tests. It is discretized with the modified-average diffusive flux and least-squares
+ * gradients, and solved by backward Euler pseudo-time stepping from CFL 1 to 20 over 40 steps, to a
+ * relative tolerance of 1e-6. The linear solver is configured by the PETSc options.
+ * \param m Preprocessed mesh to solve on
+ * \param threadseq Numbers of threads to use
+ * \param nrepeat Number of repetitions of each solve; the fastest is recorded
+ */
+std::vector<PerfRecord> runHeatPerfCase(const UMesh2dh<a_real>& m,
+                                        const std::vector<int>& threadseq, const int nrepeat);
+
+/// Write performance records of a case to a JSON file
+void writePerfJSON(const std::string fname, const std::string casename,
+                   const std::vector<PerfRecord>& records);
+
+/// Read performance records from a JSON file written by \ref writePerfJSON
+std::vector<PerfRecord> readPerfJSON(const std::string fname);
+
+/// Compare performance records with baseline records having the same number of threads
+/** Prints a report of all metrics that exceed their baselines by more than the tolerance.
+ * Records with no corresponding baseline are skipped.
+ * \return The number of regressions found
+ */
+int comparePerfRecords(const std::vector<PerfRecord>& records,
+                       const std::vector<PerfRecord>& baseline, const PerfTolerances& tols);
+
+}
+
+#endif
@@ -0,0 +1,68 @@
+#include <iostream>
+#include <string>
+#include <petscvec.h>
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/variables_map.hpp>
+
+#include "utilities/aoptionparser.hpp"
+#include "utilities/controlparser.hpp"
+#include "utilities/autotune.hpp"
+
+using namespace fvens;
+namespace po = boost::program_options;
+
+int main(int argc, char *argv[])
+{
+	StatusCode ierr = 0;
+	const char help[] = "Tunes pseudo-time and linear solver settings for a steady flow case.\n\
+		Arguments needed: FVENS control file and PETSc options file with -options_file.\n";
+
+	ierr = PetscInitialize(&argc,&argv,NULL,help); CHKERRQ(ierr);
+
+	po::options_description desc
+		(std::string("FVENS auto-tuner - picks the fastest solver settings by short trial solves")
+		 + "\n The first argument must be the control file to use. Further options");
+
+	const po::variables_map cmdvars = parse_cmd_options(argc, argv, desc);
+
+	if(cmdvars.count("help")) {
+		std::cout << desc << std::endl;
+		std::exit(0);
+	}
+
+	const FlowParserOptions opts = parse_flow_controlfile(argc, argv, cmdvars);
+
+	const int ntrialsteps = parsePetscCmd_isDefined("-autotune_trial_steps") ?
+		parsePetscCmd_int("-autotune_trial_steps") : 30;
+	const std::string outfile = parsePetscCmd_isDefined("-autotune_output_file") ?
+		parsePetscCmd_string("-autotune_output_file", 200) : opts.logfile + "-tuned.solverc";
+
+	const UMesh2dh<a_real> m = constructMesh(opts, "");
+
+	Vec u;
+	ierr = initializeSystemVector(opts, m, &u); CHKERRQ(ierr);
+
+	const std::vector<AutotuneCandidate> cands = enumerateCandidates(parseAutotuneSearchSpace(opts));
+	fvens_throw(cands.size() == 0, "The auto-tuning search space is empty!");
+
+	AutotuneFlowCase tuner(opts, ntrialsteps);
+	const std::vector<AutotuneTrial> trials = tuner.tune(m, u, cands);
+
+	const int ibest = bestTrial(trials);
+	if(ibest < 0) {
+		std::cout << "! All trial solves diverged; no settings written.\n";
+		ierr = -1;
+	}
+	else {
+		std::cout << "\nBest settings are from trial " << ibest << "; writing them to "
+		          << outfile << std::endl;
+		writeAutotunedOptions(outfile, trials[ibest]);
+	}
+
+	int ierrp = VecDestroy(&u); CHKERRQ(ierrp);
+
+	std::cout << '\n';
+	ierrp = PetscFinalize(); CHKERRQ(ierrp);
+	std::cout << "\n--------------- End --------------------- \n\n";
+	return ierr;
+}
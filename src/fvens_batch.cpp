@@ -0,0 +1,60 @@
+#include <iostream>
+#include <string>
+#include <petscvec.h>
+#include <petsctime.h>
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/variables_map.hpp>
+
+#include "utilities/aoptionparser.hpp"
+#include "utilities/controlparser.hpp"
+#include "utilities/casebatch.hpp"
+
+using namespace fvens;
+namespace po = boost::program_options;
+
+int main(int argc, char *argv[])
+{
+	StatusCode ierr = 0;
+	const char help[] = "Solves several independent steady flow cases concurrently on one mesh.\n\
+		Arguments needed: FVENS control file and PETSc options file with -options_file.\n";
+
+	ierr = PetscInitialize(&argc,&argv,NULL,help); CHKERRQ(ierr);
+
+	po::options_description desc
+		(std::string("FVENS batch solver - solves a set of steady cases on teams of threads")
+		 + "\n The first argument must be the control file to use. Further options");
+
+	const po::variables_map cmdvars = parse_cmd_options(argc, argv, desc);
+
+	if(cmdvars.count("help")) {
+		std::cout << desc << std::endl;
+		std::exit(0);
+	}
+
+	const FlowParserOptions opts = parse_flow_controlfile(argc, argv, cmdvars);
+
+	const int nteams = parsePetscCmd_isDefined("-batch_teams") ?
+		parsePetscCmd_int("-batch_teams") : 1;
+
+	const UMesh2dh<a_real> m = constructMesh(opts, "");
+
+	const std::vector<FlowParserOptions> cases = generateBatchCases(opts);
+
+	const FlowCaseBatch batch(nteams);
+	PetscLogDouble starttime, endtime;
+	PetscTime(&starttime);
+	const std::vector<BatchCaseResult> results = batch.solve(m, cases);
+	PetscTime(&endtime);
+	const double walltime = endtime - starttime;
+
+	writeBatchReport(std::cout, results, walltime);
+
+	for(const BatchCaseResult& r : results)
+		if(r.failed)
+			ierr = -1;
+
+	std::cout << '\n';
+	int ierrp = PetscFinalize(); CHKERRQ(ierrp);
+	std::cout << "\n--------------- End --------------------- \n\n";
+	return ierr;
+}
@@ -7,6 +7,7 @@
 #include "utilities/aoptionparser.hpp"
 #include "utilities/controlparser.hpp"
 #include "utilities/casesolvers.hpp"
+#include "utilities/perfcounters.hpp"
 
 using namespace fvens;
 namespace po = boost::program_options;
@@ -19,6 +20,9 @@ int main(int argc, char *argv[])
 
 	ierr = PetscInitialize(&argc,&argv,NULL,help); CHKERRQ(ierr);
 
+	// Counters need to be opened before OpenMP threads are spawned, so that the threads inherit them
+	initializePerfCounters();
+
 	// First set up command line options parsing
 
 	po::options_description desc
@@ -48,6 +52,9 @@ int main(int argc, char *argv[])
 
 	ierr = VecDestroy(&u); CHKERRQ(ierr);
 
+	reportPerfCounters(std::cout);
+	finalizePerfCounters();
+
 	std::cout << '\n';
 	ierr = PetscFinalize(); CHKERRQ(ierr);
 	std::cout << "\n--------------- End --------------------- \n\n";
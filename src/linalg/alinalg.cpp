@@ -1,8 +1,10 @@
 #include "alinalg.hpp"
+#include "subdomainpc.hpp"
 #include <iostream>
 #include <vector>
 #include <cstring>
 #include <limits>
+#include <cmath>
 
 namespace fvens {
 
@@ -71,10 +73,11 @@ StatusCode setupSystemMatrix(const UMesh2dh<a_real> *const m, Mat *const A)
 
 template StatusCode setupSystemMatrix<NVARS>(const UMesh2dh<a_real> *const m, Mat *const A);
 template StatusCode setupSystemMatrix<1>(const UMesh2dh<a_real> *const m, Mat *const A);
+template StatusCode setupSystemMatrix<NVARS+1>(const UMesh2dh<a_real> *const m, Mat *const A);
 
 template<int nvars>
 MatrixFreeSpatialJacobian<nvars>::MatrixFreeSpatialJacobian()
-	: eps{1e-7}
+	: eps{1e-7}, napplies{0}
 {
 	PetscBool set = PETSC_FALSE;
 	PetscOptionsGetReal(NULL, NULL, "-matrix_free_difference_step", &eps, &set);
@@ -116,49 +119,84 @@ StatusCode MatrixFreeSpatialJacobian<nvars>::apply(const Vec x, Vec y) const
 	StatusCode ierr = 0;
 	std::vector<a_real> dummy;
 	const UMesh2dh<a_real> *const m = spatial->mesh();
-	ierr = VecSet(y, 0.0); CHKERRQ(ierr);
 
-	const a_real *xr;
-	a_real *yr;
-	ierr = VecGetArray(y, &yr); CHKERRQ(ierr);
+	/* The vector operations below are fused, OpenMP-threaded loops over the local arrays rather
+	 * than calls to PETSc's Vec operations, which are not multi-threaded and would each make
+	 * another pass over the vectors.
+	 */
+
+	const a_real *xr, *ur;
+	a_real *auxr;
 	ierr = VecGetArrayRead(x, &xr); CHKERRQ(ierr);
+	ierr = VecGetArrayRead(u, &ur); CHKERRQ(ierr);
+	ierr = VecGetArray(aux, &auxr); CHKERRQ(ierr);
+	const a_int n = m->gnelem()*nvars;
+
+	a_real xnorm = 0;
+#pragma omp parallel for simd default(shared) reduction(+:xnorm)
+	for(a_int i = 0; i < n; i++)
+		xnorm += xr[i]*xr[i];
+
+	MPI_Comm comm;
+	ierr = PetscObjectGetComm((PetscObject)x, &comm); CHKERRQ(ierr);
+	ierr = MPI_Allreduce(MPI_IN_PLACE, &xnorm, 1, MPIU_REAL, MPI_SUM, comm); CHKERRQ(ierr);
+	xnorm = std::sqrt(xnorm);
 
-	PetscScalar xnorm = 0;
-	ierr = VecNorm(x, NORM_2, &xnorm); CHKERRQ(ierr);
 #ifdef DEBUG
 	if(xnorm < 10.0*std::numeric_limits<a_real>::epsilon())
 		SETERRQ(PETSC_COMM_SELF, PETSC_ERR_FP,
 				"Norm of offset is too small for finite difference Jacobian!");
 #endif
-	xnorm = eps/xnorm;
+	const a_real pertmag = eps/xnorm;
+
+	// aux <- u + eps/xnorm * x, and zero y in preparation for the residual computation
+	a_real *yr;
+	ierr = VecGetArray(y, &yr); CHKERRQ(ierr);
+#pragma omp parallel for simd default(shared)
+	for(a_int i = 0; i < n; i++) {
+		auxr[i] = ur[i] + pertmag*xr[i];
+		yr[i] = 0;
+	}
+	ierr = VecRestoreArray(y, &yr); CHKERRQ(ierr);
+	ierr = VecRestoreArray(aux, &auxr); CHKERRQ(ierr);
 
-	// aux <- eps/xnorm * x
-	ierr = VecAXPBY(aux, xnorm, 0.0, x); CHKERRQ(ierr);
-	// aux <- u + eps/xnorm * x
-	ierr = VecAXPY(aux, 1.0, u); CHKERRQ(ierr);
 	// y <- -r(u + eps/xnorm * x)
 	ierr = spatial->assemble_residual(aux, y, false, dummy); CHKERRQ(ierr);
-	// y <- -(-r(u + eps/xnorm * x)) + (-r(u)) = r(u + eps/xnorm * x) - r(u)
-	ierr = VecAXPBY(y, 1.0, -1.0, res); CHKERRQ(ierr);
-	
-	/* divide by the normalized step length */
-	ierr = VecScale(y, 1.0/xnorm); CHKERRQ(ierr);
 
-	// finally, add the pseudo-time term (Vol/dt du = Vol/dt x)
-#pragma omp parallel for simd default(shared)
+	// y <- -(-r(u + eps/xnorm * x)) + (-r(u)) = r(u + eps/xnorm * x) - r(u), divided by the
+	//  normalized step length, plus the pseudo-time term (Vol/dt du = Vol/dt x, or
+	//  Vol/dt P^{-1} x with a preconditioned pseudo-time derivative)
+	const bool ptprec = spatial->hasPseudoTimePreconditioner();
+	const a_real *resr;
+	ierr = VecGetArray(y, &yr); CHKERRQ(ierr);
+	ierr = VecGetArrayRead(res, &resr); CHKERRQ(ierr);
+#pragma omp parallel for default(shared)
 	for(a_int iel = 0; iel < m->gnelem(); iel++)
 	{
+		a_real px[nvars];
+		if(ptprec)
+			spatial->applyPseudoTimePreconditioner(&ur[iel*nvars], true, &xr[iel*nvars], px);
+		else
+			for(int i = 0; i < nvars; i++)
+				px[i] = xr[iel*nvars+i];
+
+#pragma omp simd
 		for(int i = 0; i < nvars; i++)
-			yr[iel*nvars+i] += (*mdt)[iel] * xr[iel*nvars+i];
+			yr[iel*nvars+i] = (resr[iel*nvars+i] - yr[iel*nvars+i])/pertmag
+				+ (*mdt)[iel] * px[i];
 	}
-	
+
+	ierr = VecRestoreArrayRead(u, &ur); CHKERRQ(ierr);
+	ierr = VecRestoreArrayRead(res, &resr); CHKERRQ(ierr);
 	ierr = VecRestoreArray(y, &yr); CHKERRQ(ierr);
 	ierr = VecRestoreArrayRead(x, &xr); CHKERRQ(ierr);
+	napplies++;
 	return ierr;
 }
 
 template class MatrixFreeSpatialJacobian<NVARS>;
 template class MatrixFreeSpatialJacobian<1>;
+template class MatrixFreeSpatialJacobian<NVARS+1>;
 
 /// The function called by PETSc to carry out a Jacobian-vector product
 template <int nvars>
@@ -208,6 +246,9 @@ template StatusCode setup_matrixfree_jacobian<NVARS>( const UMesh2dh<a_real> *co
 template StatusCode setup_matrixfree_jacobian<1>( const UMesh2dh<a_real> *const m,
 		MatrixFreeSpatialJacobian<1> *const mfj,
 		Mat *const A);
+template StatusCode setup_matrixfree_jacobian<NVARS+1>( const UMesh2dh<a_real> *const m,
+		MatrixFreeSpatialJacobian<NVARS+1> *const mfj,
+		Mat *const A);
 
 bool isMatrixFree(Mat M) 
 {
@@ -223,9 +264,13 @@ bool isMatrixFree(Mat M)
 }
 
 /// Recursive function to return the first occurrence if a specific type of PC
+/** The search descends into every local block of block Jacobi and ASM, and every sub-domain of a
+ * SubdomainPreconditioner, and stops at the first match. If there is none, pcfound is set to NULL.
+ */
 StatusCode getPC(KSP ksp, const char *const type_name, PC* pcfound)
 {
 	StatusCode ierr = 0;
+	*pcfound = NULL;
 	PC pc;
 	ierr = KSPGetPC(ksp, &pc); CHKERRQ(ierr);
 	PetscBool isbjacobi, isasm, ismg, isgamg, isksp, isrequired;
@@ -235,6 +280,8 @@ StatusCode getPC(KSP ksp, const char *const type_name, PC* pcfound)
 	ierr = PetscObjectTypeCompare((PetscObject)pc,PCGAMG,&isgamg); CHKERRQ(ierr);
 	ierr = PetscObjectTypeCompare((PetscObject)pc,PCKSP,&isksp); CHKERRQ(ierr);
 	ierr = PetscObjectTypeCompare((PetscObject)pc,type_name,&isrequired); CHKERRQ(ierr);
+	SubdomainPreconditioner *sdpc = NULL;
+	ierr = getSubdomainPreconditioner(pc, &sdpc); CHKERRQ(ierr);
 
 	if(isrequired) {
 		// base case
@@ -252,24 +299,32 @@ StatusCode getPC(KSP ksp, const char *const type_name, PC* pcfound)
 		else {
 			ierr = PCASMGetSubKSP(pc, &nlocalblocks, &firstlocalblock, &subksp); CHKERRQ(ierr);
 		}
-		if(nlocalblocks != 1)
-			SETERRQ(PETSC_COMM_SELF, PETSC_ERR_ARG_WRONGSTATE, 
-					"Only one subdomain per rank is supported.");
-		ierr = getPC(subksp[0], type_name, pcfound); CHKERRQ(ierr);
+		for(int iblk = 0; iblk < nlocalblocks && !*pcfound; iblk++) {
+			ierr = getPC(subksp[iblk], type_name, pcfound); CHKERRQ(ierr);
+		}
+	}
+	else if(sdpc) {
+		for(KSP subksp : sdpc->subdomainSolvers()) {
+			ierr = getPC(subksp, type_name, pcfound); CHKERRQ(ierr);
+			if(*pcfound)
+				break;
+		}
 	}
 	else if(ismg || isgamg) {
 		ierr = KSPSetUp(ksp); CHKERRQ(ierr); 
 		ierr = PCSetUp(pc); CHKERRQ(ierr);
 		PetscInt nlevels;
 		ierr = PCMGGetLevels(pc, &nlevels); CHKERRQ(ierr);
-		for(int ilvl = 0; ilvl < nlevels; ilvl++) {
+		for(int ilvl = 0; ilvl < nlevels && !*pcfound; ilvl++) {
 			KSP smootherctx;
 			ierr = PCMGGetSmoother(pc, ilvl , &smootherctx); CHKERRQ(ierr);
 			ierr = getPC(smootherctx, type_name, pcfound); CHKERRQ(ierr);
 		}
-		KSP coarsesolver;
-		ierr = PCMGGetCoarseSolve(pc, &coarsesolver); CHKERRQ(ierr);
-		ierr = getPC(coarsesolver, type_name, pcfound); CHKERRQ(ierr);
+		if(!*pcfound) {
+			KSP coarsesolver;
+			ierr = PCMGGetCoarseSolve(pc, &coarsesolver); CHKERRQ(ierr);
+			ierr = getPC(coarsesolver, type_name, pcfound); CHKERRQ(ierr);
+		}
 	}
 	else if(isksp) {
 		ierr = KSPSetUp(ksp); CHKERRQ(ierr); 
@@ -297,7 +352,20 @@ StatusCode setup_blasted(KSP ksp, Vec u, const Spatial<a_real,nvars> *const star
 	ierr = MatAssemblyBegin(M, MAT_FINAL_ASSEMBLY); CHKERRQ(ierr);
 	ierr = MatAssemblyEnd(M, MAT_FINAL_ASSEMBLY); CHKERRQ(ierr);
 
-	ierr = setup_blasted_stack(ksp,&bctx); CHKERRQ(ierr);
+	// BLASTed preconditioners inside sub-domains of our own sub-domain preconditioner are set up
+	//  separately for each sub-domain, as BLASTed does not know of it
+	PC pc;
+	ierr = KSPGetPC(ksp, &pc); CHKERRQ(ierr);
+	SubdomainPreconditioner *sdpc = NULL;
+	ierr = getSubdomainPreconditioner(pc, &sdpc); CHKERRQ(ierr);
+	if(sdpc) {
+		for(KSP subksp : sdpc->subdomainSolvers()) {
+			ierr = setup_blasted_stack(subksp,&bctx); CHKERRQ(ierr);
+		}
+	}
+	else {
+		ierr = setup_blasted_stack(ksp,&bctx); CHKERRQ(ierr);
+	}
 
 	return ierr;
 }
@@ -306,6 +374,8 @@ template StatusCode setup_blasted(KSP ksp, Vec u, const Spatial<a_real,NVARS> *c
 		Blasted_data_list& bctx);
 template StatusCode setup_blasted(KSP ksp, Vec u, const Spatial<a_real,1> *const startprob, 
 		Blasted_data_list& bctx);
+template StatusCode setup_blasted(KSP ksp, Vec u, const Spatial<a_real,NVARS+1> *const startprob,
+		Blasted_data_list& bctx);
 #endif
 
 
@@ -69,6 +69,9 @@ public:
 	/// Compute a Jacobian-vector product
 	StatusCode apply(const Vec x, Vec y) const;
 
+	/// Number of Jacobian-vector products (and hence residual evaluations) computed so far
+	int getNumApplications() const { return napplies; }
+
 protected:
 	/// Spatial discretization context
 	const Spatial<a_real,nvars>* spatial;
@@ -87,6 +90,9 @@ protected:
 
 	/// Temporary storage
 	mutable Vec aux;
+
+	/// Counter of Jacobian-vector products
+	mutable int napplies;
 };
 
 /// Setup a matrix-free Mat for the Jacobian
@@ -105,7 +111,8 @@ bool isMatrixFree(Mat);
 #ifdef USE_BLASTED
 
 /// Sets BLASTed preconditioners
-/** Only one subdomain per rank is supported in case of domain decomposition global preconditioners.
+/** Any number of local sub-domains is supported with domain decomposition global preconditioners
+ * (block Jacobi, ASM and SubdomainPreconditioner).
  * \param ksp The top-level KSP
  * \param u A solution vector used to assemble the Jacobian matrix once, needed for initialization
  *   of some PETSc preconditioners - the actual values don't matter.
@@ -0,0 +1,475 @@
+/** @file polynomialpc.cpp
+ * @brief Implementation of block-diagonal-scaled polynomial preconditioners
+ * @author Aditya Kashi
+ */
+
+#include <iostream>
+#include <cstring>
+#include <cmath>
+#include <Eigen/LU>
+
+#include "polynomialpc.hpp"
+#include "subdomainpc.hpp"
+#include "utilities/aoptionparser.hpp"
+#include "utilities/aerrorhandling.hpp"
+
+namespace fvens {
+
+PolynomialPCConfig parsePolynomialPCConfig()
+{
+	PolynomialPCConfig cfg;
+	const std::string type = parsePetscCmd_string("-poly_pc_type", 30);
+	if(type == "neumann")
+		cfg.type = POLYPC_NEUMANN;
+	else if(type == "chebyshev")
+		cfg.type = POLYPC_CHEBYSHEV;
+	else
+		throw std::runtime_error("Unknown polynomial preconditioner " + type);
+
+	cfg.degree = parsePetscCmd_isDefined("-poly_pc_degree") ?
+		parsePetscCmd_int("-poly_pc_degree") : 3;
+	cfg.eigiters = parsePetscCmd_isDefined("-poly_pc_eig_iters") ?
+		parsePetscCmd_int("-poly_pc_eig_iters") : 10;
+	cfg.eiglower = parseOptionalPetscCmd_real("-poly_pc_eig_lower_factor", 0.1);
+	cfg.eigupper = parseOptionalPetscCmd_real("-poly_pc_eig_upper_factor", 1.1);
+	cfg.damping = parseOptionalPetscCmd_real("-poly_pc_neumann_damping", 1.0);
+
+	fvens_throw(cfg.degree < 0, "Polynomial preconditioner degree must be non-negative!");
+	fvens_throw(cfg.eiglower <= 0 || cfg.eiglower >= cfg.eigupper,
+	            "Invalid Chebyshev eigenvalue interval factors!");
+	return cfg;
+}
+
+template <int bs>
+PolynomialPreconditioner<bs>::PolynomialPreconditioner(const PolynomialPCConfig config)
+	: cfg(config), A{NULL}, rawspmv{false}, localA{NULL}, nbrows{0},
+	  ia{nullptr}, ja{nullptr}, vals{nullptr}, zwork{NULL}, dwork{NULL}, azwork{NULL}, maxeig{1.0}
+{ }
+
+template <int bs>
+PolynomialPreconditioner<bs>::~PolynomialPreconditioner()
+{
+	releaseLocalMatrix();
+	if(zwork) {
+		VecDestroy(&zwork);
+		VecDestroy(&dwork);
+		VecDestroy(&azwork);
+	}
+}
+
+template <int bs>
+StatusCode PolynomialPreconditioner<bs>::setup(Mat pmat)
+{
+	StatusCode ierr = 0;
+	ierr = releaseLocalMatrix(); CHKERRQ(ierr);
+	A = pmat;
+
+	PetscInt matbs;
+	ierr = MatGetBlockSize(A, &matbs); CHKERRQ(ierr);
+	if(matbs != bs)
+		SETERRQ(PETSC_COMM_SELF, PETSC_ERR_ARG_WRONG,
+		        "Polynomial preconditioner: block size of matrix does not match!");
+
+	PetscInt nrows, ncols;
+	ierr = MatGetLocalSize(A, &nrows, &ncols); CHKERRQ(ierr);
+	nbrows = nrows/bs;
+
+	if(!zwork) {
+		ierr = MatCreateVecs(A, &zwork, NULL); CHKERRQ(ierr);
+		ierr = VecDuplicate(zwork, &dwork); CHKERRQ(ierr);
+		ierr = VecDuplicate(zwork, &azwork); CHKERRQ(ierr);
+	}
+
+	// Use the threaded BAIJ kernels only if all of the matrix is in the local sequential block
+	PetscBool isseqbaij, ismpibaij;
+	ierr = PetscObjectTypeCompare((PetscObject)A, MATSEQBAIJ, &isseqbaij); CHKERRQ(ierr);
+	ierr = PetscObjectTypeCompare((PetscObject)A, MATMPIBAIJ, &ismpibaij); CHKERRQ(ierr);
+	rawspmv = false;
+	if(isseqbaij) {
+		localA = A;
+		rawspmv = true;
+	}
+	else if(ismpibaij) {
+		MPI_Comm comm; int commsize;
+		ierr = PetscObjectGetComm((PetscObject)A, &comm); CHKERRQ(ierr);
+		ierr = MPI_Comm_size(comm, &commsize); CHKERRQ(ierr);
+		if(commsize == 1) {
+			Mat offdiag; const PetscInt *colmap;
+			ierr = MatMPIBAIJGetSeqBAIJ(A, &localA, &offdiag, &colmap); CHKERRQ(ierr);
+			rawspmv = true;
+		}
+	}
+
+	dinv.resize(nbrows*bs*bs);
+
+	if(rawspmv)
+	{
+		/* The structure and values are kept until the next setup, because every application
+		 * needs them. The values array is that of the matrix, so it sees any later changes to the
+		 * values as long as the non-zero pattern is the same - which is required anyway.
+		 */
+		PetscInt n; PetscBool done;
+		ierr = MatGetRowIJ(localA, 0, PETSC_FALSE, PETSC_TRUE, &n, &ia, &ja, &done); CHKERRQ(ierr);
+		if(!done) {
+			ia = ja = nullptr;
+			SETERRQ(PETSC_COMM_SELF, PETSC_ERR_SUP, "Could not access BAIJ structure!");
+		}
+		ierr = MatSeqBAIJGetArray(localA, &vals); CHKERRQ(ierr);
+
+		int nsingular = 0;
+#pragma omp parallel for default(shared) reduction(+:nsingular)
+		for(a_int i = 0; i < nbrows; i++)
+		{
+			Eigen::Map<Matrix<a_real,bs,bs,ColMajor>> di(&dinv[i*bs*bs]);
+			di = Matrix<a_real,bs,bs,ColMajor>::Zero();
+			for(PetscInt jj = ia[i]; jj < ia[i+1]; jj++)
+				if(ja[jj] == i) {
+					di = Eigen::Map<const Matrix<a_real,bs,bs,ColMajor>>(&vals[jj*bs*bs]).inverse();
+					break;
+				}
+			if(!di.allFinite())
+				nsingular++;
+		}
+
+		if(nsingular > 0)
+			SETERRQ(PETSC_COMM_SELF, PETSC_ERR_FP,
+			        "Polynomial preconditioner: singular diagonal block!");
+	}
+	else
+	{
+		const PetscScalar *pdinv;
+		ierr = MatInvertBlockDiagonal(A, &pdinv); CHKERRQ(ierr);
+		std::memcpy(&dinv[0], pdinv, nbrows*bs*bs*sizeof(a_real));
+	}
+
+	if(cfg.type == POLYPC_CHEBYSHEV) {
+		ierr = estimateMaxEigenvalue(); CHKERRQ(ierr);
+	}
+
+	return ierr;
+}
+
+template <int bs>
+void PolynomialPreconditioner<bs>::iterate(const a_real *const b, const a_real *const zold,
+                                           const a_real *const az,
+                                           const a_real c1, const a_real c2,
+                                           a_real *const d, a_real *const znew) const
+{
+	using Eigen::Map;
+	using Vector = Matrix<a_real,bs,1>;
+	using Block = Matrix<a_real,bs,bs,ColMajor>;
+
+#pragma omp parallel for default(shared)
+	for(a_int i = 0; i < nbrows; i++)
+	{
+		Vector t = Map<const Vector>(&b[i*bs]);
+		if(az)
+			t -= Map<const Vector>(&az[i*bs]);
+		else
+			for(PetscInt jj = ia[i]; jj < ia[i+1]; jj++)
+				t.noalias() -= Map<const Block>(&vals[jj*bs*bs])
+					* Map<const Vector>(&zold[ja[jj]*bs]);
+
+		Map<Vector> di(&d[i*bs]);
+		di = c1*di + c2*(Map<const Block>(&dinv[i*bs*bs]) * t);
+		Map<Vector> zi(&znew[i*bs]);
+		zi = Map<const Vector>(&zold[i*bs]) + di;
+	}
+}
+
+template <int bs>
+StatusCode PolynomialPreconditioner<bs>::apply(const Vec r, Vec z) const
+{
+	using Eigen::Map;
+	using Vector = Matrix<a_real,bs,1>;
+	using Block = Matrix<a_real,bs,bs,ColMajor>;
+	StatusCode ierr = 0;
+
+	// Coefficients of the iteration; see Saad, Iterative methods for sparse linear systems,
+	//  Algorithm 12.1 for Chebyshev.
+	a_real c0, theta = 0, delta = 0, sigma = 0, rho = 0;
+	if(cfg.type == POLYPC_CHEBYSHEV) {
+		const a_real emin = cfg.eiglower*maxeig, emax = cfg.eigupper*maxeig;
+		theta = (emax+emin)/2;
+		delta = (emax-emin)/2;
+		sigma = theta/delta;
+		rho = 1.0/sigma;
+		c0 = 1.0/theta;
+	}
+	else
+		c0 = cfg.damping;
+
+	// The iterates alternate between z and zwork, such that the last one lands in z.
+	Vec zs[2] = {z, zwork};
+	int cur = cfg.degree % 2;
+
+	const a_real *barr;
+	a_real *darr, *zarr;
+	ierr = VecGetArrayRead(r, &barr); CHKERRQ(ierr);
+	ierr = VecGetArray(dwork, &darr); CHKERRQ(ierr);
+	ierr = VecGetArray(zs[cur], &zarr); CHKERRQ(ierr);
+
+#pragma omp parallel for default(shared)
+	for(a_int i = 0; i < nbrows; i++)
+	{
+		Map<Vector> di(&darr[i*bs]);
+		di = c0*(Map<const Block>(&dinv[i*bs*bs]) * Map<const Vector>(&barr[i*bs]));
+		Map<Vector> zi(&zarr[i*bs]);
+		zi = di;
+	}
+
+	ierr = VecRestoreArray(zs[cur], &zarr); CHKERRQ(ierr);
+
+	for(int k = 0; k < cfg.degree; k++)
+	{
+		a_real c1, c2;
+		if(cfg.type == POLYPC_CHEBYSHEV) {
+			const a_real rhonew = 1.0/(2.0*sigma - rho);
+			c1 = rhonew*rho;
+			c2 = 2.0*rhonew/delta;
+			rho = rhonew;
+		}
+		else {
+			c1 = 0;
+			c2 = cfg.damping;
+		}
+
+		const a_real *azarr = nullptr;
+		if(!rawspmv) {
+			ierr = MatMult(A, zs[cur], azwork); CHKERRQ(ierr);
+			ierr = VecGetArrayRead(azwork, &azarr); CHKERRQ(ierr);
+		}
+
+		const a_real *zoldarr;
+		a_real *znewarr;
+		ierr = VecGetArrayRead(zs[cur], &zoldarr); CHKERRQ(ierr);
+		ierr = VecGetArray(zs[1-cur], &znewarr); CHKERRQ(ierr);
+
+		iterate(barr, zoldarr, azarr, c1, c2, darr, znewarr);
+
+		ierr = VecRestoreArray(zs[1-cur], &znewarr); CHKERRQ(ierr);
+		ierr = VecRestoreArrayRead(zs[cur], &zoldarr); CHKERRQ(ierr);
+		if(!rawspmv) {
+			ierr = VecRestoreArrayRead(azwork, &azarr); CHKERRQ(ierr);
+		}
+		cur = 1-cur;
+	}
+
+	ierr = VecRestoreArray(dwork, &darr); CHKERRQ(ierr);
+	ierr = VecRestoreArrayRead(r, &barr); CHKERRQ(ierr);
+	return ierr;
+}
+
+template <int bs>
+StatusCode PolynomialPreconditioner<bs>::applyScaledOperator(const Vec x, Vec y) const
+{
+	using Eigen::Map;
+	using Vector = Matrix<a_real,bs,1>;
+	using Block = Matrix<a_real,bs,bs,ColMajor>;
+
+	StatusCode ierr = MatMult(A, x, azwork); CHKERRQ(ierr);
+
+	const a_real *azarr;
+	a_real *yarr;
+	ierr = VecGetArrayRead(azwork, &azarr); CHKERRQ(ierr);
+	ierr = VecGetArray(y, &yarr); CHKERRQ(ierr);
+
+#pragma omp parallel for default(shared)
+	for(a_int i = 0; i < nbrows; i++) {
+		Map<Vector> yi(&yarr[i*bs]);
+		yi.noalias() = Map<const Block>(&dinv[i*bs*bs]) * Map<const Vector>(&azarr[i*bs]);
+	}
+
+	ierr = VecRestoreArray(y, &yarr); CHKERRQ(ierr);
+	ierr = VecRestoreArrayRead(azwork, &azarr); CHKERRQ(ierr);
+	return ierr;
+}
+
+template <int bs>
+StatusCode PolynomialPreconditioner<bs>::estimateMaxEigenvalue()
+{
+	StatusCode ierr = 0;
+	Vec x = zwork, y = dwork;
+	ierr = VecSet(x, 1.0); CHKERRQ(ierr);
+
+	PetscReal xnorm;
+	ierr = VecNorm(x, NORM_2, &xnorm); CHKERRQ(ierr);
+	maxeig = 1.0;
+	for(int it = 0; it < cfg.eigiters; it++)
+	{
+		ierr = VecScale(x, 1.0/xnorm); CHKERRQ(ierr);
+		ierr = applyScaledOperator(x, y); CHKERRQ(ierr);
+		ierr = VecNorm(y, NORM_2, &xnorm); CHKERRQ(ierr);
+		maxeig = xnorm;
+		std::swap(x,y);
+	}
+
+	if(!std::isfinite(maxeig) || maxeig <= 0)
+		SETERRQ(PETSC_COMM_SELF, PETSC_ERR_FP,
+		        "Polynomial preconditioner: invalid eigenvalue estimate!");
+	return ierr;
+}
+
+template <int bs>
+StatusCode PolynomialPreconditioner<bs>::releaseLocalMatrix()
+{
+	StatusCode ierr = 0;
+	if(vals) {
+		ierr = MatSeqBAIJRestoreArray(localA, &vals); CHKERRQ(ierr);
+		vals = nullptr;
+	}
+	if(ia) {
+		PetscInt n; PetscBool done;
+		ierr = MatRestoreRowIJ(localA, 0, PETSC_FALSE, PETSC_TRUE, &n, &ia, &ja, &done);
+		CHKERRQ(ierr);
+		ia = ja = nullptr;
+	}
+	return ierr;
+}
+
+template class PolynomialPreconditioner<NVARS>;
+template class PolynomialPreconditioner<1>;
+template class PolynomialPreconditioner<NVARS+1>;
+
+template <int nvars>
+static StatusCode polypc_setup(PC pc)
+{
+	StatusCode ierr = 0;
+	PolynomialPreconditioner<nvars> *ppc;
+	ierr = PCShellGetContext(pc, (void*)&ppc); CHKERRQ(ierr);
+	Mat A, M;
+	ierr = PCGetOperators(pc, &A, &M); CHKERRQ(ierr);
+	ierr = ppc->setup(M); CHKERRQ(ierr);
+	return ierr;
+}
+
+template <int nvars>
+static StatusCode polypc_apply(PC pc, Vec r, Vec z)
+{
+	StatusCode ierr = 0;
+	PolynomialPreconditioner<nvars> *ppc;
+	ierr = PCShellGetContext(pc, (void*)&ppc); CHKERRQ(ierr);
+	ierr = ppc->apply(r, z); CHKERRQ(ierr);
+	return ierr;
+}
+
+template <int nvars>
+static StatusCode polypc_destroy(PC pc)
+{
+	StatusCode ierr = 0;
+	PolynomialPreconditioner<nvars> *ppc;
+	ierr = PCShellGetContext(pc, (void*)&ppc); CHKERRQ(ierr);
+	delete ppc;
+	return ierr;
+}
+
+/// Recursively sets the polynomial preconditioner into every PCSHELL in the solver hierarchy
+template <int nvars>
+static StatusCode setPolynomialPCShells(KSP ksp, const PolynomialPCConfig& cfg, int& nset)
+{
+	StatusCode ierr = 0;
+	PC pc;
+	ierr = KSPGetPC(ksp, &pc); CHKERRQ(ierr);
+	PetscBool isbjacobi, isasm, ismg, isgamg, isksp, isshell;
+	ierr = PetscObjectTypeCompare((PetscObject)pc,PCBJACOBI,&isbjacobi); CHKERRQ(ierr);
+	ierr = PetscObjectTypeCompare((PetscObject)pc,PCASM,&isasm); CHKERRQ(ierr);
+	ierr = PetscObjectTypeCompare((PetscObject)pc,PCMG,&ismg); CHKERRQ(ierr);
+	ierr = PetscObjectTypeCompare((PetscObject)pc,PCGAMG,&isgamg); CHKERRQ(ierr);
+	ierr = PetscObjectTypeCompare((PetscObject)pc,PCKSP,&isksp); CHKERRQ(ierr);
+	ierr = PetscObjectTypeCompare((PetscObject)pc,PCSHELL,&isshell); CHKERRQ(ierr);
+
+	SubdomainPreconditioner *sdpc = NULL;
+	ierr = getSubdomainPreconditioner(pc, &sdpc); CHKERRQ(ierr);
+
+	if(sdpc) {
+		for(KSP subksp : sdpc->subdomainSolvers()) {
+			ierr = setPolynomialPCShells<nvars>(subksp, cfg, nset); CHKERRQ(ierr);
+		}
+	}
+	else if(isshell) {
+		PolynomialPreconditioner<nvars> *const ppc = new PolynomialPreconditioner<nvars>(cfg);
+		ierr = PCShellSetContext(pc, (void*)ppc); CHKERRQ(ierr);
+		ierr = PCShellSetSetUp(pc, &polypc_setup<nvars>); CHKERRQ(ierr);
+		ierr = PCShellSetApply(pc, &polypc_apply<nvars>); CHKERRQ(ierr);
+		ierr = PCShellSetDestroy(pc, &polypc_destroy<nvars>); CHKERRQ(ierr);
+		ierr = PCShellSetName(pc, cfg.type == POLYPC_CHEBYSHEV ? "fvens-chebyshev" : "fvens-neumann");
+		CHKERRQ(ierr);
+		nset++;
+	}
+	else if(isbjacobi || isasm)
+	{
+		PetscInt nlocalblocks, firstlocalblock;
+		ierr = KSPSetUp(ksp); CHKERRQ(ierr);
+		ierr = PCSetUp(pc); CHKERRQ(ierr);
+		KSP *subksp;
+		if(isbjacobi) {
+			ierr = PCBJacobiGetSubKSP(pc, &nlocalblocks, &firstlocalblock, &subksp); CHKERRQ(ierr);
+		}
+		else {
+			ierr = PCASMGetSubKSP(pc, &nlocalblocks, &firstlocalblock, &subksp); CHKERRQ(ierr);
+		}
+		for(int iblk = 0; iblk < nlocalblocks; iblk++) {
+			ierr = setPolynomialPCShells<nvars>(subksp[iblk], cfg, nset); CHKERRQ(ierr);
+		}
+	}
+	else if(ismg || isgamg) {
+		ierr = KSPSetUp(ksp); CHKERRQ(ierr);
+		ierr = PCSetUp(pc); CHKERRQ(ierr);
+		PetscInt nlevels;
+		ierr = PCMGGetLevels(pc, &nlevels); CHKERRQ(ierr);
+		for(int ilvl = 1; ilvl < nlevels; ilvl++) {
+			KSP smootherctx;
+			ierr = PCMGGetSmoother(pc, ilvl , &smootherctx); CHKERRQ(ierr);
+			ierr = setPolynomialPCShells<nvars>(smootherctx, cfg, nset); CHKERRQ(ierr);
+		}
+		KSP coarsesolver;
+		ierr = PCMGGetCoarseSolve(pc, &coarsesolver); CHKERRQ(ierr);
+		ierr = setPolynomialPCShells<nvars>(coarsesolver, cfg, nset); CHKERRQ(ierr);
+	}
+	else if(isksp) {
+		ierr = KSPSetUp(ksp); CHKERRQ(ierr);
+		ierr = PCSetUp(pc); CHKERRQ(ierr);
+		KSP subksp;
+		ierr = PCKSPGetKSP(pc, &subksp); CHKERRQ(ierr);
+		ierr = setPolynomialPCShells<nvars>(subksp, cfg, nset); CHKERRQ(ierr);
+	}
+
+	return ierr;
+}
+
+template <int nvars>
+StatusCode setup_polynomial_pc(KSP ksp, Vec u, const Spatial<a_real,nvars> *const startprob)
+{
+	StatusCode ierr = 0;
+	if(!parsePetscCmd_isDefined("-poly_pc_type"))
+		return ierr;
+
+	const PolynomialPCConfig cfg = parsePolynomialPCConfig();
+
+	Mat M, A;
+	ierr = KSPGetOperators(ksp, &A, &M); CHKERRQ(ierr);
+
+	// first assemble the matrix once because PETSc requires it
+	ierr = startprob->compute_jacobian(u, M); CHKERRQ(ierr);
+	ierr = MatAssemblyBegin(M, MAT_FINAL_ASSEMBLY); CHKERRQ(ierr);
+	ierr = MatAssemblyEnd(M, MAT_FINAL_ASSEMBLY); CHKERRQ(ierr);
+
+	int nset = 0;
+	ierr = setPolynomialPCShells<nvars>(ksp, cfg, nset); CHKERRQ(ierr);
+	if(nset == 0)
+		std::cout << " ! setup_polynomial_pc: -poly_pc_type was given, but no PCSHELL was found!\n";
+	else
+		std::cout << " setup_polynomial_pc: Set " << nset << " polynomial preconditioner(s) of degree "
+		          << cfg.degree << ".\n";
+
+	return ierr;
+}
+
+template StatusCode setup_polynomial_pc(KSP ksp, Vec u,
+                                        const Spatial<a_real,NVARS> *const startprob);
+template StatusCode setup_polynomial_pc(KSP ksp, Vec u,
+                                        const Spatial<a_real,1> *const startprob);
+template StatusCode setup_polynomial_pc(KSP ksp, Vec u,
+                                        const Spatial<a_real,NVARS+1> *const startprob);
+
+}
@@ -0,0 +1,152 @@
+/** @file polynomialpc.hpp
+ * @brief Block-diagonal-scaled polynomial preconditioners that need only sparse mat-vecs
+ * @author Aditya Kashi
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FVENS_POLYNOMIALPC_H
+#define FVENS_POLYNOMIALPC_H
+
+#include <vector>
+#include <petscksp.h>
+
+#include "aconstants.hpp"
+#include "spatial/aspatial.hpp"
+
+namespace fvens {
+
+/// Kinds of polynomial preconditioners available
+enum PolynomialPCType {
+	POLYPC_NEUMANN,         ///< Truncated (damped) Neumann series in the block-Jacobi scaled matrix
+	POLYPC_CHEBYSHEV        ///< Chebyshev polynomial using an estimate of the spectrum
+};
+
+/// Settings of a polynomial preconditioner
+struct PolynomialPCConfig
+{
+	PolynomialPCType type;
+	int degree;             ///< Number of matrix-vector products per application
+	int eigiters;           ///< Number of power iterations to estimate the largest eigenvalue
+	a_real eiglower;        ///< Lower end of the Chebyshev interval as a fraction of max eigenvalue
+	a_real eigupper;        ///< Upper end of the Chebyshev interval as a fraction of max eigenvalue
+	a_real damping;         ///< Damping factor of the Neumann series
+};
+
+/// Reads the polynomial preconditioner settings from the PETSc options database
+/** The options are
+ *  - `-poly_pc_type` (neumann or chebyshev)
+ *  - `-poly_pc_degree` (default 3)
+ *  - `-poly_pc_eig_iters` (default 10)
+ *  - `-poly_pc_eig_lower_factor` and `-poly_pc_eig_upper_factor` (default 0.1 and 1.1)
+ *  - `-poly_pc_neumann_damping` (default 1.0)
+ */
+PolynomialPCConfig parsePolynomialPCConfig();
+
+/// A polynomial in the block-diagonally scaled matrix \f$ D^{-1}A \f$ approximating its inverse
+/** Applying the preconditioner involves only sparse matrix-vector products and block-diagonal
+ * scaling, all of which are row-parallel, so it needs no triangular solves. Both kinds of
+ * polynomials are applied as a fixed number of steps of a stationary (Neumann) or Chebyshev
+ * iteration with zero initial guess; each step is a single fused pass over the block rows of the
+ * matrix.
+ *
+ * When the local part of the preconditioning matrix is a sequential BAIJ matrix with block size
+ * bs (as for the FVENS Jacobian, and the sub-domain matrices of block Jacobi and ASM), the
+ * mat-vecs are done with OpenMP threads directly on the BAIJ storage. For other matrices (eg.
+ * coarse multigrid levels), PETSc's MatMult and MatInvertBlockDiagonal are used instead.
+ */
+template <int bs>
+class PolynomialPreconditioner
+{
+public:
+	PolynomialPreconditioner(const PolynomialPCConfig config);
+
+	~PolynomialPreconditioner();
+
+	/// Compute the inverse diagonal blocks of the matrix and estimate its spectrum
+	StatusCode setup(Mat pmat);
+
+	/// Apply the preconditioner z = P(D^{-1}A) D^{-1} r
+	StatusCode apply(const Vec r, Vec z) const;
+
+	/// Estimate of the largest eigenvalue of \f$ D^{-1}A \f$ computed in the latest setup
+	a_real getMaxEigenvalueEstimate() const { return maxeig; }
+
+protected:
+	const PolynomialPCConfig cfg;
+
+	/// The preconditioning matrix
+	Mat A;
+
+	/// Whether the threaded BAIJ mat-vec is used, as opposed to MatMult
+	bool rawspmv;
+
+	/// Local sequential BAIJ matrix in case the threaded mat-vec is used
+	Mat localA;
+
+	/// Number of local block rows
+	a_int nbrows;
+
+	/// Block-row pointers of localA, held from setup until the next setup or destruction
+	const PetscInt *ia;
+	/// Block-column indices of localA, held from setup until the next setup or destruction
+	const PetscInt *ja;
+	/// Values of localA, held from setup until the next setup or destruction
+	PetscScalar *vals;
+
+	/// Inverses of the diagonal blocks, stored column-major as in PETSc BAIJ matrices
+	std::vector<a_real> dinv;
+
+	/// Work vectors
+	mutable Vec zwork, dwork, azwork;
+
+	/// Estimate of the largest eigenvalue of the block-diagonally scaled matrix
+	a_real maxeig;
+
+	/// Computes one step of the polynomial iteration from zold into znew
+	/** Computes, for each block row i,
+	 *   d_i <- c1 d_i + c2 D_i^{-1} (b - A zold)_i,  znew_i <- zold_i + d_i.
+	 * \param az If not null, the product A zold pre-computed by MatMult; otherwise, the product is
+	 *   computed on the fly from the BAIJ storage.
+	 */
+	void iterate(const a_real *const b, const a_real *const zold, const a_real *const az,
+	             const a_real c1, const a_real c2, a_real *const d, a_real *const znew) const;
+
+	/// Computes y <- D^{-1} A x
+	StatusCode applyScaledOperator(const Vec x, Vec y) const;
+
+	/// Power iterations for the largest eigenvalue of D^{-1}A
+	StatusCode estimateMaxEigenvalue();
+
+	/// Gives back the BAIJ structure and values of localA obtained in setup, if any
+	StatusCode releaseLocalMatrix();
+};
+
+/// Sets polynomial preconditioners in all PCSHELLs of the solver if `-poly_pc_type' is given
+/** The PCSHELLs can be at the top level or within block Jacobi, ASM, multigrid (as smoothers),
+ * PCKSP or the sub-domains of a SubdomainPreconditioner, like BLASTed preconditioners. Each shell owns its preconditioner context, which is
+ * destroyed along with the KSP. Cannot be combined with BLASTed preconditioners in the same solver.
+ *
+ * \param ksp The top-level KSP
+ * \param u A solution vector used to assemble the Jacobian matrix once, needed for initialization
+ *   of some PETSc preconditioners - the actual values don't matter.
+ * \param startprob A spatial discretization context to compute the Jacobian with
+ */
+template <int nvars>
+StatusCode setup_polynomial_pc(KSP ksp, Vec u, const Spatial<a_real,nvars> *const startprob);
+
+}
+
+#endif
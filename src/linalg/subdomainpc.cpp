@@ -0,0 +1,306 @@
+/** @file subdomainpc.cpp
+ * @brief Implementation of the threaded preconditioner of several mesh sub-domains per rank
+ * @author Aditya Kashi
+ */
+
+#include <iostream>
+#include <cstring>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "subdomainpc.hpp"
+#include "utilities/aoptionparser.hpp"
+#include "utilities/aerrorhandling.hpp"
+
+namespace fvens {
+
+/// Name given to PCSHELLs holding a sub-domain preconditioner
+static const char *const subdomain_pc_name = "fvens-subdomains";
+
+SubdomainPCConfig parseSubdomainPCConfig()
+{
+	SubdomainPCConfig cfg;
+#ifdef _OPENMP
+	cfg.nsubdomains = omp_get_max_threads();
+#else
+	cfg.nsubdomains = 1;
+#endif
+	PetscBool set = PETSC_FALSE;
+	PetscOptionsGetInt(NULL, NULL, "-mesh_subdomains", &cfg.nsubdomains, &set);
+	cfg.overlap = parsePetscCmd_isDefined("-mesh_subdomain_overlap") ?
+		parsePetscCmd_int("-mesh_subdomain_overlap") : 0;
+
+	fvens_throw(cfg.nsubdomains < 1, "Number of mesh sub-domains must be positive!");
+	fvens_throw(cfg.overlap < 0, "Overlap of mesh sub-domains must be non-negative!");
+	return cfg;
+}
+
+SubdomainPreconditioner::SubdomainPreconditioner(const UMesh2dh<a_real> *const mesh,
+                                                 const SubdomainPCConfig& config,
+                                                 const char *const prefix)
+	: sd{partitionSubdomains(*mesh, config.nsubdomains, config.overlap)},
+#ifdef PETSC_HAVE_THREADSAFETY
+	  threaded{true},
+#else
+	  threaded{false},
+#endif
+	  bs{0}, submats{NULL}
+{
+	const int nsd = static_cast<int>(sd.starts.size())-1;
+	subksp.resize(nsd);
+	for(int isd = 0; isd < nsd; isd++)
+	{
+		StatusCode ierr = KSPCreate(PETSC_COMM_SELF, &subksp[isd]);
+		petsc_throw(ierr, "Could not create sub-domain KSP");
+		ierr = KSPSetType(subksp[isd], KSPPREONLY);
+		petsc_throw(ierr, "Could not set sub-domain KSP type");
+		ierr = KSPSetOptionsPrefix(subksp[isd], prefix);
+		petsc_throw(ierr, "Could not set sub-domain options prefix");
+		ierr = KSPSetFromOptions(subksp[isd]);
+		petsc_throw(ierr, "Could not set sub-domain KSP options");
+	}
+
+	std::cout << " SubdomainPreconditioner: " << nsd << " sub-domains with " << config.overlap
+	          << " layers of overlap, " << sd.cells.size() << " cells in all.\n";
+	if(!threaded && nsd > 1)
+		std::cout << "! SubdomainPreconditioner: PETSc is not configured with --with-threadsafety;"
+			" the sub-domains are\n!  factored and solved one after the other, NOT concurrently.\n";
+}
+
+SubdomainPreconditioner::~SubdomainPreconditioner()
+{
+	for(size_t isd = 0; isd < subksp.size(); isd++)
+		KSPDestroy(&subksp[isd]);
+	for(size_t isd = 0; isd < subis.size(); isd++) {
+		ISDestroy(&subis[isd]);
+		VecDestroy(&subr[isd]);
+		VecDestroy(&subz[isd]);
+	}
+	if(submats)
+		MatDestroySubMatrices(static_cast<PetscInt>(subis.size()), &submats);
+}
+
+StatusCode SubdomainPreconditioner::setup(Mat pmat)
+{
+	StatusCode ierr = 0;
+	const int nsd = numSubdomains();
+
+	PetscInt matbs, rstart, rend;
+	ierr = MatGetBlockSize(pmat, &matbs); CHKERRQ(ierr);
+	ierr = MatGetOwnershipRange(pmat, &rstart, &rend); CHKERRQ(ierr);
+	if(rend-rstart != sd.ownedstarts.back()*matbs)
+		SETERRQ(PETSC_COMM_SELF, PETSC_ERR_ARG_WRONG,
+		        "Sub-domain preconditioner: matrix does not match the mesh!");
+
+	if(!submats)
+	{
+		bs = matbs;
+		subis.resize(nsd);
+		for(int isd = 0; isd < nsd; isd++)
+		{
+			// global block indices of the sub-domain's cells
+			std::vector<PetscInt> idx(sd.cells.begin()+sd.starts[isd],
+			                          sd.cells.begin()+sd.starts[isd+1]);
+			for(size_t i = 0; i < idx.size(); i++)
+				idx[i] += rstart/bs;
+			ierr = ISCreateBlock(PETSC_COMM_SELF, bs, static_cast<PetscInt>(idx.size()), idx.data(),
+			                     PETSC_COPY_VALUES, &subis[isd]); CHKERRQ(ierr);
+		}
+
+		ierr = MatCreateSubMatrices(pmat, nsd, subis.data(), subis.data(), MAT_INITIAL_MATRIX,
+		                            &submats); CHKERRQ(ierr);
+
+		subr.resize(nsd);
+		subz.resize(nsd);
+		for(int isd = 0; isd < nsd; isd++) {
+			ierr = MatCreateVecs(submats[isd], &subz[isd], &subr[isd]); CHKERRQ(ierr);
+			ierr = KSPSetOperators(subksp[isd], submats[isd], submats[isd]); CHKERRQ(ierr);
+		}
+	}
+	else
+	{
+		if(matbs != bs)
+			SETERRQ(PETSC_COMM_SELF, PETSC_ERR_ARG_WRONG,
+			        "Sub-domain preconditioner: block size of matrix has changed!");
+		ierr = MatCreateSubMatrices(pmat, nsd, subis.data(), subis.data(), MAT_REUSE_MATRIX,
+		                            &submats); CHKERRQ(ierr);
+	}
+
+	// factorize (or otherwise set up) the sub-domain preconditioners concurrently
+	std::vector<StatusCode> errs(nsd, 0);
+#pragma omp parallel for default(shared) schedule(dynamic,1) if(threaded)
+	for(int isd = 0; isd < nsd; isd++)
+		errs[isd] = KSPSetUp(subksp[isd]);
+
+	for(int isd = 0; isd < nsd; isd++) {
+		CHKERRQ(errs[isd]);
+	}
+	return ierr;
+}
+
+StatusCode SubdomainPreconditioner::solveSubdomain(const int isd, const a_real *const r,
+                                                   a_real *const z) const
+{
+	StatusCode ierr = 0;
+	const a_int start = sd.starts[isd];
+	const a_int ncells = sd.starts[isd+1] - start;
+
+	a_real *sr;
+	ierr = VecGetArray(subr[isd], &sr); CHKERRQ(ierr);
+	for(a_int i = 0; i < ncells; i++)
+	{
+		const a_int iel = sd.cells[start+i];
+		for(int j = 0; j < bs; j++)
+			sr[i*bs+j] = r[iel*bs+j];
+	}
+	ierr = VecRestoreArray(subr[isd], &sr); CHKERRQ(ierr);
+
+	ierr = KSPSolve(subksp[isd], subr[isd], subz[isd]); CHKERRQ(ierr);
+
+	// restricted: only the owned cells' values are written
+	const a_real *sz;
+	ierr = VecGetArrayRead(subz[isd], &sz); CHKERRQ(ierr);
+	for(a_int i = 0; i < ncells; i++)
+	{
+		const a_int iel = sd.cells[start+i];
+		if(iel < sd.ownedstarts[isd] || iel >= sd.ownedstarts[isd+1])
+			continue;
+		for(int j = 0; j < bs; j++)
+			z[iel*bs+j] = sz[i*bs+j];
+	}
+	ierr = VecRestoreArrayRead(subz[isd], &sz); CHKERRQ(ierr);
+	return ierr;
+}
+
+StatusCode SubdomainPreconditioner::solveLocal(const int isd, const a_real *const r,
+                                              a_real *const z) const
+{
+	StatusCode ierr = 0;
+	const PetscInt n = (sd.starts[isd+1] - sd.starts[isd])*bs;
+
+	a_real *sr;
+	ierr = VecGetArray(subr[isd], &sr); CHKERRQ(ierr);
+	for(PetscInt i = 0; i < n; i++)
+		sr[i] = r[i];
+	ierr = VecRestoreArray(subr[isd], &sr); CHKERRQ(ierr);
+
+	ierr = KSPSolve(subksp[isd], subr[isd], subz[isd]); CHKERRQ(ierr);
+
+	const a_real *sz;
+	ierr = VecGetArrayRead(subz[isd], &sz); CHKERRQ(ierr);
+	for(PetscInt i = 0; i < n; i++)
+		z[i] = sz[i];
+	ierr = VecRestoreArrayRead(subz[isd], &sz); CHKERRQ(ierr);
+	return ierr;
+}
+
+StatusCode SubdomainPreconditioner::apply(const Vec r, Vec z) const
+{
+	StatusCode ierr = 0;
+	const int nsd = numSubdomains();
+
+	const a_real *rarr;
+	a_real *zarr;
+	ierr = VecGetArrayRead(r, &rarr); CHKERRQ(ierr);
+	ierr = VecGetArray(z, &zarr); CHKERRQ(ierr);
+
+	std::vector<StatusCode> errs(nsd, 0);
+#pragma omp parallel for default(shared) schedule(dynamic,1) if(threaded)
+	for(int isd = 0; isd < nsd; isd++)
+		errs[isd] = solveSubdomain(isd, rarr, zarr);
+
+	ierr = VecRestoreArray(z, &zarr); CHKERRQ(ierr);
+	ierr = VecRestoreArrayRead(r, &rarr); CHKERRQ(ierr);
+	for(int isd = 0; isd < nsd; isd++) {
+		CHKERRQ(errs[isd]);
+	}
+	return ierr;
+}
+
+static StatusCode sdpc_setup(PC pc)
+{
+	StatusCode ierr = 0;
+	SubdomainPreconditioner *sdpc;
+	ierr = PCShellGetContext(pc, (void*)&sdpc); CHKERRQ(ierr);
+	Mat A, M;
+	ierr = PCGetOperators(pc, &A, &M); CHKERRQ(ierr);
+	ierr = sdpc->setup(M); CHKERRQ(ierr);
+	return ierr;
+}
+
+static StatusCode sdpc_apply(PC pc, Vec r, Vec z)
+{
+	StatusCode ierr = 0;
+	SubdomainPreconditioner *sdpc;
+	ierr = PCShellGetContext(pc, (void*)&sdpc); CHKERRQ(ierr);
+	ierr = sdpc->apply(r, z); CHKERRQ(ierr);
+	return ierr;
+}
+
+static StatusCode sdpc_destroy(PC pc)
+{
+	StatusCode ierr = 0;
+	SubdomainPreconditioner *sdpc;
+	ierr = PCShellGetContext(pc, (void*)&sdpc); CHKERRQ(ierr);
+	delete sdpc;
+	return ierr;
+}
+
+StatusCode getSubdomainPreconditioner(PC pc, SubdomainPreconditioner **sdpc)
+{
+	StatusCode ierr = 0;
+	*sdpc = NULL;
+	PetscBool isshell;
+	ierr = PetscObjectTypeCompare((PetscObject)pc,PCSHELL,&isshell); CHKERRQ(ierr);
+	if(!isshell)
+		return ierr;
+
+	const char *name;
+	ierr = PCShellGetName(pc, &name); CHKERRQ(ierr);
+	if(name && !strcmp(name, subdomain_pc_name)) {
+		ierr = PCShellGetContext(pc, (void*)sdpc); CHKERRQ(ierr);
+	}
+	return ierr;
+}
+
+template <int nvars>
+StatusCode setup_subdomain_pc(KSP ksp, Vec u, const Spatial<a_real,nvars> *const startprob)
+{
+	StatusCode ierr = 0;
+	if(!parsePetscCmd_isDefined("-mesh_subdomains"))
+		return ierr;
+
+	const SubdomainPCConfig cfg = parseSubdomainPCConfig();
+
+	Mat M, A;
+	ierr = KSPGetOperators(ksp, &A, &M); CHKERRQ(ierr);
+
+	// first assemble the matrix once because PETSc requires it
+	ierr = startprob->compute_jacobian(u, M); CHKERRQ(ierr);
+	ierr = MatAssemblyBegin(M, MAT_FINAL_ASSEMBLY); CHKERRQ(ierr);
+	ierr = MatAssemblyEnd(M, MAT_FINAL_ASSEMBLY); CHKERRQ(ierr);
+
+	PC pc;
+	ierr = KSPGetPC(ksp, &pc); CHKERRQ(ierr);
+	ierr = PCSetType(pc, PCSHELL); CHKERRQ(ierr);
+	SubdomainPreconditioner *const sdpc = new SubdomainPreconditioner(startprob->mesh(), cfg);
+	ierr = PCShellSetContext(pc, (void*)sdpc); CHKERRQ(ierr);
+	ierr = PCShellSetSetUp(pc, &sdpc_setup); CHKERRQ(ierr);
+	ierr = PCShellSetApply(pc, &sdpc_apply); CHKERRQ(ierr);
+	ierr = PCShellSetDestroy(pc, &sdpc_destroy); CHKERRQ(ierr);
+	ierr = PCShellSetName(pc, subdomain_pc_name); CHKERRQ(ierr);
+
+	// give the sub-domain solvers their operators, so that preconditioners can be set in them
+	ierr = KSPSetUp(ksp); CHKERRQ(ierr);
+	return ierr;
+}
+
+template StatusCode setup_subdomain_pc(KSP ksp, Vec u,
+                                       const Spatial<a_real,NVARS> *const startprob);
+template StatusCode setup_subdomain_pc(KSP ksp, Vec u,
+                                       const Spatial<a_real,1> *const startprob);
+template StatusCode setup_subdomain_pc(KSP ksp, Vec u,
+                                       const Spatial<a_real,NVARS+1> *const startprob);
+
+}
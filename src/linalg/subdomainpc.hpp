@@ -0,0 +1,140 @@
+/** @file subdomainpc.hpp
+ * @brief Threaded preconditioner of several mesh sub-domains per rank
+ * @author Aditya Kashi
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FVENS_SUBDOMAINPC_H
+#define FVENS_SUBDOMAINPC_H
+
+#include <vector>
+#include <petscksp.h>
+
+#include "aconstants.hpp"
+#include "mesh/ameshutils.hpp"
+#include "spatial/aspatial.hpp"
+
+namespace fvens {
+
+/// Settings of the sub-domain preconditioner
+struct SubdomainPCConfig
+{
+	int nsubdomains;        ///< Number of sub-domains on this rank
+	int overlap;            ///< Number of layers of cells by which each sub-domain is extended
+};
+
+/// Reads the sub-domain preconditioner settings from the PETSc options database
+/** The options are
+ *  - `-mesh_subdomains` (default: the number of OpenMP threads)
+ *  - `-mesh_subdomain_overlap` (default 0)
+ */
+SubdomainPCConfig parseSubdomainPCConfig();
+
+/// Restricted additive Schwarz over several mesh sub-domains of the local cells, using threads
+/** The local cells are divided into sub-domains by \ref partitionSubdomains. Each sub-domain has
+ * its own sequential KSP, by default with the options prefix "sub_" as in PETSc's block Jacobi and
+ * ASM, for the sub-matrix of the preconditioning matrix restricted to its cells (including
+ * overlap).
+ * The set-up of the sub-domain solvers (eg. ILU factorizations) and their solves run concurrently
+ * on OpenMP threads. Each sub-domain's solution is written only to the cells it owns, so threads
+ * never write to the same location and the result does not depend on the number of threads.
+ * Without overlap, this is block Jacobi with mesh-aware blocks.
+ *
+ * Concurrent use of PETSc objects requires PETSc to be configured with `--with-threadsafety';
+ * otherwise, the sub-domains are processed one after the other.
+ */
+class SubdomainPreconditioner
+{
+public:
+	/// Partitions the mesh and creates the sub-domain solvers
+	/** \param mesh The mesh whose cells are the rows of the preconditioning matrix
+	 * \param config Settings
+	 * \param prefix Options prefix of the sub-domain solvers
+	 */
+	SubdomainPreconditioner(const UMesh2dh<a_real> *const mesh, const SubdomainPCConfig& config,
+	                        const char *const prefix = "sub_");
+
+	~SubdomainPreconditioner();
+
+	/// Extracts the sub-domain matrices and sets up their solvers
+	StatusCode setup(Mat pmat);
+
+	/// Apply the preconditioner
+	StatusCode apply(const Vec r, Vec z) const;
+
+	int numSubdomains() const { return static_cast<int>(subksp.size()); }
+
+	/// The cells of the sub-domains
+	const MeshSubdomains& subdomains() const { return sd; }
+
+	/// Whether the sub-domains are processed concurrently
+	bool isThreaded() const { return threaded; }
+
+	/// Solves the system of one sub-domain, without restriction
+	/** Different sub-domains may be solved concurrently if \ref isThreaded is true.
+	 * \param isd The sub-domain
+	 * \param r Right hand side, ordered as the sub-domain's cells in \ref MeshSubdomains::cells
+	 * \param z Solution, in the same ordering
+	 */
+	StatusCode solveLocal(const int isd, const a_real *const r, a_real *const z) const;
+
+	/// The sub-domain solvers; they exist from construction, but have operators only after setup
+	const std::vector<KSP>& subdomainSolvers() const { return subksp; }
+
+protected:
+	const MeshSubdomains sd;
+
+	/// Whether the sub-domains are processed concurrently
+	const bool threaded;
+
+	/// Block size of the matrix, known after the first setup
+	int bs;
+
+	std::vector<KSP> subksp;
+
+	/// Index sets of the sub-domain matrices
+	std::vector<IS> subis;
+
+	/// The sub-domain matrices
+	Mat *submats;
+
+	/// Work vectors for the sub-domain right hand sides and solutions
+	std::vector<Vec> subr, subz;
+
+	/// Solves the sub-domain problem of one sub-domain and writes its owned part of z
+	StatusCode solveSubdomain(const int isd, const a_real *const r, a_real *const z) const;
+};
+
+/// Gets the sub-domain preconditioner of a PC, or NULL if it is not a sub-domain preconditioner
+StatusCode getSubdomainPreconditioner(PC pc, SubdomainPreconditioner **sdpc);
+
+/// Sets the top-level preconditioner to the sub-domain preconditioner if `-mesh_subdomains' is given
+/** This replaces the type of top-level PC given by `-pc_type'. The sub-domain solvers are set up
+ * from the options with the prefix "sub_". BLASTed and polynomial preconditioners (eg.
+ * `-sub_pc_type shell') may be used in the sub-domains; this must be called before those are
+ * set up.
+ *
+ * \param ksp The top-level KSP
+ * \param u A solution vector used to assemble the Jacobian matrix once, needed for initialization
+ *   of some PETSc preconditioners - the actual values don't matter.
+ * \param startprob A spatial discretization context to compute the Jacobian with
+ */
+template <int nvars>
+StatusCode setup_subdomain_pc(KSP ksp, Vec u, const Spatial<a_real,nvars> *const startprob);
+
+}
+
+#endif
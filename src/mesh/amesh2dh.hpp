@@ -136,6 +136,9 @@ public:
 	/// Returns the number of domain tags available for elements
 	int gndtag() const { return ndtag; }
 
+	/// Returns a volume region tag of an element; the first tag is the physical region
+	int gvol_region(const a_int ielem, const int itag) const { return vol_regions.get(ielem,itag); }
+
 	/// Set coordinates of a certain point
 	/** 'set' counterpart of the 'get' function [gcoords](@ref gcoords).
 	 */
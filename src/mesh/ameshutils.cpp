@@ -4,6 +4,7 @@
 
 #include <vector>
 #include <iostream>
+#include <algorithm>
 #include "ameshutils.hpp"
 #include "linalg/alinalg.hpp"
 #include "spatial/diffusion.hpp"
@@ -121,10 +122,71 @@ std::vector<a_int> levelSchedule(const UMesh2dh<scalar>& m)
 	return levels;
 }
 
+template <typename scalar>
+MeshSubdomains partitionSubdomains(const UMesh2dh<scalar>& m, const int nparts, const int overlap)
+{
+	const int np = std::max(std::min(nparts, static_cast<int>(m.gnelem())), 1);
+	MeshSubdomains sd;
+	sd.ownedstarts.resize(np+1);
+	for(int ip = 0; ip <= np; ip++)
+		sd.ownedstarts[ip] = static_cast<a_int>(static_cast<long>(m.gnelem())*ip/np);
+
+	std::vector<std::vector<a_int>> parts(np);
+
+#pragma omp parallel default(shared)
+	{
+		// marks cells already in the sub-domain being built
+		std::vector<bool> inpart(m.gnelem(), false);
+
+#pragma omp for schedule(dynamic,1)
+		for(int ip = 0; ip < np; ip++)
+		{
+			std::vector<a_int>& cells = parts[ip];
+			for(a_int iel = sd.ownedstarts[ip]; iel < sd.ownedstarts[ip+1]; iel++) {
+				cells.push_back(iel);
+				inpart[iel] = true;
+			}
+
+			// add one layer of neighbours of the cells added in the previous layer at a time
+			size_t layerstart = 0;
+			for(int ilayer = 0; ilayer < overlap; ilayer++)
+			{
+				const size_t layerend = cells.size();
+				for(size_t i = layerstart; i < layerend; i++)
+					for(int jface = 0; jface < m.gnfael(cells[i]); jface++)
+					{
+						const a_int nbr = m.gesuel(cells[i],jface);
+						if(nbr < m.gnelem() && !inpart[nbr]) {
+							cells.push_back(nbr);
+							inpart[nbr] = true;
+						}
+					}
+				layerstart = layerend;
+			}
+
+			for(const a_int iel : cells)
+				inpart[iel] = false;
+			std::sort(cells.begin(), cells.end());
+		}
+	}
+
+	sd.starts.resize(np+1);
+	sd.starts[0] = 0;
+	for(int ip = 0; ip < np; ip++)
+		sd.starts[ip+1] = sd.starts[ip] + static_cast<a_int>(parts[ip].size());
+	sd.cells.resize(sd.starts[np]);
+	for(int ip = 0; ip < np; ip++)
+		std::copy(parts[ip].begin(), parts[ip].end(), sd.cells.begin()+sd.starts[ip]);
+
+	return sd;
+}
+
 template StatusCode preprocessMesh(UMesh2dh<a_real>& m);
 
 template StatusCode reorderMesh(const char *const ordering, const Spatial<a_real,1>& sd,
                                 UMesh2dh<a_real>& m);
 template std::vector<a_int> levelSchedule(const UMesh2dh<a_real>& m);
+template MeshSubdomains partitionSubdomains(const UMesh2dh<a_real>& m, const int nparts,
+                                            const int overlap);
 
 }
@@ -41,5 +41,29 @@ StatusCode reorderMesh(const char *const ordering, const Spatial<a_real,1>& sd,
 template <typename scalar>
 std::vector<a_int> levelSchedule(const UMesh2dh<scalar>& m);
 
+/// Cells of a set of possibly overlapping sub-domains of a mesh
+struct MeshSubdomains
+{
+	/// Start of the cells owned by each sub-domain; the last entry is the number of cells.
+	/// The owned cells of sub-domain i are those from ownedstarts[i] to ownedstarts[i+1]-1.
+	std::vector<a_int> ownedstarts;
+	/// Cells of all sub-domains including overlap, each sub-domain's sorted in ascending order
+	std::vector<a_int> cells;
+	/// Start of each sub-domain's cells in \ref cells; the last entry is the size of \ref cells
+	std::vector<a_int> starts;
+};
+
+/// Divides the cells of a mesh into sub-domains, optionally extended by layers of neighbours
+/** The owned cells of the sub-domains are contiguous ranges of cells balanced by count, which
+ * partition the mesh. For the sub-domains to be compact, the mesh should have been reordered (eg.
+ * by RCM) beforehand. Each sub-domain is then extended by the given number of layers of face
+ * neighbours; ghost cells are never included.
+ * \param m The mesh, whose topological data must be available
+ * \param nparts Number of sub-domains; at most one per cell is used
+ * \param overlap Number of layers of neighbouring cells added to each sub-domain
+ */
+template <typename scalar>
+MeshSubdomains partitionSubdomains(const UMesh2dh<scalar>& m, const int nparts, const int overlap);
+
 }
 #endif
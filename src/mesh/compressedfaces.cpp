@@ -0,0 +1,84 @@
+/** \file compressedfaces.cpp
+ * \brief Construction of compressed face data
+ * \author Aditya Kashi
+ */
+
+#include <algorithm>
+#include <limits>
+#include "compressedfaces.hpp"
+#include "utilities/aoptionparser.hpp"
+
+namespace fvens {
+
+bool parseCompressedFaces()
+{
+	return parsePetscCmd_isDefined("-mesh_compressed_faces");
+}
+
+template <typename scalar>
+CompressedFaceData<scalar>::CompressedFaceData(const UMesh2dh<scalar> *const m)
+	: nwide{0}
+{
+	const a_int naface = m->gnaface();
+	const a_int nblocks = (naface + blocksize-1)/blocksize;
+	constexpr a_int maxoffset = std::numeric_limits<uint16_t>::max();
+
+	blocks.resize(nblocks);
+	loffsets.assign(naface, 0);
+	roffsets.assign(naface, 0);
+
+	for(a_int ib = 0; ib < nblocks; ib++)
+	{
+		const a_int start = ib*blocksize, end = std::min(start+blocksize, naface);
+		Block& b = blocks[ib];
+		b.lbase = m->gintfac(start,0);
+		b.rbase = m->gintfac(start,1);
+		a_int lmax = b.lbase, rmax = b.rbase;
+		for(a_int iface = start; iface < end; iface++) {
+			b.lbase = std::min(b.lbase, m->gintfac(iface,0));
+			b.rbase = std::min(b.rbase, m->gintfac(iface,1));
+			lmax = std::max(lmax, m->gintfac(iface,0));
+			rmax = std::max(rmax, m->gintfac(iface,1));
+		}
+
+		if(lmax - b.lbase <= maxoffset && rmax - b.rbase <= maxoffset)
+		{
+			b.wide = -1;
+			for(a_int iface = start; iface < end; iface++) {
+				loffsets[iface] = static_cast<uint16_t>(m->gintfac(iface,0) - b.lbase);
+				roffsets[iface] = static_cast<uint16_t>(m->gintfac(iface,1) - b.rbase);
+			}
+		}
+		else
+		{
+			b.wide = static_cast<a_int>(widecells.size()/2);
+			for(a_int iface = start; iface < end; iface++) {
+				widecells.push_back(m->gintfac(iface,0));
+				widecells.push_back(m->gintfac(iface,1));
+			}
+			nwide++;
+		}
+	}
+
+	normals.resize(naface*NDIM);
+	lengths.resize(naface);
+	for(a_int iface = 0; iface < naface; iface++)
+	{
+		for(int idim = 0; idim < NDIM; idim++)
+			normals[iface*NDIM+idim] = static_cast<float>(m->gfacemetric(iface,idim));
+		lengths[iface] = m->gfacemetric(iface,NDIM);
+	}
+}
+
+template <typename scalar>
+double CompressedFaceData<scalar>::bytesPerFace() const
+{
+	const double bytes = blocks.size()*sizeof(Block)
+		+ (loffsets.size() + roffsets.size())*sizeof(uint16_t) + widecells.size()*sizeof(a_int)
+		+ normals.size()*sizeof(float) + lengths.size()*sizeof(scalar);
+	return lengths.size() > 0 ? bytes/lengths.size() : 0;
+}
+
+template class CompressedFaceData<a_real>;
+
+}
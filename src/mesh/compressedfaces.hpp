@@ -0,0 +1,135 @@
+/** \file compressedfaces.hpp
+ * \brief Compact storage of the face-to-cell connectivity and face geometry used by face loops
+ * \author Aditya Kashi
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FVENS_COMPRESSEDFACES_H
+#define FVENS_COMPRESSEDFACES_H
+
+#include <vector>
+#include <cstdint>
+#include "amesh2dh.hpp"
+
+namespace fvens {
+
+/// Reads whether face loops should use \ref CompressedFaceData, from the PETSc option
+/// `-mesh_compressed_faces'
+bool parseCompressedFaces();
+
+/// Face data of a mesh as needed by face loops, read directly from the mesh
+/** This has the same interface as \ref CompressedFaceData, so that face loop kernels can be written
+ * once for both.
+ */
+template <typename scalar>
+class MeshFaceData
+{
+public:
+	MeshFaceData(const UMesh2dh<scalar> *const mesh) : m{mesh} { }
+
+	/// Left cell of a face
+	a_int leftCell(const a_int iface) const { return m->gintfac(iface,0); }
+
+	/// Right cell of a face; for a boundary face, this is the ghost cell
+	a_int rightCell(const a_int iface) const { return m->gintfac(iface,1); }
+
+	/// A component of the unit normal of a face
+	scalar normal(const a_int iface, const int idim) const { return m->gfacemetric(iface,idim); }
+
+	/// Length of a face
+	scalar length(const a_int iface) const { return m->gfacemetric(iface,NDIM); }
+
+protected:
+	const UMesh2dh<scalar> *const m;
+};
+
+/// Compressed face-to-cell connectivity and face geometry
+/** The face loops of the residual and gradients are bound by memory bandwidth: per face, they read
+ * a row of \ref UMesh2dh::intfac (4 integers, of which 2 are needed) and of the face metric
+ * (3 doubles). Here, the faces are grouped into blocks of \ref blocksize consecutive faces. Each
+ * block stores the smallest left cell index and the smallest right cell index of its faces, and
+ * each face stores the offsets of its cells from these as 16-bit integers. After a bandwidth-
+ * reducing reordering (eg. `-mesh_reorder rcm'), the cells of consecutive faces are close together,
+ * so nearly all blocks can be compressed; a block whose offsets do not fit is stored with full
+ * indices instead. Unit normals are stored in single precision and lengths in double precision.
+ * This makes 20 bytes per face in 2D instead of 40.
+ *
+ * The single precision normals perturb the discretization at the level of 1e-7 relative, which is
+ * far below the discretization error but means that a uniform flow is preserved only to that
+ * level. Fluxes remain conservative, as both cells of a face use the same normal.
+ */
+template <typename scalar>
+class CompressedFaceData
+{
+public:
+	/// Number of faces per block
+	static constexpr int blocksize = 64;
+
+	/// Compresses the face data of a mesh
+	/** \param mesh A mesh whose topological data and face metric are available
+	 */
+	CompressedFaceData(const UMesh2dh<scalar> *const mesh);
+
+	/// Left cell of a face
+	a_int leftCell(const a_int iface) const {
+		const Block& b = blocks[iface/blocksize];
+		return b.wide < 0 ? b.lbase + loffsets[iface]
+			: widecells[2*(b.wide + iface%blocksize)];
+	}
+
+	/// Right cell of a face; for a boundary face, this is the ghost cell
+	a_int rightCell(const a_int iface) const {
+		const Block& b = blocks[iface/blocksize];
+		return b.wide < 0 ? b.rbase + roffsets[iface]
+			: widecells[2*(b.wide + iface%blocksize)+1];
+	}
+
+	/// A component of the unit normal of a face
+	scalar normal(const a_int iface, const int idim) const { return normals[iface*NDIM+idim]; }
+
+	/// Length of a face
+	scalar length(const a_int iface) const { return lengths[iface]; }
+
+	/// Number of blocks whose cell indices could not be compressed
+	a_int numWideBlocks() const { return nwide; }
+
+	/// Number of bytes used per face
+	double bytesPerFace() const;
+
+protected:
+	/// Cell indices of a block of faces
+	struct Block {
+		a_int lbase;         ///< Smallest left cell index of the block
+		a_int rbase;         ///< Smallest right cell index of the block
+		a_int wide;          ///< Start of the block's faces in \ref widecells, or -1 if compressed
+	};
+
+	std::vector<Block> blocks;
+
+	/// Offsets of the cells of each face from the bases of its block
+	std::vector<uint16_t> loffsets, roffsets;
+
+	/// Left and right cells of the faces of the blocks that could not be compressed
+	std::vector<a_int> widecells;
+
+	std::vector<float> normals;
+	std::vector<scalar> lengths;
+
+	a_int nwide;
+};
+
+}
+#endif
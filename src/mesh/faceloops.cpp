@@ -0,0 +1,146 @@
+/** \file faceloops.cpp
+ * \brief Construction of face loop schedules
+ * \author Aditya Kashi
+ */
+
+#include <iostream>
+#include "faceloops.hpp"
+#include "utilities/aoptionparser.hpp"
+#include "utilities/aerrorhandling.hpp"
+
+namespace fvens {
+
+FaceLoopMode parseFaceLoopMode()
+{
+	if(!parsePetscCmd_isDefined("-face_loop_mode"))
+		return FACELOOP_ATOMIC;
+
+	const std::string mode = parsePetscCmd_string("-face_loop_mode", 20);
+	if(mode == "atomic")
+		return FACELOOP_ATOMIC;
+	else if(mode == "coloured" || mode == "colored")
+		return FACELOOP_COLOURED;
+	else if(mode == "partitioned")
+		return FACELOOP_PARTITIONED;
+	else
+		throw std::runtime_error("Invalid -face_loop_mode " + mode + "!");
+}
+
+template <typename scalar>
+FaceLoopSchedule<scalar>::FaceLoopSchedule(const UMesh2dh<scalar> *const mesh,
+                                           const FaceLoopMode mode, const int numparts,
+                                           const bool compressfaces)
+	: m{mesh}, loopmode{mode}, nparts{numparts > 0 ? numparts : 1},
+	  cfaces{compressfaces ? new CompressedFaceData<scalar>(mesh) : nullptr}, lastteamsize{0}
+{
+	// the cell ranges are always available, so that ownership can be queried in any mode
+	cellstarts.resize(nparts+1);
+	for(int ip = 0; ip <= nparts; ip++)
+		cellstarts[ip] = static_cast<a_int>(static_cast<long>(m->gnelem())*ip/nparts);
+
+	if(loopmode == FACELOOP_PARTITIONED) {
+		computePartitions();
+		std::cout << " FaceLoopSchedule: " << nparts << " thread-private sub-domains, "
+		          << sharedfaces.size()/2 << " interface faces out of " << m->gnaface() << ".\n";
+	}
+	else if(loopmode == FACELOOP_COLOURED) {
+		computeColouring();
+		std::cout << " FaceLoopSchedule: " << colstarts.size()-1 << " face colours.\n";
+	}
+	if(cfaces)
+		std::cout << " FaceLoopSchedule: Compressed face data, " << cfaces->bytesPerFace()
+		          << " bytes per face; " << cfaces->numWideBlocks() << " uncompressed blocks.\n";
+}
+
+template <typename scalar>
+FaceLoopSchedule<scalar>::~FaceLoopSchedule()
+{
+	delete cfaces;
+}
+
+template <typename scalar>
+void FaceLoopSchedule<scalar>::computePartitions()
+{
+	// count first, then fill, so that each part's faces are contiguous and in mesh order
+	std::vector<a_int> nowned(nparts,0), nshared(nparts,0);
+	for(a_int iface = 0; iface < m->gnaface(); iface++)
+	{
+		const int lpart = cellOwner(m->gintfac(iface,0));
+		const int rpart = iface < m->gnbface() ? lpart : cellOwner(m->gintfac(iface,1));
+		if(lpart == rpart)
+			nowned[lpart]++;
+		else {
+			nshared[lpart]++;
+			nshared[rpart]++;
+		}
+	}
+
+	ownedstarts.assign(nparts+1, 0);
+	sharedstarts.assign(nparts+1, 0);
+	for(int ip = 0; ip < nparts; ip++) {
+		ownedstarts[ip+1] = ownedstarts[ip] + nowned[ip];
+		sharedstarts[ip+1] = sharedstarts[ip] + nshared[ip];
+	}
+
+	ownedfaces.resize(ownedstarts[nparts]);
+	sharedfaces.resize(sharedstarts[nparts]);
+	std::vector<a_int> opos(ownedstarts.begin(), ownedstarts.end()-1);
+	std::vector<a_int> spos(sharedstarts.begin(), sharedstarts.end()-1);
+
+	for(a_int iface = 0; iface < m->gnaface(); iface++)
+	{
+		const int lpart = cellOwner(m->gintfac(iface,0));
+		const int rpart = iface < m->gnbface() ? lpart : cellOwner(m->gintfac(iface,1));
+		if(lpart == rpart)
+			ownedfaces[opos[lpart]++] = iface;
+		else {
+			sharedfaces[spos[lpart]++] = iface;
+			sharedfaces[spos[rpart]++] = iface;
+		}
+	}
+}
+
+template <typename scalar>
+void FaceLoopSchedule<scalar>::computeColouring()
+{
+	std::vector<int> facecolour(m->gnaface(), -1);
+	std::vector<bool> forbidden;
+	int ncolours = 0;
+
+	for(a_int iface = 0; iface < m->gnaface(); iface++)
+	{
+		forbidden.assign(ncolours, false);
+		const int ncells = iface < m->gnbface() ? 1 : 2;
+		for(int j = 0; j < ncells; j++)
+		{
+			const a_int icell = m->gintfac(iface,j);
+			for(int jface = 0; jface < m->gnfael(icell); jface++) {
+				const int col = facecolour[m->gelemface(icell,jface)];
+				if(col >= 0)
+					forbidden[col] = true;
+			}
+		}
+
+		int col = 0;
+		while(col < ncolours && forbidden[col])
+			col++;
+		if(col == ncolours)
+			ncolours++;
+		facecolour[iface] = col;
+	}
+
+	colstarts.assign(ncolours+1, 0);
+	for(a_int iface = 0; iface < m->gnaface(); iface++)
+		colstarts[facecolour[iface]+1]++;
+	for(int icol = 0; icol < ncolours; icol++)
+		colstarts[icol+1] += colstarts[icol];
+
+	colfaces.resize(m->gnaface());
+	std::vector<a_int> pos(colstarts.begin(), colstarts.end()-1);
+	for(a_int iface = 0; iface < m->gnaface(); iface++)
+		colfaces[pos[facecolour[iface]]++] = iface;
+}
+
+template class FaceLoopSchedule<a_real>;
+
+}
@@ -0,0 +1,276 @@
+/** \file faceloops.hpp
+ * \brief Schedules for threaded loops over faces that scatter contributions to both neighbouring
+ *   cells
+ * \author Aditya Kashi
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FVENS_FACELOOPS_H
+#define FVENS_FACELOOPS_H
+
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "amesh2dh.hpp"
+#include "compressedfaces.hpp"
+
+namespace fvens {
+
+/// Ways in which a face loop can avoid write conflicts between threads
+enum FaceLoopMode {
+	FACELOOP_ATOMIC,          ///< All faces in one parallel loop, with atomic updates to cells
+	FACELOOP_COLOURED,        ///< Faces in a colour share no cell; one parallel loop per colour
+	FACELOOP_PARTITIONED      ///< Each thread owns a contiguous block of cells and its faces
+};
+
+/// Reads the face loop mode from the PETSc option `-face_loop_mode'
+/** The values are atomic (default), coloured or partitioned.
+ */
+FaceLoopMode parseFaceLoopMode();
+
+/// Number of threads in the current team, 1 without OpenMP
+inline int faceLoopTeamSize()
+{
+#ifdef _OPENMP
+	return omp_get_num_threads();
+#else
+	return 1;
+#endif
+}
+
+/// Index of the calling thread in the current team, 0 without OpenMP
+inline int faceLoopThreadIndex()
+{
+#ifdef _OPENMP
+	return omp_get_thread_num();
+#else
+	return 0;
+#endif
+}
+
+/// Adds a value to a location shared between threads, atomically if required
+template <typename T>
+inline void faceLoopUpdate(T& target, const T value, const bool atomic)
+{
+	if(atomic) {
+#pragma omp atomic update
+		target += value;
+	}
+	else
+		target += value;
+}
+
+/// Divides the faces of a mesh among threads such that cell-wise updates need no atomics
+/** In the partitioned mode, the cells are split into a number of contiguous ranges (parts), balanced
+ * by cell count. For locality, the mesh should have been reordered (eg. `-mesh_reorder rcm') so
+ * that contiguous ranges form compact sub-domains. A face whose cells both belong to one part, and a
+ * boundary face whose interior cell does, is owned by that part. The faces between two parts are
+ * listed in both parts. Each thread first processes its owned faces, updating both cells, and then
+ * its interface faces, updating only the cell it owns. Interface face kernels are thus computed
+ * twice, in exchange for no synchronization at all. Since the parts are (nearly) the contiguous cell
+ * ranges used by static OpenMP scheduling of cell loops, cell data initialized (first touched) in
+ * such loops is local to the NUMA domain of the thread which updates it in the face loop.
+ *
+ * In the coloured mode, faces are greedily coloured so that no two faces of a colour share a cell.
+ *
+ * Optionally, the schedule holds a \ref CompressedFaceData copy of the face connectivity and
+ * geometry, which kernels run by \ref executeWithFaceData read instead of the mesh's.
+ */
+template <typename scalar>
+class FaceLoopSchedule
+{
+public:
+	/// Sets up the schedule
+	/** \param mesh The mesh whose faces are to be looped over; must be preprocessed
+	 * \param loopmode The method to use
+	 * \param numparts Number of parts of the partitioned mode, normally the number of threads
+	 * \param compressfaces Whether to set up compressed face data
+	 */
+	FaceLoopSchedule(const UMesh2dh<scalar> *const mesh, const FaceLoopMode loopmode,
+	                 const int numparts, const bool compressfaces = false);
+
+	~FaceLoopSchedule();
+
+	FaceLoopMode mode() const { return loopmode; }
+
+	int numParts() const { return nparts; }
+
+	/// Index of the part owning a cell; ghost cells are not owned by any part
+	int cellOwner(const a_int icell) const {
+		if(icell >= cellstarts.back())
+			return -1;
+		return static_cast<int>(std::upper_bound(cellstarts.begin(), cellstarts.end(), icell)
+		                        - cellstarts.begin()) - 1;
+	}
+
+	/// Start index of each part's cell range; the last entry is the number of cells
+	const std::vector<a_int>& partCellStarts() const { return cellstarts; }
+
+	/// Faces owned by each part, stored contiguously in ranges given by \ref ownedFaceStarts
+	const std::vector<a_int>& ownedFaces() const { return ownedfaces; }
+	const std::vector<a_int>& ownedFaceStarts() const { return ownedstarts; }
+
+	/// Interface faces of each part, in ranges given by \ref sharedFaceStarts
+	const std::vector<a_int>& sharedFaces() const { return sharedfaces; }
+	const std::vector<a_int>& sharedFaceStarts() const { return sharedstarts; }
+
+	/// Faces sorted by colour, in ranges given by \ref colourStarts
+	const std::vector<a_int>& colouredFaces() const { return colfaces; }
+	const std::vector<a_int>& colourStarts() const { return colstarts; }
+
+	/// Runs a kernel over all faces of the mesh in parallel
+	/** Must be called outside of parallel regions; opens its own, with the current number of
+	 * threads in every mode. In the partitioned mode, each thread processes every part whose index
+	 * is its thread number modulo the number of threads, so the loop is best balanced (and local)
+	 * when the number of threads equals \ref numParts.
+	 * \param kernel A callable with the signature
+	 *   `void (a_int iface, bool updateleft, bool updateright, bool atomic)`. It must add
+	 *   contributions only to the left cell of the face if updateleft is true and to the right cell
+	 *   if updateright is true, and use \ref faceLoopUpdate (or equivalent) with the atomic flag for
+	 *   those updates. The kernel must check itself whether the right cell is a ghost cell.
+	 */
+	template <typename Kernel>
+	void execute(Kernel&& kernel) const;
+
+	/// Runs a kernel over all faces of the mesh in parallel, giving it access to the face data
+	/** As \ref execute, but the kernel takes as its first argument an object with the interface of
+	 * \ref MeshFaceData, from which it must get the cells and geometry of the face. This is the
+	 * compressed face data if the schedule has it, so the kernel is compiled for both.
+	 */
+	template <typename Kernel>
+	void executeWithFaceData(Kernel&& kernel) const;
+
+	/// Calls a function once with the face data that \ref executeWithFaceData gives kernels
+	/** For computations on a few cells which must match the face loops exactly.
+	 * \param func A callable taking an object with the interface of \ref MeshFaceData
+	 */
+	template <typename Function>
+	void withFaceData(Function&& func) const {
+		if(cfaces)
+			func(*cfaces);
+		else
+			func(MeshFaceData<scalar>(m));
+	}
+
+	/// Number of threads that ran the last face loop, or 0 if none has run
+	int lastTeamSize() const { return lastteamsize.load(std::memory_order_relaxed); }
+
+	/// The compressed face data, or NULL if it is not used
+	const CompressedFaceData<scalar> *compressedFaces() const { return cfaces; }
+
+protected:
+	const UMesh2dh<scalar> *const m;
+	const FaceLoopMode loopmode;
+	const int nparts;
+
+	/// Compressed face data, if requested
+	const CompressedFaceData<scalar> *const cfaces;
+
+	std::vector<a_int> cellstarts;
+	std::vector<a_int> ownedfaces;
+	std::vector<a_int> ownedstarts;
+	std::vector<a_int> sharedfaces;
+	std::vector<a_int> sharedstarts;
+	std::vector<a_int> colfaces;
+	std::vector<a_int> colstarts;
+
+	/// Team size of the last face loop, for diagnostics
+	mutable std::atomic<int> lastteamsize;
+
+	void computePartitions();
+	void computeColouring();
+};
+
+template <typename scalar>
+template <typename Kernel>
+void FaceLoopSchedule<scalar>::execute(Kernel&& kernel) const
+{
+	if(loopmode == FACELOOP_COLOURED)
+	{
+		const int ncolours = static_cast<int>(colstarts.size())-1;
+#pragma omp parallel default(shared)
+		{
+#pragma omp master
+			lastteamsize.store(faceLoopTeamSize(), std::memory_order_relaxed);
+
+			for(int icol = 0; icol < ncolours; icol++)
+			{
+#pragma omp for
+				for(a_int i = colstarts[icol]; i < colstarts[icol+1]; i++)
+					kernel(colfaces[i], true, true, false);
+			}
+		}
+	}
+	else if(loopmode == FACELOOP_PARTITIONED)
+	{
+#pragma omp parallel default(shared)
+		{
+			// threads take more than one part if there are fewer threads than parts
+			const int nthreads = faceLoopTeamSize();
+#pragma omp master
+			lastteamsize.store(nthreads, std::memory_order_relaxed);
+
+			for(int ip = faceLoopThreadIndex(); ip < nparts; ip += nthreads)
+			{
+				for(a_int i = ownedstarts[ip]; i < ownedstarts[ip+1]; i++)
+					kernel(ownedfaces[i], true, true, false);
+
+				for(a_int i = sharedstarts[ip]; i < sharedstarts[ip+1]; i++)
+				{
+					const a_int iface = sharedfaces[i];
+					const bool ownleft = cellOwner(m->gintfac(iface,0)) == ip;
+					kernel(iface, ownleft, !ownleft, false);
+				}
+			}
+		}
+	}
+	else
+	{
+#pragma omp parallel default(shared)
+		{
+#pragma omp master
+			lastteamsize.store(faceLoopTeamSize(), std::memory_order_relaxed);
+
+#pragma omp for
+			for(a_int iface = 0; iface < m->gnaface(); iface++)
+				kernel(iface, true, true, true);
+		}
+	}
+}
+
+template <typename scalar>
+template <typename Kernel>
+void FaceLoopSchedule<scalar>::executeWithFaceData(Kernel&& kernel) const
+{
+	if(cfaces)
+		execute([&](const a_int iface, const bool updleft, const bool updright,
+		            const bool atomic) {
+			kernel(*cfaces, iface, updleft, updright, atomic);
+		});
+	else {
+		const MeshFaceData<scalar> mfaces(m);
+		execute([&](const a_int iface, const bool updleft, const bool updright,
+		            const bool atomic) {
+			kernel(mfaces, iface, updleft, updright, atomic);
+		});
+	}
+}
+
+}
+#endif
@@ -0,0 +1,65 @@
+/** \file localstencil.cpp
+ * \brief Construction of locally numbered neighbourhoods of sets of cells
+ * \author Aditya Kashi
+ */
+
+#include <unordered_map>
+#include "localstencil.hpp"
+
+namespace fvens {
+
+template <typename scalar>
+LocalStencil buildLocalStencil(const UMesh2dh<scalar>& m, const a_int *const cells,
+                               const a_int ncells, const int nlayers)
+{
+	LocalStencil st;
+	st.nrows = ncells;
+	st.cells.assign(cells, cells+ncells);
+
+	// local index of each local cell, by mesh index
+	std::unordered_map<a_int,a_int> localidx;
+	for(a_int i = 0; i < ncells; i++)
+		localidx[cells[i]] = i;
+
+	st.layerstarts.push_back(0);
+	st.nbrstarts.push_back(0);
+	for(int ilayer = 0; ilayer < nlayers; ilayer++)
+	{
+		const a_int layerstart = st.layerstarts.back();
+		const a_int layerend = static_cast<a_int>(st.cells.size());
+		st.layerstarts.push_back(layerend);
+
+		for(a_int l = layerstart; l < layerend; l++)
+		{
+			const a_int iel = st.cells[l];
+			for(int jface = 0; jface < m.gnfael(iel); jface++)
+			{
+				const a_int nbr = m.gesuel(iel,jface);
+				if(nbr >= m.gnelem()) {
+					st.nbrs.push_back(-1-static_cast<a_int>(st.bfaces.size()));
+					st.bfaces.push_back(m.gelemface(iel,jface));
+					continue;
+				}
+
+				const auto it = localidx.find(nbr);
+				if(it != localidx.end())
+					st.nbrs.push_back(it->second);
+				else {
+					const a_int lnbr = static_cast<a_int>(st.cells.size());
+					localidx[nbr] = lnbr;
+					st.cells.push_back(nbr);
+					st.nbrs.push_back(lnbr);
+				}
+			}
+			st.nbrstarts.push_back(static_cast<a_int>(st.nbrs.size()));
+		}
+	}
+	st.layerstarts.push_back(static_cast<a_int>(st.cells.size()));
+
+	return st;
+}
+
+template LocalStencil buildLocalStencil(const UMesh2dh<a_real>& m, const a_int *const cells,
+                                        const a_int ncells, const int nlayers);
+
+}
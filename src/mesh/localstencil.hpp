@@ -0,0 +1,69 @@
+/** \file localstencil.hpp
+ * \brief Locally numbered neighbourhoods of sets of cells
+ * \author Aditya Kashi
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FVENS_LOCALSTENCIL_H
+#define FVENS_LOCALSTENCIL_H
+
+#include <vector>
+#include "amesh2dh.hpp"
+
+namespace fvens {
+
+/// A set of cells extended by layers of face neighbours, with cells numbered locally
+/** This is what is needed to compute the residual of only some cells of a mesh in arrays sized by
+ * the neighbourhood of those cells. The local cells are the given cells (the 'rows') followed by
+ * the layers of neighbours, one layer after the other. Ghost cells are never local cells; the
+ * boundary faces of the local cells are numbered locally instead.
+ *
+ * The connectivity is stored for the cells of all but the outermost layer: face j of such a local
+ * cell l, in the order of \ref UMesh2dh::gelemface, is entry nbrstarts[l]+j of \ref nbrs.
+ */
+struct LocalStencil
+{
+	/// Number of rows, which are the first local cells
+	a_int nrows;
+	/// Mesh indices of the local cells
+	std::vector<a_int> cells;
+	/// Start of each layer in \ref cells, layer 0 being the rows; the last entry is the number of
+	///  local cells
+	std::vector<a_int> layerstarts;
+	/// Start of the faces of each local cell of all but the outermost layer in \ref nbrs
+	std::vector<a_int> nbrstarts;
+	/// Local index of the neighbour across each face of the inner cells, or -1-i for the boundary
+	///  face i of \ref bfaces
+	std::vector<a_int> nbrs;
+	/// Mesh indices of the boundary faces of the inner cells
+	std::vector<a_int> bfaces;
+
+	/// Number of cells, from the first, whose connectivity is stored
+	a_int numInnerCells() const { return static_cast<a_int>(nbrstarts.size())-1; }
+};
+
+/// Builds the neighbourhood of a set of cells
+/** \param m The mesh, whose topological data must be available
+ * \param cells Mesh indices of the rows; they must be distinct
+ * \param ncells Number of rows
+ * \param nlayers Number of layers of neighbours to add
+ */
+template <typename scalar>
+LocalStencil buildLocalStencil(const UMesh2dh<scalar>& m, const a_int *const cells,
+                               const a_int ncells, const int nlayers);
+
+}
+#endif
@@ -0,0 +1,233 @@
+/** \file walldistance.cpp
+ * \brief Computation of wall distances using a bounding-volume tree of wall faces
+ * \author Aditya Kashi
+ */
+
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include "walldistance.hpp"
+
+namespace fvens {
+
+/// Max number of faces in a leaf of the tree
+static const a_int leaf_size = 4;
+
+/// Size of the traversal stack; it never holds more than one entry per level of the tree, and
+/// the median split keeps the number of levels below 1 + log2 of the number of faces
+static const int max_stack_depth = 128;
+
+template <typename scalar>
+WallDistance<scalar>::WallDistance(const UMesh2dh<scalar> *const mesh,
+                                   const std::vector<int>& wallmarkers)
+	: m{mesh}, dists(m->gnelem()), nearest(m->gnelem(),-1)
+{
+	for(a_int iface = 0; iface < m->gnbface(); iface++)
+		if(std::find(wallmarkers.begin(), wallmarkers.end(), m->gintfacbtags(iface,0))
+		   != wallmarkers.end())
+			wallfaces.push_back(iface);
+
+	rebuild();
+}
+
+template <typename scalar>
+void WallDistance<scalar>::rebuild()
+{
+	nodes.clear();
+	if(wallfaces.size() > 0)
+	{
+		nodes.reserve(2*wallfaces.size()/leaf_size + 1);
+		std::vector<scalar> facecentres(m->gnbface()*NDIM);
+		for(const a_int iface : wallfaces)
+			for(int j = 0; j < NDIM; j++)
+				facecentres[iface*NDIM+j] = 0.5*(m->gcoords(m->gintfac(iface,2),j)
+				                                 + m->gcoords(m->gintfac(iface,3),j));
+
+		buildNode(0, static_cast<a_int>(wallfaces.size()), facecentres);
+	}
+
+	computeDistances(false);
+}
+
+template <typename scalar>
+void WallDistance<scalar>::update()
+{
+	// children are always stored after their parents
+	for(a_int inode = static_cast<a_int>(nodes.size())-1; inode >= 0; inode--)
+		fitNode(inode);
+
+	computeDistances(true);
+}
+
+template <typename scalar>
+a_int WallDistance<scalar>::buildNode(const a_int start, const a_int end,
+                                      std::vector<scalar>& fc)
+{
+	const a_int inode = static_cast<a_int>(nodes.size());
+	nodes.push_back(Node{{}, {}, -1, -1, start, end});
+
+	if(end - start > leaf_size)
+	{
+		// split along the longer side of the bounding box of the face centres
+		std::array<scalar,NDIM> clo, chi;
+		for(int j = 0; j < NDIM; j++) {
+			clo[j] = std::numeric_limits<scalar>::max();
+			chi[j] = std::numeric_limits<scalar>::lowest();
+		}
+		for(a_int i = start; i < end; i++)
+			for(int j = 0; j < NDIM; j++) {
+				clo[j] = std::min(clo[j], fc[wallfaces[i]*NDIM+j]);
+				chi[j] = std::max(chi[j], fc[wallfaces[i]*NDIM+j]);
+			}
+
+		int axis = 0;
+		for(int j = 1; j < NDIM; j++)
+			if(chi[j]-clo[j] > chi[axis]-clo[axis])
+				axis = j;
+
+		const a_int mid = start + (end-start)/2;
+		std::nth_element(wallfaces.begin()+start, wallfaces.begin()+mid, wallfaces.begin()+end,
+			[&fc,axis](const a_int a, const a_int b) {
+				return fc[a*NDIM+axis] < fc[b*NDIM+axis];
+			});
+
+		// the recursion may re-allocate the node array
+		const a_int left = buildNode(start, mid, fc);
+		const a_int right = buildNode(mid, end, fc);
+		nodes[inode].left = left;
+		nodes[inode].right = right;
+	}
+
+	fitNode(inode);
+	return inode;
+}
+
+template <typename scalar>
+void WallDistance<scalar>::fitNode(const a_int inode)
+{
+	Node& node = nodes[inode];
+	if(node.left >= 0)
+	{
+		const Node& l = nodes[node.left];
+		const Node& r = nodes[node.right];
+		for(int j = 0; j < NDIM; j++) {
+			node.lo[j] = std::min(l.lo[j], r.lo[j]);
+			node.hi[j] = std::max(l.hi[j], r.hi[j]);
+		}
+		return;
+	}
+
+	for(int j = 0; j < NDIM; j++) {
+		node.lo[j] = std::numeric_limits<scalar>::max();
+		node.hi[j] = std::numeric_limits<scalar>::lowest();
+	}
+	for(a_int i = node.start; i < node.end; i++)
+		for(int inofa = 2; inofa < 4; inofa++)
+			for(int j = 0; j < NDIM; j++) {
+				const scalar x = m->gcoords(m->gintfac(wallfaces[i],inofa),j);
+				node.lo[j] = std::min(node.lo[j], x);
+				node.hi[j] = std::max(node.hi[j], x);
+			}
+}
+
+template <typename scalar>
+scalar WallDistance<scalar>::squaredFaceDistance(const scalar point[NDIM], const a_int iface) const
+{
+	const a_int p1 = m->gintfac(iface,2), p2 = m->gintfac(iface,3);
+	scalar tang[NDIM], rel[NDIM];
+	scalar tlen2 = 0, proj = 0;
+	for(int j = 0; j < NDIM; j++) {
+		tang[j] = m->gcoords(p2,j) - m->gcoords(p1,j);
+		rel[j] = point[j] - m->gcoords(p1,j);
+		tlen2 += tang[j]*tang[j];
+		proj += tang[j]*rel[j];
+	}
+
+	// parameter of the point on the face nearest to the given point
+	const scalar t = tlen2 > 0 ? std::min(std::max(proj/tlen2, scalar(0)), scalar(1)) : 0;
+
+	scalar d2 = 0;
+	for(int j = 0; j < NDIM; j++)
+		d2 += (rel[j]-t*tang[j])*(rel[j]-t*tang[j]);
+	return d2;
+}
+
+template <typename scalar>
+scalar WallDistance<scalar>::squaredBoxDistance(const scalar point[NDIM], const a_int inode) const
+{
+	const Node& node = nodes[inode];
+	scalar d2 = 0;
+	for(int j = 0; j < NDIM; j++) {
+		const scalar d = std::max(std::max(node.lo[j]-point[j], point[j]-node.hi[j]), scalar(0));
+		d2 += d*d;
+	}
+	return d2;
+}
+
+template <typename scalar>
+a_int WallDistance<scalar>::findNearest(const scalar point[NDIM], const a_int hintface,
+                                        scalar& dist) const
+{
+	if(nodes.size() == 0) {
+		dist = std::numeric_limits<scalar>::max();
+		return -1;
+	}
+
+	a_int best = hintface;
+	scalar bestd2 = hintface >= 0 ? squaredFaceDistance(point, hintface)
+		: std::numeric_limits<scalar>::max();
+
+	a_int stack[max_stack_depth];
+	int top = 0;
+	stack[top++] = 0;
+
+	while(top > 0)
+	{
+		const a_int inode = stack[--top];
+		if(squaredBoxDistance(point, inode) >= bestd2 && best >= 0)
+			continue;
+
+		const Node& node = nodes[inode];
+		if(node.left < 0)
+		{
+			for(a_int i = node.start; i < node.end; i++) {
+				const scalar d2 = squaredFaceDistance(point, wallfaces[i]);
+				if(d2 < bestd2 || best < 0) {
+					bestd2 = d2;
+					best = wallfaces[i];
+				}
+			}
+			continue;
+		}
+
+		// push the farther child first so that the nearer one is searched first
+		const scalar dl = squaredBoxDistance(point, node.left);
+		const scalar dr = squaredBoxDistance(point, node.right);
+		if(dl <= dr) {
+			stack[top++] = node.right;
+			stack[top++] = node.left;
+		}
+		else {
+			stack[top++] = node.left;
+			stack[top++] = node.right;
+		}
+	}
+
+	dist = std::sqrt(bestd2);
+	return best;
+}
+
+template <typename scalar>
+void WallDistance<scalar>::computeDistances(const bool usehints)
+{
+	std::vector<scalar> centres(m->gnelem()*NDIM);
+	m->compute_cell_centres(centres);
+
+#pragma omp parallel for default(shared) schedule(dynamic,256)
+	for(a_int iel = 0; iel < m->gnelem(); iel++)
+		nearest[iel] = findNearest(&centres[iel*NDIM], usehints ? nearest[iel] : -1, dists[iel]);
+}
+
+template class WallDistance<a_real>;
+
+}
@@ -0,0 +1,124 @@
+/** \file walldistance.hpp
+ * \brief Distances of cell centres from the nearest wall using a bounding-volume tree
+ * \author Aditya Kashi
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FVENS_WALLDISTANCE_H
+#define FVENS_WALLDISTANCE_H
+
+#include <vector>
+#include <array>
+#include "amesh2dh.hpp"
+
+namespace fvens {
+
+/// Computes and stores the distance of each cell centre from the nearest wall face
+/** The wall faces are the boundary faces having one of a given list of boundary markers. They are
+ * organized in a binary tree of axis-aligned bounding boxes, built by recursively splitting the
+ * faces at the median of their centres along the longer side of the box, in O(n log n) time.
+ * A query for a point descends into the child whose box is nearer first and skips any box farther
+ * away than the nearest face found so far, which typically takes O(log n) time. The cells are
+ * queried in parallel.
+ *
+ * When the mesh nodes move without change of connectivity, \ref update refits the boxes of the
+ * existing tree in linear time and re-computes the distances. The distance to the nearest face
+ * from the previous computation is then used as the initial bound of each query, so that
+ * small motions need very few box tests. The tree stays correct under any motion, but after
+ * large motions it becomes less efficient than a new one; use \ref rebuild then.
+ *
+ * If there are no wall faces, all distances are the largest finite value of the scalar type.
+ * \warning Needs the boundary tags of faces, see UMesh2dh::compute_face_data.
+ */
+template <typename scalar>
+class WallDistance
+{
+public:
+	/// Builds the tree of wall faces and computes the wall distances
+	/** \param mesh The mesh, which must persist until this object is destroyed
+	 * \param wallmarkers Boundary markers of the faces to treat as walls
+	 */
+	WallDistance(const UMesh2dh<scalar> *const mesh, const std::vector<int>& wallmarkers);
+
+	/// Refits the tree to the current node coordinates of the mesh and re-computes distances
+	void update();
+
+	/// Re-builds the tree from the current node coordinates and re-computes distances
+	void rebuild();
+
+	/// Distance of the centre of a cell from the nearest wall
+	scalar distance(const a_int icell) const { return dists[icell]; }
+
+	/// Distances of all cell centres from the nearest wall
+	const std::vector<scalar>& distances() const { return dists; }
+
+	/// Index (in the mesh's face list) of the wall face nearest to a cell's centre
+	a_int nearestFace(const a_int icell) const { return nearest[icell]; }
+
+	/// Number of wall faces
+	a_int numWallFaces() const { return static_cast<a_int>(wallfaces.size()); }
+
+	/// Finds the wall face nearest to an arbitrary point
+	/** \param[in] point The point
+	 * \param[in] hintface A wall face whose distance is used as the initial bound of the search,
+	 *   or -1 if there is none
+	 * \param[out] dist Distance of the point from the wall
+	 * \return Index of the nearest wall face in the mesh's face list, or -1 if there are no walls
+	 */
+	a_int findNearest(const scalar point[NDIM], const a_int hintface, scalar& dist) const;
+
+protected:
+	/// A node of the tree; a leaf if it has no children
+	struct Node {
+		std::array<scalar,NDIM> lo;      ///< Lower corner of the bounding box
+		std::array<scalar,NDIM> hi;      ///< Upper corner of the bounding box
+		a_int left;                      ///< Index of the left child, or -1 for a leaf
+		a_int right;                     ///< Index of the right child, or -1 for a leaf
+		a_int start;                     ///< First position of the node's faces in wallfaces
+		a_int end;                       ///< One past the last position of the node's faces
+	};
+
+	const UMesh2dh<scalar> *const m;
+
+	/// Wall faces (indices in the mesh's face list) ordered such that each node's are contiguous
+	std::vector<a_int> wallfaces;
+	/// Nodes of the tree; the root is the first one
+	std::vector<Node> nodes;
+	/// Distance of each cell centre from the wall
+	std::vector<scalar> dists;
+	/// Nearest wall face of each cell
+	std::vector<a_int> nearest;
+
+	/// Recursively builds the sub-tree of the faces in a range of wallfaces
+	/** \return Index of the sub-tree's root node
+	 */
+	a_int buildNode(const a_int start, const a_int end, std::vector<scalar>& facecentres);
+
+	/// Computes the bounding box of a node from its children or faces
+	void fitNode(const a_int inode);
+
+	/// Square of the distance of a point from a face
+	scalar squaredFaceDistance(const scalar point[NDIM], const a_int iface) const;
+
+	/// Square of the distance of a point from the bounding box of a node; 0 if it is inside
+	scalar squaredBoxDistance(const scalar point[NDIM], const a_int inode) const;
+
+	/// Computes the distances of all cell centres
+	void computeDistances(const bool usehints);
+};
+
+}
+#endif
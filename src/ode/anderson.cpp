@@ -0,0 +1,161 @@
+/** @file anderson.cpp
+ * @brief Implementation of Anderson acceleration
+ * @author Aditya Kashi
+ */
+
+#include <iostream>
+#include <cmath>
+#include <Eigen/QR>
+
+#include "anderson.hpp"
+#include "utilities/aoptionparser.hpp"
+#include "utilities/aerrorhandling.hpp"
+
+namespace fvens {
+
+AndersonConfig parseAndersonConfig()
+{
+	AndersonConfig cfg;
+	cfg.depth = parsePetscCmd_isDefined("-anderson_depth") ?
+		parsePetscCmd_int("-anderson_depth") : 0;
+	cfg.mixing = parseOptionalPetscCmd_real("-anderson_mixing", 1.0);
+	cfg.restartfactor = parseOptionalPetscCmd_real("-anderson_restart_factor", 1.0);
+	cfg.implicit = parsePetscCmd_isDefined("-anderson_implicit");
+
+	fvens_throw(cfg.depth < 0, "Anderson acceleration depth must be non-negative!");
+	fvens_throw(cfg.mixing <= 0, "Anderson mixing parameter must be positive!");
+	return cfg;
+}
+
+AndersonAccelerator::AndersonAccelerator(const Vec x, const AndersonConfig& conf)
+	: config(conf), haveprev{false}, ncols{0}, newest{-1}, nrestarts{0}, prevfnorm{0},
+	  gram(conf.depth, conf.depth)
+{
+	fvens_throw(config.depth <= 0, "Anderson acceleration needs a positive depth!");
+
+	StatusCode ierr = VecGetLocalSize(x, &n);
+	petsc_throw(ierr, "Could not get vector size");
+	ierr = PetscObjectGetComm((PetscObject)x, &comm);
+	petsc_throw(ierr, "Could not get communicator");
+
+	df.resize(config.depth);
+	du.resize(config.depth);
+	for(int j = 0; j < config.depth; j++) {
+		ierr = VecDuplicate(x, &df[j]); petsc_throw(ierr, "Could not create history vector");
+		ierr = VecDuplicate(x, &du[j]); petsc_throw(ierr, "Could not create history vector");
+	}
+	ierr = VecDuplicate(x, &uprev); petsc_throw(ierr, "Could not create history vector");
+	ierr = VecDuplicate(x, &fprev); petsc_throw(ierr, "Could not create history vector");
+	gram.setZero();
+
+	std::cout << " AndersonAccelerator: Depth " << config.depth << ", mixing " << config.mixing
+	          << std::endl;
+}
+
+AndersonAccelerator::~AndersonAccelerator()
+{
+	int ierr = 0;
+	for(int j = 0; j < config.depth; j++) {
+		ierr += VecDestroy(&df[j]);
+		ierr += VecDestroy(&du[j]);
+	}
+	ierr += VecDestroy(&uprev);
+	ierr += VecDestroy(&fprev);
+	if(ierr)
+		std::cout << "! AndersonAccelerator: Could not destroy history vectors!\n";
+}
+
+void AndersonAccelerator::reset()
+{
+	haveprev = false;
+	ncols = 0;
+	newest = -1;
+}
+
+StatusCode AndersonAccelerator::update(a_real *const u, const a_real *const f)
+{
+	StatusCode ierr = 0;
+	const int m = config.depth;
+	const a_real beta = config.mixing;
+
+	// the slot of the new column, and the number of columns once it is added
+	const int slot = haveprev ? (newest+1) % m : -1;
+	const int nc = haveprev ? std::min(ncols+1, m) : 0;
+
+	std::vector<a_real*> dfa(m), dua(m);
+	for(int j = 0; j < m; j++) {
+		ierr = VecGetArray(df[j], &dfa[j]); CHKERRQ(ierr);
+		ierr = VecGetArray(du[j], &dua[j]); CHKERRQ(ierr);
+	}
+	a_real *upa, *fpa;
+	ierr = VecGetArray(uprev, &upa); CHKERRQ(ierr);
+	ierr = VecGetArray(fprev, &fpa); CHKERRQ(ierr);
+
+	/* Form the new column and compute, in the same pass, its inner products with all columns,
+	 * those of f with all columns, and the norm of f.
+	 */
+	std::vector<a_real> sums(2*m+1, 0);
+	a_real *const s = &sums[0];
+#pragma omp parallel for default(shared) reduction(+:s[:2*m+1])
+	for(PetscInt i = 0; i < n; i++)
+	{
+		if(slot >= 0) {
+			const a_real dfi = f[i]-fpa[i];
+			dfa[slot][i] = dfi;
+			dua[slot][i] = u[i]-upa[i] + beta*dfi;
+			for(int j = 0; j < nc; j++) {
+				s[j] += dfi*dfa[j][i];
+				s[m+j] += f[i]*dfa[j][i];
+			}
+		}
+		s[2*m] += f[i]*f[i];
+	}
+
+	ierr = MPI_Allreduce(MPI_IN_PLACE, s, 2*m+1, MPIU_REAL, MPI_SUM, comm); CHKERRQ(ierr);
+	const a_real fnorm = std::sqrt(s[2*m]);
+
+	if(haveprev && fnorm > config.restartfactor*prevfnorm) {
+		reset();
+		nrestarts++;
+	}
+	else if(haveprev) {
+		newest = slot;
+		ncols = nc;
+		for(int j = 0; j < nc; j++) {
+			gram(slot,j) = s[j];
+			gram(j,slot) = s[j];
+		}
+	}
+	prevfnorm = fnorm;
+
+	// coefficients of the least-squares combination of the history
+	Matrix<a_real,Dynamic,1> gamma = Matrix<a_real,Dynamic,1>::Zero(m);
+	if(ncols > 0) {
+		const Matrix<a_real,Dynamic,1> rhs = Eigen::Map<const Matrix<a_real,Dynamic,1>>(s+m, ncols);
+		gamma.head(ncols) = gram.topLeftCorner(ncols,ncols).colPivHouseholderQr().solve(rhs);
+	}
+
+	// save the current iterate and update, and form the next iterate
+	const int ncl = ncols;
+#pragma omp parallel for default(shared)
+	for(PetscInt i = 0; i < n; i++)
+	{
+		upa[i] = u[i];
+		fpa[i] = f[i];
+		a_real corr = 0;
+		for(int j = 0; j < ncl; j++)
+			corr += gamma[j]*dua[j][i];
+		u[i] += beta*f[i] - corr;
+	}
+	haveprev = true;
+
+	ierr = VecRestoreArray(fprev, &fpa); CHKERRQ(ierr);
+	ierr = VecRestoreArray(uprev, &upa); CHKERRQ(ierr);
+	for(int j = 0; j < m; j++) {
+		ierr = VecRestoreArray(du[j], &dua[j]); CHKERRQ(ierr);
+		ierr = VecRestoreArray(df[j], &dfa[j]); CHKERRQ(ierr);
+	}
+	return ierr;
+}
+
+}
@@ -0,0 +1,111 @@
+/** @file anderson.hpp
+ * @brief Anderson acceleration of fixed-point iterations
+ * @author Aditya Kashi
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FVENS_ANDERSON_H
+#define FVENS_ANDERSON_H
+
+#include <vector>
+#include <petscvec.h>
+
+#include "aconstants.hpp"
+
+namespace fvens {
+
+/// Settings of Anderson acceleration
+struct AndersonConfig
+{
+	int depth;                 ///< Number of previous iterations used; 0 means no acceleration
+	a_real mixing;             ///< Fraction of the fixed-point update applied (relaxation)
+	/// The history is discarded when the norm of the fixed-point update grows by more than this
+	a_real restartfactor;
+	bool implicit;             ///< Whether the implicit pseudo-time iteration is also accelerated
+};
+
+/// Reads the Anderson acceleration settings from the PETSc options database
+/** The options are
+ *  - `-anderson_depth` (default 0, ie., no acceleration)
+ *  - `-anderson_mixing` (default 1)
+ *  - `-anderson_restart_factor` (default 1, ie., whenever the update grows)
+ *  - `-anderson_implicit` (flag; by default, only explicit pseudo-time stepping is accelerated)
+ */
+AndersonConfig parseAndersonConfig();
+
+/// Anderson acceleration (also known as Anderson mixing, or DIIS) of a fixed-point iteration
+/** For a fixed-point iteration \f$ u_{k+1} = u_k + f(u_k) \f$, the accelerated iterate is
+ * \f[ u_{k+1} = u_k + \beta f_k - \sum_{j} \gamma_j (\Delta u_j + \beta \Delta f_j) \f]
+ * where \f$ \Delta u_j, \Delta f_j \f$ are differences between successive iterates and updates
+ * over the last m iterations and \f$ \gamma \f$ minimizes \f$ \|f_k - \sum_j \gamma_j \Delta f_j\|
+ * \f$. The 2m difference vectors are kept in a ring buffer of Vecs, along with the Gram matrix of
+ * the \f$ \Delta f_j \f$, so that each iteration needs one threaded pass over the history to
+ * compute the new inner products and one to form the new iterate; the small least-squares
+ * problem is solved redundantly on every rank.
+ */
+class AndersonAccelerator
+{
+public:
+	/// Allocates the history
+	/** \param x A vector with the layout of the iterates
+	 * \param config Settings; the depth must be positive
+	 */
+	AndersonAccelerator(const Vec x, const AndersonConfig& config);
+
+	~AndersonAccelerator();
+
+	/// Computes the next iterate
+	/** \param[in,out] u The current iterate on input, the next iterate on output
+	 * \param[in] f The fixed-point update at the current iterate, such that the unaccelerated
+	 *   next iterate is u + f
+	 */
+	StatusCode update(a_real *const u, const a_real *const f);
+
+	/// Discards the history, so that the next update is a plain relaxed fixed-point update
+	void reset();
+
+	/// Number of previous iterations currently in use
+	int historySize() const { return ncols; }
+
+	/// Number of times the history was discarded because the update grew
+	int numRestarts() const { return nrestarts; }
+
+protected:
+	const AndersonConfig config;
+
+	/// Local length of the iterates
+	PetscInt n;
+	MPI_Comm comm;
+
+	/// Differences between successive fixed-point updates
+	std::vector<Vec> df;
+	/// Differences between successive iterates plus mixing times the update differences
+	std::vector<Vec> du;
+	/// The previous iterate and update
+	Vec uprev, fprev;
+	bool haveprev;
+
+	int ncols;                 ///< Number of valid columns of the history
+	int newest;                ///< Slot of the newest column of the ring buffer
+	int nrestarts;
+	a_real prevfnorm;          ///< Norm of the previous update
+
+	/// Inner products of the columns of df with each other
+	Matrix<a_real,Dynamic,Dynamic> gram;
+};
+
+}
+#endif
@@ -19,6 +19,7 @@
  */
 
 #include <algorithm>
+#include <limits>
 #include <iostream>
 #include <iomanip>
 #include <fstream>
@@ -36,6 +37,7 @@
 #include "linalg/alinalg.hpp"
 #include "utilities/aoptionparser.hpp"
 #include "utilities/aerrorhandling.hpp"
+#include "utilities/perfcounters.hpp"
 
 namespace fvens {
 
@@ -64,12 +66,76 @@ static Matrix<a_real,Dynamic,Dynamic> initialize_TVDRK_Coeffs(const int _order)
 	return tvdrk;
 }
 
+/// Computes the area-weighted L2 norm of each component of the residual
+template <int nvars>
+static void residualComponentNorms(const UMesh2dh<a_real> *const m, const a_real *const r,
+                                   double *const norms)
+{
+	for(int i = 0; i < nvars; i++)
+		norms[i] = 0;
+
+#pragma omp parallel default(shared)
+	{
+		double locnorms[nvars];
+		for(int i = 0; i < nvars; i++)
+			locnorms[i] = 0;
+
+#pragma omp for
+		for(a_int iel = 0; iel < m->gnelem(); iel++)
+			for(int i = 0; i < nvars; i++)
+				locnorms[i] += r[iel*nvars+i]*r[iel*nvars+i]*m->garea(iel);
+
+#pragma omp critical
+		for(int i = 0; i < nvars; i++)
+			norms[i] += locnorms[i];
+	}
+
+	for(int i = 0; i < nvars; i++)
+		norms[i] = std::sqrt(norms[i]);
+}
+
+/// Computes the area-weighted L2 norm of the last component of the residual, used for convergence
+template <int nvars>
+static a_real convergenceResidualNorm(const UMesh2dh<a_real> *const m, const a_real *const r)
+{
+	a_real resnorm2 = 0;
+#pragma omp parallel for default(shared) reduction(+:resnorm2)
+	for(a_int iel = 0; iel < m->gnelem(); iel++)
+		resnorm2 += r[iel*nvars+nvars-1]*r[iel*nvars+nvars-1]*m->garea(iel);
+	return std::sqrt(resnorm2);
+}
+
+/// Replaces a pseudo-time residual which re-used parts of earlier ones by the full residual
+/** The full residual is computed without time steps, so dtm is left as it is.
+ * \param[in] uvec The state at which the residual in rvec was computed
+ * \param[in,out] rvec The residual, whose array rarr the caller may hold
+ */
+template <int nvars>
+static StatusCode recomputeFullResidual(const Spatial<a_real,nvars> *const space, const Vec uvec,
+                                        Vec rvec, a_real *const rarr, std::vector<a_real>& dtm)
+{
+	const UMesh2dh<a_real> *const m = space->mesh();
+#pragma omp parallel for simd default(shared)
+	for(a_int i = 0; i < m->gnelem()*nvars; i++)
+		rarr[i] = 0;
+	return space->assemble_residual(uvec, rvec, false, dtm);
+}
+
 template <int nvars>
 SteadySolver<nvars>::SteadySolver(const Spatial<a_real,nvars> *const spatial, const SteadySolverConfig& conf)
 	: space{spatial}, config{conf}, 
-	  tdata{spatial->mesh()->gnelem(), 1, 0.0, 0.0, 0.0, 0.0, 0, 0, 0, false}
+	  tdata{spatial->mesh()->gnelem(), 1, 0.0, 0.0, 0.0, 0.0, 0, 0, 0, false},
+	  andconf(parseAndersonConfig()), accel{nullptr},
+	  history{conf.lognres ? createHistoryLog(conf.logfile, nvars) : nullptr}
 { }
 
+template <int nvars>
+SteadySolver<nvars>::~SteadySolver()
+{
+	delete accel;
+	delete history;
+}
+
 template <int nvars>
 TimingData SteadySolver<nvars>::getTimingData() const {
 	return tdata;
@@ -91,6 +157,12 @@ SteadyForwardEulerSolver<nvars>::SteadyForwardEulerSolver(const Spatial<a_real,n
 		std::cout << "! SteadyForwardEulerSolver: Could not create residual vector!\n";
 		std::abort();
 	}
+
+	if(andconf.depth > 0) {
+		accel = new AndersonAccelerator(uvec, andconf);
+		ierr = VecDuplicate(uvec, &fvec);
+		petsc_throw(ierr, "Could not create update vector");
+	}
 }
 
 template<int nvars>
@@ -99,6 +171,11 @@ SteadyForwardEulerSolver<nvars>::~SteadyForwardEulerSolver()
 	int ierr = VecDestroy(&rvec);
 	if(ierr)
 		std::cout << "! SteadyForwardEulerSolver: Could not destroy residual vector!\n";
+	if(accel) {
+		ierr = VecDestroy(&fvec);
+		if(ierr)
+			std::cout << "! SteadyForwardEulerSolver: Could not destroy update vector!\n";
+	}
 }
 
 template<int nvars>
@@ -142,35 +219,94 @@ StatusCode SteadyForwardEulerSolver<nvars>::solve(Vec uvec)
 
 	std::cout << " Constant CFL = " << config.cflinit << std::endl;
 
-	while(resi/initres > config.tol && step < config.maxiter)
-	{
+	const bool ptprec = space->hasPseudoTimePreconditioner();
+
+	// number of full residuals computed to confirm convergence
+	int nfullres = 0;
+
 #pragma omp parallel for simd default(shared)
-		for(a_int i = 0; i < m->gnelem()*nvars; i++) {
-			rarr[i] = 0;
-		}
+	for(a_int i = 0; i < m->gnelem()*nvars; i++) {
+		rarr[i] = 0;
+	}
+
+	space->reset_pseudotime_residual();
 
+	while(resi/initres > config.tol && step < config.maxiter)
+	{
 		// update residual
-		space->assemble_residual(uvec, rvec, true, dtm);
+		beginPerfStage(PERFSTAGE_RESIDUAL);
+		space->assemble_pseudotime_residual(uvec, rvec, true, dtm);
+
+		// Convergence is only declared on the full residual. The update then uses it as well.
+		if(step > 0 && !space->last_pseudotime_residual_exact()
+		   && convergenceResidualNorm<nvars>(m, rarr) <= config.tol*initres)
+		{
+			ierr = recomputeFullResidual(space, uvec, rvec, rarr, dtm); CHKERRQ(ierr);
+			nfullres++;
+		}
+		endPerfStage(PERFSTAGE_RESIDUAL);
 
 		a_real errmass = 0;
 
-#pragma omp parallel default(shared)
+		HistoryRecord hrec;
+		if(history) {
+			hrec = emptyHistoryRecord();
+			residualComponentNorms<nvars>(m, rarr, hrec.residual);
+			// u is still the state at which the residual was computed
+			space->computeWallForces(uarr, hrec.forces);
+		}
+
+		if(accel)
 		{
-#pragma omp for
+			// Compute the fixed-point update and the residual norm, and zero the residual
+			a_real *farr;
+			ierr = VecGetArray(fvec, &farr); CHKERRQ(ierr);
+#pragma omp parallel for default(shared) reduction(+:errmass)
 			for(a_int iel = 0; iel < m->gnelem(); iel++)
 			{
+				if(ptprec)
+					space->applyPseudoTimePreconditioner(&u(iel,0), false, &residual(iel,0),
+					                                     &farr[iel*nvars]);
+				else
+					for(int i = 0; i < nvars; i++)
+						farr[iel*nvars+i] = residual(iel,i);
+
 				for(int i = 0; i < nvars; i++)
-				{
-					u(iel,i) += config.cflinit*dtm[iel] * 1.0/m->garea(iel)*residual(iel,i);
-				}
-			}
+					farr[iel*nvars+i] *= config.cflinit*dtm[iel] * 1.0/m->garea(iel);
 
-#pragma omp for simd reduction(+:errmass)
+				errmass += residual(iel,nvars-1)*residual(iel,nvars-1)*m->garea(iel);
+
+				for(int i = 0; i < nvars; i++)
+					residual(iel,i) = 0;
+			}
+			ierr = accel->update(uarr, farr); CHKERRQ(ierr);
+			ierr = VecRestoreArray(fvec, &farr); CHKERRQ(ierr);
+		}
+		else
+		{
+			// Update the solution, compute the residual norm and zero the residual for the next
+			//  step, all in one pass
+#pragma omp parallel for default(shared) reduction(+:errmass)
 			for(a_int iel = 0; iel < m->gnelem(); iel++)
 			{
+				a_real upd[nvars];
+				if(ptprec)
+					space->applyPseudoTimePreconditioner(&u(iel,0), false, &residual(iel,0), upd);
+				else
+					for(int i = 0; i < nvars; i++)
+						upd[i] = residual(iel,i);
+
+				for(int i = 0; i < nvars; i++)
+				{
+					u(iel,i) += config.cflinit*dtm[iel] * 1.0/m->garea(iel)*upd[i];
+				}
+
 				errmass += residual(iel,nvars-1)*residual(iel,nvars-1)*m->garea(iel);
+
+				for(int i = 0; i < nvars; i++)
+					residual(iel,i) = 0;
 			}
-		} // end parallel region
+		}
 
 		resi = sqrt(errmass);
 
@@ -186,6 +322,17 @@ StatusCode SteadyForwardEulerSolver<nvars>::solve(Vec uvec)
 		if(mpirank==0)
 			if(config.lognres)
 				convout << step << " " << std::setw(10) << resi/initres << '\n';
+		if(history) {
+			struct timeval curtime;
+			gettimeofday(&curtime, NULL);
+			hrec.step = step;
+			hrec.wall_time = (double)curtime.tv_sec + (double)curtime.tv_usec * 1.0e-6
+				- initialwtime;
+			hrec.cfl = config.cflinit;
+			hrec.rel_residual = resi/initres;
+			hrec.abs_residual = resi;
+			history->append(hrec);
+		}
 
 		// test for nan
 		if(!std::isfinite(resi))
@@ -201,6 +348,9 @@ StatusCode SteadyForwardEulerSolver<nvars>::solve(Vec uvec)
 	double finalctime = (double)clock() / (double)CLOCKS_PER_SEC;
 	tdata.ode_walltime += (finalwtime-initialwtime); tdata.ode_cputime += (finalctime-initialctime);
 
+	tdata.final_rel_residual = resi/initres;
+	tdata.num_timesteps = step;
+	tdata.num_res_evals = step + nfullres;
 	tdata.converged = true;
 	if(step == config.maxiter) {
 		tdata.converged = false;
@@ -209,6 +359,9 @@ StatusCode SteadyForwardEulerSolver<nvars>::solve(Vec uvec)
 	}
 	if(mpirank == 0) {
 		std::cout << " SteadyForwardEulerSolver: solve(): Done, steps = " << step << "\n\n";
+		if(accel)
+			std::cout << " SteadyForwardEulerSolver: solve(): Anderson acceleration restarts = "
+			          << accel->numRestarts() << "\n";
 		std::cout << " SteadyForwardEulerSolver: solve(): Time taken by ODE solver:\n";
 		std::cout << "                                   Wall time = " << tdata.ode_walltime 
 			<< ", CPU time = " << tdata.ode_cputime << std::endl << std::endl;
@@ -232,7 +385,12 @@ SteadyBackwardEulerSolver(const Spatial<a_real,nvars> *const spatial,
                           const SteadySolverConfig& conf,	
                           KSP ksp)
 
-	: SteadySolver<nvars>(spatial, conf), solver{ksp}
+	: SteadySolver<nvars>(spatial, conf), solver{ksp},
+	  nlsconf(parseNonlinearSchwarzConfig()), nlschwarz{nullptr},
+	  contconf(parseContinuationConfig()),
+	  continuation{createContinuation(conf.cflinit, conf.cflfin, conf.rampstart, conf.rampend,
+	                                  contconf)},
+	  ubackup{NULL}
 {
 	const UMesh2dh<a_real> *const m = space->mesh();
 	dtm.resize(m->gnelem(), 0);
@@ -241,12 +399,31 @@ SteadyBackwardEulerSolver(const Spatial<a_real,nvars> *const spatial,
 	ierr = MatCreateVecs(M, &duvec, &rvec);
 	if(ierr)
 		throw "! SteadyBackwardEulerSolver: Could not create residual or update vector!";
+
+	if(andconf.depth > 0 && andconf.implicit)
+		accel = new AndersonAccelerator(duvec, andconf);
+
+	if(nlsconf.type != NLSCHWARZ_NONE)
+		nlschwarz = new NonlinearSchwarz<nvars>(spatial, duvec, nlsconf);
+
+	if(contconf.maxrejections > 0) {
+		ierr = VecDuplicate(duvec, &ubackup);
+		petsc_throw(ierr, "Could not create backup state vector");
+	}
 }
 
 template <int nvars>
 SteadyBackwardEulerSolver<nvars>::~SteadyBackwardEulerSolver()
 {
-	int ierr = VecDestroy(&rvec);
+	delete nlschwarz;
+	delete continuation;
+	int ierr = 0;
+	if(ubackup) {
+		ierr = VecDestroy(&ubackup);
+		if(ierr)
+			std::cout << "! SteadyBackwardEulerSolver: Could not destroy backup state vector!\n";
+	}
+	ierr = VecDestroy(&rvec);
 	if(ierr)
 		std::cout << "! SteadyBackwardEulerSolver: Could not destroy residual vector!\n";
 	ierr = VecDestroy(&duvec);
@@ -254,41 +431,6 @@ SteadyBackwardEulerSolver<nvars>::~SteadyBackwardEulerSolver()
 		std::cout << "! SteadyBackwardEulerSolver: Could not destroy update vector!\n";
 }
 	
-template <int nvars>
-a_real SteadyBackwardEulerSolver<nvars>::linearRamp(const a_real cstart, const a_real cend, 
-		const int itstart, const int itend, const int itcur) const
-{
-	a_real curCFL;
-	if(itcur < itstart) {
-		curCFL = cstart;
-	}
-	else if(itcur < itend) {
-		if(itend-itstart <= 0) {
-			curCFL = cend;
-		}
-		else {
-			const a_real slopec = (cend-cstart)/(itend-itstart);
-			curCFL = cstart + slopec*(itcur-itstart);
-		}
-	}
-	else {
-		curCFL = cend;
-	}
-	return curCFL;
-}
-
-template <int nvars>
-a_real SteadyBackwardEulerSolver<nvars>::expResidualRamp(const a_real cflmin, const a_real cflmax, 
-		const a_real prevcfl, const a_real resratio, const a_real paramup, const a_real paramdown)
-{
-	const a_real newcfl = resratio > 1.0 ? prevcfl * std::pow(resratio, paramup)
-	                                     : prevcfl * std::pow(resratio, paramdown);
-
-	if(newcfl < cflmin) return cflmin;
-	else if(newcfl > cflmax) return cflmax;
-	else return newcfl;
-}
-
 template <int nvars>
 StatusCode SteadyBackwardEulerSolver<nvars>::solve(Vec uvec)
 {
@@ -308,10 +450,12 @@ StatusCode SteadyBackwardEulerSolver<nvars>::solve(Vec uvec)
 
 	bool ismatrixfree = isMatrixFree(A);
 	MatrixFreeSpatialJacobian<nvars>* mfA = nullptr;
+	int initmfapplies = 0;
 	if(ismatrixfree) {
 		ierr = MatShellGetContext(A, (void**)&mfA); CHKERRQ(ierr);
 		// uvec, rvec and dtm keep getting updated, but pointers to them can be set just once
 		mfA->set_state(uvec,rvec,&dtm);
+		initmfapplies = mfA->getNumApplications();
 	}
 
 	// get list of iterations at which to recompute AMG interpolation operators, if used
@@ -319,10 +463,30 @@ StatusCode SteadyBackwardEulerSolver<nvars>::solve(Vec uvec)
 
 	bool tocomputeamginterpolation = false;
 
+	/* The matrix was not last updated by this solve - it may be new, or have been assembled by
+	 * compute_jacobian during set up, or by an earlier solve - so the first update must be full.
+	 */
+	space->reset_jacobian_updates();
+	space->reset_pseudotime_residual();
+
+	// pseudo-time terms currently in the Jacobian, for incremental Jacobian updates
+	std::vector<a_real> prevdiag(m->gnelem(), 0);
+	// with a preconditioned pseudo-time derivative, the pseudo-time terms are full blocks
+	const bool ptprec = space->hasPseudoTimePreconditioner();
+	std::vector<a_real> prevdiagblocks(ptprec ? m->gnelem()*nvars*nvars : 0, 0);
+	// Re-use of the preconditioner is opt-in; whether it pays off depends on the case
+	const a_real reusepcfraction = parseOptionalPetscCmd_real("-jacobian_reuse_pc_fraction", 0.0);
+
 	a_real curCFL=0;
 	int step = 0;
-	a_real resi = 1.0, resiold = 1.0;
+	a_real resi = 1.0, resiold = 1.0, resioldprev = 1.0;
 	a_real initres = 1.0;
+	// consecutive and total rejected steps
+	int nrejected = 0, totalrejected = 0;
+	// number of full residuals computed to confirm rejections or convergence
+	int nfullres = 0;
+	// whether the current step is the retry of a rejected one, starting from an accepted state
+	bool retrying = false;
 
 	/* Our usage of Eigen Maps in the manner below assumes that VecGetArray returns a pointer to
 	 * the primary underlying storage in PETSc Vec. This usually happens, but not for
@@ -342,6 +506,23 @@ StatusCode SteadyBackwardEulerSolver<nvars>::solve(Vec uvec)
 	if(config.lognres)
 		if(mpirank == 0)
 			convout.open(config.logfile+".conv", std::ofstream::app);
+
+	/* A step can only be rejected once the residual at its result is computed, at the beginning of
+	 * the next step. So the log entries of a step are kept until then, and dropped if it is
+	 * rejected.
+	 */
+	HistoryRecord hrec = emptyHistoryRecord();
+	bool haspending = false;
+	const auto writePendingStep = [&]() {
+		if(!haspending)
+			return;
+		if(config.lognres)
+			if(mpirank == 0)
+				convout << hrec.step << " " << std::setw(10) << hrec.rel_residual << '\n';
+		if(history)
+			history->append(hrec);
+		haspending = false;
+	};
 	
 	/*struct timeval time1, time2;
 	gettimeofday(&time1, NULL);
@@ -351,17 +532,17 @@ StatusCode SteadyBackwardEulerSolver<nvars>::solve(Vec uvec)
 	PetscTime(&initialwtime);
 	
 	double linwtime = 0, linctime = 0;
-		
-	while(resi/initres > config.tol && step < config.maxiter)
-	{
+
 #pragma omp parallel for default(shared)
-		for(a_int iel = 0; iel < m->gnelem(); iel++) {
+	for(a_int iel = 0; iel < m->gnelem(); iel++) {
 #pragma omp simd
-			for(int i = 0; i < nvars; i++) {
-				residual(iel,i) = 0;
-			}
+		for(int i = 0; i < nvars; i++) {
+			residual(iel,i) = 0;
 		}
-
+	}
+		
+	while(resi/initres > config.tol && step < config.maxiter)
+	{
 		std::vector<int>::iterator it = std::find(amgrecompute.begin(), amgrecompute.end(), step+1);
 		if(it != amgrecompute.end()) {
 			if(mpirank == 0) {
@@ -383,18 +564,96 @@ StatusCode SteadyBackwardEulerSolver<nvars>::solve(Vec uvec)
 		}
 		
 		// update residual and local time steps
-		ierr = space->assemble_residual(uvec, rvec, true, dtm); CHKERRQ(ierr);
+		beginPerfStage(PERFSTAGE_RESIDUAL);
+		// The matrix-free Jacobian differences the residual, and nonlinear Schwarz combines it with
+		//  exact local residuals, so in those cases the residual must be exact.
+		const bool needexactres = ismatrixfree || nlschwarz;
+		if(needexactres) {
+			ierr = space->assemble_residual(uvec, rvec, true, dtm); CHKERRQ(ierr);
+		} else {
+			ierr = space->assemble_pseudotime_residual(uvec, rvec, true, dtm); CHKERRQ(ierr);
+		}
+		endPerfStage(PERFSTAGE_RESIDUAL);
+		bool exactres = needexactres || space->last_pseudotime_residual_exact();
 
-		ierr = MatZeroEntries(M); CHKERRQ(ierr);
-		ierr = space->compute_jacobian(uvec, M); CHKERRQ(ierr);
+		// If the last step led to a diverged residual, go back to its starting state and retry it
+		//  with a smaller CFL number.
+		if(ubackup)
+		{
+			a_real resnorm = convergenceResidualNorm<nvars>(m, rarr);
+
+			// a step is only rejected on the full residual
+			if(step > 0 && !retrying && !exactres && continuation->toReject(resnorm, resi))
+			{
+				ierr = recomputeFullResidual(space, uvec, rvec, rarr, dtm); CHKERRQ(ierr);
+				nfullres++;
+				exactres = true;
+				resnorm = convergenceResidualNorm<nvars>(m, rarr);
+			}
+
+			if(step > 0 && !retrying && continuation->toReject(resnorm, resi))
+			{
+				nrejected++;
+				if(nrejected > contconf.maxrejections) {
+					ierr = VecRestoreArray(duvec, &duarr); CHKERRQ(ierr);
+					ierr = VecRestoreArray(rvec, &rarr); CHKERRQ(ierr);
+					ierr = VecRestoreArray(uvec, &uarr); CHKERRQ(ierr);
+					throw Numerical_error("Steady backward Euler diverged - too many rejected steps!");
+				}
+
+				const PetscScalar *ubarr;
+				ierr = VecGetArrayRead(ubackup, &ubarr); CHKERRQ(ierr);
+#pragma omp parallel for default(shared)
+				for(a_int iel = 0; iel < m->gnelem(); iel++)
+					for(int i = 0; i < nvars; i++) {
+						u(iel,i) = ubarr[iel*nvars+i];
+						residual(iel,i) = 0;
+					}
+				ierr = VecRestoreArrayRead(ubackup, &ubarr); CHKERRQ(ierr);
+
+				if(accel)
+					accel->reset();
+				continuation->reject();
+				totalrejected++;
+				if(mpirank == 0)
+					std::cout << "  SteadyBackwardEulerSolver: solve(): Step " << step
+					          << " rejected, residual " << resnorm << "; retrying.\n";
+
+				// the retried step takes the place of the rejected one
+				step--;
+				resi = resiold;
+				resiold = resioldprev;
+				if(step == 0)
+					initres = resi = 1.0;
+				haspending = false;
+				retrying = true;
+				continue;
+			}
+
+			if(!retrying)
+				nrejected = 0;
+			retrying = false;
+			ierr = VecCopy(uvec, ubackup); CHKERRQ(ierr);
+		}
+
+		writePendingStep();
+
+		beginPerfStage(PERFSTAGE_JACOBIAN);
+		JacobianUpdateInfo jacinfo;
+		ierr = space->update_jacobian(uvec, M, jacinfo); CHKERRQ(ierr);
+		endPerfStage(PERFSTAGE_JACOBIAN);
+
+		// Keep the old preconditioner if only a small part of the Jacobian has changed
+		ierr = KSPSetReusePreconditioner(solver,
+				!jacinfo.full && jacinfo.fraction < reusepcfraction ? PETSC_TRUE : PETSC_FALSE);
+		CHKERRQ(ierr);
 		
-		//curCFL = linearRamp(config.cflinit, config.cflfin, config.rampstart, config.rampend, step);
-		//(void)resiold;
-		curCFL = expResidualRamp(config.cflinit, config.cflfin, curCFL, resiold/resi, 0.25, 0.3);
+		curCFL = continuation->nextCFL(step, resiold, resi, initres);
 
 		// add pseudo-time terms to diagonal blocks; also, after the following loop,
 		// dtm is the diagonal vector of the mass matrix but having only one entry for each cell.
 
+		// If the Jacobian was updated incrementally, it still contains the previous pseudo-time terms.
 #pragma omp parallel for default(shared)
 		for(a_int iel = 0; iel < m->gnelem(); iel++)
 		{
@@ -403,8 +662,24 @@ StatusCode SteadyBackwardEulerSolver<nvars>::solve(Vec uvec)
 			Matrix<a_real,nvars,nvars,RowMajor> db 
 				= Matrix<a_real,nvars,nvars,RowMajor>::Zero();
 
-			for(int i = 0; i < nvars; i++)
-				db(i,i) = dtm[iel];
+			if(ptprec)
+			{
+				space->getPseudoTimePreconditioner(&u(iel,0), true, db.data());
+				db *= dtm[iel];
+				Eigen::Map<Matrix<a_real,nvars,nvars,RowMajor>>
+					prevblock(&prevdiagblocks[iel*nvars*nvars]);
+				const Matrix<a_real,nvars,nvars,RowMajor> newblock = db;
+				if(!jacinfo.full)
+					db -= prevblock;
+				prevblock = newblock;
+			}
+			else
+			{
+				const a_real diagterm = jacinfo.full ? dtm[iel] : dtm[iel] - prevdiag[iel];
+				prevdiag[iel] = dtm[iel];
+				for(int i = 0; i < nvars; i++)
+					db(i,i) = diagterm;
+			}
 	
 #pragma omp critical
 			{
@@ -418,38 +693,64 @@ StatusCode SteadyBackwardEulerSolver<nvars>::solve(Vec uvec)
 		/// Freezes the non-zero structure for efficiency in subsequent time steps.
 		ierr = MatSetOption(M, MAT_NEW_NONZERO_LOCATIONS, PETSC_FALSE); CHKERRQ(ierr);
 
-		// setup and solve linear system for the update du
+		// setup and solve linear system for the update du, or the local nonlinear problems
 	
 		PetscLogDouble thislinwtime;
 		PetscTime(&thislinwtime);
 		double thislinctime = (double)clock() / (double)CLOCKS_PER_SEC;
 
-		ierr = KSPSolve(solver, rvec, duvec); CHKERRQ(ierr);
+		int linstepsneeded;
+		beginPerfStage(PERFSTAGE_LINSOLVE);
+		if(nlschwarz) {
+			ierr = nlschwarz->setup(M); CHKERRQ(ierr);
+			ierr = nlschwarz->computeUpdate(A, solver, uvec, rvec, dtm, duvec, &linstepsneeded);
+			CHKERRQ(ierr);
+		}
+		else {
+			ierr = KSPSolve(solver, rvec, duvec); CHKERRQ(ierr);
+			ierr = KSPGetIterationNumber(solver, &linstepsneeded); CHKERRQ(ierr);
+		}
+		endPerfStage(PERFSTAGE_LINSOLVE);
 
 		PetscLogDouble thisfinwtime; PetscTime(&thisfinwtime);
 		double thisfinctime = (double)clock() / (double)CLOCKS_PER_SEC;
 		linwtime += (thisfinwtime-thislinwtime); 
 		linctime += (thisfinctime-thislinctime);
 
-		int linstepsneeded;
-		ierr = KSPGetIterationNumber(solver, &linstepsneeded); CHKERRQ(ierr);
 		tdata.total_lin_iters += linstepsneeded;
+
+		// Convergence is only declared on the full residual at the state the step started from.
+		if(step > 0 && !exactres && convergenceResidualNorm<nvars>(m, rarr) <= config.tol*initres)
+		{
+			ierr = recomputeFullResidual(space, uvec, rvec, rarr, dtm); CHKERRQ(ierr);
+			nfullres++;
+		}
 		
+		if(history) {
+			hrec = emptyHistoryRecord();
+			residualComponentNorms<nvars>(m, rarr, hrec.residual);
+			// u is still the state at which the residual was computed
+			space->computeWallForces(uarr, hrec.forces);
+		}
+
 		a_real resnorm2 = 0;
 
-#pragma omp parallel default(shared)
+		// Update the solution, compute the residual norm and zero the residual for the next step,
+		//  all in one pass. With acceleration, du is instead the fixed-point update given to the
+		//  accelerator.
+#pragma omp parallel for default(shared) reduction(+:resnorm2)
+		for(a_int iel = 0; iel < m->gnelem(); iel++)
 		{
-#pragma omp for
-			for(a_int iel = 0; iel < m->gnelem(); iel++) {
+			if(!accel)
 				u.row(iel) += du.row(iel);
-			}
-#pragma omp for simd reduction(+:resnorm2)
-			for(a_int iel = 0; iel < m->gnelem(); iel++)
-			{
-				resnorm2 += residual(iel,nvars-1)*residual(iel,nvars-1)*m->garea(iel);
-			}
+			resnorm2 += residual(iel,nvars-1)*residual(iel,nvars-1)*m->garea(iel);
+			residual.row(iel).setZero();
+		}
+		if(accel) {
+			ierr = accel->update(uarr, duarr); CHKERRQ(ierr);
 		}
 
+		resioldprev = resiold;
 		resiold = resi;
 		resi = sqrt(resnorm2);
 
@@ -467,16 +768,67 @@ StatusCode SteadyBackwardEulerSolver<nvars>::solve(Vec uvec)
 		}
 
 		step++;
-			
-		if(config.lognres)
-			if(mpirank == 0)
-				convout << step << " " << std::setw(10)  << resi/initres << '\n';
+
+		hrec.step = step;
+		hrec.rel_residual = resi/initres;
+		if(history) {
+			hrec.linear_iters = linstepsneeded;
+			hrec.wall_time = thisfinwtime - initialwtime;
+			hrec.linear_wall_time = thisfinwtime - thislinwtime;
+			hrec.cfl = curCFL;
+			hrec.abs_residual = resi;
+		}
+		haspending = true;
 
 		// test for nan
-		if(!std::isfinite(resi))
+		if(!std::isfinite(resi)) {
+			writePendingStep();
+			// give the arrays back so that the caller can recover and re-use or destroy the vectors
+			ierr = VecRestoreArray(duvec, &duarr); CHKERRQ(ierr);
+			ierr = VecRestoreArray(rvec, &rarr); CHKERRQ(ierr);
+			ierr = VecRestoreArray(uvec, &uarr); CHKERRQ(ierr);
 			throw Numerical_error("Steady backward Euler diverged - residual is Nan or inf!");
+		}
 	}
 
+	const bool exceededmaxiter = step >= config.maxiter;
+
+	/* The loop ends before the residual at the result of the last step is computed, so the last
+	 * step is checked here. If it is rejected, its starting state is the solution.
+	 */
+	bool finalcheck = false;
+	if(ubackup && haspending)
+	{
+		finalcheck = true;
+		// the solution is accepted on the full residual
+		ierr = space->assemble_residual(uvec, rvec, true, dtm); CHKERRQ(ierr);
+
+		a_real resnorm2 = 0;
+#pragma omp parallel for default(shared) reduction(+:resnorm2)
+		for(a_int iel = 0; iel < m->gnelem(); iel++) {
+			resnorm2 += residual(iel,nvars-1)*residual(iel,nvars-1)*m->garea(iel);
+			residual.row(iel).setZero();
+		}
+
+		if(continuation->toReject(sqrt(resnorm2), resi))
+		{
+			const PetscScalar *ubarr;
+			ierr = VecGetArrayRead(ubackup, &ubarr); CHKERRQ(ierr);
+#pragma omp parallel for default(shared)
+			for(a_int iel = 0; iel < m->gnelem(); iel++)
+				for(int i = 0; i < nvars; i++)
+					u(iel,i) = ubarr[iel*nvars+i];
+			ierr = VecRestoreArrayRead(ubackup, &ubarr); CHKERRQ(ierr);
+			totalrejected++;
+			if(mpirank == 0)
+				std::cout << "  SteadyBackwardEulerSolver: solve(): Last step " << step
+				          << " rejected, residual " << sqrt(resnorm2) << "\n";
+			step--;
+			haspending = false;
+		}
+	}
+	writePendingStep();
+
 	/*gettimeofday(&time2, NULL);
 	double finalwtime = (double)time2.tv_sec + (double)time2.tv_usec * 1.0e-6;*/
 	PetscLogDouble finalwtime;
@@ -484,8 +836,15 @@ StatusCode SteadyBackwardEulerSolver<nvars>::solve(Vec uvec)
 	double finalctime = (double)clock() / (double)CLOCKS_PER_SEC;
 	tdata.ode_walltime += (finalwtime-initialwtime); 
 	tdata.ode_cputime += (finalctime-initialctime);
-	tdata.avg_lin_iters = (int) (tdata.total_lin_iters / (double)step);
+	tdata.avg_lin_iters = step > 0 ? (int) (tdata.total_lin_iters / (double)step) : 0;
 	tdata.num_timesteps = step;
+	tdata.final_rel_residual = resi/initres;
+	tdata.num_res_evals = step + totalrejected + nfullres + (finalcheck ? 1 : 0);
+	tdata.num_rejected_steps = totalrejected;
+	if(ismatrixfree)
+		tdata.num_res_evals += mfA->getNumApplications() - initmfapplies;
+	if(nlschwarz)
+		tdata.num_res_evals += static_cast<int>(nlschwarz->numLocalResidualEvaluations());
 
 	if(config.lognres)
 		if(mpirank == 0)
@@ -494,6 +853,16 @@ StatusCode SteadyBackwardEulerSolver<nvars>::solve(Vec uvec)
 	if(mpirank == 0) {
 		std::cout << " SteadyBackwardEulerSolver: solve(): Done, steps = " << step 
 			<< ", rel residual " << resi/initres << std::endl;
+		if(accel)
+			std::cout << " SteadyBackwardEulerSolver: solve(): Anderson acceleration restarts = "
+			          << accel->numRestarts() << "\n";
+		if(nlschwarz)
+			std::cout << " SteadyBackwardEulerSolver: solve(): Nonlinear Schwarz local iterations "
+			          << "= " << nlschwarz->numLocalIterations() << ", local residual evaluations = "
+			          << nlschwarz->numLocalResidualEvaluations() << "\n";
+		if(totalrejected > 0)
+			std::cout << " SteadyBackwardEulerSolver: solve(): Rejected steps = " << totalrejected
+			          << "\n";
 	}
 
 	// print timing data
@@ -517,9 +886,9 @@ StatusCode SteadyBackwardEulerSolver<nvars>::solve(Vec uvec)
 	ierr = VecRestoreArray(uvec, &uarr); CHKERRQ(ierr);
 
 	tdata.converged = false;
-	if(step < config.maxiter && (resi/initres <= config.tol))
+	if(!exceededmaxiter && (resi/initres <= config.tol))
 		tdata.converged = true;
-	else if (step >= config.maxiter){
+	else if (exceededmaxiter){
 		if(mpirank == 0) {
 			std::cout << "! SteadyBackwardEulerSolver: solve(): Exceeded max iterations!\n";
 		}
@@ -538,9 +907,16 @@ template <int nvars>
 UnsteadySolver<nvars>::UnsteadySolver(const Spatial<a_real,nvars> *const spatial, Vec soln,
 		const int temporal_order, const std::string log_file)
 	: space(spatial), uvec(soln), order{temporal_order}, cputime{0.0}, walltime{0.0},
-	  logfile{log_file}
+	  logfile{log_file}, history{createHistoryLog(log_file, nvars)},
+	  tdata{spatial->mesh()->gnelem(), 1, 0.0, 0.0, 0.0, 0.0, 0, 0, 0, false}
 { }
 
+template <int nvars>
+UnsteadySolver<nvars>::~UnsteadySolver()
+{
+	delete history;
+}
+
 template <int nvars>
 TVDRKSolver<nvars>::TVDRKSolver(const Spatial<a_real,nvars> *const spatial, 
 		Vec soln, const int temporal_order, const std::string log_file, const double cfl_num)
@@ -598,16 +974,16 @@ StatusCode TVDRKSolver<nvars>::solve(const a_real finaltime)
 	double initialwtime = (double)time1.tv_sec + (double)time1.tv_usec * 1.0e-6;
 	double initialctime = (double)clock() / (double)CLOCKS_PER_SEC;
 
+#pragma omp parallel for simd default(shared)
+	for(a_int iel = 0; iel < m->gnelem(); iel++) {
+		for(int i = 0; i < nvars; i++)
+			residual(iel,i) = 0;
+	}
+
 	while(time <= finaltime - A_SMALL_NUMBER)
 	{
 		for(int istage = 0; istage < order; istage++)
 		{
-#pragma omp parallel for simd default(shared)
-			for(a_int iel = 0; iel < m->gnelem(); iel++) {
-				for(int i = 0; i < nvars; i++)
-					residual(iel,i) = 0;
-			}
-
 			// update residual
 			space->assemble_residual(uvec, rvec, true, dtm);
 
@@ -618,6 +994,9 @@ StatusCode TVDRKSolver<nvars>::solve(const a_real finaltime)
 			if(!std::isfinite(dtmin))
 				throw Numerical_error("TVDRK solver diverged - dtmin is Nan or inf!");
 
+			// Update the stage solution and zero the residual for the next stage in one pass;
+			//  the last stage also writes the new solution.
+			const bool laststage = (istage == order-1);
 #pragma omp parallel for simd default(shared)
 			for(a_int iel = 0; iel < m->gnelem(); iel++)
 			{
@@ -626,16 +1005,13 @@ StatusCode TVDRKSolver<nvars>::solve(const a_real finaltime)
 					ustage(iel,i) = tvdcoeffs(istage,0)*u(iel,i)
 						          + tvdcoeffs(istage,1)*ustage(iel,i)
 						          - tvdcoeffs(istage,2) * dtmin*cfl/m->garea(iel)*residual(iel,i);
+					residual(iel,i) = 0;
+					if(laststage)
+						u(iel,i) = ustage(iel,i);
 				}
 			}
 		}
 
-#pragma omp parallel for simd default(shared)
-		for(a_int iel = 0; iel < m->gnelem(); iel++)
-			for(int ivar = 0; ivar < nvars; ivar++)
-				u(iel,ivar) = ustage(iel,ivar);
-
-
 		if(step % 10 == 0)
 			if(mpirank == 0)
 				std::cout << "  TVDRKSolver: solve(): Step " << step 
@@ -650,6 +1026,11 @@ StatusCode TVDRKSolver<nvars>::solve(const a_real finaltime)
 	double finalctime = (double)clock() / (double)CLOCKS_PER_SEC;
 	walltime += (finalwtime-initialwtime); cputime += (finalctime-initialctime);
 
+	tdata.num_timesteps = step;
+	tdata.converged = true;
+	tdata.ode_walltime = walltime;
+	tdata.ode_cputime = cputime;
+
 	if(mpirank == 0) {
 		std::cout << " TVDRKSolver: solve(): Done, steps = " << step << ", phy time = "
 		          << time << "\n\n";
@@ -672,6 +1053,592 @@ StatusCode TVDRKSolver<nvars>::solve(const a_real finaltime)
 	return ierr;
 }
 
+PIStepController::PIStepController(const TimeStepControlConfig& conf, const int error_order)
+	: config(conf), alpha{0.7/error_order}, beta{0.4/error_order}, kinv{1.0/error_order},
+	  preverr{1.0}, prevrejected{false}
+{ }
+
+a_real PIStepController::errorNorm(const a_int n, const a_real *const uold,
+                                   const a_real *const unew, const a_real *const uembed) const
+{
+	a_real sum = 0;
+	if(config.adaptive) {
+#pragma omp parallel for simd default(shared) reduction(+:sum)
+		for(a_int i = 0; i < n; i++) {
+			const a_real w = config.abstol
+				+ config.reltol*std::max(std::abs(uold[i]), std::abs(unew[i]));
+			sum += (unew[i]-uembed[i])*(unew[i]-uembed[i])/(w*w);
+		}
+	}
+	else {
+#pragma omp parallel for simd default(shared) reduction(+:sum)
+		for(a_int i = 0; i < n; i++)
+			sum += (unew[i]-uembed[i])*(unew[i]-uembed[i]);
+	}
+
+	a_real sums[2] = {sum, static_cast<a_real>(n)};
+	MPI_Allreduce(MPI_IN_PLACE, sums, 2, MPIU_REAL, MPI_SUM, PETSC_COMM_WORLD);
+	return std::sqrt(sums[0]/sums[1]);
+}
+
+bool PIStepController::control(const a_real errnorm, a_real& dt)
+{
+	const a_real safety = 0.9, facmin = 0.2, facmax = 5.0;
+
+	if(!config.adaptive)
+		return std::isfinite(errnorm);
+
+	if(!std::isfinite(errnorm)) {
+		dt *= facmin;
+		prevrejected = true;
+		return false;
+	}
+
+	if(errnorm <= 1.0)
+	{
+		// avoid huge increases when the error is tiny
+		const a_real err = std::max(errnorm, 1e-4);
+		const a_real fac = safety*std::pow(err,-alpha)*std::pow(preverr,beta);
+		dt *= std::min(prevrejected ? 1.0 : facmax, std::max(facmin, fac));
+		if(config.dtmax > 0)
+			dt = std::min(dt, config.dtmax);
+		preverr = err;
+		prevrejected = false;
+		return true;
+	}
+	else
+	{
+		dt *= std::max(facmin, safety*std::pow(errnorm,-kinv));
+		prevrejected = true;
+		return false;
+	}
+}
+
+/// Computes w = u + dt/V sum_j c_j k_j for residuals k_j of some stages, cell by cell
+template <int nvars>
+static StatusCode stageCombination(const UMesh2dh<a_real> *const m, const Vec u, const a_real dt,
+                                   const int nk, const a_real *const c, const Vec *const k,
+                                   a_real *const w)
+{
+	StatusCode ierr = 0;
+	assert(nk <= 4);
+	const a_real *uarr, *karr[4];
+	ierr = VecGetArrayRead(u, &uarr); CHKERRQ(ierr);
+	for(int j = 0; j < nk; j++) {
+		ierr = VecGetArrayRead(k[j], &karr[j]); CHKERRQ(ierr);
+	}
+
+#pragma omp parallel for default(shared)
+	for(a_int iel = 0; iel < m->gnelem(); iel++)
+	{
+		const a_real fac = dt/m->garea(iel);
+		for(int i = 0; i < nvars; i++)
+		{
+			a_real sum = 0;
+			for(int j = 0; j < nk; j++)
+				sum += c[j]*karr[j][iel*nvars+i];
+			w[iel*nvars+i] = uarr[iel*nvars+i] + fac*sum;
+		}
+	}
+
+	for(int j = 0; j < nk; j++) {
+		ierr = VecRestoreArrayRead(k[j], &karr[j]); CHKERRQ(ierr);
+	}
+	ierr = VecRestoreArrayRead(u, &uarr); CHKERRQ(ierr);
+	return ierr;
+}
+
+/// Computes the smallest entry of a vector over all ranks
+static a_real globalMin(const std::vector<a_real>& v)
+{
+	a_real minval = v.size() > 0 ? *std::min_element(v.begin(), v.end())
+		: std::numeric_limits<a_real>::max();
+	MPI_Allreduce(MPI_IN_PLACE, &minval, 1, MPIU_REAL, MPI_MIN, PETSC_COMM_WORLD);
+	return minval;
+}
+
+/// Writes the end-of-solve report of an adaptive unsteady solver and appends to the log file
+static void reportUnsteadySolve(const std::string solvername, const std::string logfile,
+                                const int steps, const int nrejected, const a_real time,
+                                const double walltime, const double cputime)
+{
+	std::cout << " " << solvername << ": solve(): Done, steps = " << steps << ", rejected steps = "
+	          << nrejected << ", phy time = " << time << "\n\n";
+	std::cout << " " << solvername << ": solve(): Time taken by ODE solver:\n";
+	std::cout << "                                   CPU time = " << cputime
+		<< ", wall time = " << walltime << std::endl << std::endl;
+
+	int numthreads = 0;
+#ifdef _OPENMP
+	numthreads = omp_get_max_threads();
+#endif
+	std::ofstream outf; outf.open(logfile, std::ofstream::app);
+	outf << "\t" << numthreads << "\t" << walltime << "\t" << cputime << "\n";
+	outf.close();
+}
+
+template <int nvars>
+EmbeddedRKSolver<nvars>::EmbeddedRKSolver(const Spatial<a_real,nvars> *const spatial, Vec soln,
+                                          const TimeStepControlConfig& tconf,
+                                          const std::string log_file, const a_real cfl_num)
+	: UnsteadySolver<nvars>(spatial, soln, 3, log_file), tconfig(tconf), cfl{cfl_num},
+	  control(tconf, 3)
+{
+	dtm.resize(space->mesh()->gnelem(), 0);
+	dtmnew.resize(space->mesh()->gnelem(), 0);
+	StatusCode ierr = VecDuplicate(uvec, &rvec);
+	petsc_throw(ierr, "Could not create residual vector");
+	ierr = VecDuplicate(uvec, &ustage);
+	petsc_throw(ierr, "Could not create stage vector");
+	for(int j = 0; j < 3; j++) {
+		ierr = VecDuplicate(uvec, &kvec[j]);
+		petsc_throw(ierr, "Could not create stage residual vector");
+	}
+	std::cout << " EmbeddedRKSolver: Initialized Bogacki-Shampine 3(2) solver, "
+	          << (tconfig.adaptive ? "adaptive" : "constant") << " time step";
+	if(cfl > 0)
+		std::cout << ", CFL limit = " << cfl;
+	std::cout << std::endl;
+}
+
+template <int nvars>
+EmbeddedRKSolver<nvars>::~EmbeddedRKSolver()
+{
+	int ierr = VecDestroy(&rvec);
+	ierr += VecDestroy(&ustage);
+	for(int j = 0; j < 3; j++)
+		ierr += VecDestroy(&kvec[j]);
+	if(ierr)
+		std::cout << "! EmbeddedRKSolver: Could not destroy work vectors!\n";
+}
+
+template <int nvars>
+StatusCode EmbeddedRKSolver<nvars>::solve(const a_real finaltime)
+{
+	const UMesh2dh<a_real> *const m = space->mesh();
+	StatusCode ierr = 0;
+	int mpirank;
+	MPI_Comm_rank(PETSC_COMM_WORLD, &mpirank);
+	const a_int n = m->gnelem()*nvars;
+
+	// Bogacki-Shampine coefficients
+	const a_real a2[] = {0.5};
+	const a_real a3[] = {0.0, 0.75};
+	const a_real b[] = {2.0/9.0, 1.0/3.0, 4.0/9.0};
+	const a_real bhat[] = {7.0/24.0, 0.25, 1.0/3.0, 0.125};
+
+	std::vector<a_real> uembed(n);
+
+	std::ofstream steplog;
+	if(mpirank == 0)
+		steplog.open(logfile+".tsteps", std::ofstream::app);
+
+	PetscLogDouble initialwtime;
+	PetscTime(&initialwtime);
+	double initialctime = (double)clock() / (double)CLOCKS_PER_SEC;
+
+	// the first stage of the first step; later, it is the last stage of the previous step
+	ierr = VecSet(kvec[0], 0.0); CHKERRQ(ierr);
+	ierr = space->assemble_residual(uvec, kvec[0], true, dtm); CHKERRQ(ierr);
+
+	int step = 0, nrejected = 0;
+	a_real time = 0;
+	a_real dtnext = tconfig.dtinit;
+	tdata.max_step_error = 0;
+	tdata.min_timestep = finaltime;
+
+	while(time < finaltime - A_SMALL_NUMBER)
+	{
+		a_real dt = dtnext;
+		if(cfl > 0)
+			dt = std::min(dt, cfl*globalMin(dtm));
+		dt = std::min(dt, finaltime-time);
+
+		Vec kv[] = {kvec[0], kvec[1], kvec[2], rvec};
+		a_real *usarr;
+
+		ierr = VecGetArray(ustage, &usarr); CHKERRQ(ierr);
+		ierr = stageCombination<nvars>(m, uvec, dt, 1, a2, kv, usarr); CHKERRQ(ierr);
+		ierr = VecRestoreArray(ustage, &usarr); CHKERRQ(ierr);
+		ierr = VecSet(kvec[1], 0.0); CHKERRQ(ierr);
+		ierr = space->assemble_residual(ustage, kvec[1], false, dtmnew); CHKERRQ(ierr);
+
+		ierr = VecGetArray(ustage, &usarr); CHKERRQ(ierr);
+		ierr = stageCombination<nvars>(m, uvec, dt, 2, a3, kv, usarr); CHKERRQ(ierr);
+		ierr = VecRestoreArray(ustage, &usarr); CHKERRQ(ierr);
+		ierr = VecSet(kvec[2], 0.0); CHKERRQ(ierr);
+		ierr = space->assemble_residual(ustage, kvec[2], false, dtmnew); CHKERRQ(ierr);
+
+		// new solution, and the last stage evaluated there
+		ierr = VecGetArray(ustage, &usarr); CHKERRQ(ierr);
+		ierr = stageCombination<nvars>(m, uvec, dt, 3, b, kv, usarr); CHKERRQ(ierr);
+		ierr = VecRestoreArray(ustage, &usarr); CHKERRQ(ierr);
+		ierr = VecSet(rvec, 0.0); CHKERRQ(ierr);
+		ierr = space->assemble_residual(ustage, rvec, true, dtmnew); CHKERRQ(ierr);
+
+		ierr = stageCombination<nvars>(m, uvec, dt, 4, bhat, kv, &uembed[0]); CHKERRQ(ierr);
+
+		const a_real *uarr, *usrarr;
+		ierr = VecGetArrayRead(uvec, &uarr); CHKERRQ(ierr);
+		ierr = VecGetArrayRead(ustage, &usrarr); CHKERRQ(ierr);
+		const a_real errnorm = control.errorNorm(n, uarr, usrarr, &uembed[0]);
+		ierr = VecRestoreArrayRead(ustage, &usrarr); CHKERRQ(ierr);
+		ierr = VecRestoreArrayRead(uvec, &uarr); CHKERRQ(ierr);
+
+		a_real dtnew = dt;
+		const bool accepted = control.control(errnorm, dtnew);
+		if(tconfig.adaptive)
+			dtnext = dtnew;
+
+		if(accepted) {
+			ierr = VecCopy(ustage, uvec); CHKERRQ(ierr);
+			std::swap(kvec[0], rvec);
+			std::swap(dtm, dtmnew);
+			time += dt;
+			step++;
+			tdata.max_step_error = std::max(tdata.max_step_error, errnorm);
+			tdata.min_timestep = std::min(tdata.min_timestep, dt);
+		}
+		else
+			nrejected++;
+
+		if(mpirank == 0) {
+			steplog << step << ' ' << time << ' ' << dt << ' ' << errnorm << ' ' << accepted
+			        << '\n';
+			if(accepted && step % 10 == 0)
+				std::cout << "  EmbeddedRKSolver: solve(): Step " << step << ", time " << time
+				          << ", time-step = " << dt << ", error = " << errnorm << std::endl;
+		}
+
+		if(history && accepted) {
+			PetscLogDouble curwtime;
+			PetscTime(&curwtime);
+			HistoryRecord hrec = emptyHistoryRecord();
+			hrec.step = step;
+			hrec.wall_time = curwtime - initialwtime;
+			hrec.phys_time = time;
+			hrec.timestep = dt;
+			history->append(hrec);
+		}
+
+		if(!accepted && !tconfig.adaptive)
+			throw Numerical_error("Embedded RK solver diverged - solution is NaN or inf!");
+		if(dtnext < A_SMALL_NUMBER*finaltime)
+			throw Numerical_error("Embedded RK solver: time step has become too small!");
+	}
+
+	PetscLogDouble finalwtime;
+	PetscTime(&finalwtime);
+	double finalctime = (double)clock() / (double)CLOCKS_PER_SEC;
+	walltime += (finalwtime-initialwtime); cputime += (finalctime-initialctime);
+
+	tdata.num_timesteps = step;
+	tdata.num_rejected_steps = nrejected;
+	tdata.converged = true;
+	tdata.ode_walltime = walltime;
+	tdata.ode_cputime = cputime;
+
+	if(mpirank == 0) {
+		steplog.close();
+		reportUnsteadySolve("EmbeddedRKSolver", logfile, step, nrejected, time, walltime, cputime);
+	}
+
+	return ierr;
+}
+
+template <int nvars>
+ESDIRKSolver<nvars>::ESDIRKSolver(const Spatial<a_real,nvars> *const spatial, Vec soln,
+                                  const TimeStepControlConfig& tconf, KSP ksp,
+                                  const std::string log_file)
+	: UnsteadySolver<nvars>(spatial, soln, 2, log_file), tconfig(tconf), control(tconf, 3),
+	  solver(ksp),
+	  newtonrtol{parseOptionalPetscCmd_real("-unsteady_newton_rtol", 1e-6)},
+	  newtonmaxits{parsePetscCmd_isDefined("-unsteady_newton_max_its") ?
+	               parsePetscCmd_int("-unsteady_newton_max_its") : 10}
+{
+	mdiag.resize(space->mesh()->gnelem(), 0);
+	StatusCode ierr = VecDuplicate(uvec, &rvec);
+	petsc_throw(ierr, "Could not create residual vector");
+	ierr = VecDuplicate(uvec, &ustage);
+	petsc_throw(ierr, "Could not create stage vector");
+	ierr = VecDuplicate(uvec, &gvec);
+	petsc_throw(ierr, "Could not create stage residual vector");
+	ierr = VecDuplicate(uvec, &duvec);
+	petsc_throw(ierr, "Could not create update vector");
+	for(int j = 0; j < 3; j++) {
+		ierr = VecDuplicate(uvec, &kvec[j]);
+		petsc_throw(ierr, "Could not create stage residual vector");
+	}
+	std::cout << " ESDIRKSolver: Initialized TR-BDF2 solver, "
+	          << (tconfig.adaptive ? "adaptive" : "constant") << " time step" << std::endl;
+}
+
+template <int nvars>
+ESDIRKSolver<nvars>::~ESDIRKSolver()
+{
+	int ierr = VecDestroy(&rvec);
+	ierr += VecDestroy(&ustage);
+	ierr += VecDestroy(&gvec);
+	ierr += VecDestroy(&duvec);
+	for(int j = 0; j < 3; j++)
+		ierr += VecDestroy(&kvec[j]);
+	if(ierr)
+		std::cout << "! ESDIRKSolver: Could not destroy work vectors!\n";
+}
+
+template <int nvars>
+StatusCode ESDIRKSolver<nvars>::solveStage(const a_real adt, const a_real *const z,
+                                           const Vec kguess, Vec kstage, bool& converged,
+                                           int& linits)
+{
+	const UMesh2dh<a_real> *const m = space->mesh();
+	StatusCode ierr = 0;
+	std::vector<a_real> dummy;
+	converged = false;
+
+	// initial guess
+	{
+		a_real *usarr; const a_real *kgarr;
+		ierr = VecGetArray(ustage, &usarr); CHKERRQ(ierr);
+		ierr = VecGetArrayRead(kguess, &kgarr); CHKERRQ(ierr);
+#pragma omp parallel for default(shared)
+		for(a_int iel = 0; iel < m->gnelem(); iel++)
+			for(int i = 0; i < nvars; i++)
+				usarr[iel*nvars+i] = z[iel*nvars+i] + adt/m->garea(iel)*kgarr[iel*nvars+i];
+		ierr = VecRestoreArrayRead(kguess, &kgarr); CHKERRQ(ierr);
+		ierr = VecRestoreArray(ustage, &usarr); CHKERRQ(ierr);
+	}
+
+	a_real gnorm0 = 0;
+	for(int it = 0; it <= newtonmaxits; it++)
+	{
+		ierr = VecSet(rvec, 0.0); CHKERRQ(ierr);
+		ierr = space->assemble_residual(ustage, rvec, false, dummy); CHKERRQ(ierr);
+
+		// right hand side R(U) - V/(a dt) (U-Z), the negative of the stage's nonlinear residual
+		a_real gnorm = 0;
+		{
+			a_real *garr; const a_real *usarr, *rarr;
+			ierr = VecGetArray(gvec, &garr); CHKERRQ(ierr);
+			ierr = VecGetArrayRead(ustage, &usarr); CHKERRQ(ierr);
+			ierr = VecGetArrayRead(rvec, &rarr); CHKERRQ(ierr);
+#pragma omp parallel for default(shared) reduction(+:gnorm)
+			for(a_int iel = 0; iel < m->gnelem(); iel++)
+				for(int i = 0; i < nvars; i++) {
+					const a_int k = iel*nvars+i;
+					garr[k] = rarr[k] - mdiag[iel]*(usarr[k]-z[k]);
+					gnorm += garr[k]*garr[k];
+				}
+			ierr = VecRestoreArrayRead(rvec, &rarr); CHKERRQ(ierr);
+			ierr = VecRestoreArrayRead(ustage, &usarr); CHKERRQ(ierr);
+			ierr = VecRestoreArray(gvec, &garr); CHKERRQ(ierr);
+		}
+		ierr = MPI_Allreduce(MPI_IN_PLACE, &gnorm, 1, MPIU_REAL, MPI_SUM, PETSC_COMM_WORLD);
+		CHKERRQ(ierr);
+		gnorm = std::sqrt(gnorm);
+
+		if(it == 0)
+			gnorm0 = gnorm;
+		if(!std::isfinite(gnorm))
+			break;
+		if(gnorm <= newtonrtol*gnorm0 || gnorm == 0) {
+			converged = true;
+			break;
+		}
+		if(it == newtonmaxits)
+			break;
+
+		beginPerfStage(PERFSTAGE_LINSOLVE);
+		ierr = KSPSolve(solver, gvec, duvec); CHKERRQ(ierr);
+		endPerfStage(PERFSTAGE_LINSOLVE);
+
+		int its;
+		ierr = KSPGetIterationNumber(solver, &its); CHKERRQ(ierr);
+		linits += its;
+		KSPConvergedReason reason;
+		ierr = KSPGetConvergedReason(solver, &reason); CHKERRQ(ierr);
+		if(reason < 0)
+			break;
+
+		ierr = VecAXPY(ustage, 1.0, duvec); CHKERRQ(ierr);
+	}
+
+	if(converged)
+	{
+		// residual of the stage, consistent with the stage equation
+		a_real *karr; const a_real *usarr;
+		ierr = VecGetArray(kstage, &karr); CHKERRQ(ierr);
+		ierr = VecGetArrayRead(ustage, &usarr); CHKERRQ(ierr);
+#pragma omp parallel for default(shared)
+		for(a_int iel = 0; iel < m->gnelem(); iel++)
+			for(int i = 0; i < nvars; i++)
+				karr[iel*nvars+i] = mdiag[iel]*(usarr[iel*nvars+i]-z[iel*nvars+i]);
+		ierr = VecRestoreArrayRead(ustage, &usarr); CHKERRQ(ierr);
+		ierr = VecRestoreArray(kstage, &karr); CHKERRQ(ierr);
+	}
+
+	return ierr;
+}
+
+template <int nvars>
+StatusCode ESDIRKSolver<nvars>::solve(const a_real finaltime)
+{
+	const UMesh2dh<a_real> *const m = space->mesh();
+	StatusCode ierr = 0;
+	int mpirank;
+	MPI_Comm_rank(PETSC_COMM_WORLD, &mpirank);
+	const a_int n = m->gnelem()*nvars;
+
+	// TR-BDF2 coefficients
+	const a_real d = 1.0 - 1.0/std::sqrt(2.0);
+	const a_real w = std::sqrt(2.0)/4.0;
+	const a_real a2[] = {d};
+	const a_real a3[] = {w, w};
+	const a_real bhat[] = {(1.0-w)/3.0, (3.0*w+1.0)/3.0, d/3.0};
+
+	Mat M, A;
+	ierr = KSPGetOperators(solver, &A, &M); CHKERRQ(ierr);
+	const bool ismatrixfree = isMatrixFree(A);
+	if(ismatrixfree) {
+		MatrixFreeSpatialJacobian<nvars>* mfA = nullptr;
+		ierr = MatShellGetContext(A, (void**)&mfA); CHKERRQ(ierr);
+		// the Jacobian is needed at the stage solution, whose residual is kept in rvec
+		mfA->set_state(ustage,rvec,&mdiag);
+	}
+
+	std::vector<a_real> z(n), uembed(n);
+
+	std::ofstream steplog;
+	if(mpirank == 0)
+		steplog.open(logfile+".tsteps", std::ofstream::app);
+
+	PetscLogDouble initialwtime;
+	PetscTime(&initialwtime);
+	double initialctime = (double)clock() / (double)CLOCKS_PER_SEC;
+
+	std::vector<a_real> dummy;
+	ierr = VecSet(kvec[0], 0.0); CHKERRQ(ierr);
+	ierr = space->assemble_residual(uvec, kvec[0], false, dummy); CHKERRQ(ierr);
+
+	int step = 0, nrejected = 0, linits = 0;
+	a_real time = 0;
+	a_real dtnext = tconfig.dtinit;
+	tdata.max_step_error = 0;
+	tdata.min_timestep = finaltime;
+
+	while(time < finaltime - A_SMALL_NUMBER)
+	{
+		const a_real dt = std::min(dtnext, finaltime-time);
+		const int steplinits = linits;
+
+		// Jacobian at the old solution, and the mass term of the stage equations
+		beginPerfStage(PERFSTAGE_JACOBIAN);
+		ierr = MatZeroEntries(M); CHKERRQ(ierr);
+		ierr = space->compute_jacobian(uvec, M); CHKERRQ(ierr);
+		endPerfStage(PERFSTAGE_JACOBIAN);
+
+#pragma omp parallel for default(shared)
+		for(a_int iel = 0; iel < m->gnelem(); iel++)
+		{
+			mdiag[iel] = m->garea(iel)/(d*dt);
+			Matrix<a_real,nvars,nvars,RowMajor> db = Matrix<a_real,nvars,nvars,RowMajor>::Zero();
+			for(int i = 0; i < nvars; i++)
+				db(i,i) = mdiag[iel];
+#pragma omp critical
+			{
+				MatSetValuesBlocked(M, 1, &iel, 1, &iel, db.data(), ADD_VALUES);
+			}
+		}
+		ierr = MatAssemblyBegin(M, MAT_FINAL_ASSEMBLY); CHKERRQ(ierr);
+		ierr = MatAssemblyEnd(M, MAT_FINAL_ASSEMBLY); CHKERRQ(ierr);
+		ierr = MatSetOption(M, MAT_NEW_NONZERO_LOCATIONS, PETSC_FALSE); CHKERRQ(ierr);
+
+		// trapezoidal stage
+		bool converged = false;
+		ierr = stageCombination<nvars>(m, uvec, dt, 1, a2, kvec, &z[0]); CHKERRQ(ierr);
+		ierr = solveStage(d*dt, &z[0], kvec[0], kvec[1], converged, linits); CHKERRQ(ierr);
+
+		// BDF2 stage, which gives the new solution
+		if(converged) {
+			ierr = stageCombination<nvars>(m, uvec, dt, 2, a3, kvec, &z[0]); CHKERRQ(ierr);
+			ierr = solveStage(d*dt, &z[0], kvec[1], kvec[2], converged, linits); CHKERRQ(ierr);
+		}
+
+		a_real errnorm = std::numeric_limits<a_real>::infinity();
+		if(converged) {
+			ierr = stageCombination<nvars>(m, uvec, dt, 3, bhat, kvec, &uembed[0]); CHKERRQ(ierr);
+			const a_real *uarr, *usarr;
+			ierr = VecGetArrayRead(uvec, &uarr); CHKERRQ(ierr);
+			ierr = VecGetArrayRead(ustage, &usarr); CHKERRQ(ierr);
+			errnorm = control.errorNorm(n, uarr, usarr, &uembed[0]);
+			ierr = VecRestoreArrayRead(ustage, &usarr); CHKERRQ(ierr);
+			ierr = VecRestoreArrayRead(uvec, &uarr); CHKERRQ(ierr);
+		}
+
+		a_real dtnew = dt;
+		const bool accepted = control.control(errnorm, dtnew);
+		if(tconfig.adaptive)
+			dtnext = dtnew;
+
+		if(accepted) {
+			ierr = VecCopy(ustage, uvec); CHKERRQ(ierr);
+			std::swap(kvec[0], kvec[2]);
+			time += dt;
+			step++;
+			tdata.max_step_error = std::max(tdata.max_step_error, errnorm);
+			tdata.min_timestep = std::min(tdata.min_timestep, dt);
+		}
+		else
+			nrejected++;
+
+		if(mpirank == 0) {
+			steplog << step << ' ' << time << ' ' << dt << ' ' << errnorm << ' ' << accepted
+			        << '\n';
+			if(accepted && step % 10 == 0)
+				std::cout << "  ESDIRKSolver: solve(): Step " << step << ", time " << time
+				          << ", time-step = " << dt << ", error = " << errnorm << std::endl;
+		}
+
+		if(history && accepted) {
+			PetscLogDouble curwtime;
+			PetscTime(&curwtime);
+			HistoryRecord hrec = emptyHistoryRecord();
+			hrec.step = step;
+			hrec.linear_iters = linits - steplinits;
+			hrec.wall_time = curwtime - initialwtime;
+			hrec.phys_time = time;
+			hrec.timestep = dt;
+			history->append(hrec);
+		}
+
+		if(!accepted && !tconfig.adaptive)
+			throw Numerical_error("ESDIRK solver: Newton iteration of a stage did not converge!");
+		if(dtnext < A_SMALL_NUMBER*finaltime)
+			throw Numerical_error("ESDIRK solver: time step has become too small!");
+	}
+
+	PetscLogDouble finalwtime;
+	PetscTime(&finalwtime);
+	double finalctime = (double)clock() / (double)CLOCKS_PER_SEC;
+	walltime += (finalwtime-initialwtime); cputime += (finalctime-initialctime);
+
+	tdata.num_timesteps = step;
+	tdata.num_rejected_steps = nrejected;
+	tdata.converged = true;
+	tdata.ode_walltime = walltime;
+	tdata.ode_cputime = cputime;
+	tdata.total_lin_iters = linits;
+	tdata.avg_lin_iters = step > 0 ? linits/step : 0;
+
+	if(mpirank == 0) {
+		steplog.close();
+		std::cout << " ESDIRKSolver: solve(): Total linear solver iterations = " << linits << "\n";
+		reportUnsteadySolve("ESDIRKSolver", logfile, step, nrejected, time, walltime, cputime);
+	}
+
+	return ierr;
+}
+
 template class SteadySolver<NVARS>;
 template class SteadySolver<1>;
 
@@ -681,5 +1648,15 @@ template class SteadyForwardEulerSolver<1>;
 template class SteadyBackwardEulerSolver<1>;
 
 template class TVDRKSolver<NVARS>;
+template class EmbeddedRKSolver<NVARS>;
+template class ESDIRKSolver<NVARS>;
+
+// flow with one passive scalar
+template class SteadySolver<NVARS+1>;
+template class SteadyForwardEulerSolver<NVARS+1>;
+template class SteadyBackwardEulerSolver<NVARS+1>;
+template class TVDRKSolver<NVARS+1>;
+template class EmbeddedRKSolver<NVARS+1>;
+template class ESDIRKSolver<NVARS+1>;
 
 }	// end namespace
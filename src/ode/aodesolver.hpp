@@ -10,12 +10,18 @@
 #include <tuple>
 #include <petscksp.h>
 #include "spatial/aspatial.hpp"
+#include "ode/anderson.hpp"
+#include "ode/nonlinearschwarz.hpp"
+#include "ode/continuation.hpp"
+#include "utilities/historylog.hpp"
 
 namespace fvens {
 
 /// A collection of parameters specifying the temporal discretization
 struct SteadySolverConfig {
-	bool lognres;                ///< Whether to output nonlinear residual history
+	/// Whether to output nonlinear residual history, in the binary history log as well if
+	///  `-convergence_history_binary' is given
+	bool lognres;
 	std::string logfile;         ///< File in which to write nonlinear residual history if needed
 	a_real cflinit;              ///< Initial CFL number, used for steps before \ref rampstart
 	a_real cflfin;               ///< Final CFL, used for time steps after \ref rampend
@@ -42,6 +48,13 @@ struct TimingData {
 	double precsetup_walltime;   ///< Custom preconditioner setup wall time
 	double precapply_walltime;   ///< Custom preconditioner apply wall time
 	double prec_cputime;         ///< Total CPU time taken by custom preconditioner
+	a_real final_rel_residual;   ///< Relative residual norm at the end of the nonlinear solve
+	/// Number of residual evaluations, including those in matrix-free Jacobian-vector products
+	int num_res_evals;
+	int num_rejected_steps;      ///< Number of time steps rejected and retried
+	/// Largest error estimate of an accepted physical time step, with error-estimating integrators
+	a_real max_step_error;
+	a_real min_timestep;         ///< Smallest accepted physical time step of an unsteady solve
 };
 
 /// Base class for steady-state simulations in pseudo-time
@@ -64,13 +77,21 @@ public:
 	/// Solve the nonlinear steady-state problem
 	virtual StatusCode solve(Vec u) = 0;
 
-	virtual ~SteadySolver() {}
+	virtual ~SteadySolver();
 
 protected:
 	const Spatial<a_real,nvars> *const space;
 	const SteadySolverConfig& config;
 	Vec rvec;
 	TimingData tdata;
+
+	/// Anderson acceleration settings, read from the PETSc options by \ref parseAndersonConfig
+	const AndersonConfig andconf;
+	/// Accelerator of the pseudo-time iteration, or NULL if it is not accelerated
+	AndersonAccelerator *accel;
+
+	/// Binary convergence history, or NULL if it is not needed - see \ref createHistoryLog
+	HistoryLog *history;
 };
 	
 /// A driver class for explicit time-stepping to steady state using forward Euler integration
@@ -80,6 +101,8 @@ protected:
  * Optionally runs a `starter' time stepping loop to generate an initial solution
  * before starting the `main' loop.
  * The starter can perhaps use a first-order discretization.
+ *
+ * The iteration is Anderson-accelerated if `-anderson_depth' is positive.
  */
 template <int nvars>
 class SteadyForwardEulerSolver : public SteadySolver<nvars>
@@ -106,11 +129,24 @@ private:
 	using SteadySolver<nvars>::config;
 	using SteadySolver<nvars>::rvec;
 	using SteadySolver<nvars>::tdata;
+	using SteadySolver<nvars>::andconf;
+	using SteadySolver<nvars>::accel;
+	using SteadySolver<nvars>::history;
 
 	std::vector<a_real> dtm;				///< Stores allowable local time step for each cell
+
+	/// The fixed-point update of the current step, only used with Anderson acceleration
+	Vec fvec;
 };
 
 /// Implicit pseudo-time iteration to steady state
+/** The outer iteration is Anderson-accelerated if `-anderson_depth' is positive and
+ * `-anderson_implicit' is given. If `-nonlinear_schwarz' is given, each pseudo-time step is
+ * solved by \ref NonlinearSchwarz instead of one linear solve. The CFL number is chosen by a
+ * \ref PseudoTimeContinuation policy. If `-pseudotime_max_rejections' is positive, a step whose
+ * starting residual is not finite, or has grown too much, is rejected: the state of the previous
+ * step is restored and the step is retried with a smaller CFL number.
+ */
 template <int nvars>
 class SteadyBackwardEulerSolver : public SteadySolver<nvars>
 {
@@ -128,7 +164,8 @@ public:
 
 	/// Runs the time-stepping loop with backward Euler time-stepping
 	/** Stores timing data in a \ref TimingData object that can be retreived by \ref getTimingData.
-	 * Throws an instance of \ref Numerical_error if the residual becomes NaN or inf.
+	 * Throws an instance of \ref Numerical_error if the residual becomes NaN or inf, unless the
+	 * step can be rejected and retried.
 	 * 
 	 * \param[in,out] u The solution vector containing the initial solution and which
 	 *   will contain the final solution on return.
@@ -140,19 +177,27 @@ protected:
 	using SteadySolver<nvars>::config;
 	using SteadySolver<nvars>::tdata;
 	using SteadySolver<nvars>::rvec;       ///< Residual vector
+	using SteadySolver<nvars>::andconf;
+	using SteadySolver<nvars>::accel;
+	using SteadySolver<nvars>::history;
 
 	Vec duvec;                             ///< Nonlinear update vector
 	std::vector<a_real> dtm;               ///< Stores allowable local time step for each cell
 
 	KSP solver;                            ///< The solver context
 
-	/// Linear CFL ramping 
-	a_real linearRamp(const a_real cstart, const a_real cend, const int itstart, const int itend,
-			const int itcur) const;
+	/// Nonlinear Schwarz settings, read from the PETSc options by \ref parseNonlinearSchwarzConfig
+	const NonlinearSchwarzConfig nlsconf;
+	/// Nonlinear Schwarz solver of the pseudo-time steps, or NULL if it is not used
+	NonlinearSchwarz<nvars> *nlschwarz;
+
+	/// Pseudo-time continuation settings, read from the PETSc options by \ref parseContinuationConfig
+	const ContinuationConfig contconf;
+	/// Policy choosing the CFL number of each step
+	PseudoTimeContinuation *continuation;
 
-	/// A kind of exponential ramping, designed to be dependent on the residual ratio as base
-	a_real expResidualRamp(const a_real cflmin, const a_real cflmax, const a_real prevcfl,
-			const a_real resratio, const a_real paramup, const a_real paramdown);
+	/// The starting state of the last accepted step, only kept if steps may be rejected
+	Vec ubackup;
 };
 
 /// Base class for unsteady simulations
@@ -171,6 +216,12 @@ protected:
 	double walltime;
 	const std::string logfile;
 
+	/// Binary history of time steps, or NULL if it is not needed - see \ref createHistoryLog
+	HistoryLog *history;
+
+	/// Number of time steps and statistics of the time steps of the last solve
+	TimingData tdata;
+
 public:
 	/** 
 	 * \param[in] mesh Mesh context
@@ -186,10 +237,16 @@ public:
 		return std::make_tuple(walltime, cputime);
 	}
 
+	/// Get the number of time steps taken, the number of rejected steps, and the largest error
+	///  estimate and the smallest time step of accepted steps
+	TimingData getTimingData() const {
+		return tdata;
+	}
+
 	/// Solve the ODE
 	virtual StatusCode solve(const a_real time) = 0;
 
-	virtual ~UnsteadySolver() {}
+	virtual ~UnsteadySolver();
 };
 
 /// Total variation diminishing Runge-Kutta solvers upto order 3
@@ -212,6 +269,7 @@ protected:
 	using UnsteadySolver<nvars>::cputime;
 	using UnsteadySolver<nvars>::walltime;
 	using UnsteadySolver<nvars>::logfile;
+	using UnsteadySolver<nvars>::tdata;
 
 	const double cfl;
 
@@ -221,7 +279,194 @@ protected:
 private:
 	std::vector<a_real> dtm;
 };
-	
+
+/// Settings for the choice of the physical time step of the error-controlled integrators
+struct TimeStepControlConfig
+{
+	bool adaptive;              ///< Whether the time step is adapted to the error tolerance
+	a_real dtinit;              ///< Initial time step; the time step throughout if not adaptive
+	a_real reltol;              ///< Relative tolerance on the local error of each time step
+	a_real abstol;              ///< Absolute tolerance on the local error of each time step
+	a_real dtmax;               ///< Largest allowed time step; not limited if non-positive
+};
+
+/// Proportional-integral (PI) controller of the physical time step
+/** The local error estimate of a step is measured in the weighted RMS norm
+ * \f[ \|e\| = \sqrt{\frac1N \sum_i \left(\frac{e_i}{atol + rtol \max(|u^n_i|,|u^{n+1}_i|)}
+ *   \right)^2} \f]
+ * so that the step is accepted if the norm is at most 1. The next step is then
+ * \f$ \Delta t_{n+1} = \Delta t_n\, s\, \|e_n\|^{-\alpha} \|e_{n-1}\|^{\beta} \f$
+ * with \f$ \alpha = 0.7/k \f$ and \f$ \beta = 0.4/k \f$, k being the order of the error estimate,
+ * and the change in one step is bounded. A rejected step is retried with
+ * \f$ s\|e_n\|^{-1/k} \f$ times the step, and the step is not increased right after a rejection.
+ */
+class PIStepController
+{
+public:
+	/**
+	 * \param conf Time step control settings
+	 * \param error_order Order of the local error estimate in the time step
+	 */
+	PIStepController(const TimeStepControlConfig& conf, const int error_order);
+
+	/// Computes the weighted RMS norm of a local error estimate over all ranks
+	/** If the time step is not adaptive, there are no tolerances and the plain RMS norm is
+	 * computed instead.
+	 * \param n Local number of entries
+	 * \param uold Solution at the beginning of the step
+	 * \param unew Solution at the end of the step
+	 * \param uembed The embedded solution at the end of the step; its difference from unew is
+	 *   the error estimate.
+	 */
+	a_real errorNorm(const a_int n, const a_real *const uold, const a_real *const unew,
+	                 const a_real *const uembed) const;
+
+	/// Decides whether a step is accepted and computes the next time step
+	/** If time step control is not adaptive, every step with a finite error is accepted and the
+	 * time step is not changed.
+	 * \param errnorm The norm of the error estimate computed by \ref errorNorm; NaN or inf if the
+	 *   step failed altogether.
+	 * \param[in,out] dt The step just attempted on input, the step to attempt next on output
+	 * \return True if the step is accepted
+	 */
+	bool control(const a_real errnorm, a_real& dt);
+
+protected:
+	const TimeStepControlConfig& config;
+	const a_real alpha;             ///< Exponent of the current error
+	const a_real beta;              ///< Exponent of the previous error
+	const a_real kinv;              ///< Inverse of the order of the error estimate
+	a_real preverr;                 ///< Error norm of the last accepted step
+	bool prevrejected;              ///< Whether the last step was rejected
+};
+
+/// Explicit embedded Runge-Kutta solver with adaptive time steps
+/** Uses the Bogacki-Shampine 3(2) pair, which is third-order accurate and has a second-order
+ * embedded solution for the error estimate. Since the last stage is evaluated at the new solution,
+ * it is also the first stage of the next step (first same as last). Each step is additionally
+ * limited by the CFL condition if a positive CFL number is given.
+ */
+template<int nvars>
+class EmbeddedRKSolver : public UnsteadySolver<nvars>
+{
+public:
+	/**
+	 * \param spatial Spatial discretization context
+	 * \param soln The solution vector to use and update
+	 * \param tconf Time step control settings
+	 * \param log_file File to append timing data to; the history of time steps is written to
+	 *   this name with ".tsteps" appended, and optionally to a binary history log.
+	 * \param cfl_num CFL number limiting the time step; no limit if non-positive
+	 */
+	EmbeddedRKSolver(const Spatial<a_real,nvars> *const spatial, Vec soln,
+	                 const TimeStepControlConfig& tconf, const std::string log_file,
+	                 const a_real cfl_num);
+
+	~EmbeddedRKSolver();
+
+	StatusCode solve(const a_real finaltime);
+
+protected:
+	using UnsteadySolver<nvars>::space;
+	using UnsteadySolver<nvars>::rvec;
+	using UnsteadySolver<nvars>::uvec;
+	using UnsteadySolver<nvars>::cputime;
+	using UnsteadySolver<nvars>::walltime;
+	using UnsteadySolver<nvars>::logfile;
+	using UnsteadySolver<nvars>::history;
+	using UnsteadySolver<nvars>::tdata;
+
+	const TimeStepControlConfig& tconfig;
+	const a_real cfl;
+	PIStepController control;
+
+	/// Stage solution
+	Vec ustage;
+	/// Residuals of the first three stages; the residual of the last stage is stored in rvec
+	Vec kvec[3];
+	/// Allowable local time steps at the beginning and at the end of the step
+	std::vector<a_real> dtm, dtmnew;
+};
+
+/// Singly-diagonally implicit Runge-Kutta solver with an explicit first stage, with adaptive
+/// time steps
+/** Uses the TR-BDF2 scheme in Butcher form: the second stage is a trapezoidal step and the third
+ * is a BDF2 step. The scheme is second-order accurate, L-stable and stiffly accurate, and has a
+ * third-order embedded solution for the error estimate. The last stage is the first stage of the
+ * next step. Each implicit stage is solved by a Newton iteration in which the Jacobian matrix,
+ * computed once per step at the old solution, is reused. If the system matrix of the KSP is the
+ * matrix-free Jacobian, it is applied at the current Newton iterate instead, and the assembled
+ * matrix is only used for preconditioning. If a stage does not converge, the step is retried with
+ * a smaller time step if the time step is adaptive; otherwise, an instance of
+ * \ref Numerical_error is thrown.
+ *
+ * The Newton iteration is controlled by the PETSc options
+ *  - `-unsteady_newton_rtol' Tolerance on the nonlinear residual relative to the initial one
+ *     (default 1e-6)
+ *  - `-unsteady_newton_max_its' Maximum number of Newton iterations per stage (default 10)
+ */
+template<int nvars>
+class ESDIRKSolver : public UnsteadySolver<nvars>
+{
+public:
+	/**
+	 * \param spatial Spatial discretization context
+	 * \param soln The solution vector to use and update
+	 * \param tconf Time step control settings
+	 * \param ksp The linear solver context, whose operators are the Jacobian matrices
+	 * \param log_file File to append timing data to; the history of time steps is written to
+	 *   this name with ".tsteps" appended, and optionally to a binary history log.
+	 */
+	ESDIRKSolver(const Spatial<a_real,nvars> *const spatial, Vec soln,
+	             const TimeStepControlConfig& tconf, KSP ksp, const std::string log_file);
+
+	~ESDIRKSolver();
+
+	StatusCode solve(const a_real finaltime);
+
+protected:
+	using UnsteadySolver<nvars>::space;
+	using UnsteadySolver<nvars>::rvec;
+	using UnsteadySolver<nvars>::uvec;
+	using UnsteadySolver<nvars>::cputime;
+	using UnsteadySolver<nvars>::walltime;
+	using UnsteadySolver<nvars>::logfile;
+	using UnsteadySolver<nvars>::history;
+	using UnsteadySolver<nvars>::tdata;
+
+	const TimeStepControlConfig& tconfig;
+	PIStepController control;
+	KSP solver;
+
+	const a_real newtonrtol;        ///< Relative tolerance of the Newton iteration of a stage
+	const int newtonmaxits;         ///< Maximum number of Newton iterations of a stage
+
+	/// Stage solution
+	Vec ustage;
+	/// Nonlinear residual of a stage
+	Vec gvec;
+	/// Newton update
+	Vec duvec;
+	/// Residuals of the three stages
+	Vec kvec[3];
+	/// Mass matrix divided by the time step and the diagonal coefficient, for each cell
+	std::vector<a_real> mdiag;
+
+	/// Solves one implicit stage
+	/** Solves \f$ \frac{V}{a \Delta t}(U-Z) - R(U) = 0 \f$ for U, where R is the residual as
+	 * computed by the spatial discretization and a the diagonal coefficient.
+	 * \param[in] adt The diagonal coefficient times the time step
+	 * \param[in] z The explicit part Z of the stage
+	 * \param[in] kguess Residual of a previous stage used for the initial guess Z + a dt k/V
+	 * \param[out] kstage The residual of the converged stage, computed as V(U-Z)/(a dt)
+	 * \param[out] converged Whether the Newton iteration converged
+	 * \param[in,out] linits Total number of linear iterations, incremented by those used here
+	 * \return Non-zero if an error occurred in PETSc
+	 */
+	StatusCode solveStage(const a_real adt, const a_real *const z, const Vec kguess, Vec kstage,
+	                      bool& converged, int& linits);
+};
 
 }	// end namespace
 #endif
+
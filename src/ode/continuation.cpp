@@ -0,0 +1,136 @@
+/** @file continuation.cpp
+ * @brief Implementation of pseudo-time continuation policies
+ * @author Aditya Kashi
+ */
+
+#include <cmath>
+#include <algorithm>
+
+#include "continuation.hpp"
+#include "utilities/aoptionparser.hpp"
+#include "utilities/aerrorhandling.hpp"
+
+namespace fvens {
+
+ContinuationConfig parseContinuationConfig()
+{
+	ContinuationConfig cfg;
+	cfg.type = CONTINUATION_EXP_RAMP;
+	if(parsePetscCmd_isDefined("-pseudotime_continuation"))
+	{
+		const std::string type = parsePetscCmd_string("-pseudotime_continuation", 10);
+		if(type == "exp")
+			cfg.type = CONTINUATION_EXP_RAMP;
+		else if(type == "ser")
+			cfg.type = CONTINUATION_SER;
+		else if(type == "linear")
+			cfg.type = CONTINUATION_LINEAR;
+		else
+			fvens_throw(true, "Unknown type of pseudo-time continuation " + type);
+	}
+
+	cfg.rampup = parseOptionalPetscCmd_real("-cfl_ramp_exponent_up", 0.25);
+	cfg.rampdown = parseOptionalPetscCmd_real("-cfl_ramp_exponent_down", 0.3);
+	cfg.serexponent = parseOptionalPetscCmd_real("-ser_exponent", 1.0);
+
+	cfg.maxrejections = parsePetscCmd_isDefined("-pseudotime_max_rejections") ?
+		parsePetscCmd_int("-pseudotime_max_rejections") : 0;
+	cfg.rejectgrowth = parseOptionalPetscCmd_real("-pseudotime_reject_growth", 0.0);
+	cfg.cflcut = parseOptionalPetscCmd_real("-pseudotime_cfl_cut", 0.5);
+	cfg.cflrecovery = parseOptionalPetscCmd_real("-pseudotime_cfl_recovery", 1.2);
+
+	fvens_throw(cfg.maxrejections < 0, "Max number of rejected steps must be non-negative!");
+	fvens_throw(cfg.rejectgrowth != 0 && cfg.rejectgrowth <= 1.0,
+	            "Residual growth for rejecting a step must be greater than 1!");
+	fvens_throw(cfg.cflcut <= 0 || cfg.cflcut >= 1.0, "CFL cut factor must be in (0,1)!");
+	fvens_throw(cfg.cflrecovery < 1.0, "CFL recovery factor must be at least 1!");
+	return cfg;
+}
+
+PseudoTimeContinuation::PseudoTimeContinuation(const a_real cfl_min, const a_real cfl_max,
+                                               const ContinuationConfig& conf)
+	: cflmin{cfl_min}, cflmax{cfl_max}, config(conf), backoff{1.0}
+{ }
+
+a_real PseudoTimeContinuation::nextCFL(const int step, const a_real resiold, const a_real resi,
+                                       const a_real initres)
+{
+	const a_real cfl = computeCFL(step, resiold, resi, initres) * backoff;
+	backoff = std::min(1.0, backoff*config.cflrecovery);
+	return cfl;
+}
+
+bool PseudoTimeContinuation::toReject(const a_real resi, const a_real resiprev) const
+{
+	return !std::isfinite(resi) || (config.rejectgrowth > 0 && resi > config.rejectgrowth*resiprev);
+}
+
+a_real PseudoTimeContinuation::clampCFL(const a_real cfl) const
+{
+	return std::min(std::max(cfl, cflmin), cflmax);
+}
+
+ExpResidualRamp::ExpResidualRamp(const a_real cflmin, const a_real cflmax,
+                                 const ContinuationConfig& conf)
+	: PseudoTimeContinuation(cflmin, cflmax, conf), prevcfl{0}
+{ }
+
+a_real ExpResidualRamp::computeCFL(const int step, const a_real resiold, const a_real resi,
+                                   const a_real initres)
+{
+	const a_real resratio = resiold/resi;
+	const a_real newcfl = resratio > 1.0 ? prevcfl * std::pow(resratio, config.rampup)
+	                                     : prevcfl * std::pow(resratio, config.rampdown);
+	prevcfl = clampCFL(newcfl);
+	return prevcfl;
+}
+
+SERContinuation::SERContinuation(const a_real cflmin, const a_real cflmax,
+                                 const ContinuationConfig& conf)
+	: PseudoTimeContinuation(cflmin, cflmax, conf)
+{ }
+
+a_real SERContinuation::computeCFL(const int step, const a_real resiold, const a_real resi,
+                                   const a_real initres)
+{
+	if(step == 0)
+		return cflmin;
+	return clampCFL(cflmin * std::pow(initres/resi, config.serexponent));
+}
+
+LinearRamp::LinearRamp(const a_real cflmin, const a_real cflmax, const int rampstart,
+                       const int rampend, const ContinuationConfig& conf)
+	: PseudoTimeContinuation(cflmin, cflmax, conf), itstart{rampstart}, itend{rampend}
+{
+	fvens_throw(itend <= itstart && cflmax != cflmin,
+	            "A linear CFL ramp needs cfl_ramp_end greater than cfl_ramp_start!");
+}
+
+a_real LinearRamp::computeCFL(const int itcur, const a_real resiold, const a_real resi,
+                              const a_real initres)
+{
+	if(itcur < itstart)
+		return cflmin;
+	else if(itcur < itend) {
+		const a_real slopec = (cflmax-cflmin)/(itend-itstart);
+		return cflmin + slopec*(itcur-itstart);
+	}
+	else
+		return cflmax;
+}
+
+PseudoTimeContinuation *createContinuation(const a_real cflmin, const a_real cflmax,
+                                           const int rampstart, const int rampend,
+                                           const ContinuationConfig& conf)
+{
+	switch(conf.type) {
+	case CONTINUATION_SER:
+		return new SERContinuation(cflmin, cflmax, conf);
+	case CONTINUATION_LINEAR:
+		return new LinearRamp(cflmin, cflmax, rampstart, rampend, conf);
+	default:
+		return new ExpResidualRamp(cflmin, cflmax, conf);
+	}
+}
+
+}
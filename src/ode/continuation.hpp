@@ -0,0 +1,181 @@
+/** @file continuation.hpp
+ * @brief Policies for the evolution of the CFL number in pseudo-time continuation
+ * @author Aditya Kashi
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FVENS_CONTINUATION_H
+#define FVENS_CONTINUATION_H
+
+#include "aconstants.hpp"
+
+namespace fvens {
+
+/// The rule by which the CFL number of implicit pseudo-time steps is chosen
+enum ContinuationType {
+	CONTINUATION_EXP_RAMP,     ///< Powers of the ratio of successive residuals
+	CONTINUATION_SER,          ///< Switched evolution relaxation
+	CONTINUATION_LINEAR        ///< Linear ramp over a range of steps
+};
+
+/// Settings of pseudo-time continuation
+struct ContinuationConfig
+{
+	ContinuationType type;
+	a_real rampup;             ///< Exponent of the residual ratio when the residual decreases
+	a_real rampdown;           ///< Exponent of the residual ratio when the residual increases
+	a_real serexponent;        ///< Exponent of the residual reduction in SER
+
+	/// Max number of consecutive rejected steps; 0 means steps are never rejected
+	int maxrejections;
+	/// A step is rejected if the residual grows by more than this factor; it is always rejected
+	///  if the residual is not finite
+	a_real rejectgrowth;
+	a_real cflcut;             ///< Factor by which the CFL number is cut after a rejected step
+	/// Factor by which a cut CFL number recovers after every accepted step, up to the ramp's
+	a_real cflrecovery;
+};
+
+/// Reads the pseudo-time continuation settings from the PETSc options database
+/** The options are
+ *  - `-pseudotime_continuation` (`exp' (default), `ser' or `linear')
+ *  - `-cfl_ramp_exponent_up` (default 0.25) and `-cfl_ramp_exponent_down` (default 0.3)
+ *  - `-ser_exponent` (default 1)
+ *  - `-pseudotime_max_rejections` (default 0, ie., a diverged solve throws an exception)
+ *  - `-pseudotime_reject_growth` (default 0, meaning only non-finite residuals are rejected)
+ *  - `-pseudotime_cfl_cut` (default 0.5)
+ *  - `-pseudotime_cfl_recovery` (default 1.2)
+ */
+ContinuationConfig parseContinuationConfig();
+
+/// Chooses the CFL number of each implicit pseudo-time step
+/** Concrete policies compute a CFL number from the history of the residual. On top of that, the
+ * solver may reject a step whose residual has diverged, restore the previous state and call
+ * \ref reject; the CFL number given by the policy is then scaled by a back-off factor, which is
+ * cut on every rejection and recovers geometrically on accepted steps.
+ */
+class PseudoTimeContinuation
+{
+public:
+	/**
+	 * \param cflmin The smallest CFL number given by the policy, also the initial one
+	 * \param cflmax The largest CFL number
+	 * \param conf Settings
+	 */
+	PseudoTimeContinuation(const a_real cflmin, const a_real cflmax,
+	                       const ContinuationConfig& conf);
+
+	virtual ~PseudoTimeContinuation() { }
+
+	/// Returns the CFL number for the next step
+	/** \param step The number of the step, starting from 0
+	 * \param resiold The residual norm at the last-but-one accepted step
+	 * \param resi The residual norm at the last accepted step
+	 * \param initres The residual norm at the first step
+	 */
+	a_real nextCFL(const int step, const a_real resiold, const a_real resi, const a_real initres);
+
+	/// Cuts the CFL number after a step was rejected
+	void reject() { backoff *= config.cflcut; }
+
+	/// Whether a step with the given residual norm should be rejected
+	/** \param resi The residual norm of the step's starting state
+	 * \param resiprev The residual norm of the last accepted starting state
+	 */
+	bool toReject(const a_real resi, const a_real resiprev) const;
+
+protected:
+	const a_real cflmin;
+	const a_real cflmax;
+	const ContinuationConfig config;
+
+	/// Factor, at most 1, by which the policy's CFL number is scaled after rejected steps
+	a_real backoff;
+
+	/// The CFL number of the policy, without the back-off
+	virtual a_real computeCFL(const int step, const a_real resiold, const a_real resi,
+	                          const a_real initres) = 0;
+
+	/// Restricts a CFL number to [cflmin,cflmax]
+	a_real clampCFL(const a_real cfl) const;
+};
+
+/// Exponential ramping dependent on the ratio of the last two residuals
+/** \f$ CFL_{k+1} = CFL_k (r_{k-1}/r_k)^p \f$, where the exponent p differs for increasing
+ * and decreasing residuals.
+ */
+class ExpResidualRamp : public PseudoTimeContinuation
+{
+public:
+	ExpResidualRamp(const a_real cflmin, const a_real cflmax, const ContinuationConfig& conf);
+
+protected:
+	a_real computeCFL(const int step, const a_real resiold, const a_real resi,
+	                  const a_real initres);
+
+	a_real prevcfl;        ///< The last CFL number computed, without the back-off
+};
+
+/// Switched evolution relaxation (Mulder and Van Leer)
+/** \f$ CFL_k = CFL_{min} (r_0/r_k)^p \f$; the CFL number grows as the residual reduces
+ * relative to its initial value, independently of the CFL numbers used so far.
+ */
+class SERContinuation : public PseudoTimeContinuation
+{
+public:
+	SERContinuation(const a_real cflmin, const a_real cflmax, const ContinuationConfig& conf);
+
+protected:
+	a_real computeCFL(const int step, const a_real resiold, const a_real resi,
+	                  const a_real initres);
+};
+
+/// Linear CFL ramping from cflmin to cflmax between two steps
+class LinearRamp : public PseudoTimeContinuation
+{
+public:
+	/**
+	 * \param cflmin CFL number before step rampstart
+	 * \param cflmax CFL number after step rampend
+	 * \param rampstart Step at which ramping begins
+	 * \param rampend Step at which ramping ends; it must be greater than rampstart unless
+	 *   cflmin and cflmax are equal
+	 * \param conf Settings
+	 */
+	LinearRamp(const a_real cflmin, const a_real cflmax, const int rampstart, const int rampend,
+	           const ContinuationConfig& conf);
+
+protected:
+	a_real computeCFL(const int step, const a_real resiold, const a_real resi,
+	                  const a_real initres);
+
+	const int itstart;
+	const int itend;
+};
+
+/// Creates the continuation policy given in the settings
+/** \param cflmin Initial CFL number
+ * \param cflmax Final CFL number
+ * \param rampstart Step at which a linear ramp begins
+ * \param rampend Step at which a linear ramp ends
+ * \param conf Settings
+ */
+PseudoTimeContinuation *createContinuation(const a_real cflmin, const a_real cflmax,
+                                           const int rampstart, const int rampend,
+                                           const ContinuationConfig& conf);
+
+}
+#endif
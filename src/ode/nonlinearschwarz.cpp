@@ -0,0 +1,296 @@
+/** @file nonlinearschwarz.cpp
+ * @brief Implementation of nonlinear additive Schwarz for implicit pseudo-time steps
+ * @author Aditya Kashi
+ */
+
+#include <iostream>
+#include <cmath>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "nonlinearschwarz.hpp"
+#include "utilities/aoptionparser.hpp"
+#include "utilities/aerrorhandling.hpp"
+
+namespace fvens {
+
+NonlinearSchwarzConfig parseNonlinearSchwarzConfig()
+{
+	NonlinearSchwarzConfig cfg;
+	cfg.type = NLSCHWARZ_NONE;
+	if(parsePetscCmd_isDefined("-nonlinear_schwarz"))
+	{
+		const std::string type = parsePetscCmd_string("-nonlinear_schwarz", 10);
+		if(type == "nasm")
+			cfg.type = NLSCHWARZ_NASM;
+		else if(type == "aspin")
+			cfg.type = NLSCHWARZ_ASPIN;
+		else
+			fvens_throw(true, "Unknown type of nonlinear Schwarz " + type);
+	}
+
+#ifdef _OPENMP
+	cfg.subdomains.nsubdomains = omp_get_max_threads();
+#else
+	cfg.subdomains.nsubdomains = 1;
+#endif
+	PetscBool set = PETSC_FALSE;
+	PetscOptionsGetInt(NULL, NULL, "-nonlinear_schwarz_subdomains", &cfg.subdomains.nsubdomains,
+	                   &set);
+	cfg.subdomains.overlap = parsePetscCmd_isDefined("-nonlinear_schwarz_overlap") ?
+		parsePetscCmd_int("-nonlinear_schwarz_overlap") : 1;
+	cfg.localmaxits = parsePetscCmd_isDefined("-nonlinear_schwarz_local_max_its") ?
+		parsePetscCmd_int("-nonlinear_schwarz_local_max_its") : 3;
+	cfg.localrtol = parseOptionalPetscCmd_real("-nonlinear_schwarz_local_rtol", 1e-2);
+
+	fvens_throw(cfg.subdomains.nsubdomains < 1,
+	            "Number of nonlinear Schwarz sub-domains must be positive!");
+	fvens_throw(cfg.subdomains.overlap < 0,
+	            "Overlap of nonlinear Schwarz sub-domains must be non-negative!");
+	fvens_throw(cfg.localmaxits < 1, "Nonlinear Schwarz needs at least one local iteration!");
+	return cfg;
+}
+
+/// Matrix-vector product of the shell matrix of the preconditioned ASPIN operator
+template <int nvars>
+static StatusCode aspin_apply(Mat op, Vec x, Vec y)
+{
+	StatusCode ierr = 0;
+	NonlinearSchwarz<nvars> *nls;
+	ierr = MatShellGetContext(op, (void*)&nls); CHKERRQ(ierr);
+	ierr = nls->applyPreconditionedOperator(x,y); CHKERRQ(ierr);
+	return ierr;
+}
+
+template <int nvars>
+NonlinearSchwarz<nvars>::NonlinearSchwarz(const Spatial<a_real,nvars> *const spatial, const Vec x,
+                                          const NonlinearSchwarzConfig& conf)
+	: space{spatial}, config(conf), sdsolver(spatial->mesh(), conf.subdomains, "nls_sub_"),
+	  cvec{NULL}, work{NULL}, aspinop{NULL}, aspinksp{NULL}, curA{NULL},
+	  nlocalits{0}, nlocalres{0}
+{
+	fvens_throw(config.type == NLSCHWARZ_NONE, "Nonlinear Schwarz type not given!");
+
+	const int nsd = sdsolver.numSubdomains();
+	const MeshSubdomains& sd = sdsolver.subdomains();
+	stencils.resize(nsd);
+#pragma omp parallel for default(shared) schedule(dynamic,1)
+	for(int isd = 0; isd < nsd; isd++)
+		stencils[isd] = buildLocalStencil(*spatial->mesh(), &sd.cells[sd.starts[isd]],
+		                                  sd.starts[isd+1]-sd.starts[isd],
+		                                  spatial->localStencilLayers());
+
+	if(config.type == NLSCHWARZ_ASPIN)
+	{
+		MPI_Comm comm;
+		StatusCode ierr = PetscObjectGetComm((PetscObject)x, &comm);
+		petsc_throw(ierr, "Could not get communicator");
+		ierr = VecDuplicate(x, &cvec); petsc_throw(ierr, "Could not create correction vector");
+		ierr = VecDuplicate(x, &work); petsc_throw(ierr, "Could not create work vector");
+
+		PetscInt locsize, globsize;
+		ierr = VecGetLocalSize(x, &locsize); petsc_throw(ierr, "Could not get vector size");
+		ierr = VecGetSize(x, &globsize); petsc_throw(ierr, "Could not get vector size");
+		ierr = MatCreate(comm, &aspinop); petsc_throw(ierr, "Could not create ASPIN operator");
+		ierr = MatSetSizes(aspinop, locsize, locsize, globsize, globsize);
+		petsc_throw(ierr, "Could not set ASPIN operator sizes");
+		ierr = MatSetType(aspinop, MATSHELL);
+		petsc_throw(ierr, "Could not set ASPIN operator type");
+		ierr = MatShellSetContext(aspinop, (void*)this);
+		petsc_throw(ierr, "Could not set ASPIN operator context");
+		ierr = MatShellSetOperation(aspinop, MATOP_MULT, (void(*)(void))&aspin_apply<nvars>);
+		petsc_throw(ierr, "Could not set ASPIN operator product");
+		ierr = MatSetUp(aspinop); petsc_throw(ierr, "Could not set up ASPIN operator");
+
+		ierr = KSPCreate(comm, &aspinksp); petsc_throw(ierr, "Could not create ASPIN solver");
+		ierr = KSPSetType(aspinksp, KSPGMRES); petsc_throw(ierr, "Could not set ASPIN solver type");
+		ierr = KSPSetOperators(aspinksp, aspinop, aspinop);
+		petsc_throw(ierr, "Could not set ASPIN solver operators");
+		PC pc;
+		ierr = KSPGetPC(aspinksp, &pc); petsc_throw(ierr, "Could not get ASPIN PC");
+		ierr = PCSetType(pc, PCNONE); petsc_throw(ierr, "Could not set ASPIN PC type");
+		ierr = KSPSetOptionsPrefix(aspinksp, "aspin_");
+		petsc_throw(ierr, "Could not set ASPIN options prefix");
+		ierr = KSPSetFromOptions(aspinksp); petsc_throw(ierr, "Could not set ASPIN solver options");
+	}
+
+	std::cout << " NonlinearSchwarz: " << (config.type == NLSCHWARZ_ASPIN ? "ASPIN" : "NASM")
+	          << ", at most " << config.localmaxits << " local iterations to relative tolerance "
+	          << config.localrtol << std::endl;
+}
+
+template <int nvars>
+NonlinearSchwarz<nvars>::~NonlinearSchwarz()
+{
+	int ierr = 0;
+	if(config.type == NLSCHWARZ_ASPIN) {
+		ierr += KSPDestroy(&aspinksp);
+		ierr += MatDestroy(&aspinop);
+		ierr += VecDestroy(&cvec);
+		ierr += VecDestroy(&work);
+	}
+	if(ierr)
+		std::cout << "! NonlinearSchwarz: Could not destroy work storage!\n";
+}
+
+template <int nvars>
+StatusCode NonlinearSchwarz<nvars>::setup(Mat M)
+{
+	return sdsolver.setup(M);
+}
+
+template <int nvars>
+StatusCode NonlinearSchwarz<nvars>::applyPreconditionedOperator(const Vec x, Vec y) const
+{
+	StatusCode ierr = 0;
+	ierr = MatMult(curA, x, work); CHKERRQ(ierr);
+	ierr = sdsolver.apply(work, y); CHKERRQ(ierr);
+	return ierr;
+}
+
+template <int nvars>
+StatusCode NonlinearSchwarz<nvars>::solveLocalProblem(const int isd, const a_real *const u,
+                                                      const a_real *const r,
+                                                      const std::vector<a_real>& diag,
+                                                      a_real *const c,
+                                                      int *const nits, int *const nres)
+{
+	StatusCode ierr = 0;
+	const MeshSubdomains& sd = sdsolver.subdomains();
+	const a_int start = sd.starts[isd];
+	const a_int ncells = sd.starts[isd+1] - start;
+	const a_int *const cells = &sd.cells[start];
+
+	// local rows of G, the local Newton update and the accumulated local correction
+	std::vector<a_real> g(ncells*nvars), dz(ncells*nvars), dc(ncells*nvars, 0);
+	// the local state and its residual
+	std::vector<a_real> ul(ncells*nvars), rl(ncells*nvars);
+
+	// G at u^n; the residual array r holds -r(u^n), as computed by assemble_residual
+	a_real g0norm = 0;
+	for(a_int i = 0; i < ncells; i++)
+		for(int j = 0; j < nvars; j++) {
+			g[i*nvars+j] = r[cells[i]*nvars+j];
+			g0norm += g[i*nvars+j]*g[i*nvars+j];
+		}
+	g0norm = std::sqrt(g0norm);
+
+	*nits = 0; *nres = 0;
+	a_real gnorm = g0norm;
+	while(gnorm > config.localrtol*g0norm)
+	{
+		// the local linear solves use PETSc, which may only be called concurrently if thread-safe
+		if(sdsolver.isThreaded()) {
+			ierr = sdsolver.solveLocal(isd, g.data(), dz.data());
+		}
+		else {
+#pragma omp critical (nonlinearschwarz_local_solve)
+			ierr = sdsolver.solveLocal(isd, g.data(), dz.data());
+		}
+		CHKERRQ(ierr);
+		(*nits)++;
+		for(a_int i = 0; i < ncells*nvars; i++)
+			dc[i] += dz[i];
+
+		if(*nits >= config.localmaxits)
+			break;
+
+		for(a_int i = 0; i < ncells; i++)
+			for(int j = 0; j < nvars; j++)
+				ul[i*nvars+j] = u[cells[i]*nvars+j] + dc[i*nvars+j];
+
+		ierr = space->compute_local_residual(stencils[isd], u, ul.data(), rl.data());
+		CHKERRQ(ierr);
+		(*nres)++;
+
+		// the pseudo-time term, including the preconditioning matrix at u^n if any
+		a_real newnorm = 0;
+		for(a_int i = 0; i < ncells; i++)
+		{
+			a_real pdc[nvars];
+			if(space->hasPseudoTimePreconditioner())
+				space->applyPseudoTimePreconditioner(&u[cells[i]*nvars], true, &dc[i*nvars], pdc);
+			else
+				for(int j = 0; j < nvars; j++)
+					pdc[j] = dc[i*nvars+j];
+
+			for(int j = 0; j < nvars; j++) {
+				g[i*nvars+j] = rl[i*nvars+j] - diag[cells[i]]*pdc[j];
+				newnorm += g[i*nvars+j]*g[i*nvars+j];
+			}
+		}
+		newnorm = std::sqrt(newnorm);
+
+		// the chord iteration is diverging; keep the previous iterate
+		if(!std::isfinite(newnorm) || newnorm > gnorm) {
+			for(a_int i = 0; i < ncells*nvars; i++)
+				dc[i] -= dz[i];
+			break;
+		}
+		gnorm = newnorm;
+	}
+
+	// restricted: only the owned cells' corrections are written
+	for(a_int i = 0; i < ncells; i++)
+	{
+		const a_int iel = cells[i];
+		if(iel < sd.ownedstarts[isd] || iel >= sd.ownedstarts[isd+1])
+			continue;
+		for(int j = 0; j < nvars; j++)
+			c[iel*nvars+j] = dc[i*nvars+j];
+	}
+	return ierr;
+}
+
+template <int nvars>
+StatusCode NonlinearSchwarz<nvars>::computeUpdate(Mat A, KSP ksp, const Vec uvec, const Vec rvec,
+                                                  const std::vector<a_real>& diag, Vec duvec,
+                                                  int *const linits)
+{
+	StatusCode ierr = 0;
+	const int nsd = sdsolver.numSubdomains();
+	curA = A;
+	const Vec corr = config.type == NLSCHWARZ_ASPIN ? cvec : duvec;
+
+	const a_real *uarr, *rarr;
+	a_real *carr;
+	ierr = VecGetArrayRead(uvec, &uarr); CHKERRQ(ierr);
+	ierr = VecGetArrayRead(rvec, &rarr); CHKERRQ(ierr);
+	ierr = VecGetArray(corr, &carr); CHKERRQ(ierr);
+
+	std::vector<StatusCode> errs(nsd, 0);
+	std::vector<int> nits(nsd, 0), nres(nsd, 0);
+	// the local residuals are always computed concurrently; only the local linear solves are
+	//  serialized if PETSc is not thread-safe
+#pragma omp parallel for default(shared) schedule(dynamic,1)
+	for(int isd = 0; isd < nsd; isd++)
+		errs[isd] = solveLocalProblem(isd, uarr, rarr, diag, carr, &nits[isd], &nres[isd]);
+
+	ierr = VecRestoreArray(corr, &carr); CHKERRQ(ierr);
+	ierr = VecRestoreArrayRead(rvec, &rarr); CHKERRQ(ierr);
+	ierr = VecRestoreArrayRead(uvec, &uarr); CHKERRQ(ierr);
+	for(int isd = 0; isd < nsd; isd++) {
+		CHKERRQ(errs[isd]);
+		nlocalits += nits[isd];
+		nlocalres += nres[isd];
+	}
+
+	*linits = 0;
+	if(config.type == NLSCHWARZ_ASPIN)
+	{
+		PetscReal rtol, abstol, dtol;
+		PetscInt maxits;
+		ierr = KSPGetTolerances(ksp, &rtol, &abstol, &dtol, &maxits); CHKERRQ(ierr);
+		ierr = KSPSetTolerances(aspinksp, rtol, abstol, dtol, maxits); CHKERRQ(ierr);
+		ierr = KSPSolve(aspinksp, cvec, duvec); CHKERRQ(ierr);
+		ierr = KSPGetIterationNumber(aspinksp, linits); CHKERRQ(ierr);
+	}
+	return ierr;
+}
+
+template class NonlinearSchwarz<NVARS>;
+template class NonlinearSchwarz<1>;
+template class NonlinearSchwarz<NVARS+1>;
+
+}
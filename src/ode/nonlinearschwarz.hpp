@@ -0,0 +1,162 @@
+/** @file nonlinearschwarz.hpp
+ * @brief Nonlinear additive Schwarz preconditioning of implicit pseudo-time steps
+ * @author Aditya Kashi
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FVENS_NONLINEARSCHWARZ_H
+#define FVENS_NONLINEARSCHWARZ_H
+
+#include <vector>
+#include <petscksp.h>
+
+#include "aconstants.hpp"
+#include "spatial/aspatial.hpp"
+#include "linalg/subdomainpc.hpp"
+
+namespace fvens {
+
+/// How the local corrections of nonlinear Schwarz are used in a pseudo-time step
+enum NonlinearSchwarzType {
+	NLSCHWARZ_NONE,        ///< Nonlinear Schwarz is not used
+	NLSCHWARZ_NASM,        ///< The combined local corrections are the update
+	NLSCHWARZ_ASPIN        ///< A Newton-Krylov step on the nonlinearly preconditioned system
+};
+
+/// Settings of nonlinear Schwarz
+struct NonlinearSchwarzConfig
+{
+	NonlinearSchwarzType type;
+	SubdomainPCConfig subdomains;  ///< Number and overlap of the sub-domains
+	int localmaxits;               ///< Max Newton iterations of each local problem
+	a_real localrtol;              ///< Relative tolerance of the local problems
+};
+
+/// Reads the nonlinear Schwarz settings from the PETSc options database
+/** The options are
+ *  - `-nonlinear_schwarz` (`nasm' or `aspin'; if not given, nonlinear Schwarz is not used)
+ *  - `-nonlinear_schwarz_subdomains` (default: the number of OpenMP threads)
+ *  - `-nonlinear_schwarz_overlap` (default 1)
+ *  - `-nonlinear_schwarz_local_max_its` (default 3)
+ *  - `-nonlinear_schwarz_local_rtol` (default 1e-2)
+ */
+NonlinearSchwarzConfig parseNonlinearSchwarzConfig();
+
+/// Nonlinear restricted additive Schwarz for a backward Euler pseudo-time step
+/** A backward Euler step from \f$ u^n \f$ needs the solution of the nonlinear system
+ * \f[ G(u) := \frac{V}{\Delta\tau} (u - u^n) - r(u) = 0 \f]
+ * where r is the residual as assembled by \ref Spatial::assemble_residual. Usually, one Newton
+ * iteration with the Jacobian \f$ A = \frac{V}{\Delta\tau} + J(u^n) \f$ is done. Here, instead, the
+ * rows of G belonging to the cells of each overlapping sub-domain (see \ref partitionSubdomains)
+ * are solved for the states of those cells, the rest being held fixed at \f$ u^n \f$. The local
+ * problems are independent and are solved concurrently on OpenMP threads, so stiff local
+ * non-linearity (shocks, separation) is resolved within a sub-domain without holding back the
+ * global iteration. Each local problem is solved by a few chord-Newton iterations with its block
+ * of A, extracted with MatCreateSubMatrices by a \ref SubdomainPreconditioner whose solvers have
+ * the options prefix "nls_sub_". Each sub-domain's correction is kept only at the cells it owns.
+ *
+ * With NASM, the combined correction is the update of the pseudo-time step. With ASPIN, the
+ * update \f$ \delta \f$ is the solution of the Newton system of the preconditioned function,
+ * \f[ P^{-1} A \delta = c, \f]
+ * where c is the combined correction and \f$ P^{-1} \f$ the restricted additive Schwarz
+ * preconditioner made of the same sub-domain solvers. This is solved by its own KSP with the
+ * options prefix "aspin_" (GMRES by default) with the tolerances of the main solver.
+ *
+ * The local residuals are computed by \ref Spatial::compute_local_residual on a stencil of each
+ * sub-domain, made of its cells and the layers of neighbours the discretization needs, so that a
+ * local iteration only visits the sub-domain and its halo, in work arrays of their size. Concurrent
+ * use of PETSc objects requires PETSc to be configured with `--with-threadsafety'; otherwise, the
+ * sub-domains are processed one after the other.
+ */
+template <int nvars>
+class NonlinearSchwarz
+{
+public:
+	/// Partitions the mesh and creates the local solvers
+	/** \param spatial The spatial discretization
+	 * \param x A global vector with the layout of the solution
+	 * \param config Settings; the type must not be \ref NLSCHWARZ_NONE
+	 */
+	NonlinearSchwarz(const Spatial<a_real,nvars> *const spatial, const Vec x,
+	                 const NonlinearSchwarzConfig& config);
+
+	~NonlinearSchwarz();
+
+	/// Sets up the local solvers from the matrix of the pseudo-time step
+	/** \param M The assembled matrix \f$ \frac{V}{\Delta\tau} + J \f$
+	 */
+	StatusCode setup(Mat M);
+
+	/// Computes the update of a pseudo-time step
+	/** \param[in] A The operator of the pseudo-time step, used only by ASPIN
+	 * \param[in] ksp The main solver, whose tolerances are used by ASPIN
+	 * \param[in] u The state \f$ u^n \f$ at the beginning of the step
+	 * \param[in] r The residual at u, as computed by \ref Spatial::assemble_residual; it must not
+	 *   re-use any cached parts, since it is combined with exact local residuals
+	 * \param[in] diag The pseudo-time term \f$ V/\Delta\tau \f$ of each cell; with a preconditioned
+	 *   pseudo-time derivative (\ref Spatial::hasPseudoTimePreconditioner), it multiplies the
+	 *   inverse preconditioning matrix at u
+	 * \param[out] du The update
+	 * \param[out] linits Number of Krylov iterations of the outer ASPIN solve, or zero for NASM
+	 */
+	StatusCode computeUpdate(Mat A, KSP ksp, const Vec u, const Vec r,
+	                         const std::vector<a_real>& diag, Vec du, int *const linits);
+
+	/// Applies the preconditioned ASPIN operator \f$ P^{-1}A \f$ of the current step
+	StatusCode applyPreconditionedOperator(const Vec x, Vec y) const;
+
+	/// Total number of local Newton iterations over all steps and sub-domains
+	long numLocalIterations() const { return nlocalits; }
+
+	/// Total number of local residual evaluations over all steps and sub-domains
+	long numLocalResidualEvaluations() const { return nlocalres; }
+
+protected:
+	const Spatial<a_real,nvars> *const space;
+	const NonlinearSchwarzConfig config;
+
+	/// Holds the sub-domains and their linear solvers
+	SubdomainPreconditioner sdsolver;
+
+	/// The cells of each sub-domain with their neighbours, for the local residuals
+	std::vector<LocalStencil> stencils;
+
+	/// The combined correction, used by ASPIN
+	Vec cvec;
+	/// Work vector of the ASPIN operator
+	Vec work;
+	/// The preconditioned operator of ASPIN
+	Mat aspinop;
+	/// The outer solver of ASPIN
+	KSP aspinksp;
+
+	/// The operator of the pseudo-time step in the current call to computeUpdate
+	Mat curA;
+
+	long nlocalits;
+	long nlocalres;
+
+	/// Solves the local problem of one sub-domain and writes its owned part of the correction
+	/** \param[out] nits Number of local Newton iterations done
+	 * \param[out] nres Number of local residual evaluations done
+	 */
+	StatusCode solveLocalProblem(const int isd, const a_real *const u, const a_real *const r,
+	                             const std::vector<a_real>& diag, a_real *const c,
+	                             int *const nits, int *const nres);
+};
+
+}
+#endif
@@ -300,6 +300,43 @@ public:
 	void getJacobianThermCondWrtConservedFromJacobianSutherViscWrtConserved(
 			const scalar *const dmuhat, scalar *const __restrict dkhat) const;
 
+	/** \name Batch conversions
+	 * These convert many states at a time, looping over the states in a way that allows the
+	 * compiler to vectorize across states. The states are stored one after the other with a
+	 * fixed stride (at least NVARS) between the starts of consecutive states, as in the rows of a
+	 * row-major array of states; only the first NVARS entries of each state are accessed.
+	 * Conversions between state vectors may be done in place. Scalar outputs are contiguous.
+	 * \param[in] n Number of states
+	 * \param[in] stride Distance between the starts of consecutive states
+	 */
+	///@{
+
+	/// Computes primitive variables from conserved variables for many states
+	void getPrimitiveFromConservedBatch(const a_int n, const int stride,
+			const scalar *const uc, scalar *const up) const;
+
+	/// Computes conserved variables from primitive variables for many states
+	void getConservedFromPrimitiveBatch(const a_int n, const int stride,
+			const scalar *const up, scalar *const uc) const;
+
+	/// Computes pressures from conserved variables for many states
+	void getPressureFromConservedBatch(const a_int n, const int stride,
+			const scalar *const uc, scalar *const __restrict p) const;
+
+	/// Computes temperatures from conserved variables for many states
+	void getTemperatureFromConservedBatch(const a_int n, const int stride,
+			const scalar *const uc, scalar *const __restrict T) const;
+
+	/// Computes speeds of sound from conserved variables for many states
+	void getSoundSpeedFromConservedBatch(const a_int n, const int stride,
+			const scalar *const uc, scalar *const __restrict c) const;
+
+	/// Computes Sutherland viscosity coefficients from conserved variables for many states
+	void getViscosityCoeffFromConservedBatch(const a_int n, const int stride,
+			const scalar *const uc, scalar *const __restrict mu) const;
+
+	///@}
+
 	/// Computes the stress tensor using gradients of primitive variables
 	/** Can also use gradients of primitive-2 variables - it only uses velocity gradients.
 	 * The result is assigned to the output array stress, so prior contents are lost.
@@ -705,7 +742,8 @@ template <typename scalar>
 inline
 scalar IdealGasPhysics<scalar>::getViscosityCoeffFromTemperature(const scalar T) const
 {
-	return (1.0+sC/Tinf)/(T+sC/Tinf) * std::pow(T,1.5) / Reinf;
+	// T^1.5 as T*sqrt(T), which is much cheaper than pow
+	return (1.0+sC/Tinf)/(T+sC/Tinf) * T*std::sqrt(T) / Reinf;
 }
 
 template <typename scalar>
@@ -726,13 +764,80 @@ void IdealGasPhysics<scalar>::getJacobianSutherlandViscosityWrtConserved(const s
 	getJacobianTemperatureWrtConserved(uc, dT);
 
 	const scalar coef = (1.0+sC/Tinf)/Reinf;
-	const scalar T15 = std::pow(T,1.5), Tm15 = std::pow(T,-1.5);
+	const scalar T15 = T*std::sqrt(T), Tm15 = 1.0/T15;
 	const scalar denom = (T + sC/Tinf)*(T+sC/Tinf);
 	// coef * pow(T,1.5) / (T + sC/Tinf)
 	for(int i = 0; i < NVARS; i++)
 		dmu[i] += coef* (1.5*Tm15*dT[i]*(T+sC/Tinf) - T15*dT[i])/denom;
 }
 
+template <typename scalar>
+inline
+void IdealGasPhysics<scalar>::getPrimitiveFromConservedBatch(const a_int n, const int stride,
+		const scalar *const uc, scalar *const up) const
+{
+#pragma omp simd
+	for(a_int i = 0; i < n; i++)
+		getPrimitiveFromConserved(&uc[i*stride], &up[i*stride]);
+}
+
+template <typename scalar>
+inline
+void IdealGasPhysics<scalar>::getConservedFromPrimitiveBatch(const a_int n, const int stride,
+		const scalar *const up, scalar *const uc) const
+{
+#pragma omp simd
+	for(a_int i = 0; i < n; i++)
+		getConservedFromPrimitive(&up[i*stride], &uc[i*stride]);
+}
+
+template <typename scalar>
+inline
+void IdealGasPhysics<scalar>::getPressureFromConservedBatch(const a_int n, const int stride,
+		const scalar *const uc, scalar *const __restrict p) const
+{
+#pragma omp simd
+	for(a_int i = 0; i < n; i++)
+		p[i] = getPressureFromConserved(&uc[i*stride]);
+}
+
+template <typename scalar>
+inline
+void IdealGasPhysics<scalar>::getTemperatureFromConservedBatch(const a_int n, const int stride,
+		const scalar *const uc, scalar *const __restrict T) const
+{
+#pragma omp simd
+	for(a_int i = 0; i < n; i++)
+		T[i] = getTemperatureFromConserved(&uc[i*stride]);
+}
+
+template <typename scalar>
+inline
+void IdealGasPhysics<scalar>::getSoundSpeedFromConservedBatch(const a_int n, const int stride,
+		const scalar *const uc, scalar *const __restrict c) const
+{
+#pragma omp simd
+	for(a_int i = 0; i < n; i++)
+		c[i] = getSoundSpeedFromConserved(&uc[i*stride]);
+}
+
+/** The constants of Sutherland's law are hoisted out of the loop, so that each state needs one
+ * square root and one division.
+ */
+template <typename scalar>
+inline
+void IdealGasPhysics<scalar>::getViscosityCoeffFromConservedBatch(const a_int n, const int stride,
+		const scalar *const uc, scalar *const __restrict mu) const
+{
+	const scalar coef = (1.0+sC/Tinf)/Reinf;
+	const scalar sct = sC/Tinf;
+#pragma omp simd
+	for(a_int i = 0; i < n; i++) {
+		const scalar T = getTemperatureFromConserved(&uc[i*stride]);
+		mu[i] = coef * T*std::sqrt(T) / (T+sct);
+	}
+}
+
 template <typename scalar>
 inline
 scalar IdealGasPhysics<scalar>::getConstantViscosityCoeff() const {
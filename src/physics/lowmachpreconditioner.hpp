@@ -0,0 +1,129 @@
+/** \file lowmachpreconditioner.hpp
+ * \brief Low-Mach preconditioning of the inviscid flux dissipation and the pseudo-time derivative
+ * \author Aditya Kashi
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FVENS_LOWMACHPRECONDITIONER_H
+#define FVENS_LOWMACHPRECONDITIONER_H
+
+#include <cmath>
+#include <algorithm>
+#include "aconstants.hpp"
+
+namespace fvens {
+
+/// Weiss-Smith (Turkel-type) low-Mach preconditioning of the Euler equations
+/** In the variables \f$ w = (p, v_n, v_t, s) \f$, where \f$ ds = d\rho - dp/c^2 \f$, the
+ * preconditioning matrix is \f$ \mathrm{diag}(\theta,1,1,1) \f$ with \f$ \theta = \beta^2/c^2 \f$;
+ * only the pressure equation is scaled. The reference velocity is
+ * \f[ \beta^2 = \min(\max(|v|^2, K^2 |v_\infty|^2), c^2), \f]
+ * where the cut-off K keeps the preconditioning bounded near stagnation points. Velocities are
+ * non-dimensionalized by the free-stream speed, so \f$ |v_\infty| = 1 \f$. At supersonic speeds,
+ * \f$ \theta = 1 \f$ and there is no preconditioning. The preconditioned acoustic wave speeds are
+ * \f$ u' \pm c' \f$ with
+ * \f[ u' = \frac12 (1+\theta) v_n, \quad c' = \frac12 \sqrt{(1-\theta)^2 v_n^2 + 4\beta^2}, \f]
+ * which scale with the flow speed rather than the speed of sound as the Mach number goes to zero.
+ *
+ * In conserved variables, the preconditioning matrix is \f$ P = I + (\theta-1) a b^T \f$, where
+ * \f$ a = [1, v_x, v_y, H, Y_k]^T/c^2 \f$ is the change in the conserved variables due to a unit
+ * change in pressure at constant entropy, velocity and passive scalars \f$ Y_k \f$, and
+ * \f$ b = \partial p/\partial u = (\gamma-1) [|v|^2/2, -v_x, -v_y, 1, 0]^T \f$. As \f$ b^T a = 1 \f$,
+ * \f$ P^{-1} = I + (1/\theta-1) a b^T \f$.
+ */
+class LowMachPreconditioner
+{
+public:
+	/// Set the constants
+	/** \param gamma Adiabatic index
+	 * \param cutoff The cut-off K of the reference velocity relative to the free-stream speed
+	 */
+	LowMachPreconditioner(const a_real gamma, const a_real cutoff)
+		: g{gamma}, cut2{cutoff*cutoff}
+	{ }
+
+	/// Returns the square of the reference velocity \f$ \beta \f$
+	/** \param vmag2 Square of the velocity magnitude
+	 * \param c Speed of sound
+	 */
+	template <typename scalar>
+	scalar getReferenceVelocity2(const scalar vmag2, const scalar c) const
+	{
+		return std::min(std::max(vmag2, static_cast<scalar>(cut2)), c*c);
+	}
+
+	/// Computes the preconditioned acoustic wave speeds \f$ u' \pm c' \f$
+	/** \param vn Normal velocity
+	 * \param c Speed of sound
+	 * \param beta2 Square of the reference velocity
+	 * \param[out] up The convective part \f$ u' \f$
+	 * \param[out] cp The acoustic part \f$ c' \f$
+	 */
+	template <typename scalar>
+	static void getWaveSpeeds(const scalar vn, const scalar c, const scalar beta2,
+	                          scalar& up, scalar& cp)
+	{
+		const scalar theta = beta2/(c*c);
+		up = 0.5*vn*(1.0+theta);
+		cp = 0.5*std::sqrt(vn*vn*(1.0-theta)*(1.0-theta) + 4.0*beta2);
+	}
+
+	/// Returns the spectral radius \f$ |u'| + c' \f$ of the preconditioned normal flux Jacobian
+	template <typename scalar>
+	scalar getSpectralRadius(const scalar vn, const scalar vmag2, const scalar c) const
+	{
+		scalar up, cp;
+		getWaveSpeeds(vn, c, getReferenceVelocity2(vmag2, c), up, cp);
+		return std::fabs(up) + cp;
+	}
+
+	/// Computes the preconditioning matrix, or its inverse, at a state
+	/** \param u Conserved variables; any beyond the first NVARS are passive scalars
+	 * \param inverse If true, \f$ P^{-1} \f$ is computed, otherwise P
+	 * \param[out] mat The nvars x nvars matrix in row-major order; it is assigned to.
+	 */
+	template <typename scalar, int nvars>
+	void getMatrix(const scalar *const u, const bool inverse, scalar *const mat) const
+	{
+		const scalar vx = u[1]/u[0], vy = u[2]/u[0];
+		const scalar vmag2 = vx*vx + vy*vy;
+		const scalar p = (g-1.0)*(u[3] - 0.5*u[0]*vmag2);
+		const scalar c2 = g*p/u[0];
+		const scalar H = (u[3]+p)/u[0];
+
+		const scalar theta = getReferenceVelocity2(vmag2, std::sqrt(c2))/c2;
+		const scalar fac = inverse ? 1.0/theta - 1.0 : theta - 1.0;
+
+		scalar a[nvars], b[nvars];
+		a[0] = 1.0/c2; a[1] = vx/c2; a[2] = vy/c2; a[3] = H/c2;
+		b[0] = 0.5*(g-1.0)*vmag2; b[1] = -(g-1.0)*vx; b[2] = -(g-1.0)*vy; b[3] = g-1.0;
+		for(int k = NVARS; k < nvars; k++) {
+			a[k] = u[k]/(u[0]*c2);
+			b[k] = 0;
+		}
+
+		for(int i = 0; i < nvars; i++)
+			for(int j = 0; j < nvars; j++)
+				mat[i*nvars+j] = (i == j ? 1.0 : 0.0) + fac*a[i]*b[j];
+	}
+
+protected:
+	const a_real g;          ///< Adiabatic index
+	const a_real cut2;       ///< Square of the cut-off of the reference velocity
+};
+
+}
+#endif
@@ -0,0 +1,120 @@
+/** \file saturbulence.hpp
+ * \brief Closure functions and source terms of the Spalart-Allmaras turbulence model
+ * \author Aditya Kashi
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FVENS_SATURBULENCE_H
+#define FVENS_SATURBULENCE_H
+
+#include <cmath>
+#include <algorithm>
+#include "aconstants.hpp"
+
+namespace fvens {
+
+/// The 'negative' Spalart-Allmaras one-equation model without the trip term (SA-neg-noft2)
+/** The transported variable is the working variable \f$ \tilde{\nu} \f$, conserved as
+ * \f$ \rho \tilde{\nu} \f$ (see Allmaras, Johnson and Spalart, ICCFD7-1902, 2012):
+ * \f[
+ * \partial_t (\rho\tilde{\nu}) + \nabla\cdot(\rho\mathbf{v}\tilde{\nu})
+ *   = \frac{1}{\sigma}\left[\nabla\cdot((\mu+\rho\tilde{\nu}f_n)\nabla\tilde{\nu})
+ *     + c_{b2}\rho|\nabla\tilde{\nu}|^2\right] + \rho(P - D).
+ * \f]
+ * All quantities are non-dimensional as in IdealGasPhysics; in particular, the molecular
+ * viscosity includes the factor 1/Re, so the model's form is unchanged. The negative branch keeps
+ * the model well-posed when \f$ \tilde{\nu} \f$ undershoots below zero during the nonlinear
+ * iterations; the eddy viscosity is zero there.
+ */
+template <typename scalar>
+class SpalartAllmaras
+{
+public:
+	const a_real cb1 = 0.1355;
+	const a_real cb2 = 0.622;
+	const a_real sigma = 2.0/3.0;
+	const a_real kappa = 0.41;
+	const a_real cw1 = cb1/(kappa*kappa) + (1.0+cb2)/sigma;
+	const a_real cw2 = 0.3;
+	const a_real cw3 = 2.0;
+	const a_real cv1 = 7.1;
+	const a_real cv2 = 0.7;
+	const a_real cv3 = 0.9;
+	const a_real ct3 = 1.2;
+	const a_real cn1 = 16.0;
+	/// Turbulent Prandtl number, for the eddy thermal conductivity
+	const a_real Prt = 0.9;
+
+	/// Eddy viscosity from density, working variable and molecular viscosity
+	scalar eddyViscosity(const scalar rho, const scalar nut, const scalar mu) const {
+		if(nut <= 0)
+			return 0;
+		const scalar chi3 = std::pow(rho*nut/mu, 3);
+		return rho*nut*chi3/(chi3 + cv1*cv1*cv1);
+	}
+
+	/// Diffusivity of the working variable, including the factor 1/sigma
+	scalar diffusivity(const scalar rho, const scalar nut, const scalar mu) const {
+		if(nut >= 0)
+			return (mu + rho*nut)/sigma;
+		const scalar chi3 = std::pow(rho*nut/mu, 3);
+		return (mu + rho*nut*(cn1+chi3)/(cn1-chi3))/sigma;
+	}
+
+	/// Source term per unit volume, ie., production minus destruction plus the cb2 term
+	/** \param[in] rho Density
+	 * \param[in] nut Working variable
+	 * \param[in] mu Molecular viscosity
+	 * \param[in] vort Magnitude of vorticity
+	 * \param[in] d Distance from the nearest wall
+	 * \param[in] gradnut2 Square of the magnitude of the gradient of the working variable
+	 * \param[out] dsrc An approximation of the derivative of the source w.r.t. density times the
+	 *   working variable which is never positive, for use in an approximate Jacobian. Only
+	 *   the destruction term is differentiated, with its closure functions frozen.
+	 */
+	scalar source(const scalar rho, const scalar nut, const scalar mu, const scalar vort,
+	              const scalar d, const scalar gradnut2, scalar& dsrc) const
+	{
+		const scalar diffusion = cb2/sigma*rho*gradnut2;
+		const scalar d2 = d*d;
+
+		if(nut < 0) {
+			dsrc = 2.0*cw1*nut/d2;
+			return rho*(cb1*(1.0-ct3)*vort*nut + cw1*nut*nut/d2) + diffusion;
+		}
+
+		const scalar chi = rho*nut/mu;
+		const scalar chi3 = chi*chi*chi;
+		const scalar fv1 = chi3/(chi3 + cv1*cv1*cv1);
+		const scalar fv2 = 1.0 - chi/(1.0 + chi*fv1);
+		const scalar sbar = nut*fv2/(kappa*kappa*d2);
+
+		// modified vorticity, limited so that it stays positive
+		const scalar stilde = sbar >= -cv2*vort ? vort + sbar
+			: vort + vort*(cv2*cv2*vort + cv3*sbar)/((cv3-2.0*cv2)*vort - sbar);
+
+		const scalar r = stilde > 0 ? std::min(nut/(stilde*kappa*kappa*d2), scalar(10.0)) : 10.0;
+		const scalar g = r + cw2*(std::pow(r,6) - r);
+		const scalar cw36 = std::pow(cw3,6);
+		const scalar fw = g*std::pow((1.0+cw36)/(std::pow(g,6)+cw36), 1.0/6.0);
+
+		dsrc = -2.0*cw1*fw*nut/d2;
+		return rho*(cb1*stilde*nut - cw1*fw*nut*nut/d2) + diffusion;
+	}
+};
+
+}
+#endif
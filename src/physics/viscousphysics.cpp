@@ -63,24 +63,21 @@ void getPrimitive2StatesAndGradients(const IdealGasPhysics<scalar>& physics,
 	}
 }
 
-template<typename scalar, int ndim, int nvars, bool constVisc>
+template<typename scalar, int ndim, int nvars>
 void computeViscousFlux(const IdealGasPhysics<scalar>& physics, const scalar *const n,
                         const scalar grad[ndim][nvars],
                         const scalar *const ul, const scalar *const ur,
+                        const scalar mulamRe, const scalar mutRe, const scalar ktRe,
                         scalar *const __restrict vflux)
 {
 	static_assert(ndim == NDIM, "3D not implemented yet.");
 	static_assert(nvars == ndim+2, "Only single-phase ideal gas is supported.");
 	
 	// Non-dimensional dynamic viscosity divided by free-stream Reynolds number
-	const scalar muRe = constVisc ? 
-			physics.getConstantViscosityCoeff() 
-		:
-			0.5*( physics.getViscosityCoeffFromConserved(ul)
-			+ physics.getViscosityCoeffFromConserved(ur) );
+	const scalar muRe = mulamRe + mutRe;
 	
 	// Non-dimensional thermal conductivity
-	const scalar kdiff = physics.getThermalConductivityFromViscosity(muRe); 
+	const scalar kdiff = physics.getThermalConductivityFromViscosity(mulamRe) + ktRe;
 
 	scalar stress[ndim][ndim];
 	for(int i = 0; i < ndim; i++)
@@ -255,17 +252,12 @@ getPrimitive2StatesAndGradients<double,NDIM,false>(const IdealGasPhysics<double>
                                                    double *const gradtl, double *const gradtr);
 
 template void
-computeViscousFlux<double,NDIM,NVARS,true>(const IdealGasPhysics<double>& physics,
-                                           const double *const n,
-                                           const double grad[NDIM][NVARS],
-                                           const double *const ul, const double *const ur,
-                                           double *const __restrict vflux);
-template void
-computeViscousFlux<double,NDIM,NVARS,false>(const IdealGasPhysics<double>& physics,
-                                           const double *const n,
-                                           const double grad[NDIM][NVARS],
-                                           const double *const ul, const double *const ur,
-                                           double *const __restrict vflux);
+computeViscousFlux<double,NDIM,NVARS>(const IdealGasPhysics<double>& physics,
+                                      const double *const n,
+                                      const double grad[NDIM][NVARS],
+                                      const double *const ul, const double *const ur,
+                                      const double mulamRe, const double mutRe, const double ktRe,
+                                      double *const __restrict vflux);
 
 template void
 computeViscousFluxJacobian<double,NDIM,NVARS,true>(const IdealGasPhysics<double>& jphy,
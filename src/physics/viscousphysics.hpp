@@ -49,12 +49,18 @@ void getPrimitive2StatesAndGradients(const IdealGasPhysics<scalar>& physics,
  * \param[in] grad Unique gradients of primitive 2 variables at the face quadrature point
  * \param[in] ul Left state of faces (conserved variables)
  * \param[in] ul Right state of faces (conserved variables)
+ * \param[in] mulamRe Non-dimensional laminar viscosity coefficient (divided by Reynolds number)
+ *   at the face, usually the average of those of the left and right states
+ * \param[in] mutRe Non-dimensional eddy viscosity (divided by Reynolds number) at the face;
+ *   zero for laminar flow
+ * \param[in] ktRe Non-dimensional eddy thermal conductivity at the face; zero for laminar flow
  * \param[in,out] vflux On output, contains the viscous flux across the face
  */
-template<typename scalar, int ndim, int nvars, bool constVisc>
+template<typename scalar, int ndim, int nvars>
 void computeViscousFlux(const IdealGasPhysics<scalar>& physics, const scalar *const n,
                         const scalar grad[ndim][nvars],
                         const scalar *const ul, const scalar *const ur,
+                        const scalar mulamRe, const scalar mutRe, const scalar ktRe,
                         scalar *const __restrict vflux);
 
 /// Computes the Jacobians of the viscous flux w.r.t. left and right cell-centered states
@@ -0,0 +1,186 @@
+/** \file activeset.cpp
+ * \brief Implementation of active-set tracking for residual evaluation
+ * \author Aditya Kashi
+ */
+
+#include <cmath>
+#include <algorithm>
+#include "activeset.hpp"
+#include "utilities/aoptionparser.hpp"
+
+namespace fvens {
+
+ActiveSetConfig parseActiveSetConfig(const std::string prefix, const int deflayers,
+                                     const int defrefresh)
+{
+	ActiveSetConfig config;
+	config.enabled = parsePetscCmd_isDefined(prefix+"_threshold");
+	config.threshold = parseOptionalPetscCmd_real(prefix+"_threshold", 0.0);
+	config.layers = parsePetscCmd_isDefined(prefix+"_layers") ?
+		parsePetscCmd_int(prefix+"_layers") : deflayers;
+	config.refreshinterval = parsePetscCmd_isDefined(prefix+"_refresh_interval") ?
+		parsePetscCmd_int(prefix+"_refresh_interval") : defrefresh;
+	if(config.refreshinterval < 1)
+		config.refreshinterval = 1;
+	return config;
+}
+
+template <typename scalar, int nvars>
+ActiveSet<scalar,nvars>::ActiveSet(const UMesh2dh<scalar> *const mesh,
+                                   const ActiveSetConfig& config)
+	: m{mesh}, cfg(config), ncalls{0}, ntotalcalls{0}, ntotalactive{0}, nactive{0}, fullrefresh{true},
+	  uref(m->gnelem()*nvars), cellactive(m->gnelem()), cellwork(m->gnelem()),
+	  faceactive(m->gnaface())
+{ }
+
+template <typename scalar, int nvars>
+ActiveSetResidual<scalar,nvars>::ActiveSetResidual(const UMesh2dh<scalar> *const mesh,
+                                                   const ActiveSetConfig& config)
+	: ActiveSet<scalar,nvars>(mesh, config),
+	  fluxes(m->gnaface()*nvars), specrads(m->gnaface()*2),
+	  recmark(m->gnelem()), gradmark(m->gnelem())
+{ }
+
+template <typename scalar, int nvars>
+ActiveSetJacobian<scalar,nvars>::ActiveSetJacobian(const UMesh2dh<scalar> *const mesh,
+                                                   const ActiveSetConfig& config)
+	: ActiveSet<scalar,nvars>(mesh, config), blocks(m->gnaface()*2*nvars*nvars)
+{ }
+
+template <typename scalar, int nvars>
+void ActiveSet<scalar,nvars>::markActiveFaces(const scalar *const u)
+{
+	fullrefresh = (ncalls % cfg.refreshinterval == 0);
+	ncalls++;
+	ntotalcalls++;
+
+	if(fullrefresh)
+	{
+#pragma omp parallel default(shared)
+		{
+#pragma omp for
+			for(a_int i = 0; i < m->gnelem()*nvars; i++)
+				uref[i] = u[i];
+#pragma omp for
+			for(a_int iface = 0; iface < m->gnaface(); iface++)
+				faceactive[iface] = 1;
+		}
+		nactive = m->gnaface();
+		ntotalactive += nactive;
+		return;
+	}
+
+	a_int nact = 0;
+
+#pragma omp parallel default(shared)
+	{
+		// find changed cells
+#pragma omp for
+		for(a_int iel = 0; iel < m->gnelem(); iel++)
+		{
+			scalar diff = 0, mag = 0;
+			for(int i = 0; i < nvars; i++) {
+				diff = std::max(diff, std::abs(u[iel*nvars+i]-uref[iel*nvars+i]));
+				mag = std::max(mag, std::abs(uref[iel*nvars+i]));
+			}
+
+			cellactive[iel] = diff > cfg.threshold*mag ? 1 : 0;
+			if(cellactive[iel])
+				for(int i = 0; i < nvars; i++)
+					uref[iel*nvars+i] = u[iel*nvars+i];
+		}
+
+		// mark layers of neighbours
+		for(int ilayer = 0; ilayer < cfg.layers; ilayer++)
+		{
+#pragma omp for
+			for(a_int iel = 0; iel < m->gnelem(); iel++)
+			{
+				char active = cellactive[iel];
+				for(int jface = 0; jface < m->gnfael(iel); jface++) {
+					const a_int nbr = m->gesuel(iel,jface);
+					if(nbr < m->gnelem())
+						active = active || cellactive[nbr];
+				}
+				cellwork[iel] = active;
+			}
+#pragma omp for
+			for(a_int iel = 0; iel < m->gnelem(); iel++)
+				cellactive[iel] = cellwork[iel];
+		}
+
+#pragma omp for reduction(+:nact)
+		for(a_int iface = 0; iface < m->gnaface(); iface++)
+		{
+			const a_int relem = m->gintfac(iface,1);
+			faceactive[iface] = cellactive[m->gintfac(iface,0)]
+				|| (relem < m->gnelem() && cellactive[relem]);
+			nact += faceactive[iface];
+		}
+	}
+
+	nactive = nact;
+	ntotalactive += nactive;
+}
+
+template <typename scalar, int nvars>
+void ActiveSetResidual<scalar,nvars>::markActiveStencil(const scalar *const u)
+{
+	this->markActiveFaces(u);
+	actfaces.clear();
+	reccells.clear();
+	gradcells.clear();
+	if(fullrefresh)
+		return;
+
+#pragma omp parallel default(shared)
+	{
+#pragma omp for
+		for(a_int iel = 0; iel < m->gnelem(); iel++)
+		{
+			char rec = 0;
+			for(int jface = 0; jface < m->gnfael(iel); jface++)
+				rec = rec || faceactive[m->gelemface(iel,jface)];
+			recmark[iel] = rec;
+		}
+
+#pragma omp for
+		for(a_int iel = 0; iel < m->gnelem(); iel++)
+		{
+			char grad = recmark[iel];
+			for(int jface = 0; jface < m->gnfael(iel); jface++) {
+				const a_int nbr = m->gesuel(iel,jface);
+				if(nbr < m->gnelem())
+					grad = grad || recmark[nbr];
+			}
+			gradmark[iel] = grad;
+		}
+	}
+
+	for(a_int iface = 0; iface < m->gnaface(); iface++)
+		if(faceactive[iface])
+			actfaces.push_back(iface);
+	for(a_int iel = 0; iel < m->gnelem(); iel++) {
+		if(recmark[iel])
+			reccells.push_back(iel);
+		if(gradmark[iel])
+			gradcells.push_back(iel);
+	}
+}
+
+template <typename scalar, int nvars>
+double ActiveSet<scalar,nvars>::activeFraction() const
+{
+	if(ntotalcalls == 0)
+		return 1.0;
+	return static_cast<double>(ntotalactive)/(static_cast<double>(ntotalcalls)*m->gnaface());
+}
+
+template class ActiveSet<a_real,NVARS>;
+template class ActiveSetResidual<a_real,NVARS>;
+template class ActiveSetJacobian<a_real,NVARS>;
+template class ActiveSet<a_real,NVARS+1>;
+template class ActiveSetResidual<a_real,NVARS+1>;
+template class ActiveSetJacobian<a_real,NVARS+1>;
+
+}
@@ -0,0 +1,195 @@
+/** \file activeset.hpp
+ * \brief Re-use of face fluxes and Jacobian blocks in converged regions during pseudo-time
+ *   iterations
+ * \author Aditya Kashi
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FVENS_ACTIVESET_H
+#define FVENS_ACTIVESET_H
+
+#include <vector>
+#include <string>
+#include "mesh/amesh2dh.hpp"
+
+namespace fvens {
+
+/// Settings of active-set residual evaluation
+struct ActiveSetConfig
+{
+	bool enabled;              ///< Whether face fluxes are re-used at all
+	a_real threshold;          ///< Relative change in a cell's state beyond which it is 'changed'
+	int layers;                ///< Number of layers of neighbours around changed cells also marked
+	int refreshinterval;       ///< Number of evaluations after which all faces are recomputed
+};
+
+/// Reads active-set settings from the PETSc options database
+/** The active set is enabled by giving `<prefix>_threshold' (real). The other options are
+ * `<prefix>_layers' and `<prefix>_refresh_interval'.
+ * \param prefix The prefix of the options, including the leading '-', eg. "-active_set"
+ * \param deflayers Default number of layers
+ * \param defrefresh Default refresh interval
+ */
+ActiveSetConfig parseActiveSetConfig(const std::string prefix, const int deflayers,
+                                     const int defrefresh);
+
+/// Tracks which cells' states have changed since quantities depending on them were last computed
+/** Before each evaluation, the state of each cell is compared with the state at which the
+ * quantities of its faces were last computed (its reference state). If the max-norm of the
+ * difference, relative to the max-norm of the reference state, exceeds the threshold, the cell is
+ * 'changed' and its reference state is updated. The changed cells and a given number of layers of
+ * their neighbours are then 'active'. Faces with an active cell on either side are active.
+ *
+ * The reference states are only updated for changed cells, so slow drifts are detected as soon as
+ * they accumulate beyond the threshold. Every few evaluations, all faces are marked active.
+ */
+template <typename scalar, int nvars>
+class ActiveSet
+{
+public:
+	ActiveSet(const UMesh2dh<scalar> *const mesh, const ActiveSetConfig& config);
+
+	/// Determines the active faces for a new evaluation at state u
+	/** Must be called once before each evaluation that uses the active set.
+	 * \param u The cell-centred conserved variables, stored row-major (cell-wise)
+	 */
+	void markActiveFaces(const scalar *const u);
+
+	/// Whether all faces are active in the current evaluation because of a periodic refresh
+	bool isFullRefresh() const { return fullrefresh; }
+
+	/// Whether quantities of a face are to be recomputed in the current evaluation
+	bool isFaceActive(const a_int iface) const { return faceactive[iface]; }
+
+	/// Number of faces being recomputed in the current evaluation
+	a_int numActiveFaces() const { return nactive; }
+
+	/// Fraction of all face evaluations so far that were actually computed
+	double activeFraction() const;
+
+	/// Forgets the reference states, so that the next evaluation is a full refresh
+	/** To be called when the quantities cached by the caller are no longer those computed by
+	 * the previous evaluations, eg. at the start of a new solve.
+	 */
+	void reset() { ncalls = 0; }
+
+protected:
+	const UMesh2dh<scalar> *const m;
+	const ActiveSetConfig cfg;
+
+	/// Number of evaluations since construction or the last reset
+	long ncalls;
+	/// Number of evaluations so far
+	long ntotalcalls;
+	/// Total number of active faces so far
+	long ntotalactive;
+	/// Number of active faces in the current evaluation
+	a_int nactive;
+	/// Whether the current evaluation is a full refresh
+	bool fullrefresh;
+
+	/// Reference state of each cell
+	std::vector<scalar> uref;
+	/// Marker of active cells
+	std::vector<char> cellactive;
+	/// Work array for expanding the active cells
+	std::vector<char> cellwork;
+	/// Marker of active faces
+	std::vector<char> faceactive;
+};
+
+/// Active set along with a cache of face fluxes, for residual evaluation
+/** Only the fluxes of active faces are recomputed, the rest are taken from the cache. Since the
+ * face values depend on cell-centred gradients and limiters, which depend on neighbouring cells,
+ * two layers are needed for second-order schemes to re-compute every face whose stencil includes a
+ * changed cell.
+ *
+ * Apart from a full refresh, face values are only reconstructed in the cells having an active
+ * face, and gradients only computed in those cells and their neighbours. The states at the other
+ * faces are not needed, since their fluxes and spectral radii are cached.
+ */
+template <typename scalar, int nvars>
+class ActiveSetResidual : public ActiveSet<scalar,nvars>
+{
+public:
+	ActiveSetResidual(const UMesh2dh<scalar> *const mesh, const ActiveSetConfig& config);
+
+	/// Determines the active faces for a new evaluation at state u and the cells they depend on
+	/** To be called instead of \ref markActiveFaces. Unless the evaluation is a full refresh, lists
+	 * the active faces, the cells with an active face (whose face values are needed) and those
+	 * cells along with their face neighbours (whose gradients are needed).
+	 * \param u The cell-centred conserved variables, stored row-major (cell-wise)
+	 */
+	void markActiveStencil(const scalar *const u);
+
+	/// The active faces of the current evaluation, if it is not a full refresh
+	const std::vector<a_int>& activeFaces() const { return actfaces; }
+
+	/// Cells with an active face in the current evaluation, if it is not a full refresh
+	const std::vector<a_int>& reconstructionCells() const { return reccells; }
+
+	/// Cells whose gradients are needed in the current evaluation, if it is not a full refresh
+	const std::vector<a_int>& gradientCells() const { return gradcells; }
+
+	/// Cached flux of a face (integrated over the face)
+	scalar *faceFlux(const a_int iface) { return &fluxes[iface*nvars]; }
+
+	/// Cached integrated spectral radii of a face on the left (0) and right (1) sides
+	scalar& faceSpectralRadius(const a_int iface, const int side) {
+		return specrads[iface*2+side];
+	}
+
+protected:
+	using ActiveSet<scalar,nvars>::m;
+	using ActiveSet<scalar,nvars>::fullrefresh;
+	using ActiveSet<scalar,nvars>::faceactive;
+
+	std::vector<scalar> fluxes;
+	std::vector<scalar> specrads;
+
+	/// Markers of cells whose face values and gradients are needed
+	std::vector<char> recmark, gradmark;
+	std::vector<a_int> actfaces;
+	std::vector<a_int> reccells;
+	std::vector<a_int> gradcells;
+};
+
+/// Active set along with a cache of the Jacobian blocks of each face, for incremental assembly
+/** The Jacobian blocks of a face only depend on the states of its two cells, so no layers of
+ * neighbours are needed. The blocks are stored row-major, as passed to PETSc.
+ */
+template <typename scalar, int nvars>
+class ActiveSetJacobian : public ActiveSet<scalar,nvars>
+{
+public:
+	ActiveSetJacobian(const UMesh2dh<scalar> *const mesh, const ActiveSetConfig& config);
+
+	/// For a boundary face, its contribution to the diagonal block of its cell; for an interior
+	/// face, its lower block (in the row of the right cell and the column of the left cell)
+	a_real *lowerBlock(const a_int iface) { return &blocks[iface*2*nvars*nvars]; }
+
+	/// For an interior face, its upper block (in the row of the left cell and the column of the
+	/// right cell)
+	a_real *upperBlock(const a_int iface) { return &blocks[(iface*2+1)*nvars*nvars]; }
+
+protected:
+	using ActiveSet<scalar,nvars>::m;
+
+	std::vector<a_real> blocks;
+};
+
+}
+#endif
@@ -12,8 +12,9 @@ namespace fvens
 
 template<typename scalar, int nvars>
 GradientScheme<scalar,nvars>::GradientScheme(const UMesh2dh<scalar> *const mesh, 
-		const amat::Array2d<scalar>& _rc)
-	: m{mesh}, rc{_rc}
+		const amat::Array2d<scalar>& _rc, const FaceLoopSchedule<scalar> *const loops)
+	: m{mesh}, rc{_rc}, atomicloops(mesh, FACELOOP_ATOMIC, 1),
+	  faceloops{loops ? loops : &atomicloops}
 { }
 
 template<typename scalar, int nvars>
@@ -22,8 +23,8 @@ GradientScheme<scalar,nvars>::~GradientScheme()
 
 template<typename scalar, int nvars>
 ZeroGradients<scalar,nvars>::ZeroGradients(const UMesh2dh<scalar> *const mesh, 
-		const amat::Array2d<scalar>& _rc)
-	: GradientScheme<scalar,nvars>(mesh, _rc)
+		const amat::Array2d<scalar>& _rc, const FaceLoopSchedule<scalar> *const loops)
+	: GradientScheme<scalar,nvars>(mesh, _rc, loops)
 { }
 
 template<typename scalar, int nvars>
@@ -41,13 +42,42 @@ void ZeroGradients<scalar,nvars>::compute_gradients(
 	}
 }
 
+template<typename scalar, int nvars>
+void ZeroGradients<scalar,nvars>::compute_cell_gradient(const a_int iel,
+		const scalar *const ucell, const scalar *const *const unbrs,
+		Eigen::Array<scalar,NDIM,nvars>& grad) const
+{
+	grad = Eigen::Array<scalar,NDIM,nvars>::Zero();
+}
+
 template<typename scalar, int nvars>
 GreenGaussGradients<scalar,nvars>::GreenGaussGradients(const UMesh2dh<scalar> *const mesh, 
-		const amat::Array2d<scalar>& _rc)
-	: GradientScheme<scalar,nvars>(mesh, _rc)
-{ }
+		const amat::Array2d<scalar>& _rc, const FaceLoopSchedule<scalar> *const loops)
+	: GradientScheme<scalar,nvars>(mesh, _rc, loops), leftweights(mesh->gnaface())
+{
+	// For boundary faces, the right cell is the ghost cell.
+#pragma omp parallel for default(shared)
+	for(a_int iface = 0; iface < m->gnaface(); iface++)
+	{
+		const a_int ielem = m->gintfac(iface,0);
+		const a_int jelem = m->gintfac(iface,1);
+		const a_int ip1 = m->gintfac(iface,2);
+		const a_int ip2 = m->gintfac(iface,3);
+		scalar dL = 0, dR = 0, mid[NDIM];
+		for(int idim = 0; idim < NDIM; idim++)
+		{
+			mid[idim] = (m->gcoords(ip1,idim) + m->gcoords(ip2,idim)) * 0.5;
+			dL += (mid[idim]-rc(ielem,idim))*(mid[idim]-rc(ielem,idim));
+			dR += (mid[idim]-rc(jelem,idim))*(mid[idim]-rc(jelem,idim));
+		}
+		dL = 1.0/sqrt(dL);
+		dR = 1.0/sqrt(dR);
+		leftweights[iface] = dL/(dL+dR);
+	}
+}
 
-/* The state at the face is approximated as an inverse-distance-weighted average.
+/* The state at the face is approximated as an inverse-distance-weighted average, whose weights are
+ * precomputed so that the face loop needs no more of the mesh than the face data.
  */
 template<typename scalar, int nvars>
 void GreenGaussGradients<scalar,nvars>::compute_gradients(
@@ -55,85 +85,72 @@ void GreenGaussGradients<scalar,nvars>::compute_gradients(
 		const amat::Array2d<scalar>& ug, 
 		GradArray<scalar,nvars>& grad ) const
 {
-#pragma omp parallel default(shared)
+#pragma omp parallel for default(shared)
+	for(a_int iel = 0; iel < m->gnelem(); iel++)
 	{
-#pragma omp for
-		for(a_int iel = 0; iel < m->gnelem(); iel++)
-		{
-			for(int j = 0; j < NDIM; j++)
-				for(int i = 0; i < nvars; i++)
-					grad[iel](j,i) = 0;
-		}
-		
-#pragma omp for
-		for(a_int iface = 0; iface < m->gnbface(); iface++)
+		for(int j = 0; j < NDIM; j++)
+			for(int i = 0; i < nvars; i++)
+				grad[iel](j,i) = 0;
+	}
+
+	// For boundary faces, the right state is the ghost state.
+	faceloops->executeWithFaceData([&](const auto& faces, const a_int iface, const bool updleft,
+	                                   const bool updright, const bool atomic)
+	{
+		const bool isbound = iface < m->gnbface();
+		const a_int ielem = faces.leftCell(iface);
+		const a_int jelem = faces.rightCell(iface);
+		const scalar wL = leftweights[iface];
+		const scalar areainv1 = 1.0/m->garea(ielem);
+		const scalar areainv2 = isbound ? 0 : 1.0/m->garea(jelem);
+
+		for(int ivar = 0; ivar < nvars; ivar++)
 		{
-			scalar areainv1;
-			scalar ut[nvars];
-			scalar dL, dR, mid[NDIM];
-		
-			const a_int ielem = m->gintfac(iface,0);
-			const a_int jelem = m->gintfac(iface,1);   // ghost cell index
-			const a_int ip1 = m->gintfac(iface,2);
-			const a_int ip2 = m->gintfac(iface,3);
-			dL = 0; dR = 0;
+			const scalar ur = isbound ? ug(iface,ivar) : u(jelem,ivar);
+			const scalar ut = (u(ielem,ivar)*wL + ur*(1.0-wL)) * faces.length(iface);
+
 			for(int idim = 0; idim < NDIM; idim++)
 			{
-				mid[idim] = (m->gcoords(ip1,idim) + m->gcoords(ip2,idim)) * 0.5;
-				dL += (mid[idim]-rc(ielem,idim))*(mid[idim]-rc(ielem,idim));
-				dR += (mid[idim]-rc(jelem,idim))*(mid[idim]-rc(jelem,idim));
-			}
-			dL = 1.0/sqrt(dL);
-			dR = 1.0/sqrt(dR);
-			areainv1 = 1.0/m->garea(ielem);
-			
-			for(int ivar = 0; ivar < nvars; ivar++)
-			{
-				ut[ivar]= (u(ielem,ivar)*dL + ug(iface,ivar)*dR)/(dL+dR) * m->gfacemetric(iface,2);
-
-				for(int idim = 0; idim < NDIM; idim++)
-					grad[ielem](idim,ivar) += (ut[ivar] * m->gfacemetric(iface,idim))*areainv1;
+				if(updleft)
+					faceLoopUpdate(grad[ielem](idim,ivar),
+					               (ut * faces.normal(iface,idim))*areainv1, atomic);
+				if(updright && !isbound)
+					faceLoopUpdate(grad[jelem](idim,ivar),
+					               -(ut * faces.normal(iface,idim))*areainv2, atomic);
 			}
 		}
+	});
+}
+
+template<typename scalar, int nvars>
+void GreenGaussGradients<scalar,nvars>::compute_cell_gradient(const a_int iel,
+		const scalar *const ucell, const scalar *const *const unbrs,
+		Eigen::Array<scalar,NDIM,nvars>& grad) const
+{
+	grad = Eigen::Array<scalar,NDIM,nvars>::Zero();
+	const scalar areainv = 1.0/m->garea(iel);
 
-#pragma omp for
-		for(a_int iface = m->gnbface(); iface < m->gnaface(); iface++)
+	faceloops->withFaceData([&](const auto& faces)
+	{
+		for(int jface = 0; jface < m->gnfael(iel); jface++)
 		{
-			a_int ielem, jelem, ip1, ip2;
-			scalar areainv1, areainv2;
-			scalar ut[nvars];
-			scalar dL, dR, mid[NDIM];
-		
-			ielem = m->gintfac(iface,0);
-			jelem = m->gintfac(iface,1);
-			ip1 = m->gintfac(iface,2);
-			ip2 = m->gintfac(iface,3);
-			dL = 0; dR = 0;
-			for(int idim = 0; idim < NDIM; idim++)
-			{
-				mid[idim] = (m->gcoords(ip1,idim) + m->gcoords(ip2,idim)) * 0.5;
-				dL += (mid[idim]-rc(ielem,idim))*(mid[idim]-rc(ielem,idim));
-				dR += (mid[idim]-rc(jelem,idim))*(mid[idim]-rc(jelem,idim));
-			}
-			dL = 1.0/sqrt(dL);
-			dR = 1.0/sqrt(dR);
-			areainv1 = 1.0/m->garea(ielem);
-			areainv2 = 1.0/m->garea(jelem);
-			
+			const a_int iface = m->gelemface(iel,jface);
+			const bool isleft = faces.leftCell(iface) == iel;
+			const scalar wL = leftweights[iface];
+
+			// the outward normal of this cell
+			const scalar sign = isleft ? 1.0 : -1.0;
+			const scalar *const ul = isleft ? ucell : unbrs[jface];
+			const scalar *const ur = isleft ? unbrs[jface] : ucell;
+
 			for(int ivar = 0; ivar < nvars; ivar++)
 			{
-				ut[ivar] = (u(ielem,ivar)*dL + u(jelem,ivar)*dR)/(dL+dR) * m->gfacemetric(iface,2);
-
+				const scalar ut = (ul[ivar]*wL + ur[ivar]*(1.0-wL)) * faces.length(iface);
 				for(int idim = 0; idim < NDIM; idim++)
-				{
-#pragma omp atomic update
-					grad[ielem](idim,ivar) += (ut[ivar] * m->gfacemetric(iface,idim))*areainv1;
-#pragma omp atomic update
-					grad[jelem](idim,ivar) -= (ut[ivar] * m->gfacemetric(iface,idim))*areainv2;
-				}
+					grad(idim,ivar) += sign*(ut * faces.normal(iface,idim))*areainv;
 			}
 		}
-	} // end parallel region
+	});
 }
 
 /** An inverse-distance weighted least-squares is used.
@@ -141,8 +158,8 @@ void GreenGaussGradients<scalar,nvars>::compute_gradients(
 template<typename scalar, int nvars>
 WeightedLeastSquaresGradients<scalar,nvars>::WeightedLeastSquaresGradients(
 		const UMesh2dh<scalar> *const mesh, 
-		const amat::Array2d<scalar>& _rc)
-	: GradientScheme<scalar,nvars>(mesh, _rc)
+		const amat::Array2d<scalar>& _rc, const FaceLoopSchedule<scalar> *const loops)
+	: GradientScheme<scalar,nvars>(mesh, _rc, loops)
 { 
 	V.resize(m->gnelem());
 #pragma omp parallel for default(shared)
@@ -153,28 +170,8 @@ WeightedLeastSquaresGradients<scalar,nvars>::WeightedLeastSquaresGradients(
 
 	// compute LHS of least-squares problem
 
-#pragma omp parallel for default(shared)
-	for(a_int iface = 0; iface < m->gnbface(); iface++)
-	{
-		const a_int ielem = m->gintfac(iface,0);
-		const a_int jelem = m->gintfac(iface,1);
-		scalar w2 = 0, dr[NDIM];
-		for(short idim = 0; idim < NDIM; idim++)
-		{
-			w2 += (rc(ielem,idim)-rc(jelem,idim))*(rc(ielem,idim)-rc(jelem,idim));
-			dr[idim] = rc(ielem,idim)-rc(jelem,idim);
-		}
-		w2 = 1.0/(w2);
-		
-		for(int i = 0; i<NDIM; i++)
-			for(int j = 0; j < NDIM; j++) {
-#pragma omp atomic update
-				V[ielem](i,j) += w2*dr[i]*dr[j];
-			}
-	}
-
-#pragma omp parallel for default(shared)
-	for(a_int iface = m->gnbface(); iface < m->gnaface(); iface++)
+	faceloops->execute([&](const a_int iface, const bool updleft, const bool updright,
+	                       const bool atomic)
 	{
 		const a_int ielem = m->gintfac(iface,0);
 		const a_int jelem = m->gintfac(iface,1);
@@ -185,15 +182,15 @@ WeightedLeastSquaresGradients<scalar,nvars>::WeightedLeastSquaresGradients(
 			dr[idim] = rc(ielem,idim)-rc(jelem,idim);
 		}
 		w2 = 1.0/(w2);
-		
+
 		for(int i = 0; i<NDIM; i++)
 			for(int j = 0; j < NDIM; j++) {
-#pragma omp atomic update
-				V[ielem](i,j) += w2*dr[i]*dr[j];
-#pragma omp atomic update
-				V[jelem](i,j) += w2*dr[i]*dr[j];
+				if(updleft)
+					faceLoopUpdate(V[ielem](i,j), w2*dr[i]*dr[j], atomic);
+				if(updright && iface >= m->gnbface())
+					faceLoopUpdate(V[jelem](i,j), w2*dr[i]*dr[j], atomic);
 			}
-	}
+	});
 
 #pragma omp parallel for default(shared)
 	for(a_int ielem = 0; ielem < m->gnelem(); ielem++)
@@ -221,56 +218,33 @@ void WeightedLeastSquaresGradients<scalar,nvars>::compute_gradients(
 	
 	// compute least-squares RHS
 
-#pragma omp parallel for default(shared)
-	for(a_int iface = 0; iface < m->gnbface(); iface++)
+	faceloops->executeWithFaceData([&](const auto& faces, const a_int iface, const bool updleft,
+	                                   const bool updright, const bool atomic)
 	{
-		const a_int ielem = m->gintfac(iface,0);
-		const a_int jelem = m->gintfac(iface,1);
+		const bool isbound = iface < m->gnbface();
+		const a_int ielem = faces.leftCell(iface);
+		const a_int jelem = faces.rightCell(iface);
 		scalar w2 = 0, dr[NDIM], du[nvars];
-		for(short idim = 0; idim < NDIM; idim++)
+		for(int idim = 0; idim < NDIM; idim++)
 		{
 			w2 += (rc(ielem,idim)-rc(jelem,idim))*(rc(ielem,idim)-rc(jelem,idim));
 			dr[idim] = rc(ielem,idim)-rc(jelem,idim);
 		}
 		w2 = 1.0/(w2);
-		
-		for(short ivar = 0; ivar < nvars; ivar++)
-			du[ivar] = u(ielem,ivar) - ug(iface,ivar);
-		
-		for(short ivar = 0; ivar < nvars; ivar++)
-		{
-			for(int jdim = 0; jdim < NDIM; jdim++)
-#pragma omp atomic update
-				f[ielem](jdim,ivar) += w2*dr[jdim]*du[ivar];
-		}
-	}
 
-#pragma omp parallel for default(shared)
-	for(a_int iface = m->gnbface(); iface < m->gnaface(); iface++)
-	{
-		a_int ielem = m->gintfac(iface,0);
-		a_int jelem = m->gintfac(iface,1);
-		scalar w2 = 0, dr[NDIM], du[nvars];
-		for(short idim = 0; idim < NDIM; idim++)
-		{
-			w2 += (rc(ielem,idim)-rc(jelem,idim))*(rc(ielem,idim)-rc(jelem,idim));
-			dr[idim] = rc(ielem,idim)-rc(jelem,idim);
-		}
-		w2 = 1.0/(w2);
-		
-		for(short ivar = 0; ivar < nvars; ivar++)
-			du[ivar] = u(ielem,ivar) - u(jelem,ivar);
+		for(int ivar = 0; ivar < nvars; ivar++)
+			du[ivar] = u(ielem,ivar) - (isbound ? ug(iface,ivar) : u(jelem,ivar));
 
-		for(short ivar = 0; ivar < nvars; ivar++)
+		for(int ivar = 0; ivar < nvars; ivar++)
 		{
 			for(int jdim = 0; jdim < NDIM; jdim++) {
-#pragma omp atomic update
-				f[ielem](jdim,ivar) += w2*dr[jdim]*du[ivar];
-#pragma omp atomic update
-				f[jelem](jdim,ivar) += w2*dr[jdim]*du[ivar];
+				if(updleft)
+					faceLoopUpdate(f[ielem](jdim,ivar), w2*dr[jdim]*du[ivar], atomic);
+				if(updright && !isbound)
+					faceLoopUpdate(f[jelem](jdim,ivar), w2*dr[jdim]*du[ivar], atomic);
 			}
 		}
-	}
+	});
 
 #pragma omp parallel for default(shared)
 	for(a_int ielem = 0; ielem < m->gnelem(); ielem++)
@@ -284,11 +258,62 @@ void WeightedLeastSquaresGradients<scalar,nvars>::compute_gradients(
 	}
 }
 
+template<typename scalar, int nvars>
+void WeightedLeastSquaresGradients<scalar,nvars>::compute_cell_gradient(const a_int iel,
+		const scalar *const ucell, const scalar *const *const unbrs,
+		Eigen::Array<scalar,NDIM,nvars>& grad) const
+{
+	Matrix<scalar,NDIM,nvars> f = Matrix<scalar,NDIM,nvars>::Zero();
+
+	for(int jface = 0; jface < m->gnfael(iel); jface++)
+	{
+		const a_int iface = m->gelemface(iel,jface);
+		// the neighbour, or the ghost cell of a boundary face
+		const a_int jelem = m->gintfac(iface,0) == iel ? m->gintfac(iface,1) : m->gintfac(iface,0);
+		scalar w2 = 0, dr[NDIM];
+		for(int idim = 0; idim < NDIM; idim++)
+		{
+			dr[idim] = rc(iel,idim)-rc(jelem,idim);
+			w2 += dr[idim]*dr[idim];
+		}
+		w2 = 1.0/(w2);
+
+		for(int ivar = 0; ivar < nvars; ivar++)
+			for(int jdim = 0; jdim < NDIM; jdim++)
+				f(jdim,ivar) += w2*dr[jdim]*(ucell[ivar] - unbrs[jface][ivar]);
+	}
+
+	grad = (V[iel]*f).array();
+}
+
 template class ZeroGradients<a_real,NVARS>;
 template class GreenGaussGradients<a_real,NVARS>;
 template class WeightedLeastSquaresGradients<a_real,NVARS>;
 template class ZeroGradients<a_real,1>;
 template class GreenGaussGradients<a_real,1>;
 template class WeightedLeastSquaresGradients<a_real,1>;
+template class ZeroGradients<a_real,NVARS+1>;
+template class GreenGaussGradients<a_real,NVARS+1>;
+template class WeightedLeastSquaresGradients<a_real,NVARS+1>;
+
+// for residuals of batches of 4, 8 and 16 interleaved states
+template class ZeroGradients<a_real,4*NVARS>;
+template class GreenGaussGradients<a_real,4*NVARS>;
+template class WeightedLeastSquaresGradients<a_real,4*NVARS>;
+template class ZeroGradients<a_real,8*NVARS>;
+template class GreenGaussGradients<a_real,8*NVARS>;
+template class WeightedLeastSquaresGradients<a_real,8*NVARS>;
+template class ZeroGradients<a_real,16*NVARS>;
+template class GreenGaussGradients<a_real,16*NVARS>;
+template class WeightedLeastSquaresGradients<a_real,16*NVARS>;
+template class ZeroGradients<a_real,4*(NVARS+1)>;
+template class GreenGaussGradients<a_real,4*(NVARS+1)>;
+template class WeightedLeastSquaresGradients<a_real,4*(NVARS+1)>;
+template class ZeroGradients<a_real,8*(NVARS+1)>;
+template class GreenGaussGradients<a_real,8*(NVARS+1)>;
+template class WeightedLeastSquaresGradients<a_real,8*(NVARS+1)>;
+template class ZeroGradients<a_real,16*(NVARS+1)>;
+template class GreenGaussGradients<a_real,16*(NVARS+1)>;
+template class WeightedLeastSquaresGradients<a_real,16*(NVARS+1)>;
 
 } // end namespace
@@ -8,6 +8,7 @@
 #define AGRADIENTSCHEMES_H 1
 
 #include "mesh/amesh2dh.hpp"
+#include "mesh/faceloops.hpp"
 
 namespace fvens
 {
@@ -22,13 +23,20 @@ protected:
 	const UMesh2dh<scalar> *const m;                     ///< Mesh context
 	const amat::Array2d<scalar>& rc;                     ///< All cell-centres' coordinates
 
+	/// Schedule of face loops used when no other is given - plain atomic updates
+	const FaceLoopSchedule<scalar> atomicloops;
+	/// Schedule of threaded face loops
+	const FaceLoopSchedule<scalar> *const faceloops;
+
 public:
 	/// Sets needed data
 	/** \param mesh Mesh context
 	 * \param _rc Cell centres of all cells including ghost cells
+	 * \param loops Schedule of threaded face loops; if not given, atomic updates are used
 	 */
 	GradientScheme(const UMesh2dh<scalar> *const mesh,
-	               const amat::Array2d<scalar>& _rc);
+	               const amat::Array2d<scalar>& _rc,
+	               const FaceLoopSchedule<scalar> *const loops = nullptr);
 	
 	virtual ~GradientScheme();
 
@@ -37,6 +45,18 @@ public:
 			const MVector<scalar>& unk,                 ///< [in] Solution multi-vector
 			const amat::Array2d<scalar>& unkg,          ///< [in] Ghost cell states 
 			GradArray<scalar,nvars>& grads ) const = 0;
+
+	/// Computes the gradient of one cell from the states of its face neighbours
+	/** This gives the same result as \ref compute_gradients for that cell, up to round-off.
+	 * \param[in] iel The cell
+	 * \param[in] ucell The state of the cell
+	 * \param[in] unbrs For each face of the cell, in the order of \ref UMesh2dh::gelemface, the state
+	 *   of the neighbour across it, or the ghost state if it is a boundary face
+	 * \param[out] grad The gradient
+	 */
+	virtual void compute_cell_gradient(const a_int iel, const scalar *const ucell,
+	                                   const scalar *const *const unbrs,
+	                                   Eigen::Array<scalar,NDIM,nvars>& grad) const = 0;
 };
 
 /// Simply sets the gradient to zero
@@ -45,12 +65,17 @@ class ZeroGradients : public GradientScheme<scalar,nvars>
 {
 public:
 	ZeroGradients(const UMesh2dh<scalar> *const mesh, 
-	              const amat::Array2d<scalar>& _rc);
+	              const amat::Array2d<scalar>& _rc,
+	              const FaceLoopSchedule<scalar> *const loops = nullptr);
 
 	void compute_gradients(const MVector<scalar>& unk, 
 	                       const amat::Array2d<scalar>& unkg, 
 	                       GradArray<scalar,nvars>& grads ) const;
 
+	void compute_cell_gradient(const a_int iel, const scalar *const ucell,
+	                           const scalar *const *const unbrs,
+	                           Eigen::Array<scalar,NDIM,nvars>& grad) const;
+
 protected:
 	using GradientScheme<scalar,nvars>::m;
 	using GradientScheme<scalar,nvars>::rc;
@@ -66,15 +91,24 @@ class GreenGaussGradients : public GradientScheme<scalar,nvars>
 {
 public:
 	GreenGaussGradients(const UMesh2dh<scalar> *const mesh, 
-	                    const amat::Array2d<scalar>& _rc);
+	                    const amat::Array2d<scalar>& _rc,
+	                    const FaceLoopSchedule<scalar> *const loops = nullptr);
 
 	void compute_gradients(const MVector<scalar>& unk, 
 	                       const amat::Array2d<scalar>& unkg,
 	                       GradArray<scalar,nvars>& grads ) const;
 
+	void compute_cell_gradient(const a_int iel, const scalar *const ucell,
+	                           const scalar *const *const unbrs,
+	                           Eigen::Array<scalar,NDIM,nvars>& grad) const;
+
 protected:
 	using GradientScheme<scalar,nvars>::m;
 	using GradientScheme<scalar,nvars>::rc;
+	using GradientScheme<scalar,nvars>::faceloops;
+
+	/// Weight of the left cell's state in the face state, for each face
+	std::vector<scalar> leftweights;
 };
 
 /// Class implementing linear weighted least-squares reconstruction
@@ -83,15 +117,21 @@ class WeightedLeastSquaresGradients : public GradientScheme<scalar,nvars>
 {
 public:
 	WeightedLeastSquaresGradients(const UMesh2dh<scalar> *const mesh, 
-	                              const amat::Array2d<scalar>& _rc);
+	                              const amat::Array2d<scalar>& _rc,
+	                              const FaceLoopSchedule<scalar> *const loops = nullptr);
 
 	void compute_gradients(const MVector<scalar>& unk, 
 	                       const amat::Array2d<scalar>& unkg, 
 	                       GradArray<scalar,nvars>& grads ) const;
 
+	void compute_cell_gradient(const a_int iel, const scalar *const ucell,
+	                           const scalar *const *const unbrs,
+	                           Eigen::Array<scalar,NDIM,nvars>& grad) const;
+
 protected:
 	using GradientScheme<scalar,nvars>::m;
 	using GradientScheme<scalar,nvars>::rc;
+	using GradientScheme<scalar,nvars>::faceloops;
 
 private:
 	/// The least squares LHS matrix
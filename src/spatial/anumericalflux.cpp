@@ -650,10 +650,67 @@ void RoeAverageBasedFlux<scalar,j_real>::getJacobiansRoeAveragesWrtConserved (
 }
 
 template <typename scalar, typename j_real>
-RoeFlux<scalar,j_real>::RoeFlux(const IdealGasPhysics<scalar> *const analyticalflux) 
-	: RoeAverageBasedFlux<scalar,j_real>(analyticalflux), fixeps{1.0e-4}
+RoeFlux<scalar,j_real>::RoeFlux(const IdealGasPhysics<scalar> *const analyticalflux,
+                                const LowMachPreconditioner *const lowmachprec,
+                                const bool frozenjac)
+	: RoeAverageBasedFlux<scalar,j_real>(analyticalflux), fixeps{1.0e-4}, lowmach{lowmachprec},
+	  frozenjacobian{frozenjac || lowmachprec != nullptr}
 { }
 
+/** The jump is transformed to the variables (p, vn, vt, s), in which the flux Jacobian decouples
+ * into the acoustic system of p and vn, and the convection of vt and s. For the acoustic system,
+ * with eigenvalues \f$ \lambda_{1,2} = u' \pm c' \f$ of PA,
+ * \f$ |PA| = a\,PA + b\,I \f$ where \f$ a = (|\lambda_1|-|\lambda_2|)/(\lambda_1-\lambda_2) \f$
+ * and \f$ b = (\lambda_1|\lambda_2| - \lambda_2|\lambda_1|)/(\lambda_1-\lambda_2) \f$, so the
+ * dissipation is \f$ a A \Delta w + b P^{-1} \Delta w \f$. Without preconditioning
+ * (\f$ \theta = 1 \f$), this is the usual Roe dissipation with \f$ u' = v_n, c' = c \f$. Because of the Roe-averaged state,
+ * the linearized jumps in (p, vn, vt) are the actual jumps.
+ */
+template <typename scalar, typename j_real>
+template <typename T>
+void RoeFlux<scalar,j_real>::getDissipation(const T n[NDIM], const T rhoij,
+		const T vxij, const T vyij, const T cij, const T du[NVARS], T adu[NVARS]) const
+{
+	const T vm2 = vxij*vxij + vyij*vyij;
+	const T vn = vxij*n[0] + vyij*n[1];
+	const T vt = -vxij*n[1] + vyij*n[0];
+	const T c2 = cij*cij;
+
+	const T dp = (g-1.0)*(du[3] - vxij*du[1] - vyij*du[2] + 0.5*vm2*du[0]);
+	const T dvn = (du[1]*n[0] + du[2]*n[1] - vn*du[0])/rhoij;
+	const T dvt = (-du[1]*n[1] + du[2]*n[0] - vt*du[0])/rhoij;
+	const T ds = du[0] - dp/c2;
+
+	const T beta2 = lowmach ? lowmach->getReferenceVelocity2(vm2, cij) : c2;
+	const T theta = beta2/c2;
+	T up = vn, cp = cij;
+	if(lowmach)
+		lowmach->getWaveSpeeds(vn, cij, beta2, up, cp);
+
+	// absolute eigenvalues with Harten's entropy fix
+	const T delta = fixeps*cp;
+	const auto fixedabs = [delta](const T l) {
+		const T al = std::fabs(l);
+		return al < delta ? (al*al + delta*delta)/(2.0*delta) : al;
+	};
+	const T l1 = up + cp, l2 = up - cp;
+	const T al1 = fixedabs(l1), al2 = fixedabs(l2), aln = fixedabs(vn);
+
+	const T ca = (al1-al2)/(l1-l2);
+	const T cb = (l1*al2 - l2*al1)/(l1-l2);
+	const T Dp = ca*(vn*dp + rhoij*c2*dvn) + cb*dp/theta;
+	const T Dvn = ca*(dp/rhoij + vn*dvn) + cb*dvn;
+	const T Dvt = aln*dvt;
+	const T Ds = aln*ds;
+
+	// back to conserved variables
+	const T Drho = Dp/c2 + Ds;
+	adu[0] = Drho;
+	adu[1] = vxij*Drho + rhoij*(n[0]*Dvn - n[1]*Dvt);
+	adu[2] = vyij*Drho + rhoij*(n[1]*Dvn + n[0]*Dvt);
+	adu[3] = Dp/(g-1.0) + 0.5*vm2*Drho + rhoij*(vn*Dvn + vt*Dvt);
+}
+
 template <typename scalar, typename j_real>
 void RoeFlux<scalar,j_real>::get_flux(const scalar *const ul, const scalar *const ur,
 		const scalar* const n, scalar *const __restrict flux) const
@@ -668,6 +725,20 @@ void RoeFlux<scalar,j_real>::get_flux(const scalar *const ul, const scalar *cons
 	scalar Rij,rhoij,vxij,vyij,vm2ij,vnij,Hij,cij;	
 	getRoeAverages(ul,ur,n,vxi,vyi,Hi,vxj,vyj,Hj, Rij,rhoij,vxij,vyij,vm2ij,vnij,Hij,cij);
 
+	if(lowmach)
+	{
+		scalar du[NVARS], adu[NVARS], fi[NVARS], fj[NVARS];
+		for(int ivar = 0; ivar < NVARS; ivar++)
+			du[ivar] = ur[ivar]-ul[ivar];
+		getDissipation(n, rhoij, vxij, vyij, cij, du, adu);
+
+		physics->getDirectionalFlux(ul,n,vni,pi,fi);
+		physics->getDirectionalFlux(ur,n,vnj,pj,fj);
+		for(int ivar = 0; ivar < NVARS; ivar++)
+			flux[ivar] = 0.5*(fi[ivar]+fj[ivar] - adu[ivar]);
+		return;
+	}
+
 	// eigenvalues
 	scalar l[4];
 	l[0] = fabs(vnij-cij); l[1] = fabs(vnij); l[2] = l[1]; l[3] = fabs(vnij+cij);
@@ -737,6 +808,29 @@ void RoeFlux<scalar,j_real>::get_jacobian(const j_real *const ul, const j_real *
 	// compute Roe-averages
 	j_real Rij,rhoij,vxij,vyij,vm2ij,vnij,Hij,cij;	
 	getRoeAverages(ul,ur,n,vxi,vyi,Hi,vxj,vyj,Hj, Rij,rhoij,vxij,vyij,vm2ij,vnij,Hij,cij);
+
+	if(frozenjacobian)
+	{
+		// frozen dissipation matrix, assembled column by column as it is linear in the jump
+		j_real ad[NVARS*NVARS];
+		for(int k = 0; k < NVARS; k++)
+		{
+			j_real du[NVARS], adu[NVARS];
+			for(int ivar = 0; ivar < NVARS; ivar++)
+				du[ivar] = ivar == k ? 1.0 : 0.0;
+			getDissipation(n, rhoij, vxij, vyij, cij, du, adu);
+			for(int ivar = 0; ivar < NVARS; ivar++)
+				ad[ivar*NVARS+k] = adu[ivar];
+		}
+
+		physics->getJacobianDirectionalFluxWrtConserved(ul,n,dfdl);
+		physics->getJacobianDirectionalFluxWrtConserved(ur,n,dfdr);
+		for(int k = 0; k < NVARS*NVARS; k++) {
+			dfdl[k] = -0.5*(dfdl[k] + ad[k]);
+			dfdr[k] = 0.5*(dfdr[k] - ad[k]);
+		}
+		return;
+	}
 	
 	//> Derivatives of the above variables
 	
@@ -1048,9 +1142,26 @@ void HLLFlux<scalar,j_real>::get_jacobian(const j_real *const ul, const j_real *
 }
 
 template <typename scalar, typename j_real>
-HLLCFlux<scalar,j_real>::HLLCFlux(const IdealGasPhysics<scalar> *const analyticalflux) 
-	: RoeAverageBasedFlux<scalar>(analyticalflux)
+HLLCFlux<scalar,j_real>::HLLCFlux(const IdealGasPhysics<scalar> *const analyticalflux,
+                                  const LowMachPreconditioner *const lowmachprec)
+	: RoeAverageBasedFlux<scalar>(analyticalflux), lowmach{lowmachprec}
+{
+}
+
+template <typename scalar, typename j_real>
+template <typename T>
+void HLLCFlux<scalar,j_real>::getPreconditionedSignalSpeeds(const T vni, const T vm2i, const T ci,
+		const T vnj, const T vm2j, const T cj, const T vnij, const T vm2ij, const T cij,
+		T& sl, T& sr) const
 {
+	T up, cp;
+	lowmach->getWaveSpeeds(vni, ci, lowmach->getReferenceVelocity2(vm2i,ci), up, cp);
+	sl = up - cp;
+	lowmach->getWaveSpeeds(vnj, cj, lowmach->getReferenceVelocity2(vm2j,cj), up, cp);
+	sr = up + cp;
+	lowmach->getWaveSpeeds(vnij, cij, lowmach->getReferenceVelocity2(vm2ij,cij), up, cp);
+	sl = std::min(sl, up - cp);
+	sr = std::max(sr, up + cp);
 }
 
 template <typename scalar, typename j_real>
@@ -1184,6 +1295,9 @@ void HLLCFlux<scalar,j_real>::get_flux(const scalar *const ul, const scalar *con
 	sr = vnj+cj;
 	if(sr < vnij+cij)
 		sr = vnij+cij;
+	if(lowmach)
+		getPreconditionedSignalSpeeds(vni, dimDotProduct(vi,vi), ci, vnj, dimDotProduct(vj,vj), cj,
+		                              vnij, vm2ij, cij, sl, sr);
 	const scalar sm = ( ur[0]*vnj*(sr-vnj) - ul[0]*vni*(sl-vni) + pi-pj ) 
 		/ ( ur[0]*(sr-vnj) - ul[0]*(sl-vni) );
 
@@ -1294,6 +1408,14 @@ void HLLCFlux<scalar,j_real>::get_jacobian(const j_real *const ul, const j_real
 		}
 	}
 
+	if(lowmach) {
+		getPreconditionedSignalSpeeds(vni, dimDotProduct(vi,vi), ci, vnj, dimDotProduct(vj,vj), cj,
+		                              vnij, vm2ij, cij, sl, sr);
+		for(int k = 0; k < NVARS; k++) {
+			dsli[k] = dslj[k] = dsri[k] = dsrj[k] = 0;
+		}
+	}
+
 	const j_real num = ( ur[0]*vnj*(sr-vnj) - ul[0]*vni*(sl-vni) + pi-pj );
 	const j_real denom = (ur[0]*(sr-vnj) - ul[0]*(sl-vni));
 
@@ -1385,11 +1507,15 @@ void HLLCFlux<scalar,j_real>::get_jacobian(const j_real *const ul, const j_real
 		dfdl[i] *= -1.0;
 }
 
+template class InviscidFlux<a_real>;
 template class LocalLaxFriedrichsFlux<a_real>;
 template class VanLeerFlux<a_real>;
 template class AUSMFlux<a_real>;
 template class AUSMPlusFlux<a_real>;
 template class RoeFlux<a_real>;
+template void RoeFlux<a_real>::getDissipation(const a_real n[NDIM], const a_real rhoij,
+		const a_real vxij, const a_real vyij, const a_real cij, const a_real du[NVARS],
+		a_real adu[NVARS]) const;
 template class HLLFlux<a_real>;
 template class HLLCFlux<a_real>;
 
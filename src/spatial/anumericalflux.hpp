@@ -9,6 +9,7 @@
 
 #include "aconstants.hpp"
 #include "physics/aphysics.hpp"
+#include "physics/lowmachpreconditioner.hpp"
 
 namespace fvens {
 
@@ -205,12 +206,32 @@ protected:
 
 /// Roe-Pike flux-difference splitting
 /** From Blazek \cite{blazek}.
+ *
+ * With low-Mach preconditioning, the dissipation is \f$ P^{-1}|PA| \Delta u \f$ at the
+ * Roe-averaged state, where P is the preconditioning matrix of \ref LowMachPreconditioner, so that
+ * the pressure dissipation scales correctly as the Mach number goes to zero. The Jacobian is then
+ * computed with the dissipation matrix frozen.
+ *
+ * The frozen-coefficient Jacobian can also be requested without preconditioning:
+ * \f$ \partial F/\partial u_L \approx \frac12 (A(u_L) + |A_{Roe}|) \f$ and
+ * \f$ \partial F/\partial u_R \approx \frac12 (A(u_R) - |A_{Roe}|) \f$, neglecting the
+ * derivatives of the Roe-averaged state. It is exact when the left and right states are equal,
+ * and is much cheaper than the full linearization; it is meant for approximate Jacobians used only
+ * for preconditioning, such as with matrix-free solvers.
  */
 template <typename scalar, typename j_real = a_real>
 class RoeFlux : public RoeAverageBasedFlux<scalar,j_real>
 {
 public:
-	RoeFlux(const IdealGasPhysics<scalar> *const analyticalflux);
+	/** \param analyticalflux The gas physics
+	 * \param lowmachprec Low-Mach preconditioning to use for the dissipation, if any; it must
+	 *   outlive this object
+	 * \param frozenjac Whether to compute the frozen-coefficient Jacobian; it is always used with
+	 *   low-Mach preconditioning
+	 */
+	RoeFlux(const IdealGasPhysics<scalar> *const analyticalflux,
+	        const LowMachPreconditioner *const lowmachprec = nullptr,
+	        const bool frozenjac = false);
 	
 	/** \sa InviscidFlux::get_flux
 	 */
@@ -232,6 +253,21 @@ protected:
 
 	/// Entropy fix parameter
 	const a_real fixeps;
+
+	/// Low-Mach preconditioning, or null if it is not used
+	const LowMachPreconditioner *const lowmach;
+
+	/// Whether the Jacobian is computed with the dissipation matrix frozen
+	const bool frozenjacobian;
+
+	/// Computes the dissipation, low-Mach preconditioned if requested, at the Roe-averaged state
+	/** \param[in] du The jump in conserved variables across the face
+	 * \param[out] adu The dissipation \f$ P^{-1}|PA|\Delta u \f$, which is linear in du;
+	 *   without preconditioning, P = I.
+	 */
+	template <typename T>
+	void getDissipation(const T n[NDIM], const T rhoij, const T vxij, const T vyij,
+	                    const T cij, const T du[NVARS], T adu[NVARS]) const;
 };
 
 /// Harten Lax Van-Leer numerical flux
@@ -267,12 +303,21 @@ protected:
 /// Harten Lax Van-Leer numerical flux with contact restoration by Toro
 /** Implemented as described by Batten et al. \cite invflux_hllc_batten
  * Good for both inviscid and viscous flows.
+ *
+ * With low-Mach preconditioning, the signal speeds are estimated from the preconditioned acoustic
+ * wave speeds, which reduces the dissipation at low Mach numbers (Luo, Baum and Lohner, J. Comput.
+ * Phys. 194, 2004). The Jacobian is then computed with the signal speeds frozen.
  */
 template <typename scalar, typename j_real = a_real>
 class HLLCFlux : public RoeAverageBasedFlux<scalar,j_real>
 {
 public:
-	HLLCFlux(const IdealGasPhysics<scalar> *const analyticalflux);
+	/** \param analyticalflux The gas physics
+	 * \param lowmachprec Low-Mach preconditioning to use for the signal speeds, if any; it must
+	 *   outlive this object
+	 */
+	HLLCFlux(const IdealGasPhysics<scalar> *const analyticalflux,
+	         const LowMachPreconditioner *const lowmachprec = nullptr);
 	
 	/** \sa InviscidFlux::get_flux
 	 */
@@ -292,6 +337,19 @@ protected:
 	using RoeAverageBasedFlux<scalar,j_real>::getRoeAverages;
 	using RoeAverageBasedFlux<scalar,j_real>::getJacobiansRoeAveragesWrtConserved;
 
+	/// Low-Mach preconditioning, or null if it is not used
+	const LowMachPreconditioner *const lowmach;
+
+	/// Estimates the signal speeds from the preconditioned acoustic wave speeds
+	/** The slowest and fastest of the left, right and Roe-averaged preconditioned wave speeds
+	 * \f$ u' \mp c' \f$ (see \ref LowMachPreconditioner) are used.
+	 */
+	template <typename T>
+	void getPreconditionedSignalSpeeds(const T vni, const T vm2i, const T ci,
+	                                   const T vnj, const T vm2j, const T cj,
+	                                   const T vnij, const T vm2ij, const T cij,
+	                                   T& sl, T& sr) const;
+
 	/// Computes the averaged state between the waves in the Riemann fan
 	/** \param[in] u The state outside the Riemann fan
 	 * \param[in] n Normal to the face
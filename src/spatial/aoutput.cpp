@@ -5,8 +5,15 @@
 #include <iostream>
 #include <iomanip>
 #include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <limits>
 #include "aoutput.hpp"
 #include "utilities/aoptionparser.hpp"
+#include "utilities/aerrorhandling.hpp"
 
 namespace fvens {
 
@@ -68,14 +75,17 @@ StatusCode FlowOutput::postprocess_cell(const Vec uvec,
 		scalars(iel,0) = u(iel,0);
 	}
 
+	std::vector<a_real> p(m->gnelem()), c(m->gnelem());
+	phy->getPressureFromConservedBatch(m->gnelem(), NVARS, uarr, &p[0]);
+	phy->getSoundSpeedFromConservedBatch(m->gnelem(), NVARS, uarr, &c[0]);
+
 	for(a_int iel = 0; iel < m->gnelem(); iel++)
 	{
 		velocities(iel,0) = u(iel,1)/u(iel,0);
 		velocities(iel,1) = u(iel,2)/u(iel,0);
 		a_real vmag2 = pow(velocities(iel,0), 2) + pow(velocities(iel,1), 2);
-		scalars(iel,2) = phy->getPressureFromConserved(&uarr[iel*NVARS]);
-		a_real c = phy->getSoundSpeedFromConserved(&uarr[iel*NVARS]);
-		scalars(iel,1) = sqrt(vmag2)/c;
+		scalars(iel,2) = p[iel];
+		scalars(iel,1) = sqrt(vmag2)/c[iel];
 	}
 	compute_entropy_cell(uvec);
 	
@@ -116,6 +126,11 @@ StatusCode FlowOutput::postprocess_point(const Vec uvec,
 		for(int ivar = 0; ivar < NVARS; ivar++)
 			up(ipoin,ivar) /= areasum(ipoin);
 	
+	std::vector<a_real> p(m->gnpoin()), c(m->gnpoin()), T(m->gnpoin());
+	phy->getPressureFromConservedBatch(m->gnpoin(), NVARS, &up(0,0), &p[0]);
+	phy->getSoundSpeedFromConservedBatch(m->gnpoin(), NVARS, &up(0,0), &c[0]);
+	phy->getTemperatureFromConservedBatch(m->gnpoin(), NVARS, &up(0,0), &T[0]);
+
 	for(a_int ipoin = 0; ipoin < m->gnpoin(); ipoin++)
 	{
 		scalars(ipoin,0) = up(ipoin,0);
@@ -124,10 +139,9 @@ StatusCode FlowOutput::postprocess_point(const Vec uvec,
 			velocities(ipoin,idim) = up(ipoin,idim+1)/up(ipoin,0);
 		const a_real vmag2 = dimDotProduct(&velocities(ipoin,0),&velocities(ipoin,0));
 
-		scalars(ipoin,2) = phy->getPressureFromConserved(&up(ipoin,0));
-		a_real c = phy->getSoundSpeedFromConserved(&up(ipoin,0));
-		scalars(ipoin,1) = sqrt(vmag2)/c;
-		scalars(ipoin,3) = phy->getTemperatureFromConserved(&up(ipoin,0));
+		scalars(ipoin,2) = p[ipoin];
+		scalars(ipoin,1) = sqrt(vmag2)/c[ipoin];
+		scalars(ipoin,3) = T[ipoin];
 	}
 
 	compute_entropy_cell(uvec);
@@ -143,11 +157,16 @@ void FlowOutput::exportVolumeData(const MVector<a_real>& u, std::string volfile)
 	open_file_toWrite(volfile+"-vol.out", fout);
 	fout << "#   x    y    rho     u      v      p      T      M \n";
 
+	std::vector<a_real> Ts(m->gnelem()), cs(m->gnelem()), ps(m->gnelem());
+	phy->getTemperatureFromConservedBatch(m->gnelem(), NVARS, &u(0,0), &Ts[0]);
+	phy->getSoundSpeedFromConservedBatch(m->gnelem(), NVARS, &u(0,0), &cs[0]);
+	phy->getPressureFromConservedBatch(m->gnelem(), NVARS, &u(0,0), &ps[0]);
+
 	for(a_int iel = 0; iel < m->gnelem(); iel++)
 	{
-		const a_real T = phy->getTemperatureFromConserved(&u(iel,0));
-		const a_real c = phy->getSoundSpeedFromConserved(&u(iel,0));
-		const a_real p = phy->getPressureFromConserved(&u(iel,0));
+		const a_real T = Ts[iel];
+		const a_real c = cs[iel];
+		const a_real p = ps[iel];
 		a_real vmag = std::sqrt(u(iel,1)/u(iel,0)*u(iel,1)/u(iel,0)
 				+u(iel,2)/u(iel,0)*u(iel,2)/u(iel,0));
 
@@ -165,7 +184,375 @@ void FlowOutput::exportVolumeData(const MVector<a_real>& u, std::string volfile)
 	fout.close();
 }
 
-/** \todo Use values at the face to compute drag, lift etc. rather than cell-centred data.
+/// Fields that can be selected for output
+enum OutputField { OUT_COORDS, OUT_DENSITY, OUT_VELOCITY, OUT_PRESSURE, OUT_TEMPERATURE, OUT_MACH };
+
+/// Converts the name of a field to the field; the name must be valid
+static OutputField getOutputField(const std::string& name)
+{
+	if(name == "coordinates")
+		return OUT_COORDS;
+	else if(name == "density")
+		return OUT_DENSITY;
+	else if(name == "velocity")
+		return OUT_VELOCITY;
+	else if(name == "pressure")
+		return OUT_PRESSURE;
+	else if(name == "temperature")
+		return OUT_TEMPERATURE;
+	else
+		return OUT_MACH;
+}
+
+int getOutputFieldComponents(const std::string& name)
+{
+	if(name == "coordinates" || name == "velocity")
+		return NDIM;
+	else if(name == "density" || name == "pressure" || name == "temperature"
+	        || name == "mach-number")
+		return 1;
+	else
+		return 0;
+}
+
+OutputPrecision parseOutputPrecision(const std::string& name)
+{
+	std::string uname = name;
+	std::transform(uname.begin(), uname.end(), uname.begin(), ::toupper);
+	if(uname == "FLOAT16")
+		return FLOAT16;
+	else if(uname == "FLOAT32")
+		return FLOAT32;
+	else if(uname == "FLOAT64")
+		return FLOAT64;
+	else
+		throw std::runtime_error("Unknown output precision " + name);
+}
+
+/// Converts a single-precision number to the bits of the nearest half-precision number
+/** Rounds to nearest, ties to even. Values too large for half precision become infinities.
+ */
+static uint16_t floatToHalf(const float value)
+{
+	uint32_t f;
+	std::memcpy(&f, &value, sizeof(float));
+	const uint16_t sign = static_cast<uint16_t>((f >> 16) & 0x8000);
+	const uint32_t fexp = (f >> 23) & 0xff;
+	uint32_t mant = f & 0x7fffff;
+
+	// infinity or NaN
+	if(fexp == 0xff)
+		return static_cast<uint16_t>(sign | 0x7c00 | (mant ? 0x200 : 0));
+
+	const int exp = static_cast<int>(fexp) - 127 + 15;
+	if(exp >= 31)
+		return static_cast<uint16_t>(sign | 0x7c00);
+
+	if(exp <= 0) {
+		// subnormal half, or zero
+		if(exp < -10)
+			return sign;
+		mant |= 0x800000;
+		const int shift = 14 - exp;
+		uint32_t half = mant >> shift;
+		const uint32_t rem = mant & ((1u << shift) - 1);
+		const uint32_t halfway = 1u << (shift-1);
+		if(rem > halfway || (rem == halfway && (half & 1)))
+			half++;
+		return static_cast<uint16_t>(sign | half);
+	}
+
+	// a carry out of the mantissa correctly increments the exponent
+	uint32_t half = (static_cast<uint32_t>(exp) << 10) | (mant >> 13);
+	const uint32_t rem = mant & 0x1fff;
+	if(rem > 0x1000 || (rem == 0x1000 && (half & 1)))
+		half++;
+	return static_cast<uint16_t>(sign | half);
+}
+
+/// Converts the bits of a half-precision number to single precision
+static float halfToFloat(const uint16_t h)
+{
+	const uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+	const uint32_t exp = (h >> 10) & 0x1f;
+	const uint32_t mant = h & 0x3ff;
+
+	float value;
+	if(exp == 0)
+		value = std::ldexp(static_cast<float>(mant), -24);
+	else if(exp == 31)
+		value = mant ? std::numeric_limits<float>::quiet_NaN()
+			: std::numeric_limits<float>::infinity();
+	else
+		value = std::ldexp(static_cast<float>(mant | 0x400), static_cast<int>(exp)-25);
+
+	uint32_t f;
+	std::memcpy(&f, &value, sizeof(float));
+	f |= sign;
+	std::memcpy(&value, &f, sizeof(float));
+	return value;
+}
+
+/// Name of a precision as written in field output files
+static std::string precisionName(const OutputPrecision prec)
+{
+	return prec == FLOAT16 ? "float16" : (prec == FLOAT32 ? "float32" : "float64");
+}
+
+/// Writes an array of values in the requested precision
+static void writeValues(std::ofstream& fout, const std::vector<a_real>& vals,
+                        const OutputPrecision prec)
+{
+	if(prec == FLOAT64) {
+		const std::vector<double> buf(vals.begin(), vals.end());
+		fout.write(reinterpret_cast<const char*>(buf.data()), buf.size()*sizeof(double));
+	}
+	else if(prec == FLOAT32) {
+		std::vector<float> buf(vals.size());
+		for(size_t i = 0; i < vals.size(); i++)
+			buf[i] = static_cast<float>(vals[i]);
+		fout.write(reinterpret_cast<const char*>(buf.data()), buf.size()*sizeof(float));
+	}
+	else {
+		std::vector<uint16_t> buf(vals.size());
+		for(size_t i = 0; i < vals.size(); i++)
+			buf[i] = floatToHalf(static_cast<float>(vals[i]));
+		fout.write(reinterpret_cast<const char*>(buf.data()), buf.size()*sizeof(uint16_t));
+	}
+}
+
+/// Reads an array of values written in some precision
+static void readValues(std::ifstream& fin, const OutputPrecision prec, std::vector<a_real>& vals)
+{
+	if(prec == FLOAT64) {
+		std::vector<double> buf(vals.size());
+		fin.read(reinterpret_cast<char*>(buf.data()), buf.size()*sizeof(double));
+		for(size_t i = 0; i < vals.size(); i++)
+			vals[i] = buf[i];
+	}
+	else if(prec == FLOAT32) {
+		std::vector<float> buf(vals.size());
+		fin.read(reinterpret_cast<char*>(buf.data()), buf.size()*sizeof(float));
+		for(size_t i = 0; i < vals.size(); i++)
+			vals[i] = buf[i];
+	}
+	else {
+		std::vector<uint16_t> buf(vals.size());
+		fin.read(reinterpret_cast<char*>(buf.data()), buf.size()*sizeof(uint16_t));
+		for(size_t i = 0; i < vals.size(); i++)
+			vals[i] = halfToFloat(buf[i]);
+	}
+}
+
+/// Byte order of the machine, as written in field output files
+static std::string byteOrderName()
+{
+	const uint16_t one = 1;
+	unsigned char first;
+	std::memcpy(&first, &one, 1);
+	return first ? "little-endian" : "big-endian";
+}
+
+/// Centre of a cell as the average of its nodes
+static void getCellCentre(const UMesh2dh<a_real> *const m, const a_int iel, a_real rc[NDIM])
+{
+	for(int j = 0; j < NDIM; j++)
+		rc[j] = 0;
+	for(int ino = 0; ino < m->gnnode(iel); ino++)
+		for(int j = 0; j < NDIM; j++)
+			rc[j] += m->gcoords(m->ginpoel(iel,ino),j);
+	for(int j = 0; j < NDIM; j++)
+		rc[j] /= m->gnnode(iel);
+}
+
+StatusCode FlowOutput::exportFields(const Vec uvec, const FieldOutputConfig& conf) const
+{
+	for(const std::string& name : conf.fields)
+		fvens_throw(getOutputFieldComponents(name) == 0, "Unknown output field " + name);
+	fvens_throw(!conf.box.empty() && conf.box.size() != 2*NDIM,
+	            "The output box needs lower and upper bounds in each direction!");
+
+	const bool subset = !conf.box.empty() || !conf.regiontags.empty();
+	fvens_throw(!conf.regiontags.empty() && m->gndtag() == 0,
+	            "Output by volume region was requested but the mesh has no region tags!");
+
+	// select cells
+	std::vector<a_int> cells;
+	if(subset) {
+		for(a_int iel = 0; iel < m->gnelem(); iel++)
+		{
+			if(!conf.box.empty()) {
+				a_real rc[NDIM];
+				getCellCentre(m, iel, rc);
+				bool inside = true;
+				for(int j = 0; j < NDIM; j++)
+					inside = inside && rc[j] >= conf.box[j] && rc[j] <= conf.box[NDIM+j];
+				if(!inside)
+					continue;
+			}
+			if(!conf.regiontags.empty() && std::find(conf.regiontags.begin(),
+			                                        conf.regiontags.end(),
+			                                        m->gvol_region(iel,0)) == conf.regiontags.end())
+				continue;
+			cells.push_back(iel);
+		}
+	}
+	const a_int ncells = subset ? static_cast<a_int>(cells.size()) : m->gnelem();
+
+	std::ofstream fout(conf.file, std::ios::out | std::ios::binary);
+	fvens_throw(!fout, "Could not open file " + conf.file);
+
+	fout << "FVENS-FIELDS 1\n"
+	     << "cells " << ncells << "\n"
+	     << "precision " << precisionName(conf.precision) << "\n"
+	     << "byte-order " << byteOrderName() << "\n"
+	     << "subset " << (subset ? 1 : 0) << "\n"
+	     << "fields";
+	for(const std::string& name : conf.fields)
+		fout << " " << name << ":" << getOutputFieldComponents(name);
+	fout << "\ndata\n";
+
+	if(subset) {
+		std::vector<uint32_t> ind(cells.begin(), cells.end());
+		fout.write(reinterpret_cast<const char*>(ind.data()), ind.size()*sizeof(uint32_t));
+	}
+
+	StatusCode ierr = 0;
+	const PetscScalar* uarr;
+	ierr = VecGetArrayRead(uvec, &uarr); CHKERRQ(ierr);
+
+	// states of the selected cells, contiguous so that the batch conversions can be used
+	std::vector<a_real> usel;
+	if(subset) {
+		usel.resize(ncells*NVARS);
+		for(a_int i = 0; i < ncells; i++)
+			for(int j = 0; j < NVARS; j++)
+				usel[i*NVARS+j] = uarr[cells[i]*NVARS+j];
+	}
+	const a_real *const ustates = subset ? usel.data() : uarr;
+
+	std::vector<a_real> vals, cs;
+	for(const std::string& name : conf.fields)
+	{
+		const int ncomp = getOutputFieldComponents(name);
+		const OutputField field = getOutputField(name);
+		vals.resize(ncells*ncomp);
+
+		if(field == OUT_PRESSURE)
+			phy->getPressureFromConservedBatch(ncells, NVARS, ustates, vals.data());
+		else if(field == OUT_TEMPERATURE)
+			phy->getTemperatureFromConservedBatch(ncells, NVARS, ustates, vals.data());
+		else if(field == OUT_MACH) {
+			cs.resize(ncells);
+			phy->getSoundSpeedFromConservedBatch(ncells, NVARS, ustates, cs.data());
+		}
+
+#pragma omp parallel for default(shared)
+		for(a_int i = 0; i < ncells; i++)
+		{
+			const a_int iel = subset ? cells[i] : i;
+			const a_real *const uc = &ustates[i*NVARS];
+			a_real *const v = &vals[i*ncomp];
+			switch(field) {
+			case OUT_COORDS:
+				getCellCentre(m, iel, v);
+				break;
+			case OUT_DENSITY:
+				v[0] = uc[0];
+				break;
+			case OUT_VELOCITY:
+				for(int j = 0; j < NDIM; j++)
+					v[j] = uc[j+1]/uc[0];
+				break;
+			case OUT_PRESSURE:
+			case OUT_TEMPERATURE:
+				break;
+			case OUT_MACH:
+				v[0] = std::sqrt(dimDotProduct(&uc[1],&uc[1]))/uc[0] / cs[i];
+			}
+		}
+
+		writeValues(fout, vals, conf.precision);
+	}
+
+	ierr = VecRestoreArrayRead(uvec, &uarr); CHKERRQ(ierr);
+	fvens_throw(!fout, "Could not write field output to " + conf.file);
+	fout.close();
+	return ierr;
+}
+
+FieldOutputData readFieldOutput(const std::string& file)
+{
+	std::ifstream fin(file, std::ios::in | std::ios::binary);
+	fvens_throw(!fin, "Could not open file " + file);
+
+	FieldOutputData data;
+	a_int ncells = 0;
+	OutputPrecision prec = FLOAT64;
+	bool subset = false;
+
+	std::string line;
+	std::getline(fin, line);
+	fvens_throw(line != "FVENS-FIELDS 1", file + " is not a field output file!");
+	while(std::getline(fin, line) && line != "data")
+	{
+		std::istringstream ss(line);
+		std::string key;
+		ss >> key;
+		if(key == "cells")
+			ss >> ncells;
+		else if(key == "precision") {
+			std::string pname;
+			ss >> pname;
+			prec = parseOutputPrecision(pname);
+		}
+		else if(key == "byte-order") {
+			std::string order;
+			ss >> order;
+			fvens_throw(order != byteOrderName(), "Byte order of " + file + " is not native!");
+		}
+		else if(key == "subset") {
+			int flag = 0;
+			ss >> flag;
+			subset = flag;
+		}
+		else if(key == "fields") {
+			std::string entry;
+			while(ss >> entry) {
+				const size_t colon = entry.rfind(':');
+				fvens_throw(colon == std::string::npos, "Invalid field in " + file);
+				const std::string name = entry.substr(0,colon);
+				data.fields.push_back(name);
+				data.ncomps[name] = std::stoi(entry.substr(colon+1));
+			}
+		}
+	}
+	fvens_throw(line != "data", "Incomplete header in " + file);
+
+	data.cells.resize(ncells);
+	if(subset) {
+		std::vector<uint32_t> ind(ncells);
+		fin.read(reinterpret_cast<char*>(ind.data()), ind.size()*sizeof(uint32_t));
+		for(a_int i = 0; i < ncells; i++)
+			data.cells[i] = ind[i];
+	}
+	else
+		for(a_int i = 0; i < ncells; i++)
+			data.cells[i] = i;
+
+	for(const std::string& name : data.fields)
+	{
+		std::vector<a_real>& vals = data.values[name];
+		vals.resize(ncells*data.ncomps[name]);
+		readValues(fin, prec, vals);
+	}
+	fvens_throw(!fin, "Could not read all the data in " + file);
+
+	return data;
+}
+
+/** The gradients are computed afresh, because the state u is usually not the one at which the
+ * last residual was computed.
  */
 void FlowOutput::exportSurfaceData(const MVector<a_real>& u, const std::vector<int> wbcm, 
 		std::vector<int> obcm, const std::string basename) const
@@ -176,17 +563,6 @@ void FlowOutput::exportSurfaceData(const MVector<a_real>& u, const std::vector<i
 
 	space->getGradients(u, grad);
 
-	// get number of faces in wall boundary and other boundary
-	
-	std::vector<int> nwbfaces(wbcm.size(),0), nobfaces(obcm.size(),0);
-	for(a_int iface = 0; iface < m->gnbface(); iface++)
-	{
-		for(int im = 0; im < static_cast<int>(wbcm.size()); im++)
-			if(m->gintfacbtags(iface,0) == wbcm[im]) nwbfaces[im]++;
-		for(int im = 0; im < static_cast<int>(obcm.size()); im++)
-			if(m->gintfacbtags(iface,0) == obcm[im]) nobfaces[im]++;
-	}
-
 	// Iterate over wall boundary markers
 	for(int im=0; im < static_cast<int>(wbcm.size()); im++)
 	{
@@ -194,7 +570,7 @@ void FlowOutput::exportSurfaceData(const MVector<a_real>& u, const std::vector<i
 		std::ofstream fout; 
 		open_file_toWrite(fname, fout);
 		
-		MVector<a_real> output(nwbfaces[im], 2+NDIM);
+		MVector<a_real> output(space->surfaceFaces(wbcm[im]).size(), 2+NDIM);
 
 		//a_int facecoun = 0;			// face iteration counter for this boundary marker
 		//a_real totallen = 0;		// total area of the surface with this boundary marker
@@ -231,41 +607,27 @@ void FlowOutput::exportSurfaceData(const MVector<a_real>& u, const std::vector<i
 		std::ofstream fout;
 		open_file_toWrite(fname, fout);
 		
-		Matrix<a_real,Dynamic,Dynamic> output(nobfaces[im], 2+NDIM);
-		a_int facecoun = 0;
+		const std::vector<a_int>& faces = space->surfaceFaces(obcm[im]);
+		Matrix<a_real,Dynamic,Dynamic> output(faces.size(), 2+NDIM);
 
 		fout << "#   x         y          u           v\n";
 
-		for(a_int iface = 0; iface < m->gnbface(); iface++)
+		for(a_int facecoun = 0; facecoun < static_cast<a_int>(faces.size()); facecoun++)
 		{
-			if(m->gintfacbtags(iface,0) == obcm[im])
+			const a_int iface = faces[facecoun];
+			const a_int lelem = m->gintfac(iface,0);
+
+			// coords of face center
+			for(int j = 0; j < NDIM; j++) 
 			{
-				a_int lelem = m->gintfac(iface,0);
-				/*a_real n[NDIM];
-				for(int j = 0; j < NDIM; j++)
-					n[j] = m->gfacemetric(iface,j);
-				const a_real len = m->gfacemetric(iface,2);*/
-
-				// coords of face center
-				a_int ijp[NDIM];
-				ijp[0] = m->gintfac(iface,2);
-				ijp[1] = m->gintfac(iface,3);
-				a_real coord[NDIM];
-				for(int j = 0; j < NDIM; j++) 
-				{
-					coord[j] = 0;
-					for(int inofa = 0; inofa < m->gnnofa(); inofa++)
-						coord[j] += m->gcoords(ijp[inofa],j);
-					coord[j] /= m->gnnofa();
-					
-					output(facecoun,j) = coord[j];
-				}
-
-				output(facecoun,NDIM) =  u(lelem,1)/u(lelem,0);
-				output(facecoun,NDIM+1)= u(lelem,2)/u(lelem,0);
-
-				facecoun++;
+				a_real coord = 0;
+				for(int inofa = 0; inofa < m->gnnofa(); inofa++)
+					coord += m->gcoords(m->gintfac(iface,2+inofa),j);
+				output(facecoun,j) = coord / m->gnnofa();
 			}
+
+			output(facecoun,NDIM) =  u(lelem,1)/u(lelem,0);
+			output(facecoun,NDIM+1)= u(lelem,2)/u(lelem,0);
 		}
 		
 		// write out the output
@@ -5,10 +5,48 @@
 #ifndef AOUTPUT_H
 #define AOUTPUT_H 1
 
+#include <map>
 #include "flow_spatial.hpp"
 
 namespace fvens {
 
+/// Floating-point formats in which field output can be written
+enum OutputPrecision { FLOAT16, FLOAT32, FLOAT64 };
+
+/// Specification of a selective output of cell-centred flow fields
+/** The fields that can be selected are `coordinates' (of cell centres), `density', `velocity',
+ * `pressure', `temperature' and `mach-number'. A cell is written if its centre lies in the box
+ * (when one is given) and its first volume region tag is one of the listed tags (when some
+ * are given).
+ */
+struct FieldOutputConfig
+{
+	std::string file;                   ///< File to write; if empty, no field output is written
+	std::vector<std::string> fields;    ///< Names of the fields to write, in order
+	OutputPrecision precision;          ///< Format of the values written
+	std::vector<a_real> box;            ///< Bounds xmin ymin xmax ymax of cell centres, or empty
+	std::vector<int> regiontags;        ///< Volume region tags of cells to write, or empty
+};
+
+/// Field data read back from a field output file
+struct FieldOutputData
+{
+	std::vector<a_int> cells;                          ///< Indices of the cells written
+	std::vector<std::string> fields;                   ///< Names of fields in the file, in order
+	std::map<std::string,int> ncomps;                  ///< Number of components of each field
+	/// Values of each field, with the components of a cell consecutive
+	std::map<std::string,std::vector<a_real>> values;
+};
+
+/// Number of components of a field that can be selected for output, or 0 if there's no such field
+int getOutputFieldComponents(const std::string& name);
+
+/// Converts the name of a precision (FLOAT16, FLOAT32 or FLOAT64, in any case) to the precision
+OutputPrecision parseOutputPrecision(const std::string& name);
+
+/// Reads a file written by \ref FlowOutput::exportFields
+FieldOutputData readFieldOutput(const std::string& file);
+
 /// Interface for output to files
 template <short nvars>
 class Output
@@ -71,6 +109,17 @@ public:
 	 */
 	void exportVolumeData(const MVector<a_real>& u, const std::string volfile) const;
 
+	/// Writes only the selected cell-centred fields in a selected region, in binary
+	/** The values are computed directly from the conserved variables of the selected cells, and
+	 * written in the requested precision. The file begins with a text header of a few lines
+	 * describing the contents, ending with the line `data'. Then, if a region was selected, the
+	 * indices of the selected cells are written as 32-bit integers. Finally, each field is written
+	 * in turn for all selected cells, with the components of each cell's value consecutive.
+	 * Binary data is in the byte order of the machine, which is given in the header.
+	 * \sa readFieldOutput
+	 */
+	StatusCode exportFields(const Vec uvec, const FieldOutputConfig& config) const;
+
 	/// Export surface data
 	/** We compute pressure and skin-friction coefficients for wall boundaries, and
 	 * normalized x- and y-velocities along other boundaries.
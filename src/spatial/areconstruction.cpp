@@ -82,10 +82,41 @@ void LinearUnlimitedReconstruction<scalar,nvars>::compute_face_values(
 	}
 }
 
+template <typename scalar, int nvars>
+void LinearUnlimitedReconstruction<scalar,nvars>::compute_cell_face_values(const a_int iel,
+		const scalar *const ucell, const scalar *const *const unbrs,
+		const Eigen::Array<scalar,NDIM,nvars>& grad,
+		const Eigen::Array<scalar,NDIM,nvars> *const *const nbrgrads,
+		scalar *const *const ufaces) const
+{
+	for(int jface = 0; jface < m->gnfael(iel); jface++)
+	{
+		const a_int face = m->gelemface(iel,jface);
+		for(int i = 0; i < nvars; i++)
+			ufaces[jface][i] = linearExtrapolate(ucell[i], grad, i, 1.0, &gr[face](0,0), &ri(iel,0));
+	}
+}
+
 template class SolutionReconstruction<a_real,NVARS>;
 template class SolutionReconstruction<a_real,1>;
 template class LinearUnlimitedReconstruction<a_real,NVARS>;
 template class LinearUnlimitedReconstruction<a_real,1>;
+template class SolutionReconstruction<a_real,NVARS+1>;
+template class LinearUnlimitedReconstruction<a_real,NVARS+1>;
+
+// for residuals of batches of 4, 8 and 16 interleaved states
+template class SolutionReconstruction<a_real,4*NVARS>;
+template class LinearUnlimitedReconstruction<a_real,4*NVARS>;
+template class SolutionReconstruction<a_real,8*NVARS>;
+template class LinearUnlimitedReconstruction<a_real,8*NVARS>;
+template class SolutionReconstruction<a_real,16*NVARS>;
+template class LinearUnlimitedReconstruction<a_real,16*NVARS>;
+template class SolutionReconstruction<a_real,4*(NVARS+1)>;
+template class LinearUnlimitedReconstruction<a_real,4*(NVARS+1)>;
+template class SolutionReconstruction<a_real,8*(NVARS+1)>;
+template class LinearUnlimitedReconstruction<a_real,8*(NVARS+1)>;
+template class SolutionReconstruction<a_real,16*(NVARS+1)>;
+template class LinearUnlimitedReconstruction<a_real,16*(NVARS+1)>;
 
 } // end namespace
 
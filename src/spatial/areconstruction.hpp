@@ -36,6 +36,22 @@ public:
 	                                 amat::Array2d<scalar>& uface_left,
 	                                 amat::Array2d<scalar>& uface_right) const = 0;
 
+	/// Computes the values at the faces of one cell on its side of each face
+	/** This gives the same values as \ref compute_face_values on that cell's sides of its faces.
+	 * \param[in] iel The cell
+	 * \param[in] ucell The state of the cell
+	 * \param[in] unbrs For each face of the cell, in the order of \ref UMesh2dh::gelemface, the state
+	 *   of the neighbour across it, or the ghost state if it is a boundary face
+	 * \param[in] grad The gradient of the cell
+	 * \param[in] nbrgrads For each face of the cell, the gradient of the neighbour across it, or
+	 *   NULL if it is a boundary face
+	 * \param[out] ufaces For each face of the cell, the location of its face value
+	 */
+	virtual void compute_cell_face_values(const a_int iel, const scalar *const ucell,
+		const scalar *const *const unbrs, const Eigen::Array<scalar,NDIM,nvars>& grad,
+		const Eigen::Array<scalar,NDIM,nvars> *const *const nbrgrads,
+		scalar *const *const ufaces) const = 0;
+
 	virtual ~SolutionReconstruction();
 };
 
@@ -58,6 +74,12 @@ public:
 	                         amat::Array2d<scalar>& uface_left,
 	                         amat::Array2d<scalar>& uface_right) const;
 
+	void compute_cell_face_values(const a_int iel, const scalar *const ucell,
+	                              const scalar *const *const unbrs,
+	                              const Eigen::Array<scalar,NDIM,nvars>& grad,
+	                              const Eigen::Array<scalar,NDIM,nvars> *const *const nbrgrads,
+	                              scalar *const *const ufaces) const;
+
 protected:
 	using SolutionReconstruction<scalar,nvars>::m;
 	using SolutionReconstruction<scalar,nvars>::ri;
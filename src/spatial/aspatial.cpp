@@ -100,6 +100,43 @@ Spatial<scalar,nvars>::~Spatial()
 	delete [] gr;
 }
 
+template<typename scalar, int nvars>
+StatusCode Spatial<scalar,nvars>::compute_local_residual(const LocalStencil& st,
+                                                         const scalar *const u,
+                                                         const scalar *const urows,
+                                                         scalar *const rrows) const
+{
+	StatusCode ierr = 0;
+	const PetscInt nloc = m->gnelem()*nvars;
+	Vec uvec, rvec;
+	ierr = VecCreateSeq(PETSC_COMM_SELF, nloc, &uvec); CHKERRQ(ierr);
+	ierr = VecDuplicate(uvec, &rvec); CHKERRQ(ierr);
+
+	scalar *ua;
+	ierr = VecGetArray(uvec, &ua); CHKERRQ(ierr);
+	for(a_int i = 0; i < nloc; i++)
+		ua[i] = u[i];
+	for(a_int l = 0; l < st.nrows; l++)
+		for(int j = 0; j < nvars; j++)
+			ua[st.cells[l]*nvars+j] = urows[l*nvars+j];
+	ierr = VecRestoreArray(uvec, &ua); CHKERRQ(ierr);
+
+	std::vector<a_real> dtmdummy;
+	ierr = VecSet(rvec, 0.0); CHKERRQ(ierr);
+	ierr = assemble_residual(uvec, rvec, false, dtmdummy); CHKERRQ(ierr);
+
+	const scalar *ra;
+	ierr = VecGetArrayRead(rvec, &ra); CHKERRQ(ierr);
+	for(a_int l = 0; l < st.nrows; l++)
+		for(int j = 0; j < nvars; j++)
+			rrows[l*nvars+j] = ra[st.cells[l]*nvars+j];
+	ierr = VecRestoreArrayRead(rvec, &ra); CHKERRQ(ierr);
+
+	ierr = VecDestroy(&uvec); CHKERRQ(ierr);
+	ierr = VecDestroy(&rvec); CHKERRQ(ierr);
+	return ierr;
+}
+
 template<typename scalar, int nvars>
 void Spatial<scalar,nvars>::compute_ghost_cell_coords_about_midpoint(amat::Array2d<scalar>& rchg)
 {
@@ -168,11 +205,12 @@ void Spatial<scalar,nvars>::compute_ghost_cell_coords_about_face(amat::Array2d<s
 }
 
 template <typename scalar, int nvars>
+template <int nv>
 void Spatial<scalar,nvars>::
 getFaceGradient_modifiedAverage(const a_int iface,
                                 const scalar *const ucl, const scalar *const ucr,
                                 const scalar *const gradl, const scalar *const gradr,
-                                scalar grad[NDIM][nvars]) const
+                                scalar grad[NDIM][nv]) const
 {
 	scalar dr[NDIM], dist=0;
 	const a_int lelem = m->gintfac(iface,0);
@@ -187,12 +225,12 @@ getFaceGradient_modifiedAverage(const a_int iface,
 		dr[i] /= dist;
 	}
 
-	for(int i = 0; i < nvars; i++) 
+	for(int i = 0; i < nv; i++) 
 	{
 		scalar davg[NDIM];
 		
 		for(int j = 0; j < NDIM; j++)
-			davg[j] = 0.5*(gradl[j*nvars+i] + gradr[j*nvars+i]);
+			davg[j] = 0.5*(gradl[j*nv+i] + gradr[j*nv+i]);
 
 		const scalar corr = (ucr[i]-ucl[i])/dist;
 		
@@ -206,10 +244,11 @@ getFaceGradient_modifiedAverage(const a_int iface,
 }
 
 template <typename scalar, int nvars>
+template <int nv>
 void Spatial<scalar,nvars>::getFaceGradientAndJacobian_thinLayer(const a_int iface,
 		const a_real *const ucl, const a_real *const ucr,
 		const a_real *const dul, const a_real *const dur,
-		a_real grad[NDIM][nvars], a_real dgradl[NDIM][nvars][nvars], a_real dgradr[NDIM][nvars][nvars])
+		a_real grad[NDIM][nv], a_real dgradl[NDIM][nv][nv], a_real dgradr[NDIM][nv][nv])
 	const
 {
 	a_real dr[NDIM], dist=0;
@@ -225,7 +264,7 @@ void Spatial<scalar,nvars>::getFaceGradientAndJacobian_thinLayer(const a_int ifa
 		dr[i] /= dist;
 	}
 
-	for(int i = 0; i < nvars; i++) 
+	for(int i = 0; i < nv; i++) 
 	{
 		const a_real corr = (ucr[i]-ucl[i])/dist;        //< The thin layer gradient magnitude
 		
@@ -233,15 +272,49 @@ void Spatial<scalar,nvars>::getFaceGradientAndJacobian_thinLayer(const a_int ifa
 		{
 			grad[j][i] = corr*dr[j];
 			
-			for(int k = 0; k < nvars; k++) {
-				dgradl[j][i][k] = -dul[i*nvars+k]/dist * dr[j];
-				dgradr[j][i][k] = dur[i*nvars+k]/dist * dr[j];
+			for(int k = 0; k < nv; k++) {
+				dgradl[j][i][k] = -dul[i*nv+k]/dist * dr[j];
+				dgradr[j][i][k] = dur[i*nv+k]/dist * dr[j];
 			}
 		}
 	}
 }
 
 template class Spatial<a_real,NVARS>;
+template class Spatial<a_real,NVARS+1>;
 template class Spatial<a_real,1>;
 
+template void Spatial<a_real,NVARS>::getFaceGradient_modifiedAverage<NVARS>(const a_int iface,
+		const a_real *const ucl, const a_real *const ucr,
+		const a_real *const gradl, const a_real *const gradr, a_real grad[NDIM][NVARS]) const;
+// the SA working variable alone, compiled for the flow without extra variables as well
+template void Spatial<a_real,NVARS>::getFaceGradient_modifiedAverage<1>(const a_int iface,
+		const a_real *const ucl, const a_real *const ucr,
+		const a_real *const gradl, const a_real *const gradr, a_real grad[NDIM][1]) const;
+template void Spatial<a_real,NVARS+1>::getFaceGradient_modifiedAverage<1>(const a_int iface,
+		const a_real *const ucl, const a_real *const ucr,
+		const a_real *const gradl, const a_real *const gradr, a_real grad[NDIM][1]) const;
+template void Spatial<a_real,NVARS>::getFaceGradientAndJacobian_thinLayer<NVARS>(const a_int iface,
+		const a_real *const ucl, const a_real *const ucr,
+		const a_real *const dul, const a_real *const dur,
+		a_real grad[NDIM][NVARS], a_real dgradl[NDIM][NVARS][NVARS], a_real dgradr[NDIM][NVARS][NVARS])
+	const;
+template void Spatial<a_real,1>::getFaceGradient_modifiedAverage<1>(const a_int iface,
+		const a_real *const ucl, const a_real *const ucr,
+		const a_real *const gradl, const a_real *const gradr, a_real grad[NDIM][1]) const;
+template void Spatial<a_real,1>::getFaceGradientAndJacobian_thinLayer<1>(const a_int iface,
+		const a_real *const ucl, const a_real *const ucr,
+		const a_real *const dul, const a_real *const dur,
+		a_real grad[NDIM][1], a_real dgradl[NDIM][1][1], a_real dgradr[NDIM][1][1])
+	const;
+// the flow variables of flow with a passive scalar
+template void Spatial<a_real,NVARS+1>::getFaceGradient_modifiedAverage<NVARS>(const a_int iface,
+		const a_real *const ucl, const a_real *const ucr,
+		const a_real *const gradl, const a_real *const gradr, a_real grad[NDIM][NVARS]) const;
+template void Spatial<a_real,NVARS+1>::getFaceGradientAndJacobian_thinLayer<NVARS>(const a_int iface,
+		const a_real *const ucl, const a_real *const ucr,
+		const a_real *const dul, const a_real *const dur,
+		a_real grad[NDIM][NVARS], a_real dgradl[NDIM][NVARS][NVARS], a_real dgradr[NDIM][NVARS][NVARS])
+	const;
+
 }	// end namespace
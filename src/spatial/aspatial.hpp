@@ -28,11 +28,19 @@
 #include "utilities/aarray2d.hpp"
 
 #include "mesh/amesh2dh.hpp"
+#include "mesh/localstencil.hpp"
 
 #include <petscmat.h>
 
 namespace fvens {
 
+/// Information about an update of a Jacobian matrix \sa Spatial::update_jacobian
+struct JacobianUpdateInfo
+{
+	bool full;                ///< Whether the matrix was zeroed and recomputed entirely
+	a_real fraction;          ///< Fraction of faces whose contributions were recomputed
+};
+
 /// Base class for finite volume spatial discretization
 template<typename scalar, int nvars>
 class Spatial
@@ -61,16 +69,129 @@ public:
 	 */
 	virtual StatusCode assemble_residual(const Vec u, Vec residual, 
 			const bool gettimesteps, std::vector<a_real>& dtm) const = 0;
+
+	/// Computes the residual and local time steps for a pseudo-time iteration of a steady problem
+	/** Discretizations may re-use parts of the residual computed in earlier calls where the state
+	 * has not changed appreciably since, so this is only meant to be called once per pseudo-time
+	 * step with the current iterate. By default, just calls \ref assemble_residual.
+	 */
+	virtual StatusCode assemble_pseudotime_residual(const Vec u, Vec residual,
+			const bool gettimesteps, std::vector<a_real>& dtm) const
+	{
+		return assemble_residual(u, residual, gettimesteps, dtm);
+	}
+
+	/// Whether the last residual of \ref assemble_pseudotime_residual was computed entirely anew
+	/** If not, decisions that must not depend on re-used parts, such as declaring convergence,
+	 * need the residual from \ref assemble_residual. The default residual is always exact.
+	 */
+	virtual bool last_pseudotime_residual_exact() const { return true; }
+
+	/// Makes the next \ref assemble_pseudotime_residual compute the whole residual
+	/** To be called at the start of a solve. The default does nothing, since the default
+	 * pseudo-time residual re-uses nothing.
+	 */
+	virtual void reset_pseudotime_residual() const { }
 	
+	/// Computes the residual of some cells where only those cells' states differ from a given state
+	/** The residual (-r, as in \ref assemble_residual) of the rows of the stencil is computed at
+	 * the state which is urows at the rows and u everywhere else. Discretizations that can, only
+	 * visit the stencil and work in arrays of its size. The default evaluates the residual of the
+	 * whole mesh at a full copy of the state.
+	 * \param[in] st The rows and their neighbours, with at least \ref localStencilLayers layers
+	 * \param[in] u The state of all cells
+	 * \param[in] urows The states of the rows, in the order of the stencil
+	 * \param[out] rrows The residuals of the rows; overwritten
+	 */
+	virtual StatusCode compute_local_residual(const LocalStencil& st, const scalar *const u,
+	                                          const scalar *const urows, scalar *const rrows) const;
+
+	/// Number of layers of neighbours that \ref compute_local_residual needs around the rows
+	virtual int localStencilLayers() const { return 0; }
+
 	/// Computes the Jacobian matrix of the residual r(u) \sa assemble_residual
 	/** It is supposed to compute dr/du when we want to solve [M du/dt +] r(u) = 0.
 	 */
 	virtual StatusCode compute_jacobian(const Vec u, Mat A) const = 0;
 
+	/// Updates a Jacobian matrix computed earlier by this object to a new state
+	/** The matrix must contain the Jacobian at some earlier state, computed by the last call to
+	 * this function, plus possibly other terms added by the caller. Discretizations may update
+	 * only the contributions that depend on cells whose state has changed, in which case the
+	 * other terms are left as they are; otherwise, the matrix is zeroed and recomputed. The
+	 * default does the latter.
+	 * \param[in] u The new state
+	 * \param[in,out] A The Jacobian matrix
+	 * \param[out] info Whether the update was full, and the fraction of faces recomputed
+	 */
+	virtual StatusCode update_jacobian(const Vec u, Mat A, JacobianUpdateInfo& info) const
+	{
+		StatusCode ierr = MatZeroEntries(A); CHKERRQ(ierr);
+		info.full = true;
+		info.fraction = 1.0;
+		return compute_jacobian(u, A);
+	}
+
+	/// Makes the next \ref update_jacobian recompute the whole matrix
+	/** Must be called before updating a matrix that was not last updated by update_jacobian,
+	 * such as a new matrix or one filled by \ref compute_jacobian, eg. at the start of a solve.
+	 * The default does nothing, since the default update_jacobian is always full.
+	 */
+	virtual void reset_jacobian_updates() const { }
+
 	/// Computes gradients of field variables and stores them in the argument
 	virtual void getGradients(const MVector<a_real>& u,
 	                          GradArray<a_real,nvars>& grads) const = 0;
 
+	/// Computes force coefficients on the walls, for monitoring the convergence of a solve
+	/** Must be called with the state at which the residual (with time steps) was last computed.
+	 * \param[in] u The state
+	 * \param[out] forces Lift, pressure drag and skin friction drag coefficients
+	 * \return False if the discretization does not compute forces, in which case forces is not
+	 *   touched. This is the default.
+	 */
+	virtual bool computeWallForces(const scalar *const u, scalar *const forces) const
+	{
+		return false;
+	}
+
+	/// Whether the pseudo-time derivative is preconditioned \sa getPseudoTimePreconditioner
+	virtual bool hasPseudoTimePreconditioner() const { return false; }
+
+	/// Computes the preconditioning matrix of the pseudo-time derivative of a cell, or its inverse
+	/** With a preconditioned pseudo-time derivative, the ODE of pseudo-time stepping is
+	 * \f$ M P^{-1} du/d\tau + r(u) = 0 \f$, so the pseudo-time term of the Jacobian of an implicit
+	 * step is \f$ \frac{V}{\Delta\tau} P^{-1} \f$, while an explicit step is
+	 * \f$ \Delta u = \frac{\Delta\tau}{V} P (-r(u)) \f$. The local time steps computed by
+	 * \ref assemble_residual then correspond to the preconditioned system. This is only called if
+	 * \ref hasPseudoTimePreconditioner returns true.
+	 * \param[in] u The state of the cell
+	 * \param[in] inverse If true, \f$ P^{-1} \f$ is computed, otherwise P
+	 * \param[out] mat The nvars x nvars matrix in row-major order
+	 */
+	virtual void getPseudoTimePreconditioner(const scalar *const u, const bool inverse,
+	                                         scalar *const mat) const
+	{ }
+
+	/// Multiplies a vector of one cell by its pseudo-time preconditioning matrix or its inverse
+	/** \sa getPseudoTimePreconditioner
+	 * \param[in] u The state of the cell
+	 * \param[in] inverse If true, \f$ P^{-1}x \f$ is computed, otherwise \f$ Px \f$
+	 * \param[in] x The vector to multiply
+	 * \param[out] y The product; must not alias x
+	 */
+	void applyPseudoTimePreconditioner(const scalar *const u, const bool inverse,
+	                                   const scalar *const x, scalar *const __restrict y) const
+	{
+		scalar mat[nvars*nvars];
+		getPseudoTimePreconditioner(u, inverse, mat);
+		for(int i = 0; i < nvars; i++) {
+			y[i] = 0;
+			for(int j = 0; j < nvars; j++)
+				y[i] += mat[i*nvars+j]*x[j];
+		}
+	}
+
 	/// Sets initial conditions
 	/** \param[in] fromfile True if initial data is to be read from a file
 	 * \param[in] file Name of initial conditions file
@@ -108,13 +229,17 @@ protected:
 	/** \param iface The \ref intfac index of the face at which the gradient is to be computed
 	 * \param ucl The left cell-centred state
 	 * \param ucr The right cell-centred state
-	 * \param gradl Left cell-centred gradients (ndim x nvars flattened array)
-	 * \param gradr Right cell-centred gradients (ndim x nvars flattened array)
+	 * \param gradl Left cell-centred gradients (ndim x nv flattened array)
+	 * \param gradr Right cell-centred gradients (ndim x nv flattened array)
 	 * \param[out] grad Face gradients
+	 *
+	 * The template parameter nv is the number of variables, from the first, for which the gradient
+	 * is needed; it is usually nvars.
 	 */
+	template <int nv>
 	void getFaceGradient_modifiedAverage(const a_int iface,
 		const scalar *const ucl, const scalar *const ucr,
-		const scalar *const gradl, const scalar *const gradr, scalar grad[NDIM][nvars])
+		const scalar *const gradl, const scalar *const gradr, scalar grad[NDIM][nv])
 		const;
 
 	/// Computes the thin-layer face gradient and its Jacobian w.r.t. the left and right states
@@ -128,11 +253,14 @@ protected:
 	 * \param[out] grad Face gradients
 	 * \param[out] dgradl Jacobian of left cell-centred gradients
 	 * \param[out] dgradr Jacobian of right cell-centred gradients
+	 *
+	 * As for \ref getFaceGradient_modifiedAverage, nv is the number of variables involved.
 	 */
+	template <int nv>
 	void getFaceGradientAndJacobian_thinLayer(const a_int iface,
 		const a_real *const ucl, const a_real *const ucr,
 		const a_real *const dul, const a_real *const dur,
-		a_real grad[NDIM][nvars], a_real dgradl[NDIM][nvars][nvars], a_real dgradr[NDIM][nvars][nvars])
+		a_real grad[NDIM][nv], a_real dgradl[NDIM][nv][nv], a_real dgradr[NDIM][nv][nv])
 		const;
 };
 
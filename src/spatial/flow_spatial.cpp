@@ -19,66 +19,409 @@
 
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
+#include <mutex>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "physics/viscousphysics.hpp"
 #include "utilities/afactory.hpp"
+#include "utilities/aoptionparser.hpp"
+#include "utilities/perfcounters.hpp"
+#include "utilities/aerrorhandling.hpp"
 #include "abctypemap.hpp"
 #include "flow_spatial.hpp"
 
 namespace fvens {
 
+/// Creates an active-set tracker if requested by the PETSc options
+template <typename scalar, int nvars>
+static ActiveSetResidual<scalar,nvars>* createActiveSet(const UMesh2dh<scalar> *const mesh)
+{
+	const ActiveSetConfig config = parseActiveSetConfig("-active_set", 2, 20);
+	if(!config.enabled)
+		return nullptr;
+
+	std::cout << " FlowFV_base: Re-using fluxes away from cells changing by less than "
+	          << config.threshold << " relative,\n   with full refreshes every "
+	          << config.refreshinterval << " pseudo-time residuals.\n";
+	return new ActiveSetResidual<scalar,nvars>(mesh, config);
+}
+
+/// Creates an active-set tracker for incremental Jacobian updates if requested
+/** Not used for turbulent flow, since the source term of the turbulence model couples the
+ * Jacobian blocks of a cell to all its neighbours' states through the vorticity.
+ */
+template <typename scalar, int nvars>
+static ActiveSetJacobian<a_real,nvars>* createJacobianActiveSet(const UMesh2dh<scalar> *const mesh,
+                                                               const FlowPhysicsConfig& pconf)
+{
+	const ActiveSetConfig config = parseActiveSetConfig("-jacobian_active_set", 0, 10);
+	if(!config.enabled)
+		return nullptr;
+	if(isTurbulent(pconf)) {
+		std::cout << " FlowFV_base: Incremental Jacobian updates are not available for turbulent"
+			" flow.\n";
+		return nullptr;
+	}
+
+	std::cout << " FlowFV_base: Updating Jacobian blocks only next to cells changing by more than "
+	          << config.threshold << " relative,\n   with full refreshes every "
+	          << config.refreshinterval << " Jacobian updates.\n";
+	return new ActiveSetJacobian<a_real,nvars>(mesh, config);
+}
+
+a_real getSAFreestreamWorkingVariable(const a_real muinf)
+{
+	// the free-stream density is 1
+	return muinf*parseOptionalPetscCmd_real("-sa_freestream_viscosity_ratio", 3.0);
+}
+
+/// Reads the free-stream values of passive scalars from `-passive_scalar_freestream'
+/** Scalars not given are set to zero. For turbulent flow, the free-stream value of the SA working
+ * variable is given by \ref getSAFreestreamWorkingVariable instead.
+ */
+template <int nvars>
+static std::array<a_real,nvars-NVARS> parsePassiveScalarFreestream(const FlowPhysicsConfig& pconf)
+{
+	std::array<a_real,nvars-NVARS> vals;
+	vals.fill(0);
+	if(nvars > NVARS && isTurbulent(pconf)) {
+		vals.fill(getSAFreestreamWorkingVariable(1.0/pconf.Reinf));
+	}
+	else if(nvars > NVARS) {
+		const std::vector<PetscReal> opt
+			= parseOptionalPetscCmd_realArray("-passive_scalar_freestream", nvars-NVARS);
+		for(size_t i = 0; i < opt.size(); i++)
+			vals[i] = opt[i];
+	}
+	return vals;
+}
+
+/// Creates the wall distance computation over the no-slip walls if the flow is turbulent
 template <typename scalar>
-FlowFV_base<scalar>::FlowFV_base(const UMesh2dh<scalar> *const mesh,
-                                 const FlowPhysicsConfig& pconf, 
-                                 const FlowNumericsConfig& nconf)
+static WallDistance<scalar>* createWallDistance(const UMesh2dh<scalar> *const mesh,
+                                                const FlowPhysicsConfig& pconf)
+{
+	if(!isTurbulent(pconf))
+		return nullptr;
+
+	std::vector<int> wallmarkers;
+	for(auto it = pconf.bcconf.begin(); it != pconf.bcconf.end(); it++)
+		if(it->bc_type == ADIABATIC_WALL_BC || it->bc_type == ISOTHERMAL_WALL_BC)
+			wallmarkers.push_back(it->bc_tag);
+
+	return new WallDistance<scalar>(mesh, wallmarkers);
+}
+
+/// Returns the markers of all slip and no-slip walls
+static std::vector<int> getWallMarkers(const FlowPhysicsConfig& pconf)
+{
+	std::vector<int> wallmarkers;
+	for(auto it = pconf.bcconf.begin(); it != pconf.bcconf.end(); it++)
+		if(it->bc_type == SLIP_WALL_BC || it->bc_type == ADIABATIC_WALL_BC
+		   || it->bc_type == ISOTHERMAL_WALL_BC)
+			wallmarkers.push_back(it->bc_tag);
+	return wallmarkers;
+}
+
+/// Computes the eddy viscosity of the SA model from a conserved state
+/** Zero if there is no working variable.
+ */
+template <typename scalar, int nvars>
+static inline scalar saEddyViscosity(const SpalartAllmaras<scalar>& sa, const scalar *const u,
+                                     const scalar mu)
+{
+	scalar mut = 0;
+	for(int k = NVARS; k < nvars; k++)
+		mut = sa.eddyViscosity(u[0], u[k]/u[0], mu);
+	return mut;
+}
+
+/// Converts passive scalars from conserved (density times scalar) to primitive form
+/** Only reads the density uc[0], so uc and up can point to the same storage after conversion of
+ * the flow variables, as the density is a primitive variable as well.
+ */
+template <typename scalar, int nvars>
+static inline void passiveScalarsToPrimitive(const scalar *const uc, scalar *const up)
+{
+	for(int k = NVARS; k < nvars; k++)
+		up[k] = uc[k]/uc[0];
+}
+
+/// Converts passive scalars from primitive form to density times scalar
+template <typename scalar, int nvars>
+static inline void passiveScalarsToConserved(const scalar *const up, scalar *const uc)
+{
+	for(int k = NVARS; k < nvars; k++)
+		uc[k] = up[k]*up[0];
+}
+
+/// Number of states converted together by the batch conversion routines of the gas physics
+static constexpr a_int conversion_batch = 64;
+
+/// Number of states in the batch beginning at some index of a range ending at another index
+static inline a_int batchSize(const a_int start, const a_int end)
+{
+	return std::min(conversion_batch, end-start);
+}
+
+/// Converts consecutive states, stored as rows of length nvars, from conserved to primitive
+template <typename scalar, int nvars>
+static inline void statesToPrimitive(const IdealGasPhysics<scalar>& physics, const a_int n,
+                                     const scalar *const uc, scalar *const up)
+{
+	physics.getPrimitiveFromConservedBatch(n, nvars, uc, up);
+	for(a_int i = 0; i < n; i++)
+		passiveScalarsToPrimitive<scalar,nvars>(&uc[i*nvars], &up[i*nvars]);
+}
+
+/// Converts consecutive states, stored as rows of length nvars, from primitive to conserved
+template <typename scalar, int nvars>
+static inline void statesToConserved(const IdealGasPhysics<scalar>& physics, const a_int n,
+                                     const scalar *const up, scalar *const uc)
+{
+	physics.getConservedFromPrimitiveBatch(n, nvars, up, uc);
+	for(a_int i = 0; i < n; i++)
+		passiveScalarsToConserved<scalar,nvars>(&up[i*nvars], &uc[i*nvars]);
+}
+
+/// Computes the fluxes of passive scalars as the mass flux times the upwind scalar
+/** \param[in] ul Left conserved state
+ * \param[in] ur Right conserved state
+ * \param[in,out] flux On input, the flux of the flow variables; on output, the fluxes of the
+ *   passive scalars are also set
+ */
+template <typename scalar, int nvars>
+static inline void passiveScalarFlux(const scalar *const ul, const scalar *const ur,
+                                     scalar *const flux)
+{
+	for(int k = NVARS; k < nvars; k++)
+		flux[k] = flux[0] >= 0 ? flux[0]*ul[k]/ul[0] : flux[0]*ur[k]/ur[0];
+}
+
+/// Computes the Jacobian of a ghost state including passive scalars w.r.t. the interior state
+/** The ghost passive scalars are density times either the free-stream or the interior scalar, the
+ * latter multiplied by a sign.
+ * \param[in] imposed Whether the free-stream scalars are imposed
+ * \param[in] sign Factor multiplying the extrapolated scalars, 1 or -1
+ * \param[in] ui Interior conserved state
+ * \param[in] ug Ghost conserved state
+ * \param[in] dflow Jacobian of the ghost flow variables w.r.t. the interior flow variables
+ * \param[out] dug The full Jacobian, row-major
+ */
+template <int nvars>
+static void passiveScalarGhostJacobian(const bool imposed, const a_real sign,
+                                       const a_real *const ui,
+                                       const a_real *const ug, const a_real *const dflow,
+                                       a_real *const dug)
+{
+	Eigen::Map<const Matrix<a_real,NVARS,NVARS,RowMajor>> dfl(dflow);
+	Eigen::Map<Matrix<a_real,nvars,nvars,RowMajor>> dg(dug);
+	dg.setZero();
+	dg.template topLeftCorner<NVARS,NVARS>() = dfl;
+
+	for(int k = NVARS; k < nvars; k++) {
+		dg.template block<1,NVARS>(k,0) = ug[k]/ug[0]*dfl.row(0);
+		if(!imposed) {
+			dg(k,k) += sign*ug[0]/ui[0];
+			dg(k,0) -= sign*ug[0]*ui[k]/(ui[0]*ui[0]);
+		}
+	}
+}
+
+/// Assembles the Jacobian blocks of a face's flux including passive scalars
+/** The passive scalar fluxes are given by \ref passiveScalarFlux. The blocks follow the convention
+ * of the numerical fluxes, ie., L is the negative of the derivative w.r.t. the left state and U is
+ * the derivative w.r.t. the right state.
+ * \param[in] ul Left conserved state
+ * \param[in] ur Right conserved state
+ * \param[in] mdot Mass flux from left to right
+ * \param[in] Lflow Block of the flow variables w.r.t. the left flow variables
+ * \param[in] Uflow Block of the flow variables w.r.t. the right flow variables
+ * \param[out] L The full lower block, row-major
+ * \param[out] U The full upper block, row-major
+ */
+template <int nvars>
+static void passiveScalarFluxJacobian(const a_real *const ul, const a_real *const ur,
+                                      const a_real mdot,
+                                      const a_real *const Lflow, const a_real *const Uflow,
+                                      a_real *const L, a_real *const U)
+{
+	Eigen::Map<const Matrix<a_real,NVARS,NVARS,RowMajor>> Lf(Lflow);
+	Eigen::Map<const Matrix<a_real,NVARS,NVARS,RowMajor>> Uf(Uflow);
+	Eigen::Map<Matrix<a_real,nvars,nvars,RowMajor>> Lm(L);
+	Eigen::Map<Matrix<a_real,nvars,nvars,RowMajor>> Um(U);
+	Lm.setZero(); Um.setZero();
+	Lm.template topLeftCorner<NVARS,NVARS>() = Lf;
+	Um.template topLeftCorner<NVARS,NVARS>() = Uf;
+
+	const bool fromleft = mdot >= 0;
+	for(int k = NVARS; k < nvars; k++)
+	{
+		const a_real phi = fromleft ? ul[k]/ul[0] : ur[k]/ur[0];
+
+		// through the mass flux
+		Lm.template block<1,NVARS>(k,0) = phi*Lf.row(0);
+		Um.template block<1,NVARS>(k,0) = phi*Uf.row(0);
+
+		// through the upwind scalar
+		if(fromleft) {
+			Lm(k,k) -= mdot/ul[0];
+			Lm(k,0) += mdot*phi/ul[0];
+		}
+		else {
+			Um(k,k) += mdot/ur[0];
+			Um(k,0) -= mdot*phi/ur[0];
+		}
+	}
+}
+
+/// Adds approximate Jacobians of the eddy-viscous fluxes and of the diffusion of the SA working
+/// variable to the flux Jacobian blocks of a face
+/** Both use the thin-layer approximation with the eddy viscosity and the diffusivity frozen, like
+ * FlowFV::compute_viscous_flux_approximate_jacobian. The blocks follow the convention of
+ * \ref passiveScalarFluxJacobian.
+ * \param[in] ul Left conserved state
+ * \param[in] ur Right conserved state
+ * \param[in] mu Molecular viscosity at the face
+ * \param[in] dist Distance between the left and right cell centres divided by the cosine of the
+ *   angle between the line joining them and the face normal, see FlowFV::projectedCentreDistance
+ * \param[in,out] L The full lower block, row-major
+ * \param[in,out] U The full upper block, row-major
+ */
+template <typename scalar, int nvars>
+static void addTurbulentFluxJacobian(const SpalartAllmaras<scalar>& sa,
+                                     const a_real *const ul, const a_real *const ur,
+                                     const a_real mu, const a_real dist,
+                                     a_real *const L, a_real *const U)
+{
+	Eigen::Map<Matrix<a_real,nvars,nvars,RowMajor>> Lm(L);
+	Eigen::Map<Matrix<a_real,nvars,nvars,RowMajor>> Um(U);
+
+	const a_real rho = 0.5*(ul[0]+ur[0]);
+	for(int k = NVARS; k < nvars; k++)
+	{
+		const a_real nut = 0.5*(ul[k]/ul[0] + ur[k]/ur[0]);
+		const a_real mut = sa.eddyViscosity(rho, nut, mu);
+		const a_real diff = sa.diffusivity(rho, nut, mu);
+
+		for(int i = 0; i < NVARS; i++) {
+			Lm(i,i) -= mut/(rho*dist);
+			Um(i,i) -= mut/(rho*dist);
+		}
+		Lm(k,k) -= diff/(ul[0]*dist);
+		Um(k,k) -= diff/(ur[0]*dist);
+	}
+}
+
+template <typename scalar, int nvars>
+FlowFV_base<scalar,nvars>::FlowFV_base(const UMesh2dh<scalar> *const mesh,
+                                       const FlowPhysicsConfig& pconf,
+                                       const FlowNumericsConfig& nconf)
 	: 
-	Spatial<scalar,NVARS>(mesh), 
+	Spatial<scalar,nvars>(mesh), 
 	pconfig{pconf},
 	nconfig{nconf},
 	physics(pconfig.gamma, pconfig.Minf, pconfig.Tinf, pconfig.Reinf, pconfig.Pr), 
 	uinf(physics.compute_freestream_state(pconfig.aoa)),
+	scalarinf(parsePassiveScalarFreestream<nvars>(pconf)),
+#ifdef _OPENMP
+	faceloops(mesh, parseFaceLoopMode(), omp_get_max_threads(), parseCompressedFaces()),
+#else
+	faceloops(mesh, parseFaceLoopMode(), 1, parseCompressedFaces()),
+#endif
+
+	lowmach {nconfig.lowmach_cutoff > 0 ?
+		new LowMachPreconditioner(pconfig.gamma, nconfig.lowmach_cutoff) : nullptr},
 
-	inviflux {create_const_inviscidflux<scalar>(nconfig.conv_numflux, &physics)}, 
+	inviflux {create_const_inviscidflux<scalar>(nconfig.conv_numflux, &physics, lowmach)}, 
+	jflux {nconfig.conv_numflux_jac.empty() || nconfig.conv_numflux_jac == nconfig.conv_numflux ?
+		inviflux
+		: create_const_inviscidflux<scalar>(nconfig.conv_numflux_jac, &physics, lowmach)},
 
-	gradcomp {create_const_gradientscheme<scalar,NVARS>(nconfig.gradientscheme, m, rc)},
-	lim {create_const_reconstruction<scalar,NVARS>(nconfig.reconstruction, m, rc, gr,
+	gradcomp {create_const_gradientscheme<scalar,nvars>(nconfig.gradientscheme, m, rc,
+	                                                    &faceloops)},
+	lim {create_const_reconstruction<scalar,nvars>(nconfig.reconstruction, m, rc, gr,
 	                                               nconfig.limiter_param)},
 
-	bcs {create_const_flowBCs<scalar>(pconf.bcconf, physics,uinf)}
+	bcs {create_const_flowBCs<scalar>(pconf.bcconf, physics,uinf)},
+
+	activecache {createActiveSet<scalar,nvars>(mesh)},
+	jaccache {createJacobianActiveSet<scalar,nvars>(mesh, pconf)},
+
+	walldist {createWallDistance<scalar>(mesh, pconf)},
+
+	surfint(mesh, rc, physics, pconf.aoa),
+	wallmarkers(getWallMarkers(pconf)),
+	lastgradsexact{false}
 
 {
+	fvens_throw(!inviflux || !jflux, lowmach ?
+	            "Low-Mach preconditioning needs the Roe or HLLC flux, also for the Jacobian!"
+	            : "Could not create the inviscid numerical flux!");
+	if(lowmach) {
+		std::cout << " FlowFV_base: Low-Mach preconditioning with cut-off " << nconfig.lowmach_cutoff
+		          << '\n';
+	}
+
 	std::cout << " FlowFV_base: Boundary conditions:\n";
 	for(auto it = pconfig.bcconf.begin(); it != pconfig.bcconf.end(); it++) {
 		std::cout << "  " << bcTypeMap.left.find(it->bc_type)->second << '\n';
 	}
+
+	if(isTurbulent(pconfig)) {
+		fvens_throw(nvars != NVARS+1 || !pconfig.viscous_sim,
+		            "The SA turbulence model needs viscous flow with exactly one extra variable!");
+		std::cout << " FlowFV_base: Spalart-Allmaras turbulence model, free-stream working variable "
+		          << scalarinf[0] << ", " << walldist->numWallFaces() << " wall faces.\n";
+	}
 }
 
-template <typename scalar>
-FlowFV_base<scalar>::~FlowFV_base()
+template <typename scalar, int nvars>
+FlowFV_base<scalar,nvars>::~FlowFV_base()
 {
 	delete gradcomp;
+	if(jflux != inviflux)
+		delete jflux;
 	delete inviflux;
+	delete lowmach;
 	delete lim;
 	// delete BCs
 	for(auto it = bcs.begin(); it != bcs.end(); it++) {
 		delete it->second;
 	}
+	if(activecache) {
+		std::cout << " FlowFV_base: Fraction of face fluxes recomputed in pseudo-time residuals = "
+		          << activecache->activeFraction() << '\n';
+		delete activecache;
+	}
+	if(jaccache) {
+		std::cout << " FlowFV_base: Fraction of face Jacobians recomputed = "
+		          << jaccache->activeFraction() << '\n';
+		delete jaccache;
+	}
+	delete walldist;
 }
 
-template <typename scalar>
-StatusCode FlowFV_base<scalar>::initializeUnknowns(Vec u) const
+template <typename scalar, int nvars>
+StatusCode FlowFV_base<scalar,nvars>::initializeUnknowns(Vec u) const
 {
 	StatusCode ierr = 0;
 	PetscScalar * uloc;
 	VecGetArray(u, &uloc);
 	PetscInt locsize;
 	VecGetLocalSize(u, &locsize);
-	assert(locsize % NVARS == 0);
-	locsize /= NVARS;
+	assert(locsize % nvars == 0);
+	locsize /= nvars;
 	
 	//initial values are equal to boundary values
-	for(a_int i = 0; i < locsize; i++)
+	for(a_int i = 0; i < locsize; i++) {
 		for(int j = 0; j < NVARS; j++)
-			uloc[i*NVARS+j] = uinf[j];
+			uloc[i*nvars+j] = uinf[j];
+		for(int j = NVARS; j < nvars; j++)
+			uloc[i*nvars+j] = uinf[0]*scalarinf[j-NVARS];
+	}
 
 	VecRestoreArray(u, &uloc);
 
@@ -88,8 +431,8 @@ StatusCode FlowFV_base<scalar>::initializeUnknowns(Vec u) const
 	return ierr;
 }
 
-template <typename scalar>
-void FlowFV_base<scalar>::compute_boundary_states(const amat::Array2d<scalar>& ins, 
+template <typename scalar, int nvars>
+void FlowFV_base<scalar,nvars>::compute_boundary_states(const amat::Array2d<scalar>& ins, 
                                                   amat::Array2d<scalar>& bs ) const
 {
 #pragma omp parallel for default(shared)
@@ -99,20 +442,43 @@ void FlowFV_base<scalar>::compute_boundary_states(const amat::Array2d<scalar>& i
 	}
 }
 
-template <typename scalar>
-void FlowFV_base<scalar>::compute_boundary_state(const int ied, 
+template <typename scalar, int nvars>
+void FlowFV_base<scalar,nvars>::compute_boundary_state(const int ied, 
                                          const scalar *const ins, 
                                          scalar *const gs        ) const
 {
 	const std::array<scalar,NDIM> n = m->gnormal(ied);
 	bcs.at(m->gintfacbtags(ied,0))->computeGhostState(ins, &n[0], gs);
+
+	if(nvars > NVARS) {
+		const bool imposed = isPassiveScalarImposed(ied);
+		const scalar sign = isPassiveScalarReflected(ied) ? -1.0 : 1.0;
+		for(int k = NVARS; k < nvars; k++)
+			gs[k] = gs[0] * (imposed ? scalarinf[k-NVARS] : sign*ins[k]/ins[0]);
+	}
 }
 
-template <typename scalar>
-void FlowFV_base<scalar>::getGradients(const MVector<scalar>& u,
-                               GradArray<scalar,NVARS>& grads) const
+template <typename scalar, int nvars>
+bool FlowFV_base<scalar,nvars>::isPassiveScalarImposed(const a_int iface) const
 {
-	amat::Array2d<scalar> ug(m->gnbface(),NVARS);
+	const BCType bctype = bcs.at(m->gintfacbtags(iface,0))->bctype;
+	return bctype == FARFIELD_BC || bctype == INFLOW_OUTFLOW_BC || bctype == SUBSONIC_INFLOW_BC;
+}
+
+template <typename scalar, int nvars>
+bool FlowFV_base<scalar,nvars>::isPassiveScalarReflected(const a_int iface) const
+{
+	if(!isTurbulent(pconfig))
+		return false;
+	const BCType bctype = bcs.at(m->gintfacbtags(iface,0))->bctype;
+	return bctype == ADIABATIC_WALL_BC || bctype == ISOTHERMAL_WALL_BC;
+}
+
+template <typename scalar, int nvars>
+void FlowFV_base<scalar,nvars>::getGradients(const MVector<scalar>& u,
+                               GradArray<scalar,nvars>& grads) const
+{
+	amat::Array2d<scalar> ug(m->gnbface(),nvars);
 	for(a_int iface = 0; iface < m->gnbface(); iface++)
 	{
 		const a_int lelem = m->gintfac(iface,0);
@@ -122,8 +488,8 @@ void FlowFV_base<scalar>::getGradients(const MVector<scalar>& u,
 	gradcomp->compute_gradients(u, ug, grads);
 }
 
-template <typename scalar>
-StatusCode FlowFV_base<scalar>::assemble_residual(const Vec uvec, 
+template <typename scalar, int nvars>
+StatusCode FlowFV_base<scalar,nvars>::assemble_residual(const Vec uvec, 
                                                   Vec __restrict rvec, 
                                                   const bool gettimesteps,
                                                   std::vector<a_real>& dtm) const
@@ -131,15 +497,15 @@ StatusCode FlowFV_base<scalar>::assemble_residual(const Vec uvec,
 	StatusCode ierr = 0;
 	amat::Array2d<a_real> integ, ug, uleft, uright;	
 	integ.resize(m->gnelem(), 1);
-	ug.resize(m->gnbface(),NVARS);
-	uleft.resize(m->gnaface(), NVARS);
-	uright.resize(m->gnaface(), NVARS);
-	GradArray<a_real,NVARS> grads;
+	ug.resize(m->gnbface(),nvars);
+	uleft.resize(m->gnaface(), nvars);
+	uright.resize(m->gnaface(), nvars);
+	GradArray<a_real,nvars> grads;
 
 	PetscInt locnelem; const PetscScalar *uarr; PetscScalar *rarr;
 	ierr = VecGetLocalSize(uvec, &locnelem); CHKERRQ(ierr);
-	assert(locnelem % NVARS == 0);
-	locnelem /= NVARS;
+	assert(locnelem % nvars == 0);
+	locnelem /= nvars;
 	assert(locnelem == m->gnelem());
 	//ierr = VecGetLocalSize(dtmvec, &dtsz); CHKERRQ(ierr);
 	//assert(locnelem == dtsz);
@@ -155,138 +521,135 @@ StatusCode FlowFV_base<scalar>::assemble_residual(const Vec uvec,
 	return ierr;
 }
 
-template <typename scalar>
-static inline std::array<scalar,NDIM> flowDirectionVector(const scalar aoa) {
-	std::array<scalar,NDIM> dir;
-	for(int i = 0; i < NDIM; i++) dir[i] = 0;
+template <typename scalar, int nvars>
+StatusCode FlowFV_base<scalar,nvars>::assemble_pseudotime_residual(const Vec uvec, Vec rvec,
+                                                             const bool gettimesteps,
+                                                             std::vector<a_real>& dtm) const
+{
+	if(!activecache)
+		return assemble_residual(uvec, rvec, gettimesteps, dtm);
+
+	StatusCode ierr = 0;
+	const PetscScalar *uarr; PetscScalar *rarr;
+	ierr = VecGetArrayRead(uvec, &uarr); CHKERRQ(ierr);
+	ierr = VecGetArray(rvec, &rarr); CHKERRQ(ierr);
 
-	dir[0] = cos(aoa);
-	dir[1] = sin(aoa);
+	ierr = compute_residual(uarr, rarr, gettimesteps, dtm, activecache); CHKERRQ(ierr);
 
-	return dir;
+	ierr = VecRestoreArrayRead(uvec, &uarr); CHKERRQ(ierr);
+	ierr = VecRestoreArray(rvec, &rarr); CHKERRQ(ierr);
+	return ierr;
 }
 
-template <typename scalar>
+template <typename scalar, int nvars>
 std::tuple<scalar,scalar,scalar>
-FlowFV_base<scalar>::computeSurfaceData (const MVector<scalar>& u,
-                                         const GradArray<scalar,NVARS>& grad,
+FlowFV_base<scalar,nvars>::computeSurfaceData (const MVector<scalar>& u,
+                                         const GradArray<scalar,nvars>& grad,
                                          const int iwbcm,
                                          MVector<scalar>& output) const
 {
-	// unit vector in the direction of flow
-	const std::array<scalar,NDIM> av = flowDirectionVector(pconfig.aoa); 
-
-	a_int facecoun = 0;			// face iteration counter for this boundary marker
-	scalar totallen = 0;		// total area of the surface with this boundary marker
-	scalar Cdf=0, Cdp=0, Cl=0;
-	
-	const scalar pinf = physics.getFreestreamPressure();
+	return surfint.integrate(iwbcm, &u(0,0), grad, false, &output);
+}
 
-	// unit vector normal to the free-stream flow direction
-	// TODO: Generalize to 3D
-	scalar flownormal[NDIM]; flownormal[0] = -av[1]; flownormal[1] = av[0];
+template <typename scalar, int nvars>
+void FlowFV_base<scalar,nvars>::getPrimitiveGradients(const scalar *const u,
+                                                      GradArray<scalar,nvars>& grads) const
+{
+	amat::Array2d<scalar> ug(m->gnbface(),nvars);
+	MVector<scalar> up(m->gnelem(), nvars);
 
-	// iterate over faces having this boundary marker
-	for(a_int iface = 0; iface < m->gnbface(); iface++)
+#pragma omp parallel default(shared)
 	{
-		if(m->gintfacbtags(iface,0) == iwbcm)
+#pragma omp for
+		for(a_int iface = 0; iface < m->gnbface(); iface++)
 		{
 			const a_int lelem = m->gintfac(iface,0);
-			scalar n[NDIM];
-			for(int j = 0; j < NDIM; j++)
-				n[j] = m->gfacemetric(iface,j);
-			const scalar len = m->gfacemetric(iface,2);
+			compute_boundary_state(iface, &u[lelem*nvars], &ug(iface,0));
+			statesToPrimitive<scalar,nvars>(physics, 1, &ug(iface,0), &ug(iface,0));
+		}
+
+#pragma omp for
+		for(a_int iel = 0; iel < m->gnelem(); iel += conversion_batch)
+			statesToPrimitive<scalar,nvars>(physics, batchSize(iel, m->gnelem()),
+			                                &u[iel*nvars], &up(iel,0));
+	}
+
+	grads.resize(m->gnelem());
+	gradcomp->compute_gradients(up, ug, grads);
+}
+
+template <typename scalar, int nvars>
+template <typename Function>
+void FlowFV_base<scalar,nvars>::withSurfaceGradients(const scalar *const u, Function&& f) const
+{
+	if(nconfig.order2)
+	{
+		// held during f, so that no residual evaluation takes the kept gradients meanwhile
+		std::lock_guard<std::mutex> lock(lastgradsmutex);
+		const size_t nu = static_cast<size_t>(m->gnelem())*nvars;
+		if(!lastgrads.empty() && lastgradsexact && lastgradstate.size() == nu
+		   && std::equal(u, u+nu, lastgradstate.begin()))
+		{
+			f(static_cast<const GradArray<scalar,nvars>&>(lastgrads));
+			return;
+		}
+	}
+
+	GradArray<scalar,nvars> grads;
+	if(nconfig.order2 || pconfig.viscous_sim)
+		getPrimitiveGradients(u, grads);
+	f(static_cast<const GradArray<scalar,nvars>&>(grads));
+}
+
+template <typename scalar, int nvars>
+std::tuple<scalar,scalar,scalar>
+FlowFV_base<scalar,nvars>::computeSurfaceForces(const scalar *const u, const int iwbcm) const
+{
+	std::tuple<scalar,scalar,scalar> coeffs;
+	withSurfaceGradients(u, [&](const GradArray<scalar,nvars>& grads) {
+		coeffs = surfint.integrate(iwbcm, u, grads, true, nullptr);
+	});
+	return coeffs;
+}
+
+template <typename scalar, int nvars>
+bool FlowFV_base<scalar,nvars>::computeWallForces(const scalar *const u, scalar *const forces)
+	const
+{
+	scalar totallen = 0;
+	for(int i = 0; i < 3; i++)
+		forces[i] = 0;
+
+	// the gradients are found once for all walls
+	withSurfaceGradients(u, [&](const GradArray<scalar,nvars>& grads) {
+		for(const int marker : wallmarkers)
+		{
+			const scalar len = surfint.surfaceLength(marker);
+			if(len <= 0)
+				continue;
+			const std::tuple<scalar,scalar,scalar> coeffs
+				= surfint.integrate(marker, u, grads, true, nullptr);
+			forces[0] += std::get<0>(coeffs)*len;
+			forces[1] += std::get<1>(coeffs)*len;
+			forces[2] += std::get<2>(coeffs)*len;
 			totallen += len;
+		}
+	});
 
-			// coords of face center
-			a_int ijp[NDIM];
-			ijp[0] = m->gintfac(iface,2);
-			ijp[1] = m->gintfac(iface,3);
-			scalar coord[NDIM];
-			for(int j = 0; j < NDIM; j++) 
-			{
-				coord[j] = 0;
-				for(int inofa = 0; inofa < m->gnnofa(); inofa++)
-					coord[j] += m->gcoords(ijp[inofa],j);
-				coord[j] /= m->gnnofa();
-				
-				output(facecoun,j) = coord[j];
-			}
+	if(totallen <= 0)
+		return false;
+	for(int i = 0; i < 3; i++)
+		forces[i] /= totallen;
+	return true;
+}
 
-			/** Pressure coefficient: 
-			 * \f$ C_p = (p-p_\infty)/(\frac12 rho_\infty * v_\infty^2) \f$
-			 * = 2(p* - p_inf*) where *'s indicate non-dimensional values.
-			 * We note that p_inf* = 1/(gamma Minf^2) in our non-dimensionalization.
-			 */
-			output(facecoun, NDIM) = (physics.getPressureFromConserved(&u(lelem,0)) - pinf)*2.0;
-
-			/** Skin friction coefficient \f% C_f = \tau_w / (\frac12 \rho v_\infty^2) \f$.
-			 * 
-			 * We can define \f$ \tau_w \f$, the wall shear stress, as
-			 * \f$ \tau_w = (\mathbf{T} \hat{\mathbf{n}}).\hat{\mathbf{t}} \f$
-			 * where \f$ \mathbf{\Tau} \f$ is the viscous stress tensor, 
-			 * \f$ \hat{\mathbf{n}} \f$ is the unit normal to the face and 
-			 * \f$ \hat{\mathbf{t}} \f$ is a consistent unit tangent to the face.
-			 * 
-			 * Note that because of our non-dimensionalization,
-			 * \f$ C_f = 2 \tau_w \f$.
-			 *
-			 * Note that finally the wall shear stress becomes
-			 * \f$ \tau_w = \mu (\nabla\mathbf{u}+\nabla\mathbf{u}^T) \hat{\mathbf{n}}
-			 *                                           .\hat{\mathbf{t}} \f$.
-			 *
-			 * Note that if n is (n1,n2), t is chosen as (n2,-n1).
-			 */
-
-			// non-dim viscosity / Re_inf
-			const scalar muhat = physics.getViscosityCoeffFromConserved(&u(lelem,0));
-
-			// velocity gradient tensor
-			scalar gradu[NDIM][NDIM];
-			gradu[0][0] = (grad[lelem](0,1)*u(lelem,0)-u(lelem,1)*grad[lelem](0,0))
-							/ (u(lelem,0)*u(lelem,0));
-			gradu[0][1] = (grad[lelem](1,1)*u(lelem,0)-u(lelem,1)*grad[lelem](1,0))
-							/ (u(lelem,0)*u(lelem,0));
-			gradu[1][0] = (grad[lelem](0,2)*u(lelem,0)-u(lelem,2)*grad[lelem](0,0))
-							/ (u(lelem,0)*u(lelem,0));
-			gradu[1][1] = (grad[lelem](1,2)*u(lelem,0)-u(lelem,2)*grad[lelem](1,0))
-							/ (u(lelem,0)*u(lelem,0));
-			
-			const scalar tauw = 
-				muhat*((2.0*gradu[0][0]*n[0] +(gradu[0][1]+gradu[1][0])*n[1])*n[1]
-				+ ((gradu[1][0]+gradu[0][1])*n[0] + 2.0*gradu[1][1]*n[1])*(-n[0]));
-
-			output(facecoun, NDIM+1) = 2.0*tauw;
-
-			// add contributions to Cdp, Cdf and Cl
-			
-			// face normal dot free-stream direction
-			const scalar ndotf = n[0]*av[0]+n[1]*av[1];
-			// face normal dot "up" direction perpendicular to free stream
-			const scalar ndotnf = n[0]*flownormal[0]+n[1]*flownormal[1];
-			// face tangent dot free-stream direction
-			const scalar tdotf = n[1]*av[0]-n[0]*av[1];
-
-			Cdp += output(facecoun,NDIM)*ndotf*len;
-			Cdf += output(facecoun,NDIM+1)*tdotf*len;
-			Cl += output(facecoun,NDIM)*ndotnf*len;
-
-			facecoun++;
-		}
-	}
-
-	// Normalize drag and lift by reference area
-	Cdp /= totallen; Cdf /= totallen; Cl /= totallen;
-
-	return std::make_tuple(Cl, Cdp, Cdf);
-}
-
-template<typename scalar, bool secondOrderRequested, bool constVisc>
-FlowFV<scalar,secondOrderRequested,constVisc>::FlowFV(const UMesh2dh<scalar> *const mesh,
-                                                      const FlowPhysicsConfig& pconf, 
-                                                      const FlowNumericsConfig& nconf)
-	: FlowFV_base<scalar>(mesh, pconf, nconf),
-	jphy(pconfig.gamma, pconfig.Minf, pconfig.Tinf, pconfig.Reinf, pconfig.Pr)
+template<typename scalar, bool secondOrderRequested, bool constVisc, int nvars>
+FlowFV<scalar,secondOrderRequested,constVisc,nvars>::FlowFV(const UMesh2dh<scalar> *const mesh,
+                                                            const FlowPhysicsConfig& pconf,
+                                                            const FlowNumericsConfig& nconf)
+	: FlowFV_base<scalar,nvars>(mesh, pconf, nconf),
+	jphy(pconfig.gamma, pconfig.Minf, pconfig.Tinf, pconfig.Reinf, pconfig.Pr),
+	sa()
 {
 	if(secondOrderRequested)
 		std::cout << "FlowFV: Second order solution requested.\n";
@@ -294,19 +657,25 @@ FlowFV<scalar,secondOrderRequested,constVisc>::FlowFV(const UMesh2dh<scalar> *co
 		std::cout << " FLowFV: Using constant viscosity.\n";
 }
 
-template<typename scalar, bool secondOrderRequested, bool constVisc>
-FlowFV<scalar,secondOrderRequested,constVisc>::~FlowFV()
+template<typename scalar, bool secondOrderRequested, bool constVisc, int nvars>
+FlowFV<scalar,secondOrderRequested,constVisc,nvars>::~FlowFV()
 {
+	delete batch4.gradcomp;
+	delete batch4.lim;
+	delete batch8.gradcomp;
+	delete batch8.lim;
+	delete batch16.gradcomp;
+	delete batch16.lim;
 }
 
-template<typename scalar, bool secondOrderRequested, bool constVisc>
-void FlowFV<scalar,secondOrderRequested,constVisc>
+template<typename scalar, bool secondOrderRequested, bool constVisc, int nvars>
+void FlowFV<scalar,secondOrderRequested,constVisc,nvars>
 ::compute_viscous_flux(const a_int iface,
                        const scalar *const ucell_l, const scalar *const ucell_r,
                        const amat::Array2d<scalar>& ug,
-                       const GradArray<scalar,NVARS>& grads,
+                       const GradArray<scalar,nvars>& grads,
                        const amat::Array2d<scalar>& ul, const amat::Array2d<scalar>& ur,
-                       scalar *const __restrict vflux) const
+                       const scalar mulam, scalar *const __restrict vflux) const
 {
 	const a_int lelem = m->gintfac(iface,0);
 	const a_int relem = m->gintfac(iface,1);
@@ -379,12 +748,48 @@ void FlowFV<scalar,secondOrderRequested,constVisc>
 	scalar grad[NDIM][NVARS];
 	getFaceGradient_modifiedAverage(iface, uctl, uctr, gradl, gradr, grad);
 
-	computeViscousFlux<scalar,NDIM,NVARS,constVisc>(physics, &normal[0], grad,
-	                                                &ul(iface,0), &ur(iface,0), vflux);
+	for(int k = NVARS; k < nvars; k++)
+		vflux[k] = 0;
+
+	if(!isTurbulent(pconfig)) {
+		computeViscousFlux<scalar,NDIM,NVARS>(physics, &normal[0], grad, &ul(iface,0), &ur(iface,0),
+		                                      mulam, 0, 0, vflux);
+		return;
+	}
+
+	/* Eddy viscosity and diffusivity of the working variable from the averages of the cell-centred
+	 * states, so that they vanish at walls where the ghost working variable is reflected.
+	 */
+	const scalar rho = 0.5*(ucell_l[0] + in_ucr[0]);
+	const scalar nutl = ucell_l[NVARS]/ucell_l[0], nutr = in_ucr[NVARS]/in_ucr[0];
+	const scalar nut = 0.5*(nutl + nutr);
+	const scalar mu = constVisc ? physics.getConstantViscosityCoeff()
+		: 0.5*(physics.getViscosityCoeffFromConserved(ucell_l)
+		       + physics.getViscosityCoeffFromConserved(in_ucr));
+	const scalar mut = sa.eddyViscosity(rho, nut, mu);
+	const scalar kt = physics.getThermalConductivityFromViscosity(mut)*physics.Pr/sa.Prt;
+
+	computeViscousFlux<scalar,NDIM,NVARS>(physics, &normal[0], grad, &ul(iface,0), &ur(iface,0),
+	                                      mulam, mut, kt, vflux);
+
+	// primitive cell-centred gradients of the working variable
+	scalar gradnutl[NDIM], gradnutr[NDIM];
+	for(int i = 0; i < NDIM; i++) {
+		gradnutl[i] = secondOrderRequested ? grads[lelem](i,NVARS) : 0;
+		gradnutr[i] = secondOrderRequested ?
+			grads[iface < m->gnbface() ? lelem : relem](i,NVARS) : 0;
+	}
+
+	scalar gradnut[NDIM][1];
+	getFaceGradient_modifiedAverage(iface, &nutl, &nutr, gradnutl, gradnutr, gradnut);
+
+	vflux[NVARS] = 0;
+	for(int i = 0; i < NDIM; i++)
+		vflux[NVARS] -= sa.diffusivity(rho, nut, mu)*gradnut[i][0]*normal[i];
 }
 
-template<typename scalar, bool secondOrder, bool constVisc>
-void FlowFV<scalar,secondOrder,constVisc>
+template<typename scalar, bool secondOrder, bool constVisc, int nvars>
+void FlowFV<scalar,secondOrder,constVisc,nvars>
 ::compute_viscous_flux_jacobian(const a_int iface,
                                 const a_real *const ul, const a_real *const ur,
                                 a_real *const __restrict dvfi, a_real *const __restrict dvfj) const
@@ -423,8 +828,8 @@ void FlowFV<scalar,secondOrder,constVisc>
 	                                                        dvfi, dvfj);
 }
 
-template<typename scalar, bool secondOrder, bool constVisc>
-void FlowFV<scalar,secondOrder,constVisc>
+template<typename scalar, bool secondOrder, bool constVisc, int nvars>
+void FlowFV<scalar,secondOrder,constVisc,nvars>
 ::compute_viscous_flux_approximate_jacobian(const a_int iface,
                                             const a_real *const ul, const a_real *const ur,
                                             a_real *const __restrict dvfi,
@@ -461,21 +866,56 @@ void FlowFV<scalar,secondOrder,constVisc>
 	}
 }
 
-template<typename scalar, bool secondOrderRequested, bool constVisc>
-StatusCode FlowFV<scalar,secondOrderRequested,constVisc>::compute_residual(const scalar *const uarr, 
+template<typename scalar, bool secondOrder, bool constVisc, int nvars>
+a_real FlowFV<scalar,secondOrder,constVisc,nvars>::faceViscosity(const a_real *const ul,
+                                                                 const a_real *const ur) const
+{
+	return constVisc ? jphy.getConstantViscosityCoeff()
+		: 0.5*(jphy.getViscosityCoeffFromConserved(ul) + jphy.getViscosityCoeffFromConserved(ur));
+}
+
+template<typename scalar, bool secondOrder, bool constVisc, int nvars>
+a_real FlowFV<scalar,secondOrder,constVisc,nvars>::projectedCentreDistance(const a_int iface)
+	const
+{
+	const a_int lelem = m->gintfac(iface,0);
+	const a_int relem = m->gintfac(iface,1);
+	a_real dist2 = 0, proj = 0;
+	for(int i = 0; i < NDIM; i++) {
+		const a_real dr = rc(relem,i)-rc(lelem,i);
+		dist2 += dr*dr;
+		proj += dr*m->gfacemetric(iface,i);
+	}
+	return dist2/proj;
+}
+
+template<typename scalar, bool secondOrderRequested, bool constVisc, int nvars>
+StatusCode FlowFV<scalar,secondOrderRequested,constVisc,nvars>::compute_residual(const scalar *const uarr, 
 		scalar *const __restrict rarr, 
-		const bool gettimesteps, std::vector<a_real>& dtm) const
+		const bool gettimesteps, std::vector<a_real>& dtm,
+		ActiveSetResidual<scalar,nvars> *const activeset) const
 {
 	StatusCode ierr = 0;
 	amat::Array2d<scalar> integ, ug, uleft, uright;	
 	integ.resize(m->gnelem(), 1);
-	ug.resize(m->gnbface(),NVARS);
-	uleft.resize(m->gnaface(), NVARS);
-	uright.resize(m->gnaface(), NVARS);
-	GradArray<scalar,NVARS> grads;
+	ug.resize(m->gnbface(),nvars);
+	uleft.resize(m->gnaface(), nvars);
+	uright.resize(m->gnaface(), nvars);
+	GradArray<scalar,nvars> grads;
+
+	/* The gradients of evaluations computing time steps, which are done once per pseudo-time step,
+	 * are kept for computeSurfaceForces; their storage is re-used from the last such evaluation.
+	 * It is taken under the lock, so an evaluation running concurrently finds it empty and
+	 * computes all its gradients afresh. Other evaluations do not touch it.
+	 */
+	const bool keepgrads = secondOrderRequested && gettimesteps;
+	if(keepgrads) {
+		std::lock_guard<std::mutex> lock(lastgradsmutex);
+		std::swap(grads, lastgrads);
+	}
 
-	Eigen::Map<const MVector<scalar>> u(uarr, m->gnelem(), NVARS);
-	Eigen::Map<MVector<scalar>> residual(rarr, m->gnelem(), NVARS);
+	Eigen::Map<const MVector<scalar>> u(uarr, m->gnelem(), nvars);
+	Eigen::Map<MVector<scalar>> residual(rarr, m->gnelem(), nvars);
 
 #pragma omp parallel default(shared)
 	{
@@ -490,11 +930,24 @@ StatusCode FlowFV<scalar,secondOrderRequested,constVisc>::compute_residual(const
 		for(a_int ied = 0; ied < m->gnbface(); ied++)
 		{
 			a_int ielem = m->gintfac(ied,0);
-			for(int ivar = 0; ivar < NVARS; ivar++)
+			for(int ivar = 0; ivar < nvars; ivar++)
 				uleft(ied,ivar) = u(ielem,ivar);
 		}
 	}
 
+	if(activeset)
+		activeset->markActiveStencil(uarr);
+
+	/* Apart from full refreshes of the active set, face states are only needed at the active faces.
+	 * Gradients kept for computeSurfaceForces are only partially updated if they were all computed
+	 * before, as the other cells' gradients are then those of the (nearly) unchanged states.
+	 */
+	const bool activeonly = activeset && !activeset->isFullRefresh();
+	const bool partialrecon = activeonly
+		&& (!keepgrads || grads.size() == static_cast<size_t>(m->gnelem()));
+	const std::vector<a_int> *const actfaces = activeonly ? &activeset->activeFaces() : nullptr;
+	const a_int nactfaces = activeonly ? static_cast<a_int>(actfaces->size()) : 0;
+
 	if(secondOrderRequested)
 	{
 		// for storing cell-centred gradients at interior cells and ghost cells
@@ -503,40 +956,114 @@ StatusCode FlowFV<scalar,secondOrderRequested,constVisc>::compute_residual(const
 		// get cell average values at ghost cells using BCs
 		compute_boundary_states(uleft, ug);
 
-		MVector<scalar> up(m->gnelem(), NVARS);
+		MVector<scalar> up(m->gnelem(), nvars);
 
-		// convert cell-centered state vectors to primitive variables
+		// convert cell-centered state vectors to primitive variables, a batch at a time
 #pragma omp parallel default(shared)
 		{
 #pragma omp for
-			for(a_int iface = 0; iface < m->gnbface(); iface++)
-			{
-				physics.getPrimitiveFromConserved(&ug(iface,0), &ug(iface,0));
-			}
+			for(a_int iface = 0; iface < m->gnbface(); iface += conversion_batch)
+				statesToPrimitive<scalar,nvars>(physics, batchSize(iface, m->gnbface()),
+				                                &ug(iface,0), &ug(iface,0));
 
 #pragma omp for
-			for(a_int iel = 0; iel < m->gnelem(); iel++)
-				physics.getPrimitiveFromConserved(&uarr[iel*NVARS], &up(iel,0));
+			for(a_int iel = 0; iel < m->gnelem(); iel += conversion_batch)
+				statesToPrimitive<scalar,nvars>(physics, batchSize(iel, m->gnelem()),
+				                                &uarr[iel*nvars], &up(iel,0));
 		}
 
+		// primitive state of the neighbour (or ghost cell) of cell iel across its face j
+		const auto nbrstate = [&](const a_int iel, const int j) -> const scalar* {
+			const a_int nbr = m->gesuel(iel,j);
+			return nbr < m->gnelem() ? &up(nbr,0) : &ug(m->gelemface(iel,j),0);
+		};
+
 		// reconstruct
-		gradcomp->compute_gradients(up, ug, grads);
-		lim->compute_face_values(up, ug, grads, uleft, uright);
+		beginPerfStage(PERFSTAGE_GRADIENT);
+		if(partialrecon)
+		{
+			const std::vector<a_int>& gcells = activeset->gradientCells();
+			const a_int ngcells = static_cast<a_int>(gcells.size());
+#pragma omp parallel default(shared)
+			{
+				std::vector<const scalar*> unbrs;
+#pragma omp for
+				for(a_int i = 0; i < ngcells; i++)
+				{
+					const a_int iel = gcells[i];
+					unbrs.resize(m->gnfael(iel));
+					for(int j = 0; j < m->gnfael(iel); j++)
+						unbrs[j] = nbrstate(iel,j);
+					gradcomp->compute_cell_gradient(iel, &up(iel,0), &unbrs[0], grads[iel]);
+				}
+			}
+		}
+		else
+			gradcomp->compute_gradients(up, ug, grads);
+		endPerfStage(PERFSTAGE_GRADIENT);
+
+		beginPerfStage(PERFSTAGE_LIMITER);
+		if(partialrecon)
+		{
+			const std::vector<a_int>& rcells = activeset->reconstructionCells();
+			const a_int nrcells = static_cast<a_int>(rcells.size());
+#pragma omp parallel default(shared)
+			{
+				std::vector<const scalar*> unbrs;
+				std::vector<const Eigen::Array<scalar,NDIM,nvars>*> nbrgrads;
+				std::vector<scalar*> ufaces;
+#pragma omp for
+				for(a_int i = 0; i < nrcells; i++)
+				{
+					const a_int iel = rcells[i];
+					const int nfael = m->gnfael(iel);
+					unbrs.resize(nfael);
+					nbrgrads.resize(nfael);
+					ufaces.resize(nfael);
+					for(int j = 0; j < nfael; j++) {
+						const a_int nbr = m->gesuel(iel,j);
+						const a_int iface = m->gelemface(iel,j);
+						unbrs[j] = nbrstate(iel,j);
+						nbrgrads[j] = nbr < m->gnelem() ? &grads[nbr] : nullptr;
+						ufaces[j] = m->gintfac(iface,0) == iel ? &uleft(iface,0) : &uright(iface,0);
+					}
+					lim->compute_cell_face_values(iel, &up(iel,0), &unbrs[0], grads[iel],
+					                              &nbrgrads[0], &ufaces[0]);
+				}
+			}
+		}
+		else
+			lim->compute_face_values(up, ug, grads, uleft, uright);
+		endPerfStage(PERFSTAGE_LIMITER);
 
 		// Convert face values back to conserved variables - gradients stay primitive.
+		if(partialrecon)
+		{
+#pragma omp parallel for default(shared)
+			for(a_int i = 0; i < nactfaces; i++)
+			{
+				const a_int iface = (*actfaces)[i];
+				scalar *const ur = iface < m->gnbface() ? &ug(iface,0) : &uright(iface,0);
+				statesToConserved<scalar,nvars>(physics, 1, &uleft(iface,0), &uleft(iface,0));
+				statesToConserved<scalar,nvars>(physics, 1, ur, ur);
+			}
+		}
+		else
 #pragma omp parallel default(shared)
 		{
 #pragma omp for
-			for(a_int iface = m->gnbface(); iface < m->gnaface(); iface++)
+			for(a_int iface = m->gnbface(); iface < m->gnaface(); iface += conversion_batch)
 			{
-				physics.getConservedFromPrimitive(&uleft(iface,0), &uleft(iface,0));
-				physics.getConservedFromPrimitive(&uright(iface,0), &uright(iface,0));
+				const a_int nb = batchSize(iface, m->gnaface());
+				statesToConserved<scalar,nvars>(physics, nb, &uleft(iface,0), &uleft(iface,0));
+				statesToConserved<scalar,nvars>(physics, nb, &uright(iface,0), &uright(iface,0));
 			}
 #pragma omp for
-			for(a_int iface = 0; iface < m->gnbface(); iface++) 
+			for(a_int iface = 0; iface < m->gnbface(); iface += conversion_batch)
 			{
-				physics.getConservedFromPrimitive(&uleft(iface,0), &uleft(iface,0));
-				physics.getConservedFromPrimitive(&ug(iface,0), &ug(iface,0));
+				const a_int nb = batchSize(iface, m->gnbface());
+				statesToConserved<scalar,nvars>(physics, nb, &uleft(iface,0), &uleft(iface,0));
+				statesToConserved<scalar,nvars>(physics, nb, &ug(iface,0), &ug(iface,0));
 			}
 		}
 	}
@@ -550,7 +1077,7 @@ StatusCode FlowFV<scalar,secondOrderRequested,constVisc>::compute_residual(const
 		{
 			a_int ielem = m->gintfac(ied,0);
 			a_int jelem = m->gintfac(ied,1);
-			for(int ivar = 0; ivar < NVARS; ivar++)
+			for(int ivar = 0; ivar < nvars; ivar++)
 			{
 				uleft(ied,ivar) = u(ielem,ivar);
 				uright(ied,ivar) = u(jelem,ivar);
@@ -559,7 +1086,18 @@ StatusCode FlowFV<scalar,secondOrderRequested,constVisc>::compute_residual(const
 	}
 
 	// set right (ghost) state for boundary faces
-	compute_boundary_states(uleft,uright);
+	if(activeonly)
+	{
+#pragma omp parallel for default(shared)
+		for(a_int i = 0; i < nactfaces; i++)
+		{
+			const a_int iface = (*actfaces)[i];
+			if(iface < m->gnbface())
+				compute_boundary_state(iface, &uleft(iface,0), &uright(iface,0));
+		}
+	}
+	else
+		compute_boundary_states(uleft,uright);
 
 	// Compute fluxes.
 	/**
@@ -574,113 +1112,749 @@ StatusCode FlowFV<scalar,secondOrderRequested,constVisc>::compute_residual(const
 	 * from \cite{blazek}.
 	 */
 
-#pragma omp parallel default(shared)
+	beginPerfStage(PERFSTAGE_FLUX);
+
+	/* Speeds of sound (for time steps) and laminar viscosities of the left and right states of all
+	 * faces, computed a batch at a time, or of the active faces only.
+	 */
+	const bool needspeeds = gettimesteps || activeset;
+	const bool sutherland = pconfig.viscous_sim && !constVisc;
+	std::vector<scalar> cl, cr, mul, mur;
+	if(needspeeds) {
+		cl.resize(m->gnaface());
+		cr.resize(m->gnaface());
+	}
+	if(sutherland) {
+		mul.resize(m->gnaface());
+		mur.resize(m->gnaface());
+	}
+	if(activeonly)
 	{
-#pragma omp for
-		for(a_int ied = 0; ied < m->gnaface(); ied++)
+#pragma omp parallel for default(shared)
+		for(a_int i = 0; i < nactfaces; i++)
+		{
+			const a_int iface = (*actfaces)[i];
+			cl[iface] = physics.getSoundSpeedFromConserved(&uleft(iface,0));
+			cr[iface] = physics.getSoundSpeedFromConserved(&uright(iface,0));
+			if(sutherland) {
+				mul[iface] = physics.getViscosityCoeffFromConserved(&uleft(iface,0));
+				mur[iface] = physics.getViscosityCoeffFromConserved(&uright(iface,0));
+			}
+		}
+	}
+	else if(needspeeds || sutherland)
+	{
+#pragma omp parallel for default(shared)
+		for(a_int iface = 0; iface < m->gnaface(); iface += conversion_batch)
+		{
+			const a_int nb = batchSize(iface, m->gnaface());
+			if(needspeeds) {
+				physics.getSoundSpeedFromConservedBatch(nb, nvars, &uleft(iface,0), &cl[iface]);
+				physics.getSoundSpeedFromConservedBatch(nb, nvars, &uright(iface,0), &cr[iface]);
+			}
+			if(sutherland) {
+				physics.getViscosityCoeffFromConservedBatch(nb, nvars, &uleft(iface,0),
+				                                            &mul[iface]);
+				physics.getViscosityCoeffFromConservedBatch(nb, nvars, &uright(iface,0),
+				                                            &mur[iface]);
+			}
+		}
+	}
+
+	faceloops.executeWithFaceData([&](const auto& faces, const a_int ied, const bool updleft,
+	                                  const bool updright, const bool atomic)
+	{
+		const a_int lelem = faces.leftCell(ied);
+		const a_int relem = faces.rightCell(ied);
+		const bool updr = updright && relem < m->gnelem();
+
+		// re-use the cached contributions of inactive faces
+		if(activeset && !activeset->isFaceActive(ied))
 		{
-			scalar n[NDIM];
-			n[0] = m->gfacemetric(ied,0);
-			n[1] = m->gfacemetric(ied,1);
-			scalar len = m->gfacemetric(ied,2);
-			const int lelem = m->gintfac(ied,0);
-			const int relem = m->gintfac(ied,1);
-			scalar fluxes[NVARS];
+			const scalar *const fluxes = activeset->faceFlux(ied);
+			if(updleft)
+				for(int ivar = 0; ivar < nvars; ivar++)
+					faceLoopUpdate(residual(lelem,ivar), -fluxes[ivar], atomic);
+			if(updr)
+				for(int ivar = 0; ivar < nvars; ivar++)
+					faceLoopUpdate(residual(relem,ivar), fluxes[ivar], atomic);
+			if(gettimesteps) {
+				if(updleft)
+					faceLoopUpdate(integ(lelem), activeset->faceSpectralRadius(ied,0), atomic);
+				if(updr)
+					faceLoopUpdate(integ(relem), activeset->faceSpectralRadius(ied,1), atomic);
+			}
+			return;
+		}
+
+		scalar n[NDIM];
+		n[0] = faces.normal(ied,0);
+		n[1] = faces.normal(ied,1);
+		scalar len = faces.length(ied);
+		scalar fluxes[nvars];
 
-			inviflux->get_flux(&uleft(ied,0), &uright(ied,0), n, fluxes);
+		inviflux->get_flux(&uleft(ied,0), &uright(ied,0), n, fluxes);
+		passiveScalarFlux<scalar,nvars>(&uleft(ied,0), &uright(ied,0), fluxes);
 
-			// integrate over the face
-			for(int ivar = 0; ivar < NVARS; ivar++)
-					fluxes[ivar] *= len;
+		// integrate over the face
+		for(int ivar = 0; ivar < nvars; ivar++)
+				fluxes[ivar] *= len;
+
+		if(pconfig.viscous_sim) 
+		{
+			// get viscous fluxes
+			scalar vflux[nvars];
+			const scalar *const urt = (ied < m->gnbface()) ? nullptr : &uarr[relem*nvars];
+			const scalar mulam = constVisc ? physics.getConstantViscosityCoeff()
+				: 0.5*(mul[ied] + mur[ied]);
+			compute_viscous_flux(ied, &uarr[lelem*nvars], urt, ug, grads, uleft, uright, mulam,
+			                     vflux);
+
+			for(int ivar = 0; ivar < nvars; ivar++)
+				fluxes[ivar] += vflux[ivar]*len;
+		}
+
+		/// We assemble the negative of the residual ( M du/dt + r(u) = 0).
+		if(updleft)
+			for(int ivar = 0; ivar < nvars; ivar++)
+				faceLoopUpdate(residual(lelem,ivar), -fluxes[ivar], atomic);
+		if(updr)
+			for(int ivar = 0; ivar < nvars; ivar++)
+				faceLoopUpdate(residual(relem,ivar), fluxes[ivar], atomic);
+
+		// interface faces of partitioned loops are computed twice; only one of them fills the cache
+		if(activeset && updleft)
+			for(int ivar = 0; ivar < nvars; ivar++)
+				activeset->faceFlux(ied)[ivar] = fluxes[ivar];
+		
+		// compute max allowable time steps; always needed to fill the cache of the active set
+		if(gettimesteps || activeset)
+		{
+			//speeds of sound
+			const scalar ci = cl[ied];
+			const scalar cj = cr[ied];
+			//calculate normal velocities
+			const scalar vni = (uleft(ied,1)*n[0] +uleft(ied,2)*n[1])/uleft(ied,0);
+			const scalar vnj = (uright(ied,1)*n[0] + uright(ied,2)*n[1])/uright(ied,0);
+
+			scalar specradi, specradj;
+			if(lowmach) {
+				specradi = lowmach->getSpectralRadius(vni, dimDotProduct(&uleft(ied,1),&uleft(ied,1))
+				                                      /(uleft(ied,0)*uleft(ied,0)), ci)*len;
+				specradj = lowmach->getSpectralRadius(vnj, dimDotProduct(&uright(ied,1),
+				                                      &uright(ied,1))/(uright(ied,0)*uright(ied,0)),
+				                                      cj)*len;
+			}
+			else {
+				specradi = (fabs(vni)+ci)*len;
+				specradj = (fabs(vnj)+cj)*len;
+			}
 
 			if(pconfig.viscous_sim) 
 			{
-				// get viscous fluxes
-				scalar vflux[NVARS];
-				const scalar *const urt = (ied < m->gnbface()) ? nullptr : &uarr[relem*NVARS];
-				compute_viscous_flux(ied, &uarr[lelem*NVARS], urt, ug, grads, uleft, uright, 
-				                     vflux);
-
-				for(int ivar = 0; ivar < NVARS; ivar++)
-					fluxes[ivar] += vflux[ivar]*len;
+				scalar mui, muj;
+				if(constVisc) {
+					mui = physics.getConstantViscosityCoeff();
+					muj = physics.getConstantViscosityCoeff();
+				}
+				else {
+					mui = mul[ied];
+					muj = mur[ied];
+				}
+				if(isTurbulent(pconfig)) {
+					mui += saEddyViscosity<scalar,nvars>(sa, &uleft(ied,0), mui);
+					muj += saEddyViscosity<scalar,nvars>(sa, &uright(ied,0), muj);
+				}
+				const scalar coi = std::max(4.0/(3*uleft(ied,0)), physics.g/uleft(ied,0));
+				const scalar coj = std::max(4.0/(3*uright(ied,0)), physics.g/uright(ied,0));
+				
+				specradi += coi*mui/physics.Pr * len*len/m->garea(lelem);
+				if(relem < m->gnelem())
+					specradj += coj*muj/physics.Pr * len*len/m->garea(relem);
 			}
 
-			/// We assemble the negative of the residual ( M du/dt + r(u) = 0).
-			for(int ivar = 0; ivar < NVARS; ivar++) {
-#pragma omp atomic
-				residual(lelem,ivar) -= fluxes[ivar];
+			if(activeset && updleft) {
+				activeset->faceSpectralRadius(ied,0) = specradi;
+				activeset->faceSpectralRadius(ied,1) = specradj;
 			}
-			if(relem < m->gnelem()) {
-				for(int ivar = 0; ivar < NVARS; ivar++) {
-#pragma omp atomic
-					residual(relem,ivar) += fluxes[ivar];
+
+			if(updleft)
+				faceLoopUpdate(integ(lelem), specradi, atomic);
+			if(updr)
+				faceLoopUpdate(integ(relem), specradj, atomic);
+		}
+	});
+
+	if(gettimesteps)
+#pragma omp parallel for simd default(shared)
+		for(a_int iel = 0; iel < m->gnelem(); iel++)
+		{
+			dtm[iel] = m->garea(iel)/integ(iel);
+		}
+
+	if(isTurbulent(pconfig))
+	{
+		std::vector<scalar> src, dsrc;
+		compute_turbulence_source(uarr, src, dsrc);
+#pragma omp parallel for default(shared)
+		for(a_int iel = 0; iel < m->gnelem(); iel++)
+			for(int k = NVARS; k < nvars; k++)
+				residual(iel,k) += src[iel];
+	}
+	endPerfStage(PERFSTAGE_FLUX);
+
+	if(keepgrads) {
+		std::lock_guard<std::mutex> lock(lastgradsmutex);
+		std::swap(grads, lastgrads);
+		lastgradstate.assign(uarr, uarr + static_cast<size_t>(m->gnelem())*nvars);
+		lastgradsexact = !partialrecon;
+	}
+
+	return ierr;
+}
+
+/* All work arrays are indexed by the local cells and faces of the stencil. The face values of the
+ * cells of the first two layers are stored by cell and face, as they are produced by
+ * SolutionReconstruction::compute_cell_face_values; each face shared by two rows is visited once.
+ */
+template<typename scalar, bool secondOrderRequested, bool constVisc, int nvars>
+StatusCode FlowFV<scalar,secondOrderRequested,constVisc,nvars>
+::compute_local_residual(const LocalStencil& st, const scalar *const uarr,
+                         const scalar *const urows, scalar *const rrows) const
+{
+	if(pconfig.viscous_sim)
+		return Spatial<scalar,nvars>::compute_local_residual(st, uarr, urows, rrows);
+
+	fvens_throw(static_cast<int>(st.layerstarts.size())-2 < localStencilLayers(),
+	            "The local stencil has too few layers!");
+
+	const a_int nloc = static_cast<a_int>(st.cells.size());
+
+	// cell-centred states of the local cells
+	std::vector<scalar> ul(nloc*nvars);
+	for(a_int l = 0; l < nloc; l++)
+		for(int j = 0; j < nvars; j++)
+			ul[l*nvars+j] = l < st.nrows ? urows[l*nvars+j] : uarr[st.cells[l]*nvars+j];
+
+	// face values of the rows and the first layer, by cell and face
+	std::vector<scalar> uface;
+	if(secondOrderRequested)
+	{
+		const a_int ngrad = st.layerstarts[3];
+		const a_int nrec = st.layerstarts[2];
+		const a_int nbf = static_cast<a_int>(st.bfaces.size());
+
+		// ghost states of the local boundary faces
+		std::vector<scalar> ugp(nbf*nvars);
+		for(a_int l = 0; l < ngrad; l++)
+			for(a_int k = st.nbrstarts[l]; k < st.nbrstarts[l+1]; k++)
+				if(st.nbrs[k] < 0) {
+					const a_int ib = -1-st.nbrs[k];
+					compute_boundary_state(st.bfaces[ib], &ul[l*nvars], &ugp[ib*nvars]);
 				}
+
+		std::vector<scalar> up(nloc*nvars);
+		statesToPrimitive<scalar,nvars>(physics, nloc, &ul[0], &up[0]);
+		if(nbf > 0)
+			statesToPrimitive<scalar,nvars>(physics, nbf, &ugp[0], &ugp[0]);
+
+		// neighbours' primitive states of face j of local cell l
+		const auto nbrstate = [&](const a_int l, const int j) -> const scalar* {
+			const a_int nbr = st.nbrs[st.nbrstarts[l]+j];
+			return nbr >= 0 ? &up[nbr*nvars] : &ugp[(-1-nbr)*nvars];
+		};
+
+		GradArray<scalar,nvars> grads(ngrad);
+		std::vector<const scalar*> unbrs;
+		for(a_int l = 0; l < ngrad; l++)
+		{
+			const int nfael = m->gnfael(st.cells[l]);
+			unbrs.resize(nfael);
+			for(int j = 0; j < nfael; j++)
+				unbrs[j] = nbrstate(l,j);
+			gradcomp->compute_cell_gradient(st.cells[l], &up[l*nvars], &unbrs[0], grads[l]);
+		}
+
+		uface.resize(st.nbrstarts[nrec]*nvars);
+		std::vector<const Eigen::Array<scalar,NDIM,nvars>*> nbrgrads;
+		std::vector<scalar*> ufaces;
+		for(a_int l = 0; l < nrec; l++)
+		{
+			const int nfael = m->gnfael(st.cells[l]);
+			unbrs.resize(nfael);
+			nbrgrads.resize(nfael);
+			ufaces.resize(nfael);
+			for(int j = 0; j < nfael; j++) {
+				const a_int nbr = st.nbrs[st.nbrstarts[l]+j];
+				unbrs[j] = nbrstate(l,j);
+				nbrgrads[j] = nbr >= 0 ? &grads[nbr] : nullptr;
+				ufaces[j] = &uface[(st.nbrstarts[l]+j)*nvars];
 			}
-			
-			// compute max allowable time steps
-			if(gettimesteps) 
-			{
-				//calculate speeds of sound
-				const scalar ci = physics.getSoundSpeedFromConserved(&uleft(ied,0));
-				const scalar cj = physics.getSoundSpeedFromConserved(&uright(ied,0));
-				//calculate normal velocities
-				const scalar vni = (uleft(ied,1)*n[0] +uleft(ied,2)*n[1])/uleft(ied,0);
-				const scalar vnj = (uright(ied,1)*n[0] + uright(ied,2)*n[1])/uright(ied,0);
+			lim->compute_cell_face_values(st.cells[l], &up[l*nvars], &unbrs[0], grads[l],
+			                              &nbrgrads[0], &ufaces[0]);
+		}
 
-				scalar specradi = (fabs(vni)+ci)*len;
-				scalar specradj = (fabs(vnj)+cj)*len;
+		statesToConserved<scalar,nvars>(physics, st.nbrstarts[nrec], &uface[0], &uface[0]);
+	}
 
-				if(pconfig.viscous_sim) 
-				{
-					scalar mui, muj;
-					if(constVisc) {
-						mui = physics.getConstantViscosityCoeff();
-						muj = physics.getConstantViscosityCoeff();
-					}
-					else {
-						mui = physics.getViscosityCoeffFromConserved(&uleft(ied,0));
-						muj = physics.getViscosityCoeffFromConserved(&uright(ied,0));
-					}
-					const scalar coi = std::max(4.0/(3*uleft(ied,0)), physics.g/uleft(ied,0));
-					const scalar coj = std::max(4.0/(3*uright(ied,0)), physics.g/uright(ied,0));
-					
-					specradi += coi*mui/physics.Pr * len*len/m->garea(lelem);
-					if(relem < m->gnelem())
-						specradj += coj*muj/physics.Pr * len*len/m->garea(relem);
-				}
+	// state on the side of local cell l of its face j
+	const auto facestate = [&](const a_int l, const int j) -> const scalar* {
+		return secondOrderRequested ? &uface[(st.nbrstarts[l]+j)*nvars] : &ul[l*nvars];
+	};
 
-#pragma omp atomic
-				integ(lelem) += specradi;
-				
-				if(relem < m->gnelem()) {
-#pragma omp atomic
-					integ(relem) += specradj;
+	for(a_int i = 0; i < st.nrows*nvars; i++)
+		rrows[i] = 0;
+
+	// the face geometry is that of the face loops of the full residual
+	faceloops.withFaceData([&](const auto& faces)
+	{
+		for(a_int l = 0; l < st.nrows; l++)
+		{
+			const a_int iel = st.cells[l];
+			for(int j = 0; j < m->gnfael(iel); j++)
+			{
+				const a_int nbr = st.nbrs[st.nbrstarts[l]+j];
+				// faces between two rows are computed once
+				if(nbr >= 0 && nbr < l)
+					continue;
+
+				const a_int iface = m->gelemface(iel,j);
+				const bool isleft = faces.leftCell(iface) == iel;
+
+				const scalar *const uown = facestate(l,j);
+				scalar ughost[nvars];
+				const scalar *unbr = ughost;
+				if(nbr < 0)
+					compute_boundary_state(iface, uown, ughost);
+				else {
+					const a_int jel = st.cells[nbr];
+					int jn = 0;
+					while(m->gelemface(jel,jn) != iface)
+						jn++;
+					unbr = facestate(nbr,jn);
 				}
+
+				const scalar *const uleft = isleft ? uown : unbr;
+				const scalar *const uright = isleft ? unbr : uown;
+				const scalar n[NDIM] = {faces.normal(iface,0), faces.normal(iface,1)};
+				const scalar len = faces.length(iface);
+				scalar fluxes[nvars];
+				inviflux->get_flux(uleft, uright, n, fluxes);
+				passiveScalarFlux<scalar,nvars>(uleft, uright, fluxes);
+
+				// -flux is added to the left cell and the flux to the right cell
+				const scalar sign = isleft ? -1.0 : 1.0;
+				for(int ivar = 0; ivar < nvars; ivar++)
+					rrows[l*nvars+ivar] += sign*fluxes[ivar]*len;
+				if(nbr >= 0 && nbr < st.nrows)
+					for(int ivar = 0; ivar < nvars; ivar++)
+						rrows[nbr*nvars+ivar] -= sign*fluxes[ivar]*len;
 			}
 		}
+	});
 
-#pragma omp barrier
+	return 0;
+}
 
-		if(gettimesteps)
-#pragma omp for simd
-			for(a_int iel = 0; iel < m->gnelem(); iel++)
+/// Copies nk consecutive states, beginning with state k0, of each cell of an interleaved batch of
+///  nstates states into an interleaved batch of nk states
+template <typename scalar, int nvars>
+static void extractStates(const a_int nelem, const int nstates, const int k0, const int nk,
+                          const scalar *const src, scalar *const dst)
+{
+#pragma omp parallel for default(shared)
+	for(a_int iel = 0; iel < nelem; iel++)
+		for(int i = 0; i < nk*nvars; i++)
+			dst[iel*nk*nvars + i] = src[(iel*nstates + k0)*nvars + i];
+}
+
+/// Copies an interleaved batch of nk states back into states k0 to k0+nk-1 of an interleaved
+///  batch of nstates states
+template <typename scalar, int nvars>
+static void insertStates(const a_int nelem, const int nstates, const int k0, const int nk,
+                         const scalar *const src, scalar *const dst)
+{
+#pragma omp parallel for default(shared)
+	for(a_int iel = 0; iel < nelem; iel++)
+		for(int i = 0; i < nk*nvars; i++)
+			dst[(iel*nstates + k0)*nvars + i] = src[iel*nk*nvars + i];
+}
+
+template<typename scalar, bool secondOrderRequested, bool constVisc, int nvars>
+StatusCode FlowFV<scalar,secondOrderRequested,constVisc,nvars>
+::compute_residual_batch(const int nstates, const scalar *const uarr, scalar *const rarr) const
+{
+	StatusCode ierr = 0;
+	const a_int nelem = m->gnelem();
+	std::vector<a_real> dtmdummy;
+	std::vector<scalar> uwork, rwork;
+
+	for(int k0 = 0; k0 < nstates; )
+	{
+		const int rem = nstates - k0;
+		const int nk = pconfig.viscous_sim || isTurbulent(pconfig) ? 1
+			: rem >= 16 ? 16 : rem >= 8 ? 8 : rem >= 4 ? 4 : 1;
+
+		// the sub-batch needs to be copied out unless it is the whole batch
+		const scalar *uk = uarr;
+		scalar *rk = rarr;
+		if(nk < nstates) {
+			uwork.resize(nelem*nk*nvars);
+			rwork.resize(nelem*nk*nvars);
+			extractStates<scalar,nvars>(nelem, nstates, k0, nk, uarr, &uwork[0]);
+			extractStates<scalar,nvars>(nelem, nstates, k0, nk, rarr, &rwork[0]);
+			uk = &uwork[0];
+			rk = &rwork[0];
+		}
+
+		switch(nk) {
+		case 16:
+			ierr = compute_residual_multi<16>(uk, rk); CHKERRQ(ierr);
+			break;
+		case 8:
+			ierr = compute_residual_multi<8>(uk, rk); CHKERRQ(ierr);
+			break;
+		case 4:
+			ierr = compute_residual_multi<4>(uk, rk); CHKERRQ(ierr);
+			break;
+		default:
+			ierr = compute_residual(uk, rk, false, dtmdummy); CHKERRQ(ierr);
+		}
+
+		if(nk < nstates)
+			insertStates<scalar,nvars>(nelem, nstates, k0, nk, &rwork[0], rarr);
+		k0 += nk;
+	}
+	return ierr;
+}
+
+template<typename scalar, bool secondOrderRequested, bool constVisc, int nvars>
+template <int K>
+const typename FlowFV<scalar,secondOrderRequested,constVisc,nvars>::template BatchNumerics<K*nvars>&
+FlowFV<scalar,secondOrderRequested,constVisc,nvars>::getBatchNumerics() const
+{
+	BatchNumerics<K*nvars>& bn = batchNumerics(std::integral_constant<int,K>());
+	std::call_once(bn.created, [this,&bn]() {
+		bn.gradcomp = create_const_gradientscheme<scalar,K*nvars>(nconfig.gradientscheme, m, rc,
+		                                                         &faceloops);
+		bn.lim = create_const_reconstruction<scalar,K*nvars>(nconfig.reconstruction, m, rc, gr,
+		                                                    nconfig.limiter_param);
+	});
+	return bn;
+}
+
+/** The K states are treated as one state of K*nvars variables by the gradient and reconstruction
+ * schemes, all of which act on each variable independently. In the face loop, the geometry and
+ * connectivity of each face are loaded once and the fluxes of all K states are computed with them.
+ */
+template<typename scalar, bool secondOrderRequested, bool constVisc, int nvars>
+template <int K>
+StatusCode FlowFV<scalar,secondOrderRequested,constVisc,nvars>
+::compute_residual_multi(const scalar *const uarr, scalar *const __restrict rarr) const
+{
+	constexpr int nb = K*nvars;
+	StatusCode ierr = 0;
+	amat::Array2d<scalar> ug, uleft, uright;
+	uleft.resize(m->gnaface(), nb);
+	uright.resize(m->gnaface(), nb);
+
+	Eigen::Map<const MVector<scalar>> u(uarr, m->gnelem(), nb);
+	Eigen::Map<MVector<scalar>> residual(rarr, m->gnelem(), nb);
+
+	// cell-centred values of boundary cells as left-side values of boundary faces
+#pragma omp parallel for default(shared)
+	for(a_int ied = 0; ied < m->gnbface(); ied++)
+	{
+		const a_int ielem = m->gintfac(ied,0);
+		for(int ivar = 0; ivar < nb; ivar++)
+			uleft(ied,ivar) = u(ielem,ivar);
+	}
+
+	if(secondOrderRequested)
+	{
+		const BatchNumerics<nb>& bn = getBatchNumerics<K>();
+		GradArray<scalar,nb> grads(m->gnelem());
+		MVector<scalar> up(m->gnelem(), nb);
+		ug.resize(m->gnbface(), nb);
+
+		// ghost states and conversion to primitive variables; a row holds K states
+#pragma omp parallel default(shared)
+		{
+#pragma omp for
+			for(a_int iface = 0; iface < m->gnbface(); iface++)
+				for(int k = 0; k < K; k++)
+					compute_boundary_state(iface, &uleft(iface,k*nvars), &ug(iface,k*nvars));
+
+#pragma omp for
+			for(a_int iface = 0; iface < m->gnbface(); iface += conversion_batch)
+				statesToPrimitive<scalar,nvars>(physics, batchSize(iface, m->gnbface())*K,
+				                                &ug(iface,0), &ug(iface,0));
+
+#pragma omp for
+			for(a_int iel = 0; iel < m->gnelem(); iel += conversion_batch)
+				statesToPrimitive<scalar,nvars>(physics, batchSize(iel, m->gnelem())*K,
+				                                &uarr[iel*nb], &up(iel,0));
+		}
+
+		beginPerfStage(PERFSTAGE_GRADIENT);
+		bn.gradcomp->compute_gradients(up, ug, grads);
+		endPerfStage(PERFSTAGE_GRADIENT);
+
+		beginPerfStage(PERFSTAGE_LIMITER);
+		bn.lim->compute_face_values(up, ug, grads, uleft, uright);
+		endPerfStage(PERFSTAGE_LIMITER);
+
+#pragma omp parallel default(shared)
+		{
+#pragma omp for
+			for(a_int iface = m->gnbface(); iface < m->gnaface(); iface += conversion_batch)
 			{
-				dtm[iel] = m->garea(iel)/integ(iel);
+				const a_int nf = batchSize(iface, m->gnaface())*K;
+				statesToConserved<scalar,nvars>(physics, nf, &uleft(iface,0), &uleft(iface,0));
+				statesToConserved<scalar,nvars>(physics, nf, &uright(iface,0), &uright(iface,0));
 			}
-	} // end parallel region
-	
+#pragma omp for
+			for(a_int iface = 0; iface < m->gnbface(); iface += conversion_batch)
+				statesToConserved<scalar,nvars>(physics, batchSize(iface, m->gnbface())*K,
+				                                &uleft(iface,0), &uleft(iface,0));
+		}
+	}
+	else
+	{
+#pragma omp parallel for default(shared)
+		for(a_int ied = m->gnbface(); ied < m->gnaface(); ied++)
+		{
+			const a_int ielem = m->gintfac(ied,0);
+			const a_int jelem = m->gintfac(ied,1);
+			for(int ivar = 0; ivar < nb; ivar++)
+			{
+				uleft(ied,ivar) = u(ielem,ivar);
+				uright(ied,ivar) = u(jelem,ivar);
+			}
+		}
+	}
+
+	// right (ghost) states of boundary faces
+#pragma omp parallel for default(shared)
+	for(a_int ied = 0; ied < m->gnbface(); ied++)
+		for(int k = 0; k < K; k++)
+			compute_boundary_state(ied, &uleft(ied,k*nvars), &uright(ied,k*nvars));
+
+	beginPerfStage(PERFSTAGE_FLUX);
+	faceloops.executeWithFaceData([&](const auto& faces, const a_int ied, const bool updleft,
+	                                  const bool updright, const bool atomic)
+	{
+		const a_int lelem = faces.leftCell(ied);
+		const a_int relem = faces.rightCell(ied);
+		const bool updr = updright && relem < m->gnelem();
+
+		scalar n[NDIM];
+		n[0] = faces.normal(ied,0);
+		n[1] = faces.normal(ied,1);
+		const scalar len = faces.length(ied);
+
+		for(int k = 0; k < K; k++)
+		{
+			scalar fluxes[nvars];
+			inviflux->get_flux(&uleft(ied,k*nvars), &uright(ied,k*nvars), n, fluxes);
+			passiveScalarFlux<scalar,nvars>(&uleft(ied,k*nvars), &uright(ied,k*nvars), fluxes);
+
+			if(updleft)
+				for(int ivar = 0; ivar < nvars; ivar++)
+					faceLoopUpdate(residual(lelem,k*nvars+ivar), -fluxes[ivar]*len, atomic);
+			if(updr)
+				for(int ivar = 0; ivar < nvars; ivar++)
+					faceLoopUpdate(residual(relem,k*nvars+ivar), fluxes[ivar]*len, atomic);
+		}
+	});
+	endPerfStage(PERFSTAGE_FLUX);
+
 	return ierr;
 }
 
-template<typename scalar, bool order2, bool constVisc>
-StatusCode FlowFV<scalar,order2,constVisc>::compute_jacobian(const Vec uvec, Mat A) const
+template<typename scalar, bool secondOrderRequested, bool constVisc, int nvars>
+void FlowFV<scalar,secondOrderRequested,constVisc,nvars>
+::compute_turbulence_source(const scalar *const uarr, std::vector<scalar>& src,
+                            std::vector<scalar>& dsrc) const
+{
+	// number of variables whose gradients are needed: x- and y-velocities and the working variable
+	constexpr int ngv = 3;
+
+	Eigen::Map<const MVector<scalar>> u(uarr, m->gnelem(), nvars);
+	amat::Array2d<scalar> gg(m->gnelem(), NDIM*ngv);
+	gg.zeros();
+
+	faceloops.execute([&](const a_int ied, const bool updleft, const bool updright,
+	                      const bool atomic)
+	{
+		const a_int lelem = m->gintfac(ied,0);
+		const a_int relem = m->gintfac(ied,1);
+		const scalar len = m->gfacemetric(ied,2);
+
+		scalar ughost[nvars];
+		const scalar *ur = nullptr;
+		if(ied < m->gnbface()) {
+			compute_boundary_state(ied, &uarr[lelem*nvars], ughost);
+			ur = ughost;
+		}
+		else
+			ur = &uarr[relem*nvars];
+		const scalar *const ul = &uarr[lelem*nvars];
+
+		scalar vals[ngv];
+		vals[0] = 0.5*(ul[1]/ul[0] + ur[1]/ur[0]);
+		vals[1] = 0.5*(ul[2]/ul[0] + ur[2]/ur[0]);
+		vals[2] = 0;
+		for(int k = NVARS; k < nvars; k++)
+			vals[2] = 0.5*(ul[k]/ul[0] + ur[k]/ur[0]);
+
+		for(int j = 0; j < NDIM; j++)
+			for(int i = 0; i < ngv; i++)
+			{
+				const scalar contrib = vals[i]*m->gfacemetric(ied,j)*len;
+				if(updleft)
+					faceLoopUpdate(gg(lelem,j*ngv+i), contrib, atomic);
+				if(updright && relem < m->gnelem())
+					faceLoopUpdate(gg(relem,j*ngv+i), -contrib, atomic);
+			}
+	});
+
+	src.resize(m->gnelem());
+	dsrc.resize(m->gnelem());
+
+#pragma omp parallel for default(shared)
+	for(a_int iel = 0; iel < m->gnelem(); iel++)
+	{
+		const scalar area = m->garea(iel);
+		const scalar rho = u(iel,0);
+		scalar nut = 0;
+		for(int k = NVARS; k < nvars; k++)
+			nut = u(iel,k)/rho;
+		const scalar mu = constVisc ? physics.getConstantViscosityCoeff()
+			: physics.getViscosityCoeffFromConserved(&uarr[iel*nvars]);
+
+		const scalar vort = std::abs(gg(iel,ngv) - gg(iel,1))/area;
+		const scalar gradnut2 = (gg(iel,2)*gg(iel,2) + gg(iel,ngv+2)*gg(iel,ngv+2))/(area*area);
+
+		scalar ds = 0;
+		src[iel] = area*sa.source(rho, nut, mu, vort, walldist->distance(iel), gradnut2, ds);
+		dsrc[iel] = area*ds;
+	}
+}
+
+template<typename scalar, bool order2, bool constVisc, int nvars>
+void FlowFV<scalar,order2,constVisc,nvars>::compute_boundary_face_jacobian(const a_int iface,
+                                                                          const a_real *const uarr,
+                                                                          a_real *const leftarr)
+	const
+{
+	const a_int lelem = m->gintfac(iface,0);
+	const std::array<a_real,NDIM> n = m->gnormal(iface);
+	const a_real len = m->gfacemetric(iface,2);
+	const a_real *const ul = &uarr[lelem*nvars];
+	
+	a_real uface[nvars];
+	Matrix<a_real,nvars,nvars,RowMajor> drdl;
+	Matrix<a_real,nvars,nvars,RowMajor> right;
+	Eigen::Map<Matrix<a_real,nvars,nvars,RowMajor>> left(leftarr);
+
+	// With passive scalars, the flow blocks are computed separately and then embedded
+	Matrix<a_real,NVARS,NVARS,RowMajor> drdlflow, leftflow, rightflow;
+	a_real *const drdlf = nvars == NVARS ? drdl.data() : drdlflow.data();
+	a_real *const leftf = nvars == NVARS ? left.data() : leftflow.data();
+	a_real *const rightf = nvars == NVARS ? right.data() : rightflow.data();
+	
+	bcs.at(m->gintfacbtags(iface,0))->computeGhostStateAndJacobian(ul, &n[0], uface, drdlf);
+	
+	jflux->get_jacobian(ul, uface, &n[0], leftf, rightf);
+
+	if(pconfig.viscous_sim) {
+		//compute_viscous_flux_approximate_jacobian(iface, ul, uface, leftf, rightf);
+		compute_viscous_flux_jacobian(iface, ul, uface, leftf, rightf);
+	}
+
+	if(nvars > NVARS)
+	{
+		const bool imposed = isPassiveScalarImposed(iface);
+		const a_real sign = isPassiveScalarReflected(iface) ? -1.0 : 1.0;
+		for(int k = NVARS; k < nvars; k++)
+			uface[k] = uface[0] * (imposed ? scalarinf[k-NVARS] : sign*ul[k]/ul[0]);
+		passiveScalarGhostJacobian<nvars>(imposed, sign, ul, uface, drdlf, drdl.data());
+
+		a_real mflux[NVARS];
+		inviflux->get_flux(ul, uface, &n[0], mflux);
+		passiveScalarFluxJacobian<nvars>(ul, uface, mflux[0], leftf, rightf,
+		                                 left.data(), right.data());
+
+		if(isTurbulent(pconfig))
+			addTurbulentFluxJacobian<scalar,nvars>(sa, ul, uface, faceViscosity(ul, uface),
+			                                       projectedCentreDistance(iface), left.data(),
+			                                       right.data());
+	}
+	
+	/* The actual derivative is  dF/dl  +  dF/dr * dr/dl.
+	 * We actually need to subtract dF/dr from dF/dl because the inviscid numerical flux
+	 * computation returns the negative of dF/dl but positive dF/dr. The latter was done to
+	 * get correct signs for lower and upper off-diagonal blocks.
+	 *
+	 * Integrate the results over the face and negate, as -ve of L is added to D
+	 */
+	left = -len*(left - right*drdl);
+}
+
+template<typename scalar, bool order2, bool constVisc, int nvars>
+void FlowFV<scalar,order2,constVisc,nvars>::compute_interior_face_jacobian(const a_int iface,
+                                                                          const a_real *const uarr,
+                                                                          a_real *const L,
+                                                                          a_real *const U) const
+{
+	const a_int lelem = m->gintfac(iface,0);
+	const a_int relem = m->gintfac(iface,1);
+	a_real n[NDIM];
+	n[0] = m->gfacemetric(iface,0);
+	n[1] = m->gfacemetric(iface,1);
+	const a_real len = m->gfacemetric(iface,2);
+	const a_real *const ul = &uarr[lelem*nvars];
+	const a_real *const ur = &uarr[relem*nvars];
+
+	// With passive scalars, the flow blocks are computed separately and then embedded
+	Matrix<a_real,NVARS,NVARS,RowMajor> Lflow, Uflow;
+	a_real *const Lf = nvars == NVARS ? L : Lflow.data();
+	a_real *const Uf = nvars == NVARS ? U : Uflow.data();
+
+	// NOTE: the values of L and U get REPLACED here, not added to
+	jflux->get_jacobian(ul, ur, n, Lf, Uf);
+
+	if(pconfig.viscous_sim) {
+		//compute_viscous_flux_approximate_jacobian(iface, ul, ur, Lf, Uf);
+		compute_viscous_flux_jacobian(iface, ul, ur, Lf, Uf);
+	}
+
+	if(nvars > NVARS) {
+		a_real mflux[NVARS];
+		inviflux->get_flux(ul, ur, n, mflux);
+		passiveScalarFluxJacobian<nvars>(ul, ur, mflux[0], Lf, Uf, L, U);
+
+		if(isTurbulent(pconfig))
+			addTurbulentFluxJacobian<scalar,nvars>(sa, ul, ur, faceViscosity(ul, ur),
+			                                       projectedCentreDistance(iface), L, U);
+	}
+
+	for(int i = 0; i < nvars*nvars; i++) {
+		L[i] *= len;
+		U[i] *= len;
+	}
+}
+
+template<typename scalar, bool order2, bool constVisc, int nvars>
+StatusCode FlowFV<scalar,order2,constVisc,nvars>::compute_jacobian(const Vec uvec, Mat A) const
 {
 	StatusCode ierr = 0;
 
 	PetscInt locnelem; const PetscScalar *uarr;
 	ierr = VecGetLocalSize(uvec, &locnelem); CHKERRQ(ierr);
-	assert(locnelem % NVARS == 0);
-	locnelem /= NVARS;
+	assert(locnelem % nvars == 0);
+	locnelem /= nvars;
 	assert(locnelem == m->gnelem());
 
 	ierr = VecGetArrayRead(uvec, &uarr); CHKERRQ(ierr);
@@ -689,33 +1863,8 @@ StatusCode FlowFV<scalar,order2,constVisc>::compute_jacobian(const Vec uvec, Mat
 	for(a_int iface = 0; iface < m->gnbface(); iface++)
 	{
 		const a_int lelem = m->gintfac(iface,0);
-		const std::array<a_real,NDIM> n = m->gnormal(iface);
-		const a_real len = m->gfacemetric(iface,2);
-		
-		a_real uface[NVARS];
-		Matrix<a_real,NVARS,NVARS,RowMajor> drdl;
-		Matrix<a_real,NVARS,NVARS,RowMajor> left;
-		Matrix<a_real,NVARS,NVARS,RowMajor> right;
-		
-		bcs.at(m->gintfacbtags(iface,0))->computeGhostStateAndJacobian(&uarr[lelem*NVARS], &n[0],
-		                                                               uface, &drdl(0,0));
-		
-		inviflux->get_jacobian(&uarr[lelem*NVARS], uface, &n[0], &left(0,0), &right(0,0));
-
-		if(pconfig.viscous_sim) {
-			//compute_viscous_flux_approximate_jacobian(iface, &uarr[lelem*NVARS], uface, 
-			//		&left(0,0), &right(0,0));
-			compute_viscous_flux_jacobian(iface,&uarr[lelem*NVARS],uface, &left(0,0), &right(0,0));
-		}
-		
-		/* The actual derivative is  dF/dl  +  dF/dr * dr/dl.
-		 * We actually need to subtract dF/dr from dF/dl because the inviscid numerical flux
-		 * computation returns the negative of dF/dl but positive dF/dr. The latter was done to
-		 * get correct signs for lower and upper off-diagonal blocks.
-		 *
-		 * Integrate the results over the face and negate, as -ve of L is added to D
-		 */
-		left = -len*(left - right*drdl);
+		Matrix<a_real,nvars,nvars,RowMajor> left;
+		compute_boundary_face_jacobian(iface, uarr, left.data());
 
 #pragma omp critical
 		{
@@ -726,27 +1875,12 @@ StatusCode FlowFV<scalar,order2,constVisc>::compute_jacobian(const Vec uvec, Mat
 #pragma omp parallel for default(shared)
 	for(a_int iface = m->gnbface(); iface < m->gnaface(); iface++)
 	{
-		//const a_int intface = iface-m->gnbface();
 		const a_int lelem = m->gintfac(iface,0);
 		const a_int relem = m->gintfac(iface,1);
-		a_real n[NDIM];
-		n[0] = m->gfacemetric(iface,0);
-		n[1] = m->gfacemetric(iface,1);
-		const a_real len = m->gfacemetric(iface,2);
-		Matrix<a_real,NVARS,NVARS,RowMajor> L;
-		Matrix<a_real,NVARS,NVARS,RowMajor> U;
-	
-		// NOTE: the values of L and U get REPLACED here, not added to
-		inviflux->get_jacobian(&uarr[lelem*NVARS], &uarr[relem*NVARS], n, &L(0,0), &U(0,0));
+		Matrix<a_real,nvars,nvars,RowMajor> L;
+		Matrix<a_real,nvars,nvars,RowMajor> U;
+		compute_interior_face_jacobian(iface, uarr, L.data(), U.data());
 
-		if(pconfig.viscous_sim) {
-			//compute_viscous_flux_approximate_jacobian(iface, &uarr[lelem*NVARS], &uarr[relem*NVARS], 
-			//		&L(0,0), &U(0,0));
-			compute_viscous_flux_jacobian(iface, &uarr[lelem*NVARS], &uarr[relem*NVARS], 
-			                              &L(0,0), &U(0,0));
-		}
-
-		L *= len; U *= len;
 #pragma omp critical
 		{
 			ierr = MatSetValuesBlocked(A, 1, &relem, 1, &lelem, L.data(), ADD_VALUES);
@@ -768,11 +1902,102 @@ StatusCode FlowFV<scalar,order2,constVisc>::compute_jacobian(const Vec uvec, Mat
 		}
 	}
 
+	if(isTurbulent(pconfig))
+	{
+		// derivative of the source term, which is subtracted in the residual r(u)
+		std::vector<a_real> src, dsrc;
+		compute_turbulence_source(uarr, src, dsrc);
+		for(a_int iel = 0; iel < m->gnelem(); iel++)
+		{
+			Matrix<a_real,nvars,nvars,RowMajor> D = Matrix<a_real,nvars,nvars,RowMajor>::Zero();
+			for(int k = NVARS; k < nvars; k++)
+				D(k,k) = -dsrc[iel];
+			ierr = MatSetValuesBlocked(A, 1, &iel, 1, &iel, D.data(), ADD_VALUES); CHKERRQ(ierr);
+		}
+	}
+
 	ierr = VecRestoreArrayRead(uvec, &uarr); CHKERRQ(ierr);
 	
 	return ierr;
 }
 
+template<typename scalar, bool order2, bool constVisc, int nvars>
+StatusCode FlowFV<scalar,order2,constVisc,nvars>::update_jacobian(const Vec uvec, Mat A,
+                                                           JacobianUpdateInfo& info) const
+{
+	if(!jaccache)
+		return Spatial<scalar,nvars>::update_jacobian(uvec, A, info);
+
+	StatusCode ierr = 0;
+	const PetscScalar *uarr;
+	ierr = VecGetArrayRead(uvec, &uarr); CHKERRQ(ierr);
+
+	jaccache->markActiveFaces(uarr);
+	info.full = jaccache->isFullRefresh();
+	info.fraction = static_cast<a_real>(jaccache->numActiveFaces())/m->gnaface();
+
+	if(info.full) {
+		ierr = MatZeroEntries(A); CHKERRQ(ierr);
+	}
+
+	/* At a full refresh, the cached blocks are just overwritten and added to the zeroed matrix.
+	 * Otherwise, the differences between the new and the cached blocks of active faces are added.
+	 */
+	const a_real oldfactor = info.full ? 0.0 : 1.0;
+
+#pragma omp parallel for default(shared)
+	for(a_int iface = 0; iface < m->gnbface(); iface++)
+	{
+		if(!jaccache->isFaceActive(iface))
+			continue;
+
+		const a_int lelem = m->gintfac(iface,0);
+		Eigen::Map<Matrix<a_real,nvars,nvars,RowMajor>> cached(jaccache->lowerBlock(iface));
+		Matrix<a_real,nvars,nvars,RowMajor> left;
+		compute_boundary_face_jacobian(iface, uarr, left.data());
+
+		const Matrix<a_real,nvars,nvars,RowMajor> dleft = left - oldfactor*cached;
+		cached = left;
+
+#pragma omp critical
+		{
+			ierr = MatSetValuesBlocked(A, 1,&lelem, 1,&lelem, dleft.data(), ADD_VALUES);
+		}
+	}
+
+#pragma omp parallel for default(shared)
+	for(a_int iface = m->gnbface(); iface < m->gnaface(); iface++)
+	{
+		if(!jaccache->isFaceActive(iface))
+			continue;
+
+		const a_int lelem = m->gintfac(iface,0);
+		const a_int relem = m->gintfac(iface,1);
+		Eigen::Map<Matrix<a_real,nvars,nvars,RowMajor>> cachedL(jaccache->lowerBlock(iface));
+		Eigen::Map<Matrix<a_real,nvars,nvars,RowMajor>> cachedU(jaccache->upperBlock(iface));
+		Matrix<a_real,nvars,nvars,RowMajor> L;
+		Matrix<a_real,nvars,nvars,RowMajor> U;
+		compute_interior_face_jacobian(iface, uarr, L.data(), U.data());
+
+		Matrix<a_real,nvars,nvars,RowMajor> dL = L - oldfactor*cachedL;
+		Matrix<a_real,nvars,nvars,RowMajor> dU = U - oldfactor*cachedU;
+		cachedL = L;
+		cachedU = U;
+
+#pragma omp critical
+		{
+			ierr = MatSetValuesBlocked(A, 1, &relem, 1, &lelem, dL.data(), ADD_VALUES);
+			ierr = MatSetValuesBlocked(A, 1, &lelem, 1, &relem, dU.data(), ADD_VALUES);
+			dL *= -1.0; dU *= -1.0;
+			ierr = MatSetValuesBlocked(A, 1, &lelem, 1, &lelem, dL.data(), ADD_VALUES);
+			ierr = MatSetValuesBlocked(A, 1, &relem, 1, &relem, dU.data(), ADD_VALUES);
+		}
+	}
+
+	ierr = VecRestoreArrayRead(uvec, &uarr); CHKERRQ(ierr);
+	return ierr;
+}
+
 template class FlowFV_base<a_real>;
 
 template class FlowFV<a_real,true,true>;
@@ -780,5 +2005,13 @@ template class FlowFV<a_real,false,true>;
 template class FlowFV<a_real,true,false>;
 template class FlowFV<a_real,false,false>;
 
+// with one passive scalar
+template class FlowFV_base<a_real,NVARS+1>;
+
+template class FlowFV<a_real,true,true,NVARS+1>;
+template class FlowFV<a_real,false,true,NVARS+1>;
+template class FlowFV<a_real,true,false,NVARS+1>;
+template class FlowFV<a_real,false,false,NVARS+1>;
+
 }
 
@@ -20,11 +20,17 @@
 #ifndef FVENS_FLOW_SPATIAL_H
 #define FVENS_FLOW_SPATIAL_H
 
+#include <mutex>
+#include <type_traits>
 #include "aspatial.hpp"
 #include "anumericalflux.hpp"
 #include "agradientschemes.hpp"
 #include "areconstruction.hpp"
 #include "abc.hpp"
+#include "activeset.hpp"
+#include "surfaceintegrals.hpp"
+#include "mesh/walldistance.hpp"
+#include "physics/saturbulence.hpp"
 
 namespace fvens {
 
@@ -40,26 +46,54 @@ struct FlowPhysicsConfig
 	bool viscous_sim;                   ///< Whether to include viscous effects
 	bool const_visc;                    ///< Whether to use constant viscosity
 	std::vector<FlowBCConfig> bcconf;   ///< Boundary condition specification
+	/// Turbulence model - "NONE" or "SA" (Spalart-Allmaras, needs \ref NVARS+1 variables)
+	std::string turbulence_model;
 };
 
+/// Whether a turbulence model is requested in a physics configuration
+inline bool isTurbulent(const FlowPhysicsConfig& pconf) {
+	return pconf.turbulence_model == "SA";
+}
+
+/// Free-stream value of the SA working variable as a multiple of the free-stream kinematic
+///  viscosity, read from the option `-sa_freestream_viscosity_ratio' (3 by default)
+/** \param muinf Non-dimensional free-stream molecular viscosity (1/Re)
+ */
+a_real getSAFreestreamWorkingVariable(const a_real muinf);
+
 /// Collection of options related to the spatial discretization scheme
 struct FlowNumericsConfig
 {
 	std::string conv_numflux;         ///< Convective numerical flux to use
-	std::string conv_numflux_jac;     ///< Conv. numer. flux to use for approximate Jacobian
+	/// Conv. numer. flux to use for approximate Jacobian; if empty, \ref conv_numflux is used
+	std::string conv_numflux_jac;
 	std::string gradientscheme;       ///< Method to use to compute gradients
 	std::string reconstruction;       ///< Method to use to reconstruct the solution
 	a_real limiter_param;             ///< Parameter that is required for some limiters
 	bool order2;                      ///< Whether to compute a second-order solution
+	a_real lowmach_cutoff;            ///< Cut-off of the reference velocity of low-Mach
+	                                  ///<  preconditioning, which is used only if this is positive
 };
 
 /// Abstract base class for finite volume discretization of flow problems
-/** This is meant to be a template-parameter-free abstract class encapsulating a spatial discretization
- * for a flow problem.
+/** This is meant to be an abstract class encapsulating a spatial discretization for a flow problem,
+ * free of template parameters related to the numerical scheme.
+ *
+ * The first \ref NVARS conserved variables are those of the flow. Any further variables, up to
+ * nvars, are passive scalars, stored as density times the scalar. They are transported with the
+ * mass flux of the flow, upwinded by its sign; their diffusion is neglected. At far-field and
+ * inflow boundaries, the scalars take their free-stream values, given by the option
+ * `-passive_scalar_freestream' (zero by default); elsewhere, they are extrapolated from the
+ * interior. The flow does not depend on the scalars.
+ *
+ * If the Spalart-Allmaras model is requested, there must be exactly one variable beyond the flow
+ * variables. It is the SA working variable instead of a passive scalar; see \ref FlowFV.
  */
-template <typename scalar>
-class FlowFV_base : public Spatial<scalar,NVARS>
+template <typename scalar, int nvars = NVARS>
+class FlowFV_base : public Spatial<scalar,nvars>
 {
+	static_assert(nvars >= NVARS, "The flow variables must be part of the conserved variables!");
+
 public:
 	/// Sets data and initializes the numerics
 	FlowFV_base(const UMesh2dh<scalar> *const mesh,              ///< Mesh context
@@ -91,40 +125,118 @@ public:
 	                                     const bool gettimesteps,
 	                                     std::vector<a_real>& dtm) const;
 
+	/// Computes the residual re-using cached fluxes away from changed cells, if requested
+	/** If the option `-active_set_threshold' is given, fluxes are only recomputed at faces near
+	 * cells whose state has changed (see \ref ActiveSetResidual). Otherwise, same as
+	 * \ref assemble_residual.
+	 */
+	virtual StatusCode assemble_pseudotime_residual(const Vec u, Vec residual,
+	                                                const bool gettimesteps,
+	                                                std::vector<a_real>& dtm) const;
+
+	/// Whether the last pseudo-time residual was a full refresh of the active set, if any
+	bool last_pseudotime_residual_exact() const {
+		return !activecache || activecache->isFullRefresh();
+	}
+
+	/// Forgets the cached fluxes, so that the next pseudo-time residual is full
+	void reset_pseudotime_residual() const {
+		if(activecache)
+			activecache->reset();
+	}
+
+	/// Fraction of face fluxes actually computed by pseudo-time residuals so far
+	/** This is 1 without an active set. */
+	double pseudotime_active_fraction() const {
+		return activecache ? activecache->activeFraction() : 1.0;
+	}
+
+	/// The schedule of the threaded face loops
+	const FaceLoopSchedule<scalar>& faceLoopSchedule() const { return faceloops; }
+
 	/// Computes the [right hand side](@ref residual)
 	/** Actually computes -r(u) (ie., negative of r(u)), where the nonlinear problem being solved is 
 	 * [M du/dt +] r(u) = 0. 
 	 * Invokes flux calculation and adds the fluxes to the residual vector,
 	 * and also computes local time steps.
+	 * \param activeset If not null, fluxes are computed only at its active faces and taken from its
+	 *   cache elsewhere
 	 */
 	virtual StatusCode compute_residual(const scalar *const u, scalar *const __restrict residual,
-	                                    const bool gettimesteps, std::vector<a_real>& dtm) const = 0;
+	                                    const bool gettimesteps, std::vector<a_real>& dtm,
+	                                    ActiveSetResidual<scalar,nvars> *const activeset = nullptr)
+		const = 0;
+
+	/// Computes the residuals of several states together, in one pass over the mesh
+	/** The states are stored interleaved cell by cell: variable ivar of state k in cell iel is at
+	 * index (iel*nstates + k)*nvars + ivar, in both u and residual. Like \ref compute_residual,
+	 * -r(u) is added to the residual; no time steps are computed and no active set is used.
+	 *
+	 * For inviscid flows, the states are processed in batches of 16, 8 or 4, in each of which the
+	 * mesh data of every face and cell is loaded once for all states of the batch. Any remaining
+	 * states, and all states of viscous flows, are evaluated one after the other.
+	 */
+	virtual StatusCode compute_residual_batch(const int nstates, const scalar *const u,
+	                                          scalar *const __restrict residual) const = 0;
 
 	/// Computes Cp, Csf, Cl, Cd_p and Cd_sf on one surface
 	/** \param[in] u The multi-vector containing conserved variables
 	 * \param[in] grad Gradients of converved variables at cell-centres
 	 * \param[in] iwbcm The marker of the boundary on which the computation is to be done
 	 * \param[in,out] output On output, contains for each boundary face having the marker im : 
-	 *                   Cp and Csf, in that order
+	 *                   the coordinates of the face centre, Cp and Csf, in that order
 	 * \return A tuple containing Cl, Cd_p and Cd_sf.
-	 *
-	 * \todo Write unit tests
-	 * \todo Generalize to 3D
+	 * \sa SurfaceIntegrator
 	 */
 	std::tuple<scalar,scalar,scalar> computeSurfaceData(const MVector<scalar>& u,
-	                                                    const GradArray<scalar,NVARS>& grad,
+	                                                    const GradArray<scalar,nvars>& grad,
 	                                                    const int iwbcm,
 	                                                    MVector<scalar>& output) const;
 
+	/// Computes Cl, Cd_p and Cd_sf on one surface re-using the gradients of the last residual
+	/** Only the faces of the surface are visited, so this is cheap enough to be called every
+	 * pseudo-time step. The gradients are those computed by the last call to compute_residual that
+	 * computed time steps, which must have been at the state u. For first-order discretizations,
+	 * the gradients are computed here on every call if the flow is viscous.
+	 * \param[in] u Conserved variables at cell centres
+	 * \param[in] iwbcm The marker of the surface
+	 */
+	std::tuple<scalar,scalar,scalar> computeSurfaceForces(const scalar *const u, const int iwbcm)
+		const;
+
+	/// Computes Cl, Cd_p and Cd_sf over all the slip and no-slip walls together
+	/** The coefficients of the walls are weighted by their lengths. \sa computeSurfaceForces
+	 * \return False if there are no walls
+	 */
+	bool computeWallForces(const scalar *const u, scalar *const forces) const;
+
+	/// The boundary faces having a marker, in increasing order
+	const std::vector<a_int>& surfaceFaces(const int marker) const {
+		return surfint.faces(marker);
+	}
+
 	/// Computes gradients of converved variables
-	void getGradients(const MVector<scalar>& u, GradArray<scalar,NVARS>& grads) const;
+	void getGradients(const MVector<scalar>& u, GradArray<scalar,nvars>& grads) const;
+
+	/// Computes cell-centred gradients of primitive variables, as the residual does
+	void getPrimitiveGradients(const scalar *const u, GradArray<scalar,nvars>& grads) const;
+
+	/// Whether low-Mach preconditioning is used
+	bool hasPseudoTimePreconditioner() const { return lowmach != nullptr; }
+
+	/// Computes the low-Mach preconditioning matrix or its inverse \sa LowMachPreconditioner
+	void getPseudoTimePreconditioner(const scalar *const u, const bool inverse,
+	                                 scalar *const mat) const
+	{
+		lowmach->getMatrix<scalar,nvars>(u, inverse, mat);
+	}
 
 protected:
 
-	using Spatial<scalar,NVARS>::m;
-	using Spatial<scalar,NVARS>::rc;
-	using Spatial<scalar,NVARS>::gr;
-	using Spatial<scalar,NVARS>::getFaceGradient_modifiedAverage;
+	using Spatial<scalar,nvars>::m;
+	using Spatial<scalar,nvars>::rc;
+	using Spatial<scalar,nvars>::gr;
+	using Spatial<scalar,nvars>::getFaceGradient_modifiedAverage;
 
 	/// Problem specification
 	const FlowPhysicsConfig pconfig;
@@ -135,23 +247,47 @@ protected:
 	/// Analytical flux vector computation
 	const IdealGasPhysics<scalar> physics;
 
-	/// Free-stream/reference condition
+	/// Free-stream/reference condition of the flow
 	const std::array<a_real,NVARS> uinf;
 
+	/// Free-stream values of the passive scalars (not multiplied by density)
+	const std::array<a_real,nvars-NVARS> scalarinf;
+
+	/// Schedule of threaded loops over faces, selected by the option `-face_loop_mode'
+	/** Set up for the maximum number of OpenMP threads at construction; also used for gradients.
+	 */
+	const FaceLoopSchedule<scalar> faceloops;
+
+	/// Low-Mach preconditioning of the flux dissipation and local time steps; null if not used
+	const LowMachPreconditioner *const lowmach;
+
 	/// Numerical inviscid flux calculation context for residual computation
 	/** This is the "actual" flux being used.
 	 */
 	const InviscidFlux<scalar> *const inviflux;
 
+	/// Numerical inviscid flux whose Jacobian is used for the Jacobian matrix
+	/** This is the same object as \ref inviflux unless a different flux is requested in
+	 * \ref FlowNumericsConfig::conv_numflux_jac, such as a cheaper approximate one.
+	 */
+	const InviscidFlux<scalar> *const jflux;
+
 	/// Gradient computation context
-	const GradientScheme<scalar,NVARS> *const gradcomp;
+	const GradientScheme<scalar,nvars> *const gradcomp;
 
 	/// Reconstruction context
-	const SolutionReconstruction<scalar,NVARS> *const lim;
+	const SolutionReconstruction<scalar,nvars> *const lim;
 
 	/// The different boundary conditions required for all the boundaries
 	const std::map<int,const FlowBC<scalar>*> bcs;
 
+	/// Tracker of changed cells and cache of face fluxes for pseudo-time residuals; may be null
+	ActiveSetResidual<scalar,nvars> *const activecache;
+
+	/// Tracker of changed cells and cache of face Jacobian blocks for incremental Jacobian
+	/// updates; may be null
+	ActiveSetJacobian<a_real,nvars> *const jaccache;
+
 	/// Computes flow variables at all boundaries (either Gauss points or ghost cell centers) 
 	/// using the interior state provided
 	/** \param[in] instates provides the left (interior state) for each boundary face
@@ -169,6 +305,50 @@ protected:
 	 * \param[in,out] gs Ghost state of conserved variables
 	 */
 	void compute_boundary_state(const int ied, const scalar *const ins, scalar *const gs) const;
+
+	/// Distances of cell centres from the nearest no-slip wall; only computed for turbulent flow
+	const WallDistance<scalar> *const walldist;
+
+	/// Integrator of pressure and skin friction over boundary surfaces
+	const SurfaceIntegrator<scalar,nvars> surfint;
+
+	/// Markers of the slip and no-slip walls
+	const std::vector<int> wallmarkers;
+
+	/// Cell-centred gradients of primitive variables computed by the last residual evaluation
+	///  that computed time steps; empty if there has been none, or while one is running
+	/** Re-used by \ref computeSurfaceForces if they are exactly the gradients at the state given
+	 * to it, and as the storage of the gradients of the next such residual evaluation.
+	 */
+	mutable GradArray<scalar,nvars> lastgrads;
+
+	/// The state at which \ref lastgrads were computed
+	mutable std::vector<scalar> lastgradstate;
+
+	/// False if \ref lastgrads were only partly updated by an active-set residual evaluation
+	mutable bool lastgradsexact;
+
+	/// Guards \ref lastgrads and its state against concurrent residual evaluations and surface
+	///  force computations
+	mutable std::mutex lastgradsmutex;
+
+	/// Calls f with the gradients to integrate surface forces with, at the state u
+	/** These are \ref lastgrads if they were computed exactly at u. Otherwise, they are computed
+	 * afresh, unless the discretization is first-order and inviscid, in which case no gradients
+	 * are passed.
+	 * \param f A callable taking the gradients as a const GradArray<scalar,nvars>&
+	 */
+	template <typename Function>
+	void withSurfaceGradients(const scalar *const u, Function&& f) const;
+
+	/// Whether the passive scalars are imposed at a boundary face, rather than extrapolated
+	bool isPassiveScalarImposed(const a_int iface) const;
+
+	/// Whether the ghost passive scalars at a boundary face are the negatives of the interior
+	///  ones, so that they vanish at the face
+	/** This is the case for the SA working variable at no-slip walls.
+	 */
+	bool isPassiveScalarReflected(const a_int iface) const;
 };
 
 /// Computes the integrated fluxes and their Jacobians for compressible flow
@@ -181,13 +361,23 @@ protected:
  * objects, except the one for numerical inviscid flux \ref jflux, are meant to be logically
  * equivalent to the corresponding objects for the fluxes in the base flow class with only a change in
  * the scalar type.
+ *
+ * With the Spalart-Allmaras model, the viscous fluxes of the flow use the sum of the molecular and
+ * eddy viscosities, and the eddy thermal conductivity. The working variable is convected like a
+ * passive scalar; its diffusive flux uses the same face gradients as the flow, and its source term
+ * uses the vorticity and the gradient of the working variable from a Green-Gauss reconstruction
+ * of the cell-centred values, so that it is available for first-order schemes as well. The
+ * Jacobian is fully coupled (block size 5); the eddy viscosity is frozen in the viscous flux
+ * Jacobians of the flow, the diffusion of the working variable is approximated by its thin-layer
+ * form, and only the destruction term of the source is differentiated, to strengthen the diagonal.
  */
 template <
 	typename scalar,
 	bool secondOrderRequested,      ///< Whether to compute gradients to get a 2nd order solution
-	bool constVisc                  ///< Whether to use constant viscosity (true) or Sutherland (false)
+	bool constVisc,                 ///< Whether to use constant viscosity (true) or Sutherland (false)
+	int nvars = NVARS               ///< Number of conserved variables, including passive scalars
 >
-class FlowFV : public FlowFV_base<scalar>
+class FlowFV : public FlowFV_base<scalar,nvars>
 {
 public:
 	/// Sets data and initializes the numerics
@@ -205,27 +395,71 @@ public:
 	 * and also computes local time steps.
 	 */
 	StatusCode compute_residual(const scalar *const u, scalar *const residual,
-	                            const bool gettimesteps, std::vector<a_real>& dtm) const;
+	                            const bool gettimesteps, std::vector<a_real>& dtm,
+	                            ActiveSetResidual<scalar,nvars> *const activeset = nullptr) const;
+
+	/// Computes the residuals of several interleaved states together
+	/** \sa FlowFV_base::compute_residual_batch
+	 */
+	StatusCode compute_residual_batch(const int nstates, const scalar *const u,
+	                                  scalar *const residual) const;
+
+	/// Computes the residual of some cells, visiting only their neighbourhood
+	/** Viscous flows use the full residual evaluation of \ref Spatial::compute_local_residual.
+	 */
+	StatusCode compute_local_residual(const LocalStencil& st, const scalar *const u,
+	                                  const scalar *const urows, scalar *const rrows) const;
+
+	/// The limited reconstruction at the faces of the rows needs the gradients of the rows' face
+	///  neighbours and their neighbours, and so the states of one more layer
+	int localStencilLayers() const { return secondOrderRequested ? 3 : 1; }
 
 	/// Computes the residual Jacobian as a PETSc martrix
 	/** Computes the Jacobian of r(u), where the 
 	 */
 	virtual StatusCode compute_jacobian(const Vec u, Mat A) const;
+
+	/// Updates the Jacobian, recomputing only faces next to changed cells if requested
+	/** If the option `-jacobian_active_set_threshold' is given, the contributions of faces adjacent
+	 * to cells that have changed (see \ref ActiveSet) are replaced by adding the difference between
+	 * the new and the cached contributions. Otherwise, or at periodic refreshes, the matrix is
+	 * zeroed and recomputed.
+	 */
+	virtual StatusCode update_jacobian(const Vec u, Mat A, JacobianUpdateInfo& info) const;
+
+	/// Forgets the cached face blocks, so that the next \ref update_jacobian is full
+	void reset_jacobian_updates() const {
+		if(jaccache)
+			jaccache->reset();
+	}
 	
 protected:
-	using Spatial<scalar,NVARS>::m;
-	using Spatial<scalar,NVARS>::rc;
-	using Spatial<scalar,NVARS>::gr;
-	using Spatial<scalar,NVARS>::getFaceGradient_modifiedAverage;
-	using Spatial<scalar,NVARS>::getFaceGradientAndJacobian_thinLayer;
-	using FlowFV_base<scalar>::pconfig;
-	using FlowFV_base<scalar>::nconfig;
-	using FlowFV_base<scalar>::physics;
-	using FlowFV_base<scalar>::inviflux;
-	using FlowFV_base<scalar>::gradcomp;
-	using FlowFV_base<scalar>::lim;
-	using FlowFV_base<scalar>::bcs;
-	using FlowFV_base<scalar>::compute_boundary_states;
+	using Spatial<scalar,nvars>::m;
+	using Spatial<scalar,nvars>::rc;
+	using Spatial<scalar,nvars>::gr;
+	using Spatial<scalar,nvars>::getFaceGradient_modifiedAverage;
+	using Spatial<scalar,nvars>::getFaceGradientAndJacobian_thinLayer;
+	using FlowFV_base<scalar,nvars>::pconfig;
+	using FlowFV_base<scalar,nvars>::nconfig;
+	using FlowFV_base<scalar,nvars>::physics;
+	using FlowFV_base<scalar,nvars>::faceloops;
+	using FlowFV_base<scalar,nvars>::lowmach;
+	using FlowFV_base<scalar,nvars>::inviflux;
+	using FlowFV_base<scalar,nvars>::jflux;
+	using FlowFV_base<scalar,nvars>::gradcomp;
+	using FlowFV_base<scalar,nvars>::lim;
+	using FlowFV_base<scalar,nvars>::bcs;
+	using FlowFV_base<scalar,nvars>::compute_boundary_states;
+	using FlowFV_base<scalar,nvars>::compute_boundary_state;
+	using FlowFV_base<scalar,nvars>::jaccache;
+	using FlowFV_base<scalar,nvars>::scalarinf;
+	using FlowFV_base<scalar,nvars>::isPassiveScalarImposed;
+	using FlowFV_base<scalar,nvars>::isPassiveScalarReflected;
+	using FlowFV_base<scalar,nvars>::walldist;
+	using FlowFV_base<scalar,nvars>::lastgrads;
+	using FlowFV_base<scalar,nvars>::lastgradstate;
+	using FlowFV_base<scalar,nvars>::lastgradsexact;
+	using FlowFV_base<scalar,nvars>::lastgradsmutex;
 
 	/// Gas physics to use for computing analytical Jacobian
 	/** This should usually be same as \ref physics used for the flux computation. This has been
@@ -234,6 +468,69 @@ protected:
 	 */
 	const IdealGasPhysics<a_real> jphy;
 
+	/// Closure of the Spalart-Allmaras model; only used for turbulent flow
+	const SpalartAllmaras<scalar> sa;
+
+	/// Gradient and reconstruction contexts for batches of interleaved states
+	/** They act on nbvars variables per cell, the variables of all states of a batch.
+	 */
+	template <int nbvars>
+	struct BatchNumerics
+	{
+		const GradientScheme<scalar,nbvars> *gradcomp = nullptr;
+		const SolutionReconstruction<scalar,nbvars> *lim = nullptr;
+		std::once_flag created;
+	};
+
+	/// Contexts for batches of 4, 8 and 16 states, created on first use by second-order schemes
+	mutable BatchNumerics<4*nvars> batch4;
+	mutable BatchNumerics<8*nvars> batch8;
+	mutable BatchNumerics<16*nvars> batch16;
+
+	BatchNumerics<4*nvars>& batchNumerics(std::integral_constant<int,4>) const { return batch4; }
+	BatchNumerics<8*nvars>& batchNumerics(std::integral_constant<int,8>) const { return batch8; }
+	BatchNumerics<16*nvars>& batchNumerics(std::integral_constant<int,16>) const { return batch16; }
+
+	/// Returns the gradient and reconstruction contexts for batches of K states, creating them
+	///  the first time
+	template <int K>
+	const BatchNumerics<K*nvars>& getBatchNumerics() const;
+
+	/// Computes the residuals of a batch of K interleaved states of an inviscid flow
+	template <int K>
+	StatusCode compute_residual_multi(const scalar *const u, scalar *const __restrict residual)
+		const;
+
+	/// Computes the source term of the SA working variable in each cell, integrated over the cell
+	/** The vorticity and the gradient of the working variable are computed by the Green-Gauss
+	 * theorem from the cell-centred values, with the ghost states from the boundary conditions.
+	 * \param[in] uarr Cell-centred conserved variables of all cells
+	 * \param[out] src Integrated source term of each cell
+	 * \param[out] dsrc Approximate derivative of the integrated source term of each cell w.r.t.
+	 *   its conserved working variable, see SpalartAllmaras::source
+	 */
+	void compute_turbulence_source(const scalar *const uarr, std::vector<scalar>& src,
+	                               std::vector<scalar>& dsrc) const;
+
+	/// Computes the Jacobian of a boundary face's flux w.r.t. its interior cell's state
+	/** \param[in] iface Boundary face index
+	 * \param[in] uarr Cell-centred conserved variables of all cells
+	 * \param[out] left The contribution of the face to the diagonal block of its cell, row-major
+	 */
+	void compute_boundary_face_jacobian(const a_int iface, const a_real *const uarr,
+	                                    a_real *const left) const;
+
+	/// Computes the flux Jacobian blocks of an interior face, integrated over the face
+	/** \param[in] iface Interior face index
+	 * \param[in] uarr Cell-centred conserved variables of all cells
+	 * \param[out] L The block in the row of the right cell and column of the left cell, row-major
+	 * \param[out] U The block in the row of the left cell and column of the right cell, row-major
+	 *
+	 * The negatives of L and U contribute to the diagonal blocks of the left and right cells.
+	 */
+	void compute_interior_face_jacobian(const a_int iface, const a_real *const uarr,
+	                                    a_real *const L, a_real *const U) const;
+
 	/// Computes viscous flux across a face at one point
 	/** The output vflux still needs to be integrated on the face.
 	 * \param[in] iface Face index
@@ -244,7 +541,9 @@ protected:
 	 * \param[in] grads Cell-centred gradients ("optional", see below)
 	 * \param[in] ul Left state of faces (conserved variables)
 	 * \param[in] ur Right state of faces (conserved variables)
-	 * \param[in,out] vflux On output, contains the viscous flux across the face
+	 * \param[in] mulam Laminar viscosity coefficient at the face
+	 * \param[in,out] vflux On output, contains the viscous flux of all nvars variables across the
+	 *   face; zero for passive scalars, except the diffusive flux of the SA working variable
 	 *
 	 * Note that grads can be unallocated if only first-order fluxes are being computed,
 	 * but ul and ur are always used.
@@ -252,9 +551,9 @@ protected:
 	void compute_viscous_flux(const a_int iface,
 	                          const scalar *const ucell_l, const scalar *const ucell_r,
 	                          const amat::Array2d<scalar>& ug,
-	                          const GradArray<scalar,NVARS>& grads,
+	                          const GradArray<scalar,nvars>& grads,
 	                          const amat::Array2d<scalar>& ul, const amat::Array2d<scalar>& ur,
-	                          scalar *const vflux) const;
+	                          const scalar mulam, scalar *const vflux) const;
 
 	/// Compues the first-order "thin-layer" viscous flux Jacobian
 	/** This is the same sign as is needed in the residual; note that the viscous flux Jacobian is
@@ -273,6 +572,16 @@ protected:
 	                                   a_real *const __restrict vfluxi,
 	                                   a_real *const __restrict vfluxj) const;
 
+	/// Molecular viscosity at a face from the cell-centred conserved states on either side
+	a_real faceViscosity(const a_real *const ul, const a_real *const ur) const;
+
+	/// Distance between the cell centres (or ghost cell centre) on either side of a face, divided
+	///  by the cosine of the angle between the line joining them and the face normal
+	/** The normal component of the first-order face gradient of \ref getFaceGradient_modifiedAverage
+	 * is the jump across the face divided by this distance.
+	 */
+	a_real projectedCentreDistance(const a_int iface) const;
+
 	/// Computes the spectral radius of the thin-layer Jacobian times the identity matrix
 	/** The inputs are same as \ref compute_viscous_flux_jacobian
 	 */
@@ -97,6 +97,52 @@ void WENOReconstruction<scalar,nvars>::compute_face_values(const MVector<scalar>
 	}
 }
 
+template <typename scalar, int nvars>
+void WENOReconstruction<scalar,nvars>::compute_cell_face_values(const a_int iel,
+		const scalar *const ucell, const scalar *const *const unbrs,
+		const Eigen::Array<scalar,NDIM,nvars>& grad,
+		const Eigen::Array<scalar,NDIM,nvars> *const *const nbrgrads,
+		scalar *const *const ufaces) const
+{
+	for(int ivar = 0; ivar < nvars; ivar++)
+	{
+		scalar wsum = 0;
+		scalar lgrad[NDIM];
+		zeros(lgrad, NDIM);
+
+		// Central stencil
+		const scalar denom = pow( gradientMagnitude2(grad,ivar) + epsilon , gamma );
+		const scalar w = lambda / denom;
+		wsum += w;
+		for(int j = 0; j < NDIM; j++)
+			lgrad[j] += w*grad(j,ivar);
+
+		// Biased stencils, ignoring ghost cells
+		for(int jel = 0; jel < m->gnfael(iel); jel++)
+		{
+			if(!nbrgrads[jel])
+				continue;
+
+			const scalar denom = pow( gradientMagnitude2(*nbrgrads[jel],ivar) + epsilon , gamma );
+			const scalar w = 1.0 / denom;
+			wsum += w;
+			for(int j = 0; j < NDIM; j++)
+				lgrad[j] += w*(*nbrgrads[jel])(j,ivar);
+		}
+
+		for(int j = 0; j < NDIM; j++)
+			lgrad[j] /= wsum;
+
+		for(int jface = 0; jface < m->gnfael(iel); jface++)
+		{
+			const a_int face = m->gelemface(iel,jface);
+			ufaces[jface][ivar] = ucell[ivar];
+			for(int j = 0; j < NDIM; j++)
+				ufaces[jface][ivar] += lgrad[j]*(gr[face](0,j) - ri(iel,j));
+		}
+	}
+}
+
 template <typename scalar, int nvars>
 BarthJespersenLimiter<scalar,nvars>::BarthJespersenLimiter(const UMesh2dh<scalar> *const mesh, 
                                                      const amat::Array2d<scalar>& r_centres,
@@ -121,7 +167,9 @@ void BarthJespersenLimiter<scalar,nvars>::compute_face_values(const MVector<scal
 			for(int j = 0; j < m->gnfael(iel); j++)
 			{
 				const a_int jel = m->gesuel(iel,j);
-				const scalar dui = u(jel,ivar)-u(iel,ivar);
+				// ghost cells' states are stored by boundary face
+				const scalar uj = jel < m->gnelem() ? u(jel,ivar) : ug(m->gelemface(iel,j),ivar);
+				const scalar dui = uj-u(iel,ivar);
 				if(dui > duimax) duimax = dui;
 				if(dui < duimin) duimin = dui;
 			}
@@ -164,6 +212,52 @@ void BarthJespersenLimiter<scalar,nvars>::compute_face_values(const MVector<scal
 	}
 }
 
+template <typename scalar, int nvars>
+void BarthJespersenLimiter<scalar,nvars>::compute_cell_face_values(const a_int iel,
+		const scalar *const ucell, const scalar *const *const unbrs,
+		const Eigen::Array<scalar,NDIM,nvars>& grad,
+		const Eigen::Array<scalar,NDIM,nvars> *const *const nbrgrads,
+		scalar *const *const ufaces) const
+{
+	for(int ivar = 0; ivar < nvars; ivar++)
+	{
+		scalar duimin=0, duimax=0;
+		for(int j = 0; j < m->gnfael(iel); j++)
+		{
+			const scalar dui = unbrs[j][ivar]-ucell[ivar];
+			if(dui > duimax) duimax = dui;
+			if(dui < duimin) duimin = dui;
+		}
+
+		scalar lim = 1.0;
+		for(int j = 0; j < m->gnfael(iel); j++)
+		{
+			const a_int face = m->gelemface(iel,j);
+			const scalar uface = linearExtrapolate(ucell[ivar], grad, ivar, 1.0,
+					&gr[face](0,0), &ri(iel,0));
+
+			scalar phiik;
+			const scalar diff = uface - ucell[ivar];
+			if(diff>0)
+				phiik = 1 < duimax/diff ? 1 : duimax/diff;
+			else if(diff < 0)
+				phiik = 1 < duimin/diff ? 1 : duimin/diff;
+			else
+				phiik = 1;
+
+			if(phiik < lim)
+				lim = phiik;
+		}
+
+		for(int j = 0; j < m->gnfael(iel); j++)
+		{
+			const a_int face = m->gelemface(iel,j);
+			ufaces[j][ivar] = linearExtrapolate(ucell[ivar], grad, ivar, lim,
+					&gr[face](0,0), &ri(iel,0));
+		}
+	}
+}
+
 template <typename scalar, int nvars>
 VenkatakrishnanLimiter<scalar,nvars>
 ::VenkatakrishnanLimiter(const UMesh2dh<scalar> *const mesh,
@@ -211,7 +305,9 @@ void VenkatakrishnanLimiter<scalar,nvars>
 			for(int j = 0; j < m->gnfael(iel); j++)
 			{
 				const a_int jel = m->gesuel(iel,j);
-				const scalar dui = u(jel,ivar)-u(iel,ivar);
+				// ghost cells' states are stored by boundary face
+				const scalar uj = jel < m->gnelem() ? u(jel,ivar) : ug(m->gelemface(iel,j),ivar);
+				const scalar dui = uj-u(iel,ivar);
 				if(dui > duimax) duimax = dui;
 				if(dui < duimin) duimin = dui;
 			}
@@ -251,11 +347,78 @@ void VenkatakrishnanLimiter<scalar,nvars>
 	}
 }
 
+template <typename scalar, int nvars>
+void VenkatakrishnanLimiter<scalar,nvars>::compute_cell_face_values(const a_int iel,
+		const scalar *const ucell, const scalar *const *const unbrs,
+		const Eigen::Array<scalar,NDIM,nvars>& grad,
+		const Eigen::Array<scalar,NDIM,nvars> *const *const nbrgrads,
+		scalar *const *const ufaces) const
+{
+	const scalar eps2 = std::pow(K*clength[iel], 3);
+
+	for(int ivar = 0; ivar < nvars; ivar++)
+	{
+		scalar duimin=0, duimax=0;
+		for(int j = 0; j < m->gnfael(iel); j++)
+		{
+			const scalar dui = unbrs[j][ivar]-ucell[ivar];
+			if(dui > duimax) duimax = dui;
+			if(dui < duimin) duimin = dui;
+		}
+
+		scalar lim = 1.0;
+		for(int j = 0; j < m->gnfael(iel); j++)
+		{
+			const a_int face = m->gelemface(iel,j);
+			const scalar uface = linearExtrapolate(ucell[ivar], grad, ivar, 1.0,
+					&gr[face](0,0), &ri(iel,0));
+			const scalar dm = uface - ucell[ivar];
+
+			// Venkatakrishnan modification
+			const scalar dp = dm < 0 ? duimin : duimax;
+			const scalar phiik = (dp*dp + 2*dp*dm + eps2)/(dp*dp + dp*dm + 2*dm*dm + eps2);
+
+			if(phiik < lim)
+				lim = phiik;
+		}
+
+		for(int j = 0; j < m->gnfael(iel); j++)
+		{
+			const a_int face = m->gelemface(iel,j);
+			ufaces[j][ivar] = linearExtrapolate(ucell[ivar], grad, ivar, lim,
+					&gr[face](0,0), &ri(iel,0));
+		}
+	}
+}
+
 template class WENOReconstruction<a_real,NVARS>;
 template class BarthJespersenLimiter<a_real,NVARS>;
 template class VenkatakrishnanLimiter<a_real,NVARS>;
 template class WENOReconstruction<a_real,1>;
 template class BarthJespersenLimiter<a_real,1>;
 template class VenkatakrishnanLimiter<a_real,1>;
+template class WENOReconstruction<a_real,NVARS+1>;
+template class BarthJespersenLimiter<a_real,NVARS+1>;
+template class VenkatakrishnanLimiter<a_real,NVARS+1>;
+
+// for residuals of batches of 4, 8 and 16 interleaved states
+template class WENOReconstruction<a_real,4*NVARS>;
+template class BarthJespersenLimiter<a_real,4*NVARS>;
+template class VenkatakrishnanLimiter<a_real,4*NVARS>;
+template class WENOReconstruction<a_real,8*NVARS>;
+template class BarthJespersenLimiter<a_real,8*NVARS>;
+template class VenkatakrishnanLimiter<a_real,8*NVARS>;
+template class WENOReconstruction<a_real,16*NVARS>;
+template class BarthJespersenLimiter<a_real,16*NVARS>;
+template class VenkatakrishnanLimiter<a_real,16*NVARS>;
+template class WENOReconstruction<a_real,4*(NVARS+1)>;
+template class BarthJespersenLimiter<a_real,4*(NVARS+1)>;
+template class VenkatakrishnanLimiter<a_real,4*(NVARS+1)>;
+template class WENOReconstruction<a_real,8*(NVARS+1)>;
+template class BarthJespersenLimiter<a_real,8*(NVARS+1)>;
+template class VenkatakrishnanLimiter<a_real,8*(NVARS+1)>;
+template class WENOReconstruction<a_real,16*(NVARS+1)>;
+template class BarthJespersenLimiter<a_real,16*(NVARS+1)>;
+template class VenkatakrishnanLimiter<a_real,16*(NVARS+1)>;
 
 }
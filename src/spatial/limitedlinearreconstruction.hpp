@@ -34,6 +34,12 @@ public:
 	                         const GradArray<scalar,nvars>& grads,
 	                         amat::Array2d<scalar>& uface_left,
 	                         amat::Array2d<scalar>& uface_right) const;
+
+	void compute_cell_face_values(const a_int iel, const scalar *const ucell,
+	                              const scalar *const *const unbrs,
+	                              const Eigen::Array<scalar,NDIM,nvars>& grad,
+	                              const Eigen::Array<scalar,NDIM,nvars> *const *const nbrgrads,
+	                              scalar *const *const ufaces) const;
 protected:
 	using SolutionReconstruction<scalar,nvars>::m;
 	using SolutionReconstruction<scalar,nvars>::ri;
@@ -55,6 +61,12 @@ public:
 	                         const GradArray<scalar,nvars>& grads,
 	                         amat::Array2d<scalar>& uface_left,
 	                         amat::Array2d<scalar>& uface_right) const;
+
+	void compute_cell_face_values(const a_int iel, const scalar *const ucell,
+	                              const scalar *const *const unbrs,
+	                              const Eigen::Array<scalar,NDIM,nvars>& grad,
+	                              const Eigen::Array<scalar,NDIM,nvars> *const *const nbrgrads,
+	                              scalar *const *const ufaces) const;
 protected:
 	using SolutionReconstruction<scalar,nvars>::m;
 	using SolutionReconstruction<scalar,nvars>::ri;
@@ -85,6 +97,12 @@ public:
 	                         const GradArray<scalar,nvars>& grads,
 	                         amat::Array2d<scalar>& uface_left,
 	                         amat::Array2d<scalar>& uface_right) const;
+
+	void compute_cell_face_values(const a_int iel, const scalar *const ucell,
+	                              const scalar *const *const unbrs,
+	                              const Eigen::Array<scalar,NDIM,nvars>& grad,
+	                              const Eigen::Array<scalar,NDIM,nvars> *const *const nbrgrads,
+	                              scalar *const *const ufaces) const;
 protected:
 	using SolutionReconstruction<scalar,nvars>::m;
 	using SolutionReconstruction<scalar,nvars>::ri;
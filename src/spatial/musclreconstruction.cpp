@@ -126,7 +126,53 @@ void MUSCLVanAlbada<scalar,nvars>::compute_face_values(const MVector<scalar>& u,
 	}
 }
 
+template <typename scalar, int nvars>
+void MUSCLVanAlbada<scalar,nvars>::compute_cell_face_values(const a_int iel,
+		const scalar *const ucell, const scalar *const *const unbrs,
+		const Eigen::Array<scalar,NDIM,nvars>& grad,
+		const Eigen::Array<scalar,NDIM,nvars> *const *const nbrgrads,
+		scalar *const *const ufaces) const
+{
+	for(int jface = 0; jface < m->gnfael(iel); jface++)
+	{
+		const a_int ied = m->gelemface(iel,jface);
+		const a_int ielem = m->gintfac(ied,0);
+		const a_int jelem = m->gintfac(ied,1);
+		const bool isleft = ielem == iel;
+		// left and right cell-centred states
+		const scalar *const ul = isleft ? ucell : unbrs[jface];
+		const scalar *const ur = isleft ? unbrs[jface] : ucell;
+
+		for(int i = 0; i < nvars; i++)
+		{
+			scalar gradc[NDIM];
+			for(int j = 0; j < NDIM; j++)
+				gradc[j] = grad(j,i);
+
+			// backward-biased difference on the left, forward-biased on the right
+			const scalar delta = computeBiasedDifference(&ri(ielem,0), &ri(jelem,0),
+					ul[i], ur[i], gradc);
+
+			scalar phi = (2.0*delta * (ur[i] - ul[i]) + eps)
+				/ (delta*delta + (ur[i] - ul[i])*(ur[i] - ul[i]) + eps);
+			if( phi < 0.0) phi = 0.0;
+
+			ufaces[jface][i] = isleft ? musclReconstructLeft(ul[i], ur[i], delta, phi)
+				: musclReconstructRight(ul[i], ur[i], delta, phi);
+		}
+	}
+}
+
 template class MUSCLVanAlbada<a_real,NVARS>;
 template class MUSCLVanAlbada<a_real,1>;
+template class MUSCLVanAlbada<a_real,NVARS+1>;
+
+// for residuals of batches of 4, 8 and 16 interleaved states
+template class MUSCLVanAlbada<a_real,4*NVARS>;
+template class MUSCLVanAlbada<a_real,8*NVARS>;
+template class MUSCLVanAlbada<a_real,16*NVARS>;
+template class MUSCLVanAlbada<a_real,4*(NVARS+1)>;
+template class MUSCLVanAlbada<a_real,8*(NVARS+1)>;
+template class MUSCLVanAlbada<a_real,16*(NVARS+1)>;
 
 }
@@ -0,0 +1,191 @@
+/** @file surfaceintegrals.cpp
+ * @brief Implementation of surface integrals of pressure and skin friction
+ * @author Aditya Kashi
+ */
+
+#include <array>
+#include <algorithm>
+#include "surfaceintegrals.hpp"
+#include "utilities/aoptionparser.hpp"
+
+namespace fvens {
+
+template <typename scalar, int nvars>
+SurfaceIntegrator<scalar,nvars>::SurfaceIntegrator(const UMesh2dh<scalar> *const mesh,
+                                                   const amat::Array2d<scalar>& cellcentres,
+                                                   const IdealGasPhysics<scalar>& phy,
+                                                   const scalar aoa)
+	: m{mesh}, rc(cellcentres), physics(phy), flowdir{cos(aoa), sin(aoa)},
+	  facevalues{!parsePetscCmd_isDefined("-surface_cell_values")}
+{
+	for(a_int iface = 0; iface < m->gnbface(); iface++)
+	{
+		const int marker = m->gintfacbtags(iface,0);
+		markerfaces[marker].push_back(iface);
+		markerlengths[marker] += m->gfacemetric(iface,2);
+	}
+}
+
+template <typename scalar, int nvars>
+const std::vector<a_int>& SurfaceIntegrator<scalar,nvars>::faces(const int marker) const
+{
+	static const std::vector<a_int> nofaces;
+	const auto it = markerfaces.find(marker);
+	return it == markerfaces.end() ? nofaces : it->second;
+}
+
+template <typename scalar, int nvars>
+scalar SurfaceIntegrator<scalar,nvars>::surfaceLength(const int marker) const
+{
+	const auto it = markerlengths.find(marker);
+	return it == markerlengths.end() ? scalar(0) : it->second;
+}
+
+template <typename scalar, int nvars>
+std::tuple<scalar,scalar,scalar>
+SurfaceIntegrator<scalar,nvars>::integrate(const int marker, const scalar *const u,
+                                           const GradArray<scalar,nvars>& grad,
+                                           const bool primitive,
+                                           MVector<scalar> *const output) const
+{
+	const std::vector<a_int>& flist = faces(marker);
+	const a_int nfaces = static_cast<a_int>(flist.size());
+	if(nfaces == 0)
+		return std::make_tuple(scalar(0), scalar(0), scalar(0));
+
+	const bool hasgrad = !grad.empty();
+	const scalar pinf = physics.getFreestreamPressure();
+
+	// unit vector normal to the free-stream flow direction
+	const scalar flownormal[NDIM] = {-flowdir[1], flowdir[0]};
+
+	// Cl, Cdp and Cdf of each block of faces
+	const a_int nblocks = (nfaces + block-1)/block;
+	std::vector<std::array<scalar,3>> blocksums(nblocks);
+
+#pragma omp parallel for default(shared) if(nblocks > 1)
+	for(a_int ib = 0; ib < nblocks; ib++)
+	{
+		std::array<scalar,3> sums {0, 0, 0};
+
+		for(a_int jf = ib*block; jf < std::min(nfaces, (ib+1)*block); jf++)
+		{
+			const a_int iface = flist[jf];
+			const a_int lelem = m->gintfac(iface,0);
+			const scalar *const uc = &u[lelem*nvars];
+
+			scalar n[NDIM];
+			for(int j = 0; j < NDIM; j++)
+				n[j] = m->gfacemetric(iface,j);
+			const scalar len = m->gfacemetric(iface,2);
+
+			// coords of face center
+			scalar coord[NDIM];
+			for(int j = 0; j < NDIM; j++)
+			{
+				coord[j] = 0;
+				for(int inofa = 0; inofa < m->gnnofa(); inofa++)
+					coord[j] += m->gcoords(m->gintfac(iface,2+inofa),j);
+				coord[j] /= m->gnnofa();
+			}
+
+			// velocity gradient tensor, gradu[i][j] = d v_i / d x_j
+			scalar gradu[NDIM][NDIM];
+			if(hasgrad)
+			{
+				const auto& gr = grad[lelem];
+				for(int j = 0; j < NDIM; j++)
+					for(int i = 0; i < NDIM; i++)
+						gradu[i][j] = primitive ? gr(j,i+1)
+							: (gr(j,i+1)*uc[0]-uc[i+1]*gr(j,0)) / (uc[0]*uc[0]);
+			}
+
+			/* State at the face centre, from which the pressure and the viscosity are computed.
+			 * It is extrapolated from the cell centre with the cell's gradient, unless that gives
+			 * a non-physical state; then the cell-centred state is used.
+			 */
+			scalar uf[NVARS];
+			const scalar *us = uc;
+			if(facevalues && hasgrad)
+			{
+				const auto& gr = grad[lelem];
+				scalar ul[NVARS];
+				if(primitive)
+					physics.getPrimitiveFromConserved(uc, ul);
+				else
+					for(int k = 0; k < NVARS; k++)
+						ul[k] = uc[k];
+
+				for(int k = 0; k < NVARS; k++)
+					for(int j = 0; j < NDIM; j++)
+						ul[k] += gr(j,k)*(coord[j]-rc(lelem,j));
+
+				if(primitive)
+					physics.getConservedFromPrimitive(ul, uf);
+				else
+					for(int k = 0; k < NVARS; k++)
+						uf[k] = ul[k];
+
+				if(uf[0] > 0 && physics.getPressureFromConserved(uf) > 0)
+					us = uf;
+			}
+
+			/* Pressure coefficient:
+			 * C_p = (p-p_inf)/(1/2 rho_inf v_inf^2) = 2(p* - p_inf*)
+			 * where *'s indicate non-dimensional values.
+			 */
+			const scalar p = physics.getPressureFromConserved(us);
+			const scalar cp = (p - pinf)*2.0;
+
+			/* Skin friction coefficient C_f = tau_w / (1/2 rho v_inf^2) = 2 tau_w, where the wall
+			 * shear stress is tau_w = mu (grad v + grad v^T) n . t, t = (n2,-n1) being the unit
+			 * tangent to the face.
+			 */
+			scalar cf = 0;
+			if(hasgrad) {
+				// non-dim viscosity / Re_inf
+				const scalar muhat = physics.getViscosityCoeffFromConserved(us);
+				const scalar tauw =
+					muhat*((2.0*gradu[0][0]*n[0] +(gradu[0][1]+gradu[1][0])*n[1])*n[1]
+					+ ((gradu[1][0]+gradu[0][1])*n[0] + 2.0*gradu[1][1]*n[1])*(-n[0]));
+				cf = 2.0*tauw;
+			}
+
+			if(output) {
+				for(int j = 0; j < NDIM; j++)
+					(*output)(jf,j) = coord[j];
+				(*output)(jf,NDIM) = cp;
+				(*output)(jf,NDIM+1) = cf;
+			}
+
+			// face normal dot free-stream direction
+			const scalar ndotf = n[0]*flowdir[0]+n[1]*flowdir[1];
+			// face normal dot "up" direction perpendicular to free stream
+			const scalar ndotnf = n[0]*flownormal[0]+n[1]*flownormal[1];
+			// face tangent dot free-stream direction
+			const scalar tdotf = n[1]*flowdir[0]-n[0]*flowdir[1];
+
+			sums[0] += cp*ndotnf*len;
+			sums[1] += cp*ndotf*len;
+			sums[2] += cf*tdotf*len;
+		}
+
+		blocksums[ib] = sums;
+	}
+
+	scalar Cl = 0, Cdp = 0, Cdf = 0;
+	for(a_int ib = 0; ib < nblocks; ib++) {
+		Cl += blocksums[ib][0];
+		Cdp += blocksums[ib][1];
+		Cdf += blocksums[ib][2];
+	}
+
+	// Normalize drag and lift by reference area
+	const scalar totallen = surfaceLength(marker);
+	return std::make_tuple(Cl/totallen, Cdp/totallen, Cdf/totallen);
+}
+
+template class SurfaceIntegrator<a_real,NVARS>;
+template class SurfaceIntegrator<a_real,NVARS+1>;
+
+}
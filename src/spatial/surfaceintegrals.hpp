@@ -0,0 +1,104 @@
+/** \file surfaceintegrals.hpp
+ * \brief Parallel integration of pressure and skin friction over boundary surfaces
+ * \author Aditya Kashi
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FVENS_SURFACEINTEGRALS_H
+#define FVENS_SURFACEINTEGRALS_H
+
+#include <map>
+#include <vector>
+#include <tuple>
+#include "mesh/amesh2dh.hpp"
+#include "physics/aphysics.hpp"
+
+namespace fvens {
+
+/// Computes pressure and skin friction coefficients on boundary surfaces and integrates them to
+/// lift and drag coefficients
+/** The boundary faces of each marker, and the total length of each surface, are found once at
+ * construction. The faces of a surface are processed in parallel, in blocks of a fixed size.
+ * The contributions of the faces of a block are summed in order, and then the sums of the blocks
+ * in order, so that the result does not depend on the number of threads.
+ *
+ * When gradients are available, the pressure and the viscosity are computed from the state
+ * extrapolated to the face centre with the gradient of the cell adjacent to the face; the velocity
+ * gradient is that of the cell. The cell-centred state is used instead if no gradients are given,
+ * or with the option `-surface_cell_values'.
+ *
+ * \todo Generalize to 3D
+ */
+template <typename scalar, int nvars>
+class SurfaceIntegrator
+{
+public:
+	/**
+	 * \param mesh The mesh, which must persist until this object is destroyed
+	 * \param cellcentres Coordinates of cell centres, needed for face values
+	 * \param physics Gas physics context
+	 * \param aoa Angle of attack in radians
+	 */
+	SurfaceIntegrator(const UMesh2dh<scalar> *const mesh,
+	                  const amat::Array2d<scalar>& cellcentres,
+	                  const IdealGasPhysics<scalar>& physics, const scalar aoa);
+
+	/// The boundary faces having a marker, in increasing order; empty if there are none
+	const std::vector<a_int>& faces(const int marker) const;
+
+	/// Total length of the boundary faces having a marker
+	scalar surfaceLength(const int marker) const;
+
+	/// Computes Cp and Cf at the faces of a surface, and the surface's lift and drag coefficients
+	/** The coefficients are normalized by the free-stream dynamic pressure and the length of the
+	 * surface.
+	 * \param[in] marker The boundary marker of the surface
+	 * \param[in] u Conserved variables at cell centres
+	 * \param[in] grad Cell-centred gradients; if empty, the skin friction is taken to be zero
+	 * \param[in] primitive True if grad contains gradients of the primitive variables (density,
+	 *   velocity, pressure), false if it contains gradients of the conserved variables
+	 * \param[out] output If not null, for each face of the surface in order, the coordinates of
+	 *   the face centre, Cp and Cf; it must have at least as many rows as the surface has faces
+	 * \return Cl, Cd_p and Cd_sf, in that order
+	 */
+	std::tuple<scalar,scalar,scalar> integrate(const int marker, const scalar *const u,
+	                                           const GradArray<scalar,nvars>& grad,
+	                                           const bool primitive,
+	                                           MVector<scalar> *const output) const;
+
+protected:
+	const UMesh2dh<scalar> *const m;
+	const amat::Array2d<scalar>& rc;
+	const IdealGasPhysics<scalar>& physics;
+
+	/// Unit vector in the direction of the free stream
+	const std::array<scalar,NDIM> flowdir;
+
+	/// Whether the pressure and viscosity are computed from states extrapolated to face centres
+	const bool facevalues;
+
+	/// Boundary faces of each marker
+	std::map<int,std::vector<a_int>> markerfaces;
+
+	/// Length of the surface of each marker
+	std::map<int,scalar> markerlengths;
+
+	/// Number of faces whose contributions are summed by one thread in order
+	static constexpr a_int block = 64;
+};
+
+}
+#endif
@@ -29,18 +29,32 @@ namespace fvens {
 template <typename scalar>
 InviscidFlux<scalar>* create_mutable_inviscidflux(
 		const std::string& type, 
-		const IdealGasPhysics<scalar> *const p) 
+		const IdealGasPhysics<scalar> *const p,
+		const LowMachPreconditioner *const lowmach)
 {
 	InviscidFlux<scalar> *inviflux = nullptr;
 
+	if(lowmach && type != "ROE" && type != "ROE_FROZEN" && type != "HLLC") {
+		std::cout << " InviscidFluxFactory: ! Low-Mach preconditioning is only available with the"
+		          << " Roe and HLLC fluxes!" << std::endl;
+		return inviflux;
+	}
+
 	if(type == "VANLEER") {
 		inviflux = new VanLeerFlux<scalar>(p);
 		std::cout << " InviscidFluxFactory: Using Van Leer fluxes." << std::endl;
 	}
 	else if(type == "ROE")
 	{
-		inviflux = new RoeFlux<scalar>(p);
-		std::cout << " InviscidFluxFactory: Using Roe fluxes." << std::endl;
+		inviflux = new RoeFlux<scalar>(p, lowmach);
+		std::cout << " InviscidFluxFactory: Using Roe fluxes";
+		std::cout << (lowmach ? " with low-Mach preconditioning." : ".") << std::endl;
+	}
+	else if(type == "ROE_FROZEN")
+	{
+		inviflux = new RoeFlux<scalar>(p, lowmach, true);
+		std::cout << " InviscidFluxFactory: Using Roe fluxes with frozen-coefficient Jacobians";
+		std::cout << (lowmach ? " and low-Mach preconditioning." : ".") << std::endl;
 	}
 	else if(type == "HLL")
 	{
@@ -49,10 +63,11 @@ InviscidFlux<scalar>* create_mutable_inviscidflux(
 	}
 	else if(type == "HLLC")
 	{
-		inviflux = new HLLCFlux<scalar>(p);
-		std::cout << " InviscidFluxFactory: Using HLLC fluxes." << std::endl;
+		inviflux = new HLLCFlux<scalar>(p, lowmach);
+		std::cout << " InviscidFluxFactory: Using HLLC fluxes";
+		std::cout << (lowmach ? " with low-Mach preconditioning." : ".") << std::endl;
 	}
-	else if(type == "LLF")
+	else if(type == "LLF" || type == "RUSANOV")
 	{
 		inviflux = new LocalLaxFriedrichsFlux<scalar>(p);
 		std::cout << " InviscidFluxFactory: Using LLF fluxes." << std::endl;
@@ -76,38 +91,41 @@ InviscidFlux<scalar>* create_mutable_inviscidflux(
 template <typename scalar>
 const InviscidFlux<scalar>* create_const_inviscidflux(
 		const std::string& type,
-		const IdealGasPhysics<scalar> *const p) 
+		const IdealGasPhysics<scalar> *const p,
+		const LowMachPreconditioner *const lowmach)
 {
-	return const_cast<const InviscidFlux<scalar>*>(create_mutable_inviscidflux(type, p));
+	return const_cast<const InviscidFlux<scalar>*>(create_mutable_inviscidflux(type, p, lowmach));
 }
 
 // instantiations
 template InviscidFlux<a_real>* create_mutable_inviscidflux(
 		const std::string& type, 
-		const IdealGasPhysics<a_real> *const p);
+		const IdealGasPhysics<a_real> *const p,
+		const LowMachPreconditioner *const lowmach);
 template const InviscidFlux<a_real>* create_const_inviscidflux(
 		const std::string& type, 
-		const IdealGasPhysics<a_real> *const p);
+		const IdealGasPhysics<a_real> *const p,
+		const LowMachPreconditioner *const lowmach);
 
 template <typename scalar, int nvars>
 GradientScheme<scalar,nvars>* create_mutable_gradientscheme(const std::string& type, 
-                                                            const UMesh2dh<scalar> *const m,
-                                                            const amat::Array2d<scalar>& rc)
+		const UMesh2dh<scalar> *const m, const amat::Array2d<scalar>& rc,
+		const FaceLoopSchedule<scalar> *const loops)
 {
 	GradientScheme<scalar,nvars> * gradcomp = nullptr;
 
 	if(type == "LEASTSQUARES")
 	{
-		gradcomp = new WeightedLeastSquaresGradients<scalar,nvars>(m, rc);
+		gradcomp = new WeightedLeastSquaresGradients<scalar,nvars>(m, rc, loops);
 		std::cout << " GradientSchemeFactory: Weighted least-squares gradients will be used.\n";
 	}
 	else if(type == "GREENGAUSS")
 	{
-		gradcomp = new GreenGaussGradients<scalar,nvars>(m, rc);
+		gradcomp = new GreenGaussGradients<scalar,nvars>(m, rc, loops);
 		std::cout << " GradientSchemeFactory: Green-Gauss gradients will be used.\n";
 	}
 	else {
-		gradcomp = new ZeroGradients<scalar,nvars>(m, rc);
+		gradcomp = new ZeroGradients<scalar,nvars>(m, rc, loops);
 		std::cout << " GradientSchemeFactory: No gradient computation.\n";
 	}
 
@@ -116,28 +134,37 @@ GradientScheme<scalar,nvars>* create_mutable_gradientscheme(const std::string& t
 
 template <typename scalar, int nvars>
 const GradientScheme<scalar,nvars>* create_const_gradientscheme(const std::string& type, 
-                                                                const UMesh2dh<scalar> *const m,
-                                                                const amat::Array2d<scalar>& rc)
+		const UMesh2dh<scalar> *const m, const amat::Array2d<scalar>& rc,
+		const FaceLoopSchedule<scalar> *const loops)
 {
-	return create_mutable_gradientscheme<scalar,nvars>(type, m, rc);
+	return create_mutable_gradientscheme<scalar,nvars>(type, m, rc, loops);
 }
 
 // template instantiations
 template GradientScheme<a_real,NVARS>* create_mutable_gradientscheme<a_real,NVARS>(
 		const std::string& type, 
-		const UMesh2dh<a_real> *const m, const amat::Array2d<a_real>& rc);
+		const UMesh2dh<a_real> *const m, const amat::Array2d<a_real>& rc,
+		const FaceLoopSchedule<a_real> *const loops);
 
 template const GradientScheme<a_real,NVARS>* create_const_gradientscheme<a_real,NVARS>(
 		const std::string& type, 
-		const UMesh2dh<a_real> *const m, const amat::Array2d<a_real>& rc);
+		const UMesh2dh<a_real> *const m, const amat::Array2d<a_real>& rc,
+		const FaceLoopSchedule<a_real> *const loops);
 
 template GradientScheme<a_real,1>* create_mutable_gradientscheme<a_real,1>(
 		const std::string& type, 
-		const UMesh2dh<a_real> *const m, const amat::Array2d<a_real>& rc);
+		const UMesh2dh<a_real> *const m, const amat::Array2d<a_real>& rc,
+		const FaceLoopSchedule<a_real> *const loops);
 
 template const GradientScheme<a_real,1>* create_const_gradientscheme<a_real,1>(
 		const std::string& type, 
-		const UMesh2dh<a_real> *const m, const amat::Array2d<a_real>& rc);
+		const UMesh2dh<a_real> *const m, const amat::Array2d<a_real>& rc,
+		const FaceLoopSchedule<a_real> *const loops);
+
+template const GradientScheme<a_real,NVARS+1>* create_const_gradientscheme<a_real,NVARS+1>(
+		const std::string& type, 
+		const UMesh2dh<a_real> *const m, const amat::Array2d<a_real>& rc,
+		const FaceLoopSchedule<a_real> *const loops);
 
 
 template <typename scalar, int nvars>
@@ -206,32 +233,93 @@ create_const_reconstruction(const std::string& type,
                             const UMesh2dh<a_real> *const m, const amat::Array2d<a_real>& rc,
                             const amat::Array2d<a_real> *const gr, const a_real param);
 
+template const SolutionReconstruction<a_real,NVARS+1>*
+create_const_reconstruction(const std::string& type,
+                            const UMesh2dh<a_real> *const m, const amat::Array2d<a_real>& rc,
+                            const amat::Array2d<a_real> *const gr, const a_real param);
+
+// for residuals of batches of 4, 8 and 16 interleaved states
 
-template <typename scalar>
-FlowFV_base<scalar>* create_mutable_flowSpatialDiscretization(
+template const GradientScheme<a_real,4*NVARS>* create_const_gradientscheme<a_real,4*NVARS>(
+		const std::string& type, 
+		const UMesh2dh<a_real> *const m, const amat::Array2d<a_real>& rc,
+		const FaceLoopSchedule<a_real> *const loops);
+template const SolutionReconstruction<a_real,4*NVARS>*
+create_const_reconstruction(const std::string& type,
+                            const UMesh2dh<a_real> *const m, const amat::Array2d<a_real>& rc,
+                            const amat::Array2d<a_real> *const gr, const a_real param);
+
+template const GradientScheme<a_real,8*NVARS>* create_const_gradientscheme<a_real,8*NVARS>(
+		const std::string& type, 
+		const UMesh2dh<a_real> *const m, const amat::Array2d<a_real>& rc,
+		const FaceLoopSchedule<a_real> *const loops);
+template const SolutionReconstruction<a_real,8*NVARS>*
+create_const_reconstruction(const std::string& type,
+                            const UMesh2dh<a_real> *const m, const amat::Array2d<a_real>& rc,
+                            const amat::Array2d<a_real> *const gr, const a_real param);
+
+template const GradientScheme<a_real,16*NVARS>* create_const_gradientscheme<a_real,16*NVARS>(
+		const std::string& type, 
+		const UMesh2dh<a_real> *const m, const amat::Array2d<a_real>& rc,
+		const FaceLoopSchedule<a_real> *const loops);
+template const SolutionReconstruction<a_real,16*NVARS>*
+create_const_reconstruction(const std::string& type,
+                            const UMesh2dh<a_real> *const m, const amat::Array2d<a_real>& rc,
+                            const amat::Array2d<a_real> *const gr, const a_real param);
+
+template const GradientScheme<a_real,4*(NVARS+1)>* create_const_gradientscheme<a_real,4*(NVARS+1)>(
+		const std::string& type, 
+		const UMesh2dh<a_real> *const m, const amat::Array2d<a_real>& rc,
+		const FaceLoopSchedule<a_real> *const loops);
+template const SolutionReconstruction<a_real,4*(NVARS+1)>*
+create_const_reconstruction(const std::string& type,
+                            const UMesh2dh<a_real> *const m, const amat::Array2d<a_real>& rc,
+                            const amat::Array2d<a_real> *const gr, const a_real param);
+
+template const GradientScheme<a_real,8*(NVARS+1)>* create_const_gradientscheme<a_real,8*(NVARS+1)>(
+		const std::string& type, 
+		const UMesh2dh<a_real> *const m, const amat::Array2d<a_real>& rc,
+		const FaceLoopSchedule<a_real> *const loops);
+template const SolutionReconstruction<a_real,8*(NVARS+1)>*
+create_const_reconstruction(const std::string& type,
+                            const UMesh2dh<a_real> *const m, const amat::Array2d<a_real>& rc,
+                            const amat::Array2d<a_real> *const gr, const a_real param);
+
+template const GradientScheme<a_real,16*(NVARS+1)>* create_const_gradientscheme<a_real,16*(NVARS+1)>(
+		const std::string& type, 
+		const UMesh2dh<a_real> *const m, const amat::Array2d<a_real>& rc,
+		const FaceLoopSchedule<a_real> *const loops);
+template const SolutionReconstruction<a_real,16*(NVARS+1)>*
+create_const_reconstruction(const std::string& type,
+                            const UMesh2dh<a_real> *const m, const amat::Array2d<a_real>& rc,
+                            const amat::Array2d<a_real> *const gr, const a_real param);
+
+
+template <typename scalar, int nvars>
+FlowFV_base<scalar,nvars>* create_mutable_flowSpatialDiscretization(
 	const UMesh2dh<scalar> *const m,
 	const FlowPhysicsConfig& pconf,
 	const FlowNumericsConfig& nconf)
 {
 	if(nconf.order2)
 		if(pconf.const_visc)
-			return new FlowFV<scalar,true,true>(m, pconf, nconf);
+			return new FlowFV<scalar,true,true,nvars>(m, pconf, nconf);
 		else
-			return new FlowFV<scalar,true,false>(m, pconf, nconf);
+			return new FlowFV<scalar,true,false,nvars>(m, pconf, nconf);
 	else
 		if(pconf.const_visc)
-			return new FlowFV<scalar,false,true>(m, pconf, nconf);
+			return new FlowFV<scalar,false,true,nvars>(m, pconf, nconf);
 		else
-			return new FlowFV<scalar,false,false>(m, pconf, nconf);
+			return new FlowFV<scalar,false,false,nvars>(m, pconf, nconf);
 }
 
-template <typename scalar>
-const FlowFV_base<scalar>* create_const_flowSpatialDiscretization(
+template <typename scalar, int nvars>
+const FlowFV_base<scalar,nvars>* create_const_flowSpatialDiscretization(
 	const UMesh2dh<scalar> *const m,
 	const FlowPhysicsConfig& pconf,
 	const FlowNumericsConfig& nconf)
 {
-	return create_mutable_flowSpatialDiscretization<scalar>(m, pconf, nconf);
+	return create_mutable_flowSpatialDiscretization<scalar,nvars>(m, pconf, nconf);
 }
 
 template
@@ -240,4 +328,15 @@ create_const_flowSpatialDiscretization<a_real>(const UMesh2dh<a_real> *const m,
                                                const FlowPhysicsConfig& pconf,
                                                const FlowNumericsConfig& nconf);
 
+template
+FlowFV_base<a_real,NVARS+1>*
+create_mutable_flowSpatialDiscretization<a_real,NVARS+1>(const UMesh2dh<a_real> *const m,
+                                                         const FlowPhysicsConfig& pconf,
+                                                         const FlowNumericsConfig& nconf);
+template
+const FlowFV_base<a_real,NVARS+1>*
+create_const_flowSpatialDiscretization<a_real,NVARS+1>(const UMesh2dh<a_real> *const m,
+                                                       const FlowPhysicsConfig& pconf,
+                                                       const FlowNumericsConfig& nconf);
+
 }
@@ -32,31 +32,42 @@
 namespace fvens {
 
 /// Returns a new inviscid numerical flux context
+/** \param type Type of numerical flux. Besides the names of the fluxes, `ROE_FROZEN' gives the Roe
+ *   flux with frozen-coefficient Jacobians (\ref RoeFlux), and `RUSANOV' is the same as `LLF',
+ *   whose Jacobian has a frozen spectral radius.
+ * \param p Gas physics
+ * \param lowmach Low-Mach preconditioning, if any; only the Roe and HLLC fluxes support it
+ */
 template <typename scalar>
 InviscidFlux<scalar>* create_mutable_inviscidflux(const std::string& type, 
-		const IdealGasPhysics<scalar> *const p) ;
+		const IdealGasPhysics<scalar> *const p,
+		const LowMachPreconditioner *const lowmach = nullptr);
 
 /// Returns a new immutable inviscid flux context
 template <typename scalar>
 const InviscidFlux<scalar>* create_const_inviscidflux(const std::string& type, 
-		const IdealGasPhysics<scalar> *const p) ;
+		const IdealGasPhysics<scalar> *const p,
+		const LowMachPreconditioner *const lowmach = nullptr);
 
 /// Returns a newly-created gradient computation context
 /** \param type Type of gradient scheme
  * \param m Mesh context. Currently its scalar type has to be same as that of the gradients etc
  * \param rc Array of cell centres all cells (including ghost cells); this must also currently have
  *   the same scalar type as the gradients.
+ * \param loops Schedule of threaded face loops to use; atomic updates are used if not given
  */
 template <typename scalar, int nvars>
 GradientScheme<scalar,nvars>* create_mutable_gradientscheme(const std::string& type, 
-		const UMesh2dh<scalar> *const m, const amat::Array2d<scalar>& rc) ;
+		const UMesh2dh<scalar> *const m, const amat::Array2d<scalar>& rc,
+		const FaceLoopSchedule<scalar> *const loops = nullptr) ;
 
 /// Returns a newly-created immutable gradient computation context
 /** Parameters are as explained for \ref create_mutable_gradientscheme
  */
 template <typename scalar, int nvars>
 const GradientScheme<scalar,nvars>* create_const_gradientscheme(const std::string& type, 
-		const UMesh2dh<scalar> *const m, const amat::Array2d<scalar>& rc) ;
+		const UMesh2dh<scalar> *const m, const amat::Array2d<scalar>& rc,
+		const FaceLoopSchedule<scalar> *const loops = nullptr) ;
 
 /// Returns a solution reconstruction context
 /** Solution reconstruction here means computing the values of the conserved variables at faces from
@@ -85,9 +96,11 @@ create_const_reconstruction(const std::string& type,
 
 /// Creates the appropriate flow solver class
 /** This function is needed to instantiate the appropriate class from the \ref FlowFV template.
+ * The number of conserved variables nvars can be larger than \ref NVARS to carry passive scalars;
+ * currently, NVARS and NVARS+1 are available.
  */
-template <typename scalar>
-FlowFV_base<scalar>* create_mutable_flowSpatialDiscretization(
+template <typename scalar, int nvars = NVARS>
+FlowFV_base<scalar,nvars>* create_mutable_flowSpatialDiscretization(
 	const UMesh2dh<scalar> *const m,               ///< Mesh context
 	const FlowPhysicsConfig& pconf,                ///< Physical data about the problem
 	const FlowNumericsConfig& nconf);              ///< Options controlling the numerical method
@@ -95,8 +108,8 @@ FlowFV_base<scalar>* create_mutable_flowSpatialDiscretization(
 /// Generates an immutable spatial discretization for slow problems
 /** \sa create_mutable_flowSpatialDiscretization
  */
-template <typename scalar>
-const FlowFV_base<scalar>* create_const_flowSpatialDiscretization(
+template <typename scalar, int nvars = NVARS>
+const FlowFV_base<scalar,nvars>* create_const_flowSpatialDiscretization(
 	const UMesh2dh<scalar> *const m,               ///< Mesh context
 	const FlowPhysicsConfig& pconf,                ///< Physical data about the problem
 	const FlowNumericsConfig& nconf);              ///< Options controlling the numerical method
@@ -155,4 +155,48 @@ std::vector<int> parseOptionalPetscCmd_intArray(const std::string optionname, co
 	return arr;
 }
 
+std::vector<PetscReal> parseOptionalPetscCmd_realArray(const std::string optionname, const int maxlen)
+{
+	StatusCode ierr = 0;
+	PetscBool set = PETSC_FALSE;
+	std::vector<PetscReal> arr(maxlen);
+	int len = maxlen;
+
+	ierr = PetscOptionsGetRealArray(NULL, NULL, optionname.c_str(), &arr[0], &len, &set);
+	arr.resize(len);
+
+	petsc_throw(ierr, std::string("Could not get array ") + std::string(optionname));
+	if(!set) {
+		std::cout << "Array " << optionname << " not set.\n";
+		arr.resize(0);
+	}
+	return arr;
+}
+
+std::vector<std::string> parseOptionalPetscCmd_stringArray(const std::string optionname,
+                                                           const int maxlen)
+{
+	StatusCode ierr = 0;
+	PetscBool set = PETSC_FALSE;
+	std::vector<char*> carr(maxlen, nullptr);
+	int len = maxlen;
+
+	ierr = PetscOptionsGetStringArray(NULL, NULL, optionname.c_str(), &carr[0], &len, &set);
+	petsc_throw(ierr, std::string("Could not get array ") + std::string(optionname));
+
+	std::vector<std::string> arr;
+	if(!set) {
+		std::cout << "Array " << optionname << " not set.\n";
+		return arr;
+	}
+
+	// PETSc allocates the individual strings; we copy and free them
+	for(int i = 0; i < len; i++) {
+		arr.push_back(std::string(carr[i]));
+		ierr = PetscFree(carr[i]);
+		petsc_throw(ierr, "Could not free PETSc string");
+	}
+	return arr;
+}
+
 }
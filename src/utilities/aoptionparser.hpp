@@ -67,6 +67,20 @@ std::vector<int> parsePetscCmd_intArray(const std::string optionname, const int
  */
 std::vector<int> parseOptionalPetscCmd_intArray(const std::string optionname, const int maxlen);
 
+/// Extracts the arguments of a real array option from the default PETSc options database
+/** Does not throw if the requested option was not found; just returns an empty vector in that case. 
+ * \param maxlen Maximum number of entries expected in the array
+ */
+std::vector<PetscReal> parseOptionalPetscCmd_realArray(const std::string optionname, const int maxlen);
+
+/// Extracts the arguments of a comma-separated string array option from the default PETSc
+/// options database
+/** Does not throw if the requested option was not found; just returns an empty vector in that case. 
+ * \param maxlen Maximum number of entries expected in the array
+ */
+std::vector<std::string> parseOptionalPetscCmd_stringArray(const std::string optionname,
+                                                           const int maxlen);
+
 }
 
 #endif
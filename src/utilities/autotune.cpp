@@ -0,0 +1,345 @@
+/** \file autotune.cpp
+ * \brief Automatic selection of pseudo-time and linear solver parameters by short trial solves
+ * \author Aditya Kashi
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <limits>
+#include <petscksp.h>
+
+#include "autotune.hpp"
+#include "utilities/aoptionparser.hpp"
+#include "utilities/afactory.hpp"
+#include "linalg/polynomialpc.hpp"
+#include "linalg/subdomainpc.hpp"
+
+#ifdef USE_BLASTED
+#include <blasted_petsc.h>
+#endif
+
+namespace fvens {
+
+/// Max number of values read for any one parameter of the search space
+static const int max_autotune_values = 20;
+
+/// Field width in the trials' report
+static const int field_width = 12;
+
+/// Whether the Krylov solver takes a restart length through `-ksp_gmres_restart'
+static inline bool isGMRESType(const std::string ksptype) {
+	return ksptype.find("gmres") != std::string::npos;
+}
+
+template <typename T>
+static std::string toString(const T val) {
+	std::ostringstream ss;
+	ss << val;
+	return ss.str();
+}
+
+/// Set an option in the default PETSc options database and throw if not successful
+static void setPetscOption(const std::string option, const std::string value)
+{
+	const StatusCode ierr = PetscOptionsSetValue(NULL, option.c_str(), value.c_str());
+	petsc_throw(ierr, "Could not set PETSc option " + option);
+}
+
+/// Remove an option from the default PETSc options database and throw if not successful
+static void clearPetscOption(const std::string option)
+{
+	const StatusCode ierr = PetscOptionsClearValue(NULL, option.c_str());
+	petsc_throw(ierr, "Could not clear PETSc option " + option);
+}
+
+/// State of an option in the default PETSc options database before a trial overwrote it
+struct SavedPetscOption
+{
+	std::string name;            ///< Name of the option, including the leading hyphen
+	bool isset;                  ///< Whether the option was present at all
+	std::string value;           ///< Its value, if it was present
+};
+
+/// Record the current state of an option and then set it to a new value
+static void setTrialOption(std::vector<SavedPetscOption>& saved,
+                           const std::string option, const std::string value)
+{
+	char val[PETSC_MAX_PATH_LEN];
+	PetscBool isset = PETSC_FALSE;
+	const StatusCode ierr = PetscOptionsGetString(NULL, NULL, option.c_str(), val,
+	                                              PETSC_MAX_PATH_LEN, &isset);
+	petsc_throw(ierr, "Could not get PETSc option " + option);
+
+	saved.push_back(SavedPetscOption{option, (bool)isset, isset ? std::string(val) : ""});
+	setPetscOption(option, value);
+}
+
+/// Put back the options recorded by ef setTrialOption, in reverse order of setting
+static void restoreTrialOptions(std::vector<SavedPetscOption>& saved)
+{
+	for(auto it = saved.rbegin(); it != saved.rend(); it++)
+	{
+		if(!it->isset)
+			clearPetscOption(it->name);
+		else {
+			const StatusCode ierr = PetscOptionsSetValue(NULL, it->name.c_str(),
+			                                        it->value == "" ? NULL : it->value.c_str());
+			petsc_throw(ierr, "Could not restore PETSc option " + it->name);
+		}
+	}
+	saved.clear();
+}
+
+AutotuneSearchSpace parseAutotuneSearchSpace(const FlowParserOptions& opts)
+{
+	AutotuneSearchSpace space;
+
+	space.cflmins = parseOptionalPetscCmd_realArray("-autotune_cfl_min", max_autotune_values);
+	if(space.cflmins.size() == 0)
+		space.cflmins.push_back(opts.initcfl);
+
+	space.cflmaxs = parseOptionalPetscCmd_realArray("-autotune_cfl_max", max_autotune_values);
+	if(space.cflmaxs.size() == 0)
+		space.cflmaxs.push_back(opts.endcfl);
+
+	space.rampups = parseOptionalPetscCmd_realArray("-autotune_cfl_ramp_exponent_up",
+	                                                max_autotune_values);
+	if(space.rampups.size() == 0)
+		space.rampups.push_back(parseOptionalPetscCmd_real("-cfl_ramp_exponent_up", 0.25));
+
+	space.rampdowns = parseOptionalPetscCmd_realArray("-autotune_cfl_ramp_exponent_down",
+	                                                  max_autotune_values);
+	if(space.rampdowns.size() == 0)
+		space.rampdowns.push_back(parseOptionalPetscCmd_real("-cfl_ramp_exponent_down", 0.3));
+
+	space.ksptypes = parseOptionalPetscCmd_stringArray("-autotune_ksp_types", max_autotune_values);
+	if(space.ksptypes.size() == 0) {
+		if(parsePetscCmd_isDefined("-ksp_type"))
+			space.ksptypes.push_back(parsePetscCmd_string("-ksp_type", 50));
+		else
+			space.ksptypes.push_back(KSPGMRES);
+	}
+
+	space.restarts = parseOptionalPetscCmd_intArray("-autotune_gmres_restarts", max_autotune_values);
+	if(space.restarts.size() == 0) {
+		if(parsePetscCmd_isDefined("-ksp_gmres_restart"))
+			space.restarts.push_back(parsePetscCmd_int("-ksp_gmres_restart"));
+		else
+			space.restarts.push_back(30);
+	}
+
+	space.pctypes = parseOptionalPetscCmd_stringArray("-autotune_pc_types", max_autotune_values);
+	if(space.pctypes.size() == 0) {
+		if(parsePetscCmd_isDefined("-pc_type"))
+			space.pctypes.push_back(parsePetscCmd_string("-pc_type", 50));
+		else
+			space.pctypes.push_back("");
+	}
+
+	return space;
+}
+
+std::vector<AutotuneCandidate> enumerateCandidates(const AutotuneSearchSpace& space)
+{
+	std::vector<AutotuneCandidate> cands;
+
+	for(a_real cflmin : space.cflmins)
+		for(a_real cflmax : space.cflmaxs)
+		{
+			if(cflmin > cflmax)
+				continue;
+
+			for(a_real rampup : space.rampups)
+				for(a_real rampdown : space.rampdowns)
+					for(const std::string& ksptype : space.ksptypes)
+					{
+						// only the first restart length is used by non-GMRES solvers
+						const size_t nrestarts = isGMRESType(ksptype) ? space.restarts.size() : 1;
+
+						for(size_t irs = 0; irs < nrestarts; irs++)
+							for(const std::string& pctype : space.pctypes)
+								cands.push_back(AutotuneCandidate{cflmin, cflmax, rampup, rampdown,
+								                                  ksptype, space.restarts[irs],
+								                                  pctype});
+					}
+		}
+
+	return cands;
+}
+
+int bestTrial(const std::vector<AutotuneTrial>& trials)
+{
+	int ibest = -1;
+	for(int i = 0; i < static_cast<int>(trials.size()); i++)
+	{
+		if(trials[i].diverged)
+			continue;
+		if(ibest < 0 || trials[i].rate > trials[ibest].rate)
+			ibest = i;
+	}
+	return ibest;
+}
+
+void writeAutotunedOptions(const std::string fname, const AutotuneTrial& best)
+{
+	std::ofstream fout;
+	open_file_toWrite(fname, fout);
+
+	const AutotuneCandidate& c = best.cand;
+	fout << "# Solver settings selected by the FVENS auto-tuner\n"
+	     << "#  Residual reduction rate = " << best.rate << " orders of magnitude per second\n"
+	     << "#  Time steps in trial = " << best.tdata.num_timesteps
+	     << ", avg linear iterations = " << best.tdata.avg_lin_iters << "\n\n";
+
+	fout << "-fvens_main_cfl_min " << c.cflmin << '\n'
+	     << "-fvens_main_cfl_max " << c.cflmax << '\n'
+	     << "-cfl_ramp_exponent_up " << c.rampup << '\n'
+	     << "-cfl_ramp_exponent_down " << c.rampdown << '\n'
+	     << "-ksp_type " << c.ksptype << '\n';
+	if(isGMRESType(c.ksptype))
+		fout << "-ksp_gmres_restart " << c.restart << '\n';
+	if(c.pctype != "")
+		fout << "-pc_type " << c.pctype << '\n';
+
+	fout.close();
+}
+
+static void writeTrialHeader(std::ostream& out, const int w)
+{
+	out << '#' << std::setw(w/2) << "trial"
+	    << std::setw(w) << "cfl-min" << std::setw(w) << "cfl-max"
+	    << std::setw(w) << "ramp-up" << std::setw(w) << "ramp-down"
+	    << std::setw(w) << "ksp" << std::setw(w/2) << "rst" << std::setw(w) << "pc"
+	    << std::setw(w) << "rel-res" << std::setw(w) << "wall-time"
+	    << std::setw(w) << "rate" << '\n';
+}
+
+static void writeTrial(std::ostream& out, const int w, const int itrial, const AutotuneTrial& t)
+{
+	const AutotuneCandidate& c = t.cand;
+	out << ' ' << std::setw(w/2) << itrial
+	    << std::setw(w) << c.cflmin << std::setw(w) << c.cflmax
+	    << std::setw(w) << c.rampup << std::setw(w) << c.rampdown
+	    << std::setw(w) << c.ksptype << std::setw(w/2) << c.restart
+	    << std::setw(w) << (c.pctype == "" ? "default" : c.pctype)
+	    << std::setw(w) << t.tdata.final_rel_residual << std::setw(w) << t.tdata.ode_walltime
+	    << std::setw(w) << (t.diverged ? "diverged" : toString(t.rate)) << std::endl;
+}
+
+AutotuneFlowCase::AutotuneFlowCase(const FlowParserOptions& options, const int num_trial_steps)
+	: SteadyFlowCase(options), ntrialsteps{num_trial_steps}
+{
+	fvens_throw(opts.pseudotimetype != "IMPLICIT", "Auto-tuning requires implicit pseudo-time!");
+}
+
+AutotuneTrial AutotuneFlowCase::trial(const Spatial<a_real,NVARS> *const prob, const Vec u0,
+                                      const AutotuneCandidate& cand) const
+{
+	StatusCode ierr = 0;
+	AutotuneTrial res;
+	res.cand = cand;
+	res.diverged = false;
+	res.rate = 0;
+
+	// pass the settings to the solvers through the options database; every option set here is
+	//  put back to its previous state after the trial, so that no trial inherits another's settings
+	std::vector<SavedPetscOption> saved;
+	setTrialOption(saved, "-cfl_ramp_exponent_up", toString(cand.rampup));
+	setTrialOption(saved, "-cfl_ramp_exponent_down", toString(cand.rampdown));
+	setTrialOption(saved, "-ksp_type", cand.ksptype);
+	if(isGMRESType(cand.ksptype))
+		setTrialOption(saved, "-ksp_gmres_restart", toString(cand.restart));
+	if(cand.pctype != "")
+		setTrialOption(saved, "-pc_type", cand.pctype);
+
+	Vec u;
+	ierr = VecDuplicate(u0, &u); petsc_throw(ierr, "Could not create trial state");
+	ierr = VecCopy(u0, u); petsc_throw(ierr, "Could not copy trial state");
+
+	LinearProblemLHS<NVARS> isol = setupImplicitSolver<NVARS>(prob->mesh(), mf_flg);
+
+	const SteadySolverConfig tconf {
+		false, opts.logfile,
+		cand.cflmin, cand.cflmax, opts.rampstart, opts.rampend,
+		opts.tolerance, ntrialsteps,
+	};
+
+	ierr = setup_subdomain_pc<NVARS>(isol.ksp,u,prob);
+	fvens_throw(ierr, "Sub-domain preconditioner not setup");
+#ifdef USE_BLASTED
+	Blasted_data_list bctx = newBlastedDataList();
+	ierr = setup_blasted<NVARS>(isol.ksp,u,prob,bctx); fvens_throw(ierr, "BLASTed not setup");
+#endif
+	ierr = setup_polynomial_pc<NVARS>(isol.ksp,u,prob);
+	fvens_throw(ierr, "Polynomial preconditioner not setup");
+
+	{
+		SteadyBackwardEulerSolver<NVARS> time(prob, tconf, isol.ksp);
+		isol.mfjac.set_spatial(prob);
+
+		try {
+			ierr = time.solve(u);
+			petsc_throw(ierr, "Trial nonlinear solve failed!");
+		}
+		catch(Tolerance_error& e) {
+			// expected - trials are deliberately too short to converge
+		}
+		catch(Numerical_error& e) {
+			res.diverged = true;
+		}
+
+		res.tdata = time.getTimingData();
+		// the residual of a blown-up solve is meaningless; make sure it cannot rank well
+		if(res.diverged)
+			res.tdata.final_rel_residual = std::numeric_limits<a_real>::infinity();
+	}
+
+	if(!std::isfinite(res.tdata.final_rel_residual) || res.tdata.final_rel_residual >= 1.0)
+		res.diverged = true;
+
+	if(!res.diverged && res.tdata.ode_walltime > 0)
+		res.rate = -std::log10(res.tdata.final_rel_residual) / res.tdata.ode_walltime;
+
+	ierr = isol.destroy(); petsc_throw(ierr, "Could not destroy linear problem LHS");
+#ifdef USE_BLASTED
+	destroyBlastedDataList(&bctx);
+#endif
+	ierr = VecDestroy(&u); petsc_throw(ierr, "Could not destroy trial state");
+
+	restoreTrialOptions(saved);
+
+	return res;
+}
+
+std::vector<AutotuneTrial> AutotuneFlowCase::tune(const UMesh2dh<a_real>& m, Vec u,
+                                                  const std::vector<AutotuneCandidate>& cands) const
+{
+	const Spatial<a_real,NVARS> *const prob = createFlowSpatial(opts, m);
+
+	StatusCode ierr = execute_starter(prob, u);
+	fvens_throw(ierr, "Startup solve failed!");
+
+	std::cout << "\nAutotuneFlowCase: Running " << cands.size() << " trials of "
+	          << ntrialsteps << " time steps each.\n";
+
+	std::vector<AutotuneTrial> trials;
+	for(size_t i = 0; i < cands.size(); i++)
+	{
+		trials.push_back(trial(prob, u, cands[i]));
+		writeTrialHeader(std::cout, field_width);
+		writeTrial(std::cout, field_width, static_cast<int>(i), trials.back());
+	}
+
+	std::cout << "\nAutotuneFlowCase: Summary of trials:\n";
+	writeTrialHeader(std::cout, field_width);
+	for(size_t i = 0; i < trials.size(); i++)
+		writeTrial(std::cout, field_width, static_cast<int>(i), trials[i]);
+
+	delete prob;
+	return trials;
+}
+
+}
@@ -0,0 +1,119 @@
+/** \file autotune.hpp
+ * \brief Automatic selection of pseudo-time and linear solver parameters by short trial solves
+ * \author Aditya Kashi
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FVENS_AUTOTUNE_H
+#define FVENS_AUTOTUNE_H
+
+#include <string>
+#include <vector>
+#include "utilities/casesolvers.hpp"
+
+namespace fvens {
+
+/// One point in the space of solver settings explored by the auto-tuner
+struct AutotuneCandidate
+{
+	a_real cflmin;               ///< Initial CFL number of the main solve
+	a_real cflmax;               ///< Max CFL number of the main solve
+	a_real rampup;               ///< Exponent for increasing the CFL in the residual-ratio ramp
+	a_real rampdown;             ///< Exponent for decreasing the CFL in the residual-ratio ramp
+	std::string ksptype;         ///< PETSc KSP type
+	int restart;                 ///< Restart length for GMRES-type solvers; ignored by others
+	std::string pctype;          ///< PETSc PC type; if empty, the PC in the options database is used
+};
+
+/// Lists of values of each parameter to be explored; the search space is their Cartesian product
+struct AutotuneSearchSpace
+{
+	std::vector<a_real> cflmins;
+	std::vector<a_real> cflmaxs;
+	std::vector<a_real> rampups;
+	std::vector<a_real> rampdowns;
+	std::vector<std::string> ksptypes;
+	std::vector<int> restarts;
+	std::vector<std::string> pctypes;
+};
+
+/// Result of one trial solve
+struct AutotuneTrial
+{
+	AutotuneCandidate cand;      ///< Settings used for the trial
+	TimingData tdata;            ///< Timing and convergence data of the trial solve
+	bool diverged;               ///< Whether the trial solve blew up
+	/// Orders of magnitude of residual reduction achieved per second of wall-clock time
+	a_real rate;
+};
+
+/// Reads the search space from the PETSc options database
+/** Parameters whose options are not given are fixed to the values in the control file or
+ * the PETSc options database. The options are
+ *  - `-autotune_cfl_min` and `-autotune_cfl_max` (comma-separated reals)
+ *  - `-autotune_cfl_ramp_exponent_up` and `-autotune_cfl_ramp_exponent_down` (reals)
+ *  - `-autotune_ksp_types` (comma-separated strings)
+ *  - `-autotune_gmres_restarts` (comma-separated ints)
+ *  - `-autotune_pc_types` (comma-separated strings)
+ */
+AutotuneSearchSpace parseAutotuneSearchSpace(const FlowParserOptions& opts);
+
+/// Enumerate all admissible candidates in a search space
+/** Candidates with the minimum CFL larger than the maximum CFL are discarded, and restart lengths
+ * are only varied for GMRES-type Krylov solvers.
+ */
+std::vector<AutotuneCandidate> enumerateCandidates(const AutotuneSearchSpace& space);
+
+/// Returns the index of the trial with the best residual reduction rate, or -1 if all diverged
+int bestTrial(const std::vector<AutotuneTrial>& trials);
+
+/// Writes the settings of a trial to a PETSc options file usable for a production run
+/** Pass the file to the solver with `-options_file' along with the original PETSc options file.
+ */
+void writeAutotunedOptions(const std::string fname, const AutotuneTrial& best);
+
+/// Runs short implicit trial solves of a steady case with different solver settings
+/** The startup (first-order) solve is carried out once as for a normal run; each trial then
+ * restarts the main solve from the resulting state for a small fixed number of pseudo-time steps.
+ * Settings are passed to the trial solves through the default PETSc options database; each
+ * trial restores the options it set once it is done, so the next trial starts from the user's.
+ */
+class AutotuneFlowCase : public SteadyFlowCase
+{
+public:
+	/// Construct a tuning case with parsed options
+	/** \param options Parsed control file options
+	 * \param num_trial_steps Number of pseudo-time steps to take in each trial solve
+	 */
+	AutotuneFlowCase(const FlowParserOptions& options, const int num_trial_steps);
+
+	/// Solve the startup problem and then carry out one trial for each candidate
+	/** \param mesh The mesh to solve the problem on
+	 * \param u The initial condition; on output, the state after the startup solve
+	 */
+	std::vector<AutotuneTrial> tune(const UMesh2dh<a_real>& mesh, Vec u,
+	                                const std::vector<AutotuneCandidate>& candidates) const;
+
+	/// Carry out one trial solve from the state u0, which is not modified
+	AutotuneTrial trial(const Spatial<a_real,NVARS> *const prob, const Vec u0,
+	                    const AutotuneCandidate& cand) const;
+
+protected:
+	const int ntrialsteps;
+};
+
+}
+#endif
@@ -0,0 +1,225 @@
+/** \file casebatch.cpp
+ * \brief Concurrent solution of several independent steady flow cases on one mesh
+ * \author Aditya Kashi
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include <petscsys.h>
+#include <petsctime.h>
+
+#include "casebatch.hpp"
+#include "utilities/aoptionparser.hpp"
+
+namespace fvens {
+
+/// Max number of values read for the list of any one parameter of the batch
+static const int max_batch_cases = 1000;
+
+/// Field width in the batch report
+static const int field_width = 12;
+
+/// A steady case which records the timing data of its main solve instead of throwing when it
+/// does not converge
+class BatchSteadyFlowCase : public SteadyFlowCase
+{
+public:
+	BatchSteadyFlowCase(const FlowParserOptions& options) : SteadyFlowCase(options), tdata{}
+	{
+		tdata.converged = false;
+	}
+
+	int execute(const Spatial<a_real,NVARS> *const prob, Vec u) const
+	{
+		return executeRecorded(prob, u);
+	}
+
+	int execute(const Spatial<a_real,NVARS+1> *const prob, Vec u) const
+	{
+		return executeRecorded(prob, u);
+	}
+
+	const TimingData& timingData() const { return tdata; }
+
+protected:
+	mutable TimingData tdata;
+
+	template <int nvars>
+	int executeRecorded(const Spatial<a_real,nvars> *const prob, Vec u) const
+	{
+		int ierr = execute_starter(prob, u); fvens_throw(ierr, "Startup solve failed!");
+		tdata = execute_main(prob, u);
+		return ierr;
+	}
+};
+
+std::vector<FlowParserOptions> generateBatchCases(const FlowParserOptions& opts)
+{
+	const std::vector<PetscReal> machs
+		= parseOptionalPetscCmd_realArray("-batch_mach_numbers", max_batch_cases);
+	const std::vector<PetscReal> alphas
+		= parseOptionalPetscCmd_realArray("-batch_angles_of_attack", max_batch_cases);
+	const int nrepeat = parsePetscCmd_isDefined("-batch_num_cases") ?
+		parsePetscCmd_int("-batch_num_cases") : 1;
+
+	const size_t ncases = std::max(std::max(machs.size(), alphas.size()),
+	                               static_cast<size_t>(std::max(nrepeat,1)));
+
+	std::vector<FlowParserOptions> cases(ncases, opts);
+	for(size_t ic = 0; ic < ncases; ic++)
+	{
+		if(ic < machs.size())
+			cases[ic].Minf = machs[ic];
+		if(ic < alphas.size())
+			cases[ic].alpha = PI/180.0*alphas[ic];
+		cases[ic].logfile = opts.logfile + "-case" + std::to_string(ic);
+		cases[ic].vol_output_reqd = "NO";
+		cases[ic].fieldout.file.clear();
+	}
+	return cases;
+}
+
+FlowCaseBatch::FlowCaseBatch(const int num_teams) : nteams{num_teams > 0 ? num_teams : 1}
+{ }
+
+std::vector<BatchCaseResult> FlowCaseBatch::solve(const UMesh2dh<a_real>& m,
+                                                  const std::vector<FlowParserOptions>& cases) const
+{
+	const int ncases = static_cast<int>(cases.size());
+	std::vector<BatchCaseResult> results(ncases);
+
+	int commsize = 1;
+	int ierr = MPI_Comm_size(PETSC_COMM_WORLD, &commsize);
+	petsc_throw(ierr, "Could not get communicator size");
+	fvens_throw(commsize > 1, "Batches of cases can only be solved on one MPI rank!");
+
+	int numteams = std::min(nteams, ncases);
+#ifndef _OPENMP
+	if(numteams > 1) {
+		std::cout << "! FlowCaseBatch: Not built with OpenMP; the " << numteams << " requested teams"
+			" are NOT used and the cases are solved one after the other!\n";
+		numteams = 1;
+	}
+	const int nthreads = 1;
+#else
+#ifndef PETSC_HAVE_THREADSAFETY
+	if(numteams > 1) {
+		std::cout << "! FlowCaseBatch: PETSc is not configured with --with-threadsafety;\n"
+			"!  the " << numteams << " requested teams are NOT used and the cases are solved one after"
+			" the other with all threads.\n"
+			"!  Reconfigure PETSc with --with-threadsafety to solve the cases concurrently.\n";
+		numteams = 1;
+	}
+#endif
+	const int nthreads = omp_get_max_threads();
+#endif
+	const int teamsize = std::max(nthreads/std::max(numteams,1), 1);
+	std::cout << " FlowCaseBatch: Solving " << ncases << " cases with " << numteams
+	          << " teams of " << teamsize << " threads each.\n";
+
+	if(numteams <= 1)
+	{
+		for(int ic = 0; ic < ncases; ic++)
+			results[ic] = solveCase(m, cases[ic], 0);
+		return results;
+	}
+
+#ifdef _OPENMP
+	const int maxlevels = omp_get_max_active_levels();
+	omp_set_max_active_levels(std::max(maxlevels,2));
+
+#pragma omp parallel num_threads(numteams) proc_bind(spread) default(shared)
+	{
+		const int team = omp_get_thread_num();
+		// applies to parallel regions nested within this thread only
+		omp_set_num_threads(teamsize);
+
+#pragma omp for schedule(dynamic,1)
+		for(int ic = 0; ic < ncases; ic++)
+			results[ic] = solveCase(m, cases[ic], team);
+	}
+
+	omp_set_max_active_levels(maxlevels);
+#endif
+	return results;
+}
+
+BatchCaseResult FlowCaseBatch::solveCase(const UMesh2dh<a_real>& m,
+                                         const FlowParserOptions& caseopts, const int team) const
+{
+	BatchCaseResult res{};
+	res.Minf = caseopts.Minf;
+	res.alpha = caseopts.alpha;
+	res.team = team;
+	res.failed = false;
+	res.fnls = FlowSolutionFunctionals{0,0,0,0,0};
+
+	PetscLogDouble starttime, endtime;
+	PetscTime(&starttime);
+
+	// exceptions must not escape the parallel region; a failed case must not stop the others
+	Vec u = NULL;
+	try {
+		int ierr = initializeSystemVector(caseopts, m, &u);
+		fvens_throw(ierr, "Could not initialize system vector!");
+
+		const BatchSteadyFlowCase flowcase(caseopts);
+		res.fnls = flowcase.run_output(false, false, m, u);
+		res.tdata = flowcase.timingData();
+	}
+	catch(std::exception& e) {
+		std::cout << " FlowCaseBatch: Case with Mach " << caseopts.Minf << " failed: "
+		          << e.what() << std::endl;
+		res.failed = true;
+		res.tdata.converged = false;
+	}
+
+	if(u)
+		VecDestroy(&u);
+
+	PetscTime(&endtime);
+	res.walltime = endtime - starttime;
+	return res;
+}
+
+void writeBatchReport(std::ostream& os, const std::vector<BatchCaseResult>& results,
+                      const double walltime)
+{
+	os << "\n" << std::setw(6) << "Case" << std::setw(6) << "Team"
+	   << std::setw(field_width) << "Mach" << std::setw(field_width) << "AoA(deg)"
+	   << std::setw(field_width) << "CL" << std::setw(field_width) << "CDp"
+	   << std::setw(field_width) << "CDsf" << std::setw(field_width) << "Steps"
+	   << std::setw(field_width) << "Time(s)" << std::setw(field_width) << "Status" << '\n';
+
+	int nconverged = 0;
+	double sumcasetime = 0;
+	for(size_t ic = 0; ic < results.size(); ic++)
+	{
+		const BatchCaseResult& r = results[ic];
+		const std::string status = r.failed ? "failed" :
+			(r.tdata.converged ? "converged" : "unconverged");
+		if(!r.failed && r.tdata.converged)
+			nconverged++;
+		sumcasetime += r.walltime;
+
+		os << std::setw(6) << ic << std::setw(6) << r.team
+		   << std::setw(field_width) << r.Minf << std::setw(field_width) << r.alpha*180.0/PI
+		   << std::setw(field_width) << r.fnls.CL << std::setw(field_width) << r.fnls.CDp
+		   << std::setw(field_width) << r.fnls.CDsf
+		   << std::setw(field_width) << (r.failed ? 0 : r.tdata.num_timesteps)
+		   << std::setw(field_width) << r.walltime << std::setw(field_width) << status << '\n';
+	}
+
+	os << "\n Cases: " << results.size() << ", converged: " << nconverged << '\n'
+	   << " Total wall time: " << walltime << "s; sum of wall times of cases: " << sumcasetime
+	   << "s\n"
+	   << " Throughput: " << static_cast<double>(results.size())/walltime*3600.0
+	   << " cases per hour\n";
+}
+
+}
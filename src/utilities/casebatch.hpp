@@ -0,0 +1,94 @@
+/** \file casebatch.hpp
+ * \brief Concurrent solution of several independent steady flow cases on one mesh
+ * \author Aditya Kashi
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FVENS_CASEBATCH_H
+#define FVENS_CASEBATCH_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include "utilities/casesolvers.hpp"
+
+namespace fvens {
+
+/// Result of one case of a batch
+struct BatchCaseResult
+{
+	a_real Minf;                 ///< Free-stream Mach number of the case
+	a_real alpha;                ///< Angle of attack of the case in radians
+	int team;                    ///< Index of the thread team that solved the case
+	bool failed;                 ///< Whether the solve threw an exception
+	TimingData tdata;            ///< Timing and convergence data of the main solve
+	FlowSolutionFunctionals fnls;///< Output functionals; only valid if the case did not fail
+	double walltime;             ///< Wall-clock time taken by the whole case
+};
+
+/// Generates the options of each case of a batch from the control file options
+/** The cases are specified by the following PETSc options:
+ *  - `-batch_mach_numbers` (comma-separated reals): free-stream Mach numbers
+ *  - `-batch_angles_of_attack` (comma-separated reals): angles of attack in degrees
+ *  - `-batch_num_cases` (int): number of cases
+ * The number of cases is the largest of the lengths of the lists and `-batch_num_cases'. Cases
+ * beyond the end of a list take the value from the control file. Each case logs to the log file
+ * of the control file with the suffix "-case<index>", and no volume or field output is
+ * written.
+ */
+std::vector<FlowParserOptions> generateBatchCases(const FlowParserOptions& opts);
+
+/// Solves a batch of independent steady cases concurrently, each on its own team of threads
+/** The mesh is shared, read-only, by all cases; everything else (discretization, solution vector,
+ * Jacobian and solvers) is private to a case. The available OpenMP threads are split into a
+ * number of teams: an outer parallel region has one thread per team, and each of those threads
+ * sets the number of threads of the parallel regions nested within it - those of the spatial
+ * discretization and the solvers - to the team size. Cases are handed out to teams dynamically,
+ * since they need different numbers of pseudo-time steps. For the teams to be placed on disjoint
+ * sets of cores, run with eg. `OMP_PLACES=cores OMP_PROC_BIND=spread,close'.
+ *
+ * Concurrent solves require PETSc to be configured with `--with-threadsafety'; otherwise, the
+ * cases are solved one after the other with all threads. Only one MPI rank is supported.
+ * Performance counter stages are not recorded while more than one team is active.
+ */
+class FlowCaseBatch
+{
+public:
+	/// Set up the batch
+	/** \param num_teams Requested number of thread teams; at most one team per case is used
+	 */
+	FlowCaseBatch(const int num_teams);
+
+	/// Solve all cases on a mesh and return their results in the order of the cases
+	std::vector<BatchCaseResult> solve(const UMesh2dh<a_real>& mesh,
+	                                   const std::vector<FlowParserOptions>& cases) const;
+
+protected:
+	const int nteams;
+
+	/// Solve one case with the calling thread's team of threads
+	BatchCaseResult solveCase(const UMesh2dh<a_real>& mesh, const FlowParserOptions& caseopts,
+	                          const int team) const;
+};
+
+/// Writes a table of the results of a batch and its aggregate throughput
+/** \param walltime Wall-clock time taken by the whole batch
+ */
+void writeBatchReport(std::ostream& os, const std::vector<BatchCaseResult>& results,
+                      const double walltime);
+
+}
+#endif
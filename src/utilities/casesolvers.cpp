@@ -13,6 +13,8 @@
 #include "utilities/aoptionparser.hpp"
 #include "spatial/aoutput.hpp"
 #include "mesh/ameshutils.hpp"
+#include "linalg/polynomialpc.hpp"
+#include "linalg/subdomainpc.hpp"
 
 #ifdef USE_BLASTED
 #include <blasted_petsc.h>
@@ -51,32 +53,87 @@ const FlowFV_base<a_real>* createFlowSpatial(const FlowParserOptions& opts,
 	return create_const_flowSpatialDiscretization(&m, pconf, nconfmain);
 }
 
+const FlowFV_base<a_real,NVARS+1>* createTurbulentFlowSpatial(const FlowParserOptions& opts,
+                                                             const UMesh2dh<a_real>& m)
+{
+	std::cout << "Setting up main spatial scheme with turbulence model " << opts.turbulence_model
+	          << ".\n";
+	const FlowPhysicsConfig pconf = extract_spatial_physics_config(opts);
+	const FlowNumericsConfig nconfmain = extract_spatial_numerics_config(opts);
+
+	return create_const_flowSpatialDiscretization<a_real,NVARS+1>(&m, pconf, nconfmain);
+}
+
+int getNumberOfFlowVariables(const FlowParserOptions& opts)
+{
+	return isTurbulent(extract_spatial_physics_config(opts)) ? NVARS+1 : NVARS;
+}
+
 int initializeSystemVector(const FlowParserOptions& opts, const UMesh2dh<a_real>& m, Vec *const u)
 {
-	int ierr = VecCreateSeq(PETSC_COMM_SELF, m.gnelem()*NVARS, u); CHKERRQ(ierr);
+	const int nvars = getNumberOfFlowVariables(opts);
+	int ierr = VecCreateSeq(PETSC_COMM_SELF, m.gnelem()*nvars, u); CHKERRQ(ierr);
 
 	const IdealGasPhysics<a_real> phy(opts.gamma, opts.Minf, opts.Tinf, opts.Reinf, opts.Pr);
 	const std::array<a_real,NVARS> uinf = phy.compute_freestream_state(opts.alpha);
+	const a_real nutinf = nvars > NVARS ? getSAFreestreamWorkingVariable(1.0/opts.Reinf) : 0;
 
 	PetscScalar * uloc;
 	ierr = VecGetArray(*u, &uloc); CHKERRQ(ierr);
 	
 	//initial values are equal to free-stream values
-	for(a_int i = 0; i < m.gnelem(); i++)
+	for(a_int i = 0; i < m.gnelem(); i++) {
 		for(int j = 0; j < NVARS; j++)
-			uloc[i*NVARS+j] = uinf[j];
+			uloc[i*nvars+j] = uinf[j];
+		for(int j = NVARS; j < nvars; j++)
+			uloc[i*nvars+j] = uinf[0]*nutinf;
+	}
 
 	ierr = VecRestoreArray(*u, &uloc); CHKERRQ(ierr);
 	return ierr;
 }
 
+/// Copies the flow variables out of a solution vector having extra variables
+/** \param[in] u The solution vector with nvars variables per cell
+ * \param[out] uflow A new vector with only the \ref NVARS flow variables per cell
+ */
+static int extractFlowVariables(const Vec u, const int nvars, Vec *const uflow)
+{
+	PetscInt size;
+	int ierr = VecGetLocalSize(u, &size); CHKERRQ(ierr);
+	const a_int nelem = size/nvars;
+	ierr = VecCreateSeq(PETSC_COMM_SELF, nelem*NVARS, uflow); CHKERRQ(ierr);
+
+	const PetscScalar *uarr; PetscScalar *uflowarr;
+	ierr = VecGetArrayRead(u, &uarr); CHKERRQ(ierr);
+	ierr = VecGetArray(*uflow, &uflowarr); CHKERRQ(ierr);
+	for(a_int i = 0; i < nelem; i++)
+		for(int j = 0; j < NVARS; j++)
+			uflowarr[i*NVARS+j] = uarr[i*nvars+j];
+	ierr = VecRestoreArray(*uflow, &uflowarr); CHKERRQ(ierr);
+	ierr = VecRestoreArrayRead(u, &uarr); CHKERRQ(ierr);
+	return ierr;
+}
+
 FlowCase::FlowCase(const FlowParserOptions& options) : opts{options}
 {
 }
 
+int FlowCase::execute(const Spatial<a_real,NVARS+1> *const, Vec) const
+{
+	throw std::runtime_error("This kind of case does not support turbulent flow!");
+}
+
 int FlowCase::run(const UMesh2dh<a_real>& m, Vec u) const
 {
 	int ierr = 0;
+	if(getNumberOfFlowVariables(opts) > NVARS) {
+		const Spatial<a_real,NVARS+1> *const tprob = createTurbulentFlowSpatial(opts, m);
+		ierr = execute(tprob, u); CHKERRQ(ierr);
+		delete tprob;
+		return ierr;
+	}
+
 	const Spatial<a_real,NVARS> *const prob = createFlowSpatial(opts, m);
 
 	ierr = execute(prob, u); CHKERRQ(ierr);
@@ -91,19 +148,40 @@ FlowSolutionFunctionals FlowCase::run_output(const bool surface_file_needed,
 {
 	int ierr = 0;
 
-	const FlowFV_base<a_real> *const prob = createFlowSpatial(opts, m);
+	/* For turbulent flow, the outputs are computed from the flow variables by a laminar
+	 * discretization; the surface quantities are unaffected, since the eddy viscosity vanishes
+	 * at walls.
+	 */
+	const bool turbulent = getNumberOfFlowVariables(opts) > NVARS;
+	FlowParserOptions outopts = opts;
+	outopts.turbulence_model = "NONE";
+
+	const FlowFV_base<a_real> *const prob = createFlowSpatial(outopts, m);
 
 	const a_real h = 1.0 / ( std::pow((a_real)m.gnelem(), 1.0/NDIM) );
 	std::cout << "***\n";
 
 	try {
-		ierr = execute(prob, u);
+		if(turbulent) {
+			const Spatial<a_real,NVARS+1> *const tprob = createTurbulentFlowSpatial(opts, m);
+			ierr = execute(tprob, u);
+			delete tprob;
+		}
+		else
+			ierr = execute(prob, u);
 	}
 	catch (Tolerance_error& e) {
 		std::cout << e.what() << std::endl;
 	}
 	fvens_throw(ierr, "Could not solve steady case! Error code " + std::to_string(ierr));
 
+	Vec uturb = NULL;
+	if(turbulent) {
+		uturb = u;
+		ierr = extractFlowVariables(uturb, NVARS+1, &u);
+		petsc_throw(ierr, "Could not extract flow variables");
+	}
+
 	MVector<a_real> umat; umat.resize(m.gnelem(),NVARS);
 	const PetscScalar *uarr;
 	ierr = VecGetArrayRead(u, &uarr); 
@@ -140,6 +218,11 @@ FlowSolutionFunctionals FlowCase::run_output(const bool surface_file_needed,
 
 	if(opts.vol_output_reqd == "YES")
 		out.exportVolumeData(umat, opts.volnameprefix);
+
+	if(!opts.fieldout.file.empty()) {
+		ierr = out.exportFields(u, opts.fieldout);
+		petsc_throw(ierr, "Could not export fields");
+	}
 	
 	MVector<a_real> output; output.resize(m.gnelem(),NDIM+2);
 	GradArray<a_real,NVARS> grad;
@@ -150,12 +233,16 @@ FlowSolutionFunctionals FlowCase::run_output(const bool surface_file_needed,
 		{ prob->computeSurfaceData(umat, grad, opts.lwalls[0], output)};
 
 	delete prob;
+	if(uturb) {
+		ierr = VecDestroy(&u); petsc_throw(ierr, "Could not destroy flow variables");
+	}
 
 	return FlowSolutionFunctionals{h, entropy,
 			std::get<0>(fnls), std::get<1>(fnls), std::get<2>(fnls)};
 }
 
-void FlowCase::setupKSP(LinearProblemLHS& solver, const bool use_mfjac) {
+template <int nvars>
+void FlowCase::setupKSP(LinearProblemLHS<nvars>& solver, const bool use_mfjac) {
 	// initialize solver
 	int ierr = KSPCreate(PETSC_COMM_WORLD, &solver.ksp); petsc_throw(ierr, "KSP Create");
 	if(use_mfjac) {
@@ -170,18 +257,19 @@ void FlowCase::setupKSP(LinearProblemLHS& solver, const bool use_mfjac) {
 	ierr = KSPSetFromOptions(solver.ksp); petsc_throw(ierr, "KSP set from options");
 }
 
-FlowCase::LinearProblemLHS FlowCase::setupImplicitSolver(const UMesh2dh<a_real> *const mesh,
-                                                         const bool use_mfjac)
+template <int nvars>
+FlowCase::LinearProblemLHS<nvars> FlowCase::setupImplicitSolver(const UMesh2dh<a_real> *const mesh,
+                                                                const bool use_mfjac)
 {
-	LinearProblemLHS solver;
+	LinearProblemLHS<nvars> solver;
 
 	// Initialize Jacobian for implicit schemes
-	int ierr = setupSystemMatrix<NVARS>(mesh, &solver.M); fvens_throw(ierr, "Setup system matrix");
+	int ierr = setupSystemMatrix<nvars>(mesh, &solver.M); fvens_throw(ierr, "Setup system matrix");
 
 	// setup matrix-free Jacobian if requested
 	if(use_mfjac) {
 		std::cout << " Allocating matrix-free Jac\n";
-		ierr = setup_matrixfree_jacobian<NVARS>(mesh, &solver.mfjac, &solver.A); 
+		ierr = setup_matrixfree_jacobian<nvars>(mesh, &solver.mfjac, &solver.A); 
 		fvens_throw(ierr, "Setup matrix-free Jacobian");
 	}
 
@@ -191,12 +279,28 @@ FlowCase::LinearProblemLHS FlowCase::setupImplicitSolver(const UMesh2dh<a_real>
 	return solver;
 }
 
+template FlowCase::LinearProblemLHS<NVARS>
+FlowCase::setupImplicitSolver<NVARS>(const UMesh2dh<a_real> *const mesh, const bool use_mfjac);
+template FlowCase::LinearProblemLHS<NVARS+1>
+FlowCase::setupImplicitSolver<NVARS+1>(const UMesh2dh<a_real> *const mesh, const bool use_mfjac);
+
 SteadyFlowCase::SteadyFlowCase(const FlowParserOptions& options)
 	: FlowCase(options),
 	  mf_flg {parsePetscCmd_isDefined("-matrix_free_jacobian")}
 { }
 
 int SteadyFlowCase::execute_starter(const Spatial<a_real,NVARS> *const prob, Vec u) const
+{
+	return solveStarter(prob, u);
+}
+
+int SteadyFlowCase::execute_starter(const Spatial<a_real,NVARS+1> *const prob, Vec u) const
+{
+	return solveStarter(prob, u);
+}
+
+template <int nvars>
+int SteadyFlowCase::solveStarter(const Spatial<a_real,nvars> *const prob, Vec u) const
 {
 	int ierr = 0;
 	
@@ -206,12 +310,12 @@ int SteadyFlowCase::execute_starter(const Spatial<a_real,NVARS> *const prob, Vec
 	const FlowNumericsConfig nconfstart {firstorder_spatial_numerics_config(opts)};
 
 	std::cout << "\nSetting up spatial scheme for the initial guess.\n";
-	const Spatial<a_real,NVARS> *const startprob
-		= create_const_flowSpatialDiscretization(m, pconf, nconfstart);
+	const Spatial<a_real,nvars> *const startprob
+		= create_const_flowSpatialDiscretization<a_real,nvars>(m, pconf, nconfstart);
 
 	std::cout << "***\n";
 
-	LinearProblemLHS isol = setupImplicitSolver(m, mf_flg);
+	LinearProblemLHS<nvars> isol = setupImplicitSolver<nvars>(m, mf_flg);
 
 	// set up time discrization
 
@@ -221,12 +325,12 @@ int SteadyFlowCase::execute_starter(const Spatial<a_real,NVARS> *const prob, Vec
 		opts.firsttolerance, opts.firstmaxiter,
 	};
 
-	SteadySolver<NVARS> * starttime = nullptr;
+	SteadySolver<nvars> * starttime = nullptr;
 
 	if(opts.pseudotimetype == "IMPLICIT")
 	{
 		if(opts.usestarter != 0) {
-			starttime = new SteadyBackwardEulerSolver<NVARS>(startprob, starttconf, isol.ksp);
+			starttime = new SteadyBackwardEulerSolver<nvars>(startprob, starttconf, isol.ksp);
 			std::cout << "Set up backward Euler temporal scheme for initialization solve.\n";
 		}
 
@@ -234,18 +338,25 @@ int SteadyFlowCase::execute_starter(const Spatial<a_real,NVARS> *const prob, Vec
 	else
 	{
 		if(opts.usestarter != 0) {
-			starttime = new SteadyForwardEulerSolver<NVARS>(startprob, u, starttconf);
+			starttime = new SteadyForwardEulerSolver<nvars>(startprob, u, starttconf);
 			std::cout << "Set up explicit forward Euler temporal scheme for startup solve.\n";
 		}
 	}
 
+	if(opts.pseudotimetype == "IMPLICIT") {
+		ierr = setup_subdomain_pc<nvars>(isol.ksp,u,startprob); CHKERRQ(ierr);
+	}
+
 	// setup BLASTed preconditioning if requested
 #ifdef USE_BLASTED
 	Blasted_data_list bctx = newBlastedDataList();
 	if(opts.pseudotimetype == "IMPLICIT") {
-		ierr = setup_blasted<NVARS>(isol.ksp,u,startprob,bctx); CHKERRQ(ierr);
+		ierr = setup_blasted<nvars>(isol.ksp,u,startprob,bctx); CHKERRQ(ierr);
 	}
 #endif
+	if(opts.pseudotimetype == "IMPLICIT") {
+		ierr = setup_polynomial_pc<nvars>(isol.ksp,u,startprob); CHKERRQ(ierr);
+	}
 
 	std::cout << "***\n";
 
@@ -280,12 +391,23 @@ int SteadyFlowCase::execute_starter(const Spatial<a_real,NVARS> *const prob, Vec
 }
 
 TimingData SteadyFlowCase::execute_main(const Spatial<a_real,NVARS> *const prob, Vec u) const
+{
+	return solveMain(prob, u);
+}
+
+TimingData SteadyFlowCase::execute_main(const Spatial<a_real,NVARS+1> *const prob, Vec u) const
+{
+	return solveMain(prob, u);
+}
+
+template <int nvars>
+TimingData SteadyFlowCase::solveMain(const Spatial<a_real,nvars> *const prob, Vec u) const
 {
 	int ierr = 0;
 	
 	const UMesh2dh<a_real> *const m = prob->mesh();
 
-	LinearProblemLHS isol = setupImplicitSolver(m, mf_flg);
+	LinearProblemLHS<nvars> isol = setupImplicitSolver<nvars>(m, mf_flg);
 
 	// set up time discrization
 
@@ -295,44 +417,56 @@ TimingData SteadyFlowCase::execute_main(const Spatial<a_real,NVARS> *const prob,
 		opts.tolerance, opts.maxiter,
 	};
 
-	SteadySolver<NVARS> * time = nullptr;
+	SteadySolver<nvars> * time = nullptr;
 
+	if(opts.pseudotimetype == "IMPLICIT") {
+		ierr = setup_subdomain_pc<nvars>(isol.ksp,u,prob);
+		fvens_throw(ierr, "Sub-domain preconditioner not setup");
+	}
 #ifdef USE_BLASTED
 	Blasted_data_list bctx = newBlastedDataList();
 	if(opts.pseudotimetype == "IMPLICIT") {
-		ierr = setup_blasted<NVARS>(isol.ksp,u,prob,bctx); fvens_throw(ierr, "BLASTed not setup");
+		ierr = setup_blasted<nvars>(isol.ksp,u,prob,bctx); fvens_throw(ierr, "BLASTed not setup");
 	}
 #endif
+	if(opts.pseudotimetype == "IMPLICIT") {
+		ierr = setup_polynomial_pc<nvars>(isol.ksp,u,prob);
+		fvens_throw(ierr, "Polynomial preconditioner not setup");
+	}
 
 	// setup nonlinear ODE solver for main solve - MUST be done AFTER KSPCreate
 	if(opts.pseudotimetype == "IMPLICIT")
 	{
-		time = new SteadyBackwardEulerSolver<NVARS>(prob, maintconf, isol.ksp);
+		time = new SteadyBackwardEulerSolver<nvars>(prob, maintconf, isol.ksp);
 		std::cout << "\nSet up backward Euler temporal scheme for main solve.\n";
 	}
 	else
 	{
-		time = new SteadyForwardEulerSolver<NVARS>(prob, u, maintconf);
+		time = new SteadyForwardEulerSolver<nvars>(prob, u, maintconf);
 		std::cout << "\nSet up explicit forward Euler temporal scheme for main solve.\n";
 	}
 
 	isol.mfjac.set_spatial(prob);
 
 	// Solve the main problem
+	TimingData tdata{};
 	try {
 		ierr = time->solve(u);
+		petsc_throw(ierr, "Nonlinear solver failed!");
+		std::cout << "***\n";
+		tdata = time->getTimingData();
+	}
+	catch(Tolerance_error& e) {
+		// the solver records its timing data before throwing
+		std::cout << "FVENS: Main solve did not converge: " << e.what() << std::endl;
+		tdata = time->getTimingData();
+		tdata.converged = false;
 	}
 	catch(Numerical_error& e) {
 		std::cout << "FVENS: Main solve failed: " << e.what() << std::endl;
-		TimingData tdata; tdata.converged = false;
-		delete time;
-		return tdata;
+		tdata.converged = false;
 	}
 
-	petsc_throw(ierr, "Nonlinear solver failed!");
-	std::cout << "***\n";
-
-	TimingData tdata = time->getTimingData();
 #ifdef USE_BLASTED
 	computeTotalTimes(&bctx);
 	tdata.precsetup_walltime = bctx.factorwalltime;
@@ -362,24 +496,121 @@ int SteadyFlowCase::execute(const Spatial<a_real,NVARS> *const prob, Vec u) cons
 	return ierr;
 }
 
+int SteadyFlowCase::execute(const Spatial<a_real,NVARS+1> *const prob, Vec u) const
+{
+	int ierr = 0;
+	
+	ierr = execute_starter(prob, u); fvens_throw(ierr, "Startup solve failed!");
+	TimingData td = execute_main(prob, u); fvens_throw(ierr, "Steady case solver failed!");
+	if(!td.converged)
+		throw Tolerance_error("Main flow solve did not converge!");
+
+	return ierr;
+}
+
 UnsteadyFlowCase::UnsteadyFlowCase(const FlowParserOptions& options)
 	: FlowCase(options)
 { }
 
+template <int nvars>
+TimingData UnsteadyFlowCase::solveTVDRK(const Spatial<a_real,nvars> *const prob, Vec u) const
+{
+	TVDRKSolver<nvars> time(prob, u, opts.time_order, opts.logfile, opts.phy_cfl);
+	int ierr = time.solve(opts.final_time);
+	fvens_throw(ierr, "TVDRK solve failed!");
+	return time.getTimingData();
+}
+
+TimeStepControlConfig UnsteadyFlowCase::timeStepControlConfig() const
+{
+	const TimeStepControlConfig tconf {
+		opts.phy_errtol > 0, opts.phy_timestep, opts.phy_errtol, opts.phy_abserrtol,
+		opts.phy_maxtimestep
+	};
+	return tconf;
+}
+
+template <int nvars>
+TimingData UnsteadyFlowCase::solveEmbeddedRK(const Spatial<a_real,nvars> *const prob, Vec u) const
+{
+	const TimeStepControlConfig tconf = timeStepControlConfig();
+	EmbeddedRKSolver<nvars> time(prob, u, tconf, opts.logfile, opts.phy_cfl);
+	int ierr = time.solve(opts.final_time);
+	fvens_throw(ierr, "Embedded RK solve failed!");
+	return time.getTimingData();
+}
+
+template <int nvars>
+TimingData UnsteadyFlowCase::solveESDIRK(const Spatial<a_real,nvars> *const prob, Vec u) const
+{
+	int ierr = 0;
+	TimingData tdata;
+	const TimeStepControlConfig tconf = timeStepControlConfig();
+
+	const bool use_mfjac = parsePetscCmd_isDefined("-matrix_free_jacobian");
+	LinearProblemLHS<nvars> isol = setupImplicitSolver<nvars>(prob->mesh(), use_mfjac);
+	isol.mfjac.set_spatial(prob);
+
+	ierr = setup_subdomain_pc<nvars>(isol.ksp,u,prob);
+	fvens_throw(ierr, "Sub-domain preconditioner not setup");
+#ifdef USE_BLASTED
+	Blasted_data_list bctx = newBlastedDataList();
+	ierr = setup_blasted<nvars>(isol.ksp,u,prob,bctx); fvens_throw(ierr, "BLASTed not setup");
+#endif
+	ierr = setup_polynomial_pc<nvars>(isol.ksp,u,prob);
+	fvens_throw(ierr, "Polynomial preconditioner not setup");
+
+	{
+		ESDIRKSolver<nvars> time(prob, u, tconf, isol.ksp, opts.logfile);
+		ierr = time.solve(opts.final_time);
+		fvens_throw(ierr, "ESDIRK solve failed!");
+		tdata = time.getTimingData();
+	}
+
+	ierr = isol.destroy(); petsc_throw(ierr, "Could not destroy implicit solver");
+#ifdef USE_BLASTED
+	destroyBlastedDataList(&bctx);
+#endif
+	return tdata;
+}
+
 /** \todo Implement an unsteady integrator factory and use that here.
  */
+template <int nvars>
+TimingData UnsteadyFlowCase::solveUnsteady(const Spatial<a_real,nvars> *const prob, Vec u) const
+{
+	if(opts.time_integrator == "TVDRK")
+		return solveTVDRK(prob, u);
+	else if(opts.time_integrator == "RK32")
+		return solveEmbeddedRK(prob, u);
+	else if(opts.time_integrator == "ESDIRK")
+		return solveESDIRK(prob, u);
+	else
+		throw std::runtime_error("Unknown time integrator " + opts.time_integrator);
+}
+
+int UnsteadyFlowCase::execute_starter(const Spatial<a_real,NVARS> *const, Vec) const
+{
+	return 0;
+}
+
+TimingData UnsteadyFlowCase::execute_main(const Spatial<a_real,NVARS> *const prob, Vec u) const
+{
+	return solveUnsteady(prob, u);
+}
+
+int UnsteadyFlowCase::execute(const Spatial<a_real,NVARS+1> *const prob, Vec u) const
+{
+	solveUnsteady(prob, u);
+	return 0;
+}
+
 int UnsteadyFlowCase::execute(const Spatial<a_real,NVARS> *const prob, Vec u) const
 {
 	int ierr = 0;
 
-	if(opts.time_integrator == "TVDRK") {
-		TVDRKSolver<NVARS> time(prob, u, opts.time_order, opts.logfile, opts.phy_cfl);
-		ierr = time.solve(opts.final_time);
-		CHKERRQ(ierr);
-		return ierr;
-	} else {
-		throw "Nothing but TVDRK is implemented yet!";
-	}
+	solveUnsteady(prob, u);
+	return ierr;
 	
 	// physical configuration
 	const FlowPhysicsConfig pconf = extract_spatial_physics_config(opts);
@@ -467,6 +698,10 @@ int UnsteadyFlowCase::execute(const Spatial<a_real,NVARS> *const prob, Vec u) co
 
 	ierr = KSPSetFromOptions(ksp); CHKERRQ(ierr);
 
+	if(opts.pseudotimetype == "IMPLICIT") {
+		ierr = setup_subdomain_pc<NVARS>(ksp,u,startprob); CHKERRQ(ierr);
+	}
+
 	// setup BLASTed preconditioning if requested
 #ifdef USE_BLASTED
 	Blasted_data_list bctx = newBlastedDataList();
@@ -474,6 +709,9 @@ int UnsteadyFlowCase::execute(const Spatial<a_real,NVARS> *const prob, Vec u) co
 		ierr = setup_blasted<NVARS>(ksp,u,startprob,bctx); CHKERRQ(ierr);
 	}
 #endif
+	if(opts.pseudotimetype == "IMPLICIT") {
+		ierr = setup_polynomial_pc<NVARS>(ksp,u,startprob); CHKERRQ(ierr);
+	}
 
 	std::cout << "***\n";
 
@@ -503,12 +741,18 @@ int UnsteadyFlowCase::execute(const Spatial<a_real,NVARS> *const prob, Vec u) co
 		CHKERRQ(ierr);
 	}
 	ierr = KSPSetFromOptions(ksp); CHKERRQ(ierr);
+	if(opts.pseudotimetype == "IMPLICIT") {
+		ierr = setup_subdomain_pc<NVARS>(ksp,u,startprob); CHKERRQ(ierr);
+	}
 #ifdef USE_BLASTED
 	bctx = newBlastedDataList();
 	if(opts.pseudotimetype == "IMPLICIT") {
 		ierr = setup_blasted<NVARS>(ksp,u,startprob,bctx); CHKERRQ(ierr);
 	}
 #endif
+	if(opts.pseudotimetype == "IMPLICIT") {
+		ierr = setup_polynomial_pc<NVARS>(ksp,u,startprob); CHKERRQ(ierr);
+	}
 
 	// setup nonlinear ODE solver for main solve - MUST be done AFTER KSPCreate
 	if(opts.pseudotimetype == "IMPLICIT")
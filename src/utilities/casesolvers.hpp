@@ -50,11 +50,24 @@ struct FlowSolutionFunctionals
 UMesh2dh<a_real> constructMesh(const FlowParserOptions& opts, const std::string mesh_suffix);
 
 /// Create a spatial discretization context for the flow problem
+/** Only for laminar flow or inviscid flow; see \ref createTurbulentFlowSpatial.
+ */
 const FlowFV_base<a_real>* createFlowSpatial(const FlowParserOptions& opts,
                                              const UMesh2dh<a_real>& m);
 
+/// Create a spatial discretization context for turbulent flow, with the turbulence model's
+///  working variable as the last variable
+const FlowFV_base<a_real,NVARS+1>* createTurbulentFlowSpatial(const FlowParserOptions& opts,
+                                                             const UMesh2dh<a_real>& m);
+
+/// Number of PDEs (conserved variables per cell) of the flow problem in the control file options
+int getNumberOfFlowVariables(const FlowParserOptions& opts);
+
 /// Allocate a vector of size number of cells times the number of PDEs, and initialize it with
 ///  free-stream values from control file options
+/** For turbulent flow, the last variable is initialized with the free-stream value of the
+ * turbulence model's working variable.
+ */
 int initializeSystemVector(const FlowParserOptions& opts, const UMesh2dh<a_real>& m, Vec *const u);
 
 /// Solve a flow problem, either steady or unsteady, with conditions specified in the FVENS control file
@@ -97,6 +110,12 @@ public:
 	 */
 	virtual int execute(const Spatial<a_real,NVARS> *const prob, Vec u) const = 0;
 
+	/// Solve a turbulent case given a spatial discretization context
+	/** Throws an exception by default; case types that support turbulent flow override this.
+	 * \return An error code (may also throw exceptions)
+	 */
+	virtual int execute(const Spatial<a_real,NVARS+1> *const prob, Vec u) const;
+
 	/// Solve a startup problem corresponding to the actual problem to be solved
 	/**
 	 * Should set up all the implicit solver objects it needs and destroy them after it's done.
@@ -118,11 +137,12 @@ protected:
 	const FlowParserOptions& opts;
 
 	/// Objects required for time-implicit solution
+	template <int nvars>
 	struct LinearProblemLHS {
 		Mat A;                                  ///< System Jacobian matrix
 		Mat M;                                  ///< System preconditioning matrix
 		KSP ksp;                                ///< Linear solver context
-		MatrixFreeSpatialJacobian<NVARS> mfjac; ///< Matrix-free system Jacobian (used iff requested)
+		MatrixFreeSpatialJacobian<nvars> mfjac; ///< Matrix-free system Jacobian (used iff requested)
 		bool mf_flg;                            ///< Whether matrix-free Jacobian has been requested
 
 		/// Destroy all components of linear problem LHS
@@ -143,10 +163,13 @@ protected:
 	 * \param[in] use_mfjac Whether a matrix-free Jacobian should be set up (true) or not (false)
 	 * \return Objects required for implicit solution of the problem
 	 */
-	static LinearProblemLHS setupImplicitSolver(const UMesh2dh<a_real> *const mesh, const bool use_mfjac);
+	template <int nvars>
+	static LinearProblemLHS<nvars> setupImplicitSolver(const UMesh2dh<a_real> *const mesh,
+	                                                   const bool use_mfjac);
 
 	/// Sets up only the KSP context, assuming the Mats have been set up
-	static void setupKSP(LinearProblemLHS& solver, const bool use_matrix_free);
+	template <int nvars>
+	static void setupKSP(LinearProblemLHS<nvars>& solver, const bool use_matrix_free);
 };
 
 /// Solution procedure for a steady-state case
@@ -181,14 +204,35 @@ public:
 	 */
 	TimingData execute_main(const Spatial<a_real,NVARS> *const prob, Vec u) const;
 
+	/// Solve a turbulent case given a spatial discretization context
+	/** Same as for laminar flow, with the turbulence model coupled to the flow in every solve.
+	 */
+	int execute(const Spatial<a_real,NVARS+1> *const prob, Vec u) const;
+
+	/// Solve the 1st-order turbulent problem corresponding to the actual problem
+	int execute_starter(const Spatial<a_real,NVARS+1> *const prob, Vec u) const;
+
+	/// Solve the steady-state turbulent problem from some (decent) initial condition
+	TimingData execute_main(const Spatial<a_real,NVARS+1> *const prob, Vec u) const;
+
 protected:
 
 	const bool mf_flg;
+
+	/// Implementation of \ref execute_starter for any number of variables
+	template <int nvars>
+	int solveStarter(const Spatial<a_real,nvars> *const prob, Vec u) const;
+
+	/// Implementation of \ref execute_main for any number of variables
+	template <int nvars>
+	TimingData solveMain(const Spatial<a_real,nvars> *const prob, Vec u) const;
 };
 
 /// Solution procedure for an unsteady flow case
 /** To use, one should just call either \ref FlowCase::run or \ref FlowCase::run_output.
- * Currently only TVD RK time integration is supported.
+ * The time integrators are TVD RK ("TVDRK") with CFL-limited time steps, and the embedded
+ * Runge-Kutta ("RK32") and ESDIRK ("ESDIRK") schemes, whose time steps can be adapted to an
+ * error tolerance.
  */
 class UnsteadyFlowCase : public FlowCase
 {
@@ -198,6 +242,39 @@ public:
 
 	/// Solve a case given a spatial discretization context
 	int execute(const Spatial<a_real,NVARS> *const prob, Vec u) const;
+
+	/// Solve a turbulent case given a spatial discretization context
+	int execute(const Spatial<a_real,NVARS+1> *const prob, Vec u) const;
+
+	/// Does nothing, since an unsteady case starts from its initial condition
+	int execute_starter(const Spatial<a_real,NVARS> *const prob, Vec u) const;
+
+	/// Integrates in time from the initial condition in u up to the final time
+	/** \return The number of time steps and timing data; with the RK32 and ESDIRK integrators,
+	 *   also the number of rejected steps, and the largest error estimate and the smallest time
+	 *   step of the accepted steps.
+	 */
+	TimingData execute_main(const Spatial<a_real,NVARS> *const prob, Vec u) const;
+
+protected:
+	/// Integrates in time with the chosen time integrator
+	template <int nvars>
+	TimingData solveUnsteady(const Spatial<a_real,nvars> *const prob, Vec u) const;
+
+	/// Integrates in time with a TVD Runge-Kutta scheme
+	template <int nvars>
+	TimingData solveTVDRK(const Spatial<a_real,nvars> *const prob, Vec u) const;
+
+	/// Integrates in time with the explicit embedded Runge-Kutta scheme
+	template <int nvars>
+	TimingData solveEmbeddedRK(const Spatial<a_real,nvars> *const prob, Vec u) const;
+
+	/// Integrates in time with the implicit ESDIRK scheme
+	template <int nvars>
+	TimingData solveESDIRK(const Spatial<a_real,nvars> *const prob, Vec u) const;
+
+	/// Time step control settings from the control file options
+	TimeStepControlConfig timeStepControlConfig() const;
 };
 
 }
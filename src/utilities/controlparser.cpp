@@ -109,6 +109,28 @@ FlowParserOptions parse_flow_controlfile(const int argc, const char *const argv[
 	opts.logfile = infopts.get<std::string>(c_io+".log_file_prefix");
 	opts.lognres = infopts.get<bool>(c_io+".convergence_history_required");
 
+	// optional output of selected fields
+	opts.fieldout.precision = FLOAT32;
+	if(infopts.get_child_optional(c_io+".field_output")) {
+		const std::string c_fo = c_io+".field_output";
+		opts.fieldout.file = infopts.get<std::string>(c_fo+".file");
+		opts.fieldout.fields
+			= parseStringToVector<std::string>(infopts.get<std::string>(c_fo+".fields"));
+		for(const std::string& name : opts.fieldout.fields)
+			fvens_throw(getOutputFieldComponents(name) == 0, "Unknown output field " + name);
+		opts.fieldout.precision
+			= parseOutputPrecision(infopts.get<std::string>(c_fo+".precision", "float32"));
+		auto optbox = infopts.get_optional<std::string>(c_fo+".box");
+		if(optbox) {
+			opts.fieldout.box = parseStringToVector<a_real>(*optbox);
+			fvens_throw(opts.fieldout.box.size() != 2*NDIM,
+			            "The field output box needs lower and upper bounds in each direction!");
+		}
+		auto opttags = infopts.get_optional<std::string>(c_fo+".region_tags");
+		if(opttags)
+			opts.fieldout.regiontags = parseStringToVector<int>(*opttags);
+	}
+
 	opts.flowtype = get_upperCaseString(infopts, c_flowconds+".flow_type");
 	opts.gamma = infopts.get<a_real>(c_flowconds+".adiabatic_index");
 	opts.alpha = PI/180.0*infopts.get<a_real>(c_flowconds+".angle_of_attack");
@@ -120,6 +142,12 @@ FlowParserOptions parse_flow_controlfile(const int argc, const char *const argv[
 		opts.Pr = infopts.get<a_real>(c_flowconds+".Prandtl_number");
 		opts.useconstvisc = infopts.get(c_flowconds+".use_constant_viscosity",false);
 	}
+	opts.turbulence_model = boost::to_upper_copy<std::string>(
+		infopts.get<std::string>(c_flowconds+".turbulence_model", "NONE"));
+	fvens_throw(opts.turbulence_model != "NONE" && opts.turbulence_model != "SA",
+	            "Unknown turbulence model " + opts.turbulence_model);
+	fvens_throw(opts.turbulence_model == "SA" && !opts.viscsim,
+	            "A turbulence model needs Navier-Stokes flow!");
 
 	opts.bcconf = parse_BC_options(infopts, c_bcs);
 
@@ -151,12 +179,22 @@ FlowParserOptions parse_flow_controlfile(const int argc, const char *const argv[
 	{
 		opts.final_time = infopts.get<a_real>(c_phy_time+".final_time");
 		opts.time_integrator = get_upperCaseString(infopts, c_phy_time + ".time_integrator");
-		opts.time_order = infopts.get<int>(c_phy_time + ".temporal_order");
 
-		if(opts.time_integrator == "TVDRK")
+		if(opts.time_integrator == "TVDRK") {
+			opts.time_order = infopts.get<int>(c_phy_time + ".temporal_order");
 			opts.phy_cfl = infopts.get<a_real>(c_phy_time+".physical_cfl");
-		else
+		}
+		else {
+			// the error-controlled integrators have a fixed order
+			opts.time_order = infopts.get<int>(c_phy_time + ".temporal_order",
+			                                   opts.time_integrator == "RK32" ? 3 : 2);
 			opts.phy_timestep = infopts.get<a_real>(c_phy_time+".physical_time_step");
+			opts.phy_cfl = infopts.get<a_real>(c_phy_time+".physical_cfl", 0.0);
+			opts.phy_errtol = infopts.get<a_real>(c_phy_time+".error_tolerance", 0.0);
+			opts.phy_abserrtol = infopts.get<a_real>(c_phy_time+".error_abs_tolerance",
+			                                         opts.phy_errtol);
+			opts.phy_maxtimestep = infopts.get<a_real>(c_phy_time+".max_time_step", 0.0);
+		}
 	}
 
 	opts.invflux = get_upperCaseString(infopts, c_spatial+".inviscid_flux");
@@ -164,6 +202,14 @@ FlowParserOptions parse_flow_controlfile(const int argc, const char *const argv[
 	if(opts.gradientmethod == "NONE")
 		opts.order2 = false;
 	opts.limiter = get_upperCaseString(infopts, c_spatial+".limiter");
+	opts.lowmach_cutoff = 0;
+	if(infopts.get<bool>(c_spatial+".low_mach_preconditioning", false)) {
+		opts.lowmach_cutoff = infopts.get<a_real>(c_spatial+".low_mach_cutoff", 1.0);
+		fvens_throw(opts.lowmach_cutoff <= 0, "The low-Mach cut-off must be positive!");
+		// the preconditioned dissipation and time steps are not time-accurate
+		fvens_throw(opts.sim_type == "UNSTEADY",
+		            "Low-Mach preconditioning is only available for steady problems!");
+	}
 
 	opts.pseudotimetype = get_upperCaseString(infopts, c_pseudotime+".pseudotime_stepping_type");
 
@@ -171,15 +217,20 @@ FlowParserOptions parse_flow_controlfile(const int argc, const char *const argv[
 	opts.endcfl = infopts.get<a_real>(c_pseudotime+"."+pt_main+".cfl_max");
 	opts.tolerance = infopts.get<a_real>(c_pseudotime+"."+pt_main+".tolerance");
 	opts.maxiter = infopts.get<int>(c_pseudotime+"."+pt_main+".max_timesteps");
+	// only used by a linear CFL ramp
+	opts.rampstart = infopts.get<int>(c_pseudotime+"."+pt_main+".cfl_ramp_start", 0);
+	opts.rampend = infopts.get<int>(c_pseudotime+"."+pt_main+".cfl_ramp_end", 0);
 	if(infopts.get_child_optional(c_pseudotime+"."+pt_init)) {
 		opts.usestarter = 1;
 		opts.firstinitcfl = infopts.get<a_real>(c_pseudotime+"."+pt_init+".cfl_min");
 		opts.firstendcfl = infopts.get<a_real>(c_pseudotime+"."+pt_init+".cfl_max");
 		opts.firsttolerance = infopts.get<a_real>(c_pseudotime+"."+pt_init+".tolerance");
 		opts.firstmaxiter = infopts.get<int>(c_pseudotime+"."+pt_init+".max_timesteps");
+		opts.firstrampstart = infopts.get<int>(c_pseudotime+"."+pt_init+".cfl_ramp_start", 0);
+		opts.firstrampend = infopts.get<int>(c_pseudotime+"."+pt_init+".cfl_ramp_end", 0);
 	}
 
-	if(opts.pseudotimetype == "IMPLICIT") {
+	if(opts.pseudotimetype == "IMPLICIT" || opts.time_integrator == "ESDIRK") {
 		opts.invfluxjac = get_upperCaseString(infopts, "Jacobian_inviscid_flux");
 		if(opts.invfluxjac == "CONSISTENT")
 			opts.invfluxjac = opts.invflux;
@@ -192,6 +243,24 @@ FlowParserOptions parse_flow_controlfile(const int argc, const char *const argv[
 	if(set)
 		opts.logfile = petsclogfile;
 
+	// the CFL range of the main solve can be overridden eg. by a tuned PETSc options file
+	PetscReal cflval = 0;
+	PetscOptionsGetReal(NULL, NULL, "-fvens_main_cfl_min", &cflval, &set);
+	if(set)
+		opts.initcfl = cflval;
+	PetscOptionsGetReal(NULL, NULL, "-fvens_main_cfl_max", &cflval, &set);
+	if(set)
+		opts.endcfl = cflval;
+
+	// a cheaper flux for the approximate Jacobian can be chosen in the same way
+	char jacflux[50];
+	PetscOptionsGetString(NULL, NULL, "-fvens_jacobian_inviscid_flux", jacflux, 50, &set);
+	if(set) {
+		opts.invfluxjac = boost::to_upper_copy<std::string>(jacflux);
+		if(opts.invfluxjac == "CONSISTENT")
+			opts.invfluxjac = opts.invflux;
+	}
+
 	return opts;
 }
 
@@ -199,7 +268,7 @@ FlowPhysicsConfig extract_spatial_physics_config(const FlowParserOptions& opts)
 {
 	const FlowPhysicsConfig pconf { 
 		opts.gamma, opts.Minf, opts.Tinf, opts.Reinf, opts.Pr, opts.alpha,
-		opts.viscsim, opts.useconstvisc, opts.bcconf
+		opts.viscsim, opts.useconstvisc, opts.bcconf, opts.turbulence_model
 	};
 	return pconf;
 }
@@ -207,14 +276,14 @@ FlowPhysicsConfig extract_spatial_physics_config(const FlowParserOptions& opts)
 FlowNumericsConfig extract_spatial_numerics_config(const FlowParserOptions& opts)
 {
 	const FlowNumericsConfig nconf {opts.invflux, opts.invfluxjac, 
-		opts.gradientmethod, opts.limiter, opts.limiter_param, opts.order2};
+		opts.gradientmethod, opts.limiter, opts.limiter_param, opts.order2, opts.lowmach_cutoff};
 	return nconf;
 }
 
 FlowNumericsConfig firstorder_spatial_numerics_config(const FlowParserOptions& opts)
 {
 	const FlowNumericsConfig nconf {opts.invflux, opts.invfluxjac, 
-		"NONE", "NONE", 1.0 , false};
+		"NONE", "NONE", 1.0 , false, opts.lowmach_cutoff};
 	return nconf;
 }
 
@@ -12,6 +12,7 @@
 #include <boost/program_options/variables_map.hpp>
 #include "aconstants.hpp"
 #include "spatial/flow_spatial.hpp"
+#include "spatial/aoutput.hpp"
 
 namespace fvens {
 
@@ -30,7 +31,8 @@ struct FlowParserOptions
 		vol_output_reqd,                   ///< Whether volume output is required in a text file
 		                                   ///<  in addition to the main VTU output
 		sim_type,                          ///< Steady or unsteady simulation
-		time_integrator;                   ///< Physical time discretization scheme
+		time_integrator,                   ///< Physical time discretization scheme
+		turbulence_model;                  ///< NONE or SA (Spalart-Allmaras)
 	
 	a_real initcfl, endcfl,                  ///< Starting CFL number and max CFL number
 		tolerance,                           ///< Relative tolerance for the whole nonlinear problem
@@ -39,9 +41,14 @@ struct FlowParserOptions
 		Minf, alpha, Reinf, Tinf,            ///< Free-stream flow properties
 		Pr, gamma,                           ///< Non-dimensional constants Prandtl no., adia. index
 		limiter_param,                       ///< Parameter controlling some limiters
+		lowmach_cutoff,                      ///< Cut-off of low-Mach preconditioning, 0 if unused
 		final_time,                          ///< Physical time upto which to simulate
-		phy_timestep,                        ///< Constant physical time step for unsteady implicit
-		phy_cfl;                             ///< CFL used only by unsteady explicit solvers
+		phy_timestep,                        ///< Constant or initial physical time step
+		phy_cfl,                             ///< CFL used only by unsteady explicit solvers
+		phy_errtol,                          ///< Relative tolerance on the local error of a time
+		                                     ///<  step; the time step is adaptive if positive
+		phy_abserrtol,                       ///< Absolute tolerance on the local error of a step
+		phy_maxtimestep;                     ///< Largest physical time step if positive
 	
 	int maxiter, 
 		rampstart, rampend, 
@@ -63,6 +70,8 @@ struct FlowParserOptions
 	
 	std::vector<int> lwalls,         ///< List of wall boundary markers for output
 		lothers;                     ///< List of other boundary markers for output
+
+	FieldOutputConfig fieldout;      ///< Selection of fields for compact binary output
 };
 
 /// Reads a control file for flow problems
@@ -0,0 +1,225 @@
+/** @file historylog.cpp
+ * @brief Implementation of the memory-mapped binary convergence history
+ * @author Aditya Kashi
+ */
+
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <iomanip>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <petscsys.h>
+
+#include "historylog.hpp"
+#include "aoptionparser.hpp"
+#include "aerrorhandling.hpp"
+
+namespace fvens {
+
+static_assert(sizeof(HistoryHeader) == 64, "History header must be 64 bytes");
+static_assert(sizeof(HistoryRecord) % 8 == 0, "History records must be 8-byte aligned");
+
+static const char history_magic[8] = {'F','V','E','N','S','H','S','T'};
+static const uint32_t history_version = 1;
+
+HistoryRecord emptyHistoryRecord()
+{
+	const double nan = std::numeric_limits<double>::quiet_NaN();
+	HistoryRecord rec;
+	rec.step = 0;
+	rec.linear_iters = 0;
+	rec.wall_time = rec.linear_wall_time = rec.cfl = rec.phys_time = rec.timestep = nan;
+	rec.rel_residual = rec.abs_residual = nan;
+	for(int i = 0; i < HISTORY_MAX_VARS; i++)
+		rec.residual[i] = nan;
+	for(int i = 0; i < HISTORY_NUM_FORCES; i++)
+		rec.forces[i] = nan;
+	return rec;
+}
+
+/// Whether an existing header describes a file that can be appended to
+static bool isCompatible(const HistoryHeader& h, const int nvars, const uint64_t capacity)
+{
+	return std::memcmp(h.magic, history_magic, 8) == 0 && h.version == history_version
+		&& h.recordsize == sizeof(HistoryRecord) && h.capacity == capacity
+		&& h.nvars == static_cast<uint32_t>(nvars);
+}
+
+HistoryLog::HistoryLog(const std::string filename, const int nvars, const uint64_t cap)
+	: capacity{cap}
+{
+	fvens_throw(nvars < 1 || nvars > HISTORY_MAX_VARS,
+	            "Number of variables not supported by the history log");
+	fvens_throw(capacity == 0, "History log capacity must be positive");
+
+	fd = open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+	fvens_throw(fd < 0, "Could not open history file " + filename);
+
+	mapsize = sizeof(HistoryHeader) + capacity*sizeof(HistoryRecord);
+
+	HistoryHeader existing;
+	std::memset(&existing, 0, sizeof(HistoryHeader));
+	const bool append = pread(fd, &existing, sizeof(HistoryHeader), 0)
+			== static_cast<ssize_t>(sizeof(HistoryHeader))
+		&& isCompatible(existing, nvars, capacity);
+
+	if(!append) {
+		// discard whatever was there; the new size zero-fills the file
+		if(ftruncate(fd, 0) != 0 || ftruncate(fd, mapsize) != 0) {
+			close(fd);
+			fvens_throw(true, "Could not resize history file " + filename);
+		}
+	}
+
+	void *const map = mmap(NULL, mapsize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if(map == MAP_FAILED) {
+		close(fd);
+		fvens_throw(true, "Could not map history file " + filename);
+	}
+	header = reinterpret_cast<HistoryHeader*>(map);
+	records = reinterpret_cast<HistoryRecord*>(reinterpret_cast<char*>(map)
+	                                           + sizeof(HistoryHeader));
+
+	if(!append) {
+		header->version = history_version;
+		header->recordsize = sizeof(HistoryRecord);
+		header->capacity = capacity;
+		header->nvars = nvars;
+		__atomic_store_n(&header->started, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&header->count, 0, __ATOMIC_RELAXED);
+		// the magic is written last, so that readers never accept a half-initialized header
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+		std::memcpy(header->magic, history_magic, 8);
+	}
+	else {
+		// a writer that died while appending may have left started ahead of count
+		__atomic_store_n(&header->started, header->count, __ATOMIC_RELAXED);
+	}
+}
+
+HistoryLog::~HistoryLog()
+{
+	msync(header, mapsize, MS_ASYNC);
+	munmap(header, mapsize);
+	close(fd);
+}
+
+void HistoryLog::append(const HistoryRecord& rec)
+{
+	const uint64_t k = __atomic_load_n(&header->count, __ATOMIC_RELAXED);
+
+	/* Announce that slot k%capacity, which holds record k-capacity, is about to be overwritten.
+	 * The release fence orders this store before the stores to the slot.
+	 */
+	__atomic_store_n(&header->started, k+1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	std::memcpy(&records[k % capacity], &rec, sizeof(HistoryRecord));
+
+	// publish the record
+	__atomic_store_n(&header->count, k+1, __ATOMIC_RELEASE);
+}
+
+uint64_t HistoryLog::numRecords() const
+{
+	return __atomic_load_n(&header->count, __ATOMIC_RELAXED);
+}
+
+HistoryLog *createHistoryLog(const std::string prefix, const int nvars)
+{
+	if(!parsePetscCmd_isDefined("-convergence_history_binary"))
+		return nullptr;
+
+	int mpirank;
+	MPI_Comm_rank(PETSC_COMM_WORLD, &mpirank);
+	if(mpirank != 0)
+		return nullptr;
+
+	const int capacity = parsePetscCmd_isDefined("-convergence_history_capacity") ?
+		parsePetscCmd_int("-convergence_history_capacity") : 65536;
+	fvens_throw(capacity <= 0, "History log capacity must be positive");
+
+	return new HistoryLog(prefix+".hist", nvars, capacity);
+}
+
+std::vector<HistoryRecord> readHistory(const std::string filename, int& nvars, uint64_t& first)
+{
+	const int fd = open(filename.c_str(), O_RDONLY);
+	fvens_throw(fd < 0, "Could not open history file " + filename);
+
+	struct stat st;
+	HistoryHeader h;
+	if(fstat(fd, &st) != 0
+	   || pread(fd, &h, sizeof(HistoryHeader), 0) != static_cast<ssize_t>(sizeof(HistoryHeader))
+	   || std::memcmp(h.magic, history_magic, 8) != 0 || h.version != history_version
+	   || h.recordsize != sizeof(HistoryRecord) || h.capacity == 0
+	   || h.nvars < 1 || h.nvars > static_cast<uint32_t>(HISTORY_MAX_VARS)
+	   || static_cast<uint64_t>(st.st_size)
+	      < sizeof(HistoryHeader) + h.capacity*sizeof(HistoryRecord))
+	{
+		close(fd);
+		fvens_throw(true, filename + " is not a compatible history file");
+	}
+
+	const uint64_t capacity = h.capacity;
+	nvars = h.nvars;
+	const size_t mapsize = sizeof(HistoryHeader) + capacity*sizeof(HistoryRecord);
+	void *const map = mmap(NULL, mapsize, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	fvens_throw(map == MAP_FAILED, "Could not map history file " + filename);
+
+	HistoryHeader *const header = reinterpret_cast<HistoryHeader*>(map);
+	const HistoryRecord *const records = reinterpret_cast<const HistoryRecord*>(
+		reinterpret_cast<char*>(map) + sizeof(HistoryHeader));
+
+	// the records completely written so far
+	const uint64_t count = __atomic_load_n(&header->count, __ATOMIC_ACQUIRE);
+	first = count > capacity ? count-capacity : 0;
+
+	std::vector<HistoryRecord> recs(count-first);
+	for(uint64_t k = first; k < count; k++)
+		std::memcpy(&recs[k-first], &records[k % capacity], sizeof(HistoryRecord));
+
+	/* Drop the records whose slots the writer began to overwrite while we were copying. Pairs
+	 * with the release fence in HistoryLog::append.
+	 */
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	const uint64_t started = __atomic_load_n(&header->started, __ATOMIC_RELAXED);
+	munmap(map, mapsize);
+
+	if(started > first + capacity) {
+		const uint64_t ndrop = std::min<uint64_t>(started - capacity - first, recs.size());
+		recs.erase(recs.begin(), recs.begin() + ndrop);
+		first += ndrop;
+	}
+
+	return recs;
+}
+
+void writeHistoryCSV(const std::vector<HistoryRecord>& recs, const int nvars, std::ostream& out)
+{
+	out << "step,linear_iters,wall_time,linear_wall_time,cfl,phys_time,timestep,"
+	    << "rel_residual,abs_residual";
+	for(int i = 0; i < nvars; i++)
+		out << ",residual_" << i;
+	out << ",CL,CDp,CDf\n";
+
+	out << std::setprecision(std::numeric_limits<double>::digits10);
+	for(const HistoryRecord& r : recs)
+	{
+		out << r.step << ',' << r.linear_iters << ',' << r.wall_time << ',' << r.linear_wall_time
+		    << ',' << r.cfl << ',' << r.phys_time << ',' << r.timestep << ',' << r.rel_residual
+		    << ',' << r.abs_residual;
+		for(int i = 0; i < nvars; i++)
+			out << ',' << r.residual[i];
+		for(int i = 0; i < HISTORY_NUM_FORCES; i++)
+			out << ',' << r.forces[i];
+		out << '\n';
+	}
+}
+
+}
@@ -0,0 +1,133 @@
+/** \file historylog.hpp
+ * \brief Binary convergence history stored in a memory-mapped ring buffer of fixed-size records
+ * \author Aditya Kashi
+ *
+ * The history file consists of a \ref HistoryHeader followed by a fixed number of
+ * \ref HistoryRecord slots. Record k goes into slot k modulo the capacity, so the file never
+ * grows and only the latest records are retained. The file is mapped into memory, so that
+ * appending a record is a copy into the mapping and does not need any system call; the kernel
+ * writes the pages back to the file on its own. Other processes may map the same file and read
+ * the history of a running solver at any time - see \ref readHistory.
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FVENS_HISTORYLOG_H
+#define FVENS_HISTORYLOG_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <ostream>
+
+namespace fvens {
+
+/// Max number of variables whose residual norms can be stored in a record
+constexpr int HISTORY_MAX_VARS = 8;
+/// Number of force coefficients in a record: lift, pressure drag and skin friction drag
+constexpr int HISTORY_NUM_FORCES = 3;
+
+/// One step of a steady or unsteady solver
+/** Quantities not available to the solver writing the record are NaN.
+ */
+struct HistoryRecord
+{
+	int32_t step;                     ///< Step number, starting from 1 in each solve
+	int32_t linear_iters;             ///< Linear solver iterations used in the step
+	double wall_time;                 ///< Wall-clock time since the beginning of the solve
+	double linear_wall_time;          ///< Wall-clock time taken by linear solves in this step
+	double cfl;                       ///< Pseudo-time CFL number
+	double phys_time;                 ///< Physical time at the end of the step
+	double timestep;                  ///< Physical time step
+	double rel_residual;              ///< Residual norm relative to the initial one
+	double abs_residual;              ///< Residual norm
+	double residual[HISTORY_MAX_VARS];        ///< Residual norm of each variable
+	double forces[HISTORY_NUM_FORCES];        ///< Force coefficients
+};
+
+/// Metadata at the beginning of a history file
+struct HistoryHeader
+{
+	char magic[8];                    ///< Always "FVENSHST"
+	uint32_t version;                 ///< Layout version of the file
+	uint32_t recordsize;              ///< Size in bytes of a \ref HistoryRecord
+	uint64_t capacity;                ///< Number of record slots in the file
+	uint32_t nvars;                   ///< Number of meaningful entries in HistoryRecord::residual
+	uint32_t reserved0;
+	/// Number of records whose writing has begun; only accessed atomically
+	uint64_t started;
+	/// Number of records completely written; only accessed atomically
+	uint64_t count;
+	char reserved[16];
+};
+
+/// Returns a record in which every quantity is NaN and the integers are zero
+HistoryRecord emptyHistoryRecord();
+
+/// Appends records to a memory-mapped history file
+/** If the file exists and has the same layout and capacity, records are appended to it (so that
+ * successive solves with the same log file prefix share one history, as with the text logs);
+ * otherwise, it is created or overwritten. Only one process may write a history file at a time.
+ */
+class HistoryLog
+{
+public:
+	/// Maps a history file, throwing an exception if that is not possible
+	/** \param filename Name of the history file
+	 * \param num_vars Number of variables whose residuals are stored, at most HISTORY_MAX_VARS
+	 * \param capacity Number of records retained in the ring buffer
+	 */
+	HistoryLog(const std::string filename, const int num_vars, const uint64_t capacity);
+
+	~HistoryLog();
+
+	/// Copies a record into the next slot
+	/** Readers see the record only after it is completely written.
+	 */
+	void append(const HistoryRecord& rec);
+
+	/// Number of records appended to the file so far, including those overwritten
+	uint64_t numRecords() const;
+
+protected:
+	int fd;                           ///< File descriptor of the history file
+	size_t mapsize;                   ///< Size of the mapping in bytes
+	HistoryHeader *header;            ///< Start of the mapping
+	HistoryRecord *records;           ///< Record slots following the header
+	uint64_t capacity;                ///< Number of record slots
+};
+
+/// Creates a history log if the PETSc option `-convergence_history_binary' is given
+/** The log is only created on rank 0, and is written to the file `<prefix>.hist'. The number of
+ * records retained is given by the option `-convergence_history_capacity' (default 65536).
+ * \return The new history log, to be deleted by the caller, or NULL if the history is not needed
+ */
+HistoryLog *createHistoryLog(const std::string prefix, const int nvars);
+
+/// Reads the records currently retained in a history file, oldest first
+/** The file may be written to concurrently; records overwritten while they were being copied
+ * are dropped from the result.
+ * \param filename Name of the history file
+ * \param[out] nvars Number of meaningful residual entries per record
+ * \param[out] first Index, among all records ever appended, of the first record returned
+ */
+std::vector<HistoryRecord> readHistory(const std::string filename, int& nvars, uint64_t& first);
+
+/// Writes history records as comma-separated values with a header line
+void writeHistoryCSV(const std::vector<HistoryRecord>& recs, const int nvars, std::ostream& out);
+
+}
+
+#endif
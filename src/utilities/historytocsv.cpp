@@ -0,0 +1,48 @@
+/** @file historytocsv.cpp
+ * @brief Exports a binary convergence history file as comma-separated values
+ * @author Aditya Kashi
+ *
+ * The history file may belong to a solver that is still running.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include "utilities/historylog.hpp"
+
+using namespace fvens;
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+	if(argc < 2) {
+		cout << "Need: 1. History file, 2. (optional) Output CSV file; default is stdout.\n";
+		return -1;
+	}
+
+	int nvars;
+	uint64_t first;
+	vector<HistoryRecord> recs;
+	try {
+		recs = readHistory(argv[1], nvars, first);
+	}
+	catch(std::exception& e) {
+		cerr << e.what() << endl;
+		return -1;
+	}
+
+	if(argc >= 3) {
+		ofstream outf(argv[2]);
+		if(!outf) {
+			cerr << "Could not open " << argv[2] << endl;
+			return -1;
+		}
+		writeHistoryCSV(recs, nvars, outf);
+	}
+	else
+		writeHistoryCSV(recs, nvars, cout);
+
+	if(first > 0)
+		cerr << "Note: the first " << first << " records were overwritten in the ring buffer.\n";
+	return 0;
+}
@@ -5,9 +5,28 @@
 
 #include "isentropicvortex.hpp"
 #include <cmath>
+#include <fstream>
+#include "utilities/aerrorhandling.hpp"
 
 namespace fvens {
-namespace fvens_tests {
+
+IsenVortexConfig readIsenVortexConfig(const std::string paramfile, const a_real gamma,
+                                      const a_real Minf, const a_real aoa)
+{
+	std::ifstream infile(paramfile);
+	fvens_throw(!infile, "Could not open vortex parameter file " + paramfile);
+	std::string dum;
+	std::array<a_real,2> vcentre;
+	a_real strength, clength, sigma;
+	infile >> dum; infile >> vcentre[0] >> vcentre[1];
+	infile >> dum; infile >> strength;
+	infile >> dum; infile >> clength;
+	infile >> dum; infile >> sigma;
+	infile.close();
+
+	const IsenVortexConfig ivconf {gamma, Minf, vcentre, strength, clength, sigma, aoa};
+	return ivconf;
+}
 
 IsentropicVortexProblem::IsentropicVortexProblem(const IsenVortexConfig config)
 	: conf{config}
@@ -65,4 +84,3 @@ void IsentropicVortexProblem::getInitialConditionAndExactSolution
 }
 
 }
-}
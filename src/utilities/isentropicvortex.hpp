@@ -1,5 +1,5 @@
 /** \file isentropicvortex.hpp
- * \brief Definitions for isentropic vortex test
+ * \brief Initial condition and exact solution of the isentropic vortex problem
  * \author Aditya Kashi
  * \date 2018-05
  */
@@ -8,10 +8,10 @@
 #define FVENS_ISENTROPIC_VORTEX_H
 
 #include <array>
+#include <string>
 #include "mesh/amesh2dh.hpp"
 
-namespace fvens{
-namespace fvens_tests {
+namespace fvens {
 
 /// Physical configuration for the isentropic vortex problem
 struct IsenVortexConfig {
@@ -24,6 +24,16 @@ struct IsenVortexConfig {
 	a_real aoa;                  ///< Angle of attack IN RADIANS
 };
 
+/// Reads the vortex centre, strength, characteristic length and standard deviation from a file
+/** The file has a label line followed by the value(s) for each of them, in that order.
+ * \param paramfile The vortex parameter file
+ * \param gamma Adiabatic index
+ * \param Minf Free-stream Mach number
+ * \param aoa Angle of attack in radians
+ */
+IsenVortexConfig readIsenVortexConfig(const std::string paramfile, const a_real gamma,
+                                      const a_real Minf, const a_real aoa);
+
 /// Specification of isentropic vortex problems solution
 /** Ref: \ref survey_isentropicvortex (Spiegel, Huynh and DeBonis, AIAA)
  */
@@ -57,6 +67,5 @@ protected:
 	                      a_real *const u) const;
 };
 
-}
 }
 #endif
@@ -0,0 +1,314 @@
+/** \file perfcounters.cpp
+ * \brief Implementation of hardware performance counter instrumentation
+ * \author Aditya Kashi
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "perfcounters.hpp"
+#include "aoptionparser.hpp"
+
+namespace fvens {
+
+/// Hardware events counted
+enum PerfEvent {
+	PERFEVENT_CYCLES = 0,
+	PERFEVENT_INSTRUCTIONS,
+	PERFEVENT_LLC_REFERENCES,
+	PERFEVENT_LLC_MISSES,
+	PERFEVENT_NUM
+};
+
+/// Bytes moved from memory per last-level cache miss (one cache line)
+static const double bytes_per_miss = 64.0;
+
+static const char *const stage_names[PERFSTAGE_NUM] = {
+	"residual", "gradient", "limiter", "flux", "jacobian", "lin-solve"
+};
+
+/// Accumulated data of one stage
+struct PerfStageData
+{
+	double walltime;                        ///< Total wall-clock time spent in the stage
+	long long counts[PERFEVENT_NUM];        ///< Total counts of each event in the stage
+	long ncalls;                            ///< Number of times the stage was entered
+	int depth;                              ///< Current nesting depth of the stage
+	double startwtime;                      ///< Wall time at the current (outermost) entry
+	long long startcounts[PERFEVENT_NUM];   ///< Counter values at the current entry
+};
+
+/// State of the instrumentation
+struct PerfCounterState
+{
+	bool enabled = false;                   ///< Whether the instrumentation has been requested
+	bool hwcounters = false;                ///< Whether hardware counters could be opened
+	int fds[PERFEVENT_NUM];                 ///< File descriptors of the counters
+	double peakbandwidth = 0;               ///< Peak memory bandwidth in GB/s, if given
+	double peakipc = 4.0;                   ///< Peak instructions per cycle per core
+	PerfStageData stages[PERFSTAGE_NUM];
+};
+
+static PerfCounterState perfstate;
+
+/// Whether the caller is inside an active parallel region
+static bool inParallelRegion()
+{
+#ifdef _OPENMP
+	return omp_in_parallel();
+#else
+	return false;
+#endif
+}
+
+/// Wall-clock time in seconds from an arbitrary origin
+static double perfWallTime()
+{
+#ifdef _OPENMP
+	return omp_get_wtime();
+#else
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch())
+		.count();
+#endif
+}
+
+#ifdef __linux__
+
+static int openCounter(const unsigned long long config)
+{
+	perf_event_attr attr;
+	std::memset(&attr, 0, sizeof(perf_event_attr));
+	attr.size = sizeof(perf_event_attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = config;
+	attr.disabled = 1;
+	attr.inherit = 1;              // count threads spawned after this point as well
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+static bool openHardwareCounters()
+{
+	const unsigned long long configs[PERFEVENT_NUM] = {
+		PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_REFERENCES, PERF_COUNT_HW_CACHE_MISSES
+	};
+
+	for(int i = 0; i < PERFEVENT_NUM; i++)
+	{
+		perfstate.fds[i] = openCounter(configs[i]);
+		if(perfstate.fds[i] < 0) {
+			std::cout << "! PerfCounters: Could not open hardware counter " << i << ": "
+			          << std::strerror(errno) << ".\n  Check /proc/sys/kernel/perf_event_paranoid."
+			          << " Only wall-clock times will be reported.\n";
+			for(int j = 0; j < i; j++)
+				close(perfstate.fds[j]);
+			return false;
+		}
+	}
+
+	for(int i = 0; i < PERFEVENT_NUM; i++) {
+		ioctl(perfstate.fds[i], PERF_EVENT_IOC_RESET, 0);
+		ioctl(perfstate.fds[i], PERF_EVENT_IOC_ENABLE, 0);
+	}
+	return true;
+}
+
+static void readHardwareCounters(long long *const counts)
+{
+	for(int i = 0; i < PERFEVENT_NUM; i++) {
+		long long val = 0;
+		if(read(perfstate.fds[i], &val, sizeof(long long)) != sizeof(long long))
+			val = 0;
+		counts[i] = val;
+	}
+}
+
+static void closeHardwareCounters()
+{
+	for(int i = 0; i < PERFEVENT_NUM; i++)
+		close(perfstate.fds[i]);
+}
+
+#else
+
+static bool openHardwareCounters()
+{
+	std::cout << "! PerfCounters: Hardware counters are only supported on Linux."
+	          << " Only wall-clock times will be reported.\n";
+	return false;
+}
+
+static void readHardwareCounters(long long *const counts)
+{
+	for(int i = 0; i < PERFEVENT_NUM; i++)
+		counts[i] = 0;
+}
+
+static void closeHardwareCounters()
+{ }
+
+#endif
+
+bool initializePerfCounters()
+{
+	perfstate.enabled = parsePetscCmd_isDefined("-perf_counters");
+	if(!perfstate.enabled)
+		return false;
+
+	perfstate.peakbandwidth = parseOptionalPetscCmd_real("-perf_peak_bandwidth", 0.0);
+	perfstate.peakipc = parseOptionalPetscCmd_real("-perf_peak_ipc", 4.0);
+
+	for(int is = 0; is < PERFSTAGE_NUM; is++) {
+		PerfStageData& s = perfstate.stages[is];
+		s.walltime = 0; s.ncalls = 0; s.depth = 0; s.startwtime = 0;
+		for(int i = 0; i < PERFEVENT_NUM; i++) {
+			s.counts[i] = 0;
+			s.startcounts[i] = 0;
+		}
+	}
+
+	if(parsePetscCmd_isDefined("-perf_no_hardware_counters")) {
+		std::cout << " PerfCounters: Hardware counters not requested."
+		          << " Only wall-clock times will be reported.\n";
+		perfstate.hwcounters = false;
+	}
+	else
+		perfstate.hwcounters = openHardwareCounters();
+	return true;
+}
+
+void beginPerfStage(const PerfStage stage)
+{
+	if(!perfstate.enabled || inParallelRegion())
+		return;
+
+	// Stages entered from within a parallel region are not measured, because the counters
+	//  already include all threads.
+	PerfStageData& s = perfstate.stages[stage];
+	// only the outermost entry of a (recursively) nested stage is measured
+	if(s.depth++ > 0)
+		return;
+
+	s.ncalls++;
+	if(perfstate.hwcounters)
+		readHardwareCounters(s.startcounts);
+	s.startwtime = perfWallTime();
+}
+
+void endPerfStage(const PerfStage stage)
+{
+	if(!perfstate.enabled || inParallelRegion())
+		return;
+
+	PerfStageData& s = perfstate.stages[stage];
+	if(--s.depth > 0)
+		return;
+
+	s.walltime += perfWallTime() - s.startwtime;
+	if(perfstate.hwcounters) {
+		long long counts[PERFEVENT_NUM];
+		readHardwareCounters(counts);
+		for(int i = 0; i < PERFEVENT_NUM; i++)
+			s.counts[i] += counts[i] - s.startcounts[i];
+	}
+}
+
+long perfStageCalls(const PerfStage stage)
+{
+	return perfstate.enabled ? perfstate.stages[stage].ncalls : 0;
+}
+
+double perfStageWallTime(const PerfStage stage)
+{
+	return perfstate.enabled ? perfstate.stages[stage].walltime : 0;
+}
+
+bool perfHardwareCountersAvailable()
+{
+	return perfstate.enabled && perfstate.hwcounters;
+}
+
+void reportPerfCounters(std::ostream& out)
+{
+	if(!perfstate.enabled)
+		return;
+
+	const int w = 12;
+	out << "\nPerfCounters: Stage-wise performance\n";
+	out << std::setw(w) << "stage" << std::setw(w) << "calls" << std::setw(w) << "wtime(s)";
+	if(perfstate.hwcounters)
+		out << std::setw(w) << "Gcycles" << std::setw(w) << "Ginstrs" << std::setw(w) << "IPC"
+		    << std::setw(w) << "LLC-miss%" << std::setw(w) << "est-GB/s"
+		    << std::setw(w) << "instr/B" << std::setw(w) << "bound";
+	out << '\n';
+
+	for(int is = 0; is < PERFSTAGE_NUM; is++)
+	{
+		const PerfStageData& s = perfstate.stages[is];
+		if(s.ncalls == 0)
+			continue;
+
+		out << std::setw(w) << stage_names[is] << std::setw(w) << s.ncalls
+		    << std::setw(w) << s.walltime;
+
+		if(perfstate.hwcounters)
+		{
+			const double cycles = static_cast<double>(s.counts[PERFEVENT_CYCLES]);
+			const double instrs = static_cast<double>(s.counts[PERFEVENT_INSTRUCTIONS]);
+			const double refs = static_cast<double>(s.counts[PERFEVENT_LLC_REFERENCES]);
+			const double bytes = static_cast<double>(s.counts[PERFEVENT_LLC_MISSES])*bytes_per_miss;
+
+			const double ipc = cycles > 0 ? instrs/cycles : 0;
+			const double missrate = refs > 0 ? 100.0*s.counts[PERFEVENT_LLC_MISSES]/refs : 0;
+			const double bandwidth = s.walltime > 0 ? bytes/s.walltime*1e-9 : 0;
+			const double intensity = bytes > 0 ? instrs/bytes : 0;
+
+			// The stage is taken to be limited by whichever resource it uses the larger fraction of.
+			// Without a given peak bandwidth, only the achieved IPC is looked at.
+			std::string bound;
+			if(perfstate.peakbandwidth > 0)
+				bound = bandwidth/perfstate.peakbandwidth > ipc/perfstate.peakipc ?
+					"memory" : "compute";
+			else
+				bound = ipc < 0.25*perfstate.peakipc ? "memory?" : "compute?";
+
+			out << std::setw(w) << cycles*1e-9 << std::setw(w) << instrs*1e-9
+			    << std::setw(w) << ipc << std::setw(w) << missrate << std::setw(w) << bandwidth
+			    << std::setw(w) << intensity << std::setw(w) << bound;
+		}
+		out << '\n';
+	}
+
+	if(!perfstate.hwcounters)
+		out << " Hardware counters were not available.\n";
+	else
+		out << " Memory traffic is estimated as " << bytes_per_miss
+		    << " bytes per last-level cache miss. Cycles and instructions are summed over threads.\n";
+	out << std::flush;
+}
+
+void finalizePerfCounters()
+{
+	if(perfstate.enabled && perfstate.hwcounters)
+		closeHardwareCounters();
+	perfstate.enabled = false;
+	perfstate.hwcounters = false;
+}
+
+}
@@ -0,0 +1,84 @@
+/** \file perfcounters.hpp
+ * \brief Optional hardware performance counter instrumentation of solver stages
+ * \author Aditya Kashi
+ *
+ * On Linux, counters are read through the perf_event_open system call. The counters are opened
+ * for the whole process with inheritance to threads created later, so that OpenMP worker threads
+ * are counted as long as \ref initializePerfCounters is called before the first parallel region.
+ * If the counters cannot be opened (not Linux, no PMU access because of
+ * /proc/sys/kernel/perf_event_paranoid, virtualized hosts etc.), the instrumentation only
+ * measures wall-clock time and says so in its report.
+ *
+ * Stages entered inside a parallel region are not measured, since the counters already include all
+ * threads; so only stages begun by the master thread outside parallel regions are reported.
+ *
+ * This file is part of FVENS.
+ *   FVENS is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   FVENS is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with FVENS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FVENS_PERFCOUNTERS_H
+#define FVENS_PERFCOUNTERS_H
+
+#include <ostream>
+
+namespace fvens {
+
+/// Instrumented stages of the solver
+/** Stages may be nested; eg., the gradient stage is part of every residual evaluation.
+ */
+enum PerfStage {
+	PERFSTAGE_RESIDUAL = 0,      ///< Residual evaluations by the pseudo-time solver
+	PERFSTAGE_GRADIENT,          ///< Gradient reconstruction
+	PERFSTAGE_LIMITER,           ///< Limited reconstruction of face values
+	PERFSTAGE_FLUX,              ///< Face loop computing numerical fluxes
+	PERFSTAGE_JACOBIAN,          ///< Assembly of the Jacobian matrix
+	PERFSTAGE_LINSOLVE,          ///< Linear solves
+	PERFSTAGE_NUM                ///< Number of stages, not a stage
+};
+
+/// Open the hardware counters if the PETSc option `-perf_counters' is given
+/** Does nothing otherwise, in which case the other functions in this file are no-ops.
+ * With the option `-perf_no_hardware_counters', the hardware counters are not opened and only
+ * wall-clock times are measured, as when they cannot be opened.
+ * Peak machine characteristics for the roofline classification are read from the options
+ * `-perf_peak_bandwidth' (GB/s) and `-perf_peak_ipc' (instructions per cycle per core).
+ * \return true if instrumentation is enabled (with or without hardware counters)
+ */
+bool initializePerfCounters();
+
+/// Start accumulating counts for a stage
+void beginPerfStage(const PerfStage stage);
+
+/// Stop accumulating counts for a stage
+void endPerfStage(const PerfStage stage);
+
+/// Number of measured entries into a stage so far
+long perfStageCalls(const PerfStage stage);
+
+/// Wall-clock time accumulated in a stage so far
+double perfStageWallTime(const PerfStage stage);
+
+/// Whether hardware counters are being read
+bool perfHardwareCountersAvailable();
+
+/// Print, for each stage, the time, cycles, instructions, IPC, last-level cache misses,
+///  estimated memory traffic and arithmetic intensity, and classify it on the roofline
+void reportPerfCounters(std::ostream& out);
+
+/// Close the hardware counters
+void finalizePerfCounters();
+
+}
+
+#endif
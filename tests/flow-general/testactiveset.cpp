@@ -0,0 +1,138 @@
+/** \file testactiveset.cpp
+ * \brief Implements tests for residuals re-using cached fluxes away from changed cells
+ * \author Aditya Kashi
+ */
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+#include "utilities/afactory.hpp"
+#include "utilities/aerrorhandling.hpp"
+#include "spatial/activeset.hpp"
+#include "testactiveset.hpp"
+#include "testwallbcs.hpp"
+
+namespace fvens {
+namespace fvens_tests {
+
+/// Compares the residual computed with an active set after a local change with the full residual
+static int checkActiveSetResidual(const UMesh2dh<a_real> *const m,
+                                  const FlowFV_base<a_real> *const flow, const std::string& name)
+{
+	const a_int nelem = m->gnelem();
+	const std::array<a_real,NVARS> uref = get_test_state();
+
+	a_real xmin = m->gcoords(0,0), xmax = xmin;
+	for(a_int ip = 0; ip < m->gnpoin(); ip++) {
+		xmin = std::min(xmin, m->gcoords(ip,0));
+		xmax = std::max(xmax, m->gcoords(ip,0));
+	}
+
+	// the changed state differs in the cells near the left end of the domain
+	std::vector<a_real> u(nelem*NVARS), uchanged(nelem*NVARS);
+	for(a_int iel = 0; iel < nelem; iel++)
+	{
+		const a_real x = m->gcoords(m->ginpoel(iel,0),0), y = m->gcoords(m->ginpoel(iel,0),1);
+		const a_real pert = 1.0 + 0.05*std::sin(3.0*x)*std::cos(2.0*y);
+		const a_real change = x < xmin + 0.2*(xmax-xmin) ? 1.0 + 0.02*std::cos(5.0*y) : 1.0;
+		for(int j = 0; j < NVARS; j++) {
+			u[iel*NVARS+j] = uref[j]*pert;
+			uchanged[iel*NVARS+j] = u[iel*NVARS+j]*change;
+		}
+	}
+
+	ActiveSetConfig config;
+	config.enabled = true;
+	config.threshold = 1e-10;
+	config.layers = 2;
+	config.refreshinterval = 100;
+	ActiveSetResidual<a_real,NVARS> aset(m, config);
+
+	std::vector<a_real> r(nelem*NVARS, 0.0), ra(nelem*NVARS, 0.0), dtm(nelem), dtma(nelem);
+
+	// fill the cache, then re-use it
+	int ierr = flow->compute_residual(&u[0], &ra[0], true, dtma, &aset);
+	fvens_throw(ierr, "Residual failed!");
+	std::fill(ra.begin(), ra.end(), 0.0);
+	ierr = flow->compute_residual(&uchanged[0], &ra[0], true, dtma, &aset);
+	fvens_throw(ierr, "Residual failed!");
+
+	ierr = flow->compute_residual(&uchanged[0], &r[0], true, dtm);
+	fvens_throw(ierr, "Residual failed!");
+
+	int err = 0;
+	if(aset.isFullRefresh() || aset.numActiveFaces() == 0 || aset.numActiveFaces() == m->gnaface())
+	{
+		err = 1;
+		std::cerr << "! " << name << ": the change should have activated some of the faces, but "
+		          << aset.numActiveFaces() << " of " << m->gnaface() << " are active.\n";
+	}
+
+	a_real scale = 0, dtscale = 0;
+	for(size_t i = 0; i < r.size(); i++)
+		scale = std::max(scale, std::fabs(r[i]));
+	for(a_int iel = 0; iel < nelem; iel++)
+		dtscale = std::max(dtscale, dtm[iel]);
+
+	for(a_int iel = 0; iel < nelem; iel++)
+	{
+		for(int j = 0; j < NVARS; j++)
+			if(std::fabs(ra[iel*NVARS+j] - r[iel*NVARS+j]) > 1e-11*scale) {
+				err = 1;
+				std::cerr << "! " << name << ": residual differs at cell " << iel << ": "
+				          << ra[iel*NVARS+j] << " vs " << r[iel*NVARS+j] << "\n";
+			}
+		if(std::fabs(dtma[iel] - dtm[iel]) > 1e-11*dtscale) {
+			err = 1;
+			std::cerr << "! " << name << ": time step differs at cell " << iel << ": "
+			          << dtma[iel] << " vs " << dtm[iel] << "\n";
+		}
+	}
+	return err;
+}
+
+int testActiveSetResidual(const UMesh2dh<a_real> *const m, const FlowPhysicsConfig& pconf,
+                          const FlowNumericsConfig& nconf)
+{
+	int err = 0;
+
+	FlowPhysicsConfig ipconf = pconf;
+	ipconf.viscous_sim = false;
+
+	const std::array<std::array<std::string,2>,6> schemes {{
+		{"NONE", "NONE"}, {"LEASTSQUARES", "NONE"}, {"GREENGAUSS", "WENO"},
+		{"LEASTSQUARES", "BARTHJESPERSEN"}, {"GREENGAUSS", "VENKATAKRISHNAN"},
+		{"LEASTSQUARES", "VANALBADA"} }};
+
+	for(const std::string loopmode : {"coloured", "partitioned"})
+	{
+		int ierr = PetscOptionsSetValue(NULL, "-face_loop_mode", loopmode.c_str());
+		petsc_throw(ierr, "Could not set option");
+
+		for(const auto& scheme : schemes)
+		{
+			FlowNumericsConfig inconf = nconf;
+			inconf.gradientscheme = scheme[0];
+			inconf.reconstruction = scheme[1];
+			inconf.order2 = scheme[0] != "NONE";
+			const FlowFV_base<a_real> *const iflow
+				= create_const_flowSpatialDiscretization(m, ipconf, inconf);
+			err = checkActiveSetResidual(m, iflow, "Inviscid " + scheme[0] + " " + scheme[1] + ", "
+			                             + loopmode) || err;
+			delete iflow;
+		}
+
+		const FlowFV_base<a_real> *const flow
+			= create_const_flowSpatialDiscretization(m, pconf, nconf);
+		err = checkActiveSetResidual(m, flow, "As configured, " + loopmode) || err;
+		delete flow;
+
+		ierr = PetscOptionsClearValue(NULL, "-face_loop_mode");
+		petsc_throw(ierr, "Could not clear option");
+	}
+
+	return err;
+}
+
+}
+}
@@ -0,0 +1,27 @@
+/** \file testactiveset.hpp
+ * \brief Tests for residuals re-using cached fluxes away from changed cells
+ * \author Aditya Kashi
+ */
+
+#ifndef FVENS_TEST_ACTIVESET_H
+#define FVENS_TEST_ACTIVESET_H
+
+#include "spatial/flow_spatial.hpp"
+
+namespace fvens {
+namespace fvens_tests {
+
+/// Tests the residual computed with an active set against the full residual
+/** After an evaluation which fills the cache, the states of a region of the mesh are changed and
+ * the residual and time steps computed with the active set are compared with those computed
+ * without it. This is done for the inviscid flow with first-order fluxes, with both gradient
+ * schemes and with every reconstruction, and for the flow as configured, in the coloured and the
+ * partitioned face loop modes.
+ * \return 0 if the test passes, 1 otherwise
+ */
+int testActiveSetResidual(const UMesh2dh<a_real> *const m, const FlowPhysicsConfig& pconf,
+                          const FlowNumericsConfig& nconf);
+
+}
+}
+#endif
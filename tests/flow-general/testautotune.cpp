@@ -0,0 +1,75 @@
+/** \file
+ * \brief Reads an options file written by the FVENS auto-tuner and checks that the selected
+ *  solver settings are among the candidates that were offered.
+ *
+ * Arguments: the options file, a comma-separated list of allowed KSP types and a
+ * comma-separated list of allowed PC types.
+ */
+
+#undef NDEBUG
+
+#include <fstream>
+#include <sstream>
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+static std::vector<std::string> splitList(const std::string list)
+{
+	std::vector<std::string> items;
+	std::istringstream ss(list);
+	std::string item;
+	while(std::getline(ss, item, ','))
+		items.push_back(item);
+	return items;
+}
+
+static bool isIn(const std::string val, const std::vector<std::string>& list)
+{
+	return std::find(list.begin(), list.end(), val) != list.end();
+}
+
+int main(int argc, char *argv[])
+{
+	assert(argc >= 4);
+	const std::vector<std::string> ksptypes = splitList(argv[2]);
+	const std::vector<std::string> pctypes = splitList(argv[3]);
+
+	std::ifstream fin(argv[1]);
+	if(!fin) {
+		std::cout << "Auto-tuned options file " << argv[1] << " was not written!" << std::endl;
+		return -1;
+	}
+
+	std::string ksptype = "", pctype = "";
+	int restart = -1;
+	std::string line;
+	while(std::getline(fin,line))
+	{
+		if(line.size() == 0 || line[0] == '#')
+			continue;
+		std::istringstream ls(line);
+		std::string key;
+		ls >> key;
+		if(key == "-ksp_type")
+			ls >> ksptype;
+		else if(key == "-pc_type")
+			ls >> pctype;
+		else if(key == "-ksp_gmres_restart")
+			ls >> restart;
+	}
+
+	std::cout << "Selected KSP type " << ksptype << ", PC type " << pctype
+	          << ", restart " << restart << std::endl;
+
+	assert(isIn(ksptype, ksptypes));
+	assert(isIn(pctype, pctypes));
+	if(ksptype.find("gmres") != std::string::npos)
+		assert(restart > 0);
+	else
+		assert(restart == -1);
+
+	return 0;
+}
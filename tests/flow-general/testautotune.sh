@@ -0,0 +1,20 @@
+#! /bin/bash
+
+# Execute the auto-tuner and check the options file it writes
+
+outfile=@CMAKE_CURRENT_BINARY_DIR@/2dcyl-tuned.solverc
+rm -f $outfile
+
+@CMAKE_BINARY_DIR@/fvens_autotune $@
+retval=$?
+if [ $retval -ne 0 ]
+then
+	exit $retval
+fi
+
+@CMAKE_CURRENT_BINARY_DIR@/check_autotune_output $outfile gmres,bcgs bjacobi
+retval=$?
+
+rm -f $outfile
+
+exit $retval
@@ -0,0 +1,90 @@
+/** \file testbatchresidual.cpp
+ * \brief Implements tests for the evaluation of residuals of batches of states
+ * \author Aditya Kashi
+ */
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+#include "utilities/afactory.hpp"
+#include "utilities/aerrorhandling.hpp"
+#include "testbatchresidual.hpp"
+#include "testwallbcs.hpp"
+
+namespace fvens {
+namespace fvens_tests {
+
+/// Compares the residual of a batch of nstates different smooth states with individual residuals
+static int checkBatch(const UMesh2dh<a_real> *const m, const FlowFV_base<a_real> *const flow,
+                      const int nstates)
+{
+	const a_int nelem = m->gnelem();
+	const std::array<a_real,NVARS> uref = get_test_state();
+
+	std::vector<a_real> ub(nelem*nstates*NVARS), rb(nelem*nstates*NVARS, 0.0);
+	for(a_int iel = 0; iel < nelem; iel++)
+	{
+		const a_real x = m->gcoords(m->ginpoel(iel,0),0), y = m->gcoords(m->ginpoel(iel,0),1);
+		for(int k = 0; k < nstates; k++)
+		{
+			const a_real pert = 1.0 + 0.05*std::sin((3.0+k)*x)*std::cos((2.0+0.5*k)*y);
+			for(int j = 0; j < NVARS; j++)
+				ub[(iel*nstates+k)*NVARS+j] = uref[j]*pert;
+		}
+	}
+
+	int ierr = flow->compute_residual_batch(nstates, &ub[0], &rb[0]);
+	fvens_throw(ierr, "Batch residual failed!");
+
+	int err = 0;
+	std::vector<a_real> u(nelem*NVARS), r(nelem*NVARS);
+	std::vector<a_real> dtm(nelem);
+	for(int k = 0; k < nstates; k++)
+	{
+		for(a_int iel = 0; iel < nelem; iel++)
+			for(int j = 0; j < NVARS; j++)
+				u[iel*NVARS+j] = ub[(iel*nstates+k)*NVARS+j];
+		std::fill(r.begin(), r.end(), 0.0);
+		flow->compute_residual(&u[0], &r[0], false, dtm);
+
+		a_real scale = 0;
+		for(size_t i = 0; i < r.size(); i++)
+			scale = std::max(scale, std::fabs(r[i]));
+		const a_real tol = 1e-12*scale;
+
+		for(a_int iel = 0; iel < nelem; iel++)
+			for(int j = 0; j < NVARS; j++)
+				if(std::fabs(rb[(iel*nstates+k)*NVARS+j] - r[iel*NVARS+j]) > tol) {
+					err = 1;
+					std::cerr << "! Batch of " << nstates << ": residual of state " << k
+					          << " differs at cell " << iel << ": "
+					          << rb[(iel*nstates+k)*NVARS+j] << " vs " << r[iel*NVARS+j] << "\n";
+				}
+	}
+	return err;
+}
+
+int testBatchResidual(const UMesh2dh<a_real> *const m, const FlowPhysicsConfig& pconf,
+                      const FlowNumericsConfig& nconf)
+{
+	int err = 0;
+
+	FlowPhysicsConfig ipconf = pconf;
+	ipconf.viscous_sim = false;
+	FlowNumericsConfig inconf = nconf;
+	inconf.reconstruction = "VENKATAKRISHNAN";
+	const FlowFV_base<a_real> *const iflow
+		= create_const_flowSpatialDiscretization(m, ipconf, inconf);
+	for(const int nstates : {4, 13, 16, 31})
+		err = checkBatch(m, iflow, nstates) || err;
+	delete iflow;
+
+	const FlowFV_base<a_real> *const flow = create_const_flowSpatialDiscretization(m, pconf, nconf);
+	err = checkBatch(m, flow, 5) || err;
+	delete flow;
+
+	return err;
+}
+
+}
+}
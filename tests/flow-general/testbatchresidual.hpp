@@ -0,0 +1,25 @@
+/** \file testbatchresidual.hpp
+ * \brief Tests for the evaluation of residuals of batches of states
+ * \author Aditya Kashi
+ */
+
+#ifndef FVENS_TEST_BATCHRESIDUAL_H
+#define FVENS_TEST_BATCHRESIDUAL_H
+
+#include "spatial/flow_spatial.hpp"
+
+namespace fvens {
+namespace fvens_tests {
+
+/// Tests the residuals of batches of states against the residuals of the states one by one
+/** Batches of several sizes, which are evaluated by different combinations of the batched kernels
+ * and the single-state residual, are checked for the inviscid flow (with the Venkatakrishnan
+ * limiter) and for the flow as configured.
+ * \return 0 if the test passes, 1 otherwise
+ */
+int testBatchResidual(const UMesh2dh<a_real> *const m, const FlowPhysicsConfig& pconf,
+                      const FlowNumericsConfig& nconf);
+
+}
+}
+#endif
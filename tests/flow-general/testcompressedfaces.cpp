@@ -0,0 +1,187 @@
+/** \file testcompressedfaces.cpp
+ * \brief Implements tests for face loops which read compressed face data
+ * \author Aditya Kashi
+ */
+
+#include <iostream>
+#include <fstream>
+#include <cmath>
+#include <algorithm>
+#include "utilities/afactory.hpp"
+#include "utilities/aerrorhandling.hpp"
+#include "mesh/compressedfaces.hpp"
+#include "testcompressedfaces.hpp"
+#include "testwallbcs.hpp"
+
+namespace fvens {
+namespace fvens_tests {
+
+/// Writes a mesh of n x n slightly distorted quadrilaterals on the unit square in Gmsh 2 format
+/** The bottom and top boundaries have marker 4, the left boundary 2 and the right boundary 3.
+ * The cells are numbered row by row, except that the bottom row is numbered last. The faces
+ * between the first two rows are thus listed with faces whose cells differ by a few rows only.
+ */
+static void writeStructuredMesh(const std::string meshfile, const int n)
+{
+	std::ofstream fout(meshfile);
+	fvens_throw(!fout, "Could not open mesh file for writing!");
+	fout.precision(16);
+	const a_real h = 1.0/n;
+	const a_real pi = 4.0*std::atan(1.0);
+
+	fout << "$MeshFormat\n2.2 0 8\n$EndMeshFormat\n$Nodes\n" << (n+1)*(n+1) << '\n';
+	for(int j = 0; j <= n; j++)
+		for(int i = 0; i <= n; i++) {
+			const a_real x = i*h, y = j*h;
+			const a_real d = 0.2*h*std::sin(2*pi*x)*std::sin(2*pi*y);
+			fout << j*(n+1)+i+1 << ' ' << x+d << ' ' << y-d << " 0\n";
+		}
+	fout << "$EndNodes\n$Elements\n" << 4*n + n*n << '\n';
+
+	const auto node = [n](const int i, const int j) { return j*(n+1)+i+1; };
+	int ielm = 1;
+	for(int i = 0; i < n; i++)
+		fout << ielm++ << " 1 2 4 1 " << node(i,0) << ' ' << node(i+1,0) << '\n';
+	for(int j = 0; j < n; j++)
+		fout << ielm++ << " 1 2 3 2 " << node(n,j) << ' ' << node(n,j+1) << '\n';
+	for(int i = 0; i < n; i++)
+		fout << ielm++ << " 1 2 4 3 " << node(i+1,n) << ' ' << node(i,n) << '\n';
+	for(int j = 0; j < n; j++)
+		fout << ielm++ << " 1 2 2 4 " << node(0,j+1) << ' ' << node(0,j) << '\n';
+
+	for(int jrow = 1; jrow <= n; jrow++)
+		for(int i = 0; i < n; i++) {
+			const int j = jrow % n;
+			fout << ielm++ << " 3 2 1 1 " << node(i,j) << ' ' << node(i+1,j) << ' '
+			     << node(i+1,j+1) << ' ' << node(i,j+1) << '\n';
+		}
+	fout << "$EndElements\n";
+}
+
+/// Checks that the compressed face data reproduces the face data of the mesh
+static int checkFaceData(const UMesh2dh<a_real>& m)
+{
+	const CompressedFaceData<a_real> cfaces(&m);
+	const a_int nblocks = (m.gnaface() + CompressedFaceData<a_real>::blocksize-1)
+		/ CompressedFaceData<a_real>::blocksize;
+	std::cout << " Compressed faces: " << cfaces.numWideBlocks() << " of " << nblocks
+	          << " blocks with full indices, " << cfaces.bytesPerFace() << " bytes per face\n";
+
+	int err = 0;
+	if(cfaces.numWideBlocks() == 0 || cfaces.numWideBlocks() == nblocks) {
+		std::cerr << "! The mesh does not have both compressed and uncompressed blocks!\n";
+		err = 1;
+	}
+
+	for(a_int iface = 0; iface < m.gnaface(); iface++)
+	{
+		if(cfaces.leftCell(iface) != m.gintfac(iface,0)
+		   || cfaces.rightCell(iface) != m.gintfac(iface,1)
+		   || cfaces.length(iface) != m.gfacemetric(iface,NDIM)) {
+			std::cerr << "! Cells or length of face " << iface << " are decoded wrongly!\n";
+			err = 1;
+		}
+		for(int idim = 0; idim < NDIM; idim++)
+			if(std::fabs(cfaces.normal(iface,idim) - m.gfacemetric(iface,idim)) > 1e-7) {
+				std::cerr << "! Normal of face " << iface << " is too inaccurate!\n";
+				err = 1;
+			}
+	}
+	return err;
+}
+
+/// Computes the residual at a smooth state, with or without compressed face data
+static std::vector<a_real> computeResidual(const UMesh2dh<a_real>& m,
+                                           const FlowPhysicsConfig& pconf,
+                                           const FlowNumericsConfig& nconf, const bool compressed)
+{
+	if(compressed) {
+		const int ierr = PetscOptionsSetValue(NULL, "-mesh_compressed_faces", NULL);
+		petsc_throw(ierr, "Could not set option");
+	}
+	const FlowFV_base<a_real> *const flow
+		= create_const_flowSpatialDiscretization(&m, pconf, nconf);
+	if(compressed) {
+		const int ierr = PetscOptionsClearValue(NULL, "-mesh_compressed_faces");
+		petsc_throw(ierr, "Could not clear option");
+	}
+
+	const a_int nelem = m.gnelem();
+	const std::array<a_real,NVARS> uref = get_test_state();
+	std::vector<a_real> u(nelem*NVARS), r(nelem*NVARS, 0.0), dtm(nelem);
+	for(a_int iel = 0; iel < nelem; iel++)
+	{
+		const a_real x = m.gcoords(m.ginpoel(iel,0),0), y = m.gcoords(m.ginpoel(iel,0),1);
+		const a_real pert = 1.0 + 0.05*std::sin(3.0*x)*std::cos(2.0*y);
+		for(int j = 0; j < NVARS; j++)
+			u[iel*NVARS+j] = uref[j]*pert;
+	}
+
+	const int ierr = flow->compute_residual(&u[0], &r[0], false, dtm);
+	fvens_throw(ierr, "Residual failed!");
+	delete flow;
+	return r;
+}
+
+/// Compares the residuals computed with and without compressed face data
+/** The single precision normals perturb each face flux by about 1e-7 of the flux, while the
+ * residual of the smooth state is a difference of fluxes of the order of the squared mesh size.
+ * The tolerance is therefore relative to the flux magnitude, estimated by the largest state.
+ */
+static int checkResidual(const UMesh2dh<a_real>& m, const FlowPhysicsConfig& pconf,
+                         const FlowNumericsConfig& nconf, const std::string& name)
+{
+	const std::vector<a_real> r = computeResidual(m, pconf, nconf, false);
+	const std::vector<a_real> rc = computeResidual(m, pconf, nconf, true);
+
+	const std::array<a_real,NVARS> uref = get_test_state();
+	const a_real fluxscale = *std::max_element(uref.begin(), uref.end(),
+		[](const a_real a, const a_real b) { return std::fabs(a) < std::fabs(b); });
+	a_real maxlen = 0;
+	for(a_int iface = 0; iface < m.gnaface(); iface++)
+		maxlen = std::max(maxlen, m.gfacemetric(iface,NDIM));
+	const a_real tol = 1e-6*std::fabs(fluxscale)*maxlen;
+
+	a_real maxdiff = 0;
+	for(size_t i = 0; i < r.size(); i++)
+		maxdiff = std::max(maxdiff, std::fabs(rc[i]-r[i]));
+	std::cout << " " << name << ": largest difference in residual " << maxdiff
+	          << ", tolerance " << tol << '\n';
+
+	if(maxdiff > tol) {
+		std::cerr << "! " << name << ": residuals with compressed faces differ!\n";
+		return 1;
+	}
+	return 0;
+}
+
+int testCompressedFaces(const std::string meshfile, const FlowPhysicsConfig& pconf,
+                        const FlowNumericsConfig& nconf)
+{
+	writeStructuredMesh(meshfile, 260);
+	UMesh2dh<a_real> m;
+	m.readMesh(meshfile);
+	m.compute_topological();
+	m.compute_areas();
+	m.compute_face_data();
+
+	int err = checkFaceData(m);
+
+	FlowPhysicsConfig ipconf = pconf;
+	ipconf.viscous_sim = false;
+	for(const std::string gradscheme : {"GREENGAUSS", "LEASTSQUARES"})
+	{
+		FlowNumericsConfig inconf = nconf;
+		inconf.gradientscheme = gradscheme;
+		inconf.reconstruction = "NONE";
+		inconf.order2 = true;
+		err = checkResidual(m, ipconf, inconf, "Inviscid " + gradscheme) || err;
+	}
+
+	err = checkResidual(m, pconf, nconf, "As configured") || err;
+
+	return err;
+}
+
+}
+}
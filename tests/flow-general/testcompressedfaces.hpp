@@ -0,0 +1,28 @@
+/** \file testcompressedfaces.hpp
+ * \brief Tests for face loops which read compressed face data
+ * \author Aditya Kashi
+ */
+
+#ifndef FVENS_TEST_COMPRESSEDFACES_H
+#define FVENS_TEST_COMPRESSEDFACES_H
+
+#include "spatial/flow_spatial.hpp"
+
+namespace fvens {
+namespace fvens_tests {
+
+/// Tests the compressed face data and the residual computed with it (`-mesh_compressed_faces')
+/** A structured mesh of more than 2^16 cells is generated, numbered such that some blocks of faces
+ * have cell offsets too large for 16 bits, so that both kinds of blocks are tested. The cells of
+ * all faces must be decoded exactly, and the residuals computed with and without the option must
+ * agree up to the single precision of the compressed normals. This is checked for the inviscid
+ * flow with both gradient schemes and for the flow as configured.
+ * \param meshfile Name of the mesh file to generate
+ * \return 0 if the test passes, 1 otherwise
+ */
+int testCompressedFaces(const std::string meshfile, const FlowPhysicsConfig& pconf,
+                        const FlowNumericsConfig& nconf);
+
+}
+}
+#endif
@@ -3,6 +3,16 @@
 #include "utilities/aoptionparser.hpp"
 #include "utilities/controlparser.hpp"
 #include "testwallbcs.hpp"
+#include "testpassivescalar.hpp"
+#include "testsaturbulence.hpp"
+#include "testfieldoutput.hpp"
+#include "testbatchresidual.hpp"
+#include "testlocalresidual.hpp"
+#include "testlowmach.hpp"
+#include "testsurfaceforces.hpp"
+#include "testcompressedfaces.hpp"
+#include "testfrozenroe.hpp"
+#include "testactiveset.hpp"
 
 using namespace fvens;
 using namespace fvens_tests;
@@ -14,6 +24,18 @@ using namespace std::literals::string_literals;
  * Currently avaiable:
  * - 'wall_boundaries': Tests whether certain components of the numerical inviscid flux
  *     are zero for the 3 types of solid walls - adiabatic, isothermal and slip.
+ * - 'passive_scalar': Tests the residual and the face Jacobians of the flow discretization with
+ *     a passive scalar.
+ * - 'sa_turbulence': Tests the residual and the Jacobian of the flow discretization with the
+ *     Spalart-Allmaras turbulence model.
+ * - 'field_output': Tests selective output of flow fields in different precisions.
+ * - 'batch_residual': Tests the residuals of batches of states against individual residuals.
+ * - 'local_residual': Tests the residuals of sub-domains against the residual of the whole mesh.
+ * - 'low_mach': Tests low-Mach preconditioning of the Roe and HLLC fluxes.
+ * - 'surface_forces': Tests the lift and drag coefficients computed on walls.
+ * - 'compressed_faces': Tests the residual computed with compressed face data on a generated mesh.
+ * - 'frozen_roe_jacobian': Tests the frozen-coefficient Jacobian of the Roe flux.
+ * - 'active_set_residual': Tests the residual re-using cached fluxes away from changed cells.
  */
 int main(int argc, char *argv[])
 {
@@ -82,6 +104,70 @@ int main(int argc, char *argv[])
 		finerr = finerr || err;
 	}
 
+	if(testchoice == "passive_scalar")
+	{
+		int err = testPassiveScalarResidual(&m, pconf, nconf);
+		finerr = finerr || err;
+		err = testPassiveScalarJacobian(&m, pconf, nconf);
+		finerr = finerr || err;
+	}
+
+	if(testchoice == "sa_turbulence")
+	{
+		int err = testSATurbulenceResidual(&m, pconf, nconf);
+		finerr = finerr || err;
+		err = testSATurbulenceJacobian(&m, pconf, nconf);
+		finerr = finerr || err;
+	}
+
+	if(testchoice == "field_output")
+	{
+		int err = testFieldOutput(&m, pconf, nconf);
+		finerr = finerr || err;
+	}
+
+	if(testchoice == "batch_residual")
+	{
+		int err = testBatchResidual(&m, pconf, nconf);
+		finerr = finerr || err;
+	}
+
+	if(testchoice == "local_residual")
+	{
+		int err = testLocalResidual(&m, pconf, nconf);
+		finerr = finerr || err;
+	}
+
+	if(testchoice == "low_mach")
+	{
+		int err = testLowMachPreconditioning(pconf);
+		finerr = finerr || err;
+	}
+
+	if(testchoice == "surface_forces")
+	{
+		int err = testSurfaceForces(&m, pconf, nconf);
+		finerr = finerr || err;
+	}
+
+	if(testchoice == "compressed_faces")
+	{
+		int err = testCompressedFaces("compressedfaces.msh", pconf, nconf);
+		finerr = finerr || err;
+	}
+
+	if(testchoice == "frozen_roe_jacobian")
+	{
+		int err = testFrozenRoeJacobian(pconf);
+		finerr = finerr || err;
+	}
+
+	if(testchoice == "active_set_residual")
+	{
+		int err = testActiveSetResidual(&m, pconf, nconf);
+		finerr = finerr || err;
+	}
+
 	ierr = PetscFinalize(); CHKERRQ(ierr);
 	return finerr;
 }
@@ -0,0 +1,148 @@
+/** \file testfieldoutput.cpp
+ * \brief Implements tests for selective output of flow fields
+ * \author Aditya Kashi
+ */
+
+#include <iostream>
+#include <cmath>
+#include <cstdio>
+#include <petscvec.h>
+#include "utilities/afactory.hpp"
+#include "utilities/aerrorhandling.hpp"
+#include "spatial/aoutput.hpp"
+#include "testfieldoutput.hpp"
+
+namespace fvens {
+namespace fvens_tests {
+
+/// Compares the values of one field read back with reference values of all cells
+/** \param reltol Tolerance relative to the largest magnitude of the reference values
+ */
+static int compareField(const FieldOutputData& data, const std::string& name,
+                        const MVector<a_real>& ref, const a_real reltol)
+{
+	int err = 0;
+	const int ncomp = data.ncomps.at(name);
+	const std::vector<a_real>& vals = data.values.at(name);
+	const a_real tol = reltol*ref.cwiseAbs().maxCoeff();
+	for(size_t i = 0; i < data.cells.size(); i++)
+		for(int j = 0; j < ncomp; j++) {
+			const a_real exact = ref(data.cells[i],j);
+			if(std::fabs(vals[i*ncomp+j] - exact) > tol) {
+				err = 1;
+				std::cerr << "! Field " << name << " of cell " << data.cells[i] << ": "
+				          << vals[i*ncomp+j] << " vs " << exact << "\n";
+			}
+		}
+	return err;
+}
+
+int testFieldOutput(const UMesh2dh<a_real> *const m, const FlowPhysicsConfig& pconf,
+                    const FlowNumericsConfig& nconf)
+{
+	const FlowFV_base<a_real> *const flow = create_const_flowSpatialDiscretization(m, pconf, nconf);
+	const IdealGasPhysics<a_real> phy(pconf.gamma, pconf.Minf, pconf.Tinf, pconf.Reinf, pconf.Pr);
+	const FlowOutput out(flow, &phy, pconf.aoa);
+
+	// a smoothly varying state, and the reference values of the fields
+	const std::array<a_real,NVARS> uref = phy.compute_freestream_state(pconf.aoa);
+	Vec uvec;
+	int ierr = VecCreateSeq(PETSC_COMM_SELF, m->gnelem()*NVARS, &uvec);
+	petsc_throw(ierr, "Could not create vector");
+	PetscScalar *uarr;
+	ierr = VecGetArray(uvec, &uarr); petsc_throw(ierr, "Could not get array");
+
+	MVector<a_real> centres(m->gnelem(),NDIM), rho(m->gnelem(),1), vel(m->gnelem(),NDIM),
+		pres(m->gnelem(),1), temp(m->gnelem(),1), mach(m->gnelem(),1);
+	for(a_int iel = 0; iel < m->gnelem(); iel++)
+	{
+		for(int j = 0; j < NDIM; j++) {
+			centres(iel,j) = 0;
+			for(int ino = 0; ino < m->gnnode(iel); ino++)
+				centres(iel,j) += m->gcoords(m->ginpoel(iel,ino),j);
+			centres(iel,j) /= m->gnnode(iel);
+		}
+		const a_real pert = 1.0 + 0.1*std::sin(3.0*centres(iel,0))*std::cos(2.0*centres(iel,1));
+		for(int j = 0; j < NVARS; j++)
+			uarr[iel*NVARS+j] = uref[j]*pert;
+		uarr[iel*NVARS+2] += 0.05*uref[0]*std::cos(centres(iel,0));
+
+		const a_real *const uc = &uarr[iel*NVARS];
+		rho(iel,0) = uc[0];
+		for(int j = 0; j < NDIM; j++)
+			vel(iel,j) = uc[j+1]/uc[0];
+		pres(iel,0) = phy.getPressureFromConserved(uc);
+		temp(iel,0) = phy.getTemperatureFromConserved(uc);
+		mach(iel,0) = std::sqrt(vel(iel,0)*vel(iel,0)+vel(iel,1)*vel(iel,1))
+			/ phy.getSoundSpeedFromConserved(uc);
+	}
+	ierr = VecRestoreArray(uvec, &uarr); petsc_throw(ierr, "Could not restore array");
+
+	int err = 0;
+
+	// all fields of all cells in double precision
+	FieldOutputConfig conf;
+	conf.file = "test-fields-all.bin";
+	conf.fields = {"coordinates", "density", "velocity", "pressure", "temperature", "mach-number"};
+	conf.precision = FLOAT64;
+	ierr = out.exportFields(uvec, conf); petsc_throw(ierr, "Could not export fields");
+
+	const FieldOutputData all = readFieldOutput(conf.file);
+	if(static_cast<a_int>(all.cells.size()) != m->gnelem() || all.fields != conf.fields) {
+		std::cerr << "! Wrong cells or fields read back!\n";
+		err = 1;
+	}
+	else {
+		err = compareField(all, "coordinates", centres, 1e-14) || err;
+		err = compareField(all, "density", rho, 1e-14) || err;
+		err = compareField(all, "velocity", vel, 1e-14) || err;
+		err = compareField(all, "pressure", pres, 1e-14) || err;
+		err = compareField(all, "temperature", temp, 1e-14) || err;
+		err = compareField(all, "mach-number", mach, 1e-14) || err;
+	}
+	std::remove(conf.file.c_str());
+
+	// some fields of the cells in the lower-left part of the domain in lower precisions
+	a_real lo[NDIM], hi[NDIM];
+	for(int j = 0; j < NDIM; j++) {
+		lo[j] = centres.col(j).minCoeff();
+		hi[j] = centres.col(j).maxCoeff();
+	}
+	conf.box = {lo[0]-1.0, lo[1]-1.0, 0.5*(lo[0]+hi[0]), 0.5*(lo[1]+hi[1])};
+	conf.fields = {"pressure", "velocity"};
+
+	a_int nbox = 0;
+	for(a_int iel = 0; iel < m->gnelem(); iel++)
+		if(centres(iel,0) <= conf.box[2] && centres(iel,1) <= conf.box[3])
+			nbox++;
+
+	const std::vector<std::pair<OutputPrecision,a_real>> precs {{FLOAT32, 1e-6}, {FLOAT16, 1e-3}};
+	for(const auto& prec : precs)
+	{
+		conf.precision = prec.first;
+		conf.file = "test-fields-box.bin";
+		ierr = out.exportFields(uvec, conf); petsc_throw(ierr, "Could not export fields");
+
+		const FieldOutputData part = readFieldOutput(conf.file);
+		if(static_cast<a_int>(part.cells.size()) != nbox || nbox == 0 || nbox == m->gnelem()) {
+			std::cerr << "! Wrong number of cells in the box: " << part.cells.size() << " vs "
+			          << nbox << "\n";
+			err = 1;
+		}
+		for(const a_int iel : part.cells)
+			if(centres(iel,0) > conf.box[2] || centres(iel,1) > conf.box[3]) {
+				std::cerr << "! Cell " << iel << " is outside the box!\n";
+				err = 1;
+			}
+		err = compareField(part, "pressure", pres, prec.second) || err;
+		err = compareField(part, "velocity", vel, prec.second) || err;
+		std::remove(conf.file.c_str());
+	}
+
+	ierr = VecDestroy(&uvec); petsc_throw(ierr, "Could not destroy vector");
+	delete flow;
+	return err;
+}
+
+}
+}
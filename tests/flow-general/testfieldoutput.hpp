@@ -0,0 +1,25 @@
+/** \file testfieldoutput.hpp
+ * \brief Tests for selective output of flow fields
+ * \author Aditya Kashi
+ */
+
+#ifndef FVENS_TEST_FIELDOUTPUT_H
+#define FVENS_TEST_FIELDOUTPUT_H
+
+#include "spatial/flow_spatial.hpp"
+
+namespace fvens {
+namespace fvens_tests {
+
+/// Tests writing selected fields in each precision and reading them back
+/** All fields are written for all cells in double precision and must be read back to round-off.
+ * Then some fields of the cells in a box are written in single and half precision; the cells read
+ * back must be those whose centres lie in the box, and the values must agree to the precision.
+ * \return 0 if the test passes, 1 otherwise
+ */
+int testFieldOutput(const UMesh2dh<a_real> *const m, const FlowPhysicsConfig& pconf,
+                    const FlowNumericsConfig& nconf);
+
+}
+}
+#endif
@@ -0,0 +1,147 @@
+/** \file testfrozenroe.cpp
+ * \brief Implements tests for the frozen-coefficient Roe flux Jacobian
+ * \author Aditya Kashi
+ */
+
+#include <iostream>
+#include <cmath>
+#include <array>
+#include <algorithm>
+#include "utilities/afactory.hpp"
+#include "testfrozenroe.hpp"
+#include "../flowstatetests.hpp"
+
+namespace fvens {
+namespace fvens_tests {
+
+/// Gives access to the Roe-averaged state and the dissipation of the Roe flux
+class RoeDissipation : public RoeFlux<a_real>
+{
+public:
+	RoeDissipation(const IdealGasPhysics<a_real> *const phy) : RoeFlux<a_real>(phy) { }
+
+	/// The Roe flux with the dissipation evaluated at a given Roe-averaged state
+	/** \param roe Roe-averaged density, x- and y-velocities and speed of sound
+	 */
+	void getFluxAtRoeState(const a_real *const ul, const a_real *const ur, const a_real *const n,
+	                       const std::array<a_real,4>& roe, a_real *const flux) const
+	{
+		a_real du[NVARS], adu[NVARS], fl[NVARS], fr[NVARS];
+		for(int i = 0; i < NVARS; i++)
+			du[i] = ur[i]-ul[i];
+		getDissipation(n, roe[0], roe[1], roe[2], roe[3], du, adu);
+		physics->getDirectionalFluxFromConserved(ul, n, fl);
+		physics->getDirectionalFluxFromConserved(ur, n, fr);
+		for(int i = 0; i < NVARS; i++)
+			flux[i] = 0.5*(fl[i] + fr[i] - adu[i]);
+	}
+
+	/// Roe-averaged density, x- and y-velocities and speed of sound of two states
+	std::array<a_real,4> getRoeState(const a_real *const ul, const a_real *const ur,
+	                                 const a_real *const n) const
+	{
+		a_real vi[NDIM], vj[NDIM], vni, vnj, pi, pj, Hi, Hj;
+		physics->getVarsFromConserved(ul, n, vi, vni, pi, Hi);
+		physics->getVarsFromConserved(ur, n, vj, vnj, pj, Hj);
+		a_real Rij, rhoij, vxij, vyij, vm2ij, vnij, Hij, cij;
+		getRoeAverages(ul, ur, n, vi[0], vi[1], Hi, vj[0], vj[1], Hj,
+		               Rij, rhoij, vxij, vyij, vm2ij, vnij, Hij, cij);
+		return {rhoij, vxij, vyij, cij};
+	}
+};
+
+static a_real maxAbs(const a_real *const a, const int n)
+{
+	a_real m = 0;
+	for(int i = 0; i < n; i++)
+		m = std::max(m, std::fabs(a[i]));
+	return m;
+}
+
+int testFrozenRoeJacobian(const FlowPhysicsConfig& pconf)
+{
+	int err = 0;
+	const a_real g = pconf.gamma;
+	const a_real n[NDIM] = {0.6, 0.8};
+	const IdealGasPhysics<a_real> phy(g, pconf.Minf, pconf.Tinf, pconf.Reinf, pconf.Pr);
+	const a_real pinf = phy.getFreestreamPressure();
+
+	const InviscidFlux<a_real> *const roe = create_const_inviscidflux("ROE", &phy);
+	const InviscidFlux<a_real> *const frozen = create_const_inviscidflux("ROE_FROZEN", &phy);
+	const RoeDissipation diss(&phy);
+
+	const std::array<a_real,NVARS> ul = conservedState(g, 1.0, 0.5, 0.1, pinf);
+	const std::array<a_real,NVARS> ur = conservedState(g, 1.2, 0.3, -0.2, 1.3*pinf);
+
+	// equal states: no derivatives of the Roe-averaged state contribute to the full Jacobian
+	{
+		a_real dfdl[NVARS*NVARS], dfdr[NVARS*NVARS], fdfdl[NVARS*NVARS], fdfdr[NVARS*NVARS];
+		roe->get_jacobian(&ul[0], &ul[0], n, dfdl, dfdr);
+		frozen->get_jacobian(&ul[0], &ul[0], n, fdfdl, fdfdr);
+		const a_real scale = std::max(maxAbs(dfdl, NVARS*NVARS), maxAbs(dfdr, NVARS*NVARS));
+		const a_real diff = std::max(maxDiff(dfdl, fdfdl, NVARS*NVARS),
+		                             maxDiff(dfdr, fdfdr, NVARS*NVARS));
+		std::cout << " Equal states: difference from the Roe Jacobian " << diff/scale << '\n';
+		if(diff > 1e-12*scale) {
+			err = 1;
+			std::cerr << "! Frozen Roe Jacobian differs from the Roe Jacobian at equal states!\n";
+		}
+	}
+
+	const std::array<a_real,4> roestate = diss.getRoeState(&ul[0], &ur[0], n);
+
+	// the dissipation is that of the Roe flux
+	{
+		a_real f[NVARS], froe[NVARS];
+		roe->get_flux(&ul[0], &ur[0], n, froe);
+		diss.getFluxAtRoeState(&ul[0], &ur[0], n, roestate, f);
+		if(maxDiff(f, froe, NVARS) > 1e-12*maxAbs(froe, NVARS)) {
+			err = 1;
+			std::cerr << "! The dissipation does not give the Roe flux: "
+			          << maxDiff(f, froe, NVARS) << '\n';
+		}
+	}
+
+	// different states: central differences with the Roe-averaged state fixed
+	{
+		a_real fdfdl[NVARS*NVARS], fdfdr[NVARS*NVARS], rdfdl[NVARS*NVARS], rdfdr[NVARS*NVARS];
+		frozen->get_jacobian(&ul[0], &ur[0], n, fdfdl, fdfdr);
+
+		for(int k = 0; k < NVARS; k++)
+		{
+			const a_real h = 1e-5*std::max(std::fabs(ul[k]), std::fabs(ur[k]));
+			std::array<a_real,NVARS> up = ul, um = ul;
+			up[k] += h; um[k] -= h;
+			a_real fp[NVARS], fm[NVARS];
+			diss.getFluxAtRoeState(&up[0], &ur[0], n, roestate, fp);
+			diss.getFluxAtRoeState(&um[0], &ur[0], n, roestate, fm);
+			// the left Jacobian is stored negated
+			for(int i = 0; i < NVARS; i++)
+				rdfdl[i*NVARS+k] = -(fp[i]-fm[i])/(2*h);
+
+			up = ur; um = ur;
+			up[k] += h; um[k] -= h;
+			diss.getFluxAtRoeState(&ul[0], &up[0], n, roestate, fp);
+			diss.getFluxAtRoeState(&ul[0], &um[0], n, roestate, fm);
+			for(int i = 0; i < NVARS; i++)
+				rdfdr[i*NVARS+k] = (fp[i]-fm[i])/(2*h);
+		}
+
+		const a_real scale = std::max(maxAbs(rdfdl, NVARS*NVARS), maxAbs(rdfdr, NVARS*NVARS));
+		const a_real diff = std::max(maxDiff(rdfdl, fdfdl, NVARS*NVARS),
+		                             maxDiff(rdfdr, fdfdr, NVARS*NVARS));
+		std::cout << " Different states: difference from finite differences " << diff/scale
+		          << '\n';
+		if(diff > 1e-7*scale) {
+			err = 1;
+			std::cerr << "! Frozen Roe Jacobian does not match finite differences!\n";
+		}
+	}
+
+	delete roe;
+	delete frozen;
+	return err;
+}
+
+}
+}
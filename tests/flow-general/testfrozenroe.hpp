@@ -0,0 +1,26 @@
+/** \file testfrozenroe.hpp
+ * \brief Tests for the frozen-coefficient Roe flux Jacobian
+ * \author Aditya Kashi
+ */
+
+#ifndef FVENS_TEST_FROZENROE_H
+#define FVENS_TEST_FROZENROE_H
+
+#include "spatial/flow_spatial.hpp"
+
+namespace fvens {
+namespace fvens_tests {
+
+/// Tests the Jacobian of the Roe flux computed with the dissipation matrix frozen
+/** Checks that
+ *  - it equals the full Roe Jacobian when the left and right states are equal,
+ *  - it matches finite differences of the Roe flux with the Roe-averaged state held fixed, for
+ *    different left and right states, and
+ *  - the dissipation it is built from gives the Roe flux.
+ * \return 0 if the test passes, 1 otherwise
+ */
+int testFrozenRoeJacobian(const FlowPhysicsConfig& pconf);
+
+}
+}
+#endif
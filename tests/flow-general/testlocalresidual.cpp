@@ -0,0 +1,113 @@
+/** \file testlocalresidual.cpp
+ * \brief Implements tests for the evaluation of residuals of sets of cells
+ * \author Aditya Kashi
+ */
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+#include "utilities/afactory.hpp"
+#include "utilities/aerrorhandling.hpp"
+#include "mesh/ameshutils.hpp"
+#include "testlocalresidual.hpp"
+#include "testwallbcs.hpp"
+
+namespace fvens {
+namespace fvens_tests {
+
+/// Compares the local residuals of some sub-domains with the full residual
+static int checkLocalResidual(const UMesh2dh<a_real> *const m,
+                              const FlowFV_base<a_real> *const flow, const std::string& name)
+{
+	const a_int nelem = m->gnelem();
+	const std::array<a_real,NVARS> uref = get_test_state();
+
+	std::vector<a_real> u(nelem*NVARS);
+	for(a_int iel = 0; iel < nelem; iel++)
+	{
+		const a_real x = m->gcoords(m->ginpoel(iel,0),0), y = m->gcoords(m->ginpoel(iel,0),1);
+		const a_real pert = 1.0 + 0.05*std::sin(3.0*x)*std::cos(2.0*y);
+		for(int j = 0; j < NVARS; j++)
+			u[iel*NVARS+j] = uref[j]*pert;
+	}
+
+	const MeshSubdomains sd = partitionSubdomains(*m, 3, 1);
+
+	int err = 0;
+	std::vector<a_real> uchanged(nelem*NVARS), r(nelem*NVARS), dtm(nelem);
+	for(size_t isd = 0; isd+1 < sd.starts.size(); isd++)
+	{
+		const a_int ncells = sd.starts[isd+1]-sd.starts[isd];
+		const LocalStencil st = buildLocalStencil(*m, &sd.cells[sd.starts[isd]], ncells,
+		                                          flow->localStencilLayers());
+
+		// change the states of the sub-domain
+		uchanged = u;
+		std::vector<a_real> urows(ncells*NVARS), rrows(ncells*NVARS);
+		for(a_int i = 0; i < ncells; i++)
+		{
+			const a_int iel = st.cells[i];
+			const a_real pert = 1.0 + 0.02*std::cos(5.0*m->gcoords(m->ginpoel(iel,1),0));
+			for(int j = 0; j < NVARS; j++) {
+				urows[i*NVARS+j] = u[iel*NVARS+j]*pert;
+				uchanged[iel*NVARS+j] = urows[i*NVARS+j];
+			}
+		}
+
+		std::fill(r.begin(), r.end(), 0.0);
+		int ierr = flow->compute_residual(&uchanged[0], &r[0], false, dtm);
+		fvens_throw(ierr, "Residual failed!");
+		ierr = flow->compute_local_residual(st, &u[0], &urows[0], &rrows[0]);
+		fvens_throw(ierr, "Local residual failed!");
+
+		a_real scale = 0;
+		for(size_t i = 0; i < r.size(); i++)
+			scale = std::max(scale, std::fabs(r[i]));
+		const a_real tol = 1e-12*scale;
+
+		for(a_int i = 0; i < ncells; i++)
+			for(int j = 0; j < NVARS; j++)
+				if(std::fabs(rrows[i*NVARS+j] - r[st.cells[i]*NVARS+j]) > tol) {
+					err = 1;
+					std::cerr << "! " << name << ": residual of sub-domain " << isd
+					          << " differs at cell " << st.cells[i] << ": " << rrows[i*NVARS+j]
+					          << " vs " << r[st.cells[i]*NVARS+j] << "\n";
+				}
+	}
+	return err;
+}
+
+int testLocalResidual(const UMesh2dh<a_real> *const m, const FlowPhysicsConfig& pconf,
+                      const FlowNumericsConfig& nconf)
+{
+	int err = 0;
+
+	FlowPhysicsConfig ipconf = pconf;
+	ipconf.viscous_sim = false;
+
+	const std::array<std::array<std::string,2>,6> schemes {{
+		{"NONE", "NONE"}, {"LEASTSQUARES", "NONE"}, {"GREENGAUSS", "WENO"},
+		{"LEASTSQUARES", "BARTHJESPERSEN"}, {"GREENGAUSS", "VENKATAKRISHNAN"},
+		{"LEASTSQUARES", "VANALBADA"} }};
+
+	for(const auto& scheme : schemes)
+	{
+		FlowNumericsConfig inconf = nconf;
+		inconf.gradientscheme = scheme[0];
+		inconf.reconstruction = scheme[1];
+		inconf.order2 = scheme[0] != "NONE";
+		const FlowFV_base<a_real> *const iflow
+			= create_const_flowSpatialDiscretization(m, ipconf, inconf);
+		err = checkLocalResidual(m, iflow, "Inviscid " + scheme[0] + " " + scheme[1]) || err;
+		delete iflow;
+	}
+
+	const FlowFV_base<a_real> *const flow = create_const_flowSpatialDiscretization(m, pconf, nconf);
+	err = checkLocalResidual(m, flow, "As configured") || err;
+	delete flow;
+
+	return err;
+}
+
+}
+}
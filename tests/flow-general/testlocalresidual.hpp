@@ -0,0 +1,26 @@
+/** \file testlocalresidual.hpp
+ * \brief Tests for the evaluation of residuals of sets of cells from their neighbourhoods
+ * \author Aditya Kashi
+ */
+
+#ifndef FVENS_TEST_LOCALRESIDUAL_H
+#define FVENS_TEST_LOCALRESIDUAL_H
+
+#include "spatial/flow_spatial.hpp"
+
+namespace fvens {
+namespace fvens_tests {
+
+/// Tests the residuals of overlapping sub-domains against the residual of the whole mesh
+/** The states of the cells of each sub-domain are changed and the residuals computed by
+ * \ref Spatial::compute_local_residual are compared with the rows of the full residual at the
+ * changed state. This is done for the inviscid flow with first-order fluxes, with both gradient
+ * schemes and with every reconstruction, and for the flow as configured.
+ * \return 0 if the test passes, 1 otherwise
+ */
+int testLocalResidual(const UMesh2dh<a_real> *const m, const FlowPhysicsConfig& pconf,
+                      const FlowNumericsConfig& nconf);
+
+}
+}
+#endif
@@ -0,0 +1,144 @@
+/** \file testlowmach.cpp
+ * \brief Implements tests for low-Mach preconditioning of the numerical fluxes
+ * \author Aditya Kashi
+ */
+
+#include <iostream>
+#include <cmath>
+#include <array>
+#include "utilities/afactory.hpp"
+#include "testlowmach.hpp"
+#include "../flowstatetests.hpp"
+
+namespace fvens {
+namespace fvens_tests {
+
+int testLowMachPreconditioning(const FlowPhysicsConfig& pconf)
+{
+	int err = 0;
+	const a_real g = pconf.gamma;
+	const a_real n[NDIM] = {0.6, 0.8};
+
+	// with a cut-off larger than the sound speed, there is no preconditioning
+	{
+		const IdealGasPhysics<a_real> phy(g, pconf.Minf, pconf.Tinf, pconf.Reinf, pconf.Pr);
+		const LowMachPreconditioner nolm(g, 100.0/pconf.Minf);
+		const InviscidFlux<a_real> *const roe = create_const_inviscidflux("ROE", &phy);
+		const InviscidFlux<a_real> *const roelm = create_const_inviscidflux("ROE", &phy, &nolm);
+		const a_real pinf = phy.getFreestreamPressure();
+		const std::array<a_real,NVARS> ul = conservedState(g, 1.0, 1.0, 0.1, pinf);
+		const std::array<a_real,NVARS> ur = conservedState(g, 1.1, 0.8, -0.2, 1.2*pinf);
+
+		a_real f[NVARS], flm[NVARS];
+		roe->get_flux(&ul[0], &ur[0], n, f);
+		roelm->get_flux(&ul[0], &ur[0], n, flm);
+		if(maxDiff(f, flm, NVARS) > 1e-12*pinf) {
+			err = 1;
+			std::cerr << "! Unpreconditioned low-Mach Roe flux differs from the Roe flux by "
+			          << maxDiff(f, flm, NVARS) << '\n';
+		}
+		delete roe;
+		delete roelm;
+	}
+
+	// consistency and scaling of the dissipation at a low Mach number
+	const a_real Mlow = 0.01;
+	const IdealGasPhysics<a_real> phy(g, Mlow, pconf.Tinf, pconf.Reinf, pconf.Pr);
+	const LowMachPreconditioner lm(g, 1.0);
+	const a_real pinf = phy.getFreestreamPressure();
+
+	const InviscidFlux<a_real> *const roe = create_const_inviscidflux("ROE", &phy);
+	const InviscidFlux<a_real> *const roelm = create_const_inviscidflux("ROE", &phy, &lm);
+	const InviscidFlux<a_real> *const hllc = create_const_inviscidflux("HLLC", &phy);
+	const InviscidFlux<a_real> *const hllclm = create_const_inviscidflux("HLLC", &phy, &lm);
+
+	const std::array<a_real,NVARS> u = conservedState(g, 1.0, 0.9, 0.2, pinf);
+	a_real fphys[NVARS];
+	phy.getDirectionalFluxFromConserved(&u[0], n, fphys);
+
+	const InviscidFlux<a_real> *const lmfluxes[] = {roelm, hllclm};
+	for(const InviscidFlux<a_real> *const flux : lmfluxes)
+	{
+		a_real f[NVARS];
+		flux->get_flux(&u[0], &u[0], n, f);
+		if(maxDiff(f, fphys, NVARS) > 1e-12*pinf) {
+			err = 1;
+			std::cerr << "! Low-Mach flux is inconsistent: " << maxDiff(f, fphys, NVARS) << '\n';
+		}
+	}
+
+	// the frozen Jacobian of the preconditioned Roe flux at equal states: -dfdl + dfdr = dF/du
+	{
+		a_real dfdl[NVARS*NVARS], dfdr[NVARS*NVARS], dfdu[NVARS*NVARS], sum[NVARS*NVARS];
+		roelm->get_jacobian(&u[0], &u[0], n, dfdl, dfdr);
+		phy.getJacobianDirectionalFluxWrtConserved(&u[0], n, dfdu);
+		for(int k = 0; k < NVARS*NVARS; k++)
+			sum[k] = dfdr[k] - dfdl[k];
+		if(maxDiff(sum, dfdu, NVARS*NVARS) > 1e-10*pinf) {
+			err = 1;
+			std::cerr << "! Low-Mach Roe Jacobian is inconsistent: "
+			          << maxDiff(sum, dfdu, NVARS*NVARS) << '\n';
+		}
+	}
+
+	/* A jump in normal velocity is damped by a pressure dissipation of order rho*c*dvn without
+	 * preconditioning, but rho*|v|*dvn with it.
+	 */
+	{
+		const std::array<a_real,NVARS> ul = conservedState(g, 1.0, 1.0-0.03, 0.0, pinf);
+		const std::array<a_real,NVARS> ur = conservedState(g, 1.0, 1.0+0.03, 0.0, pinf);
+		const a_real nx[NDIM] = {1.0, 0.0};
+		a_real fl[NVARS], fr[NVARS];
+		phy.getDirectionalFluxFromConserved(&ul[0], nx, fl);
+		phy.getDirectionalFluxFromConserved(&ur[0], nx, fr);
+
+		const std::pair<const InviscidFlux<a_real>*, const InviscidFlux<a_real>*> pairs[]
+			= {{roe, roelm}, {hllc, hllclm}};
+		for(const auto& fluxes : pairs)
+		{
+			a_real f[NVARS], flm[NVARS];
+			fluxes.first->get_flux(&ul[0], &ur[0], nx, f);
+			fluxes.second->get_flux(&ul[0], &ur[0], nx, flm);
+			const a_real diss = std::fabs(f[1] - 0.5*(fl[1]+fr[1]));
+			const a_real disslm = std::fabs(flm[1] - 0.5*(fl[1]+fr[1]));
+			if(disslm > 10.0*Mlow*diss) {
+				err = 1;
+				std::cerr << "! Low-Mach pressure dissipation is " << disslm << ", unpreconditioned "
+				          << diss << '\n';
+			}
+		}
+	}
+
+	delete roe;
+	delete roelm;
+	delete hllc;
+	delete hllclm;
+
+	// the preconditioning matrix and its inverse, with a passive scalar
+	{
+		constexpr int nv = NVARS+1;
+		const a_real us[nv] = {u[0], u[1], u[2], u[3], 0.3*u[0]};
+		a_real pm[nv*nv], pinv[nv*nv];
+		lm.getMatrix<a_real,nv>(us, false, pm);
+		lm.getMatrix<a_real,nv>(us, true, pinv);
+		a_real maxerr = 0, maxinv = 0;
+		for(int i = 0; i < nv; i++)
+			for(int j = 0; j < nv; j++) {
+				a_real prod = 0;
+				for(int k = 0; k < nv; k++)
+					prod += pm[i*nv+k]*pinv[k*nv+j];
+				maxerr = std::max(maxerr, std::fabs(prod - (i == j ? 1.0 : 0.0)));
+				maxinv = std::max(maxinv, std::fabs(pinv[i*nv+j]));
+			}
+		if(maxerr > 1e-14*maxinv) {
+			err = 1;
+			std::cerr << "! The low-Mach preconditioning matrix and its inverse do not match: "
+			          << maxerr << '\n';
+		}
+	}
+
+	return err;
+}
+
+}
+}
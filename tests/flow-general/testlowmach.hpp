@@ -0,0 +1,26 @@
+/** \file testlowmach.hpp
+ * \brief Tests for low-Mach preconditioning of the numerical fluxes
+ * \author Aditya Kashi
+ */
+
+#ifndef FVENS_TEST_LOWMACH_H
+#define FVENS_TEST_LOWMACH_H
+
+#include "spatial/flow_spatial.hpp"
+
+namespace fvens {
+namespace fvens_tests {
+
+/// Tests the low-Mach preconditioned Roe and HLLC fluxes and the preconditioning matrix
+/** Checks that
+ *  - the preconditioned Roe flux reduces to the Roe flux when the cut-off exceeds the sound speed,
+ *  - the preconditioned fluxes are consistent at a low Mach number, as is the frozen Roe Jacobian,
+ *  - the preconditioned dissipation of a velocity jump scales with the Mach number, and
+ *  - the preconditioning matrix and its inverse are inverses, also with a passive scalar.
+ * \return 0 if the test passes, 1 otherwise
+ */
+int testLowMachPreconditioning(const FlowPhysicsConfig& pconf);
+
+}
+}
+#endif
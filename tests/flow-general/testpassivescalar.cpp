@@ -0,0 +1,246 @@
+/** \file testpassivescalar.cpp
+ * \brief Implements tests for the transport of passive scalars
+ * \author Aditya Kashi
+ */
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+#include <petscsys.h>
+#include "utilities/afactory.hpp"
+#include "utilities/aerrorhandling.hpp"
+#include "testpassivescalar.hpp"
+#include "testwallbcs.hpp"
+
+namespace fvens {
+namespace fvens_tests {
+
+int testPassiveScalarResidual(const UMesh2dh<a_real> *const m, const FlowPhysicsConfig& pconf,
+                              const FlowNumericsConfig& nconf)
+{
+	constexpr int nvs = NVARS+1;
+	const a_real phi = 0.7;
+	int ierr = PetscOptionsSetValue(NULL, "-passive_scalar_freestream", "0.7");
+	petsc_throw(ierr, "Could not set passive scalar option!");
+
+	const FlowFV_base<a_real> *const flow = create_const_flowSpatialDiscretization(m, pconf, nconf);
+	const FlowFV_base<a_real,nvs> *const flows
+		= create_const_flowSpatialDiscretization<a_real,nvs>(m, pconf, nconf);
+
+	// a smoothly perturbed state
+	const std::array<a_real,NVARS> uref = get_test_state();
+	std::vector<a_real> u(m->gnelem()*NVARS), us(m->gnelem()*nvs);
+	for(a_int iel = 0; iel < m->gnelem(); iel++)
+	{
+		const a_real pert = 1.0 + 0.05*std::sin(3.0*m->gcoords(m->ginpoel(iel,0),0))
+			*std::cos(2.0*m->gcoords(m->ginpoel(iel,0),1));
+		for(int j = 0; j < NVARS; j++) {
+			u[iel*NVARS+j] = uref[j]*pert;
+			us[iel*nvs+j] = uref[j]*pert;
+		}
+		us[iel*nvs+NVARS] = us[iel*nvs]*phi;
+	}
+
+	std::vector<a_real> r(m->gnelem()*NVARS, 0.0), rs(m->gnelem()*nvs, 0.0);
+	std::vector<a_real> dtm(m->gnelem());
+	flow->compute_residual(&u[0], &r[0], true, dtm);
+	flows->compute_residual(&us[0], &rs[0], true, dtm);
+
+	a_real scale = 0;
+	for(size_t i = 0; i < r.size(); i++)
+		scale = std::max(scale, std::fabs(r[i]));
+	const a_real tol = 1e-12*scale;
+
+	int err = 0;
+	for(a_int iel = 0; iel < m->gnelem(); iel++)
+	{
+		for(int j = 0; j < NVARS; j++)
+			if(std::fabs(rs[iel*nvs+j] - r[iel*NVARS+j]) > tol) {
+				err = 1;
+				std::cerr << "! Flow residual changed by passive scalar at cell " << iel << ": "
+				          << rs[iel*nvs+j] << " vs " << r[iel*NVARS+j] << "\n";
+			}
+		if(std::fabs(rs[iel*nvs+NVARS] - phi*rs[iel*nvs]) > tol) {
+			err = 1;
+			std::cerr << "! Passive scalar residual inconsistent at cell " << iel << ": "
+			          << rs[iel*nvs+NVARS] << " vs " << phi*rs[iel*nvs] << "\n";
+		}
+	}
+
+	delete flow;
+	delete flows;
+	return err;
+}
+
+/// Exposes the face Jacobians of a first-order flow discretization
+template <int nvars>
+class FaceJacobianFlowFV : public FlowFV<a_real,false,false,nvars>
+{
+public:
+	FaceJacobianFlowFV(const UMesh2dh<a_real> *const mesh, const FlowPhysicsConfig& pconf,
+	                   const FlowNumericsConfig& nconf)
+		: FlowFV<a_real,false,false,nvars>(mesh, pconf, nconf)
+	{ }
+
+	using FlowFV<a_real,false,false,nvars>::compute_boundary_face_jacobian;
+	using FlowFV<a_real,false,false,nvars>::compute_interior_face_jacobian;
+	using FlowFV<a_real,false,false,nvars>::compute_boundary_state;
+	using FlowFV<a_real,false,false,nvars>::inviflux;
+};
+
+/// The flux of the passive scalar through a face: the mass flux times the upwind scalar
+static a_real scalarFlux(const InviscidFlux<a_real> *const flux, const a_real *const ul,
+                         const a_real *const ur, const a_real *const n)
+{
+	a_real f[NVARS];
+	flux->get_flux(ul, ur, n, f);
+	return f[0] >= 0 ? f[0]*ul[NVARS]/ul[0] : f[0]*ur[NVARS]/ur[0];
+}
+
+/// Compares a row of a Jacobian block with a finite-difference row, prints and returns 1 if
+///  they differ
+static int compareRow(const a_real *const exact, const a_real *const fd, const int nvs,
+                      const char *const name, const a_int iface)
+{
+	a_real scale = 1e-10;
+	for(int j = 0; j < nvs; j++)
+		scale = std::max(scale, std::fabs(fd[j]));
+	int err = 0;
+	for(int j = 0; j < nvs; j++)
+		if(std::fabs(exact[j] - fd[j]) > 1e-5*scale) {
+			err = 1;
+			std::cerr << "! Scalar row of " << name << " at face " << iface << ", column " << j
+			          << ": " << exact[j] << " vs finite difference " << fd[j] << "\n";
+		}
+	return err;
+}
+
+int testPassiveScalarJacobian(const UMesh2dh<a_real> *const m, const FlowPhysicsConfig& pconf,
+                              const FlowNumericsConfig& nconf)
+{
+	constexpr int nvs = NVARS+1;
+	int ierr = PetscOptionsSetValue(NULL, "-passive_scalar_freestream", "0.7");
+	petsc_throw(ierr, "Could not set passive scalar option!");
+
+	const FaceJacobianFlowFV<NVARS> flow(m, pconf, nconf);
+	const FaceJacobianFlowFV<nvs> flows(m, pconf, nconf);
+
+	const std::array<a_real,NVARS> uref = get_test_state();
+	std::vector<a_real> u(m->gnelem()*NVARS), us(m->gnelem()*nvs);
+	for(a_int iel = 0; iel < m->gnelem(); iel++)
+	{
+		const a_real x = m->gcoords(m->ginpoel(iel,0),0), y = m->gcoords(m->ginpoel(iel,0),1);
+		const a_real pert = 1.0 + 0.05*std::sin(3.0*x)*std::cos(2.0*y);
+		for(int j = 0; j < NVARS; j++) {
+			u[iel*NVARS+j] = uref[j]*pert;
+			us[iel*nvs+j] = uref[j]*pert;
+		}
+		us[iel*nvs+NVARS] = us[iel*nvs]*(0.7 + 0.2*std::cos(4.0*x + y));
+	}
+
+	const a_real h = 1e-6;
+	int err = 0;
+
+	// Checks the flow blocks against those without the scalar
+	const auto checkFlowBlock = [&err,nvs](const a_real *const bs, const a_real *const b,
+	                                        const char *const name, const a_int iface)
+	{
+		for(int i = 0; i < NVARS; i++)
+		{
+			for(int j = 0; j < NVARS; j++)
+				if(std::fabs(bs[i*nvs+j] - b[i*NVARS+j]) > 1e-12*(1.0 + std::fabs(b[i*NVARS+j]))) {
+					err = 1;
+					std::cerr << "! Flow block " << name << " changed by passive scalar at face "
+					          << iface << ": " << bs[i*nvs+j] << " vs " << b[i*NVARS+j] << "\n";
+				}
+			if(bs[i*nvs+NVARS] != 0) {
+				err = 1;
+				std::cerr << "! Flow row " << i << " of " << name << " depends on the scalar at face "
+				          << iface << "\n";
+			}
+		}
+	};
+
+	for(a_int iface = 0; iface < m->gnbface(); iface++)
+	{
+		const a_int lelem = m->gintfac(iface,0);
+		const std::array<a_real,NDIM> n = m->gnormal(iface);
+		const a_real len = m->gfacemetric(iface,2);
+
+		a_real lefts[nvs*nvs], left[NVARS*NVARS];
+		flows.compute_boundary_face_jacobian(iface, &us[0], lefts);
+		flow.compute_boundary_face_jacobian(iface, &u[0], left);
+		checkFlowBlock(lefts, left, "D", iface);
+
+		// The ghost state Jacobian of isothermal walls is not exact (see Isothermalwall2D), which
+		//  carries over to the mass flux the scalar flux depends on.
+		if(std::any_of(pconf.bcconf.begin(), pconf.bcconf.end(),
+			[m,iface](const FlowBCConfig& bc) {
+				return bc.bc_tag == m->gintfacbtags(iface,0) && bc.bc_type == ISOTHERMAL_WALL_BC;
+			}))
+			continue;
+
+		// the contribution to the diagonal block is the face integral of the total derivative
+		a_real fd[nvs];
+		for(int j = 0; j < nvs; j++)
+		{
+			a_real up[nvs], um[nvs], gp[nvs], gm[nvs];
+			for(int k = 0; k < nvs; k++)
+				up[k] = um[k] = us[lelem*nvs+k];
+			const a_real eps = h*std::max(1.0, std::fabs(up[j]));
+			up[j] += eps; um[j] -= eps;
+			flows.compute_boundary_state(iface, up, gp);
+			flows.compute_boundary_state(iface, um, gm);
+			fd[j] = len*(scalarFlux(flows.inviflux, up, gp, &n[0])
+			             - scalarFlux(flows.inviflux, um, gm, &n[0]))/(2*eps);
+		}
+		err = compareRow(&lefts[NVARS*nvs], fd, nvs, "D", iface) || err;
+	}
+
+	for(a_int iface = m->gnbface(); iface < m->gnaface(); iface++)
+	{
+		const a_int lelem = m->gintfac(iface,0);
+		const a_int relem = m->gintfac(iface,1);
+		const std::array<a_real,NDIM> n = m->gnormal(iface);
+		const a_real len = m->gfacemetric(iface,2);
+
+		a_real Ls[nvs*nvs], Us[nvs*nvs], L[NVARS*NVARS], U[NVARS*NVARS];
+		flows.compute_interior_face_jacobian(iface, &us[0], Ls, Us);
+		flow.compute_interior_face_jacobian(iface, &u[0], L, U);
+		checkFlowBlock(Ls, L, "L", iface);
+		checkFlowBlock(Us, U, "U", iface);
+
+		// L is the negative of the derivative w.r.t. the left state
+		a_real fdl[nvs], fdu[nvs];
+		for(int j = 0; j < nvs; j++)
+		{
+			a_real ul[nvs], ur[nvs];
+			for(int k = 0; k < nvs; k++) {
+				ul[k] = us[lelem*nvs+k];
+				ur[k] = us[relem*nvs+k];
+			}
+
+			const a_real epsl = h*std::max(1.0, std::fabs(ul[j]));
+			ul[j] += epsl;
+			const a_real fp = scalarFlux(flows.inviflux, ul, ur, &n[0]);
+			ul[j] -= 2*epsl;
+			const a_real fm = scalarFlux(flows.inviflux, ul, ur, &n[0]);
+			ul[j] += epsl;
+			fdl[j] = -len*(fp-fm)/(2*epsl);
+
+			const a_real epsr = h*std::max(1.0, std::fabs(ur[j]));
+			ur[j] += epsr;
+			const a_real gp = scalarFlux(flows.inviflux, ul, ur, &n[0]);
+			ur[j] -= 2*epsr;
+			const a_real gm = scalarFlux(flows.inviflux, ul, ur, &n[0]);
+			fdu[j] = len*(gp-gm)/(2*epsr);
+		}
+		err = compareRow(&Ls[NVARS*nvs], fdl, nvs, "L", iface) || err;
+		err = compareRow(&Us[NVARS*nvs], fdu, nvs, "U", iface) || err;
+	}
+
+	return err;
+}
+
+}
+}
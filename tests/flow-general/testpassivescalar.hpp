@@ -0,0 +1,35 @@
+/** \file testpassivescalar.hpp
+ * \brief Tests for the transport of passive scalars by the flow discretization
+ * \author Aditya Kashi
+ */
+
+#ifndef FVENS_TEST_PASSIVESCALAR_H
+#define FVENS_TEST_PASSIVESCALAR_H
+
+#include "spatial/flow_spatial.hpp"
+
+namespace fvens {
+namespace fvens_tests {
+
+/// Tests the residual of the flow discretization with one passive scalar
+/** The residuals with and without the passive scalar are computed at a non-uniform flow state
+ * carrying a uniform scalar equal to its free-stream value. The flow residuals must be the same,
+ * and the residual of the scalar must be the scalar times the mass residual.
+ * \return 0 if the test passes, 1 otherwise
+ */
+int testPassiveScalarResidual(const UMesh2dh<a_real> *const m, const FlowPhysicsConfig& pconf,
+                              const FlowNumericsConfig& nconf);
+
+/// Tests the flux Jacobian blocks of the faces with one passive scalar
+/** At a non-uniform state with a non-uniform scalar, the rows of the first-order face Jacobians
+ * belonging to the scalar are compared with central finite differences of the scalar flux. The
+ * blocks of the flow variables must be the same as without the scalar, and must not depend on the
+ * scalar.
+ * \return 0 if the test passes, 1 otherwise
+ */
+int testPassiveScalarJacobian(const UMesh2dh<a_real> *const m, const FlowPhysicsConfig& pconf,
+                              const FlowNumericsConfig& nconf);
+
+}
+}
+#endif
@@ -0,0 +1,255 @@
+/** \file testsaturbulence.cpp
+ * \brief Implements tests for the coupling of the Spalart-Allmaras turbulence model to the flow
+ * \author Aditya Kashi
+ */
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+#include <petscsys.h>
+#include "utilities/afactory.hpp"
+#include "utilities/aerrorhandling.hpp"
+#include "testsaturbulence.hpp"
+
+namespace fvens {
+namespace fvens_tests {
+
+/// Computes the residual of a turbulent discretization at a state with a uniform working variable
+static std::vector<a_real> computeTurbulentResidual(const UMesh2dh<a_real> *const m,
+                                                    const FlowPhysicsConfig& pconf,
+                                                    const FlowNumericsConfig& nconf,
+                                                    const std::vector<a_real>& u, const a_real nut)
+{
+	constexpr int nvt = NVARS+1;
+	const FlowFV_base<a_real,nvt> *const flowt
+		= create_const_flowSpatialDiscretization<a_real,nvt>(m, pconf, nconf);
+
+	std::vector<a_real> ut(m->gnelem()*nvt);
+	for(a_int iel = 0; iel < m->gnelem(); iel++) {
+		for(int j = 0; j < NVARS; j++)
+			ut[iel*nvt+j] = u[iel*NVARS+j];
+		ut[iel*nvt+NVARS] = u[iel*NVARS]*nut;
+	}
+
+	std::vector<a_real> rt(m->gnelem()*nvt, 0.0);
+	std::vector<a_real> dtm(m->gnelem());
+	flowt->compute_residual(&ut[0], &rt[0], true, dtm);
+
+	delete flowt;
+	return rt;
+}
+
+int testSATurbulenceResidual(const UMesh2dh<a_real> *const m, const FlowPhysicsConfig& pconf,
+                             const FlowNumericsConfig& nconf)
+{
+	constexpr int nvt = NVARS+1;
+	FlowPhysicsConfig tconf = pconf;
+	tconf.turbulence_model = "SA";
+
+	/* On the coarse test mesh, unlimited reconstruction gives unphysical face states next to the
+	 * walls, and hence a non-finite residual, even for a uniform state; so a limiter is used.
+	 */
+	const FlowNumericsConfig fconf {nconf.conv_numflux, nconf.conv_numflux_jac,
+	                                nconf.gradientscheme, "VANALBADA", nconf.limiter_param,
+	                                nconf.order2, nconf.lowmach_cutoff};
+
+	const FlowFV_base<a_real> *const flow = create_const_flowSpatialDiscretization(m, pconf, fconf);
+
+	// a smoothly perturbed free-stream state
+	const IdealGasPhysics<a_real> phy(pconf.gamma, pconf.Minf, pconf.Tinf, pconf.Reinf, pconf.Pr);
+	const std::array<a_real,NVARS> uref = phy.compute_freestream_state(pconf.aoa);
+	std::vector<a_real> u(m->gnelem()*NVARS);
+	for(a_int iel = 0; iel < m->gnelem(); iel++)
+	{
+		const a_real pert = 1.0 + 0.05*std::sin(3.0*m->gcoords(m->ginpoel(iel,0),0))
+			*std::cos(2.0*m->gcoords(m->ginpoel(iel,0),1));
+		for(int j = 0; j < NVARS; j++)
+			u[iel*NVARS+j] = uref[j]*pert;
+		// shear, so that there is eddy viscosity away from the walls
+		u[iel*NVARS+1] *= 1.0 + 0.1*std::sin(4.0*m->gcoords(m->ginpoel(iel,0),1));
+	}
+
+	std::vector<a_real> r(m->gnelem()*NVARS, 0.0);
+	std::vector<a_real> dtm(m->gnelem());
+	flow->compute_residual(&u[0], &r[0], true, dtm);
+	delete flow;
+
+	a_real scale = 0;
+	for(size_t i = 0; i < r.size(); i++) {
+		if(!std::isfinite(r[i])) {
+			std::cerr << "! Laminar residual is not finite!\n";
+			return 1;
+		}
+		scale = std::max(scale, std::fabs(r[i]));
+	}
+	const a_real tol = 1e-12*scale;
+
+	int err = 0;
+
+	// no eddy viscosity anywhere
+	int ierr = PetscOptionsSetValue(NULL, "-sa_freestream_viscosity_ratio", "0");
+	petsc_throw(ierr, "Could not set SA option!");
+	const std::vector<a_real> rzero = computeTurbulentResidual(m, tconf, fconf, u, 0.0);
+
+	for(a_int iel = 0; iel < m->gnelem(); iel++)
+	{
+		for(int j = 0; j < NVARS; j++)
+			if(std::fabs(rzero[iel*nvt+j] - r[iel*NVARS+j]) > tol) {
+				err = 1;
+				std::cerr << "! Flow residual changed by zero eddy viscosity at cell " << iel
+				          << ": " << rzero[iel*nvt+j] << " vs " << r[iel*NVARS+j] << "\n";
+			}
+		if(std::fabs(rzero[iel*nvt+NVARS]) > tol) {
+			err = 1;
+			std::cerr << "! Residual of zero working variable is nonzero at cell " << iel << ": "
+			          << rzero[iel*nvt+NVARS] << "\n";
+		}
+	}
+
+	// a turbulent state
+	ierr = PetscOptionsSetValue(NULL, "-sa_freestream_viscosity_ratio", "50");
+	petsc_throw(ierr, "Could not set SA option!");
+	const a_real nut = getSAFreestreamWorkingVariable(1.0/pconf.Reinf);
+	const std::vector<a_real> rturb = computeTurbulentResidual(m, tconf, fconf, u, nut);
+
+	a_real maxdiff = 0;
+	for(a_int iel = 0; iel < m->gnelem(); iel++)
+	{
+		for(int j = 0; j < nvt; j++)
+			if(!std::isfinite(rturb[iel*nvt+j])) {
+				err = 1;
+				std::cerr << "! Turbulent residual is not finite at cell " << iel << "\n";
+			}
+		for(int j = 0; j < NVARS; j++)
+			maxdiff = std::max(maxdiff, std::fabs(rturb[iel*nvt+j] - r[iel*NVARS+j]));
+	}
+	if(maxdiff <= tol) {
+		err = 1;
+		std::cerr << "! Eddy viscosity did not change the flow residual!\n";
+	}
+
+	return err;
+}
+
+/// Exposes the face Jacobians and the source term of a first-order turbulent discretization
+class TurbulentJacobianFlowFV : public FlowFV<a_real,false,false,NVARS+1>
+{
+public:
+	TurbulentJacobianFlowFV(const UMesh2dh<a_real> *const mesh, const FlowPhysicsConfig& pconf,
+	                        const FlowNumericsConfig& nconf)
+		: FlowFV<a_real,false,false,NVARS+1>(mesh, pconf, nconf)
+	{ }
+
+	using FlowFV<a_real,false,false,NVARS+1>::compute_boundary_face_jacobian;
+	using FlowFV<a_real,false,false,NVARS+1>::compute_interior_face_jacobian;
+	using FlowFV<a_real,false,false,NVARS+1>::compute_turbulence_source;
+};
+
+int testSATurbulenceJacobian(const UMesh2dh<a_real> *const m, const FlowPhysicsConfig& pconf,
+                             const FlowNumericsConfig& nconf)
+{
+	constexpr int nvt = NVARS+1;
+	constexpr int k = NVARS;
+	FlowPhysicsConfig tconf = pconf;
+	tconf.turbulence_model = "SA";
+	int ierr = PetscOptionsSetValue(NULL, "-sa_freestream_viscosity_ratio", "50");
+	petsc_throw(ierr, "Could not set SA option!");
+
+	const TurbulentJacobianFlowFV flow(m, tconf, nconf);
+	const a_int nelem = m->gnelem();
+
+	// a non-uniform flow carrying the free-stream working variable
+	const IdealGasPhysics<a_real> phy(pconf.gamma, pconf.Minf, pconf.Tinf, pconf.Reinf, pconf.Pr);
+	const std::array<a_real,NVARS> uref = phy.compute_freestream_state(pconf.aoa);
+	const a_real nut = getSAFreestreamWorkingVariable(1.0/pconf.Reinf);
+	std::vector<a_real> u(nelem*nvt);
+	for(a_int iel = 0; iel < nelem; iel++)
+	{
+		const a_real pert = 1.0 + 0.05*std::sin(3.0*m->gcoords(m->ginpoel(iel,0),0))
+			*std::cos(2.0*m->gcoords(m->ginpoel(iel,0),1));
+		for(int j = 0; j < NVARS; j++)
+			u[iel*nvt+j] = uref[j]*pert;
+		u[iel*nvt+1] *= 1.0 + 0.1*std::sin(4.0*m->gcoords(m->ginpoel(iel,0),1));
+		u[iel*nvt+k] = u[iel*nvt]*nut;
+	}
+
+	// Derivatives of the working variable residuals w.r.t. the working variables, without source
+	std::vector<a_real> jac(nelem*nelem, 0.0);
+	std::vector<bool> skip(nelem, false);
+	for(a_int iface = 0; iface < m->gnbface(); iface++)
+	{
+		const a_int lelem = m->gintfac(iface,0);
+		a_real left[nvt*nvt];
+		flow.compute_boundary_face_jacobian(iface, &u[0], left);
+		jac[lelem*nelem+lelem] += left[k*nvt+k];
+
+		for(const FlowBCConfig& bc : pconf.bcconf)
+			if(bc.bc_tag == m->gintfacbtags(iface,0) && bc.bc_type == ISOTHERMAL_WALL_BC)
+				skip[lelem] = true;
+	}
+	for(a_int iface = m->gnbface(); iface < m->gnaface(); iface++)
+	{
+		const a_int lelem = m->gintfac(iface,0);
+		const a_int relem = m->gintfac(iface,1);
+		a_real L[nvt*nvt], U[nvt*nvt];
+		flow.compute_interior_face_jacobian(iface, &u[0], L, U);
+		jac[relem*nelem+lelem] += L[k*nvt+k];
+		jac[lelem*nelem+relem] += U[k*nvt+k];
+		jac[lelem*nelem+lelem] -= L[k*nvt+k];
+		jac[relem*nelem+relem] -= U[k*nvt+k];
+	}
+
+	int err = 0;
+	std::vector<a_real> src, dsrc;
+	flow.compute_turbulence_source(&u[0], src, dsrc);
+	for(a_int iel = 0; iel < nelem; iel++)
+		if(!(dsrc[iel] <= 0)) {
+			err = 1;
+			std::cerr << "! Source derivative is " << dsrc[iel] << " at cell " << iel << "\n";
+		}
+
+	a_real scale = 0;
+	for(a_int iel = 0; iel < nelem; iel++)
+		scale = std::max(scale, std::fabs(jac[iel*nelem+iel]));
+
+	/* Residual of the working variable without the source term, ie., r(u) + source, where
+	 * compute_residual gives -r(u).
+	 */
+	const auto residual = [&flow,nelem](const std::vector<a_real>& ustate)
+	{
+		std::vector<a_real> res(nelem*nvt, 0.0), srcterm, dsrcterm;
+		std::vector<a_real> dtm(nelem);
+		flow.compute_residual(&ustate[0], &res[0], false, dtm);
+		flow.compute_turbulence_source(&ustate[0], srcterm, dsrcterm);
+		std::vector<a_real> r(nelem);
+		for(a_int iel = 0; iel < nelem; iel++)
+			r[iel] = -res[iel*nvt+k] + srcterm[iel];
+		return r;
+	};
+
+	for(a_int jel = 0; jel < nelem; jel++)
+	{
+		std::vector<a_real> up(u), um(u);
+		const a_real eps = 1e-6*std::fabs(u[jel*nvt+k]);
+		up[jel*nvt+k] += eps;
+		um[jel*nvt+k] -= eps;
+		const std::vector<a_real> rp = residual(up), rm = residual(um);
+
+		for(a_int iel = 0; iel < nelem; iel++)
+		{
+			if(skip[iel])
+				continue;
+			const a_real fd = (rp[iel]-rm[iel])/(2*eps);
+			if(std::fabs(jac[iel*nelem+jel] - fd) > 1e-5*scale) {
+				err = 1;
+				std::cerr << "! Jacobian of the working variable at (" << iel << ", " << jel << "): "
+				          << jac[iel*nelem+jel] << " vs finite difference " << fd << "\n";
+			}
+		}
+	}
+
+	return err;
+}
+
+}
+}
@@ -0,0 +1,39 @@
+/** \file testsaturbulence.hpp
+ * \brief Tests for the coupling of the Spalart-Allmaras turbulence model to the flow
+ * \author Aditya Kashi
+ */
+
+#ifndef FVENS_TEST_SATURBULENCE_H
+#define FVENS_TEST_SATURBULENCE_H
+
+#include "spatial/flow_spatial.hpp"
+
+namespace fvens {
+namespace fvens_tests {
+
+/// Tests the residual of the flow discretization with the Spalart-Allmaras model
+/** At a non-uniform flow state, the residual of the flow variables with a zero working variable
+ * (and zero free-stream working variable) must be the laminar residual, and the residual of the
+ * working variable must vanish. With a positive working variable, the eddy viscosity must change
+ * the flow residual.
+ * \return 0 if the test passes, 1 otherwise
+ */
+int testSATurbulenceResidual(const UMesh2dh<a_real> *const m, const FlowPhysicsConfig& pconf,
+                             const FlowNumericsConfig& nconf);
+
+/// Tests the Jacobian of the working variable w.r.t. itself against finite differences
+/** The first-order face Jacobian blocks and the source derivative are assembled into the entries
+ * coupling the working variables of the cells, and compared with central differences of the
+ * first-order residual. The working variable is uniform, so that the terms proportional to its
+ * gradient, whose derivatives are neglected in the Jacobian, vanish. The source is excluded from
+ * the comparison since only its destruction term is linearized; its derivative must not be
+ * positive instead. Cells next to isothermal walls are skipped since the ghost-state Jacobian
+ * of that BC is inexact.
+ * \return 0 if the test passes, 1 otherwise
+ */
+int testSATurbulenceJacobian(const UMesh2dh<a_real> *const m, const FlowPhysicsConfig& pconf,
+                             const FlowNumericsConfig& nconf);
+
+}
+}
+#endif
@@ -0,0 +1,261 @@
+/** \file testsurfaceforces.cpp
+ * \brief Implements tests for the integration of surface forces
+ * \author Aditya Kashi
+ */
+
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include <array>
+#include <string>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "utilities/afactory.hpp"
+#include "utilities/aerrorhandling.hpp"
+#include "testsurfaceforces.hpp"
+#include "testwallbcs.hpp"
+
+namespace fvens {
+namespace fvens_tests {
+
+/// Conserved state at the centre of a boundary face, extrapolated from the adjacent cell centre
+static void faceState(const UMesh2dh<a_real> *const m, const IdealGasPhysics<a_real>& phy,
+                      const a_real *const u, const GradArray<a_real,NVARS>& grads,
+                      const bool primitive, const a_int iface, a_real *const uf)
+{
+	const a_int lelem = m->gintfac(iface,0);
+	a_real dr[NDIM];
+	for(int j = 0; j < NDIM; j++)
+	{
+		a_real fc = 0, cc = 0;
+		for(int inofa = 0; inofa < m->gnnofa(); inofa++)
+			fc += m->gcoords(m->gintfac(iface,2+inofa),j);
+		for(int inode = 0; inode < m->gnnode(lelem); inode++)
+			cc += m->gcoords(m->ginpoel(lelem,inode),j);
+		dr[j] = fc/m->gnnofa() - cc/m->gnnode(lelem);
+	}
+
+	a_real ul[NVARS];
+	if(primitive)
+		phy.getPrimitiveFromConserved(&u[lelem*NVARS], ul);
+	else
+		for(int k = 0; k < NVARS; k++)
+			ul[k] = u[lelem*NVARS+k];
+	for(int k = 0; k < NVARS; k++)
+		for(int j = 0; j < NDIM; j++)
+			ul[k] += grads[lelem](j,k)*dr[j];
+	if(primitive)
+		phy.getConservedFromPrimitive(ul, uf);
+	else
+		for(int k = 0; k < NVARS; k++)
+			uf[k] = ul[k];
+}
+
+/// Lift, pressure drag and skin friction drag coefficients of a surface, face by face
+/** \param grads Gradients at cell centres, used to extrapolate the pressure and viscosity to the
+ *   faces; if empty, the cell-centred values are used and the skin friction is zero
+ * \param primitive Whether grads are gradients of primitive or of conserved variables
+ */
+static std::array<a_real,3> serialSurfaceForces(const UMesh2dh<a_real> *const m,
+                                                const IdealGasPhysics<a_real>& phy,
+                                                const a_real aoa, const a_real *const u,
+                                                const GradArray<a_real,NVARS>& grads,
+                                                const bool primitive, const int marker)
+{
+	const a_real pinf = phy.getFreestreamPressure();
+	a_real cl = 0, cdp = 0, cdf = 0, len = 0;
+	for(a_int iface = 0; iface < m->gnbface(); iface++)
+	{
+		if(m->gintfacbtags(iface,0) != marker)
+			continue;
+		const a_int lelem = m->gintfac(iface,0);
+		const a_real *const uc = &u[lelem*NVARS];
+		a_real uf[NVARS];
+		if(!grads.empty())
+			faceState(m, phy, u, grads, primitive, iface, uf);
+		const a_real *const us = grads.empty() ? uc : uf;
+
+		const a_real cp = 2.0*(phy.getPressureFromConserved(us) - pinf);
+		const a_real nx = m->gfacemetric(iface,0), ny = m->gfacemetric(iface,1);
+		const a_real flen = m->gfacemetric(iface,2);
+		cl += cp*(-nx*std::sin(aoa) + ny*std::cos(aoa))*flen;
+		cdp += cp*(nx*std::cos(aoa) + ny*std::sin(aoa))*flen;
+		len += flen;
+
+		if(grads.empty())
+			continue;
+		// wall shear stress mu (grad v + grad v^T) n . t with the tangent t = (ny,-nx)
+		const auto& gr = grads[lelem];
+		a_real gu[NDIM][NDIM];
+		for(int i = 0; i < NDIM; i++)
+			for(int j = 0; j < NDIM; j++)
+				gu[i][j] = primitive ? gr(j,i+1) : (gr(j,i+1)*uc[0]-uc[i+1]*gr(j,0))/(uc[0]*uc[0]);
+		const a_real mu = phy.getViscosityCoeffFromConserved(us);
+		const a_real dudx = gu[0][0], dudy = gu[0][1], dvdx = gu[1][0], dvdy = gu[1][1];
+		const a_real tauw = mu*((2.0*dudx*nx + (dudy+dvdx)*ny)*ny
+		                        - ((dvdx+dudy)*nx + 2.0*dvdy*ny)*nx);
+		cdf += 2.0*tauw*(ny*std::cos(aoa) - nx*std::sin(aoa))*flen;
+	}
+	return {cl/len, cdp/len, cdf/len};
+}
+
+static bool differ(const a_real a, const a_real b, const a_real tol, const char *const what,
+                   const int marker)
+{
+	if(std::fabs(a-b) <= tol)
+		return false;
+	std::cerr << "! " << what << " on marker " << marker << " differs: " << a << " vs " << b
+	          << "\n";
+	return true;
+}
+
+/// Compares forces to the serial integration, with a tolerance relative to their magnitude
+static int compareForces(const std::tuple<a_real,a_real,a_real>& f, const std::array<a_real,3>& ref,
+                         const std::string what, const int marker)
+{
+	const a_real tol = 1e-12*(1.0 + std::fabs(ref[0]) + std::fabs(ref[1]) + std::fabs(ref[2]));
+	int err = 0;
+	err = differ(std::get<0>(f), ref[0], tol, ("Lift "+what).c_str(), marker) || err;
+	err = differ(std::get<1>(f), ref[1], tol, ("Pressure drag "+what).c_str(), marker) || err;
+	err = differ(std::get<2>(f), ref[2], tol, ("Skin friction drag "+what).c_str(), marker)
+		|| err;
+	return err;
+}
+
+/// Smoothly perturbed test state
+/** The variables are perturbed out of phase, so that the velocity varies too.
+ */
+static MVector<a_real> perturbedState(const UMesh2dh<a_real> *const m, const a_real amplitude)
+{
+	const std::array<a_real,NVARS> uref = get_test_state();
+	MVector<a_real> u(m->gnelem(), NVARS);
+	for(a_int iel = 0; iel < m->gnelem(); iel++)
+	{
+		const a_real x = m->gcoords(m->ginpoel(iel,0),0), y = m->gcoords(m->ginpoel(iel,0),1);
+		for(int j = 0; j < NVARS; j++)
+			u(iel,j) = uref[j]*(1.0 + amplitude*std::sin(3.0*x + j)*std::cos(2.0*y - j));
+	}
+	return u;
+}
+
+int testSurfaceForces(const UMesh2dh<a_real> *const m, const FlowPhysicsConfig& pconf,
+                      const FlowNumericsConfig& nconf)
+{
+	int err = 0;
+	const FlowFV_base<a_real> *const flow = create_const_flowSpatialDiscretization(m, pconf, nconf);
+	const IdealGasPhysics<a_real> phy(pconf.gamma, pconf.Minf, pconf.Tinf, pconf.Reinf, pconf.Pr);
+	const GradArray<a_real,NVARS> nograds;
+
+	const a_int nelem = m->gnelem();
+	const MVector<a_real> u = perturbedState(m, 0.05);
+
+	// residual evaluation that keeps its gradients
+	std::vector<a_real> r(nelem*NVARS, 0.0);
+	std::vector<a_real> dtm(nelem);
+	int ierr = flow->compute_residual(&u(0,0), &r[0], true, dtm);
+	fvens_throw(ierr, "Residual failed!");
+
+	GradArray<a_real,NVARS> grads(nelem), pgrads(nelem);
+	flow->getGradients(u, grads);
+	flow->getPrimitiveGradients(&u(0,0), pgrads);
+
+	// a different state, at which the kept gradients must not be used
+	const MVector<a_real> u2 = perturbedState(m, 0.1);
+	GradArray<a_real,NVARS> pgrads2(nelem);
+	flow->getPrimitiveGradients(&u2(0,0), pgrads2);
+
+	int nmarkers = 0;
+	for(const int marker : {2, 3})
+	{
+		a_int nfaces = 0;
+		for(a_int iface = 0; iface < m->gnbface(); iface++)
+			if(m->gintfacbtags(iface,0) == marker)
+				nfaces++;
+		if(static_cast<a_int>(flow->surfaceFaces(marker).size()) != nfaces) {
+			std::cerr << "! Faces of marker " << marker << " not found correctly!\n";
+			err = 1;
+			continue;
+		}
+		if(nfaces == 0)
+			continue;
+		nmarkers++;
+		std::cout << " Marker " << marker << ": " << nfaces << " faces\n";
+
+		const std::array<a_real,3> ref
+			= serialSurfaceForces(m, phy, pconf.aoa, &u(0,0), pgrads, true, marker);
+
+		// the output uses conserved gradients, which extrapolate to slightly different face states
+		MVector<a_real> output(nfaces, NDIM+2);
+		const std::tuple<a_real,a_real,a_real> fresh
+			= flow->computeSurfaceData(u, grads, marker, output);
+		err = compareForces(fresh, serialSurfaceForces(m, phy, pconf.aoa, &u(0,0), grads, false,
+		                                               marker),
+		                    "of the output", marker) || err;
+
+		const std::tuple<a_real,a_real,a_real> kept = flow->computeSurfaceForces(&u(0,0), marker);
+		err = compareForces(kept, ref, "with kept gradients", marker) || err;
+		std::cout << "  Cl " << ref[0] << ", Cd_p " << ref[1] << ", Cd_sf " << ref[2] << '\n';
+
+		const std::array<a_real,3> ref2
+			= serialSurfaceForces(m, phy, pconf.aoa, &u2(0,0), pgrads2, true, marker);
+		err = compareForces(flow->computeSurfaceForces(&u2(0,0), marker), ref2,
+		                    "at a state other than the residual's", marker) || err;
+
+#ifdef _OPENMP
+		const int nthreads = omp_get_max_threads();
+		omp_set_num_threads(1);
+		const std::tuple<a_real,a_real,a_real> single = flow->computeSurfaceForces(&u(0,0), marker);
+		omp_set_num_threads(nthreads);
+		if(single != kept) {
+			std::cerr << "! Forces on marker " << marker << " depend on the number of threads!\n";
+			err = 1;
+		}
+#endif
+	}
+	if(nmarkers == 0) {
+		std::cerr << "! No surfaces found!\n";
+		err = 1;
+	}
+
+	a_real forces[3];
+	if(!flow->computeWallForces(&u(0,0), forces)) {
+		std::cerr << "! Walls not found!\n";
+		err = 1;
+	}
+	for(int i = 0; i < 3; i++)
+		if(!std::isfinite(forces[i])) {
+			std::cerr << "! Wall force " << i << " is not finite!\n";
+			err = 1;
+		}
+
+	delete flow;
+
+	// first-order residuals keep no gradients, so they must be recomputed at each state
+	FlowNumericsConfig nconf1 = nconf;
+	nconf1.order2 = false;
+	const FlowFV_base<a_real> *const flow1
+		= create_const_flowSpatialDiscretization(m, pconf, nconf1);
+	for(const a_real amplitude : {0.05, 0.1})
+	{
+		const MVector<a_real> ua = perturbedState(m, amplitude);
+		ierr = flow1->compute_residual(&ua(0,0), &r[0], true, dtm);
+		fvens_throw(ierr, "Residual failed!");
+		flow1->getPrimitiveGradients(&ua(0,0), pgrads);
+		for(const int marker : {2, 3})
+		{
+			if(flow1->surfaceFaces(marker).empty())
+				continue;
+			const std::array<a_real,3> ref = serialSurfaceForces(m, phy, pconf.aoa, &ua(0,0),
+				pconf.viscous_sim ? pgrads : nograds, true, marker);
+			err = compareForces(flow1->computeSurfaceForces(&ua(0,0), marker), ref,
+			                    "at first order", marker) || err;
+		}
+	}
+	delete flow1;
+
+	return err;
+}
+
+}
+}
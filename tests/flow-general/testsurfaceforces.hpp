@@ -0,0 +1,32 @@
+/** \file testsurfaceforces.hpp
+ * \brief Tests for the integration of surface forces
+ * \author Aditya Kashi
+ */
+
+#ifndef FVENS_TEST_SURFACEFORCES_H
+#define FVENS_TEST_SURFACEFORCES_H
+
+#include "spatial/flow_spatial.hpp"
+
+namespace fvens {
+namespace fvens_tests {
+
+/// Tests the lift and drag coefficients computed on the walls of the mesh
+/** The walls are those of markers 2 and 3 which the mesh has. Checks that
+ *  - the faces of each wall are found,
+ *  - the forces of the surface output agree with a straightforward serial integration of values
+ *    extrapolated to the faces with the same conserved gradients,
+ *  - the forces computed with the gradients kept by the last residual evaluation agree with a
+ *    serial integration using the same primitive gradients,
+ *  - at a state other than that of the last residual evaluation, the forces use the gradients
+ *    of that state rather than the kept ones,
+ *  - the forces do not depend on the number of threads, and
+ *  - for a first-order discretization, the forces use the gradients of the current state.
+ * \return 0 if the test passes, 1 otherwise
+ */
+int testSurfaceForces(const UMesh2dh<a_real> *const m, const FlowPhysicsConfig& pconf,
+                      const FlowNumericsConfig& nconf);
+
+}
+}
+#endif
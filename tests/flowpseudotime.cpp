@@ -5,18 +5,402 @@
 
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 #include <string>
+#include <cmath>
 #include <petscvec.h>
 
 #include "utilities/aoptionparser.hpp"
 #include "utilities/controlparser.hpp"
 #include "utilities/aerrorhandling.hpp"
 #include "utilities/casesolvers.hpp"
+#include "utilities/casebatch.hpp"
+#include "utilities/perfcounters.hpp"
 
 using namespace fvens;
 namespace po = boost::program_options;
 using namespace std::literals::string_literals;
 
+/// Solves the main problem twice from the same state with one spatial discretization
+/** Nothing cached in the discretization during the first solve, such as the face blocks of
+ * incremental Jacobian updates, may affect the second: both must converge in the same number of
+ * steps to the same solution.
+ */
+static int testRepeatedSolve(const SteadyFlowCase& flowcase, const Spatial<a_real,NVARS> *const prob,
+                             const Vec u0)
+{
+	StatusCode ierr = flowcase.execute_starter(prob, u0);
+	fvens_throw(ierr, "Startup solve failed!");
+
+	Vec u[2];
+	TimingData td[2];
+	for(int i = 0; i < 2; i++)
+	{
+		ierr = VecDuplicate(u0, &u[i]); petsc_throw(ierr, "Vec duplicate");
+		ierr = VecCopy(u0, u[i]); petsc_throw(ierr, "Vec copy");
+		try {
+			td[i] = flowcase.execute_main(prob, u[i]);
+		}
+		catch(Tolerance_error& e) {
+			std::cout << e.what() << std::endl;
+			td[i].converged = false;
+		}
+	}
+
+	int err = 0;
+	if(!td[0].converged || !td[1].converged) {
+		std::cout << " ! Solve did not converge: " << td[0].converged << ", " << td[1].converged
+		          << '\n';
+		err = 1;
+	}
+	if(std::abs(td[0].num_timesteps - td[1].num_timesteps) > 1) {
+		std::cout << " ! The solves took " << td[0].num_timesteps << " and " << td[1].num_timesteps
+		          << " steps!\n";
+		err = 1;
+	}
+
+	PetscReal unorm, diffnorm;
+	ierr = VecNorm(u[0], NORM_2, &unorm); petsc_throw(ierr, "Vec norm");
+	ierr = VecAXPY(u[1], -1.0, u[0]); petsc_throw(ierr, "Vec axpy");
+	ierr = VecNorm(u[1], NORM_2, &diffnorm); petsc_throw(ierr, "Vec norm");
+	if(diffnorm > 1e-6*unorm) {
+		std::cout << " ! The solutions differ by " << diffnorm/unorm << " relative!\n";
+		err = 1;
+	}
+
+	for(int i = 0; i < 2; i++) {
+		ierr = VecDestroy(&u[i]); petsc_throw(ierr, "Vec destroy");
+	}
+	return err;
+}
+
+/// Runs the startup and main solves of a steady case, returning the timing data of the main solve
+template <int nvars>
+static TimingData solveSteady(const SteadyFlowCase& flowcase,
+                              const Spatial<a_real,nvars> *const prob, Vec u)
+{
+	StatusCode ierr = flowcase.execute_starter(prob, u);
+	fvens_throw(ierr, "Startup solve failed!");
+	TimingData td;
+	try {
+		td = flowcase.execute_main(prob, u);
+	}
+	catch(Tolerance_error& e) {
+		std::cout << e.what() << std::endl;
+		td.converged = false;
+	}
+	return td;
+}
+
+/// Solves a case with the Spalart-Allmaras model, and again laminar
+/** Both must converge, and the turbulent solve must not take more than twice the number of
+ * pseudo-time steps of the laminar one.
+ */
+static int testTurbulentConvergence(const FlowParserOptions& opts, const UMesh2dh<a_real>& m)
+{
+	fvens_throw(getNumberOfFlowVariables(opts) != NVARS+1,
+	            "The turbulent convergence test needs a turbulence model!");
+	FlowParserOptions lamopts = opts;
+	lamopts.turbulence_model = "NONE";
+
+	Vec u;
+	StatusCode ierr = initializeSystemVector(opts, m, &u); petsc_throw(ierr, "Vec init");
+	const SteadyFlowCase turbcase(opts);
+	const FlowFV_base<a_real,NVARS+1> *const tprob = createTurbulentFlowSpatial(opts, m);
+	const TimingData tdturb = solveSteady(turbcase, tprob, u);
+	delete tprob;
+	ierr = VecDestroy(&u); petsc_throw(ierr, "Vec destroy");
+
+	ierr = initializeSystemVector(lamopts, m, &u); petsc_throw(ierr, "Vec init");
+	const SteadyFlowCase lamcase(lamopts);
+	const FlowFV_base<a_real> *const prob = createFlowSpatial(lamopts, m);
+	const TimingData tdlam = solveSteady(lamcase, prob, u);
+	delete prob;
+	ierr = VecDestroy(&u); petsc_throw(ierr, "Vec destroy");
+
+	std::cout << " Pseudo-time steps: turbulent " << tdturb.num_timesteps << ", laminar "
+	          << tdlam.num_timesteps << '\n';
+
+	int err = 0;
+	if(!tdturb.converged || !tdlam.converged) {
+		std::cout << " ! Solve did not converge: turbulent " << tdturb.converged << ", laminar "
+		          << tdlam.converged << '\n';
+		err = 1;
+	}
+	if(tdturb.num_timesteps > 2*tdlam.num_timesteps) {
+		std::cout << " ! The turbulent solve took too many steps!\n";
+		err = 1;
+	}
+	return err;
+}
+
+/// Solves an explicit case with and without Anderson acceleration
+/** `-anderson_depth' must be given. Both solves must converge, and the accelerated one must take
+ * at most 3/4 of the pseudo-time steps of the unaccelerated one.
+ */
+static int testAndersonAcceleration(const SteadyFlowCase& flowcase,
+                                    const Spatial<a_real,NVARS> *const prob, const Vec u0,
+                                    const FlowParserOptions& opts)
+{
+	fvens_throw(opts.pseudotimetype != "EXPLICIT",
+	            "The Anderson acceleration test needs explicit pseudo-time stepping!");
+	fvens_throw(parsePetscCmd_int("-anderson_depth") <= 0,
+	            "The Anderson acceleration test needs a positive -anderson_depth!");
+	const std::string depth = std::to_string(parsePetscCmd_int("-anderson_depth"));
+
+	Vec u;
+	StatusCode ierr = VecDuplicate(u0, &u); petsc_throw(ierr, "Vec duplicate");
+	ierr = VecCopy(u0, u); petsc_throw(ierr, "Vec copy");
+	const TimingData tdacc = solveSteady(flowcase, prob, u);
+
+	// the solver reads the option when it is constructed
+	ierr = PetscOptionsClearValue(NULL, "-anderson_depth");
+	petsc_throw(ierr, "Could not clear option");
+	ierr = VecCopy(u0, u); petsc_throw(ierr, "Vec copy");
+	const TimingData tdplain = solveSteady(flowcase, prob, u);
+	ierr = PetscOptionsSetValue(NULL, "-anderson_depth", depth.c_str());
+	petsc_throw(ierr, "Could not set option");
+
+	ierr = VecDestroy(&u); petsc_throw(ierr, "Vec destroy");
+
+	std::cout << " Pseudo-time steps: accelerated " << tdacc.num_timesteps << ", unaccelerated "
+	          << tdplain.num_timesteps << '\n';
+
+	int err = 0;
+	if(!tdacc.converged || !tdplain.converged) {
+		std::cout << " ! Solve did not converge: accelerated " << tdacc.converged
+		          << ", unaccelerated " << tdplain.converged << '\n';
+		err = 1;
+	}
+	if(4*tdacc.num_timesteps > 3*tdplain.num_timesteps) {
+		std::cout << " ! Anderson acceleration did not reduce the number of steps enough!\n";
+		err = 1;
+	}
+	return err;
+}
+
+/// Solves an implicit case whose CFL number is too large for some steps
+/** Rejection of steps must be enabled with `-pseudotime_max_rejections' and
+ * `-pseudotime_reject_growth'. The solve must converge after rejecting at least one step.
+ */
+static int testStepRejection(const SteadyFlowCase& flowcase,
+                             const Spatial<a_real,NVARS> *const prob, Vec u,
+                             const FlowParserOptions& opts)
+{
+	fvens_throw(opts.pseudotimetype != "IMPLICIT",
+	            "The step rejection test needs implicit pseudo-time stepping!");
+	fvens_throw(!parsePetscCmd_isDefined("-pseudotime_max_rejections"),
+	            "The step rejection test needs -pseudotime_max_rejections!");
+
+	const TimingData td = solveSteady(flowcase, prob, u);
+	std::cout << " Pseudo-time steps: " << td.num_timesteps << ", rejected "
+	          << td.num_rejected_steps << '\n';
+
+	int err = 0;
+	if(!td.converged) {
+		std::cout << " ! Solve did not converge!\n";
+		err = 1;
+	}
+	if(td.num_rejected_steps <= 0) {
+		std::cout << " ! No step was rejected!\n";
+		err = 1;
+	}
+	return err;
+}
+
+/// Computes the convergence norm of the full residual at a state
+static a_real fullResidualNorm(const Spatial<a_real,NVARS> *const prob, const Vec u)
+{
+	const UMesh2dh<a_real> *const m = prob->mesh();
+	Vec r;
+	StatusCode ierr = VecDuplicate(u, &r); petsc_throw(ierr, "Vec duplicate");
+	ierr = VecSet(r, 0.0); petsc_throw(ierr, "Vec set");
+	std::vector<a_real> dtm(m->gnelem());
+	ierr = prob->assemble_residual(u, r, false, dtm); petsc_throw(ierr, "Residual");
+
+	const PetscScalar *rarr;
+	ierr = VecGetArrayRead(r, &rarr); petsc_throw(ierr, "Vec get array");
+	a_real resnorm2 = 0;
+	for(a_int iel = 0; iel < m->gnelem(); iel++)
+		resnorm2 += rarr[iel*NVARS+NVARS-1]*rarr[iel*NVARS+NVARS-1]*m->garea(iel);
+	ierr = VecRestoreArrayRead(r, &rarr); petsc_throw(ierr, "Vec restore array");
+	ierr = VecDestroy(&r); petsc_throw(ierr, "Vec destroy");
+	return std::sqrt(resnorm2);
+}
+
+/// Solves a case re-using face fluxes away from changed cells
+/** `-active_set_threshold' must be given. The solve must converge with only some of the fluxes
+ * recomputed, and the full residual at the solution must meet the tolerance relative to the full
+ * residual at the start of the main solve.
+ */
+static int testActiveSet(const SteadyFlowCase& flowcase, const FlowFV_base<a_real> *const prob,
+                         Vec u, const FlowParserOptions& opts)
+{
+	fvens_throw(!parsePetscCmd_isDefined("-active_set_threshold"),
+	            "The active set test needs -active_set_threshold!");
+
+	StatusCode ierr = flowcase.execute_starter(prob, u);
+	fvens_throw(ierr, "Startup solve failed!");
+	const a_real initres = fullResidualNorm(prob, u);
+
+	TimingData td;
+	try {
+		td = flowcase.execute_main(prob, u);
+	}
+	catch(Tolerance_error& e) {
+		std::cout << e.what() << std::endl;
+		td.converged = false;
+	}
+	const a_real finalres = fullResidualNorm(prob, u);
+
+	std::cout << " Pseudo-time steps: " << td.num_timesteps << ", full relative residual "
+	          << finalres/initres << ", fraction of fluxes computed "
+	          << prob->pseudotime_active_fraction() << '\n';
+
+	int err = 0;
+	if(!td.converged) {
+		std::cout << " ! Solve did not converge!\n";
+		err = 1;
+	}
+	if(finalres > opts.tolerance*initres) {
+		std::cout << " ! The full residual does not meet the tolerance!\n";
+		err = 1;
+	}
+	if(prob->pseudotime_active_fraction() >= 1.0) {
+		std::cout << " ! All fluxes were recomputed!\n";
+		err = 1;
+	}
+	return err;
+}
+
+/// Solves a batch of cases with too few pseudo-time steps to converge
+/** The batch is given by the `-batch_*' options. Each case must be reported as unconverged, with
+ * the number of steps it took, both in its result and in the batch report.
+ */
+static int testBatchUnconverged(const FlowParserOptions& opts, const UMesh2dh<a_real>& m)
+{
+	const int maxsteps = 3;
+	std::vector<FlowParserOptions> cases = generateBatchCases(opts);
+	for(FlowParserOptions& caseopts : cases)
+		caseopts.maxiter = maxsteps;
+
+	const int nteams = parsePetscCmd_isDefined("-batch_teams") ?
+		parsePetscCmd_int("-batch_teams") : 1;
+	const FlowCaseBatch batch(nteams);
+	const std::vector<BatchCaseResult> results = batch.solve(m, cases);
+
+	std::ostringstream report;
+	writeBatchReport(report, results, 1.0);
+	std::cout << report.str();
+
+	int err = 0;
+	for(size_t ic = 0; ic < results.size(); ic++)
+	{
+		const BatchCaseResult& r = results[ic];
+		if(r.failed || r.tdata.converged) {
+			std::cout << " ! Case " << ic << " did not end as unconverged!\n";
+			err = 1;
+		}
+		if(r.tdata.num_timesteps != maxsteps) {
+			std::cout << " ! Case " << ic << " recorded " << r.tdata.num_timesteps << " steps!\n";
+			err = 1;
+		}
+	}
+
+	// the report has a blank line and a header before one row per case
+	std::istringstream lines(report.str());
+	std::string line;
+	std::getline(lines, line);
+	std::getline(lines, line);
+	for(size_t ic = 0; ic < results.size(); ic++)
+	{
+		std::getline(lines, line);
+		std::istringstream row(line);
+		int icase, team, steps;
+		double mach, aoa, cl, cdp, cdsf;
+		row >> icase >> team >> mach >> aoa >> cl >> cdp >> cdsf >> steps;
+		if(!row || steps != maxsteps) {
+			std::cout << " ! The report of case " << ic << " does not have the step count!\n";
+			err = 1;
+		}
+	}
+	return err;
+}
+
+/// Solves a case with performance instrumentation
+/** `-perf_counters' must be given. Wall-clock time must have been accumulated in the stages of the
+ * residual, flux, Jacobian and linear solve, whether or not hardware counters could be opened.
+ */
+static int testPerfCounters(const SteadyFlowCase& flowcase, const Spatial<a_real,NVARS> *const prob,
+                            Vec u)
+{
+	fvens_throw(!parsePetscCmd_isDefined("-perf_counters"),
+	            "The performance counter test needs -perf_counters!");
+
+	StatusCode ierr = flowcase.execute_starter(prob, u);
+	fvens_throw(ierr, "Startup solve failed!");
+	const TimingData td = flowcase.execute_main(prob, u);
+
+	reportPerfCounters(std::cout);
+	std::cout << " Hardware counters " << (perfHardwareCountersAvailable() ? "were" : "were not")
+	          << " read.\n";
+
+	int err = 0;
+	if(!td.converged) {
+		std::cout << " ! Solve did not converge!\n";
+		err = 1;
+	}
+	const PerfStage stages[] = {PERFSTAGE_RESIDUAL, PERFSTAGE_FLUX, PERFSTAGE_JACOBIAN,
+		PERFSTAGE_LINSOLVE};
+	for(const PerfStage stage : stages)
+		if(perfStageCalls(stage) <= 0 || perfStageWallTime(stage) <= 0) {
+			std::cout << " ! Stage " << stage << " was not measured!\n";
+			err = 1;
+		}
+	return err;
+}
+
+/// Solves a case with low-Mach preconditioning at its free-stream Mach number and at a tenth of it
+/** Both solves must converge, and the one at the lower Mach number must not take more than 1.5
+ * times the pseudo-time steps of the other.
+ */
+static int testLowMachConvergence(const FlowParserOptions& opts, const UMesh2dh<a_real>& m)
+{
+	fvens_throw(opts.lowmach_cutoff <= 0,
+	            "The low-Mach convergence test needs low-Mach preconditioning!");
+	FlowParserOptions lowopts = opts;
+	lowopts.Minf = opts.Minf/10;
+
+	TimingData td[2];
+	const FlowParserOptions *const caseopts[2] = {&opts, &lowopts};
+	for(int i = 0; i < 2; i++)
+	{
+		Vec u;
+		StatusCode ierr = initializeSystemVector(*caseopts[i], m, &u);
+		petsc_throw(ierr, "Vec init");
+		const SteadyFlowCase flowcase(*caseopts[i]);
+		const FlowFV_base<a_real> *const prob = createFlowSpatial(*caseopts[i], m);
+		td[i] = solveSteady(flowcase, prob, u);
+		delete prob;
+		ierr = VecDestroy(&u); petsc_throw(ierr, "Vec destroy");
+	}
+
+	std::cout << " Pseudo-time steps: Mach " << opts.Minf << ": " << td[0].num_timesteps
+	          << ", Mach " << lowopts.Minf << ": " << td[1].num_timesteps << '\n';
+
+	int err = 0;
+	if(!td[0].converged || !td[1].converged) {
+		std::cout << " ! Solve did not converge: " << td[0].converged << ", " << td[1].converged
+		          << '\n';
+		err = 1;
+	}
+	if(2*td[1].num_timesteps > 3*td[0].num_timesteps) {
+		std::cout << " ! The solve at the lower Mach number took too many steps!\n";
+		err = 1;
+	}
+	return err;
+}
+
 int main(int argc, char *argv[])
 {
 	StatusCode ierr = 0;
@@ -25,12 +409,22 @@ int main(int argc, char *argv[])
 
 	ierr = PetscInitialize(&argc,&argv,NULL,help); CHKERRQ(ierr);
 
+	// must be done before OpenMP threads are spawned; does nothing without -perf_counters
+	initializePerfCounters();
+
 	po::options_description desc
 		("FVENS functional convergence test.\n"s
 		 + " The first argument is the input control file name.\n"
 		 + "Further options");
 	desc.add_options()("test_type", po::value<std::string>(), "Type of test: 'exception_nanorinf' \
-for testing detection of NaN or inf during nonlinear sovlve");
+for testing detection of NaN or inf during nonlinear sovlve, 'repeated_solve' for testing that \
+two solves with the same spatial discretization are independent, 'turbulent_convergence' for \
+comparing the convergence of a case with a turbulence model to that of the laminar case, 'anderson_acceleration' for comparing explicit solves with and without Anderson acceleration, \
+'low_mach_convergence' for comparing the convergence of a preconditioned low-Mach case at two Mach \
+numbers, 'step_rejection' for testing that an implicit solve recovers from rejected steps, \
+'active_set' for testing that a solve re-using fluxes away from changed cells converges, \
+'batch_unconverged' for testing the report of a batch of cases that do not converge, \
+'perf_counters' for testing that the solver stages are timed");
 
 	const po::variables_map cmdvars = parse_cmd_options(argc, argv, desc);
 
@@ -42,15 +436,32 @@ for testing detection of NaN or inf during nonlinear sovlve");
 	// Read control file
 	const FlowParserOptions opts = parse_flow_controlfile(argc, argv, cmdvars);
 	const UMesh2dh<a_real> m = constructMesh(opts, "");
+
+	//std::string testchoice = parsePetscCmd_string("-test_type", 100);
+	std::string testchoice = cmdvars["test_type"].as<std::string>();
+
+	if(testchoice == "turbulent_convergence") {
+		const int err = testTurbulentConvergence(opts, m);
+		ierr = PetscFinalize(); CHKERRQ(ierr);
+		return err;
+	}
+	if(testchoice == "batch_unconverged") {
+		const int err = testBatchUnconverged(opts, m);
+		ierr = PetscFinalize(); CHKERRQ(ierr);
+		return err;
+	}
+	if(testchoice == "low_mach_convergence") {
+		const int err = testLowMachConvergence(opts, m);
+		ierr = PetscFinalize(); CHKERRQ(ierr);
+		return err;
+	}
+
 	SteadyFlowCase case1(opts);
 
 	// solution vector
 	Vec u;
 	ierr = initializeSystemVector(opts, m, &u); CHKERRQ(ierr);
 
-	//std::string testchoice = parsePetscCmd_string("-test_type", 100);
-	std::string testchoice = cmdvars["test_type"].as<std::string>();
-
 	// solve case - constructs (creates) u, computes the solution and stores the solution in it
 	if(testchoice == "exception_nanorinf") {
 		try {
@@ -63,10 +474,38 @@ for testing detection of NaN or inf during nonlinear sovlve");
 		return -1;
 	}
 
+	int err = 0;
+	if(testchoice == "repeated_solve") {
+		const FlowFV_base<a_real> *const prob = createFlowSpatial(opts, m);
+		err = testRepeatedSolve(case1, prob, u);
+		delete prob;
+	}
+	else if(testchoice == "anderson_acceleration") {
+		const FlowFV_base<a_real> *const prob = createFlowSpatial(opts, m);
+		err = testAndersonAcceleration(case1, prob, u, opts);
+		delete prob;
+	}
+	else if(testchoice == "step_rejection") {
+		const FlowFV_base<a_real> *const prob = createFlowSpatial(opts, m);
+		err = testStepRejection(case1, prob, u, opts);
+		delete prob;
+	}
+	else if(testchoice == "perf_counters") {
+		const FlowFV_base<a_real> *const prob = createFlowSpatial(opts, m);
+		err = testPerfCounters(case1, prob, u);
+		delete prob;
+	}
+	else if(testchoice == "active_set") {
+		const FlowFV_base<a_real> *const prob = createFlowSpatial(opts, m);
+		err = testActiveSet(case1, prob, u, opts);
+		delete prob;
+	}
+
 	ierr = VecDestroy(&u); CHKERRQ(ierr);
+	finalizePerfCounters();
 
 	std::cout << '\n';
 	ierr = PetscFinalize(); CHKERRQ(ierr);
 	std::cout << "\n--------------- End --------------------- \n\n";
-	return ierr;
+	return err;
 }
@@ -0,0 +1,35 @@
+/** \file flowstatetests.hpp
+ * \brief Helpers shared by tests of numerical fluxes at chosen flow states
+ * \author Aditya Kashi
+ */
+
+#ifndef FVENS_TEST_FLOWSTATETESTS_H
+#define FVENS_TEST_FLOWSTATETESTS_H
+
+#include <array>
+#include <cmath>
+#include <algorithm>
+#include "aconstants.hpp"
+
+namespace fvens {
+namespace fvens_tests {
+
+/// Conserved state from density, velocity and pressure
+inline std::array<a_real,NVARS> conservedState(const a_real g, const a_real rho, const a_real vx,
+                                               const a_real vy, const a_real p)
+{
+	return {rho, rho*vx, rho*vy, p/(g-1.0) + 0.5*rho*(vx*vx+vy*vy)};
+}
+
+/// Largest absolute difference between corresponding entries of two arrays of length n
+inline a_real maxDiff(const a_real *const a, const a_real *const b, const int n)
+{
+	a_real diff = 0;
+	for(int i = 0; i < n; i++)
+		diff = std::max(diff, std::fabs(a[i]-b[i]));
+	return diff;
+}
+
+}
+}
+#endif
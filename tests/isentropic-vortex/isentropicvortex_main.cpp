@@ -12,14 +12,13 @@
 #include "utilities/aerrorhandling.hpp"
 #include "utilities/aoptionparser.hpp"
 #include "utilities/controlparser.hpp"
-#include "isentropicvortex.hpp"
+#include "utilities/isentropicvortex.hpp"
 
 #ifdef USE_BLASTED
 #include <blasted_petsc.h>
 #endif
 
 using namespace fvens;
-using namespace fvens_tests;
 namespace po = boost::program_options;
 using namespace std::literals::string_literals;
 
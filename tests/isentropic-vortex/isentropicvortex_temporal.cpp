@@ -0,0 +1,190 @@
+/** \file isentropicvortex_temporal.cpp
+ * \brief Tests of the time integrators on the advection of an isentropic vortex
+ *
+ * Since the spatial discretization is the same for all the solves of one test, differences
+ * between the solutions only come from the temporal discretization.
+ */
+
+#include <iostream>
+#include <string>
+#include <cmath>
+#include <petscvec.h>
+
+#include "utilities/aoptionparser.hpp"
+#include "utilities/controlparser.hpp"
+#include "utilities/aerrorhandling.hpp"
+#include "utilities/casesolvers.hpp"
+#include "utilities/isentropicvortex.hpp"
+
+using namespace fvens;
+namespace po = boost::program_options;
+using namespace std::literals::string_literals;
+
+/// Integrates from the vortex initial condition up to the final time given in the options
+static TimingData solveVortex(const FlowParserOptions& opts, const UMesh2dh<a_real>& m,
+                              const IsentropicVortexProblem& isen, Vec u)
+{
+	std::vector<a_real> uexact(m.gnelem()*NVARS);
+	a_real *uarr;
+	StatusCode ierr = VecGetArray(u, &uarr); petsc_throw(ierr, "Vec get array");
+	isen.getInitialConditionAndExactSolution(m, opts.final_time, uarr, &uexact[0]);
+	ierr = VecRestoreArray(u, &uarr); petsc_throw(ierr, "Vec restore array");
+
+	const UnsteadyFlowCase flowcase(opts);
+	const FlowFV_base<a_real> *const prob = createFlowSpatial(opts, m);
+	const TimingData td = flowcase.execute_main(prob, u);
+	delete prob;
+	return td;
+}
+
+/// Relative 2-norm of the difference between a solution and a reference solution
+static a_real relativeDifference(const Vec u, const Vec uref)
+{
+	Vec diff;
+	PetscReal refnorm, diffnorm;
+	StatusCode ierr = VecDuplicate(u, &diff); petsc_throw(ierr, "Vec duplicate");
+	ierr = VecCopy(u, diff); petsc_throw(ierr, "Vec copy");
+	ierr = VecAXPY(diff, -1.0, uref); petsc_throw(ierr, "Vec axpy");
+	ierr = VecNorm(diff, NORM_2, &diffnorm); petsc_throw(ierr, "Vec norm");
+	ierr = VecNorm(uref, NORM_2, &refnorm); petsc_throw(ierr, "Vec norm");
+	ierr = VecDestroy(&diff); petsc_throw(ierr, "Vec destroy");
+	return diffnorm/refnorm;
+}
+
+/// Checks the observed order of accuracy of the time integrator with fixed time steps
+/** Solves with the physical time step in the control file and half of it, and measures the errors
+ * against a solve with a 16 times smaller step. The observed order must be within 0.25 of the
+ * temporal order of the integrator.
+ */
+static int testTemporalOrder(const FlowParserOptions& opts, const UMesh2dh<a_real>& m,
+                             const IsentropicVortexProblem& isen)
+{
+	FlowParserOptions fixedopts = opts;
+	fixedopts.phy_errtol = 0;
+	fixedopts.phy_cfl = 0;
+
+	const a_real dtfactors[] = {1.0/16, 1.0, 0.5};
+	Vec u[3];
+	for(int i = 0; i < 3; i++) {
+		StatusCode ierr = initializeSystemVector(opts, m, &u[i]); petsc_throw(ierr, "Vec init");
+		fixedopts.phy_timestep = dtfactors[i]*opts.phy_timestep;
+		const TimingData td = solveVortex(fixedopts, m, isen, u[i]);
+		std::cout << " Time step " << fixedopts.phy_timestep << ": " << td.num_timesteps
+		          << " steps\n";
+	}
+
+	const a_real errcoarse = relativeDifference(u[1], u[0]);
+	const a_real errfine = relativeDifference(u[2], u[0]);
+	const a_real order = std::log2(errcoarse/errfine);
+	std::cout << " Temporal errors " << errcoarse << ", " << errfine << "; observed order "
+	          << order << '\n';
+
+	for(int i = 0; i < 3; i++) {
+		StatusCode ierr = VecDestroy(&u[i]); petsc_throw(ierr, "Vec destroy");
+	}
+
+	if(order < opts.time_order - 0.25) {
+		std::cout << " ! The observed temporal order is less than " << opts.time_order << "!\n";
+		return 1;
+	}
+	return 0;
+}
+
+/// Checks that adaptive time stepping rejects and shrinks a too large initial time step
+/** Starts with 10 times the physical time step in the control file. Some step must be rejected,
+ * all accepted steps must meet the error tolerance and the solution must be close to that computed
+ * with a 16 times smaller fixed time step.
+ */
+static int testAdaptiveStepping(const FlowParserOptions& opts, const UMesh2dh<a_real>& m,
+                                const IsentropicVortexProblem& isen)
+{
+	fvens_throw(opts.phy_errtol <= 0, "The adaptive time stepping test needs an error tolerance!");
+
+	FlowParserOptions refopts = opts;
+	refopts.phy_errtol = 0;
+	refopts.phy_cfl = 0;
+	refopts.phy_timestep = opts.phy_timestep/16;
+	Vec uref;
+	StatusCode ierr = initializeSystemVector(opts, m, &uref); petsc_throw(ierr, "Vec init");
+	solveVortex(refopts, m, isen, uref);
+
+	FlowParserOptions adaptopts = opts;
+	adaptopts.phy_timestep = 10*opts.phy_timestep;
+	Vec u;
+	ierr = initializeSystemVector(opts, m, &u); petsc_throw(ierr, "Vec init");
+	const TimingData td = solveVortex(adaptopts, m, isen, u);
+
+	const a_real err = relativeDifference(u, uref);
+	std::cout << " Adaptive solve: " << td.num_timesteps << " steps, " << td.num_rejected_steps
+	          << " rejected, largest error estimate " << td.max_step_error << ", smallest step "
+	          << td.min_timestep << "; relative error " << err << '\n';
+
+	ierr = VecDestroy(&u); petsc_throw(ierr, "Vec destroy");
+	ierr = VecDestroy(&uref); petsc_throw(ierr, "Vec destroy");
+
+	int ferr = 0;
+	if(td.num_rejected_steps == 0) {
+		std::cout << " ! No time step was rejected!\n";
+		ferr = 1;
+	}
+	if(td.min_timestep >= adaptopts.phy_timestep) {
+		std::cout << " ! The time step was never reduced!\n";
+		ferr = 1;
+	}
+	if(td.max_step_error > 1.0) {
+		std::cout << " ! An accepted step did not meet the error tolerance!\n";
+		ferr = 1;
+	}
+	if(err > 10*opts.phy_errtol) {
+		std::cout << " ! The adaptive solution is too far from the reference solution!\n";
+		ferr = 1;
+	}
+	return ferr;
+}
+
+int main(int argc, char *argv[])
+{
+	StatusCode ierr = 0;
+	const char help[] = "Finite volume solver for Euler or Navier-Stokes equations.\n\
+		Arguments needed: FVENS control file, vortex parameter file and optionally\n\
+		PETSc options file with -options_file.\n";
+
+	ierr = PetscInitialize(&argc,&argv,NULL,help); CHKERRQ(ierr);
+
+	po::options_description desc
+		("FVENS time integration test.\n"s
+		 + " The first argument is the input control file name and the second is the vortex"
+		 + " parameter file.\n"
+		 + "Further options");
+	desc.add_options()("test_type", po::value<std::string>(), "Type of test: 'temporal_order' for \
+checking the order of accuracy of the time integrator with fixed time steps, 'adaptive' for checking \
+the rejection of steps and the error control of adaptive time stepping");
+
+	const po::variables_map cmdvars = parse_cmd_options(argc, argv, desc);
+
+	if(cmdvars.count("help")) {
+		std::cout << desc << std::endl;
+		std::exit(0);
+	}
+
+	const FlowParserOptions opts = parse_flow_controlfile(argc, argv, cmdvars);
+	fvens_throw(opts.sim_type != "UNSTEADY", "The time integration test needs an unsteady case!");
+	const UMesh2dh<a_real> m = constructMesh(opts, "");
+	const IsentropicVortexProblem isen(readIsenVortexConfig(argv[2], opts.gamma, opts.Minf,
+	                                                        opts.alpha));
+
+	const std::string testchoice = cmdvars["test_type"].as<std::string>();
+
+	int err = 0;
+	if(testchoice == "temporal_order")
+		err = testTemporalOrder(opts, m, isen);
+	else if(testchoice == "adaptive")
+		err = testAdaptiveStepping(opts, m, isen);
+	else
+		throw std::runtime_error("Unknown test type " + testchoice);
+
+	std::cout << '\n';
+	ierr = PetscFinalize(); CHKERRQ(ierr);
+	std::cout << "\n--------------- End --------------------- \n\n";
+	return err;
+}
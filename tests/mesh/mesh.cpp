@@ -2,8 +2,13 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <cmath>
+#include <algorithm>
 #include "mesh/amesh2dh.hpp"
 #include "mesh/ameshutils.hpp"
+#include "mesh/faceloops.hpp"
+#include "mesh/compressedfaces.hpp"
+#include "mesh/walldistance.hpp"
 
 #undef NDEBUG
 #include <cassert>
@@ -113,6 +118,189 @@ int test_levelscheduling_internalconsistency(const UMesh2dh<a_real>& m)
 	return 0;
 }
 
+int test_faceloop_colouring(const UMesh2dh<a_real>& m)
+{
+	const FaceLoopSchedule<a_real> sched(&m, FACELOOP_COLOURED, 1);
+	const std::vector<a_int>& cols = sched.colourStarts();
+	const std::vector<a_int>& faces = sched.colouredFaces();
+	TASSERT(cols.back() == m.gnaface());
+
+	std::vector<int> timesfound(m.gnaface(), 0);
+	for(size_t icol = 0; icol < cols.size()-1; icol++)
+	{
+		// no cell may be touched by two faces of the same colour
+		std::vector<int> touched(m.gnelem(), 0);
+		for(a_int i = cols[icol]; i < cols[icol+1]; i++)
+		{
+			const a_int iface = faces[i];
+			timesfound[iface]++;
+			for(int j = 0; j < 2; j++) {
+				const a_int icell = m.gintfac(iface,j);
+				if(icell < m.gnelem()) {
+					TASSERT(touched[icell] == 0);
+					touched[icell] = 1;
+				}
+			}
+		}
+	}
+
+	for(a_int iface = 0; iface < m.gnaface(); iface++)
+		TASSERT(timesfound[iface] == 1);
+	return 0;
+}
+
+int test_faceloop_partitions(const UMesh2dh<a_real>& m, const int nparts)
+{
+	const FaceLoopSchedule<a_real> sched(&m, FACELOOP_PARTITIONED, nparts);
+	const std::vector<a_int>& ostarts = sched.ownedFaceStarts();
+	const std::vector<a_int>& ofaces = sched.ownedFaces();
+	const std::vector<a_int>& sstarts = sched.sharedFaceStarts();
+	const std::vector<a_int>& sfaces = sched.sharedFaces();
+
+	// Every face must be owned by exactly one part, or be an interface face of exactly two parts.
+	//  Each part may only touch its own cells.
+	std::vector<int> nowned(m.gnaface(), 0), nshared(m.gnaface(), 0);
+	for(int ip = 0; ip < nparts; ip++)
+	{
+		for(a_int i = ostarts[ip]; i < ostarts[ip+1]; i++) {
+			const a_int iface = ofaces[i];
+			nowned[iface]++;
+			TASSERT(sched.cellOwner(m.gintfac(iface,0)) == ip);
+			if(iface >= m.gnbface())
+				TASSERT(sched.cellOwner(m.gintfac(iface,1)) == ip);
+		}
+		for(a_int i = sstarts[ip]; i < sstarts[ip+1]; i++) {
+			const a_int iface = sfaces[i];
+			nshared[iface]++;
+			TASSERT(iface >= m.gnbface());
+			TASSERT(sched.cellOwner(m.gintfac(iface,0)) == ip
+			        || sched.cellOwner(m.gintfac(iface,1)) == ip);
+		}
+	}
+
+	for(a_int iface = 0; iface < m.gnaface(); iface++)
+		TASSERT((nowned[iface] == 1 && nshared[iface] == 0)
+		        || (nowned[iface] == 0 && nshared[iface] == 2));
+	return 0;
+}
+
+int test_compressed_faces(UMesh2dh<a_real>& m)
+{
+	m.compute_areas();
+	m.compute_face_data();
+	const CompressedFaceData<a_real> cf(&m);
+
+	for(a_int iface = 0; iface < m.gnaface(); iface++)
+	{
+		TASSERT(cf.leftCell(iface) == m.gintfac(iface,0));
+		TASSERT(cf.rightCell(iface) == m.gintfac(iface,1));
+		for(int idim = 0; idim < NDIM; idim++)
+			TASSERT(std::fabs(cf.normal(iface,idim) - m.gfacemetric(iface,idim)) < 1e-7);
+		TASSERT(cf.length(iface) == m.gfacemetric(iface,NDIM));
+	}
+	TASSERT(cf.bytesPerFace() < 24);
+	return 0;
+}
+
+int test_subdomains(const UMesh2dh<a_real>& m, const int nparts, const int overlap)
+{
+	const MeshSubdomains sd = partitionSubdomains(m, nparts, overlap);
+	const int np = static_cast<int>(sd.starts.size())-1;
+	TASSERT(np == nparts);
+	TASSERT(sd.ownedstarts.size() == sd.starts.size());
+	TASSERT(sd.ownedstarts[0] == 0 && sd.ownedstarts[np] == m.gnelem());
+
+	for(int ip = 0; ip < np; ip++)
+	{
+		TASSERT(sd.ownedstarts[ip] < sd.ownedstarts[ip+1]);
+		std::vector<bool> insd(m.gnelem(), false);
+		a_int nowned = 0;
+		for(a_int i = sd.starts[ip]; i < sd.starts[ip+1]; i++) {
+			const a_int iel = sd.cells[i];
+			TASSERT(iel >= 0 && iel < m.gnelem());
+			if(i > sd.starts[ip])
+				TASSERT(sd.cells[i-1] < iel);
+			insd[iel] = true;
+			if(iel >= sd.ownedstarts[ip] && iel < sd.ownedstarts[ip+1])
+				nowned++;
+		}
+		TASSERT(nowned == sd.ownedstarts[ip+1]-sd.ownedstarts[ip]);
+		if(overlap == 0)
+			TASSERT(sd.starts[ip+1]-sd.starts[ip] == nowned);
+
+		// with overlap, all neighbours of owned cells are included, and every overlap cell has a
+		//  neighbour in the sub-domain
+		for(a_int i = sd.starts[ip]; i < sd.starts[ip+1]; i++)
+		{
+			const a_int iel = sd.cells[i];
+			const bool owned = iel >= sd.ownedstarts[ip] && iel < sd.ownedstarts[ip+1];
+			bool nbrin = false;
+			for(int j = 0; j < m.gnfael(iel); j++) {
+				const a_int nbr = m.gesuel(iel,j);
+				if(nbr >= m.gnelem())
+					continue;
+				if(owned && overlap > 0)
+					TASSERT(insd[nbr]);
+				nbrin = nbrin || insd[nbr];
+			}
+			if(!owned)
+				TASSERT(nbrin);
+		}
+	}
+	return 0;
+}
+
+/// Checks the wall distances of all cells against the distances from every wall face
+static int check_walldistances(const UMesh2dh<a_real>& m, const WallDistance<a_real>& wd,
+                               const std::vector<int>& markers)
+{
+	std::vector<a_real> centres(m.gnelem()*NDIM);
+	m.compute_cell_centres(centres);
+
+	for(a_int iel = 0; iel < m.gnelem(); iel++)
+	{
+		a_real mindist = 1e30;
+		for(a_int iface = 0; iface < m.gnbface(); iface++)
+		{
+			if(std::find(markers.begin(),markers.end(),m.gintfacbtags(iface,0)) == markers.end())
+				continue;
+			const a_int p1 = m.gintfac(iface,2), p2 = m.gintfac(iface,3);
+			const a_real tx = m.gcoords(p2,0)-m.gcoords(p1,0), ty = m.gcoords(p2,1)-m.gcoords(p1,1);
+			const a_real rx = centres[iel*NDIM]-m.gcoords(p1,0);
+			const a_real ry = centres[iel*NDIM+1]-m.gcoords(p1,1);
+			const a_real t = std::min(std::max((rx*tx+ry*ty)/(tx*tx+ty*ty), 0.0), 1.0);
+			mindist = std::min(mindist, std::sqrt((rx-t*tx)*(rx-t*tx) + (ry-t*ty)*(ry-t*ty)));
+		}
+
+		TASSERT(std::abs(wd.distance(iel) - mindist) < 1e-12*(1.0+mindist));
+	}
+	return 0;
+}
+
+int test_walldistance(UMesh2dh<a_real>& m, const std::vector<int>& markers)
+{
+	m.compute_face_data();
+	WallDistance<a_real> wd(&m, markers);
+	TASSERT(wd.numWallFaces() > 0);
+	int ierr = check_walldistances(m, wd, markers);
+	TASSERT(!ierr);
+
+	// move the nodes non-uniformly and refit the tree
+	for(a_int ip = 0; ip < m.gnpoin(); ip++) {
+		const a_real x = m.gcoords(ip,0), y = m.gcoords(ip,1);
+		m.scoords(ip, 0, x + 0.05*std::sin(y));
+		m.scoords(ip, 1, 0.9*y + 0.02*x*x);
+	}
+	wd.update();
+	ierr = check_walldistances(m, wd, markers);
+	TASSERT(!ierr);
+
+	wd.rebuild();
+	ierr = check_walldistances(m, wd, markers);
+	TASSERT(!ierr);
+	return 0;
+}
+
 int main(int argc, char *argv[])
 {
 	if(argc < 3) {
@@ -144,6 +332,25 @@ int main(int argc, char *argv[])
 	else if(whichtest == "levelscheduleInternal") {
 		err = test_levelscheduling_internalconsistency(m);
 	}
+	else if(whichtest == "faceloopcolouring") {
+		err = test_faceloop_colouring(m);
+	}
+	else if(whichtest == "faceloopparts") {
+		for(int nparts = 1; nparts <= 8; nparts++)
+			err = err || test_faceloop_partitions(m, nparts);
+	}
+	else if(whichtest == "compressedfaces") {
+		err = test_compressed_faces(m);
+	}
+	else if(whichtest == "subdomains") {
+		for(int nparts = 1; nparts <= 8; nparts++)
+			for(int overlap = 0; overlap <= 2; overlap++)
+				err = err || test_subdomains(m, nparts, overlap);
+	}
+	else if(whichtest == "walldistance") {
+		err = test_walldistance(m, {2});
+		err = err || test_walldistance(m, {2,4});
+	}
 	else
 		throw "Invalid test";
 
@@ -0,0 +1,86 @@
+/** \file testhistory.cpp
+ * \brief Round trip of records through the binary history log
+ */
+
+#undef NDEBUG
+
+#include <iostream>
+#include <sstream>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include "utilities/historylog.hpp"
+
+using namespace fvens;
+
+static HistoryRecord makeRecord(const int k)
+{
+	HistoryRecord rec = emptyHistoryRecord();
+	rec.step = k;
+	rec.linear_iters = 2*k;
+	rec.cfl = 10.0*k;
+	rec.rel_residual = std::pow(0.5, k);
+	for(int i = 0; i < 4; i++)
+		rec.residual[i] = k + 0.25*i;
+	return rec;
+}
+
+int main()
+{
+	const std::string fname = "testhistory.hist";
+	const int capacity = 16;
+	std::remove(fname.c_str());
+
+	{
+		HistoryLog log(fname, 4, capacity);
+		for(int k = 0; k < 10; k++)
+			log.append(makeRecord(k));
+		assert(log.numRecords() == 10);
+	}
+
+	// a new writer with the same layout appends, and the oldest records drop out of the ring
+	{
+		HistoryLog log(fname, 4, capacity);
+		assert(log.numRecords() == 10);
+		for(int k = 10; k < 40; k++)
+			log.append(makeRecord(k));
+	}
+
+	int nvars = 0;
+	uint64_t first = 0;
+	const std::vector<HistoryRecord> recs = readHistory(fname, nvars, first);
+	assert(nvars == 4);
+	assert(first == 40-capacity);
+	assert(recs.size() == static_cast<size_t>(capacity));
+	for(size_t j = 0; j < recs.size(); j++) {
+		const HistoryRecord ex = makeRecord(first+j);
+		assert(recs[j].step == ex.step);
+		assert(recs[j].linear_iters == ex.linear_iters);
+		assert(recs[j].cfl == ex.cfl);
+		assert(recs[j].rel_residual == ex.rel_residual);
+		for(int i = 0; i < 4; i++)
+			assert(recs[j].residual[i] == ex.residual[i]);
+		assert(std::isnan(recs[j].timestep));
+		assert(std::isnan(recs[j].forces[0]));
+	}
+
+	std::ostringstream csv;
+	writeHistoryCSV(recs, nvars, csv);
+	std::istringstream lines(csv.str());
+	std::string line;
+	int nlines = 0;
+	while(std::getline(lines, line))
+		nlines++;
+	assert(nlines == capacity+1);
+	assert(csv.str().compare(0, 5, "step,") == 0);
+
+	// a different layout overwrites the file
+	{
+		HistoryLog log(fname, 5, capacity);
+		assert(log.numRecords() == 0);
+	}
+
+	std::remove(fname.c_str());
+	std::cout << "History log round trip passed.\n";
+	return 0;
+}